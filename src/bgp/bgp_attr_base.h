@@ -155,6 +155,24 @@ public:
         return LocateInternal(attr);
     }
 
+    // Find the entry with the same contents as the passed in attribute,
+    // which is not inserted and can be a temporary. Returns NULL if there
+    // is none.
+    TypePtr Find(Type *attr) {
+        size_t hash = HashCompute(attr);
+        tbb::mutex::scoped_lock lock(mutex_[hash]);
+        typename Set::iterator it = set_[hash].find(attr);
+        if (it == set_[hash].end())
+            return NULL;
+
+        // An entry whose refcount dropped to 0 is about to be deleted, see
+        // LocateInternal.
+        int prev = intrusive_ptr_add_ref(*it);
+        TypePtr ptr = (prev > 0) ? TypePtr(*it) : TypePtr();
+        intrusive_ptr_del_ref(*it);
+        return ptr;
+    }
+
 private:
     const size_t HashCompute(Type *attr) const {
         if (hash_size_ <= 1) return 0;
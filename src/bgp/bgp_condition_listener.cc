@@ -48,12 +48,34 @@ public:
         return id_;
     }
 
+    // Match objects added without an index
     MatchList *match_objects() {
         return &match_object_list_;
     }
 
-    void AddMatchObject(ConditionMatch *obj) {
-        match_object_list_.insert(ConditionMatchPtr(obj));
+    ConditionMatchIndex *index() const {
+        return index_;
+    }
+
+    bool empty() const {
+        return match_object_list_.empty() && indexed_object_list_.empty();
+    }
+
+    void AddMatchObject(ConditionMatch *obj, ConditionMatchIndex *index) {
+        if (!index) {
+            match_object_list_.insert(ConditionMatchPtr(obj));
+            return;
+        }
+        assert(!index_ || index_ == index);
+        index_ = index;
+        indexed_object_list_.insert(ConditionMatchPtr(obj));
+    }
+
+    void RemoveMatchObject(ConditionMatch *obj) {
+        match_object_list_.erase(ConditionMatchPtr(obj));
+        indexed_object_list_.erase(ConditionMatchPtr(obj));
+        if (indexed_object_list_.empty())
+            index_ = NULL;
     }
 
     void StoreDoneCb(ConditionMatch *obj,
@@ -99,6 +121,8 @@ private:
     DBTable::DBTableWalkRef walk_ref_;
     WalkList walk_list_;
     MatchList match_object_list_;
+    MatchList indexed_object_list_;
+    ConditionMatchIndex *index_;
     LifetimeRef<ConditionMatchTableState> table_delete_ref_;
     DISALLOW_COPY_AND_ASSIGN(ConditionMatchTableState);
 };
@@ -113,7 +137,7 @@ BgpConditionListener::BgpConditionListener(BgpServer *server) :
 bool BgpConditionListener::PurgeTableState() {
     CHECK_CONCURRENCY("bgp::Config");
     BOOST_FOREACH(ConditionMatchTableState *ts, purge_list_) {
-        if (ts->match_objects()->empty()) {
+        if (ts->empty()) {
             BgpTable *bgptable = ts->table();
             if (ts->walk_ref() != NULL)
                 bgptable->ReleaseWalker(ts->walk_ref());
@@ -136,7 +160,8 @@ bool BgpConditionListener::PurgeTableState() {
 //
 void BgpConditionListener::AddMatchCondition(BgpTable *table,
                                              ConditionMatch *obj,
-                                             RequestDoneCb cb) {
+                                             RequestDoneCb cb,
+                                             ConditionMatchIndex *index) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
 
     tbb::mutex::scoped_lock lock(mutex_);
@@ -153,7 +178,7 @@ void BgpConditionListener::AddMatchCondition(BgpTable *table,
     } else {
         ts = loc->second;
     }
-    ts->AddMatchObject(obj);
+    ts->AddMatchObject(obj, index);
     TableWalk(ts, obj, cb);
 }
 
@@ -335,6 +360,15 @@ bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
         }
         (*match_obj_it)->Match(server, bgptable, rt, deleted);
     }
+
+    // Indexed objects only see the routes the index returns them for
+    if (ts->index()) {
+        ConditionMatchIndex::MatchList matches;
+        ts->index()->FindMatches(rt, &matches);
+        BOOST_FOREACH(ConditionMatch *obj, matches) {
+            obj->Match(server, bgptable, rt, obj->deleted() || del_rt);
+        }
+    }
     return true;
 }
 
@@ -371,12 +405,17 @@ void BgpConditionListener::UnregisterMatchCondition(BgpTable *bgptable,
 
     // Wait for Walk completion of deleted ConditionMatch object
     if (obj->deleted() && obj->walk_done()) {
-        ts->match_objects()->erase(obj);
+        ts->RemoveMatchObject(obj);
         purge_list_.insert(ts);
     }
     purge_trigger_->Set();
 }
 
+bool BgpConditionListener::HasMatchConditions(BgpTable *table) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return (map_.find(table) != map_.end());
+}
+
 void BgpConditionListener::DisableTableWalkProcessing() {
     DBTableWalkMgr *walk_mgr = server()->database()->GetWalkMgr();
     walk_mgr->DisableWalkProcessing();
@@ -389,7 +428,8 @@ void BgpConditionListener::EnableTableWalkProcessing() {
 
 ConditionMatchTableState::ConditionMatchTableState(BgpTable *table,
                                                    DBTableBase::ListenerId id)
-    : table_(table), id_(id), table_delete_ref_(this, table->deleter()) {
+    : table_(table), id_(id), index_(NULL),
+      table_delete_ref_(this, table->deleter()) {
     assert(table->deleter() != NULL);
 }
 
@@ -12,6 +12,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "base/util.h"
 
@@ -99,6 +100,26 @@ inline void intrusive_ptr_release(ConditionMatch *match) {
 //
 typedef boost::intrusive_ptr<ConditionMatch> ConditionMatchPtr;
 
+//
+// ConditionMatchIndex
+// Index over the ConditionMatch objects an application adds to a table.
+// Route notifications are dispatched only to the objects the index returns
+// for the route instead of to all the objects of the table.
+// The application keeps an object in the index until it unregisters it.
+// Concurrency: FindMatches runs in db::DBTable task, the index is updated
+// from the same tasks as AddMatchCondition and UnregisterMatchCondition
+//
+class ConditionMatchIndex {
+public:
+    typedef std::vector<ConditionMatch *> MatchList;
+
+    virtual ~ConditionMatchIndex() {
+    }
+
+    // Append the objects that may match the route
+    virtual void FindMatches(BgpRoute *route, MatchList *matches) const = 0;
+};
+
 //
 // ConditionMatchState
 // Base class for meta data that Condition Match adds against BgpRoute
@@ -165,8 +186,12 @@ public:
     // Add a new match condition
     // All subsequent DB Table notification matches this condition
     // DB Table is walked to match this condition for existing entries
+    // With an index, the condition is only matched against the routes for
+    // which the index returns it. All indexed conditions of a table share
+    // the same index
     void AddMatchCondition(BgpTable *table, ConditionMatch *obj,
-                           RequestDoneCb addDoneCb);
+                           RequestDoneCb addDoneCb,
+                           ConditionMatchIndex *index = NULL);
 
     // Delete a match condition
     // DB table should be walked to match this deleting condition and
@@ -194,6 +219,9 @@ public:
     // API to remove condition object from the table
     void UnregisterMatchCondition(BgpTable *table, ConditionMatch *obj);
 
+    // Return true if the listener has match conditions on the table
+    bool HasMatchConditions(BgpTable *table);
+
     BgpServer *server() {
         return server_;
     }
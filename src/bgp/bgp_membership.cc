@@ -360,6 +360,14 @@ bool BgpMembershipManager::IsRibOutRegistered(const IPeer *peer,
     return (prs && prs->ribout_registered());
 }
 
+//
+// Return true if any IPeer is registered or being registered to the BgpTable.
+//
+bool BgpMembershipManager::HasRegisteredPeers(const BgpTable *table) const {
+    tbb::spin_rw_mutex::scoped_lock read_lock(rw_mutex_, false);
+    return (FindRibState(table) != NULL);
+}
+
 //
 // Return RibOut's output queue depth.
 //
@@ -1070,6 +1078,57 @@ void BgpMembershipManager::PeerRibState::FillMembershipInfo(
     smpi->set_generation_id(subscription_gen_id_);
 }
 
+const int BgpMembershipManager::Walker::kPeerPathWalkBatchSize;
+
+//
+// Task to walk the paths of the peers in the PeerList in one partition of
+// the BgpTable, using the per peer path index of the BgpTable.
+//
+// The paths are first moved from the index to a list owned by the task and
+// put back in the index as they get processed. Paths deleted while they are
+// still in the list are removed from it by BgpTable::RemovePeerPath. New paths
+// added by the peers during the walk go to the index and are not walked.
+//
+class BgpMembershipManager::Walker::PeerPathWalkTask : public Task {
+public:
+    PeerPathWalkTask(Walker *walker, int part_id)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
+               part_id),
+          walker_(walker),
+          part_id_(part_id),
+          started_(false) {
+    }
+
+    virtual ~PeerPathWalkTask() {
+        assert(list_.empty());
+    }
+
+    virtual bool Run() {
+        if (!started_) {
+            BgpTable *table = walker_->rs_->table();
+            for (PeerList::iterator it = walker_->peer_list_.begin();
+                 it != walker_->peer_list_.end(); ++it) {
+                table->SplicePeerPaths(part_id_, *it, &list_);
+            }
+            started_ = true;
+        }
+        if (!walker_->PeerPathWalkCallback(part_id_, &list_))
+            return false;
+        walker_->PeerPathWalkDone();
+        return true;
+    }
+
+    std::string Description() const {
+        return "BgpMembershipManager::Walker::PeerPathWalkTask";
+    }
+
+private:
+    Walker *walker_;
+    int part_id_;
+    bool started_;
+    BgpTable::PeerPathList list_;
+};
+
 //
 // Constructor.
 //
@@ -1081,9 +1140,11 @@ BgpMembershipManager::Walker::Walker(BgpMembershipManager *manager)
       postpone_walk_(false),
       walk_started_(false),
       walk_completed_(false),
+      peer_path_walk_(false),
       rs_(NULL),
       rib_state_list_size_(0),
       ribout_state_list_size_(0) {
+    peer_path_walk_count_ = 0;
 }
 
 //
@@ -1204,6 +1265,84 @@ void BgpMembershipManager::Walker::WalkDoneCallback(DBTableBase *table_base) {
     trigger_->Set();
 }
 
+//
+// Start a walk of the paths of the peers in the PeerList instead of a walk
+// of the entire BgpTable. Used when there's only RibIn processing to do, so
+// that the cost of the walk is proportional to the number of paths added by
+// the peers rather than the size of the table.
+//
+// The walk request and complete counts of the table are updated the same as
+// for a table walk.
+//
+void BgpMembershipManager::Walker::PeerPathWalkStart() {
+    BgpTable *table = rs_->table();
+    table->incr_walk_request_count();
+    peer_path_walk_count_ = table->PartitionCount();
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (int part_id = 0; part_id < table->PartitionCount(); ++part_id) {
+        scheduler->Enqueue(new PeerPathWalkTask(this, part_id));
+    }
+}
+
+//
+// Process a batch of paths from the list of a PeerPathWalkTask.
+// Return true if all paths in the list have been processed.
+//
+// All paths of the walked peers on the route of the path at the front of the
+// list are handled together, same as in WalkCallback, so that the route gets
+// post processed only once.
+//
+bool BgpMembershipManager::Walker::PeerPathWalkCallback(int part_id,
+    BgpTable::PeerPathList *list) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    BgpTable *table = rs_->table();
+    DBTablePartBase *tpart = table->GetTablePartition(part_id);
+    int count = 0;
+    while (count < kPeerPathWalkBatchSize) {
+        if (list->empty())
+            return true;
+
+        bool notify = false;
+        BgpRoute *route = list->front().route();
+        for (Route::PathList::iterator it = route->GetPathList().begin(),
+             next = it; it != route->GetPathList().end(); it = next) {
+            next++;
+
+            BgpPath *path = static_cast<BgpPath *>(it.operator->());
+            IPeer *peer = path->GetPeer();
+            if (path->IsResolved() || path->IsAliased())
+                continue;
+            if (dynamic_cast<BgpSecondaryPath *>(path))
+                continue;
+            if (!peer || peer_list_.find(peer) == peer_list_.end())
+                continue;
+
+            // Put the path back in the index before notifying the peer
+            // since the peer may delete or replace it.
+            table->RemovePeerPath(route, path);
+            table->AddPeerPath(route, path);
+            notify |= peer->MembershipPathCallback(tpart, route, path);
+            count++;
+        }
+        table->InputCommonPostProcess(tpart, route, notify);
+    }
+    return list->empty();
+}
+
+//
+// Note that the walk of a partition is done. Trigger processing from the
+// bgp::PeerMembership task when all partitions are done.
+//
+void BgpMembershipManager::Walker::PeerPathWalkDone() {
+    CHECK_CONCURRENCY("db::DBTable");
+    if (--peer_path_walk_count_ != 0)
+        return;
+    rs_->table()->incr_walk_complete_count();
+    walk_completed_ = true;
+    trigger_->Set();
+}
+
 //
 // Start a walk for the BgpTable corresponding to the next RibState in the
 // RibStateList.
@@ -1270,9 +1409,17 @@ void BgpMembershipManager::Walker::WalkStart() {
     // walk of it's BgpTable.
     rs_->ClearPeerRibStateList();
 
-    // Start the walk.
+    // Start the walk. Walk only the paths of the peers if there's no RibOut
+    // join or leave processing to be done for the routes in the table.
     rs_->increment_walk_count();
     BgpTable *table = rs_->table();
+    if (ribout_state_list_.empty()) {
+        peer_path_walk_ = true;
+        walk_started_ = true;
+        if (!postpone_walk_)
+            PeerPathWalkStart();
+        return;
+    }
     walk_ref_ = table->AllocWalker(
         boost::bind(&BgpMembershipManager::Walker::WalkCallback, this, _1, _2),
         boost::bind(&BgpMembershipManager::Walker::WalkDoneCallback, this, _2));
@@ -1291,7 +1438,7 @@ void BgpMembershipManager::Walker::WalkStart() {
 void BgpMembershipManager::Walker::WalkFinish() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    assert(walk_ref_ != NULL);
+    assert(peer_path_walk_ || walk_ref_ != NULL);
     assert(rs_);
     assert(!peer_rib_list_.empty());
     assert(!peer_list_.empty() || !ribout_state_map_.empty());
@@ -1322,7 +1469,8 @@ void BgpMembershipManager::Walker::WalkFinish() {
         }
     }
 
-    table->ReleaseWalker(walk_ref_);
+    if (!peer_path_walk_)
+        table->ReleaseWalker(walk_ref_);
     rs_ = NULL;
     peer_rib_list_.clear();
     peer_list_.clear();
@@ -1332,6 +1480,7 @@ void BgpMembershipManager::Walker::WalkFinish() {
 
     walk_started_ = false;
     walk_completed_ = false;
+    peer_path_walk_ = false;
 }
 
 //
@@ -1382,8 +1531,12 @@ void BgpMembershipManager::Walker::PostponeWalk() {
 void BgpMembershipManager::Walker::ResumeWalk() {
     assert(walk_started_);
     assert(!walk_completed_);
-    assert(walk_ref_ != NULL);
+    assert(peer_path_walk_ || walk_ref_ != NULL);
     postpone_walk_ = false;
+    if (peer_path_walk_) {
+        PeerPathWalkStart();
+        return;
+    }
     BgpTable *table = rs_->table();
     table->WalkTable(walk_ref_);
 }
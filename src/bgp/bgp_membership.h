@@ -20,6 +20,7 @@
 #include "base/queue_task.h"
 #include "db/db_table.h"
 #include "bgp/bgp_ribout.h"
+#include "bgp/bgp_table.h"
 
 class BgpNeighborResp;
 class BgpServer;
@@ -110,6 +111,7 @@ public:
     bool IsRegistered(const IPeer *peer, const BgpTable *table) const;
     bool IsRibInRegistered(const IPeer *peer, const BgpTable *table) const;
     bool IsRibOutRegistered(const IPeer *peer, const BgpTable *table) const;
+    bool HasRegisteredPeers(const BgpTable *table) const;
     uint32_t GetRibOutQueueDepth(const IPeer *peer,
                                  const BgpTable *table) const;
 
@@ -454,6 +456,11 @@ public:
 private:
     friend class BgpMembershipTest;
 
+    class PeerPathWalkTask;
+
+    // Number of paths processed by a PeerPathWalkTask before yielding.
+    static const int kPeerPathWalkBatchSize = 1024;
+
     class RibOutState {
     public:
         explicit RibOutState(RibOut *ribout) : ribout_(ribout) { }
@@ -486,6 +493,9 @@ private:
     RibOutState *LocateRibOutState(RibOut *ribout);
     bool WalkCallback(DBTablePartBase *tpart, DBEntryBase *db_entry);
     void WalkDoneCallback(DBTableBase *table);
+    void PeerPathWalkStart();
+    bool PeerPathWalkCallback(int part_id, BgpTable::PeerPathList *list);
+    void PeerPathWalkDone();
     void WalkStart();
     void WalkFinish();
     bool WalkTrigger();
@@ -507,6 +517,8 @@ private:
     bool postpone_walk_;
     bool walk_started_;
     bool walk_completed_;
+    bool peer_path_walk_;
+    tbb::atomic<int> peer_path_walk_count_;
     DBTable::DBTableWalkRef walk_ref_;
     RibState *rs_;
     PeerRibList peer_rib_list_;
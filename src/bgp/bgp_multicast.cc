@@ -7,6 +7,9 @@
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+#include <map>
+
 #include "base/string_util.h"
 #include "base/task_annotations.h"
 #include "bgp/bgp_log.h"
@@ -66,7 +69,8 @@ McastForwarder::McastForwarder(McastSGEntry *sg_entry, ErmVpnRoute *route)
       label_(0),
       address_(0),
       rd_(route->GetPrefix().route_distinguisher()),
-      router_id_(route->GetPrefix().router_id()) {
+      router_id_(route->GetPrefix().router_id()),
+      tree_index_(-1) {
     const BgpPath *path = route->BestPath();
     const BgpAttr *attr = path->GetAttr();
 
@@ -384,7 +388,8 @@ McastSGEntry::McastSGEntry(McastManagerPartition *partition,
       forest_node_(NULL),
       local_tree_route_(NULL),
       tree_result_route_(NULL),
-      on_work_queue_(false) {
+      on_work_queue_(false),
+      tree_change_count_(0) {
     for (int level = McastTreeManager::LevelFirst;
          level < McastTreeManager::LevelCount; ++level) {
         ForwarderSet *forwarders = new ForwarderSet;
@@ -414,6 +419,8 @@ std::string McastSGEntry::ToString() const {
 void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->insert(forwarder);
+    if (level == McastTreeManager::LevelNative)
+        tree_pending_.push_back(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -427,6 +434,28 @@ void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
 //
 void McastSGEntry::ChangeForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
+    if (level == McastTreeManager::LevelNative &&
+        forwarder->tree_index() >= 0) {
+        if (forwarder->label()) {
+            NotifyForwarder(forwarder);
+            NotifyForwarderLinks(forwarder);
+
+            // Force the LocalTreeRoute to be updated with the new address
+            // and encap if this is the forest node.
+            if (forwarder == forest_node_ &&
+                partition_->tree_manager()->incremental_tree()) {
+                forest_node_ = NULL;
+            }
+        } else {
+            // The label block changed and the label got released. Withdraw
+            // the LocalTreeRoute if this is the forest node so that it gets
+            // re-added with a label from the new block.
+            if (forwarder == forest_node_)
+                DeleteLocalTreeRoute();
+            RemoveTreeNode(forwarder);
+            tree_pending_.push_back(forwarder);
+        }
+    }
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -439,6 +468,13 @@ void McastSGEntry::DeleteForwarder(McastForwarder *forwarder) {
     if (forwarder == forest_node_)
         forest_node_ = NULL;
     uint8_t level = forwarder->level();
+    if (level == McastTreeManager::LevelNative) {
+        RemoveTreeNode(forwarder);
+        McastForwarderList::iterator it =
+            std::find(tree_pending_.begin(), tree_pending_.end(), forwarder);
+        if (it != tree_pending_.end())
+            tree_pending_.erase(it);
+    }
     forwarder_sets_[level]->erase(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
@@ -476,15 +512,21 @@ void McastSGEntry::AddLocalTreeRoute() {
 
     // Select last usable leaf in the distribution tree as the forest node.
     // A leaf is considered usable if it has a valid label i.e. it has not
-    // run out of labels.
+    // run out of labels.  All McastForwarders in tree_nodes_ have a label
+    // and the last one is always a leaf.
     uint8_t level = McastTreeManager::LevelNative;
-    ForwarderSet *forwarders = forwarder_sets_[level];
-    for (ForwarderSet::reverse_iterator rit = forwarders->rbegin();
-         rit != forwarders->rend(); ++rit) {
-        McastForwarder *forwarder = *rit;
-        if (forwarder->label()) {
-            forest_node_ = forwarder;
-            break;
+    if (partition_->tree_manager()->incremental_tree()) {
+        if (!tree_nodes_.empty())
+            forest_node_ = tree_nodes_.back();
+    } else {
+        ForwarderSet *forwarders = forwarder_sets_[level];
+        for (ForwarderSet::reverse_iterator rit = forwarders->rbegin();
+             rit != forwarders->rend(); ++rit) {
+            McastForwarder *forwarder = *rit;
+            if (forwarder->label()) {
+                forest_node_ = forwarder;
+                break;
+            }
         }
     }
 
@@ -638,6 +680,12 @@ void McastSGEntry::UpdateTree(uint8_t level) {
         return;
     update_needed_[level] = false;
 
+    if (level == McastTreeManager::LevelNative &&
+        partition_->tree_manager()->incremental_tree()) {
+        UpdateTreeIncremental(level);
+        return;
+    }
+
     int degree;
     if (level == McastTreeManager::LevelNative) {
         degree = McastTreeManager::kDegree;
@@ -653,7 +701,14 @@ void McastSGEntry::UpdateTree(uint8_t level) {
          it != forwarders->end(); ++it) {
        (*it)->FlushLinks();
        (*it)->ReleaseLabel();
-       partition_->GetTablePartition()->Notify((*it)->route());
+       (*it)->clear_tree_index();
+       NotifyForwarder(*it);
+    }
+    if (level == McastTreeManager::LevelNative) {
+        tree_nodes_.clear();
+        tree_holes_.clear();
+        tree_pending_.clear();
+        tree_change_count_ = 0;
     }
 
     // Bail if we're not the tree builder.
@@ -671,10 +726,17 @@ void McastSGEntry::UpdateTree(uint8_t level) {
          it != forwarders->end(); ++it) {
         McastForwarder *forwarder = *it;
         forwarder->AllocateLabel();
-        if (!forwarder->label())
+        if (!forwarder->label()) {
+            if (level == McastTreeManager::LevelNative)
+                tree_pending_.push_back(forwarder);
             continue;
+        }
+        if (level == McastTreeManager::LevelNative)
+            forwarder->set_tree_index(vec.size());
         vec.push_back(forwarder);
     }
+    if (level == McastTreeManager::LevelNative)
+        tree_nodes_ = vec;
 
     // Go through each McastForwarder in the vector and link it to it's parent
     // McastForwarder in the k-ary tree. We also add a link from the parent to
@@ -697,6 +759,231 @@ void McastSGEntry::UpdateTree(uint8_t level) {
     UpdateRoutes(level);
 }
 
+//
+// Notify the ErmVpnRoute for the given McastForwarder so that an updated olist
+// gets exported. Keep count of the distinct notifications for debugging and
+// testing purposes.
+//
+void McastSGEntry::NotifyForwarder(McastForwarder *forwarder) {
+    ErmVpnRoute *route = forwarder->route();
+    if (!route->is_onlist())
+        partition_->increment_notify_count();
+    partition_->GetTablePartition()->Notify(route);
+}
+
+//
+// Notify the ErmVpnRoutes for all McastForwarders that are linked to the given
+// McastForwarder in the distribution tree.
+//
+void McastSGEntry::NotifyForwarderLinks(McastForwarder *forwarder) {
+    const McastForwarderList &links = forwarder->tree_links();
+    for (McastForwarderList::const_iterator it = links.begin();
+         it != links.end(); ++it) {
+        NotifyForwarder(*it);
+    }
+}
+
+//
+// Return true if the given McastForwarder is a leaf in the incremental tree.
+//
+bool McastSGEntry::IsTreeLeaf(const McastForwarder *forwarder) const {
+    assert(forwarder->tree_index() >= 0);
+    size_t child_idx =
+        forwarder->tree_index() * McastTreeManager::kDegree + 1;
+    for (size_t idx = child_idx;
+         idx < child_idx + McastTreeManager::kDegree &&
+         idx < tree_nodes_.size(); ++idx) {
+        if (tree_nodes_[idx])
+            return false;
+    }
+    return true;
+}
+
+//
+// Place the given McastForwarder at the specified slot in the incremental
+// tree and link it to its parent and to any children that occupy the child
+// slots.  Only the McastForwarder and its new neighbors get notified.
+//
+void McastSGEntry::InsertTreeNode(McastForwarder *forwarder, size_t idx) {
+    int degree = McastTreeManager::kDegree;
+    assert(forwarder->tree_index() < 0);
+    assert(forwarder->empty());
+
+    if (idx == tree_nodes_.size()) {
+        tree_nodes_.push_back(forwarder);
+    } else {
+        assert(!tree_nodes_[idx]);
+        tree_nodes_[idx] = forwarder;
+    }
+    forwarder->set_tree_index(idx);
+
+    if (idx != 0) {
+        McastForwarder *parent_forwarder = tree_nodes_[(idx - 1) / degree];
+        if (parent_forwarder) {
+            forwarder->AddLink(parent_forwarder);
+            parent_forwarder->AddLink(forwarder);
+        }
+    }
+    for (size_t child_idx = idx * degree + 1;
+         child_idx <= idx * degree + degree &&
+         child_idx < tree_nodes_.size(); ++child_idx) {
+        McastForwarder *child_forwarder = tree_nodes_[child_idx];
+        if (!child_forwarder)
+            continue;
+        forwarder->AddLink(child_forwarder);
+        child_forwarder->AddLink(forwarder);
+    }
+
+    NotifyForwarder(forwarder);
+    NotifyForwarderLinks(forwarder);
+    tree_change_count_++;
+}
+
+//
+// Remove the given McastForwarder from the incremental tree, leaving a hole
+// in its slot.  The hole gets filled when the tree is compacted.  The former
+// neighbors are notified right away since the McastForwarder may be deleted
+// before the McastSGEntry is processed from the WorkQueue.
+//
+void McastSGEntry::RemoveTreeNode(McastForwarder *forwarder) {
+    if (forwarder->tree_index() < 0)
+        return;
+
+    size_t idx = forwarder->tree_index();
+    assert(tree_nodes_[idx] == forwarder);
+    NotifyForwarderLinks(forwarder);
+    NotifyForwarder(forwarder);
+    forwarder->FlushLinks();
+    forwarder->clear_tree_index();
+    tree_nodes_[idx] = NULL;
+    tree_holes_.insert(idx);
+    tree_change_count_++;
+}
+
+//
+// Fill holes in the incremental tree by moving the last McastForwarder into
+// each hole, lowest slot first.  The last McastForwarder is always a leaf, so
+// moving it changes at most kDegree + 1 edges.
+//
+void McastSGEntry::CompactTree() {
+    for (std::set<size_t>::iterator it = tree_holes_.begin();
+         it != tree_holes_.end(); ++it) {
+        while (!tree_nodes_.empty() && !tree_nodes_.back())
+            tree_nodes_.pop_back();
+        size_t idx = *it;
+        if (idx >= tree_nodes_.size())
+            break;
+
+        McastForwarder *forwarder = tree_nodes_.back();
+        RemoveTreeNode(forwarder);
+        tree_nodes_.pop_back();
+        InsertTreeNode(forwarder, idx);
+    }
+    tree_holes_.clear();
+    while (!tree_nodes_.empty() && !tree_nodes_.back())
+        tree_nodes_.pop_back();
+}
+
+//
+// Rebalance the incremental tree so that McastForwarders are arranged in the
+// same sorted breadth first order as a full rebuild would produce.  Labels
+// are retained and only McastForwarders whose links change get notified. A
+// McastForwarder's links change iff its parent or the parent of one of its
+// children changes.
+//
+void McastSGEntry::RebalanceTree(uint8_t level) {
+    int degree = McastTreeManager::kDegree;
+    McastForwarderList old_nodes;
+    old_nodes.swap(tree_nodes_);
+
+    std::map<McastForwarder *, McastForwarder *> old_parents;
+    for (size_t idx = 1; idx < old_nodes.size(); ++idx) {
+        old_parents[old_nodes[idx]] = old_nodes[(idx - 1) / degree];
+    }
+    for (McastForwarderList::iterator it = old_nodes.begin();
+         it != old_nodes.end(); ++it) {
+        (*it)->FlushLinks();
+    }
+
+    ForwarderSet *forwarders = forwarder_sets_[level];
+    for (ForwarderSet::iterator it = forwarders->begin();
+         it != forwarders->end(); ++it) {
+        McastForwarder *forwarder = *it;
+        if (forwarder->tree_index() < 0)
+            continue;
+        forwarder->set_tree_index(tree_nodes_.size());
+        tree_nodes_.push_back(forwarder);
+    }
+
+    for (size_t idx = 0; idx < tree_nodes_.size(); ++idx) {
+        McastForwarder *forwarder = tree_nodes_[idx];
+        McastForwarder *parent_forwarder = NULL;
+        if (idx != 0) {
+            parent_forwarder = tree_nodes_[(idx - 1) / degree];
+            forwarder->AddLink(parent_forwarder);
+            parent_forwarder->AddLink(forwarder);
+        }
+
+        std::map<McastForwarder *, McastForwarder *>::iterator loc =
+            old_parents.find(forwarder);
+        McastForwarder *old_parent_forwarder =
+            (loc != old_parents.end()) ? loc->second : NULL;
+        if (parent_forwarder == old_parent_forwarder)
+            continue;
+        NotifyForwarder(forwarder);
+        if (parent_forwarder)
+            NotifyForwarder(parent_forwarder);
+        if (old_parent_forwarder)
+            NotifyForwarder(old_parent_forwarder);
+    }
+
+    tree_change_count_ = 0;
+}
+
+//
+// Incrementally update the distribution tree of Native McastForwarders.  Any
+// holes left behind by departed McastForwarders are filled first, and then
+// new McastForwarders are appended as leaves.  A McastForwarder that can't
+// get a label is left on the pending list and retried on the next update.
+//
+// The forest node is retained as long as it is still a leaf in the tree, so
+// that the LocalTreeRoute doesn't need to be updated.
+//
+void McastSGEntry::UpdateTreeIncremental(uint8_t level) {
+    CompactTree();
+
+    McastForwarderList pending;
+    pending.swap(tree_pending_);
+    for (McastForwarderList::iterator it = pending.begin();
+         it != pending.end(); ++it) {
+        McastForwarder *forwarder = *it;
+        if (!forwarder->label())
+            forwarder->AllocateLabel();
+        if (!forwarder->label()) {
+            tree_pending_.push_back(forwarder);
+            continue;
+        }
+        InsertTreeNode(forwarder, tree_nodes_.size());
+    }
+
+    uint32_t threshold =
+        partition_->tree_manager()->tree_rebalance_threshold();
+    if (threshold && tree_change_count_ > threshold)
+        RebalanceTree(level);
+
+    if (forest_node_ && forest_node_->tree_index() >= 0 &&
+        IsTreeLeaf(forest_node_)) {
+        return;
+    }
+
+    McastForwarder *old_forest_node = forest_node_;
+    UpdateRoutes(level);
+    if (old_forest_node && old_forest_node != forest_node_)
+        NotifyForwarder(old_forest_node);
+    if (forest_node_)
+        NotifyForwarder(forest_node_);
+}
+
 //
 // Update distribution trees for both levels.
 //
@@ -750,6 +1037,7 @@ McastManagerPartition::McastManagerPartition(McastTreeManager *tree_manager,
     : tree_manager_(tree_manager),
       part_id_(part_id),
       update_count_(0),
+      notify_count_(0),
       work_queue_(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
               part_id_,
               boost::bind(&McastManagerPartition::ProcessSGEntry, this, _1)) {
@@ -871,10 +1159,26 @@ const BgpServer *McastManagerPartition::server() const {
 McastTreeManager::McastTreeManager(ErmVpnTable *table)
     : table_(table),
       listener_id_(DBTable::kInvalidId),
+      incremental_tree_(GetEnvIncrementalTree()),
+      tree_rebalance_threshold_(GetEnvTreeRebalanceThreshold()),
       table_delete_ref_(this, table->deleter()) {
     deleter_.reset(new DeleteActor(this));
 }
 
+bool McastTreeManager::GetEnvIncrementalTree() {
+    char *incremental_tree_str = getenv("CONTRAIL_BGP_MCAST_INCREMENTAL_TREE");
+    if (incremental_tree_str)
+        return strtoul(incremental_tree_str, NULL, 0) != 0;
+    return false;
+}
+
+uint32_t McastTreeManager::GetEnvTreeRebalanceThreshold() {
+    char *threshold_str = getenv("CONTRAIL_BGP_MCAST_TREE_REBALANCE_THRESHOLD");
+    if (threshold_str)
+        return strtoul(threshold_str, NULL, 0);
+    return kDefaultTreeRebalanceThreshold;
+}
+
 //
 // Destructor for McastTreeManager.
 //
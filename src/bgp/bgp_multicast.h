@@ -112,6 +112,11 @@ public:
 
     bool empty() { return tree_links_.empty(); }
     ErmVpnRoute *global_tree_route() const { return global_tree_route_; }
+    const McastForwarderList &tree_links() const { return tree_links_; }
+
+    int tree_index() const { return tree_index_; }
+    void set_tree_index(int tree_index) { tree_index_ = tree_index; }
+    void clear_tree_index() { tree_index_ = -1; }
 
 private:
     friend class BgpMulticastTest;
@@ -131,6 +136,7 @@ private:
     Ip4Address router_id_;
     std::vector<std::string> encap_;
     McastForwarderList tree_links_;
+    int tree_index_;
 
     DISALLOW_COPY_AND_ASSIGN(McastForwarder);
 };
@@ -201,6 +207,16 @@ struct McastForwarderCompare {
 // when a McastForwarder is added, changed or deleted so that the distribution
 // tree and the necessary LocalTreeRoute or GlobalTreeRoutes can be updated.
 //
+// The tree of Native McastForwarders is also kept as a vector in breadth first
+// order (tree_nodes_), with each McastForwarder remembering its slot via the
+// tree_index_. If the McastTreeManager is configured for incremental trees,
+// this vector is used to insert and remove McastForwarders without rebuilding
+// the whole tree. A new McastForwarder is appended as the last leaf, and the
+// slot of a departed one is filled by the last leaf. Either operation changes
+// at most kDegree + 1 edges, so only the affected ErmVpnRoutes get notified.
+// The resulting tree is only as predictable as the join order, so the tree is
+// rebalanced back into sorted order after a configurable number of changes.
+//
 class McastSGEntry : public DBState {
 public:
     McastSGEntry(McastManagerPartition *partition,
@@ -248,6 +264,14 @@ private:
 
     void UpdateTree(uint8_t level);
     void UpdateRoutes(uint8_t level);
+    void UpdateTreeIncremental(uint8_t level);
+    void RebalanceTree(uint8_t level);
+    void InsertTreeNode(McastForwarder *forwarder, size_t idx);
+    void RemoveTreeNode(McastForwarder *forwarder);
+    void CompactTree();
+    bool IsTreeLeaf(const McastForwarder *forwarder) const;
+    void NotifyForwarder(McastForwarder *forwarder);
+    void NotifyForwarderLinks(McastForwarder *forwarder);
 
     McastManagerPartition *partition_;
     Ip4Address group_, source_;
@@ -257,6 +281,10 @@ private:
     std::vector<ForwarderSet *> forwarder_sets_;
     std::vector<bool> update_needed_;
     bool on_work_queue_;
+    McastForwarderList tree_nodes_;
+    std::set<size_t> tree_holes_;
+    McastForwarderList tree_pending_;
+    uint32_t tree_change_count_;
 
     DISALLOW_COPY_AND_ASSIGN(McastSGEntry);
 };
@@ -330,6 +358,9 @@ public:
                            Ip4Address *address,
                            std::vector<std::string> *encap) const;
 
+    uint64_t notify_count() const { return notify_count_; }
+    void increment_notify_count() { notify_count_++; }
+
 private:
     friend class BgpMulticastTest;
     friend class ShowMulticastManagerDetailHandler;
@@ -342,6 +373,7 @@ private:
     size_t part_id_;
     SGList sg_list_;
     int update_count_;
+    uint64_t notify_count_;
     WorkQueue<McastSGEntry *> work_queue_;
 
     DISALLOW_COPY_AND_ASSIGN(McastManagerPartition);
@@ -381,9 +413,16 @@ private:
 // Note that we do not create a McastTreeManager for the ErmVpnTable in the
 // default routing instance i.e. bgp.ermvpn.0.
 //
+// By default the distribution tree for Native McastForwarders is rebuilt from
+// scratch on every membership change. If incremental_tree_ is set, the tree is
+// updated incrementally and rebalanced into sorted order only after the number
+// of incremental changes exceeds tree_rebalance_threshold_. A threshold of 0
+// means that the tree is never rebalanced.
+//
 class McastTreeManager {
 public:
     static const int kDegree = 4;
+    static const uint32_t kDefaultTreeRebalanceThreshold = 1024;
 
     typedef std::vector<McastManagerPartition *> PartitionList;
     typedef PartitionList::const_iterator const_iterator;
@@ -428,12 +467,26 @@ public:
     virtual bool GetForestNodePMSI(ErmVpnRoute *rt, uint32_t *label,
             Ip4Address *address, std::vector<std::string> *encap) const;
 
+    bool incremental_tree() const { return incremental_tree_; }
+    void set_incremental_tree(bool incremental_tree) {
+        incremental_tree_ = incremental_tree;
+    }
+    uint32_t tree_rebalance_threshold() const {
+        return tree_rebalance_threshold_;
+    }
+    void set_tree_rebalance_threshold(uint32_t threshold) {
+        tree_rebalance_threshold_ = threshold;
+    }
+
 private:
     friend class BgpMulticastTest;
     friend class ShowMulticastManagerDetailHandler;
 
     class DeleteActor;
 
+    static bool GetEnvIncrementalTree();
+    static uint32_t GetEnvTreeRebalanceThreshold();
+
     void AllocPartitions();
     void FreePartitions();
     void TreeNodeListener(McastManagerPartition *partition,
@@ -445,6 +498,8 @@ private:
     ErmVpnTable *table_;
     int listener_id_;
     PartitionList partitions_;
+    bool incremental_tree_;
+    uint32_t tree_rebalance_threshold_;
 
     boost::scoped_ptr<DeleteActor> deleter_;
     LifetimeRef<McastTreeManager> table_delete_ref_;
@@ -24,25 +24,31 @@ BgpPath::BgpPath(const IPeer *peer, uint32_t path_id, PathSource src,
                  const BgpAttrPtr ptr, uint32_t flags, uint32_t label,
                  uint32_t l3_label)
     : peer_(peer), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label) {
+      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label),
+      route_(NULL) {
+    UpdatePreferenceKey();
 }
 
 BgpPath::BgpPath(const IPeer *peer, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(peer), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label), l3_label_(l3_label) {
+      flags_(flags), label_(label), l3_label_(l3_label), route_(NULL) {
+    UpdatePreferenceKey();
 }
 
 BgpPath::BgpPath(uint32_t path_id, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(NULL), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label) {
+      original_attr_(ptr), flags_(flags), label_(label), l3_label_(l3_label),
+      route_(NULL) {
+    UpdatePreferenceKey();
 }
 
 BgpPath::BgpPath(PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label, uint32_t l3_label)
     : peer_(NULL), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label), l3_label_(l3_label) {
+      flags_(flags), label_(label), l3_label_(l3_label), route_(NULL) {
+    UpdatePreferenceKey();
 }
 
 // True is better
@@ -55,34 +61,49 @@ BgpPath::BgpPath(PathSource src, const BgpAttrPtr ptr,
         }                               \
     } while (0)
 
-int BgpPath::PathCompare(const BgpPath &rhs, bool allow_ecmp) const {
-    const BgpAttr *rattr = rhs.GetAttr();
-
-    // Feasible Path first
-    KEY_COMPARE(rhs.IsFeasible(), IsFeasible());
-
-    // Compare local_pref in reverse order as larger is better.
-    KEY_COMPARE(rattr->local_pref(), attr_->local_pref());
-
-    // ETree Root path first [compare in reverse order]
-    BOOL_COMPARE(rattr->etree_leaf(), attr_->etree_leaf());
-
-    // Sticky paths first
-    BOOL_COMPARE(rattr->evpn_sticky_mac(), attr_->evpn_sticky_mac());
-
-    // Compare sequence_number in reverse order as larger is better.
-    KEY_COMPARE(rattr->sequence_number(), attr_->sequence_number());
-
+//
+// Pack the leading path selection criteria so that PathCompare can compare
+// them with two integer comparisons. Each criterion is encoded so that the
+// preferred value is the smaller one.
+//
+void BgpPath::UpdatePreferenceKey() {
+    uint64_t high = IsFeasible() ? 0 : 1;
+    uint64_t low = 0;
+    bool llgr_stale = IsLlgrStale();
+    if (attr_) {
+        // Larger local_pref is better.
+        high = (high << 32) | static_cast<uint32_t>(~attr_->local_pref());
+        // ETree Root path first.
+        high = (high << 1) | (attr_->etree_leaf() ? 1 : 0);
+        high = (high << 1) | (attr_->evpn_sticky_mac() ? 1 : 0);
+        // Larger sequence_number is better.
+        low = static_cast<uint32_t>(~attr_->sequence_number());
+        llgr_stale |= attr_->community() &&
+            attr_->community()->ContainsValue(CommunityType::LlgrStale);
+    } else {
+        high <<= 34;
+    }
     // Route without LLGR_STALE community is always preferred over one with.
-    bool llgr_stale = attr_->community() && attr_->community()->ContainsValue(
-                                                CommunityType::LlgrStale);
-    llgr_stale |= IsLlgrStale();
+    low = (low << 1) | (llgr_stale ? 1 : 0);
+    preference_key_[0] = high;
+    preference_key_[1] = low;
+}
+
+int BgpPath::PreferenceKeyCompare(const BgpPath &rhs) const {
+    KEY_COMPARE(preference_key_[0], rhs.preference_key_[0]);
+    KEY_COMPARE(preference_key_[1], rhs.preference_key_[1]);
+    return 0;
+}
 
-    bool rllgr_stale = rattr->community() && rattr->community()->ContainsValue(
-                                                 CommunityType::LlgrStale);
-    rllgr_stale |= rhs.IsLlgrStale();
+int BgpPath::PathCompare(const BgpPath &rhs, bool allow_ecmp) const {
+    const BgpAttr *rattr = rhs.GetAttr();
 
-    KEY_COMPARE(llgr_stale, rllgr_stale);
+    // Feasibility, local_pref, etree leaf, sticky mac, sequence_number and
+    // llgr stale, see UpdatePreferenceKey.
+    int result = PreferenceKeyCompare(rhs);
+    if (result) {
+        return result;
+    }
 
     // Do not compare as path length for service chain paths at this point.
     // We want to treat service chain paths as ECMP irrespective of as path
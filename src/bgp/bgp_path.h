@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_BGP_PATH_H_
 #define SRC_BGP_BGP_PATH_H_
 
+#include <boost/intrusive/list.hpp>
+
 #include <string>
 #include <vector>
 
@@ -47,6 +49,12 @@ public:
         NoNeighborAs | NoTunnelEncap | OriginatorIdLooped | ResolveNexthop |
         RoutingPolicyReject | ClusterListLooped | CheckGlobalErmVpnRoute);
 
+    // Hook for the per peer path index in BgpTable. Unlinks itself when the
+    // path is destroyed.
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink>
+    > PeerPathHook;
+
     static std::string PathIdString(uint32_t path_id);
 
     BgpPath(const IPeer *peer, uint32_t path_id, PathSource src,
@@ -82,6 +90,7 @@ public:
     void SetAttr(const BgpAttrPtr attr, const BgpAttrPtr original_attr) {
         attr_ = attr;
         original_attr_ = original_attr;
+        UpdatePreferenceKey();
     }
 
     const BgpAttr *GetAttr() const { return attr_.get(); }
@@ -110,10 +119,16 @@ public:
     bool IsLlgrStale() const { return ((flags_ & LlgrStale) != 0); }
 
     // Mark a path as rejected by Routing policy
-    void SetPolicyReject() { flags_ |= RoutingPolicyReject; }
+    void SetPolicyReject() {
+        flags_ |= RoutingPolicyReject;
+        UpdatePreferenceKey();
+    }
 
     // Reset a path as active from Routing Policy
-    void ResetPolicyReject() { flags_ &= ~RoutingPolicyReject; }
+    void ResetPolicyReject() {
+        flags_ &= ~RoutingPolicyReject;
+        UpdatePreferenceKey();
+    }
 
     bool IsPolicyReject() const {
         return ((flags_ & RoutingPolicyReject) != 0);
@@ -126,26 +141,53 @@ public:
     void ResetStale() { flags_ &= ~Stale; }
 
     // Mark/Reset a path as needing resolution
-    void SetResolveNextHop() { flags_ |= ResolveNexthop; }
-    void ResetResolveNextHop() { flags_ &= ~ResolveNexthop; }
+    void SetResolveNextHop() {
+        flags_ |= ResolveNexthop;
+        UpdatePreferenceKey();
+    }
+    void ResetResolveNextHop() {
+        flags_ &= ~ResolveNexthop;
+        UpdatePreferenceKey();
+    }
 
-    void SetLlgrStale() { flags_ |= LlgrStale; }
-    void ResetLlgrStale() { flags_ &= ~LlgrStale; }
+    void SetLlgrStale() {
+        flags_ |= LlgrStale;
+        UpdatePreferenceKey();
+    }
+    void ResetLlgrStale() {
+        flags_ &= ~LlgrStale;
+        UpdatePreferenceKey();
+    }
 
     bool NeedsResolution() const { return ((flags_ & ResolveNexthop) != 0); }
     bool CheckErmVpn() const {
         return ((flags_ & CheckGlobalErmVpnRoute) != 0);
     }
-    void ResetCheckErmVpn() { flags_ &= ~CheckGlobalErmVpnRoute; }
-    void SetCheckErmVpn() { flags_ |= CheckGlobalErmVpnRoute; }
+    void ResetCheckErmVpn() {
+        flags_ &= ~CheckGlobalErmVpnRoute;
+        UpdatePreferenceKey();
+    }
+    void SetCheckErmVpn() {
+        flags_ |= CheckGlobalErmVpnRoute;
+        UpdatePreferenceKey();
+    }
 
     virtual std::string ToString() const;
 
     // Select one path over other
     int PathCompare(const BgpPath &rhs, bool allow_ecmp) const;
+    // Compare the leading path selection criteria only
+    int PreferenceKeyCompare(const BgpPath &rhs) const;
     bool PathSameNeighborAs(const BgpPath &rhs) const;
 
+    // Route the path was added to, valid while in the per peer path index.
+    BgpRoute *route() const { return route_; }
+
 private:
+    friend class BgpTable;
+
+    void UpdatePreferenceKey();
+
     const IPeer *peer_;
     const uint32_t path_id_;
     const PathSource source_;
@@ -157,6 +199,13 @@ private:
     uint32_t flags_;
     uint32_t label_;
     uint32_t l3_label_;
+    // Packed form of the path selection criteria that do not depend on the
+    // other path: feasibility, local preference, etree leaf, sticky mac,
+    // sequence number and llgr stale, in this order. Smaller is better.
+    // Updated when the attribute or the flags change.
+    uint64_t preference_key_[2];
+    PeerPathHook peer_path_hook_;
+    BgpRoute *route_;
 };
 
 class BgpSecondaryPath : public BgpPath {
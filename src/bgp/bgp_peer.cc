@@ -39,6 +39,7 @@
 #include "bgp/tunnel_encap/tunnel_encap.h"
 #include "control-node/control_node.h"
 #include "config-client-mgr/config_client_manager.h"
+#include "db/db_partition.h"
 using boost::assign::list_of;
 using boost::assign::map_list_of;
 using boost::system::error_code;
@@ -589,7 +590,9 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
     // Check rtinstance_ to accommodate unit tests.
     if (resolve_paths_ && rtinstance_) {
         rtinstance_->GetTable(Address::INET)->LocatePathResolver();
-        rtinstance_->GetTable(Address::INET6)->LocatePathResolver();
+        BgpTable *inet6_table = rtinstance_->GetTable(Address::INET6);
+        if (inet6_table)
+            inet6_table->LocatePathResolver();
     }
 
     ProcessEndpointConfig(config);
@@ -1798,6 +1801,7 @@ void BgpPeer::ProcessNlri(Address::Family family, DBRequest::DBOperation oper,
     TableT *table = static_cast<TableT *>(rtinstance_->GetTable(family));
     assert(table);
 
+    DBRequestBatch batch(table);
     for (vector<BgpProtoPrefix *>::const_iterator it = nlri->nlri.begin();
          it != nlri->nlri.end(); ++it) {
         PrefixT prefix;
@@ -1822,8 +1826,9 @@ void BgpPeer::ProcessNlri(Address::Family family, DBRequest::DBOperation oper,
                 new_attr, flags, label, l3_label, 0));
         }
         req.key.reset(new typename TableT::RequestKey(prefix, this));
-        table->Enqueue(&req);
+        batch.Add(&req);
     }
+    table->EnqueueBatch(&batch);
 }
 
 uint32_t BgpPeer::GetPathFlags(Address::Family family,
@@ -1908,6 +1913,7 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             return;
         }
 
+        DBRequestBatch batch(table);
         unreach_count += msg->withdrawn_routes.size();
         for (vector<BgpProtoPrefix *>::const_iterator it =
              msg->withdrawn_routes.begin(); it != msg->withdrawn_routes.end();
@@ -1925,7 +1931,7 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             req.oper = DBRequest::DB_ENTRY_DELETE;
             req.data.reset(NULL);
             req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            batch.Add(&req);
         }
 
         uint32_t flags = GetPathFlags(Address::INET, attr.get());
@@ -1945,8 +1951,9 @@ void BgpPeer::ProcessUpdate(const BgpProto::Update *msg, size_t msgsize) {
             req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
             req.data.reset(new InetTable::RequestData(attr, flags, 0, 0, 0));
             req.key.reset(new InetTable::RequestKey(prefix, this));
-            table->Enqueue(&req);
+            batch.Add(&req);
         }
+        table->EnqueueBatch(&batch);
     }
 
     for (vector<BgpAttribute *>::const_iterator ait =
@@ -15,6 +15,7 @@
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer.h"
 #include "bgp/bgp_server.h"
+#include "bgp/bgp_update_decoder.h"
 #include "net/bgp_af.h"
 
 using boost::system::error_code;
@@ -2084,8 +2085,22 @@ public:
     typedef mpl::list<BgpMarker, BgpMsgLength, BgpMsgTypeAs4> Sequence;
 };
 
+//
+// Common UPDATE messages are handled by BgpUpdateDecoder; everything else,
+// including all malformed messages, goes through the generic parser.
+//
 BgpProto::BgpMessage *BgpProto::Decode(const uint8_t *data, size_t size,
                                        ParseErrorContext *ec, bool as4) {
+    BgpMessage *msg = BgpUpdateDecoder::Decode(data, size, as4);
+    if (msg)
+        return msg;
+    return GenericDecode(data, size, ec, as4);
+}
+
+BgpProto::BgpMessage *BgpProto::GenericDecode(const uint8_t *data,
+                                              size_t size,
+                                              ParseErrorContext *ec,
+                                              bool as4) {
     ParseContext context;
     int result;
     if (as4) {
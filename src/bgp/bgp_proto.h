@@ -442,6 +442,9 @@ public:
 
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL, bool as4 = false);
+    static BgpMessage *GenericDecode(const uint8_t *data, size_t size,
+                                     ParseErrorContext *ec = NULL,
+                                     bool as4 = false);
 
     static int Encode(const BgpMessage *msg, uint8_t *data, size_t size,
                       EncodeOffsets *offsets = NULL, bool as4 = false);
@@ -5,6 +5,8 @@
 #include "bgp/bgp_ribout.h"
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 
 #include <algorithm>
 
@@ -75,6 +77,92 @@ bool RibOutAttr::NextHop::operator<(const NextHop &rhs) const {
     return CompareTo(rhs) < 0;
 }
 
+RibOutNextHopList::RibOutNextHopList(RibOutNextHopListDB *nexthop_list_db,
+    RibOutAttr::NextHopList *list)
+    : nexthop_list_db_(nexthop_list_db) {
+    refcount_ = 0;
+    list_.swap(*list);
+}
+
+void RibOutNextHopList::Remove() {
+    nexthop_list_db_->Delete(this);
+}
+
+int RibOutNextHopList::CompareTo(const RibOutNextHopList &rhs) const {
+    KEY_COMPARE(list_.size(), rhs.list_.size());
+    for (size_t idx = 0; idx < list_.size(); ++idx) {
+        KEY_COMPARE(list_[idx], rhs.list_[idx]);
+    }
+    return 0;
+}
+
+//
+// Hash all the fields compared by NextHop::CompareTo, without building
+// strings as the list is hashed on every lookup.
+//
+size_t hash_value(const RibOutNextHopList &nexthop_list) {
+    size_t hash = 0;
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop, nexthop_list.list()) {
+        const IpAddress &address = nexthop.address();
+        if (address.is_v4()) {
+            boost::hash_combine(hash, address.to_v4().to_ulong());
+        } else {
+            Ip6Address::bytes_type bytes = address.to_v6().to_bytes();
+            boost::hash_range(hash, bytes.begin(), bytes.end());
+        }
+        const uint8_t *mac = nexthop.mac();
+        boost::hash_range(hash, mac, mac + MacAddress::size());
+        boost::hash_combine(hash, nexthop.label());
+        boost::hash_combine(hash, nexthop.l3_label());
+        boost::hash_combine(hash, nexthop.source_address().to_ulong());
+        boost::hash_combine(hash, nexthop.origin_vn_index());
+        boost::hash_range(hash, nexthop.encap().begin(),
+                          nexthop.encap().end());
+        boost::hash_range(hash, nexthop.tag_list().begin(),
+                          nexthop.tag_list().end());
+    }
+    return hash;
+}
+
+int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list) {
+    return cnexthop_list->refcount_.fetch_and_increment();
+}
+
+int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list) {
+    return cnexthop_list->refcount_.fetch_and_decrement();
+}
+
+void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list) {
+    int prev = cnexthop_list->refcount_.fetch_and_decrement();
+    if (prev == 1) {
+        RibOutNextHopList *nexthop_list =
+            const_cast<RibOutNextHopList *>(cnexthop_list);
+        nexthop_list->Remove();
+        assert(nexthop_list->refcount_ == 0);
+        delete nexthop_list;
+    }
+}
+
+RibOutNextHopListDB::RibOutNextHopListDB() {
+}
+
+//
+// Look the list up through a temporary entry that borrows its contents, and
+// allocate an entry only when the list is not in the database yet.
+//
+RibOutNextHopListPtr RibOutNextHopListDB::Locate(
+    RibOutAttr::NextHopList *list) {
+    RibOutNextHopList key(this, list);
+    RibOutNextHopListPtr nexthop_list = Find(&key);
+    if (nexthop_list)
+        return nexthop_list;
+    return BgpPathAttributeDB<RibOutNextHopList, RibOutNextHopListPtr,
+        RibOutAttr::NextHopList, RibOutNextHopListCompare,
+        RibOutNextHopListDB>::Locate(new RibOutNextHopList(this, &key.list_));
+}
+
+const RibOutAttr::NextHopList RibOutAttr::kEmptyNextHopList;
+
 RibOutAttr::RibOutAttr()
     : label_(0),
       l3_label_(0),
@@ -104,9 +192,10 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpAttr *attr,
       is_xmpp_(is_xmpp),
       vrf_originated_(false) {
     if (attr && is_xmpp) {
-        nexthop_list_.push_back(NextHop(table, attr->nexthop(),
+        NextHopList nexthop_list(1, NextHop(table, attr->nexthop(),
             attr->mac_address(), label, l3_label, attr->ext_community(),
             false));
+        set_nexthop_list(&nexthop_list);
     }
 }
 
@@ -119,9 +208,10 @@ RibOutAttr::RibOutAttr(const BgpTable *table, const BgpRoute *route,
       vrf_originated_(route->BestPath()->IsVrfOriginated()) {
     if (attr && include_nh) {
         if (is_xmpp) {
-            nexthop_list_.push_back(NextHop(table, attr->nexthop(),
+            NextHopList nexthop_list(1, NextHop(table, attr->nexthop(),
                 attr->mac_address(), label, 0, attr->ext_community(),
                 vrf_originated_));
+            set_nexthop_list(&nexthop_list);
         } else {
             label_ = label;
             l3_label_ = 0;
@@ -146,9 +236,13 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
 
     // Encode ECMP nexthops only for XMPP peers.
     // Vrf Origination matters only for XMPP peers.
-    set_attr(table, attr, route->BestPath()->GetLabel(),
-        route->BestPath()->GetL3Label(), route->BestPath()->IsVrfOriginated(),
-        is_xmpp);
+    // The list is interned once all the nexthops are known.
+    attr_out_ = attr;
+    NextHopList nexthop_list;
+    nexthop_list.push_back(NextHop(table, attr->nexthop(),
+        attr->mac_address(), route->BestPath()->GetLabel(),
+        route->BestPath()->GetL3Label(), attr->ext_community(),
+        route->BestPath()->IsVrfOriginated()));
 
     for (Route::PathList::const_iterator it = route->GetPathList().begin();
         it != route->GetPathList().end(); ++it) {
@@ -173,12 +267,13 @@ RibOutAttr::RibOutAttr(const BgpRoute *route, const BgpAttr *attr,
             path->IsVrfOriginated());
 
         // Skip if we have already encoded this next-hop
-        if (find(nexthop_list_.begin(), nexthop_list_.end(), nexthop) !=
-                nexthop_list_.end()) {
+        if (find(nexthop_list.begin(), nexthop_list.end(), nexthop) !=
+                nexthop_list.end()) {
             continue;
         }
-        nexthop_list_.push_back(nexthop);
+        nexthop_list.push_back(nexthop);
     }
+    set_nexthop_list(&nexthop_list);
 }
 
 //
@@ -198,14 +293,12 @@ RibOutAttr &RibOutAttr::operator=(const RibOutAttr &rhs) {
 
 //
 // Comparator for RibOutAttr.
-// First compare the BgpAttr and then the nexthops.
+// First compare the BgpAttr and then the nexthops. Both are interned, so
+// comparing the pointers is enough.
 //
 int RibOutAttr::CompareTo(const RibOutAttr &rhs) const {
     KEY_COMPARE(attr_out_.get(), rhs.attr_out_.get());
-    KEY_COMPARE(nexthop_list_.size(), rhs.nexthop_list_.size());
-    for (size_t idx = 0; idx < nexthop_list_.size(); ++idx) {
-        KEY_COMPARE(nexthop_list_[idx], rhs.nexthop_list_[idx]);
-    }
+    KEY_COMPARE(nexthop_list_.get(), rhs.nexthop_list_.get());
     KEY_COMPARE(label_, rhs.label());
     KEY_COMPARE(l3_label_, rhs.l3_label());
     KEY_COMPARE(source_address_, rhs.source_address());
@@ -218,11 +311,12 @@ void RibOutAttr::set_attr(const BgpTable *table, const BgpAttrPtr &attrp,
     uint32_t label, uint32_t l3_label, bool vrf_originated, bool is_xmpp) {
     if (!attr_out_) {
         attr_out_ = attrp;
-        assert(nexthop_list_.empty());
+        assert(!nexthop_list_);
         if (is_xmpp) {
-            NextHop nexthop(table, attrp->nexthop(), attrp->mac_address(),
-                label, l3_label, attrp->ext_community(), vrf_originated);
-            nexthop_list_.push_back(nexthop);
+            NextHopList nexthop_list(1, NextHop(table, attrp->nexthop(),
+                attrp->mac_address(), label, l3_label,
+                attrp->ext_community(), vrf_originated));
+            set_nexthop_list(&nexthop_list);
         } else {
             label_ = label;
             l3_label_ = l3_label;
@@ -239,6 +333,17 @@ void RibOutAttr::set_attr(const BgpTable *table, const BgpAttrPtr &attrp,
     attr_out_ = attrp;
 }
 
+//
+// Intern the nexthop list in the database of the server that owns the
+// BgpAttr. The contents of nexthop_list are taken.
+//
+void RibOutAttr::set_nexthop_list(NextHopList *nexthop_list) {
+    assert(attr_out_ && !nexthop_list->empty());
+    BgpServer *server =
+        const_cast<BgpAttrDB *>(attr_out_->attr_db())->server();
+    nexthop_list_ = server->ribout_nexthop_list_db()->Locate(nexthop_list);
+}
+
 RouteState::RouteState() {
 }
 
@@ -5,8 +5,10 @@
 #ifndef SRC_BGP_BGP_RIBOUT_H_
 #define SRC_BGP_BGP_RIBOUT_H_
 
+#include <boost/intrusive_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/intrusive/slist.hpp>
+#include <tbb/atomic.h>
 
 #include <algorithm>
 #include <string>
@@ -20,6 +22,7 @@
 #include "db/db_entry.h"
 #include "net/tunnel_encap_type.h"
 
+class BgpServer;
 class IPeer;
 class IPeerUpdate;
 class RibOutUpdates;
@@ -28,15 +31,26 @@ class BgpTable;
 class BgpExport;
 class BgpRoute;
 class BgpUpdateSender;
+class RibOutNextHopList;
+class RibOutNextHopListDB;
 class RouteUpdate;
 class UpdateInfoSList;
 
+int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list);
+int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list);
+void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list);
+typedef boost::intrusive_ptr<RibOutNextHopList> RibOutNextHopListPtr;
+
 //
 // This class represents the attributes for a ribout entry, including the
 // label.  It is essentially a combination of a smart pointer to BgpAttr
 // and a label. The label is not included in BgpAttr in order to maximize
 // sharing of the BgpAttr.
 //
+// The nexthop list is interned in the RibOutNextHopListDB of the BgpServer
+// that owns the BgpAttr, so copying a RibOutAttr or comparing two of them
+// does not copy or walk the nexthops.
+//
 class RibOutAttr {
 public:
     // This nested class represents an ecmp element for a ribout entry. A
@@ -58,8 +72,8 @@ public:
             uint32_t l3_label() const { return l3_label_; }
             const Ip4Address &source_address() const { return source_address_; }
             int origin_vn_index() const { return origin_vn_index_; }
-            std::vector<std::string> encap() const { return encap_; }
-            std::vector<int> tag_list() const { return tag_list_; }
+            const std::vector<std::string> &encap() const { return encap_; }
+            const std::vector<int> &tag_list() const { return tag_list_; }
 
             int CompareTo(const NextHop &rhs) const;
             bool operator==(const NextHop &rhs) const;
@@ -93,7 +107,7 @@ public:
     bool operator!=(const RibOutAttr &rhs) const { return CompareTo(rhs) != 0; }
     bool IsReachable() const { return attr_out_.get() != NULL; }
 
-    const NextHopList &nexthop_list() const { return nexthop_list_; }
+    const NextHopList &nexthop_list() const;
     const BgpAttr *attr() const { return attr_out_.get(); }
     void set_attr(const BgpTable *table, const BgpAttrPtr &attrp) {
         set_attr(table, attrp, 0, 0, false, false);
@@ -110,13 +124,13 @@ public:
 
     void clear() {
         attr_out_.reset();
-        nexthop_list_.clear();
+        nexthop_list_.reset();
     }
     uint32_t label() const {
-        return nexthop_list_.empty() ? label_ : nexthop_list_[0].label();
+        return nexthop_list_ ? nexthop_list()[0].label() : label_;
     }
     uint32_t l3_label() const {
-        return nexthop_list_.empty() ? l3_label_ : nexthop_list_[0].l3_label();
+        return nexthop_list_ ? nexthop_list()[0].l3_label() : l3_label_;
     }
     const Ip4Address &source_address() const { return source_address_; }
     Ip4Address *source_address() { return &source_address_; }
@@ -129,10 +143,13 @@ public:
     }
 
 private:
+    static const NextHopList kEmptyNextHopList;
+
     int CompareTo(const RibOutAttr &rhs) const;
+    void set_nexthop_list(NextHopList *nexthop_list);
 
     BgpAttrPtr attr_out_;
-    NextHopList nexthop_list_;
+    RibOutNextHopListPtr nexthop_list_;
     uint32_t label_;
     uint32_t l3_label_;
     Ip4Address source_address_;
@@ -141,6 +158,59 @@ private:
     mutable std::string repr_;
 };
 
+//
+// An interned, immutable list of RibOutAttr nexthops. Lists with the same
+// nexthops share a single instance, hence two lists from the same database
+// are equal if and only if they are the same object.
+//
+class RibOutNextHopList {
+public:
+    // Takes the contents of list.
+    RibOutNextHopList(RibOutNextHopListDB *nexthop_list_db,
+                      RibOutAttr::NextHopList *list);
+    void Remove();
+    int CompareTo(const RibOutNextHopList &rhs) const;
+
+    const RibOutAttr::NextHopList &list() const { return list_; }
+
+    friend std::size_t hash_value(const RibOutNextHopList &nexthop_list);
+
+private:
+    friend int intrusive_ptr_add_ref(const RibOutNextHopList *cnexthop_list);
+    friend int intrusive_ptr_del_ref(const RibOutNextHopList *cnexthop_list);
+    friend void intrusive_ptr_release(const RibOutNextHopList *cnexthop_list);
+    friend class RibOutNextHopListDB;
+
+    mutable tbb::atomic<int> refcount_;
+    RibOutNextHopListDB *nexthop_list_db_;
+    RibOutAttr::NextHopList list_;
+};
+
+struct RibOutNextHopListCompare {
+    bool operator()(const RibOutNextHopList *lhs,
+                    const RibOutNextHopList *rhs) {
+        return lhs->CompareTo(*rhs) < 0;
+    }
+};
+
+//
+// Every xmpp export locates its nexthop list here. Most lists are already
+// in the database, so they are looked up before a new entry is allocated.
+//
+class RibOutNextHopListDB : public BgpPathAttributeDB<
+    RibOutNextHopList, RibOutNextHopListPtr, RibOutAttr::NextHopList,
+    RibOutNextHopListCompare, RibOutNextHopListDB> {
+public:
+    RibOutNextHopListDB();
+
+    // Takes the contents of list.
+    RibOutNextHopListPtr Locate(RibOutAttr::NextHopList *list);
+};
+
+inline const RibOutAttr::NextHopList &RibOutAttr::nexthop_list() const {
+    return nexthop_list_ ? nexthop_list_->list() : kEmptyNextHopList;
+}
+
 //
 // This class represents a bitset of peers within a RibOut. This is distinct
 // from the GroupPeerSet in order to allow it to be denser. This is possible
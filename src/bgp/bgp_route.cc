@@ -109,29 +109,61 @@ void BgpRoute::InsertPath(BgpPath *path) {
             }
         }
     }
-    insert(path);
-
-    Sort(&BgpTable::PathSelection, prev_front);
+    if (NeedsFullSort(path)) {
+        insert(path);
+        Sort(&BgpTable::PathSelection, prev_front);
+    } else {
+        InsertSorted(path, &BgpTable::PathSelection, prev_front);
+    }
 
-    // Update counters.
-    if (table)
+    // Update counters and per peer path index.
+    if (table) {
         table->UpdatePathCount(path, +1);
+        table->AddPeerPath(this, path);
+    }
     path->UpdatePeerRefCount(+1, table ? table->family() : Address::UNSPEC);
 }
 
+//
+// MED is compared only between paths from the same neighbor AS, unless always
+// compare med is enabled. Path selection is then not transitive, and the order
+// of the paths depends on how they are sorted. Returns true if the paths and
+// the given path come from more than one neighbor AS, they must be sorted as
+// a whole to keep the order of the full sort.
+//
+bool BgpRoute::NeedsFullSort(const BgpPath *path) const {
+    const BgpAttr *attr = path->GetAttr();
+    if (attr->attr_db()->server()->global_config()->always_compare_med())
+        return false;
+    for (Route::PathList::const_iterator it = GetPathList().begin();
+         it != GetPathList().end(); ++it) {
+        const BgpPath *other = static_cast<const BgpPath *>(it.operator->());
+        if (other->GetAttr()->neighbor_as() != attr->neighbor_as())
+            return true;
+    }
+    return false;
+}
+
 //
 // Delete given path and redo path selection.
 //
 void BgpRoute::DeletePath(BgpPath *path) {
     const Path *prev_front = front();
+    bool full_sort = NeedsFullSort(path);
 
     remove(path);
-    Sort(&BgpTable::PathSelection, prev_front);
+    if (full_sort) {
+        Sort(&BgpTable::PathSelection, prev_front);
+    } else {
+        SortIfNeeded(&BgpTable::PathSelection, prev_front);
+    }
 
-    // Update counters.
+    // Update counters and per peer path index.
     BgpTable *table = static_cast<BgpTable *>(get_table());
-    if (table)
+    if (table) {
         table->UpdatePathCount(path, -1);
+        table->RemovePeerPath(this, path);
+    }
     path->UpdatePeerRefCount(-1, table ? table->family() : Address::UNSPEC);
 
     delete path;
@@ -83,6 +83,8 @@ public:
     void AddExtCommunitySubCluster(BgpPath *path);
 
 private:
+    bool NeedsFullSort(const BgpPath *path) const;
+
     DISALLOW_COPY_AND_ASSIGN(BgpRoute);
 };
 
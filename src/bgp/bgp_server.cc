@@ -18,6 +18,7 @@
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_membership.h"
 #include "bgp/bgp_peer.h"
+#include "bgp/bgp_ribout.h"
 #include "bgp/bgp_ribout_updates.h"
 #include "bgp/rtarget/rtarget_table.h"
 #include "bgp/bgp_session_manager.h"
@@ -491,6 +492,7 @@ BgpServer::BgpServer(EventManager *evm)
       logging_disabled_(false),
       mvpn_ipv4_enable_(false),
       ignore_aspath_(false),
+      lazy_vrf_tables_(false),
       aspath_db_(new AsPathDB(this)),
       aspath_4byte_db_(new AsPath4ByteDB(this)),
       as4path_db_(new As4PathDB(this)),
@@ -502,6 +504,7 @@ BgpServer::BgpServer(EventManager *evm)
       extcomm_db_(new ExtCommunityDB(this)),
       ovnpath_db_(new OriginVnPathDB(this)),
       pmsi_tunnel_db_(new PmsiTunnelDB(this)),
+      ribout_nexthop_list_db_(new RibOutNextHopListDB()),
       attr_db_(new BgpAttrDB(this)),
       session_mgr_(BgpObjectFactory::Create<BgpSessionManager>(evm, this)),
       update_sender_(new BgpUpdateSender(this)),
@@ -49,6 +49,7 @@ class LifetimeActor;
 class LifetimeManager;
 class OriginVnPathDB;
 class PmsiTunnelDB;
+class RibOutNextHopListDB;
 class RoutePathReplicator;
 class RoutingInstanceMgr;
 class RoutingPolicyMgr;
@@ -187,6 +188,9 @@ public:
     ExtCommunityDB *extcomm_db() { return extcomm_db_.get(); }
     OriginVnPathDB *ovnpath_db() { return ovnpath_db_.get(); }
     PmsiTunnelDB *pmsi_tunnel_db() { return pmsi_tunnel_db_.get(); }
+    RibOutNextHopListDB *ribout_nexthop_list_db() {
+        return ribout_nexthop_list_db_.get();
+    }
 
     bool IsDeleted() const;
     bool IsReadyForDeletion();
@@ -306,6 +310,8 @@ public:
     void set_enable_4byte_as(bool flag);
     bool ignore_aspath() const { return ignore_aspath_; }
     void set_ignore_aspath(bool flag) { ignore_aspath_ = flag; }
+    bool lazy_vrf_tables() const { return lazy_vrf_tables_; }
+    void set_lazy_vrf_tables(bool flag) { lazy_vrf_tables_ = flag; }
 
 private:
     class ConfigUpdater;
@@ -360,6 +366,7 @@ private:
     bool logging_disabled_;
     bool mvpn_ipv4_enable_;
     bool ignore_aspath_;
+    bool lazy_vrf_tables_;
 
     // databases
     boost::scoped_ptr<AsPathDB> aspath_db_;
@@ -373,6 +380,7 @@ private:
     boost::scoped_ptr<ExtCommunityDB> extcomm_db_;
     boost::scoped_ptr<OriginVnPathDB> ovnpath_db_;
     boost::scoped_ptr<PmsiTunnelDB> pmsi_tunnel_db_;
+    boost::scoped_ptr<RibOutNextHopListDB> ribout_nexthop_list_db_;
     boost::scoped_ptr<BgpAttrDB> attr_db_;
 
     // sessions and state managers
@@ -8,6 +8,7 @@
 
 #include "sandesh/sandesh_trace.h"
 #include "base/task_annotations.h"
+#include "db/db.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_membership.h"
 #include "bgp/bgp_peer.h"
@@ -60,7 +61,8 @@ BgpTable::BgpTable(DB *db, const string &name)
     : RouteTable(db, name),
       rtinstance_(NULL),
       path_resolver_(NULL),
-      instance_delete_ref_(this, NULL) {
+      instance_delete_ref_(this, NULL),
+      peer_path_maps_(DB::PartitionCount()) {
     primary_path_count_ = 0;
     secondary_path_count_ = 0;
     infeasible_path_count_ = 0;
@@ -76,6 +78,14 @@ BgpTable::BgpTable(DB *db, const string &name)
 BgpTable::~BgpTable() {
     assert(path_resolver_ == NULL),
     instance_delete_ref_.Reset(NULL);
+    for (size_t idx = 0; idx < peer_path_maps_.size(); ++idx) {
+        PeerPathMap &peer_path_map = peer_path_maps_[idx];
+        for (PeerPathMap::iterator it = peer_path_map.begin();
+             it != peer_path_map.end(); ++it) {
+            it->second->clear();
+            delete it->second;
+        }
+    }
 }
 
 void BgpTable::set_routing_instance(RoutingInstance *rtinstance) {
@@ -819,8 +829,8 @@ UpdateInfo *BgpTable::GetUpdateInfo(RibOut *ribout, BgpRoute *route,
 // Bgp Path selection..
 // Based Attribute weight
 bool BgpTable::PathSelection(const Path &path1, const Path &path2) {
-    const BgpPath &l_path = dynamic_cast<const BgpPath &> (path1);
-    const BgpPath &r_path = dynamic_cast<const BgpPath &> (path2);
+    const BgpPath &l_path = static_cast<const BgpPath &> (path1);
+    const BgpPath &r_path = static_cast<const BgpPath &> (path2);
 
     // Check the weight of Path
     bool res = l_path.PathCompare(r_path, false) < 0;
@@ -1133,6 +1143,78 @@ void BgpTable::UpdatePathCount(const BgpPath *path, int count) {
     }
 }
 
+//
+// Add the path to the index of paths of its peer in the partition of route.
+// Paths that are not walked by the BgpMembershipManager are not indexed.
+//
+void BgpTable::AddPeerPath(BgpRoute *route, BgpPath *path) {
+    const IPeer *peer = path->GetPeer();
+    if (!peer || path->IsResolved() || path->IsAliased())
+        return;
+    if (dynamic_cast<BgpSecondaryPath *>(path))
+        return;
+
+    int part_id = GetTablePartition(route)->index();
+    PeerPathMap &peer_path_map = peer_path_maps_[part_id];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end()) {
+        loc = peer_path_map.insert(
+            make_pair(peer, new PeerPathList)).first;
+    }
+    path->route_ = route;
+    loc->second->push_back(*path);
+}
+
+//
+// Remove the path from the index of paths of its peer. Also get rid of the
+// list for the peer if it's empty.
+//
+void BgpTable::RemovePeerPath(BgpRoute *route, BgpPath *path) {
+    if (!path->peer_path_hook_.is_linked())
+        return;
+    path->peer_path_hook_.unlink();
+    path->route_ = NULL;
+
+    int part_id = GetTablePartition(route)->index();
+    PeerPathMap &peer_path_map = peer_path_maps_[part_id];
+    PeerPathMap::iterator loc = peer_path_map.find(path->GetPeer());
+    if (loc != peer_path_map.end() && loc->second->empty()) {
+        delete loc->second;
+        peer_path_map.erase(loc);
+    }
+}
+
+//
+// Move all paths of the peer in the given partition to the end of list.
+// The paths can still be removed from the list with RemovePeerPath and need
+// to be added back to the index with AddPeerPath once processed.
+//
+void BgpTable::SplicePeerPaths(int part_id, const IPeer *peer,
+    PeerPathList *list) {
+    PeerPathMap &peer_path_map = peer_path_maps_[part_id];
+    PeerPathMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end())
+        return;
+    list->splice(list->end(), *loc->second);
+    delete loc->second;
+    peer_path_map.erase(loc);
+}
+
+//
+// Number of paths of the peer in all partitions.
+// Testing only, the table must be quiescent.
+//
+size_t BgpTable::GetPeerPathCount(const IPeer *peer) const {
+    size_t count = 0;
+    for (size_t idx = 0; idx < peer_path_maps_.size(); ++idx) {
+        const PeerPathMap &peer_path_map = peer_path_maps_[idx];
+        PeerPathMap::const_iterator loc = peer_path_map.find(peer);
+        if (loc != peer_path_map.end())
+            count += loc->second->size();
+    }
+    return count;
+}
+
 // Check whether the route is aggregate route
 bool BgpTable::IsAggregateRoute(const BgpRoute *route) const {
     return routing_instance()->IsAggregateRoute(this, route);
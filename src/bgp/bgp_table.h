@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "base/lifetime.h"
+#include "bgp/bgp_path.h"
 #include "bgp/bgp_rib_policy.h"
 #include "db/db_table_walker.h"
 #include "route/table.h"
@@ -36,6 +37,10 @@ class BgpTable : public RouteTable {
 public:
     typedef std::map<RibExportPolicy, RibOut *> RibOutMap;
     typedef std::set<BgpTable *> TableSet;
+    typedef boost::intrusive::member_hook<BgpPath, BgpPath::PeerPathHook,
+        &BgpPath::peer_path_hook_> PeerPathMember;
+    typedef boost::intrusive::list<BgpPath, PeerPathMember,
+        boost::intrusive::constant_time_size<false> > PeerPathList;
 
     struct RequestKey : DBRequestKey {
         virtual const IPeer *GetPeer() const = 0;
@@ -174,6 +179,15 @@ public:
         llgr_stale_path_count_ += count;
     }
 
+    // Per partition index of the paths added by each IPeer. Resolved,
+    // aliased and secondary paths are not indexed, same as the paths skipped
+    // by the BgpMembershipManager walks. The index of a partition must only
+    // be accessed from the db::DBTable task for that partition.
+    void AddPeerPath(BgpRoute *route, BgpPath *path);
+    void RemovePeerPath(BgpRoute *route, BgpPath *path);
+    void SplicePeerPaths(int part_id, const IPeer *peer, PeerPathList *list);
+    size_t GetPeerPathCount(const IPeer *peer) const;
+
     // Check whether the route is aggregate route
     bool IsAggregateRoute(const BgpRoute *route) const;
 
@@ -203,6 +217,8 @@ private:
 
     class DeleteActor;
 
+    typedef std::map<const IPeer *, PeerPathList *> PeerPathMap;
+
     void PrependLocalAs(const RibOut *ribout, BgpAttr *attr, const IPeer*) const;
     void ProcessAsOverride(const RibOut *ribout, BgpAttr *attr) const;
     void ProcessRemovePrivate(const RibOut *ribout, BgpAttr *attr) const;
@@ -225,6 +241,7 @@ private:
     tbb::atomic<uint64_t> infeasible_path_count_;
     tbb::atomic<uint64_t> stale_path_count_;
     tbb::atomic<uint64_t> llgr_stale_path_count_;
+    std::vector<PeerPathMap> peer_path_maps_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpTable);
 };
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/bgp_update_decoder.h"
+
+#include <memory>
+
+#include "base/address.h"
+#include "base/parse_object.h"
+#include "bgp/bgp_aspath.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_origin_vn_path.h"
+#include "bgp/community.h"
+#include "net/bgp_af.h"
+#include "net/rd.h"
+
+using std::auto_ptr;
+using std::vector;
+
+//
+// The checks below mirror the verifiers of the generic parser in
+// bgp_proto.cc. Anything they do not cover is rejected so that the
+// generic parser makes the decision.
+//
+template <class C>
+static bool FlagsMatch(const BgpAttribute &attr) {
+    return (attr.flags & BgpAttribute::FLAG_MASK) == C::kFlags;
+}
+
+template <class C, typename T, T C::*Member>
+static BgpAttribute *DecodeValue(const BgpAttribute &attr,
+                                 const uint8_t *data, size_t size) {
+    if (size != static_cast<size_t>(C::kSize) || !FlagsMatch<C>(attr))
+        return NULL;
+    C *obj = new C(attr);
+    obj->*Member = get_value(data, C::kSize);
+    return obj;
+}
+
+template <class C, typename T, vector<T> C::*Member>
+static BgpAttribute *DecodeList(const BgpAttribute &attr,
+                                const uint8_t *data, size_t size) {
+    if (size == 0 || size % sizeof(T) != 0 || !FlagsMatch<C>(attr))
+        return NULL;
+    C *obj = new C(attr);
+    vector<T> *list = &(obj->*Member);
+    list->reserve(size / sizeof(T));
+    for (size_t offset = 0; offset < size; offset += sizeof(T)) {
+        list->push_back(get_value(data + offset, sizeof(T)));
+    }
+    return obj;
+}
+
+template <class C, typename T>
+static BgpAttribute *DecodeAsPath(const BgpAttribute &attr,
+                                  const uint8_t *data, size_t size) {
+    if (!FlagsMatch<C>(attr))
+        return NULL;
+    auto_ptr<C> obj(new C(attr));
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < 2)
+            return NULL;
+        size_t count = data[offset + 1];
+        size_t length = count * sizeof(T);
+        if (count == 0 || size - offset - 2 < length)
+            return NULL;
+        typename C::PathSegment *segment = new typename C::PathSegment;
+        obj->path_segments.push_back(segment);
+        segment->path_segment_type = data[offset];
+        offset += 2;
+        segment->path_segment.reserve(count);
+        for (size_t idx = 0; idx < count; ++idx, offset += sizeof(T)) {
+            segment->path_segment.push_back(
+                get_value(data + offset, sizeof(T)));
+        }
+    }
+    return obj.release();
+}
+
+BgpProto::Update *BgpUpdateDecoder::Decode(const uint8_t *data, size_t size,
+                                           bool as4) {
+    if (size < kHeaderSize + 4 ||
+        size > static_cast<size_t>(BgpProto::kMaxMessageSize))
+        return NULL;
+    for (int idx = 0; idx < 16; ++idx) {
+        if (data[idx] != 0xff)
+            return NULL;
+    }
+    if (get_value(data + 16, 2) != size || data[18] != BgpProto::UPDATE)
+        return NULL;
+
+    const uint8_t *end = data + size;
+    const uint8_t *ptr = data + kHeaderSize;
+    auto_ptr<BgpProto::Update> msg(new BgpProto::Update);
+
+    size_t withdrawn_size = get_value(ptr, 2);
+    ptr += 2;
+    if (withdrawn_size > static_cast<size_t>(end - ptr) ||
+        !DecodePrefixes(ptr, withdrawn_size, &msg->withdrawn_routes))
+        return NULL;
+    ptr += withdrawn_size;
+
+    if (end - ptr < 2)
+        return NULL;
+    size_t attr_size = get_value(ptr, 2);
+    ptr += 2;
+    if (attr_size > static_cast<size_t>(end - ptr) ||
+        !DecodeAttributes(ptr, attr_size, as4, &msg->path_attributes))
+        return NULL;
+    ptr += attr_size;
+
+    if (!DecodePrefixes(ptr, end - ptr, &msg->nlri))
+        return NULL;
+    return msg.release();
+}
+
+//
+// Prefixes encoded as a length in bits followed by the significant bytes.
+//
+bool BgpUpdateDecoder::DecodePrefixes(const uint8_t *data, size_t size,
+                                      vector<BgpProtoPrefix *> *list) {
+    size_t offset = 0;
+    while (offset < size) {
+        int prefixlen = data[offset++];
+        size_t length = (prefixlen + 7) / 8;
+        if (size - offset < length)
+            return false;
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        list->push_back(prefix);
+        prefix->prefixlen = prefixlen;
+        prefix->prefix.assign(data + offset, data + offset + length);
+        offset += length;
+    }
+    return true;
+}
+
+//
+// Evpn prefixes encoded as a route type and a length in bytes followed by
+// the route.
+//
+bool BgpUpdateDecoder::DecodeTypedPrefixes(const uint8_t *data, size_t size,
+                                           vector<BgpProtoPrefix *> *list) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < 2)
+            return false;
+        uint8_t type = data[offset];
+        size_t length = data[offset + 1];
+        offset += 2;
+        if (size - offset < length)
+            return false;
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        list->push_back(prefix);
+        prefix->type = type;
+        prefix->prefixlen = length * 8;
+        prefix->prefix.assign(data + offset, data + offset + length);
+        offset += length;
+    }
+    return true;
+}
+
+bool BgpUpdateDecoder::DecodeAttributes(const uint8_t *data, size_t size,
+                                        bool as4,
+                                        vector<BgpAttribute *> *list) {
+    size_t offset = 0;
+    while (offset < size) {
+        if (size - offset < 3)
+            return false;
+        uint8_t flags = data[offset];
+        uint8_t code = data[offset + 1];
+        size_t len_size = (flags & BgpAttribute::ExtendedLength) ? 2 : 1;
+        if (size - offset - 2 < len_size)
+            return false;
+        size_t length = get_value(data + offset + 2, len_size);
+        offset += 2 + len_size;
+        if (size - offset < length)
+            return false;
+        BgpAttribute *attr = DecodeAttribute(BgpAttribute(code, flags),
+                                             data + offset, length, as4);
+        if (!attr)
+            return false;
+        list->push_back(attr);
+        offset += length;
+    }
+    return true;
+}
+
+BgpAttribute *BgpUpdateDecoder::DecodeAttribute(const BgpAttribute &attr,
+                                                const uint8_t *data,
+                                                size_t size, bool as4) {
+    switch (attr.code) {
+    case BgpAttribute::Origin:
+        if (size != 1 || data[0] > BgpAttrOrigin::INCOMPLETE)
+            return NULL;
+        return DecodeValue<BgpAttrOrigin, int, &BgpAttrOrigin::origin>(
+            attr, data, size);
+    case BgpAttribute::AsPath:
+        if (as4)
+            return DecodeAsPath<AsPath4ByteSpec, as_t>(attr, data, size);
+        return DecodeAsPath<AsPathSpec, as2_t>(attr, data, size);
+    case BgpAttribute::NextHop:
+        if (size != 4 || get_value(data, size) == 0)
+            return NULL;
+        return DecodeValue<BgpAttrNextHop, uint32_t, &BgpAttrNextHop::nexthop>(
+            attr, data, size);
+    case BgpAttribute::MultiExitDisc:
+        return DecodeValue<BgpAttrMultiExitDisc, uint32_t,
+                           &BgpAttrMultiExitDisc::med>(attr, data, size);
+    case BgpAttribute::LocalPref:
+        return DecodeValue<BgpAttrLocalPref, uint32_t,
+                           &BgpAttrLocalPref::local_pref>(attr, data, size);
+    case BgpAttribute::Communities:
+        return DecodeList<CommunitySpec, uint32_t,
+                          &CommunitySpec::communities>(attr, data, size);
+    case BgpAttribute::OriginatorId:
+        return DecodeValue<BgpAttrOriginatorId, uint32_t,
+                           &BgpAttrOriginatorId::originator_id>(
+            attr, data, size);
+    case BgpAttribute::ClusterList:
+        return DecodeList<ClusterListSpec, uint32_t,
+                          &ClusterListSpec::cluster_list>(attr, data, size);
+    case BgpAttribute::MPReachNlri:
+    case BgpAttribute::MPUnreachNlri:
+        return DecodeMpNlri(attr, data, size);
+    case BgpAttribute::ExtendedCommunities:
+        return DecodeList<ExtCommunitySpec, uint64_t,
+                          &ExtCommunitySpec::communities>(attr, data, size);
+    case BgpAttribute::OriginVnPath:
+        return DecodeList<OriginVnPathSpec, uint64_t,
+                          &OriginVnPathSpec::origin_vns>(attr, data, size);
+    default:
+        return NULL;
+    }
+}
+
+BgpAttribute *BgpUpdateDecoder::DecodeMpNlri(const BgpAttribute &attr,
+                                             const uint8_t *data,
+                                             size_t size) {
+    if (size < 3 || !FlagsMatch<BgpMpNlri>(attr))
+        return NULL;
+    uint16_t afi = get_value(data, 2);
+    uint8_t safi = data[2];
+    size_t nexthop_size;
+    bool typed = false;
+    if (afi == BgpAf::IPv4 && safi == BgpAf::Vpn) {
+        nexthop_size = RouteDistinguisher::kSize + Address::kMaxV4Bytes;
+    } else if (afi == BgpAf::IPv6 && safi == BgpAf::Vpn) {
+        nexthop_size = RouteDistinguisher::kSize + Address::kMaxV6Bytes;
+    } else if (afi == BgpAf::L2Vpn && safi == BgpAf::EVpn) {
+        nexthop_size = Address::kMaxV4Bytes;
+        typed = true;
+    } else if (afi == BgpAf::IPv4 && safi == BgpAf::RTarget) {
+        nexthop_size = Address::kMaxV4Bytes;
+    } else {
+        return NULL;
+    }
+
+    auto_ptr<BgpMpNlri> obj(new BgpMpNlri(attr));
+    obj->afi = afi;
+    obj->safi = safi;
+    size_t offset = 3;
+    if (attr.code == BgpAttribute::MPReachNlri) {
+        // Next hop length, next hop and reserved byte.
+        if (size - offset < nexthop_size + 2 ||
+            static_cast<size_t>(data[offset]) != nexthop_size)
+            return NULL;
+        offset++;
+        obj->nexthop.assign(data + offset, data + offset + nexthop_size);
+        offset += nexthop_size + 1;
+    }
+
+    bool ok;
+    if (typed) {
+        ok = DecodeTypedPrefixes(data + offset, size - offset, &obj->nlri);
+    } else {
+        ok = DecodePrefixes(data + offset, size - offset, &obj->nlri);
+    }
+    return ok ? obj.release() : NULL;
+}
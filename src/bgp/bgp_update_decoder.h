@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_BGP_UPDATE_DECODER_H_
+#define SRC_BGP_BGP_UPDATE_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "bgp/bgp_proto.h"
+
+class BgpAttribute;
+struct BgpProtoPrefix;
+
+//
+// Hand written decoder for the UPDATE messages that make up the bulk of the
+// traffic between control-nodes and with MX gateways: inet-vpn, inet6-vpn,
+// evpn and route-target MP_REACH/MP_UNREACH plus ipv4 NLRI, carrying ORIGIN,
+// AS_PATH, NEXT_HOP, MED, LOCAL_PREF, COMMUNITIES, ORIGINATOR_ID,
+// CLUSTER_LIST, EXTENDED_COMMUNITIES and ORIGIN_VN_PATH.
+//
+// Decode walks the message once with explicit bounds checks and builds the
+// same BgpProto::Update as the generic parser. It returns NULL for anything
+// else, including every malformed message, and the caller then runs the
+// generic parser, which also builds the error context for the notification.
+//
+class BgpUpdateDecoder {
+public:
+    static BgpProto::Update *Decode(const uint8_t *data, size_t size,
+                                    bool as4);
+
+private:
+    static const size_t kHeaderSize = BgpProto::kMinMessageSize;
+
+    static bool DecodePrefixes(const uint8_t *data, size_t size,
+                               std::vector<BgpProtoPrefix *> *list);
+    static bool DecodeTypedPrefixes(const uint8_t *data, size_t size,
+                                    std::vector<BgpProtoPrefix *> *list);
+    static bool DecodeAttributes(const uint8_t *data, size_t size, bool as4,
+                                 std::vector<BgpAttribute *> *list);
+    static BgpAttribute *DecodeAttribute(const BgpAttribute &attr,
+                                         const uint8_t *data, size_t size,
+                                         bool as4);
+    static BgpAttribute *DecodeMpNlri(const BgpAttribute &attr,
+                                      const uint8_t *data, size_t size);
+
+    BgpUpdateDecoder();
+};
+
+#endif  // SRC_BGP_BGP_UPDATE_DECODER_H_
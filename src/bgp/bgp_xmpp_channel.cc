@@ -35,11 +35,13 @@
 #include "bgp/security_group/security_group.h"
 #include "bgp/tunnel_encap/tunnel_encap.h"
 #include "bgp/bgp_xmpp_rtarget_manager.h"
+#include "bgp/xmpp_item_decoder.h"
 #include "control-node/sandesh/control_node_types.h"
 #include "net/community_type.h"
 #include "schema/xmpp_multicast_types.h"
 #include "schema/xmpp_enet_types.h"
 #include "schema/xmpp_mvpn_types.h"
+#include "schema/xmpp_unicast_types.h"
 #include "xml/xml_pugi.h"
 #include "xmpp/xmpp_connection.h"
 #include "xmpp/xmpp_init.h"
@@ -505,7 +507,9 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel,
             TaskScheduler::GetInstance()->GetTaskId("xmpp::StateMachine"),
             channel->GetTaskInstance(),
             boost::bind(&BgpXmppChannel::MembershipResponseHandler, this, _1)),
-      lb_mgr_(new LabelBlockManager()) {
+      lb_mgr_(new LabelBlockManager()),
+      inet_item_(new ItemType()),
+      enet_item_(new EnetItemType()) {
     close_manager_.reset(
         BgpObjectFactory::Create<PeerCloseManager>(peer_close_.get()));
     if (bgp_server) {
@@ -602,6 +606,11 @@ void BgpXmppChannel::RoutingInstanceCallback(string vrf_name, int op) {
             return;
         ProcessDeferredSubscribeRequest(rt_instance, *imr_state);
         DeleteInstanceMembershipState(vrf_name);
+    } else if (op == RoutingInstanceMgr::INSTANCE_TABLE_ADD) {
+        const SubscriptionState *sub_state = GetSubscriptionState(rt_instance);
+        if (!sub_state)
+            return;
+        ProcessTableAdd(rt_instance, *sub_state);
     } else {
         SubscriptionState *sub_state = GetSubscriptionState(rt_instance);
         if (!sub_state)
@@ -743,7 +752,22 @@ bool BgpXmppChannel::VerifyMembership(const string &vrf_name,
     RoutingInstance *rt_instance = instance_mgr->GetRoutingInstance(vrf_name);
     if (rt_instance)
         *table = rt_instance->GetTable(family);
-    if (rt_instance != NULL && !rt_instance->deleted()) {
+    if (rt_instance != NULL && !rt_instance->deleted() &&
+        (!*table || (*table)->IsDeleted())) {
+        // The table is created on first use. Request it and defer the route
+        // till the subscription for the table is processed.
+        const SubscriptionState *sub_state = GetSubscriptionState(rt_instance);
+        if (!sub_state || !rt_instance->IsLazyFamily(family)) {
+            BGP_LOG_PEER_INSTANCE_CRITICAL(Peer(), vrf_name,
+                BGP_PEER_DIR_IN, BGP_LOG_FLAG_ALL,
+                "Received route without subscribe");
+            return false;
+        }
+        instance_mgr->RequestTable(vrf_name, family);
+        *table = NULL;
+        *instance_id = sub_state->index;
+        *subscribe_pending = true;
+    } else if (rt_instance != NULL && !rt_instance->deleted()) {
         RequestType req_type;
         if (GetMembershipInfo(*table, instance_id,
                               subscription_gen_id, &req_type)) {
@@ -1140,14 +1164,21 @@ bool BgpXmppChannel::ProcessMvpnItem(string vrf_name,
 
 bool BgpXmppChannel::ProcessItem(string vrf_name,
     const pugi::xml_node &node, bool add_change, int primary_instance_id) {
-    ItemType item;
-    item.Clear();
-
-    if (!item.XmlParse(node)) {
-        BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
-            "Invalid inet route message received");
-        return false;
+    // Decode into the item kept for the channel, fall back to the autogen
+    // parser for anything the decoder does not handle.
+    ItemType *itemp = inet_item_.get();
+    auto_ptr<ItemType> parsed_item;
+    if (!XmppItemDecoder::Decode(node, itemp)) {
+        parsed_item.reset(new ItemType());
+        parsed_item->Clear();
+        if (!parsed_item->XmlParse(node)) {
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
+                "Invalid inet route message received");
+            return false;
+        }
+        itemp = parsed_item.get();
     }
+    const ItemType &item = *itemp;
 
     if (item.entry.nlri.af != BgpAf::IPv4) {
         BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
@@ -1429,15 +1460,22 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
 
 bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
     const pugi::xml_node &node, bool add_change) {
-    ItemType item;
-    item.Clear();
-
-    if (!item.XmlParse(node)) {
-        error_stats().incr_inet6_rx_bad_xml_token_count();
-        BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
-            "Invalid inet6 route message received");
-        return false;
+    // Decode into the item kept for the channel, fall back to the autogen
+    // parser for anything the decoder does not handle.
+    ItemType *itemp = inet_item_.get();
+    auto_ptr<ItemType> parsed_item;
+    if (!XmppItemDecoder::Decode(node, itemp)) {
+        parsed_item.reset(new ItemType());
+        parsed_item->Clear();
+        if (!parsed_item->XmlParse(node)) {
+            error_stats().incr_inet6_rx_bad_xml_token_count();
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
+                "Invalid inet6 route message received");
+            return false;
+        }
+        itemp = parsed_item.get();
     }
+    const ItemType &item = *itemp;
 
     if (item.entry.nlri.af != BgpAf::IPv6) {
         error_stats().incr_inet6_rx_bad_afi_safi_count();
@@ -1758,14 +1796,21 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
 
 bool BgpXmppChannel::ProcessEnetItem(string vrf_name,
     const pugi::xml_node &node, bool add_change) {
-    EnetItemType item;
-    item.Clear();
-
-    if (!item.XmlParse(node)) {
-        BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
-            "Invalid enet route message received");
-        return false;
+    // Decode into the item kept for the channel, fall back to the autogen
+    // parser for anything the decoder does not handle.
+    EnetItemType *itemp = enet_item_.get();
+    auto_ptr<EnetItemType> parsed_item;
+    if (!XmppItemDecoder::Decode(node, itemp)) {
+        parsed_item.reset(new EnetItemType());
+        parsed_item->Clear();
+        if (!parsed_item->XmlParse(node)) {
+            BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
+                "Invalid enet route message received");
+            return false;
+        }
+        itemp = parsed_item.get();
     }
+    const EnetItemType &item = *itemp;
 
     if (item.entry.nlri.af != BgpAf::L2Vpn) {
         BGP_LOG_PEER_INSTANCE_WARNING(Peer(), vrf_name, BGP_LOG_FLAG_ALL,
@@ -2510,8 +2555,8 @@ void BgpXmppChannel::ClearStaledSubscription(RoutingInstance *rt_instance,
 }
 
 void BgpXmppChannel::AddSubscriptionState(RoutingInstance *rt_instance,
-        int index) {
-    SubscriptionState state(rt_instance->GetImportList(), index);
+        int index, bool no_ribout) {
+    SubscriptionState state(rt_instance->GetImportList(), index, no_ribout);
     pair<SubscribedRoutingInstanceList::iterator, bool> ret =
         routing_instances_.insert(pair<RoutingInstance *, SubscriptionState> (
                                       rt_instance, state));
@@ -2547,13 +2592,15 @@ void BgpXmppChannel::ProcessDeferredSubscribeRequest(RoutingInstance *instance,
     const InstanceMembershipRequestState &imr_state) {
     int instance_id = imr_state.instance_id;
     bool no_ribout = imr_state.no_ribout;
-    AddSubscriptionState(instance, instance_id);
+    AddSubscriptionState(instance, instance_id, no_ribout);
     RoutingInstance::RouteTableList const rt_list = instance->GetTables();
     for (RoutingInstance::RouteTableList::const_iterator it = rt_list.begin();
          it != rt_list.end(); ++it) {
         BgpTable *table = it->second;
         if (table->IsVpnTable() || table->family() == Address::RTARGET)
             continue;
+        if (table->IsDeleted())
+            continue;
 
         TableMembershipRequestState tmr_state(
             SUBSCRIBE, instance_id, no_ribout);
@@ -2562,6 +2609,34 @@ void BgpXmppChannel::ProcessDeferredSubscribeRequest(RoutingInstance *instance,
     }
 }
 
+//
+// Subscribe to tables of a subscribed routing instance that got created
+// after the subscription was processed. Requests deferred for the tables
+// are processed when the subscribe completes.
+//
+void BgpXmppChannel::ProcessTableAdd(RoutingInstance *rt_instance,
+    const SubscriptionState &sub_state) {
+    BgpMembershipManager *mgr = bgp_server_->membership_mgr();
+    RoutingInstance::RouteTableList const rt_list = rt_instance->GetTables();
+    for (RoutingInstance::RouteTableList::const_iterator it = rt_list.begin();
+         it != rt_list.end(); ++it) {
+        BgpTable *table = it->second;
+        if (table->IsVpnTable() || table->family() == Address::RTARGET)
+            continue;
+        if (table->IsDeleted())
+            continue;
+        if (GetTableMembershipState(table->name()))
+            continue;
+        if (mgr->IsRegistered(peer_.get(), table))
+            continue;
+
+        TableMembershipRequestState tmr_state(
+            SUBSCRIBE, sub_state.index, sub_state.no_ribout);
+        AddTableMembershipState(table->name(), tmr_state);
+        RegisterTable(table, &tmr_state);
+    }
+}
+
 void BgpXmppChannel::ProcessSubscriptionRequest(
         string vrf_name, const XmppStanza::XmppMessageIq *iq,
         bool add_change) {
@@ -2697,7 +2772,7 @@ void BgpXmppChannel::ProcessSubscriptionRequest(
     }
 
     if (add_change) {
-        AddSubscriptionState(rt_instance, instance_id);
+        AddSubscriptionState(rt_instance, instance_id, no_ribout);
     } else  {
         rtarget_manager_->PublishRTargetRoute(rt_instance, false);
         DeleteSubscriptionState(rt_instance);
@@ -2711,6 +2786,8 @@ void BgpXmppChannel::ProcessSubscriptionRequest(
             continue;
 
         if (add_change) {
+            if (table->IsDeleted())
+                continue;
             TableMembershipRequestState *tmr_state =
                 GetTableMembershipState(table->name());
             if (!tmr_state) {
@@ -2748,6 +2825,23 @@ void BgpXmppChannel::ProcessSubscriptionRequest(
             }
         }
     }
+
+    // Flush requests deferred for tables that were requested on first use
+    // but have not been created yet.
+    if (!add_change) {
+        static const Address::Family kLazyFamilies[] = {
+            Address::INET6, Address::MVPN
+        };
+        for (size_t idx = 0; idx < sizeof(kLazyFamilies) /
+             sizeof(kLazyFamilies[0]); ++idx) {
+            string table_name =
+                RoutingInstance::GetTableName(vrf_name, kLazyFamilies[idx]);
+            if (rt_list.find(table_name) != rt_list.end())
+                continue;
+            if (defer_q_.count(make_pair(vrf_name, table_name)))
+                FlushDeferQ(vrf_name, table_name);
+        }
+    }
 }
 
 void BgpXmppChannel::ClearEndOfRibState() {
@@ -24,6 +24,11 @@
 #include "tbb/atomic.h"
 #include "xmpp/xmpp_channel.h"
 
+namespace autogen {
+class EnetItemType;
+class ItemType;
+}
+
 namespace pugi {
 class xml_node;
 }
@@ -236,10 +241,11 @@ private:
             LLGR_STALE = 1 << 1
         };
 
-        SubscriptionState() : index(-1), state(NONE) { }
+        SubscriptionState() : index(-1), no_ribout(false), state(NONE) { }
         SubscriptionState(const RoutingInstance::RouteTargetList &targets,
-                          int index)
-                : targets(targets), index(index), state(NONE) { }
+                          int index, bool no_ribout)
+                : targets(targets), index(index), no_ribout(no_ribout),
+                  state(NONE) { }
 
         bool IsGrStale() const { return((state & GR_STALE) != 0); }
         void SetGrStale() { state |= GR_STALE; }
@@ -251,6 +257,7 @@ private:
 
         RoutingInstance::RouteTargetList targets;
         int index;
+        bool no_ribout;
         uint32_t state;
     };
 
@@ -314,7 +321,10 @@ private:
     void ProcessSubscriptionRequest(std::string rt_instance,
                                     const XmppStanza::XmppMessageIq *iq,
                                     bool add_change);
-    void AddSubscriptionState(RoutingInstance *rt_instance, int index);
+    void AddSubscriptionState(RoutingInstance *rt_instance, int index,
+                              bool no_ribout);
+    void ProcessTableAdd(RoutingInstance *rt_instance,
+                         const SubscriptionState &sub_state);
     void DeleteSubscriptionState(RoutingInstance *rt_instance);
     SubscriptionState *GetSubscriptionState(RoutingInstance *rt_instance);
     const SubscriptionState *GetSubscriptionState(
@@ -378,6 +388,10 @@ private:
     // Label block manager for multicast labels.
     LabelBlockManagerPtr lb_mgr_;
 
+    // Reused to decode the inet, inet6 and enet items from the agent.
+    boost::scoped_ptr<autogen::ItemType> inet_item_;
+    boost::scoped_ptr<autogen::EnetItemType> enet_item_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpXmppChannel);
 };
 
@@ -29,6 +29,9 @@ public:
 
     virtual std::auto_ptr<DBEntry> AllocEntry(const DBRequestKey *key) const;
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
+    virtual PartitionStore GetPartitionStore() const {
+        return LargeTablePartitionStore();
+    }
     virtual void AddRemoveCallback(const DBEntryBase *entry, bool add) const;
 
     virtual Address::Family family() const { return Address::EVPN; }
@@ -33,6 +33,9 @@ public:
 
     virtual std::auto_ptr<DBEntry> AllocEntry(const DBRequestKey *key) const;
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
+    virtual PartitionStore GetPartitionStore() const {
+        return LargeTablePartitionStore();
+    }
 
     virtual Address::Family family() const { return family_; }
 
@@ -30,6 +30,9 @@ public:
 
     virtual std::auto_ptr<DBEntry> AllocEntry(const DBRequestKey *key) const;
     virtual std::auto_ptr<DBEntry> AllocEntryStr(const std::string &key) const;
+    virtual PartitionStore GetPartitionStore() const {
+        return LargeTablePartitionStore();
+    }
 
     virtual Address::Family family() const { return Address::INETVPN; }
     virtual bool IsVpnTable() const { return true; }
@@ -5,6 +5,7 @@
 #include "bgp/routing-instance/path_resolver.h"
 
 #include <boost/foreach.hpp>
+#include <boost/functional/hash.hpp>
 
 #include "base/lifetime.h"
 #include "base/set_util.h"
@@ -61,6 +62,23 @@ bool PathResolver::RoutePrefixMatch(const BgpRoute *route,
     return prefix.IsMoreSpecific(inet6_route->GetPrefix());
 }
 
+//
+// Hash of the IP address. Also used to pick the ResolverNexthopShard.
+//
+static size_t AddressHash(const IpAddress &address) {
+    if (address.is_v4())
+        return boost::hash_value(address.to_v4().to_ulong());
+    Ip6Address::bytes_type bytes = address.to_v6().to_bytes();
+    return boost::hash_range(bytes.begin(), bytes.end());
+}
+
+size_t PathResolver::ResolverNexthopKeyHash::operator()(
+    const ResolverNexthopKey &key) const {
+    size_t hash = AddressHash(key.first);
+    boost::hash_combine(hash, key.second);
+    return hash;
+}
+
 class PathResolver::DeleteActor : public LifetimeActor {
 public:
     explicit DeleteActor(PathResolver *resolver)
@@ -109,6 +127,7 @@ PathResolver::PathResolver(BgpTable *table)
       table_delete_ref_(this, table->deleter()) {
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
         partitions_.push_back(new PathResolverPartition(part_id, this));
+        nexthop_shards_.push_back(new ResolverNexthopShard);
     }
 }
 
@@ -118,13 +137,14 @@ PathResolver::PathResolver(BgpTable *table)
 // A PathResolver is deleted via LifetimeManager deletion.
 // Actual destruction of the object happens via BgpTable::DestroyPathResolver.
 //
-// Need to do a deep delete of the partitions vector to ensure deletion of all
-// PathResolverPartitions.
+// Need to do a deep delete of the partitions and shards vectors to ensure
+// deletion of all PathResolverPartitions and ResolverNexthopShards.
 //
 PathResolver::~PathResolver() {
     assert(listener_id_ != DBTableBase::kInvalidId);
     table_->Unregister(listener_id_);
     STLDeleteValues(&partitions_);
+    STLDeleteValues(&nexthop_shards_);
     nexthop_reg_unreg_trigger_->Reset();
     nexthop_update_trigger_->Reset();
 }
@@ -186,8 +206,9 @@ BgpConditionListener *PathResolver::get_condition_listener(
 //
 void PathResolver::RegisterUnregisterResolverNexthop(
     ResolverNexthop *rnexthop) {
-    tbb::mutex::scoped_lock lock(mutex_);
-    nexthop_reg_unreg_list_.insert(rnexthop);
+    ResolverNexthopShard *shard = GetNexthopShard(rnexthop->address());
+    tbb::mutex::scoped_lock lock(shard->mutex);
+    shard->reg_unreg_list.insert(rnexthop);
     nexthop_reg_unreg_trigger_->Set();
 }
 
@@ -196,8 +217,9 @@ void PathResolver::RegisterUnregisterResolverNexthop(
 // list.
 //
 void PathResolver::UpdateResolverNexthop(ResolverNexthop *rnexthop) {
-    tbb::mutex::scoped_lock lock(mutex_);
-    nexthop_update_list_.insert(rnexthop);
+    ResolverNexthopShard *shard = GetNexthopShard(rnexthop->address());
+    tbb::mutex::scoped_lock lock(shard->mutex);
+    shard->update_list.insert(rnexthop);
     nexthop_update_trigger_->Set();
 }
 
@@ -212,6 +234,14 @@ PathResolverPartition *PathResolver::GetPartition(int part_id) const {
     return partitions_[part_id];
 }
 
+//
+// Get the ResolverNexthopShard for the given IpAddress.
+//
+PathResolver::ResolverNexthopShard *PathResolver::GetNexthopShard(
+    const IpAddress &address) const {
+    return nexthop_shards_[AddressHash(address) % nexthop_shards_.size()];
+}
+
 //
 // Find ResolverRouteState for the given BgpRoute.
 //
@@ -248,20 +278,22 @@ ResolverNexthop *PathResolver::LocateResolverNexthop(IpAddress address,
     CHECK_CONCURRENCY("db::DBTable", "bgp::RouteAggregation",
                       "bgp::Config", "bgp::ConfigHelper");
 
-    tbb::mutex::scoped_lock lock(mutex_);
+    ResolverNexthopShard *shard = GetNexthopShard(address);
+    tbb::mutex::scoped_lock lock(shard->mutex);
     ResolverNexthopKey key(address, table);
-    ResolverNexthopMap::iterator loc = nexthop_map_.find(key);
-    if (loc != nexthop_map_.end()) {
+    ResolverNexthopMap::iterator loc = shard->nexthop_map.find(key);
+    if (loc != shard->nexthop_map.end()) {
         return loc->second;
     } else {
         ResolverNexthop *rnexthop = new ResolverNexthop(this, address, table);
-        nexthop_map_.insert(make_pair(key, rnexthop));
+        shard->nexthop_map.insert(make_pair(key, rnexthop));
         return rnexthop;
     }
 }
 
 //
-// Remove the ResolverNexthop from the map and the update list.
+// Remove the ResolverNexthop from the map and the update lists, including
+// the nexthop update lists of the partitions.
 // Called when ResolverPath is being unregistered from BgpConditionListener
 // as part of register/unregister list processing.
 //
@@ -276,11 +308,15 @@ ResolverNexthop *PathResolver::LocateResolverNexthop(IpAddress address,
 void PathResolver::RemoveResolverNexthop(ResolverNexthop *rnexthop) {
     CHECK_CONCURRENCY("bgp::Config");
 
+    ResolverNexthopShard *shard = GetNexthopShard(rnexthop->address());
     ResolverNexthopKey key(rnexthop->address(), rnexthop->table());
-    ResolverNexthopMap::iterator loc = nexthop_map_.find(key);
-    assert(loc != nexthop_map_.end());
-    nexthop_map_.erase(loc);
-    nexthop_update_list_.erase(rnexthop);
+    ResolverNexthopMap::iterator loc = shard->nexthop_map.find(key);
+    assert(loc != shard->nexthop_map.end());
+    shard->nexthop_map.erase(loc);
+    shard->update_list.erase(rnexthop);
+    for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
+        partitions_[part_id]->RemoveResolverNexthop(rnexthop);
+    }
 }
 
 //
@@ -371,13 +407,15 @@ bool PathResolver::ProcessResolverNexthopRegUnreg(ResolverNexthop *rnexthop) {
 bool PathResolver::ProcessResolverNexthopRegUnregList() {
     CHECK_CONCURRENCY("bgp::Config");
 
-    for (ResolverNexthopList::iterator it = nexthop_reg_unreg_list_.begin();
-         it != nexthop_reg_unreg_list_.end(); ++it) {
-        ResolverNexthop *rnexthop = *it;
-        if (ProcessResolverNexthopRegUnreg(rnexthop))
-            delete rnexthop;
+    BOOST_FOREACH(ResolverNexthopShard *shard, nexthop_shards_) {
+        for (ResolverNexthopList::iterator it = shard->reg_unreg_list.begin();
+             it != shard->reg_unreg_list.end(); ++it) {
+            ResolverNexthop *rnexthop = *it;
+            if (ProcessResolverNexthopRegUnreg(rnexthop))
+                delete rnexthop;
+        }
+        shard->reg_unreg_list.clear();
     }
-    nexthop_reg_unreg_list_.clear();
 
     RetryDelete();
     return true;
@@ -385,17 +423,20 @@ bool PathResolver::ProcessResolverNexthopRegUnregList() {
 
 //
 // Handle processing of all ResolverNexthops on the update list.
+// The dependent ResolverPaths are triggered by the partitions.
 //
 bool PathResolver::ProcessResolverNexthopUpdateList() {
     CHECK_CONCURRENCY("bgp::ResolverNexthop");
 
-    for (ResolverNexthopList::iterator it = nexthop_update_list_.begin();
-         it != nexthop_update_list_.end(); ++it) {
-        ResolverNexthop *rnexthop = *it;
-        assert(!rnexthop->deleted());
-        rnexthop->TriggerAllResolverPaths();
+    BOOST_FOREACH(ResolverNexthopShard *shard, nexthop_shards_) {
+        for (ResolverNexthopList::iterator it = shard->update_list.begin();
+             it != shard->update_list.end(); ++it) {
+            ResolverNexthop *rnexthop = *it;
+            assert(!rnexthop->deleted());
+            rnexthop->TriggerAllResolverPaths();
+        }
+        shard->update_list.clear();
     }
-    nexthop_update_list_.clear();
     return true;
 }
 
@@ -417,13 +458,15 @@ void PathResolver::ManagedDelete() {
 // Return true if it's safe to delete the PathResolver.
 //
 bool PathResolver::MayDelete() const {
-    if (!nexthop_map_.empty())
-        return false;
     if (!nexthop_delete_list_.empty())
         return false;
-    if (!nexthop_reg_unreg_list_.empty())
-        return false;
-    assert(nexthop_update_list_.empty());
+    BOOST_FOREACH(const ResolverNexthopShard *shard, nexthop_shards_) {
+        if (!shard->nexthop_map.empty())
+            return false;
+        if (!shard->reg_unreg_list.empty())
+            return false;
+        assert(shard->update_list.empty());
+    }
     return true;
 }
 
@@ -449,8 +492,12 @@ bool PathResolver::RouteListener(DBTablePartBase *root, DBEntryBase *entry) {
 // For testing only.
 //
 size_t PathResolver::GetResolverNexthopMapSize() const {
-    tbb::mutex::scoped_lock lock(mutex_);
-    return nexthop_map_.size();
+    size_t total = 0;
+    BOOST_FOREACH(const ResolverNexthopShard *shard, nexthop_shards_) {
+        tbb::mutex::scoped_lock lock(shard->mutex);
+        total += shard->nexthop_map.size();
+    }
+    return total;
 }
 
 //
@@ -458,7 +505,6 @@ size_t PathResolver::GetResolverNexthopMapSize() const {
 // For testing only.
 //
 size_t PathResolver::GetResolverNexthopDeleteListSize() const {
-    tbb::mutex::scoped_lock lock(mutex_);
     return nexthop_delete_list_.size();
 }
 
@@ -483,8 +529,12 @@ void PathResolver::EnableResolverNexthopRegUnregProcessing() {
 // For testing only.
 //
 size_t PathResolver::GetResolverNexthopRegUnregListSize() const {
-    tbb::mutex::scoped_lock lock(mutex_);
-    return nexthop_reg_unreg_list_.size();
+    size_t total = 0;
+    BOOST_FOREACH(const ResolverNexthopShard *shard, nexthop_shards_) {
+        tbb::mutex::scoped_lock lock(shard->mutex);
+        total += shard->reg_unreg_list.size();
+    }
+    return total;
 }
 
 //
@@ -508,8 +558,12 @@ void PathResolver::EnableResolverNexthopUpdateProcessing() {
 // For testing only.
 //
 size_t PathResolver::GetResolverNexthopUpdateListSize() const {
-    tbb::mutex::scoped_lock lock(mutex_);
-    return nexthop_update_list_.size();
+    size_t total = 0;
+    BOOST_FOREACH(const ResolverNexthopShard *shard, nexthop_shards_) {
+        tbb::mutex::scoped_lock lock(shard->mutex);
+        total += shard->update_list.size();
+    }
+    return total;
 }
 
 //
@@ -576,7 +630,7 @@ void PathResolver::FillShowInfo(ShowPathResolver *spr, bool summary) const {
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
         const PathResolverPartition *partition = partitions_[part_id];
         path_count += partition->rpath_map_.size();
-        modified_path_count += partition->rpath_update_list_.size();
+        modified_path_count += partition->GetResolverPathUpdateListSize();
         if (summary)
             continue;
         for (PathResolverPartition::PathToResolverPathMap::const_iterator it =
@@ -592,28 +646,31 @@ void PathResolver::FillShowInfo(ShowPathResolver *spr, bool summary) const {
     }
     spr->set_path_count(path_count);
     spr->set_modified_path_count(modified_path_count);
-    spr->set_nexthop_count(nexthop_map_.size());
-    spr->set_modified_nexthop_count(nexthop_reg_unreg_list_.size() +
-        nexthop_delete_list_.size() + nexthop_update_list_.size());
+    spr->set_nexthop_count(GetResolverNexthopMapSize());
+    spr->set_modified_nexthop_count(GetResolverNexthopRegUnregListSize() +
+        nexthop_delete_list_.size() + GetResolverNexthopUpdateListSize());
 
     if (summary)
         return;
 
     vector<ShowPathResolverNexthop> sprn_list;
-    for (ResolverNexthopMap::const_iterator it = nexthop_map_.begin();
-         it != nexthop_map_.end(); ++it) {
-        const ResolverNexthop *rnexthop = it->second;
-        const BgpTable *table = rnexthop->table();
-        ShowPathResolverNexthop sprn;
-        sprn.set_address(rnexthop->address().to_string());
-        sprn.set_table(table->name());
-        const BgpRoute *route = rnexthop->GetRoute();
-        if (route) {
-            ShowRouteBrief show_route;
-            route->FillRouteInfo(table, &show_route);
-            sprn.set_nexthop_route(show_route);
+    BOOST_FOREACH(const ResolverNexthopShard *shard, nexthop_shards_) {
+        for (ResolverNexthopMap::const_iterator it =
+             shard->nexthop_map.begin(); it != shard->nexthop_map.end();
+             ++it) {
+            const ResolverNexthop *rnexthop = it->second;
+            const BgpTable *table = rnexthop->table();
+            ShowPathResolverNexthop sprn;
+            sprn.set_address(rnexthop->address().to_string());
+            sprn.set_table(table->name());
+            const BgpRoute *route = rnexthop->GetRoute();
+            if (route) {
+                ShowRouteBrief show_route;
+                route->FillRouteInfo(table, &show_route);
+                sprn.set_nexthop_route(show_route);
+            }
+            sprn_list.push_back(sprn);
         }
-        sprn_list.push_back(sprn);
     }
 
     spr->set_paths(sprp_list);
@@ -643,6 +700,7 @@ PathResolverPartition::PathResolverPartition(int part_id,
 //
 PathResolverPartition::~PathResolverPartition() {
     assert(rpath_update_list_.empty());
+    assert(rnexthop_update_list_.empty());
     rpath_update_trigger_->Reset();
 }
 
@@ -708,6 +766,19 @@ void PathResolverPartition::DeferPathResolution(ResolverPath *rpath) {
     rpath_update_trigger_->Set();
 }
 
+//
+// Add a ResolverNexthop to the nexthop update list and start Task to process
+// the update list. The ResolverPaths in this partition that depend on the
+// ResolverNexthop get added to the update list when the Task runs.
+//
+void PathResolverPartition::TriggerNexthopResolution(
+    ResolverNexthop *rnexthop) {
+    CHECK_CONCURRENCY("bgp::ResolverNexthop");
+
+    rnexthop_update_list_.insert(rnexthop);
+    rpath_update_trigger_->Set();
+}
+
 //
 // Get the BgpTable partition corresponding to this PathResolverPartition.
 //
@@ -752,12 +823,32 @@ ResolverPath *PathResolverPartition::RemoveResolverPath(const BgpPath *path) {
     }
 }
 
+//
+// Remove the ResolverNexthop from the nexthop update list.
+// Called when the ResolverNexthop is removed from the PathResolver.
+//
+void PathResolverPartition::RemoveResolverNexthop(ResolverNexthop *rnexthop) {
+    CHECK_CONCURRENCY("bgp::Config");
+
+    rnexthop_update_list_.erase(rnexthop);
+}
+
 //
 // Handle processing of all ResolverPaths on the update list.
 //
+// The ResolverPaths of this partition that depend on ResolverNexthops on
+// the nexthop update list are added to the update list first.
+//
 bool PathResolverPartition::ProcessResolverPathUpdateList() {
     CHECK_CONCURRENCY("bgp::ResolverPath");
 
+    for (ResolverNexthopList::iterator it = rnexthop_update_list_.begin();
+         it != rnexthop_update_list_.end(); ++it) {
+        const ResolverPathList &rpath_list = (*it)->rpath_lists_[part_id_];
+        rpath_update_list_.insert(rpath_list.begin(), rpath_list.end());
+    }
+    rnexthop_update_list_.clear();
+
     ResolverPathList update_list;
     rpath_update_list_.swap(update_list);
     for (ResolverPathList::iterator it = update_list.begin();
@@ -807,7 +898,14 @@ void PathResolverPartition::ResumeResolverPathUpdateProcessing() {
 // For testing only.
 //
 size_t PathResolverPartition::GetResolverPathUpdateListSize() const {
-    return rpath_update_list_.size();
+    ResolverPathList update_list(rpath_update_list_);
+    for (ResolverNexthopList::const_iterator it =
+         rnexthop_update_list_.begin(); it != rnexthop_update_list_.end();
+         ++it) {
+        const ResolverPathList &rpath_list = (*it)->rpath_lists_[part_id_];
+        update_list.insert(rpath_list.begin(), rpath_list.end());
+    }
+    return update_list.size();
 }
 
 //
@@ -1257,18 +1355,18 @@ ResolverRouteState *ResolverNexthop::GetResolverRouteState() {
 
 //
 // Trigger update of resolved BgpPaths for all ResolverPaths that depend on
-// the ResolverNexthop. Actual update of the resolved BgpPaths happens when
-// the PathResolverPartitions process their update lists.
+// the ResolverNexthop. The ResolverNexthop is handed to each partition with
+// dependent ResolverPaths, which adds them to its update list in the context
+// of its own bgp::ResolverPath Task. Actual update of the resolved BgpPaths
+// happens when the PathResolverPartitions process their update lists.
 //
-void ResolverNexthop::TriggerAllResolverPaths() const {
+void ResolverNexthop::TriggerAllResolverPaths() {
     CHECK_CONCURRENCY("bgp::ResolverNexthop");
 
     for (int part_id = 0; part_id < DB::PartitionCount(); ++part_id) {
-        for (ResolverPathList::iterator it = rpath_lists_[part_id].begin();
-             it != rpath_lists_[part_id].end(); ++it) {
-            ResolverPath *rpath = *it;
-            resolver_->GetPartition(part_id)->TriggerPathResolution(rpath);
-        }
+        if (rpath_lists_[part_id].empty())
+            continue;
+        resolver_->GetPartition(part_id)->TriggerNexthopResolution(this);
     }
 }
 
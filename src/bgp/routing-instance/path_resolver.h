@@ -6,10 +6,10 @@
 #define SRC_BGP_ROUTING_INSTANCE_PATH_RESOLVER_H_
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include <tbb/mutex.h>
 #include <tbb/spin_rw_mutex.h>
 
-#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -54,10 +54,12 @@ class TaskTrigger;
 // The nexthop map keeps track of all ResolverNexthop for this instance. In
 // addition, a given ResolverNexthop may be on the register/unregister list
 // and the update list. Entries are added to the map and the lists from the
-// db::DBTable Task. A mutex is used to serialize updates to the map and the
-// lists. Note that there's no no concurrent access when entries are removed
-// from the map and the lists, since the remove operations happen from Tasks
-// that are mutually exclusive.
+// db::DBTable Task. The map and the lists are sharded by a hash of the IP
+// address, one shard per DB partition. Each shard has a mutex to serialize
+// updates to its map and lists, so that db::DBTable Tasks for different
+// partitions do not contend on a single mutex. Note that there's no no
+// concurrent access when entries are removed from the map and the lists,
+// since the remove operations happen from Tasks that are mutually exclusive.
 //
 // The register/unregister list is processed in the context of bgp::Config
 // Task. ResolverNexthops are added to this list when we need to add/remove
@@ -73,8 +75,11 @@ class TaskTrigger;
 // after the list is processed again.
 //
 // The update list is processed in the context of bgp::ResolverNexthop Task.
-// When an entry on this list is processed all it's dependent ResolverPaths
-// are queued for re-evaluation in the PathResolverPartition.
+// When an entry on this list is processed it is handed to each of the
+// PathResolverPartitions with dependent ResolverPaths. Each partition then
+// queues its own dependent ResolverPaths for re-evaluation in the context
+// of its bgp::ResolverPath Task, so the cost of a change to a nexthop with
+// many dependents is spread across the partitions.
 //
 // Concurrency Notes:
 //
@@ -124,11 +129,24 @@ private:
 
     class DeleteActor;
     typedef std::pair<IpAddress, BgpTable *> ResolverNexthopKey;
-    typedef std::map<ResolverNexthopKey, ResolverNexthop *> ResolverNexthopMap;
+    struct ResolverNexthopKeyHash {
+        size_t operator()(const ResolverNexthopKey &key) const;
+    };
+    typedef boost::unordered_map<ResolverNexthopKey, ResolverNexthop *,
+        ResolverNexthopKeyHash> ResolverNexthopMap;
     typedef std::set<ResolverNexthop *> ResolverNexthopList;
 
+    // ResolverNexthops with the same IP address hash.
+    struct ResolverNexthopShard {
+        mutable tbb::mutex mutex;
+        ResolverNexthopMap nexthop_map;
+        ResolverNexthopList reg_unreg_list;
+        ResolverNexthopList update_list;
+    };
+
     PathResolverPartition *GetPartition(int part_id);
     PathResolverPartition *GetPartition(int part_id) const;
+    ResolverNexthopShard *GetNexthopShard(const IpAddress &address) const;
 
     ResolverNexthop *LocateResolverNexthop(IpAddress address, BgpTable *table);
     void RemoveResolverNexthop(ResolverNexthop *rnexthop);
@@ -162,11 +180,8 @@ private:
     BgpTable *table_;
     DBTableBase::ListenerId listener_id_;
     bool nexthop_longest_match_;
-    mutable tbb::mutex mutex_;
-    ResolverNexthopMap nexthop_map_;
-    ResolverNexthopList nexthop_reg_unreg_list_;
+    std::vector<ResolverNexthopShard *> nexthop_shards_;
     boost::scoped_ptr<TaskTrigger> nexthop_reg_unreg_trigger_;
-    ResolverNexthopList nexthop_update_list_;
     boost::scoped_ptr<TaskTrigger> nexthop_update_trigger_;
     ResolverNexthopList nexthop_delete_list_;
     std::vector<PathResolverPartition *> partitions_;
@@ -187,6 +202,11 @@ private:
 // ResolverPath class. The list is processed in context of bgp::ResolverPath
 // Task with the partition index as the Task instance id. This allows all the
 // PathResolverPartitions to work concurrently.
+//
+// The nexthop update list contains ResolverNexthops whose BgpRoute changed.
+// It's filled from the bgp::ResolverNexthop Task and is expanded into the
+// dependent ResolverPaths of the partition before the update list is
+// processed.
 
 // Mutual exclusion of db::DBTable and bgp::ResolverPath Tasks ensures that
 // it's safe to add/delete/update resolved BgpPaths from the bgp::ResolverPath
@@ -206,6 +226,7 @@ public:
 
     void TriggerPathResolution(ResolverPath *rpath);
     void DeferPathResolution(ResolverPath *rpath);
+    void TriggerNexthopResolution(ResolverNexthop *rnexthop);
 
     int part_id() const { return part_id_; }
     DBTableBase::ListenerId listener_id() const {
@@ -218,13 +239,16 @@ public:
 private:
     friend class PathResolver;
 
-    typedef std::map<const BgpPath *, ResolverPath *> PathToResolverPathMap;
+    typedef boost::unordered_map<const BgpPath *, ResolverPath *>
+        PathToResolverPathMap;
     typedef std::set<ResolverPath *> ResolverPathList;
+    typedef std::set<ResolverNexthop *> ResolverNexthopList;
 
     ResolverPath *CreateResolverPath(const BgpPath *path, BgpRoute *route,
         ResolverNexthop *rnexthop);
     ResolverPath *FindResolverPath(const BgpPath *path);
     ResolverPath *RemoveResolverPath(const BgpPath *path);
+    void RemoveResolverNexthop(ResolverNexthop *rnexthop);
     bool ProcessResolverPathUpdateList();
 
     void DisableResolverPathUpdateProcessing();
@@ -237,6 +261,7 @@ private:
     PathResolver *resolver_;
     PathToResolverPathMap rpath_map_;
     ResolverPathList rpath_update_list_;
+    ResolverNexthopList rnexthop_update_list_;
     boost::scoped_ptr<TaskTrigger> rpath_update_trigger_;
 
     DISALLOW_COPY_AND_ASSIGN(PathResolverPartition);
@@ -361,7 +386,9 @@ private:
 // the IP address being tracked, the ResolverNexthop is added to the update
 // list in the PathResolver. The PathResolver processes the entries in this
 // list in the context of the bgp::ResolverNexthop Task. The action is to
-// trigger re-evaluation of all ResolverPaths that use the ResolverNexthop.
+// add the ResolverNexthop to the nexthop update list of each partition with
+// ResolverPaths that use it. Each partition then triggers re-evaluation of
+// its ResolverPaths that use the ResolverNexthop.
 //
 // When the last ResolverPath in a partition using a ResolverNexthop gets
 // removed, the ResolverNexthop is added to the registration/unregistration
@@ -401,7 +428,7 @@ public:
     void RemoveResolverPath(int part_id, ResolverPath *rpath);
     ResolverRouteState *GetResolverRouteState();
 
-    void TriggerAllResolverPaths() const;
+    void TriggerAllResolverPaths();
 
     void ManagedDelete() { }
 
@@ -424,6 +451,8 @@ protected:
     ResolverRouteSet routes_;
 
 private:
+    friend class PathResolverPartition;
+
     typedef std::set<ResolverPath *> ResolverPathList;
 
     PathResolver *resolver_;
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_ROUTING_INSTANCE_PREFIX_INDEX_H_
+#define SRC_BGP_ROUTING_INSTANCE_PREFIX_INDEX_H_
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/util.h"
+#include "bgp/evpn/evpn_route.h"
+#include "bgp/inet/inet_route.h"
+#include "bgp/inet6/inet6_route.h"
+
+//
+// Bit string used as the key of a PrefixIndex node. Only the first length()
+// bits are significant, bits beyond that are never compared.
+//
+class PrefixIndexKey {
+public:
+    // Address family byte followed by an IPv6 address
+    static const int kMaxBits = 8 * (1 + 16);
+
+    PrefixIndexKey() : length_(0) {
+        memset(data_, 0, sizeof(data_));
+    }
+
+    // Append size bytes of which the first bits are significant. The key
+    // must be byte aligned.
+    void Append(const uint8_t *bytes, size_t size, int bits) {
+        assert(length_ % 8 == 0);
+        assert(bits >= 0 && static_cast<size_t>(bits) <= size * 8);
+        assert(length_ + size * 8 <= static_cast<size_t>(kMaxBits));
+        memcpy(data_ + length_ / 8, bytes, size);
+        length_ += bits;
+    }
+
+    void Truncate(int length) {
+        assert(length <= length_);
+        length_ = length;
+    }
+
+    int length() const { return length_; }
+    int bit(int index) const {
+        return (data_[index / 8] >> (7 - index % 8)) & 1;
+    }
+
+    // Number of leading bits shared with rhs, at most max.
+    int CommonLength(const PrefixIndexKey &rhs, int max) const {
+        int index = 0;
+        while (index + 8 <= max && data_[index / 8] == rhs.data_[index / 8])
+            index += 8;
+        while (index < max && bit(index) == rhs.bit(index))
+            index++;
+        return index;
+    }
+
+private:
+    uint8_t data_[kMaxBits / 8];
+    int length_;
+};
+
+//
+// Maps a prefix to its PrefixIndexKey. Returns false for prefixes that can
+// not be covered by another prefix.
+//
+template <typename PrefixT>
+struct PrefixIndexTraits;
+
+template <>
+struct PrefixIndexTraits<Ip4Prefix> {
+    static bool GetKey(const Ip4Prefix &prefix, PrefixIndexKey *key) {
+        Ip4Address::bytes_type bytes = prefix.addr().to_bytes();
+        key->Append(bytes.data(), bytes.size(), prefix.prefixlen());
+        return true;
+    }
+};
+
+template <>
+struct PrefixIndexTraits<Inet6Prefix> {
+    static bool GetKey(const Inet6Prefix &prefix, PrefixIndexKey *key) {
+        Ip6Address::bytes_type bytes = prefix.addr().to_bytes();
+        key->Append(bytes.data(), bytes.size(), prefix.prefixlen());
+        return true;
+    }
+};
+
+// Only EVPN ip prefix routes are indexed. The address family comes first so
+// that IPv4 and IPv6 prefixes never cover each other.
+template <>
+struct PrefixIndexTraits<EvpnPrefix> {
+    static bool GetKey(const EvpnPrefix &prefix, PrefixIndexKey *key) {
+        if (prefix.type() != EvpnPrefix::IpPrefixRoute)
+            return false;
+        uint8_t family = prefix.family();
+        key->Append(&family, 1, 8);
+        if (prefix.family() == Address::INET) {
+            Ip4Address::bytes_type bytes = prefix.ip4_addr().to_bytes();
+            key->Append(bytes.data(), bytes.size(), prefix.prefixlen());
+        } else {
+            Ip6Address::bytes_type bytes = prefix.ip6_addr().to_bytes();
+            key->Append(bytes.data(), bytes.size(), prefix.prefixlen());
+        }
+        return true;
+    }
+};
+
+//
+// PrefixIndex
+// ===========
+//
+// Path compressed binary (Patricia) trie of prefixes. It finds the prefixes
+// covering a given prefix in O(prefix length), independent of the number of
+// prefixes in the index. Used by RouteAggregator and ServiceChain to find
+// the aggregate prefixes covering a route.
+//
+// Each node holds the bits shared by all prefixes below it. Nodes added only
+// to branch, when two prefixes differ at a bit, do not hold an entry.
+//
+// Not thread safe, the owner serializes updates with respect to lookups.
+//
+template <typename PrefixT, typename ValueT>
+class PrefixIndex {
+public:
+    typedef std::pair<PrefixT, ValueT> Entry;
+    typedef std::vector<const Entry *> EntryList;
+
+    PrefixIndex() : root_(NULL), count_(0) {
+    }
+    ~PrefixIndex() {
+        Clear();
+    }
+
+    // Returns false if the prefix is already present or can not be indexed.
+    bool Insert(const PrefixT &prefix, const ValueT &value) {
+        PrefixIndexKey key;
+        if (!PrefixIndexTraits<PrefixT>::GetKey(prefix, &key))
+            return false;
+
+        Node **link = &root_;
+        while (*link) {
+            Node *node = *link;
+            int length = std::min(node->key.length(), key.length());
+            int common = node->key.CommonLength(key, length);
+            if (common < node->key.length()) {
+                // Branch off above node
+                Node *parent;
+                if (common == key.length()) {
+                    parent = new Node(key, Entry(prefix, value));
+                } else {
+                    PrefixIndexKey branch = key;
+                    branch.Truncate(common);
+                    parent = new Node(branch);
+                    parent->child[key.bit(common)] =
+                        new Node(key, Entry(prefix, value));
+                }
+                parent->child[node->key.bit(common)] = node;
+                *link = parent;
+                count_++;
+                return true;
+            }
+            if (common == key.length()) {
+                if (node->valid)
+                    return false;
+                node->entry = Entry(prefix, value);
+                node->valid = true;
+                count_++;
+                return true;
+            }
+            link = &node->child[key.bit(common)];
+        }
+        *link = new Node(key, Entry(prefix, value));
+        count_++;
+        return true;
+    }
+
+    // Returns false if the prefix is not present.
+    bool Remove(const PrefixT &prefix) {
+        PrefixIndexKey key;
+        if (!PrefixIndexTraits<PrefixT>::GetKey(prefix, &key))
+            return false;
+
+        Node **parent_link = NULL;
+        Node **link = &root_;
+        while (*link) {
+            Node *node = *link;
+            if (node->key.length() > key.length() ||
+                node->key.CommonLength(key, node->key.length()) <
+                node->key.length())
+                return false;
+            if (node->key.length() == key.length())
+                break;
+            parent_link = link;
+            link = &node->child[key.bit(node->key.length())];
+        }
+        Node *node = *link;
+        if (!node || !node->valid)
+            return false;
+
+        node->entry = Entry();
+        node->valid = false;
+        count_--;
+        if (node->child[0] && node->child[1])
+            return true;
+        *link = node->child[0] ? node->child[0] : node->child[1];
+        delete node;
+
+        // A branch node left with a single child is not needed anymore.
+        if (!parent_link)
+            return true;
+        Node *parent = *parent_link;
+        if (parent->valid || (parent->child[0] && parent->child[1]))
+            return true;
+        *parent_link = parent->child[0] ? parent->child[0] : parent->child[1];
+        delete parent;
+        return true;
+    }
+
+    // Entries covering the prefix, including an exact match, shortest first.
+    void FindMatches(const PrefixT &prefix, EntryList *matches) const {
+        Lookup(prefix, matches, false);
+    }
+
+    const Entry *FindShortestMatch(const PrefixT &prefix) const {
+        return Lookup(prefix, NULL, true);
+    }
+
+    const Entry *FindLongestMatch(const PrefixT &prefix) const {
+        return Lookup(prefix, NULL, false);
+    }
+
+    void Clear() {
+        Delete(root_);
+        root_ = NULL;
+        count_ = 0;
+    }
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+private:
+    struct Node {
+        explicit Node(const PrefixIndexKey &key)
+            : key(key), valid(false) {
+            child[0] = child[1] = NULL;
+        }
+        Node(const PrefixIndexKey &key, const Entry &entry)
+            : key(key), entry(entry), valid(true) {
+            child[0] = child[1] = NULL;
+        }
+
+        PrefixIndexKey key;
+        Entry entry;
+        bool valid;
+        Node *child[2];
+    };
+
+    // Walk down the nodes covering the prefix and return the last entry,
+    // or the first one if shortest is set.
+    const Entry *Lookup(const PrefixT &prefix, EntryList *matches,
+                        bool shortest) const {
+        PrefixIndexKey key;
+        if (!PrefixIndexTraits<PrefixT>::GetKey(prefix, &key))
+            return NULL;
+
+        const Entry *match = NULL;
+        for (const Node *node = root_; node; ) {
+            if (node->key.length() > key.length() ||
+                node->key.CommonLength(key, node->key.length()) <
+                node->key.length())
+                break;
+            if (node->valid) {
+                match = &node->entry;
+                if (matches)
+                    matches->push_back(match);
+                if (shortest)
+                    break;
+            }
+            if (node->key.length() == key.length())
+                break;
+            node = node->child[key.bit(node->key.length())];
+        }
+        return match;
+    }
+
+    static void Delete(Node *node) {
+        if (!node)
+            return;
+        Delete(node->child[0]);
+        Delete(node->child[1]);
+        delete node;
+    }
+
+    Node *root_;
+    size_t count_;
+
+    DISALLOW_COPY_AND_ASSIGN(PrefixIndex);
+};
+
+#endif  // SRC_BGP_ROUTING_INSTANCE_PREFIX_INDEX_H_
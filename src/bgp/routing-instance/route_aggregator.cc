@@ -312,23 +312,22 @@ template <typename T>
 bool AggregateRoute<T>::IsBestMatch(BgpRoute *route) const {
     const RouteT *ip_route = static_cast<RouteT *>(route);
     const PrefixT &ip_prefix = ip_route->GetPrefix();
-    typename RouteAggregator<T>::AggregateRouteMap::const_iterator it;
-    std::set<PrefixT> prefix_list;
-    for (it = manager_->aggregate_route_map().begin();
-         it != manager_->aggregate_route_map().end(); ++it) {
-        if (!it->second->deleted() && ip_prefix != it->first &&
-            ip_prefix.IsMoreSpecific(it->first)) {
-            prefix_list.insert(it->first);
-        }
-    }
-    // It should match atleast one prefix
-    assert(prefix_list.size());
+    typedef typename RouteAggregator<T>::AggregateRouteIndex IndexT;
+    typename IndexT::EntryList matches;
+    manager_->aggregate_route_index().FindMatches(ip_prefix, &matches);
     //
     // Longest prefix matches the aggregate prefix of current AggregateRoute
     // return true to make this route as contributing route
-    // Longest prefix is the last prefix in the set
+    // Longest prefix is the last match
     //
-    if (*(prefix_list.rbegin()) == aggregate_route_prefix_) return true;
+    for (typename IndexT::EntryList::const_reverse_iterator it =
+         matches.rbegin(); it != matches.rend(); ++it) {
+        if ((*it)->second->deleted() || (*it)->first == ip_prefix)
+            continue;
+        return ((*it)->first == aggregate_route_prefix_);
+    }
+    // It should match atleast one prefix
+    assert(false);
     return false;
 }
 
@@ -817,12 +816,32 @@ void RouteAggregator<T>::LocateAggregateRoutePrefix(const AggregateRouteConfig
         new AggregateRouteT(routing_instance(), this, prefix, cfg.nexthop);
     AggregateRoutePtr aggregate_route_match = AggregateRoutePtr(match);
     aggregate_route_map_.insert(make_pair(prefix, aggregate_route_match));
+    aggregate_route_index_.Insert(prefix, match);
 
     condition_listener_->AddMatchCondition(match->bgp_table(),
-           aggregate_route_match.get(), BgpConditionListener::RequestDoneCb());
+           aggregate_route_match.get(), BgpConditionListener::RequestDoneCb(),
+           this);
     return;
 }
 
+//
+// Aggregate routes covering the route, found with a longest prefix walk of
+// the index. All the covering ones are returned, shortest first, so that a
+// less specific aggregate releases the route before a more specific one
+// tries to add it.
+//
+template <typename T>
+void RouteAggregator<T>::FindMatches(BgpRoute *route,
+                             ConditionMatchIndex::MatchList *matches) const {
+    const RouteT *ip_route = static_cast<RouteT *>(route);
+    typename AggregateRouteIndex::EntryList entries;
+    aggregate_route_index_.FindMatches(ip_route->GetPrefix(), &entries);
+    for (typename AggregateRouteIndex::EntryList::const_iterator it =
+         entries.begin(); it != entries.end(); ++it) {
+        matches->push_back((*it)->second);
+    }
+}
+
 template <typename T>
 void RouteAggregator<T>::RemoveAggregateRoutePrefix(const PrefixT &aggregate) {
     CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
@@ -856,6 +875,7 @@ bool RouteAggregator<T>::ProcessUnregisterList() {
          it != unregister_aggregate_list_.end(); ++it) {
         AggregateRouteT *aggregate = static_cast<AggregateRouteT *>(it->get());
         aggregate_route_map_.erase(aggregate->aggregate_route_prefix());
+        aggregate_route_index_.Remove(aggregate->aggregate_route_prefix());
         condition_listener_->UnregisterMatchCondition(aggregate->bgp_table(),
                                                       aggregate);
     }
@@ -11,6 +11,7 @@
 #include <set>
 
 #include "bgp/routing-instance/iroute_aggregator.h"
+#include "bgp/routing-instance/prefix_index.h"
 
 #include "bgp/bgp_condition_listener.h"
 #include "bgp/bgp_config.h"
@@ -57,7 +58,9 @@ typedef ConditionMatchPtr AggregateRoutePtr;
 // aggregate route
 //
 // RouteAggregator uses AddMatchCondition method of BgpConditionListener when
-// new route-aggregate prefix is created on routing instance.
+// new route-aggregate prefix is created on routing instance. It passes itself
+// as the ConditionMatchIndex, so a route is matched only against the aggregate
+// prefixes in aggregate_route_index_ that cover it.
 //
 // AggregateRoute
 // ================
@@ -158,7 +161,7 @@ typedef ConditionMatchPtr AggregateRoutePtr;
 // in per partition list to allow concurrent access
 //
 template <typename T>
-class RouteAggregator : public IRouteAggregator {
+class RouteAggregator : public IRouteAggregator, public ConditionMatchIndex {
 public:
     typedef typename T::RouteT RouteT;
     typedef typename T::PrefixT PrefixT;
@@ -168,6 +171,9 @@ public:
     // Map of AggregateRoute prefix to the AggregateRoute match object
     typedef std::map<PrefixT, AggregateRoutePtr> AggregateRouteMap;
 
+    // Index of the AggregateRoute prefixes to find the ones covering a route
+    typedef PrefixIndex<PrefixT, AggregateRouteT *> AggregateRouteIndex;
+
     explicit RouteAggregator(RoutingInstance *instance);
     ~RouteAggregator();
 
@@ -184,6 +190,13 @@ public:
     const AggregateRouteMap &aggregate_route_map() const {
         return aggregate_route_map_;
     }
+    const AggregateRouteIndex &aggregate_route_index() const {
+        return aggregate_route_index_;
+    }
+
+    // ConditionMatchIndex
+    virtual void FindMatches(BgpRoute *route,
+                             ConditionMatchIndex::MatchList *matches) const;
 
     Address::Family GetFamily() const;
     AddressT GetAddress(IpAddress addr) const;
@@ -241,6 +254,7 @@ private:
     BgpConditionListener *condition_listener_;
     DBTableBase::ListenerId listener_id_;
     AggregateRouteMap  aggregate_route_map_;
+    AggregateRouteIndex aggregate_route_index_;
     boost::scoped_ptr<TaskTrigger> update_list_trigger_;
     boost::scoped_ptr<TaskTrigger> unregister_list_trigger_;
     tbb::mutex mutex_;
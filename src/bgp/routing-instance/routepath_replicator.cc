@@ -367,6 +367,63 @@ void RoutePathReplicator::Leave(BgpTable *table, const RouteTarget &rt,
     }
 }
 
+//
+// Track an import target of a routing instance whose table for the family
+// has not been created yet.
+// Paths with the target in the VPN table are notified again if there are any,
+// so that the table gets created if needed.
+//
+void RoutePathReplicator::JoinDeferred(RoutingInstance *rtinstance,
+    Address::Family family, const RouteTarget &rt) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (DeferredImportMap::iterator it = deferred_imports_.lower_bound(rt);
+         it != deferred_imports_.end() && it->first == rt; ++it) {
+        if (it->second.first == rtinstance)
+            return;
+    }
+    deferred_imports_.insert(make_pair(rt, make_pair(rtinstance, family)));
+
+    RtGroup *group = server()->rtarget_group_mgr()->GetRtGroup(rt);
+    if (group && group->HasDepRoutes())
+        server()->rtarget_group_mgr()->NotifyRtGroup(rt);
+}
+
+//
+// Stop tracking an import target of a routing instance. Called when the table
+// is created or the target is removed from the routing instance.
+//
+void RoutePathReplicator::LeaveDeferred(RoutingInstance *rtinstance,
+    const RouteTarget &rt) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (DeferredImportMap::iterator it = deferred_imports_.lower_bound(rt);
+         it != deferred_imports_.end() && it->first == rt; ++it) {
+        if (it->second.first == rtinstance) {
+            deferred_imports_.erase(it);
+            return;
+        }
+    }
+}
+
+//
+// Request creation of the tables of the routing instances that import the
+// given target.
+// The map is only modified from the bgp::Config and bgp::ConfigHelper tasks,
+// which don't run in parallel with the db::DBTable task.
+//
+void RoutePathReplicator::RequestDeferredTables(const RouteTarget &rt) {
+    for (DeferredImportMap::const_iterator it =
+         deferred_imports_.lower_bound(rt);
+         it != deferred_imports_.end() && it->first == rt; ++it) {
+        RoutingInstance *rtinstance = it->second.first;
+        rtinstance->manager()->RequestTable(rtinstance->name(),
+                                            it->second.second);
+    }
+}
+
 void RoutePathReplicator::DBStateSync(BgpTable *table, TableState *ts,
     BgpRoute *rt, RtReplicated *dbstate,
     const RtReplicated::ReplicatedRtPathList *future) {
@@ -549,6 +606,8 @@ bool RoutePathReplicator::RouteListener(TableState *ts,
                 OriginVn origin_vn(comm);
                 vn_index = origin_vn.vn_index();
             } else if (ExtCommunity::is_route_target(comm)) {
+                if (!deferred_imports_.empty() && table->IsVpnTable())
+                    RequestDeferredTables(RouteTarget(comm));
                 RtGroup *group =
                     server()->rtarget_group_mgr()->GetRtGroup(comm);
                 if (!group)
@@ -13,11 +13,13 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/lifetime.h"
 #include "base/util.h"
 #include "bgp/bgp_path.h"
+#include "bgp/rtarget/rtarget_address.h"
 #include "db/db_entry.h"
 #include "db/db_table.h"
 
@@ -26,7 +28,7 @@ class BgpServer;
 class BgpTable;
 class RtGroup;
 class RoutePathReplicator;
-class RouteTarget;
+class RoutingInstance;
 
 //
 // This keeps track of a RoutePathReplicator's listener state for a BgpTable.
@@ -232,6 +234,13 @@ private:
 // TableState. Requests are enqueued from the db::DBTable task when a table
 // walk finishes and the TableState is empty.
 //
+// The DeferredImportMap keeps track of the import targets of routing instances
+// whose table for the family has not been created yet, when tables are created
+// lazily. A path in the VPN table with one of these targets requests creation
+// of the table from the RoutingInstanceMgr. The routing instance then joins
+// the targets as usual and the path gets replicated when the RtGroup is
+// notified.
+//
 // A mutex is used to serialize access from multiple bgp::ConfigHelper tasks.
 //
 class RoutePathReplicator {
@@ -242,6 +251,10 @@ public:
     void Initialize();
     void Join(BgpTable *table, const RouteTarget &rt, bool import);
     void Leave(BgpTable *table, const RouteTarget &rt, bool import);
+    void JoinDeferred(RoutingInstance *rtinstance, Address::Family family,
+                      const RouteTarget &rt);
+    void LeaveDeferred(RoutingInstance *rtinstance, const RouteTarget &rt);
+    size_t deferred_import_count() const { return deferred_imports_.size(); }
 
     std::vector<std::string> GetReplicatedTableNameList(const BgpTable *table,
         const BgpRoute *route, const BgpPath *path) const;
@@ -255,6 +268,8 @@ private:
 
     typedef std::map<BgpTable *, TableState *> TableStateList;
     typedef std::set<BgpTable *> UnregTableList;
+    typedef std::pair<RoutingInstance *, Address::Family> DeferredTable;
+    typedef std::multimap<RouteTarget, DeferredTable> DeferredImportMap;
 
     void RequestWalk(BgpTable *table);
     void BulkReplicationDone(DBTableBase *dbtable);
@@ -269,6 +284,7 @@ private:
 
     void JoinVpnTable(RtGroup *group);
     void LeaveVpnTable(RtGroup *group);
+    void RequestDeferredTables(const RouteTarget &rt);
 
     bool RouteListener(TableState *ts, DBTablePartBase *root,
                        DBEntryBase *entry);
@@ -285,6 +301,7 @@ private:
     BgpServer *server_;
     tbb::mutex mutex_;
     TableStateList table_state_list_;
+    DeferredImportMap deferred_imports_;
     Address::Family family_;
     BgpTable *vpn_table_;
     SandeshTraceBufferPtr trace_buf_;
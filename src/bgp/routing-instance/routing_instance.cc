@@ -13,13 +13,17 @@
 #include "base/set_util.h"
 #include "base/task_annotations.h"
 #include "base/task_trigger.h"
+#include "base/timer.h"
+#include "bgp/bgp_condition_listener.h"
 #include "bgp/bgp_config.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_log.h"
+#include "bgp/bgp_membership.h"
 #include "bgp/bgp_mvpn.h"
 #include "bgp/bgp_server.h"
 #include "bgp/mvpn/mvpn_table.h"
 #include "bgp/routing-instance/iroute_aggregator.h"
+#include "bgp/routing-instance/iservice_chain_mgr.h"
 #include "bgp/routing-instance/istatic_route_mgr.h"
 #include "bgp/routing-instance/peer_manager.h"
 #include "bgp/routing-instance/routepath_replicator.h"
@@ -76,6 +80,10 @@ RoutingInstanceMgr::RoutingInstanceMgr(BgpServer *server) :
                 GetEnvRoutingInstanceDormantTraceBufferCapacity()),
         trace_buf_threshold_(
                 GetEnvRoutingInstanceDormantTraceBufferThreshold()),
+        lazy_table_timer_(TimerManager::CreateTimer(*server->ioservice(),
+            "Lazy table sweep timer",
+            TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0)),
+        lazy_table_sweep_interval_(kLazyTableSweepInterval),
         deleter_(new DeleteActor(this)),
         server_delete_ref_(this, server->deleter()) {
     int task_id = TaskScheduler::GetInstance()->GetTaskId("bgp::ConfigHelper");
@@ -88,6 +96,9 @@ RoutingInstanceMgr::RoutingInstanceMgr(BgpServer *server) :
     neighbor_config_trigger_.reset(new TaskTrigger(
         boost::bind(&RoutingInstanceMgr::ProcessNeighborConfigList, this),
         TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0));
+    table_request_trigger_.reset(new TaskTrigger(
+        boost::bind(&RoutingInstanceMgr::ProcessTableRequestList, this),
+        TaskScheduler::GetInstance()->GetTaskId("bgp::Config"), 0));
 }
 
 RoutingInstanceMgr::~RoutingInstanceMgr() {
@@ -97,6 +108,7 @@ RoutingInstanceMgr::~RoutingInstanceMgr() {
     server_->UnregisterASNUpdateCallback(asn_listener_id_);
     server_->UnregisterIdentifierUpdateCallback(identifier_listener_id_);
     STLDeleteValues(&instance_config_triggers_);
+    TimerManager::DeleteTimer(lazy_table_timer_);
 }
 
 size_t RoutingInstanceMgr::GetMvpnProjectManagerCount(
@@ -119,11 +131,14 @@ void RoutingInstanceMgr::Shutdown() {
         InstanceTargetRemove(it->second);
         InstanceVnIndexRemove(it->second);
     }
+    lazy_table_timer_->Cancel();
 }
 
 bool RoutingInstanceMgr::MayDelete() const {
     if (!neighbor_config_list_.empty())
         return false;
+    if (!table_request_list_.empty())
+        return false;
     for (size_t idx = 0; idx < instance_config_lists_.size(); ++idx) {
         if (!instance_config_lists_[idx].empty())
             return false;
@@ -600,7 +615,8 @@ RoutingInstance *RoutingInstanceMgr::CreateRoutingInstance(
     // Create MvpnManager for all children mvpn networks.
     MvpnTable *mvpn_table =
         dynamic_cast<MvpnTable *>(rtinstance->GetTable(Address::MVPN));
-    mvpn_table->CreateMvpnManagers();
+    if (mvpn_table)
+        mvpn_table->CreateMvpnManagers();
     return rtinstance;
 }
 
@@ -903,6 +919,68 @@ bool RoutingInstanceMgr::ProcessNeighborConfigList() {
     return true;
 }
 
+//
+// Request creation of a lazy table of the routing instance.
+//
+// Can be called from any task that needs the table. The request is processed
+// from bgp::Config, which is exclusive with db::DBTable.
+//
+void RoutingInstanceMgr::RequestTable(const string &name,
+    Address::Family family) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    table_request_list_.insert(make_pair(name, family));
+    table_request_trigger_->Set();
+}
+
+bool RoutingInstanceMgr::ProcessTableRequestList() {
+    TableRequestList table_request_list;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        table_request_list.swap(table_request_list_);
+    }
+
+    if (deleted()) {
+        deleter()->RetryDelete();
+        return true;
+    }
+
+    for (TableRequestList::const_iterator it = table_request_list.begin();
+         it != table_request_list.end(); ++it) {
+        RoutingInstance *rtinstance = GetRoutingInstance(it->first);
+        if (!rtinstance || rtinstance->deleted())
+            continue;
+        rtinstance->LocateTable(it->second);
+    }
+    return true;
+}
+
+void RoutingInstanceMgr::StartLazyTableSweep() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (lazy_table_timer_->running())
+        return;
+    lazy_table_timer_->Start(lazy_table_sweep_interval_,
+        boost::bind(&RoutingInstanceMgr::LazyTableSweepTimerExpired, this));
+}
+
+//
+// Delete lazy tables that have been idle for a while.
+// Returns true to restart the timer as long as there are lazy tables.
+//
+bool RoutingInstanceMgr::LazyTableSweepTimerExpired() {
+    if (deleted())
+        return false;
+
+    bool restart = false;
+    for (RoutingInstanceIterator it = begin(); it != end(); ++it) {
+        RoutingInstance *rtinstance = it->second;
+        if (rtinstance->deleted())
+            continue;
+        if (rtinstance->SweepLazyTables())
+            restart = true;
+    }
+    return restart;
+}
+
 void RoutingInstanceMgr::ASNUpdateCallback(as_t old_asn, as_t old_local_asn) {
     if (server_->local_autonomous_system() == old_local_asn)
         return;
@@ -962,6 +1040,22 @@ void RoutingInstanceMgr::EnableNeighborConfigListProcessing() {
     neighbor_config_trigger_->set_enable();
 }
 
+//
+// Disable processing of table request list.
+// For testing only.
+//
+void RoutingInstanceMgr::DisableTableRequestListProcessing() {
+    table_request_trigger_->set_disable();
+}
+
+//
+// Enable processing of table request list.
+// For testing only.
+//
+void RoutingInstanceMgr::EnableTableRequestListProcessing() {
+    table_request_trigger_->set_enable();
+}
+
 class RoutingInstance::DeleteActor : public LifetimeActor {
 public:
     DeleteActor(BgpServer *server, RoutingInstance *parent)
@@ -1011,6 +1105,8 @@ void RoutingInstance::CreateNeighbors() {
 
     if (config_->neighbor_list().empty())
         return;
+    if (IsLazyFamily(Address::INET6) && !LocateTable(Address::INET6))
+        return;
     PeerManager *peer_manager = LocatePeerManager();
     BOOST_FOREACH(const string &name, config_->neighbor_list()) {
         if (peer_manager->PeerLookup(name))
@@ -1271,19 +1367,30 @@ void RoutingInstance::ProcessConfig() {
         BgpTable *inet_table = VrfTableCreate(Address::INET, Address::INETVPN);
         inet_table->LocatePathResolver();
 
-        BgpTable *inet6_table =
-            VrfTableCreate(Address::INET6, Address::INET6VPN);
-        inet6_table->LocatePathResolver();
+        // INET6 and MVPN tables may be created on first use instead.
+        if (!IsLazyFamily(Address::INET6)) {
+            BgpTable *inet6_table =
+                VrfTableCreate(Address::INET6, Address::INET6VPN);
+            inet6_table->LocatePathResolver();
+        } else if (IsTableRequiredByConfig(Address::INET6)) {
+            LazyTableCreate(Address::INET6);
+        } else {
+            LazyTableDefer(Address::INET6);
+        }
 
         VrfTableCreate(Address::ERMVPN, Address::ERMVPN);
 
         BgpTable *evpn_table = VrfTableCreate(Address::EVPN, Address::EVPN);
         evpn_table->LocatePathResolver();
 
-        BgpTable *table = VrfTableCreate(Address::MVPN, Address::MVPN);
+        if (!IsLazyFamily(Address::MVPN)) {
+            BgpTable *table = VrfTableCreate(Address::MVPN, Address::MVPN);
 
-        // Create path-resolver in mvpn table.
-        table->LocatePathResolver();
+            // Create path-resolver in mvpn table.
+            table->LocatePathResolver();
+        } else {
+            LazyTableDefer(Address::MVPN);
+        }
     }
 
     ProcessServiceChainConfig();
@@ -1475,8 +1582,12 @@ int RoutingInstance::vxlan_id() const {
 void RoutingInstance::ClearFamilyRouteTarget(Address::Family vrf_family,
                                              Address::Family vpn_family) {
     BgpTable *table = GetTable(vrf_family);
-    if (table) {
-        RoutePathReplicator *replicator = server_->replicator(vpn_family);
+    RoutePathReplicator *replicator = server_->replicator(vpn_family);
+    if (!table) {
+        BOOST_FOREACH(RouteTarget rt, import_) {
+            replicator->LeaveDeferred(this, rt);
+        }
+    } else if (!table->IsDeleted()) {
         BOOST_FOREACH(RouteTarget rt, import_) {
             replicator->Leave(table, rt, true);
         }
@@ -1582,24 +1693,42 @@ void RoutingInstance::ProcessIdentifierUpdate(as_t asn) {
     rd_.reset(new RouteDistinguisher(server_->bgp_identifier(), index_));
 }
 
+//
+// Join the table of the given family to the RouteTarget.
+// An import target of a lazy table that hasn't been created is tracked by the
+// replicator so that the table gets created when a route with the target is
+// seen.
+//
+void RoutingInstance::JoinFamilyRouteTarget(Address::Family vrf_family,
+    Address::Family vpn_family, const RouteTarget &rt, bool import) {
+    BgpTable *table = GetTable(vrf_family);
+    RoutePathReplicator *replicator = server_->replicator(vpn_family);
+    if (!table) {
+        if (import)
+            replicator->JoinDeferred(this, vrf_family, rt);
+        return;
+    }
+    if (table->IsDeleted())
+        return;
+    replicator->Join(table, rt, import);
+}
+
+void RoutingInstance::LeaveFamilyRouteTarget(Address::Family vrf_family,
+    Address::Family vpn_family, const RouteTarget &rt, bool import) {
+    BgpTable *table = GetTable(vrf_family);
+    RoutePathReplicator *replicator = server_->replicator(vpn_family);
+    if (!table) {
+        if (import)
+            replicator->LeaveDeferred(this, rt);
+        return;
+    }
+    if (table->IsDeleted())
+        return;
+    replicator->Leave(table, rt, import);
+}
+
 void RoutingInstance::AddRouteTarget(bool import,
     vector<string> *change_list, RouteTargetList::const_iterator it) {
-    BgpTable *ermvpn_table = GetTable(Address::ERMVPN);
-    RoutePathReplicator *ermvpn_replicator =
-        server_->replicator(Address::ERMVPN);
-    BgpTable *mvpn_table = GetTable(Address::MVPN);
-    RoutePathReplicator *mvpn_replicator =
-        server_->replicator(Address::MVPN);
-    BgpTable *evpn_table = GetTable(Address::EVPN);
-    RoutePathReplicator *evpn_replicator =
-        server_->replicator(Address::EVPN);
-    BgpTable *inet_table = GetTable(Address::INET);
-    RoutePathReplicator *inetvpn_replicator =
-        server_->replicator(Address::INETVPN);
-    BgpTable *inet6_table = GetTable(Address::INET6);
-    RoutePathReplicator *inet6vpn_replicator =
-        server_->replicator(Address::INET6VPN);
-
     change_list->push_back(it->ToString());
     if (import) {
         import_.insert(*it);
@@ -1609,36 +1738,20 @@ void RoutingInstance::AddRouteTarget(bool import,
         export_.insert(*it);
     }
 
-    ermvpn_replicator->Join(ermvpn_table, *it, import);
-    mvpn_replicator->Join(mvpn_table, *it, import);
-    evpn_replicator->Join(evpn_table, *it, import);
-    inetvpn_replicator->Join(inet_table, *it, import);
-    inet6vpn_replicator->Join(inet6_table, *it, import);
+    JoinFamilyRouteTarget(Address::ERMVPN, Address::ERMVPN, *it, import);
+    JoinFamilyRouteTarget(Address::MVPN, Address::MVPN, *it, import);
+    JoinFamilyRouteTarget(Address::EVPN, Address::EVPN, *it, import);
+    JoinFamilyRouteTarget(Address::INET, Address::INETVPN, *it, import);
+    JoinFamilyRouteTarget(Address::INET6, Address::INET6VPN, *it, import);
 }
 
 void RoutingInstance::DeleteRouteTarget(bool import,
     vector<string> *change_list, RouteTargetList::iterator it) {
-    BgpTable *ermvpn_table = GetTable(Address::ERMVPN);
-    RoutePathReplicator *ermvpn_replicator =
-        server_->replicator(Address::ERMVPN);
-    BgpTable *mvpn_table = GetTable(Address::MVPN);
-    RoutePathReplicator *mvpn_replicator =
-        server_->replicator(Address::MVPN);
-    BgpTable *evpn_table = GetTable(Address::EVPN);
-    RoutePathReplicator *evpn_replicator =
-        server_->replicator(Address::EVPN);
-    BgpTable *inet_table = GetTable(Address::INET);
-    RoutePathReplicator *inetvpn_replicator =
-        server_->replicator(Address::INETVPN);
-    BgpTable *inet6_table = GetTable(Address::INET6);
-    RoutePathReplicator *inet6vpn_replicator =
-        server_->replicator(Address::INET6VPN);
-
-    ermvpn_replicator->Leave(ermvpn_table, *it, import);
-    mvpn_replicator->Leave(mvpn_table, *it, import);
-    evpn_replicator->Leave(evpn_table, *it, import);
-    inetvpn_replicator->Leave(inet_table, *it, import);
-    inet6vpn_replicator->Leave(inet6_table, *it, import);
+    LeaveFamilyRouteTarget(Address::ERMVPN, Address::ERMVPN, *it, import);
+    LeaveFamilyRouteTarget(Address::MVPN, Address::MVPN, *it, import);
+    LeaveFamilyRouteTarget(Address::EVPN, Address::EVPN, *it, import);
+    LeaveFamilyRouteTarget(Address::INET, Address::INETVPN, *it, import);
+    LeaveFamilyRouteTarget(Address::INET6, Address::INET6VPN, *it, import);
 
     change_list->push_back(it->ToString());
     if (import) {
@@ -1709,6 +1822,166 @@ BgpTable *RoutingInstance::VrfTableCreate(Address::Family vrf_family,
     return table;
 }
 
+//
+// Return true if the table for the family is created on first use rather than
+// along with the routing instance.
+//
+// The INET, EVPN and ERMVPN tables of a VRF are always created, since they
+// are assumed to exist by the agent subscriptions, the EVPN manager and the
+// service chains. The MVPN table is needed upfront if MVPN is enabled.
+//
+bool RoutingInstance::IsLazyFamily(Address::Family fmly) const {
+    if (is_master_ || !server_ || !server_->lazy_vrf_tables())
+        return false;
+    if (fmly == Address::INET6)
+        return true;
+    if (fmly == Address::MVPN)
+        return !server_->mvpn_ipv4_enable();
+    return false;
+}
+
+Address::Family RoutingInstance::VpnFamily(Address::Family vrf_family) {
+    if (vrf_family == Address::INET)
+        return Address::INETVPN;
+    if (vrf_family == Address::INET6)
+        return Address::INET6VPN;
+    return vrf_family;
+}
+
+//
+// Return true if the configuration of the routing instance refers to the
+// table for the family.
+//
+bool RoutingInstance::IsTableRequiredByConfig(
+    Address::Family vrf_family) const {
+    if (!config_ || vrf_family != Address::INET6)
+        return false;
+    if (!config_->static_routes(vrf_family).empty())
+        return true;
+    if (!config_->aggregate_routes(vrf_family).empty())
+        return true;
+    const ServiceChainConfig *sc_config =
+        config_->service_chain_info(SCAddress::INET6);
+    if (sc_config && !sc_config->routing_instance.empty())
+        return true;
+    sc_config = config_->service_chain_info(SCAddress::EVPN6);
+    if (sc_config && !sc_config->routing_instance.empty())
+        return true;
+    return !config_->neighbor_list().empty();
+}
+
+//
+// Track the import targets of a lazy table that doesn't exist, so that it
+// gets created when a VPN route with one of the targets shows up.
+//
+void RoutingInstance::LazyTableDefer(Address::Family vrf_family) {
+    RoutePathReplicator *replicator =
+        server_->replicator(VpnFamily(vrf_family));
+    BOOST_FOREACH(RouteTarget rt, import_) {
+        replicator->JoinDeferred(this, vrf_family, rt);
+    }
+}
+
+BgpTable *RoutingInstance::LazyTableCreate(Address::Family vrf_family) {
+    Address::Family vpn_family = VpnFamily(vrf_family);
+    RoutePathReplicator *replicator = server_->replicator(vpn_family);
+    BOOST_FOREACH(RouteTarget rt, import_) {
+        replicator->LeaveDeferred(this, rt);
+    }
+
+    BgpTable *table = VrfTableCreate(vrf_family, vpn_family);
+    table->LocatePathResolver();
+    lazy_tables_[vrf_family] = 0;
+    mgr_->StartLazyTableSweep();
+    return table;
+}
+
+//
+// Return the table for the family, creating it if it's a lazy table.
+//
+// Returns NULL if the table can't be used right now, which is the case if
+// the table is being deleted. The table is created again when the delete is
+// complete and the instance manager notifies INSTANCE_TABLE_ADD.
+//
+BgpTable *RoutingInstance::LocateTable(Address::Family fmly) {
+    CHECK_CONCURRENCY("bgp::Config", "bgp::ConfigHelper");
+
+    BgpTable *table = GetTable(fmly);
+    if (table) {
+        if (table->IsDeleted()) {
+            if (!deleted() && IsLazyFamily(fmly))
+                pending_tables_.insert(fmly);
+            return NULL;
+        }
+        LazyTableList::iterator loc = lazy_tables_.find(fmly);
+        if (loc != lazy_tables_.end())
+            loc->second = 0;
+        return table;
+    }
+
+    if (deleted() || !IsLazyFamily(fmly))
+        return NULL;
+    table = LazyTableCreate(fmly);
+    mgr_->NotifyInstanceOp(name_, RoutingInstanceMgr::INSTANCE_TABLE_ADD);
+    return table;
+}
+
+//
+// Return true if nothing refers to the lazy table.
+//
+bool RoutingInstance::IsLazyTableIdle(BgpTable *table) {
+    if (!table->empty())
+        return false;
+    if (server_->membership_mgr()->HasRegisteredPeers(table))
+        return false;
+
+    Address::Family family = table->family();
+    if (family == Address::INET6) {
+        if (static_route_mgr(family) || route_aggregator(family))
+            return false;
+        if (peer_manager_size() != 0)
+            return false;
+        if (IsTableRequiredByConfig(family))
+            return false;
+    }
+
+    for (int idx = SCAddress::INET; idx < SCAddress::NUM_FAMILIES; ++idx) {
+        SCAddress::Family sc_family = static_cast<SCAddress::Family>(idx);
+        if (server_->condition_listener(sc_family)->HasMatchConditions(table))
+            return false;
+    }
+    return true;
+}
+
+//
+// Delete lazy tables found idle by two consecutive sweeps.
+// Returns true if there are lazy tables left.
+//
+bool RoutingInstance::SweepLazyTables() {
+    CHECK_CONCURRENCY("bgp::Config");
+
+    for (LazyTableList::iterator it = lazy_tables_.begin(), next = it;
+         it != lazy_tables_.end(); it = next) {
+        ++next;
+        BgpTable *table = GetTable(it->first);
+        if (!table || table->IsDeleted()) {
+            lazy_tables_.erase(it);
+            continue;
+        }
+        if (!IsLazyTableIdle(table)) {
+            it->second = 0;
+            continue;
+        }
+        if (++it->second < 2)
+            continue;
+
+        ClearFamilyRouteTarget(it->first, VpnFamily(it->first));
+        table->ManagedDelete();
+        lazy_tables_.erase(it);
+    }
+    return !lazy_tables_.empty();
+}
+
 void RoutingInstance::AddTable(BgpTable *tbl) {
     vrf_tables_by_name_.insert(make_pair(tbl->name(), tbl));
     vrf_tables_by_family_.insert(make_pair(tbl->family(), tbl));
@@ -1746,7 +2019,24 @@ void RoutingInstance::DestroyDBTable(DBTable *dbtable) {
     // Make sure that there are no routes left in this table
     assert(table->Size() == 0);
 
+    Address::Family family = table->family();
     delete table;
+
+    // Lazy table deleted when idle, create it again if it was requested in
+    // the meantime.
+    if (deleted() || !IsLazyFamily(family))
+        return;
+    if (pending_tables_.erase(family) == 0) {
+        LazyTableDefer(family);
+        return;
+    }
+    LazyTableCreate(family);
+    mgr_->NotifyInstanceOp(name_, RoutingInstanceMgr::INSTANCE_TABLE_ADD);
+    if (config_) {
+        UpdateStaticRouteConfig();
+        UpdateRouteAggregationConfig();
+        mgr_->CreateRoutingInstanceNeighbors(config_);
+    }
 }
 
 string RoutingInstance::GetTableName(string instance_name,
@@ -1938,6 +2228,8 @@ IStaticRouteMgr *RoutingInstance::LocateStaticRouteMgr(
     IStaticRouteMgr *manager = static_route_mgr(family);
     if (manager)
         return manager;
+    if (IsLazyFamily(family) && !LocateTable(family))
+        return NULL;
     if (family == Address::INET) {
         inet_static_route_mgr_.reset(
             BgpObjectFactory::Create<IStaticRouteMgr, Address::INET>(this));
@@ -1955,6 +2247,8 @@ IRouteAggregator *RoutingInstance::LocateRouteAggregator(
     IRouteAggregator *aggregator = route_aggregator(family);
     if (aggregator)
         return aggregator;
+    if (IsLazyFamily(family) && !LocateTable(family))
+        return NULL;
     if (family == Address::INET) {
         GetTable(family)->LocatePathResolver();
         inet_route_aggregator_.reset(
@@ -18,6 +18,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/bitset.h"
@@ -50,6 +51,7 @@ class LifetimeActor;
 class PeerManager;
 class ShowRouteTable;
 class TaskTrigger;
+class Timer;
 
 class RoutingInstance {
 public:
@@ -87,6 +89,8 @@ public:
 
     BgpTable *GetTable(Address::Family fmly);
     const BgpTable *GetTable(Address::Family fmly) const;
+    BgpTable *LocateTable(Address::Family fmly);
+    bool IsLazyFamily(Address::Family fmly) const;
 
     void AddTable(BgpTable *tbl);
 
@@ -224,6 +228,17 @@ private:
                              Address::Family vpn_family);
     void ClearFamilyRouteTarget(Address::Family vrf_family,
                                 Address::Family vpn_family);
+    void JoinFamilyRouteTarget(Address::Family vrf_family,
+        Address::Family vpn_family, const RouteTarget &rt, bool import);
+    void LeaveFamilyRouteTarget(Address::Family vrf_family,
+        Address::Family vpn_family, const RouteTarget &rt, bool import);
+
+    static Address::Family VpnFamily(Address::Family vrf_family);
+    bool IsTableRequiredByConfig(Address::Family vrf_family) const;
+    void LazyTableDefer(Address::Family vrf_family);
+    BgpTable *LazyTableCreate(Address::Family vrf_family);
+    bool IsLazyTableIdle(BgpTable *table);
+    bool SweepLazyTables();
 
     std::string name_;
     int index_;
@@ -252,6 +267,15 @@ private:
     boost::scoped_ptr<PeerManager> peer_manager_;
     std::string mvpn_project_manager_network_;
     RoutingPolicyAttachList routing_policies_;
+
+    // Tables created on first use, with the number of consecutive sweeps
+    // that found them idle.
+    typedef std::map<Address::Family, int> LazyTableList;
+    LazyTableList lazy_tables_;
+
+    // Lazily created tables requested while being deleted when idle. They
+    // are created again once the deletion completes.
+    std::set<Address::Family> pending_tables_;
 };
 
 
@@ -278,6 +302,15 @@ class RoutingInstanceSet : public BitSet {
 // a mutex is used to serialize access to shared data structures such as the
 // instances_ map, target_map_ and vn_index_map_.
 //
+// When lazy_vrf_tables is enabled on the BgpServer, the tables of some address
+// families are only created on first use: a subscribe or route from an agent,
+// a VPN route with an import target of the instance or config that needs the
+// table. Requests can come from the db::DBTable and xmpp::StateMachine tasks,
+// so they are added to the table_request_list_ and processed from bgp::Config
+// task. Clients are notified with INSTANCE_TABLE_ADD when a table is created.
+// Tables that are found idle by consecutive runs of the lazy_table_timer_ are
+// deleted again.
+//
 class RoutingInstanceMgr {
 public:
     typedef std::set<std::string> RoutingInstanceConfigList;
@@ -300,9 +333,12 @@ public:
     enum Operation {
         INSTANCE_ADD = 1,
         INSTANCE_UPDATE = 2,
-        INSTANCE_DELETE = 3
+        INSTANCE_DELETE = 3,
+        INSTANCE_TABLE_ADD = 4
     };
 
+    static const int kLazyTableSweepInterval = 60000;  // milliseconds
+
     explicit RoutingInstanceMgr(BgpServer *server);
     virtual ~RoutingInstanceMgr();
 
@@ -373,6 +409,8 @@ public:
     void Shutdown();
 
     void CreateRoutingInstanceNeighbors(const BgpInstanceConfig *config);
+    void RequestTable(const std::string &name, Address::Family family);
+    void StartLazyTableSweep();
 
     size_t count() const { return instances_.size(); }
     BgpServer *server() { return server_; }
@@ -403,8 +441,13 @@ private:
     friend class RoutingInstanceMgrTest;
     class DeleteActor;
 
+    typedef std::set<std::pair<std::string, Address::Family> >
+        TableRequestList;
+
     bool ProcessInstanceConfigList(int idx);
     bool ProcessNeighborConfigList();
+    bool ProcessTableRequestList();
+    bool LazyTableSweepTimerExpired();
 
     void InstanceTargetAdd(RoutingInstance *rti);
     void InstanceTargetRemove(const RoutingInstance *rti);
@@ -421,6 +464,8 @@ private:
     void EnableInstanceConfigListProcessing();
     void DisableNeighborConfigListProcessing();
     void EnableNeighborConfigListProcessing();
+    void DisableTableRequestListProcessing();
+    void EnableTableRequestListProcessing();
     void SetTableStatsUve(Address::Family family,
              const std::map<std::string, RoutingTableStats> &stats_map,
              RoutingInstanceStatsData *instance_info) const;
@@ -432,6 +477,8 @@ private:
     std::vector<TaskTrigger *> instance_config_triggers_;
     RoutingInstanceConfigList neighbor_config_list_;
     boost::scoped_ptr<TaskTrigger> neighbor_config_trigger_;
+    TableRequestList table_request_list_;
+    boost::scoped_ptr<TaskTrigger> table_request_trigger_;
     RoutingInstance *default_rtinstance_;
     RoutingInstanceList instances_;
     RoutingInstanceTraceBufferMap trace_buffer_active_;
@@ -444,6 +491,8 @@ private:
     int identifier_listener_id_;
     size_t dormant_trace_buf_size_;
     size_t trace_buf_threshold_;
+    Timer *lazy_table_timer_;
+    int lazy_table_sweep_interval_;
     boost::scoped_ptr<DeleteActor> deleter_;
     LifetimeRef<RoutingInstanceMgr> server_delete_ref_;
     boost::dynamic_bitset<> bmap_;      // free list.
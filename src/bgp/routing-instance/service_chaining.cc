@@ -306,7 +306,8 @@ ServiceChain<T>::ServiceChain(ServiceChainMgrT *manager,
         PrefixT ipam_subnet = PrefixT::FromString(prefix, &ec);
         if (ec != 0)
             continue;
-        prefix_to_routelist_map_[ipam_subnet] = RouteList();
+        RouteList *route_list = &prefix_to_routelist_map_[ipam_subnet];
+        prefix_to_routelist_index_.Insert(ipam_subnet, route_list);
     }
 }
 
@@ -538,27 +539,21 @@ bool ServiceChain<T>::IsMoreSpecific(BgpRoute *route,
     PrefixT *aggregate_match) const {
     const RouteT *ip_route = static_cast<RouteT *>(route);
     const PrefixT &ip_prefix = ip_route->GetPrefix();
-    for (typename PrefixToRouteListMap::const_iterator it =
-         prefix_to_route_list_map()->begin();
-         it != prefix_to_route_list_map()->end(); ++it) {
-        if (ip_prefix.IsMoreSpecific(it->first)) {
-            *aggregate_match = it->first;
-            return true;
-        }
-    }
-    return false;
+
+    // Shortest covering prefix, the first one in prefix order
+    const typename PrefixToRouteListIndex::Entry *match =
+        prefix_to_routelist_index_.FindShortestMatch(ip_prefix);
+    if (!match)
+        return false;
+    *aggregate_match = match->first;
+    return true;
 }
 
 template <typename T>
 bool ServiceChain<T>::IsAggregate(BgpRoute *route) const {
     RouteT *ip_route = dynamic_cast<RouteT *>(route);
-    for (typename PrefixToRouteListMap::const_iterator it =
-         prefix_to_route_list_map()->begin();
-         it != prefix_to_route_list_map()->end(); ++it) {
-        if (it->first == ip_route->GetPrefix())
-            return true;
-    }
-    return false;
+    return (prefix_to_route_list_map()->find(ip_route->GetPrefix()) !=
+            prefix_to_route_list_map()->end());
 }
 
 /**
@@ -1789,9 +1784,31 @@ bool ServiceChainMgr<T>::LocateServiceChain(RoutingInstance *rtinstance,
      */
     BgpTable *connected_table = NULL;
     connected_table = connected_ri->GetTable(GetConnectedFamily());
-    assert(connected_table);
     BgpTable *dest_table = dest->GetTable(GetFamily());
-    assert(dest_table);
+
+    // Tables may not exist yet if they are created on first use. Request
+    // them and resolve the service chain when they get created.
+    if (!connected_table || connected_table->IsDeleted()) {
+        mgr->RequestTable(connected_ri->name(), GetConnectedFamily());
+        string reason = "Connected table does not exist";
+        AddPendingServiceChain(rtinstance, group, reason);
+        return false;
+    }
+    if (!dest_table || dest_table->IsDeleted()) {
+        mgr->RequestTable(dest->name(), GetFamily());
+        string reason = "Destination table does not exist";
+        AddPendingServiceChain(rtinstance, group, reason);
+        return false;
+    }
+    Address::Family src_family = (GetSCFamily() == SCAddress::EVPN6) ?
+        Address::INET6 : GetFamily();
+    BgpTable *src_table = rtinstance->GetTable(src_family);
+    if (!src_table || src_table->IsDeleted()) {
+        mgr->RequestTable(rtinstance->name(), src_family);
+        string reason = "Source table does not exist";
+        AddPendingServiceChain(rtinstance, group, reason);
+        return false;
+    }
 
     // Allocate the new service chain.
     ServiceChainPtr chain = ServiceChainPtr(new ServiceChainT(this, group,
@@ -22,6 +22,7 @@
 #include "bgp/inet6/inet6_route.h"
 #include "bgp/evpn/evpn_route.h"
 #include "bgp/routing-instance/iservice_chain_mgr.h"
+#include "bgp/routing-instance/prefix_index.h"
 
 class BgpRoute;
 class BgpTable;
@@ -135,6 +136,9 @@ public:
     // Map of Virtual Network subnet prefix to List of More Specific routes
     typedef std::map<PrefixT, RouteList> PrefixToRouteListMap;
 
+    // Index of the subnet prefixes to find the ones covering a route
+    typedef PrefixIndex<PrefixT, RouteList *> PrefixToRouteListIndex;
+
     // Map of External Connecting route to Service Chain Route
     typedef std::set<BgpRoute *> ExtConnectRouteList;
 
@@ -235,6 +239,7 @@ private:
     BgpRoute *connected_route_;
     AddressT service_chain_addr_;
     PrefixToRouteListMap prefix_to_routelist_map_;
+    PrefixToRouteListIndex prefix_to_routelist_index_;
     ExtConnectRouteList ext_connect_routes_;
     bool group_oper_state_up_;
     bool connected_table_unregistered_;
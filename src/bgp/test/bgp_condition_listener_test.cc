@@ -135,6 +135,32 @@ private:
     bool hold_db_state_;
 };
 
+//
+// Index that returns the match object only for routes more specific than
+// its prefix.
+//
+template <typename PrefixT, typename RouteT>
+class TestConditionMatchIndex : public ConditionMatchIndex {
+public:
+    TestConditionMatchIndex() : match_(NULL) {
+    }
+
+    void set_match(ConditionMatch *match, const PrefixT &prefix) {
+        match_ = match;
+        prefix_ = prefix;
+    }
+
+    virtual void FindMatches(BgpRoute *route, MatchList *matches) const {
+        RouteT *ip_route = static_cast<RouteT *>(route);
+        if (ip_route->GetPrefix().IsMoreSpecific(prefix_))
+            matches->push_back(match_);
+    }
+
+private:
+    ConditionMatch *match_;
+    PrefixT prefix_;
+};
+
 //
 // Template structure to pass to fixture class template. Needed because
 // gtest fixture class template can accept only one template parameter.
@@ -145,6 +171,7 @@ struct TypeDefinition {
   typedef T2 PrefixT;
   typedef T3 RouteT;
   typedef TestConditionMatch<PrefixT, RouteT> ConditionMatchT;
+  typedef TestConditionMatchIndex<PrefixT, RouteT> ConditionMatchIndexT;
 };
 
 // TypeDefinitions that we want to test.
@@ -161,6 +188,7 @@ protected:
     typedef typename T::PrefixT PrefixT;
     typedef typename T::RouteT RouteT;
     typedef typename T::ConditionMatchT ConditionMatchT;
+    typedef typename T::ConditionMatchIndexT ConditionMatchIndexT;
 
     BgpConditionListenerTest()
         : evm_(new EventManager()),
@@ -323,10 +351,11 @@ protected:
     }
 
     void AddMatchCondition(string name, string match,
-                           bool hold_db_state = false) {
+                           bool hold_db_state = false, bool indexed = false) {
         ConcurrencyScope scope("bgp::Config");
         PrefixT prefix = PrefixT::FromString(match);
         match_.reset(new ConditionMatchT(family_, prefix, hold_db_state));
+        index_.set_match(match_.get(), prefix);
         RoutingInstance *rti =
             bgp_server_->routing_instance_mgr()->GetRoutingInstance(name);
         BgpTable *table = rti->GetTable(family_);
@@ -334,7 +363,8 @@ protected:
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         scheduler->Stop();
         listener_->AddMatchCondition(table, match_.get(),
-                                     BgpConditionListener::RequestDoneCb());
+                                     BgpConditionListener::RequestDoneCb(),
+                                     indexed ? &index_ : NULL);
         scheduler->Start();
     }
 
@@ -410,6 +440,7 @@ protected:
     string ipv6_prefix_;
     BgpConditionListener *listener_;
     ConditionMatchPtr match_;
+    ConditionMatchIndexT index_;
 };
 
 // Specialization of GetFamily for INET.
@@ -602,6 +633,41 @@ TYPED_TEST(BgpConditionListenerTest, ChangeNotify) {
     task_util::WaitForIdle();
 }
 
+//
+// A condition added with an index sees only the routes the index returns it
+// for, although its Match would accept the 10.1.1.1 host route as well.
+//
+TYPED_TEST(BgpConditionListenerTest, Index) {
+    typedef typename TypeParam::ConditionMatchT ConditionMatchT;
+    typedef typename TypeParam::PrefixT PrefixT;
+
+    this->AddRoutingInstance("blue");
+    task_util::WaitForIdle();
+
+    this->AddRoute("blue", this->BuildHostAddress("192.168.1.2"));
+    this->AddRoute("blue", this->BuildHostAddress("10.1.1.1"));
+    this->AddMatchCondition("blue", this->BuildPrefix("192.168.1.0", 24),
+                            false, true);
+    task_util::WaitForIdle();
+
+    ConditionMatchT *match = static_cast<ConditionMatchT *>(this->match_.get());
+    TASK_UTIL_EXPECT_EQ(1, match->matched_routes_size());
+
+    this->AddRoute("blue", this->BuildHostAddress("192.168.1.3"));
+    this->AddRoute("blue", this->BuildHostAddress("10.1.1.2"));
+    TASK_UTIL_EXPECT_EQ(2, match->matched_routes_size());
+    EXPECT_TRUE(match->lookup_matched_routes(PrefixT::FromString(
+        this->BuildHostAddress("192.168.1.3"))) != NULL);
+
+    this->RemoveMatchCondition("blue");
+    TASK_UTIL_EXPECT_TRUE(match->matched_routes_empty());
+
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.1.2"));
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.1.3"));
+    this->DeleteRoute("blue", this->BuildHostAddress("10.1.1.1"));
+    this->DeleteRoute("blue", this->BuildHostAddress("10.1.1.2"));
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
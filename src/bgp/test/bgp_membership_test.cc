@@ -6,6 +6,7 @@
 #include <tbb/atomic.h>
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "control-node/control_node.h"
 #include "bgp/inet/inet_table.h"
 #include "bgp/bgp_config_ifmap.h"
@@ -1504,6 +1505,133 @@ TEST_F(BgpMembershipTest, WalkWithPendingWalkDeathTest) {
     task_util::WaitForIdle();
 }
 
+//
+// Verify that the per peer path index of the table tracks the paths added
+// and deleted by each peer.
+//
+TEST_F(BgpMembershipTest, PeerPathIndex) {
+    static const int kRouteCount = 8;
+
+    // Register peers.
+    Register(peers_[0], blue_tbl_);
+    Register(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+
+    // Add paths from peers, only half the routes for the second peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+        if (idx % 2 == 0)
+            AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.1.1");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(kRouteCount / 2,
+        blue_tbl_->GetPeerPathCount(peers_[1]));
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[2]));
+
+    // Update paths from first peer, the index should not change.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.2");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->GetPeerPathCount(peers_[0]));
+
+    // Walk only visits paths of the first peer.
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(0, peers_[1]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->GetPeerPathCount(peers_[0]));
+
+    // Delete paths from first peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount / 2, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(kRouteCount / 2,
+        blue_tbl_->GetPeerPathCount(peers_[1]));
+
+    // Delete paths from second peer.
+    for (int idx = 0; idx < kRouteCount; idx += 2) {
+        DeleteRoute(peers_[1], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[1]));
+
+    // Unregister peers.
+    Unregister(peers_[0], blue_tbl_);
+    Unregister(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+}
+
+//
+// Compare the time for a RibIn walk of a peer with few paths, as done for
+// the sweep after graceful restart, with the time for a walk of the entire
+// table.
+//
+TEST_F(BgpMembershipTest, WalkRibInScale) {
+    static const int kRouteCount = 32768;
+    static const int kPeerRouteCount = 64;
+
+    // Register peers.
+    Register(peers_[0], blue_tbl_);
+    Register(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+
+    // Add most paths from the second peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.1.1");
+    }
+    for (int idx = 0; idx < kPeerRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->Size());
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Walk the paths of the first peer.
+    uint64_t start = ClockMonotonicUsec();
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    uint64_t peer_walk_time = ClockMonotonicUsec() - start;
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kPeerRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(0, peers_[1]->path_cb_count());
+
+    // Register third peer, which needs a walk of the entire table.
+    start = ClockMonotonicUsec();
+    Register(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+    uint64_t table_walk_time = ClockMonotonicUsec() - start;
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 2, blue_tbl_->walk_complete_count());
+
+    std::cout << "RibIn walk of " << kPeerRouteCount << " paths in table with "
+        << kRouteCount << " routes : " << peer_walk_time << " usec"
+        << std::endl;
+    std::cout << "Walk of table with " << kRouteCount << " routes : "
+        << table_walk_time << " usec" << std::endl;
+
+    // Delete paths from peers.
+    for (int idx = 0; idx < kPeerRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[1], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+
+    // Unregister peers.
+    Unregister(peers_[0], blue_tbl_);
+    Unregister(peers_[1], blue_tbl_);
+    Unregister(peers_[2], blue_tbl_);
+    task_util::WaitForIdle();
+}
+
 static void SetUp() {
     bgp_log_test::init();
     BgpObjectFactory::Register<BgpPeer>(
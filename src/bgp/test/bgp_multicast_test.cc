@@ -21,8 +21,19 @@ public:
           address_str_(address_str),
           label_block_(new LabelBlock(1000, 1500 -1)) {
         boost::system::error_code ec;
-        BgpAttrSpec attr_spec;
         address_ = Ip4Address::from_string(address_str.c_str(), ec);
+        BuildAttr();
+    }
+    virtual ~XmppPeerMock() { }
+
+    // Switch to a new label block. Routes need to be re-added to pick it up.
+    void SetLabelBlock(uint32_t first, uint32_t last) {
+        label_block_.reset(new LabelBlock(first, last));
+        BuildAttr();
+    }
+
+    void BuildAttr() {
+        BgpAttrSpec attr_spec;
         BgpAttrNextHop nexthop(address_.to_ulong());
         attr_spec.push_back(&nexthop);
         BgpAttrLabelBlock label_block(label_block_);
@@ -33,7 +44,6 @@ public:
         attr_spec.push_back(&ext);
         attr = server_->attr_db()->Locate(attr_spec);
     }
-    virtual ~XmppPeerMock() { }
 
     void AddRoute(ErmVpnTable *table, string group_str, string source_str) {
         boost::system::error_code ec;
@@ -70,6 +80,7 @@ public:
         DelRoute(table, group_str, "0.0.0.0");
     }
 
+    const Ip4Address &address() const { return address_; }
     virtual const std::string &ToString() const { return address_str_; }
     virtual const std::string &ToUVEKey() const { return address_str_; }
     virtual BgpServer *server() { return server_; }
@@ -387,6 +398,131 @@ protected:
         return total;
     }
 
+    uint64_t GetTreeNotifyCount(McastTreeManager *tm) {
+        uint64_t total = 0;
+        for (int idx = 0; idx < ErmVpnTable::kPartitionCount; idx++) {
+            total += tm->partitions_[idx]->notify_count();
+        }
+        return total;
+    }
+
+    void VerifyTreeSorted(McastTreeManager *tm, string group_str) {
+        ConcurrencyScope scope("db::DBTable");
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source;
+
+        for (McastTreeManager::PartitionList::iterator it =
+             tm->partitions_.begin(); it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (!sg_entry)
+                continue;
+            McastSGEntry::ForwarderSet *forwarders =
+                sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+            TASK_UTIL_EXPECT_EQ(forwarders->size(),
+                                sg_entry->tree_nodes_.size());
+            size_t idx = 0;
+            for (McastSGEntry::ForwarderSet::iterator it =
+                 forwarders->begin(); it != forwarders->end(); ++it, ++idx) {
+                TASK_UTIL_EXPECT_EQ(*it, sg_entry->tree_nodes_[idx]);
+                TASK_UTIL_EXPECT_EQ(static_cast<int>(idx), (*it)->tree_index());
+            }
+            return;
+        }
+    }
+
+    McastSGEntry *FindSGEntry(McastTreeManager *tm, string group_str) {
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source;
+        for (McastTreeManager::PartitionList::iterator it =
+             tm->partitions_.begin(); it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (sg_entry)
+                return sg_entry;
+        }
+        return NULL;
+    }
+
+    // Verify that the olist of every McastForwarder in the tree has the
+    // current address and label of each of its tree links, and that the
+    // LocalTreeRoute advertises the label of the forest node.
+    void VerifyTreeOList(McastTreeManager *tm, string group_str) {
+        ConcurrencyScope scope("db::DBTable");
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        ASSERT_TRUE(sg_entry != NULL);
+
+        for (McastForwarderList::iterator it = sg_entry->tree_nodes_.begin();
+             it != sg_entry->tree_nodes_.end(); ++it) {
+            McastForwarder *forwarder = *it;
+            ASSERT_TRUE(forwarder != NULL);
+            boost::scoped_ptr<UpdateInfo> uinfo(
+                forwarder->GetUpdateInfo(tm->table_));
+            ASSERT_TRUE(uinfo.get() != NULL);
+            const BgpOList *olist = uinfo->roattr.attr()->olist().get();
+            ASSERT_TRUE(olist != NULL);
+            for (McastForwarderList::iterator link_it =
+                 forwarder->tree_links_.begin();
+                 link_it != forwarder->tree_links_.end(); ++link_it) {
+                McastForwarder *link = *link_it;
+                bool found = false;
+                for (BgpOList::Elements::const_iterator elem_it =
+                     olist->elements().begin();
+                     elem_it != olist->elements().end(); ++elem_it) {
+                    if ((*elem_it)->address == link->address() &&
+                        (*elem_it)->label == link->label()) {
+                        found = true;
+                        break;
+                    }
+                }
+                EXPECT_TRUE(found) << forwarder->ToString() <<
+                    " olist missing " << link->ToString();
+            }
+        }
+
+        McastForwarder *forest_node = sg_entry->forest_node_;
+        ASSERT_TRUE(forest_node != NULL);
+        ASSERT_TRUE(sg_entry->local_tree_route_ != NULL);
+        const BgpPath *path = sg_entry->local_tree_route_->BestPath();
+        ASSERT_TRUE(path != NULL);
+        const EdgeDiscovery *ediscovery = path->GetAttr()->edge_discovery();
+        ASSERT_TRUE(ediscovery != NULL);
+        for (EdgeDiscovery::EdgeList::const_iterator it =
+             ediscovery->edge_list.begin();
+             it != ediscovery->edge_list.end(); ++it) {
+            EXPECT_EQ(forest_node->address(), (*it)->address);
+            EXPECT_EQ(forest_node->label(), (*it)->label_block->first());
+        }
+    }
+
+    // Measure the number of native ErmVpnRoutes that get notified when a
+    // single McastForwarder leaves and then rejoins a group of kPeerCount.
+    void MeasureTreeNotifyCount(bool incremental,
+                                uint64_t *leave_count, uint64_t *join_count) {
+        red_tm_->set_incremental_tree(incremental);
+        red_tm_->set_tree_rebalance_threshold(0);
+
+        AddRouteAllPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+
+        uint64_t count = GetTreeNotifyCount(red_tm_);
+        peers_[kPeerCount / 2]->DelRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+        *leave_count = GetTreeNotifyCount(red_tm_) - count;
+
+        count = GetTreeNotifyCount(red_tm_);
+        peers_[kPeerCount / 2]->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+        *join_count = GetTreeNotifyCount(red_tm_) - count;
+
+        DelRouteAllPeers(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifySGCount(red_tm_, 0);
+    }
+
     EventManager evm_;
     BgpServer server_;
     ErmVpnTable *red_table_;
@@ -737,6 +873,149 @@ TEST_F(BgpMulticastTest, TreeUpdateCompression) {
     TASK_UTIL_EXPECT_EQ(6, VerifyTreeUpdateCount(red_tm_));
 }
 
+TEST_F(BgpMulticastTest, IncrementalTreeAddDel) {
+    red_tm_->set_incremental_tree(true);
+    red_tm_->set_tree_rebalance_threshold(0);
+
+    AddRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kEvenPeerCount + 2);
+    VerifySGCount(red_tm_, 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kEvenPeerCount);
+    VerifyRoute(red_table_, "192.168.1.255");
+
+    AddRouteOddPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount + 2);
+    VerifySGCount(red_tm_, 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+
+    DelRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kOddPeerCount + 2);
+    VerifySGCount(red_tm_, 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kOddPeerCount);
+
+    DelRouteOddPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", 0);
+}
+
+TEST_F(BgpMulticastTest, IncrementalTreeRebalance) {
+    red_tm_->set_incremental_tree(true);
+    red_tm_->set_tree_rebalance_threshold(kPeerCount);
+
+    // Join in reverse order, one at a time, so that the incremental tree is
+    // not sorted until it gets rebalanced.
+    for (int idx = kPeerCount - 1; idx >= 0; --idx) {
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+    }
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+
+    DelRouteOddPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kEvenPeerCount);
+    VerifyTreeSorted(red_tm_, "192.168.1.255");
+
+    DelRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+}
+
+TEST_F(BgpMulticastTest, IncrementalTreeSwitchMode) {
+    AddRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+
+    red_tm_->set_incremental_tree(true);
+    DelRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kOddPeerCount);
+
+    red_tm_->set_incremental_tree(false);
+    AddRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+    VerifyTreeSorted(red_tm_, "192.168.1.255");
+
+    DelRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+}
+
+// A label block change on the forest node releases its label. The olists and
+// the LocalTreeRoute must pick up the label from the new block.
+TEST_F(BgpMulticastTest, IncrementalTreeLabelBlockChange) {
+    red_tm_->set_incremental_tree(true);
+    red_tm_->set_tree_rebalance_threshold(0);
+
+    AddRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+    VerifyTreeOList(red_tm_, "192.168.1.255");
+
+    McastSGEntry *sg_entry = FindSGEntry(red_tm_, "192.168.1.255");
+    ASSERT_TRUE(sg_entry != NULL);
+    McastForwarder *forest_node = sg_entry->forest_node_;
+    ASSERT_TRUE(forest_node != NULL);
+    uint32_t old_label = forest_node->label();
+    XmppPeerMock *forest_peer = NULL;
+    for (vector<XmppPeerMock *>::iterator it = peers_.begin();
+         it != peers_.end(); ++it) {
+        if ((*it)->address() == forest_node->address())
+            forest_peer = *it;
+    }
+    ASSERT_TRUE(forest_peer != NULL);
+
+    forest_peer->SetLabelBlock(1200, 1300 - 1);
+    forest_peer->AddRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+    TASK_UTIL_EXPECT_TRUE(sg_entry->forest_node_ != NULL);
+    TASK_UTIL_EXPECT_NE(old_label, sg_entry->forest_node_->label());
+    VerifyTreeOList(red_tm_, "192.168.1.255");
+
+    // Membership changes after the label change keep the olists current.
+    DelRouteEvenPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kOddPeerCount);
+    VerifyTreeOList(red_tm_, "192.168.1.255");
+
+    DelRouteOddPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+}
+
+//
+// Benchmark the number of route updates triggered by a single membership
+// change with and without incremental tree updates.
+//
+TEST_F(BgpMulticastTest, TreeNotifyCountPerMembershipChange) {
+    uint64_t full_leave_count, full_join_count;
+    MeasureTreeNotifyCount(false, &full_leave_count, &full_join_count);
+    uint64_t incr_leave_count, incr_join_count;
+    MeasureTreeNotifyCount(true, &incr_leave_count, &incr_join_count);
+
+    cout << "Route updates per membership change with " << kPeerCount
+         << " forwarders:" << endl;
+    cout << "    Full rebuild: leave " << full_leave_count
+         << " join " << full_join_count << endl;
+    cout << "    Incremental:  leave " << incr_leave_count
+         << " join " << incr_join_count << endl;
+
+    uint64_t max_count = 2 * McastTreeManager::kDegree + 4;
+    EXPECT_LE(incr_leave_count, max_count);
+    EXPECT_LE(incr_join_count, max_count);
+    EXPECT_LT(incr_leave_count, full_leave_count);
+    EXPECT_LT(incr_join_count, full_join_count);
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ::testing::InitGoogleTest(&argc, argv);
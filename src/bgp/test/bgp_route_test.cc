@@ -5,6 +5,8 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/foreach.hpp>
 
+#include <algorithm>
+
 #include "base/test/task_test_util.h"
 #include "bgp/bgp_config.h"
 #include "bgp/bgp_log.h"
@@ -1628,6 +1630,163 @@ TEST_F(BgpRouteTest, GetSourceString) {
     }
 }
 
+static void ExpectSamePathOrder(const BgpRoute &route,
+                                const BgpRoute &reference) {
+    Route::PathList::const_iterator it = route.GetPathList().begin();
+    BOOST_FOREACH(const Path &path, reference.GetPathList()) {
+        ASSERT_TRUE(it != route.GetPathList().end());
+        EXPECT_EQ(static_cast<const BgpPath &>(path).GetPeer(),
+                  static_cast<const BgpPath &>(*it).GetPeer());
+        ++it;
+    }
+    EXPECT_TRUE(it == route.GetPathList().end());
+}
+
+// Paths inserted in sorted position, and kept in order on delete, are in the
+// same order as after a full sort.
+TEST_F(BgpRouteTest, InsertSorted) {
+    const int kPathCount = 1000;
+    std::vector<PeerMock *> peers;
+    std::vector<BgpAttrPtr> attrs;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        peers.push_back(new PeerMock(BgpProto::IBGP, Ip4Address(idx + 1)));
+        BgpAttrSpec spec;
+        BgpAttr *attr = new BgpAttr(server_.attr_db(), spec);
+        attr->set_local_pref(100 + idx % 4);
+        attr->set_med(idx % 8);
+        attrs.push_back(server_.attr_db()->Locate(attr));
+    }
+    std::vector<int> order;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        order.push_back(idx);
+    }
+    std::random_shuffle(order.begin(), order.end());
+
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+    InetRoute reference(prefix);
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        int i = order[idx];
+        route.InsertPath(new BgpPath(peers[i], BgpPath::BGP_XMPP, attrs[i],
+                                     0, 0));
+        reference.insert(new BgpPath(peers[i], BgpPath::BGP_XMPP, attrs[i],
+                                     0, 0));
+        reference.Sort(&BgpTable::PathSelection, reference.front());
+    }
+    ExpectSamePathOrder(route, reference);
+    EXPECT_EQ(103U, route.BestPath()->GetAttr()->local_pref());
+
+    std::random_shuffle(order.begin(), order.end());
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        int i = order[idx];
+        route.DeletePath(route.FindPath(BgpPath::BGP_XMPP, peers[i], 0));
+        BgpPath *path = reference.FindPath(BgpPath::BGP_XMPP, peers[i], 0);
+        reference.remove(path);
+        reference.Sort(&BgpTable::PathSelection, reference.front());
+        delete path;
+        if (idx % 100 == 0) {
+            ExpectSamePathOrder(route, reference);
+        }
+    }
+    EXPECT_TRUE(route.front() == NULL);
+    STLDeleteValues(&peers);
+}
+
+// MED is compared only between paths from the same neighbor AS, so path
+// selection is cyclic for these paths:
+//   path1 (AS 100, MED 10) is better than path2 (AS 200) on router id
+//   path2 (AS 200, MED 5) is better than path3 (AS 100) on router id
+//   path3 (AS 100, MED 1) is better than path1 (AS 100) on MED
+// Paths are in the order of the full sort whatever the insertion order.
+TEST_F(BgpRouteTest, InsertSortedCyclicMed) {
+    const int kPathCount = 3;
+    const as_t neighbor_as[kPathCount] = { 100, 200, 100 };
+    const uint32_t med[kPathCount] = { 10, 5, 1 };
+    std::vector<PeerMock *> peers;
+    std::vector<BgpAttrPtr> attrs;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        peers.push_back(new PeerMock(BgpProto::IBGP, Ip4Address(idx + 1)));
+        BgpAttrSpec spec;
+        BgpAttr *attr = new BgpAttr(server_.attr_db(), spec);
+        AsPathSpec as_path;
+        AsPathSpec::PathSegment *ps = new AsPathSpec::PathSegment;
+        ps->path_segment_type = AsPathSpec::PathSegment::AS_SEQUENCE;
+        ps->path_segment.push_back(neighbor_as[idx]);
+        as_path.path_segments.push_back(ps);
+        attr->set_as_path(&as_path);
+        attr->set_med(med[idx]);
+        attrs.push_back(server_.attr_db()->Locate(attr));
+    }
+
+    std::vector<int> order;
+    for (int idx = 0; idx < kPathCount; ++idx) {
+        order.push_back(idx);
+    }
+    Ip4Prefix prefix;
+    do {
+        InetRoute route(prefix);
+        InetRoute reference(prefix);
+        for (int idx = 0; idx < kPathCount; ++idx) {
+            int i = order[idx];
+            route.InsertPath(new BgpPath(peers[i], BgpPath::BGP_XMPP,
+                                         attrs[i], 0, 0));
+            reference.insert(new BgpPath(peers[i], BgpPath::BGP_XMPP,
+                                         attrs[i], 0, 0));
+            reference.Sort(&BgpTable::PathSelection, reference.front());
+            ExpectSamePathOrder(route, reference);
+        }
+
+        // Delete the best path, the remaining ones are re-sorted
+        const BgpPath *path =
+            static_cast<const BgpPath *>(reference.front());
+        route.DeletePath(
+            route.FindPath(BgpPath::BGP_XMPP, path->GetPeer(), 0));
+        reference.remove(path);
+        reference.Sort(&BgpTable::PathSelection, reference.front());
+        delete path;
+        ExpectSamePathOrder(route, reference);
+
+        while (reference.front()) {
+            path = static_cast<const BgpPath *>(reference.front());
+            route.DeletePath(
+                route.FindPath(BgpPath::BGP_XMPP, path->GetPeer(), 0));
+            reference.remove(path);
+            delete path;
+        }
+        EXPECT_TRUE(route.front() == NULL);
+    } while (std::next_permutation(order.begin(), order.end()));
+    STLDeleteValues(&peers);
+}
+
+// A path modified in place is moved to its position on the next insert.
+TEST_F(BgpRouteTest, InsertSortedOutOfOrder) {
+    PeerMock peer1(BgpProto::IBGP, Ip4Address(1));
+    PeerMock peer2(BgpProto::IBGP, Ip4Address(2));
+    PeerMock peer3(BgpProto::IBGP, Ip4Address(3));
+    BgpAttrSpec spec;
+    BgpAttrPtr attr = server_.attr_db()->Locate(
+        new BgpAttr(server_.attr_db(), spec));
+
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+    BgpPath *path1 = new BgpPath(&peer1, BgpPath::BGP_XMPP, attr, 0, 0);
+    BgpPath *path2 = new BgpPath(&peer2, BgpPath::BGP_XMPP, attr, 0, 0);
+    route.InsertPath(path2);
+    route.InsertPath(path1);
+    EXPECT_EQ(path1, route.BestPath());
+
+    path1->SetPolicyReject();
+    EXPECT_EQ(path1, route.BestPath());
+    BgpPath *path3 = new BgpPath(&peer3, BgpPath::BGP_XMPP, attr, 0, 0);
+    route.InsertPath(path3);
+    EXPECT_EQ(path2, route.BestPath());
+    EXPECT_EQ(path1, &route.GetPathList().back());
+
+    route.DeletePath(path1);
+    route.DeletePath(path2);
+    route.DeletePath(path3);
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
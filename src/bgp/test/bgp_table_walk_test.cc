@@ -247,6 +247,16 @@ public:
             "bgp::Config");
     }
 
+    void SetMaxConcurrentWalks(size_t count) {
+        DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+        walk_mgr->SetMaxConcurrentWalks(count);
+    }
+
+    void SetWalkBudget(uint32_t budget) {
+        DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+        walk_mgr->SetWalkBudget(budget);
+    }
+
     void PauseTableWalk() {
         pause_walk_ = true;
     }
@@ -1085,6 +1095,101 @@ TEST_F(BgpTableWalkTest, WalkEmptyTable) {
     TASK_UTIL_EXPECT_EQ(1, red_->walk_complete_count());
 }
 
+//
+// Trigger walk on multiple tables at same time.
+// Verify that walk of blue table completes while walk of red table is paused
+//
+TEST_F(BgpTableWalkTest, ConcurrentWalk) {
+    DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+    SetMaxConcurrentWalks(2);
+    AddInetRoute(red_, "11.1.1.0/24");
+    AddInetRoute(blue_, "22.2.2.0/24");
+
+    DBTable::DBTableWalkRef walk_ref_1 = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback_1, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone_1, this, _1, _2));
+    DBTable::DBTableWalkRef walk_ref_2 = blue_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+
+    // Walk of red table runs in context of bgp::ResolverPath, which is
+    // mutually exclusive with the pause task in bgp::ResolverNexthop
+    red_->SetWalkTaskId(
+        TaskScheduler::GetInstance()->GetTaskId("bgp::ResolverPath"));
+    int pause_task =
+        TaskScheduler::GetInstance()->GetTaskId("bgp::ResolverNexthop");
+    PauseTableWalk();
+    WalkPauseTask *task = new WalkPauseTask(this, pause_task);
+    TaskScheduler::GetInstance()->Enqueue(task);
+
+    // Start both walks together, red first
+    DisableWalkProcessing();
+    WalkTable(red_, walk_ref_1);
+    WalkTable(blue_, walk_ref_2);
+    EnableWalkProcessing();
+
+    // Walk of blue table is not held up by walk of red table
+    TASK_UTIL_EXPECT_TRUE(walk_done_);
+    TASK_UTIL_EXPECT_EQ(1, walk_count_);
+    TASK_UTIL_EXPECT_EQ(1, blue_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(1, red_->walk_count());
+    TASK_UTIL_EXPECT_EQ(0, red_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(1, walk_mgr->walks_in_progress());
+    TASK_UTIL_EXPECT_EQ(0, walk_mgr->walk_queue_depth());
+
+    // Resume the red table walk
+    ResumeTableWalk();
+    TASK_UTIL_EXPECT_TRUE(walk_done_1_);
+    TASK_UTIL_EXPECT_EQ(1, walk_count_1_);
+    TASK_UTIL_EXPECT_EQ(1, red_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(0, walk_mgr->walks_in_progress());
+
+    DeleteInetRoute(red_, "11.1.1.0/24");
+    DeleteInetRoute(blue_, "22.2.2.0/24");
+}
+
+//
+// Verify that walks yield when the walk budget is used up, and still
+// complete
+//
+TEST_F(BgpTableWalkTest, WalkBudget) {
+    DBTableWalkMgr *walk_mgr = server_.database()->GetWalkMgr();
+    for (int idx = 0; idx < 255; idx++) {
+        string prefix = string("10.1.1.") + integerToString(idx % 255) + "/32";
+        AddInetRoute(red_, prefix, false);
+        prefix = string("10.1.2.") + integerToString(idx % 255) + "/32";
+        AddInetRoute(blue_, prefix, false);
+    }
+    red_->SetWalkIterationToYield(1);
+    blue_->SetWalkIterationToYield(1);
+    SetMaxConcurrentWalks(2);
+    SetWalkBudget(32);
+    uint64_t yield_count = walk_mgr->walk_budget_yield_count();
+
+    DBTable::DBTableWalkRef walk_ref_1 = red_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback_1, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone_1, this, _1, _2));
+    DBTable::DBTableWalkRef walk_ref_2 = blue_->AllocWalker(
+              boost::bind(&BgpTableWalkTest::WalkTableCallback, this, _1, _2),
+              boost::bind(&BgpTableWalkTest::WalkDone, this, _1, _2));
+    WalkTable(red_, walk_ref_1);
+    WalkTable(blue_, walk_ref_2);
+
+    TASK_UTIL_EXPECT_TRUE(walk_done_);
+    TASK_UTIL_EXPECT_TRUE(walk_done_1_);
+    TASK_UTIL_EXPECT_EQ(255, walk_count_);
+    TASK_UTIL_EXPECT_EQ(255, walk_count_1_);
+    TASK_UTIL_EXPECT_TRUE(walk_mgr->walk_budget_yield_count() > yield_count);
+
+    SetWalkBudget(0);
+    for (int idx = 0; idx < 255; idx++) {
+        string prefix = string("10.1.1.") + integerToString(idx % 255) + "/32";
+        DeleteInetRoute(red_, prefix, false);
+        prefix = string("10.1.2.") + integerToString(idx % 255) + "/32";
+        DeleteInetRoute(blue_, prefix, false);
+    }
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
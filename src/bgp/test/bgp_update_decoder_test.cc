@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "base/time_util.h"
+#include "bgp/bgp_aspath.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_log.h"
+#include "bgp/bgp_origin_vn_path.h"
+#include "bgp/bgp_proto.h"
+#include "bgp/bgp_update_decoder.h"
+#include "bgp/community.h"
+#include "control-node/control_node.h"
+#include "net/bgp_af.h"
+#include "testing/gunit.h"
+
+using boost::scoped_ptr;
+using std::cout;
+using std::endl;
+using std::vector;
+
+class BgpUpdateDecoderTest : public ::testing::Test {
+protected:
+    static const int kRepeatCount = 4096;
+
+    virtual void SetUp() {
+        srand(1);
+    }
+
+    static void AddPrefix(vector<BgpProtoPrefix *> *list, int max_bits) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = rand() % (max_bits + 1);
+        for (int idx = (prefix->prefixlen + 7) / 8; idx > 0; --idx) {
+            prefix->prefix.push_back(rand());
+        }
+        list->push_back(prefix);
+    }
+
+    static void AddEvpnPrefix(vector<BgpProtoPrefix *> *list) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->type = rand() % 4 + 1;
+        int length = rand() % 40;
+        prefix->prefixlen = length * 8;
+        for (int idx = length; idx > 0; --idx) {
+            prefix->prefix.push_back(rand());
+        }
+        list->push_back(prefix);
+    }
+
+    static BgpMpNlri *RandomMpNlri(BgpAttribute::Code code) {
+        static const struct {
+            uint16_t afi;
+            uint8_t safi;
+            int nexthop_size;
+            int max_bits;
+        } families[] = {
+            { BgpAf::IPv4, BgpAf::Vpn, 12, 120 },
+            { BgpAf::IPv6, BgpAf::Vpn, 24, 216 },
+            { BgpAf::L2Vpn, BgpAf::EVpn, 4, 0 },
+            { BgpAf::IPv4, BgpAf::RTarget, 4, 96 },
+        };
+        int family = rand() % (sizeof(families) / sizeof(families[0]));
+        BgpMpNlri *mp_nlri = new BgpMpNlri(code, families[family].afi,
+                                           families[family].safi);
+        if (code == BgpAttribute::MPReachNlri) {
+            for (int idx = families[family].nexthop_size; idx > 0; --idx) {
+                mp_nlri->nexthop.push_back(rand());
+            }
+        }
+        for (int idx = rand() % 8; idx > 0; --idx) {
+            if (families[family].safi == BgpAf::EVpn) {
+                AddEvpnPrefix(&mp_nlri->nlri);
+            } else {
+                AddPrefix(&mp_nlri->nlri, families[family].max_bits);
+            }
+        }
+        return mp_nlri;
+    }
+
+    template <class C, typename T>
+    static BgpAttribute *RandomAsPath() {
+        C *path_spec = new C;
+        for (int count = rand() % 3; count > 0; --count) {
+            typename C::PathSegment *ps = new typename C::PathSegment;
+            ps->path_segment_type = rand() % 2 + 1;
+            for (int len = rand() % 8 + 1; len > 0; --len) {
+                ps->path_segment.push_back(static_cast<T>(rand()));
+            }
+            path_spec->path_segments.push_back(ps);
+        }
+        return path_spec;
+    }
+
+    static void RandomUpdate(BgpProto::Update *msg, bool as4) {
+        vector<BgpAttribute *> &attrs = msg->path_attributes;
+        if (rand() % 4 == 0) {
+            for (int idx = rand() % 4; idx > 0; --idx) {
+                AddPrefix(&msg->withdrawn_routes, 32);
+            }
+            attrs.push_back(RandomMpNlri(BgpAttribute::MPUnreachNlri));
+            return;
+        }
+
+        attrs.push_back(new BgpAttrOrigin(rand() % 3));
+        if (as4) {
+            attrs.push_back(RandomAsPath<AsPath4ByteSpec, as_t>());
+        } else {
+            attrs.push_back(RandomAsPath<AsPathSpec, as2_t>());
+        }
+        if (rand() % 2)
+            attrs.push_back(new BgpAttrNextHop(rand() | 1));
+        if (rand() % 2)
+            attrs.push_back(new BgpAttrMultiExitDisc(rand()));
+        attrs.push_back(new BgpAttrLocalPref(rand()));
+        if (rand() % 2) {
+            CommunitySpec *community = new CommunitySpec;
+            for (int idx = rand() % 4 + 1; idx > 0; --idx) {
+                community->communities.push_back(rand());
+            }
+            attrs.push_back(community);
+        }
+        if (rand() % 2) {
+            attrs.push_back(new BgpAttrOriginatorId(rand()));
+            ClusterListSpec *clist = new ClusterListSpec;
+            for (int idx = rand() % 3 + 1; idx > 0; --idx) {
+                clist->cluster_list.push_back(rand());
+            }
+            attrs.push_back(clist);
+        }
+        ExtCommunitySpec *ext_community = new ExtCommunitySpec;
+        for (int idx = rand() % 8 + 1; idx > 0; --idx) {
+            ext_community->communities.push_back(
+                (static_cast<uint64_t>(rand()) << 32) | rand());
+        }
+        attrs.push_back(ext_community);
+        if (rand() % 2) {
+            OriginVnPathSpec *ovnpath = new OriginVnPathSpec;
+            for (int idx = rand() % 3 + 1; idx > 0; --idx) {
+                ovnpath->origin_vns.push_back(rand());
+            }
+            attrs.push_back(ovnpath);
+        }
+        attrs.push_back(RandomMpNlri(BgpAttribute::MPReachNlri));
+        for (int idx = rand() % 4; idx > 0; --idx) {
+            AddPrefix(&msg->nlri, 32);
+        }
+    }
+
+    static int Encode(bool as4, uint8_t *data, size_t size) {
+        BgpProto::Update msg;
+        RandomUpdate(&msg, as4);
+        return BgpProto::Encode(&msg, data, size, NULL, as4);
+    }
+
+    // Insert, delete or change a byte after the marker and keep the
+    // message length consistent with the buffer.
+    static size_t Mutate(uint8_t *data, size_t size) {
+        size_t pos = 16 + rand() % (size - 16);
+        switch (rand() % 3) {
+        case 0:
+            memmove(data + pos + 1, data + pos, size - pos);
+            data[pos] = rand();
+            size++;
+            break;
+        case 1:
+            memmove(data + pos, data + pos + 1, size - pos - 1);
+            size--;
+            break;
+        case 2:
+            data[pos] = rand();
+            break;
+        }
+        if (pos > 17) {
+            data[16] = size >> 8;
+            data[17] = size & 0xff;
+        }
+        return size;
+    }
+
+    static void CompareFlags(const BgpProto::Update &lhs,
+                             const BgpProto::Update &rhs) {
+        ASSERT_EQ(lhs.path_attributes.size(), rhs.path_attributes.size());
+        for (size_t idx = 0; idx < lhs.path_attributes.size(); ++idx) {
+            EXPECT_EQ(lhs.path_attributes[idx]->flags,
+                      rhs.path_attributes[idx]->flags);
+        }
+    }
+
+    // Whenever the decoder accepts a message, the generic parser must
+    // accept it too and give the same result.
+    void Verify(const uint8_t *data, size_t size, bool as4, int *accepted) {
+        scoped_ptr<BgpProto::Update> decoded(
+            BgpUpdateDecoder::Decode(data, size, as4));
+        scoped_ptr<BgpProto::BgpMessage> parsed(
+            BgpProto::GenericDecode(data, size, NULL, as4));
+        if (!decoded)
+            return;
+        (*accepted)++;
+        ASSERT_TRUE(parsed.get() != NULL);
+        ASSERT_EQ(BgpProto::UPDATE, parsed->type);
+        const BgpProto::Update *update =
+            static_cast<const BgpProto::Update *>(parsed.get());
+        EXPECT_EQ(0, decoded->CompareTo(*update));
+        CompareFlags(*decoded, *update);
+    }
+
+    void Fuzz(bool as4) {
+        uint8_t data[BgpProto::kMaxMessageSize + 1];
+        int accepted = 0;
+        for (int idx = 0; idx < kRepeatCount; ++idx) {
+            int size = Encode(as4, data, BgpProto::kMaxMessageSize);
+            ASSERT_LT(0, size);
+
+            // The encoding of the supported attributes is always accepted.
+            int count = accepted;
+            Verify(data, size, as4, &accepted);
+            EXPECT_EQ(count + 1, accepted);
+
+            size = Mutate(data, size);
+            if (size > BgpProto::kMaxMessageSize)
+                continue;
+            Verify(data, size, as4, &accepted);
+        }
+        cout << accepted - kRepeatCount << " of " << kRepeatCount
+             << " changed messages decoded" << endl;
+    }
+};
+
+TEST_F(BgpUpdateDecoderTest, Fuzz) {
+    Fuzz(false);
+}
+
+TEST_F(BgpUpdateDecoderTest, FuzzAs4) {
+    Fuzz(true);
+}
+
+// Messages with attributes outside the common set are left to the generic
+// parser.
+TEST_F(BgpUpdateDecoderTest, Unsupported) {
+    BgpProto::Update msg;
+    msg.path_attributes.push_back(new BgpAttrOrigin(BgpAttrOrigin::IGP));
+    msg.path_attributes.push_back(new BgpAttrAtomicAggregate);
+    uint8_t data[BgpProto::kMaxMessageSize];
+    int size = BgpProto::Encode(&msg, data, sizeof(data), NULL, false);
+    ASSERT_LT(0, size);
+    EXPECT_TRUE(BgpUpdateDecoder::Decode(data, size, false) == NULL);
+
+    scoped_ptr<BgpProto::BgpMessage> result(
+        BgpProto::Decode(data, size, NULL, false));
+    EXPECT_TRUE(result.get() != NULL);
+}
+
+TEST_F(BgpUpdateDecoderTest, Benchmark) {
+    vector<vector<uint8_t> > messages;
+    uint8_t data[BgpProto::kMaxMessageSize];
+    for (int idx = 0; idx < kRepeatCount; ++idx) {
+        int size = Encode(false, data, sizeof(data));
+        ASSERT_LT(0, size);
+        messages.push_back(vector<uint8_t>(data, data + size));
+    }
+
+    uint64_t start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kRepeatCount; ++idx) {
+        scoped_ptr<BgpProto::BgpMessage> msg(BgpProto::GenericDecode(
+            &messages[idx][0], messages[idx].size(), NULL, false));
+        EXPECT_TRUE(msg.get() != NULL);
+    }
+    uint64_t parse_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    for (int idx = 0; idx < kRepeatCount; ++idx) {
+        scoped_ptr<BgpProto::Update> msg(BgpUpdateDecoder::Decode(
+            &messages[idx][0], messages[idx].size(), false));
+        EXPECT_TRUE(msg.get() != NULL);
+    }
+    uint64_t decode_time = ClockMonotonicUsec() - start;
+
+    cout << kRepeatCount << " updates: generic parser " << parse_time
+         << " usec, BgpUpdateDecoder " << decode_time << " usec" << endl;
+}
+
+int main(int argc, char **argv) {
+    bgp_log_test::init();
+    ControlNode::SetDefaultSchedulingPolicy();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1158,6 +1158,63 @@ TEST_F(BgpXmppInet6Test, 1AgentConnectedInstances) {
     agent_a_->SessionDown();
 }
 
+//
+// Lazy tables: the inet6 table of the instance doesn't exist when the agent
+// subscribes. The route from the agent is deferred, the table gets created,
+// and the deferred route is added once the agent is subscribed to the table.
+//
+TEST_F(BgpXmppInet6Test, 1AgentLazyTable) {
+    bgp_server_->set_lazy_vrf_tables(true);
+    Configure(one_cn_unconnected_instances_config);
+    task_util::WaitForIdle();
+
+    RoutingInstanceMgr *mgr = bgp_server_->routing_instance_mgr();
+    TASK_UTIL_ASSERT_TRUE(mgr->GetRoutingInstance("blue") != NULL);
+    RoutingInstance *blue_ri = mgr->GetRoutingInstance("blue");
+    TASK_UTIL_EXPECT_TRUE(blue_ri->GetTable(Address::INET) != NULL);
+    TASK_UTIL_EXPECT_TRUE(blue_ri->GetTable(Address::INET6) == NULL);
+
+    // Create XMPP Agent A connected to XMPP server.
+    agent_a_.reset(
+        new test::NetworkAgentMock(&evm_, "agent-a", xmpp_server_->GetPort(),
+            "127.0.0.1"));
+    TASK_UTIL_EXPECT_TRUE(agent_a_->IsEstablished());
+
+    // Register to blue instance, doesn't create the table.
+    agent_a_->Inet6Subscribe("blue", 1);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(blue_ri->GetTable(Address::INET6) == NULL);
+
+    // Add route from agent, creates the table.
+    string route_a("2001:db8:85a3::8a2e:370:aaaa/128");
+    test::NextHop nexthop_a("192.168.1.1");
+    agent_a_->AddInet6Route("blue", route_a, nexthop_a);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(blue_ri->GetTable(Address::INET6) != NULL);
+
+    // Verify that the deferred route got added and showed up on agent.
+    TASK_UTIL_EXPECT_EQ(1U, blue_ri->GetTable(Address::INET6)->Size());
+    TASK_UTIL_EXPECT_EQ(1, agent_a_->Inet6RouteCount("blue"));
+    TASK_UTIL_EXPECT_TRUE(
+        VerifyRouteUpdateNexthop("blue", route_a, "192.168.1.1",
+                                 agent_a_.get()));
+
+    // More routes go to the table right away.
+    string route_b("2001:db8:85a3::8a2e:370:bbbb/128");
+    agent_a_->AddInet6Route("blue", route_b, nexthop_a);
+    TASK_UTIL_EXPECT_EQ(2, agent_a_->Inet6RouteCount("blue"));
+
+    // Delete routes.
+    agent_a_->DeleteInet6Route("blue", route_a);
+    agent_a_->DeleteInet6Route("blue", route_b);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, agent_a_->Inet6RouteCount("blue"));
+    TASK_UTIL_EXPECT_EQ(0U, blue_ri->GetTable(Address::INET6)->Size());
+
+    // Close the sessions.
+    agent_a_->SessionDown();
+}
+
 static const char *two_cns_unconnected_instances_config = "\
 <config>\
     <bgp-router name=\'X\'>\
@@ -2207,6 +2207,46 @@ TYPED_TEST(PathResolverTest, MultiplePrefix) {
     }
 }
 
+//
+// BGP has multiple prefixes, each with a different nexthop.
+// The ResolverNexthops are spread over all the nexthop shards.
+//
+TYPED_TEST(PathResolverTest, MultiplePrefixMultipleNexthop) {
+    PeerMock *bgp_peer1 = this->bgp_peer1_;
+    PeerMock *xmpp_peer1 = this->xmpp_peer1_;
+    int count = DB::PartitionCount() * 2;
+
+    for (int idx = 1; idx <= count; ++idx) {
+        string nexthop = "192.168.2." + integerToString(idx);
+        this->AddBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx),
+            this->BuildHostAddress(nexthop));
+        this->AddXmppPath(xmpp_peer1, "blue", this->BuildPrefix(nexthop, 32),
+            this->BuildNextHopAddress("172.16.1.1"), 10000 + idx);
+    }
+    for (int idx = 1; idx <= count; ++idx) {
+        this->VerifyPathAttributes("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"), 10000 + idx);
+    }
+
+    TASK_UTIL_EXPECT_EQ(count, this->ResolverNexthopMapSize("blue"));
+    this->VerifyPathResolverSandesh("blue", count, count);
+
+    for (int idx = 1; idx <= count; ++idx) {
+        string nexthop = "192.168.2." + integerToString(idx);
+        this->DeleteXmppPath(xmpp_peer1, "blue",
+            this->BuildPrefix(nexthop, 32));
+    }
+    for (int idx = 1; idx <= count; ++idx) {
+        this->VerifyPathNoExists("blue", this->BuildPrefix(idx), bgp_peer1,
+            this->BuildNextHopAddress("172.16.1.1"));
+    }
+
+    for (int idx = 1; idx <= count; ++idx) {
+        this->DeleteBgpPath(bgp_peer1, "blue", this->BuildPrefix(idx));
+    }
+    TASK_UTIL_EXPECT_EQ(0, this->ResolverNexthopMapSize("blue"));
+}
+
 //
 // BGP has multiple prefixes, each with the same nexthop.
 // Change XMPP path multiple times when path update list processing is disabled.
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "bgp/bgp_log.h"
+#include "bgp/routing-instance/prefix_index.h"
+#include "control-node/control_node.h"
+#include "testing/gunit.h"
+
+using std::vector;
+
+class PrefixIndexTest : public ::testing::Test {
+protected:
+    typedef PrefixIndex<Ip4Prefix, int> Ip4PrefixIndex;
+
+    static const int kPrefixCount = 1024;
+    static const int kLookupCount = 1024;
+
+    virtual void SetUp() {
+        srand(1);
+    }
+
+    // Prefixes clustered under a few /8s so that they nest.
+    static Ip4Prefix RandomPrefix(int min_length) {
+        int length = min_length + rand() % (33 - min_length);
+        uint32_t addr = ((rand() % 4) << 24) | (rand() & 0xffffff);
+        if (length < 32)
+            addr &= ~(0xffffffff >> length);
+        return Ip4Prefix(Ip4Address(addr), length);
+    }
+
+    // Covering prefixes found by comparing with every prefix, shortest first.
+    static vector<int> LinearMatches(const vector<Ip4Prefix> &prefixes,
+                                     const Ip4Prefix &prefix) {
+        vector<int> matches;
+        for (int length = 0; length <= 32; ++length) {
+            for (size_t idx = 0; idx < prefixes.size(); ++idx) {
+                if (prefixes[idx].prefixlen() == length &&
+                    prefix.IsMoreSpecific(prefixes[idx])) {
+                    matches.push_back(idx);
+                }
+            }
+        }
+        return matches;
+    }
+
+    static vector<int> IndexMatches(const Ip4PrefixIndex &index,
+                                    const Ip4Prefix &prefix) {
+        Ip4PrefixIndex::EntryList entries;
+        index.FindMatches(prefix, &entries);
+        vector<int> matches;
+        for (size_t idx = 0; idx < entries.size(); ++idx) {
+            matches.push_back(entries[idx]->second);
+        }
+        return matches;
+    }
+};
+
+TEST_F(PrefixIndexTest, Inet) {
+    Ip4PrefixIndex index;
+    EXPECT_TRUE(index.Insert(Ip4Prefix::FromString("1.1.0.0/16"), 16));
+    EXPECT_TRUE(index.Insert(Ip4Prefix::FromString("1.0.0.0/8"), 8));
+    EXPECT_TRUE(index.Insert(Ip4Prefix::FromString("1.1.1.0/24"), 24));
+    EXPECT_TRUE(index.Insert(Ip4Prefix::FromString("1.2.0.0/16"), 116));
+    EXPECT_FALSE(index.Insert(Ip4Prefix::FromString("1.1.0.0/16"), 0));
+    EXPECT_EQ(4U, index.size());
+
+    Ip4Prefix prefix = Ip4Prefix::FromString("1.1.1.1/32");
+    Ip4PrefixIndex::EntryList matches;
+    index.FindMatches(prefix, &matches);
+    ASSERT_EQ(3U, matches.size());
+    EXPECT_EQ(8, matches[0]->second);
+    EXPECT_EQ(16, matches[1]->second);
+    EXPECT_EQ(24, matches[2]->second);
+    EXPECT_EQ(8, index.FindShortestMatch(prefix)->second);
+    EXPECT_EQ(24, index.FindLongestMatch(prefix)->second);
+
+    // An exact match covers the prefix
+    prefix = Ip4Prefix::FromString("1.1.0.0/16");
+    EXPECT_EQ(16, index.FindLongestMatch(prefix)->second);
+    prefix = Ip4Prefix::FromString("2.0.0.0/8");
+    EXPECT_TRUE(index.FindLongestMatch(prefix) == NULL);
+
+    EXPECT_TRUE(index.Remove(Ip4Prefix::FromString("1.1.1.0/24")));
+    EXPECT_FALSE(index.Remove(Ip4Prefix::FromString("1.1.1.0/24")));
+    EXPECT_FALSE(index.Remove(Ip4Prefix::FromString("1.0.0.0/14")));
+    prefix = Ip4Prefix::FromString("1.1.1.1/32");
+    EXPECT_EQ(16, index.FindLongestMatch(prefix)->second);
+
+    EXPECT_TRUE(index.Remove(Ip4Prefix::FromString("1.0.0.0/8")));
+    EXPECT_EQ(16, index.FindShortestMatch(prefix)->second);
+    EXPECT_EQ(2U, index.size());
+
+    index.Clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_TRUE(index.FindLongestMatch(prefix) == NULL);
+}
+
+TEST_F(PrefixIndexTest, Inet6) {
+    PrefixIndex<Inet6Prefix, int> index;
+    EXPECT_TRUE(index.Insert(Inet6Prefix::FromString("2001:db8::/32"), 32));
+    EXPECT_TRUE(index.Insert(Inet6Prefix::FromString("2001:db8:1::/48"), 48));
+    EXPECT_TRUE(index.Insert(Inet6Prefix::FromString("2001:db9::/32"), 0));
+
+    Inet6Prefix prefix = Inet6Prefix::FromString("2001:db8:1::1/128");
+    EXPECT_EQ(32, index.FindShortestMatch(prefix)->second);
+    EXPECT_EQ(48, index.FindLongestMatch(prefix)->second);
+    prefix = Inet6Prefix::FromString("2001:db8:2::1/128");
+    EXPECT_EQ(32, index.FindLongestMatch(prefix)->second);
+    prefix = Inet6Prefix::FromString("2001:dba::/32");
+    EXPECT_TRUE(index.FindLongestMatch(prefix) == NULL);
+}
+
+// IPv4 and IPv6 ip prefix routes do not cover each other and other route
+// types are not indexed.
+TEST_F(PrefixIndexTest, Evpn) {
+    PrefixIndex<EvpnPrefix, int> index;
+    EXPECT_TRUE(index.Insert(EvpnPrefix::FromString("5-0:0-0-0.0.0.0/0"), 4));
+    EXPECT_TRUE(index.Insert(EvpnPrefix::FromString("5-0:0-0-::/0"), 6));
+    EXPECT_FALSE(index.Insert(EvpnPrefix::FromString(
+        "2-10.1.1.1:65535-0-11:12:13:14:15:16,0.0.0.0"), 2));
+
+    EvpnPrefix prefix = EvpnPrefix::FromString("5-0:0-0-10.1.1.0/24");
+    EXPECT_EQ(4, index.FindLongestMatch(prefix)->second);
+    prefix = EvpnPrefix::FromString("5-0:0-0-2001:db8::/64");
+    EXPECT_EQ(6, index.FindLongestMatch(prefix)->second);
+    prefix = EvpnPrefix::FromString(
+        "2-10.1.1.1:65535-0-11:12:13:14:15:16,0.0.0.0");
+    EXPECT_TRUE(index.FindLongestMatch(prefix) == NULL);
+}
+
+// Random inserts, removes and lookups give the same result as a linear scan.
+TEST_F(PrefixIndexTest, Random) {
+    Ip4PrefixIndex index;
+    vector<Ip4Prefix> prefixes;
+    for (int idx = 0; idx < kPrefixCount; ++idx) {
+        Ip4Prefix prefix = RandomPrefix(8);
+        bool found = false;
+        for (size_t pos = 0; pos < prefixes.size(); ++pos) {
+            if (prefixes[pos] == prefix)
+                found = true;
+        }
+        EXPECT_EQ(!found, index.Insert(prefix, prefixes.size()));
+        if (!found)
+            prefixes.push_back(prefix);
+
+        // Remove every fourth prefix again
+        if (idx % 4 == 3) {
+            int pos = rand() % prefixes.size();
+            EXPECT_TRUE(index.Remove(prefixes[pos]));
+            EXPECT_TRUE(index.Insert(prefixes[pos], pos));
+        }
+        ASSERT_EQ(prefixes.size(), index.size());
+    }
+
+    for (int idx = 0; idx < kPrefixCount; ++idx) {
+        Ip4Prefix prefix = RandomPrefix(16);
+        EXPECT_EQ(LinearMatches(prefixes, prefix),
+                  IndexMatches(index, prefix));
+    }
+
+    for (size_t pos = 0; pos < prefixes.size(); ++pos) {
+        EXPECT_TRUE(index.Remove(prefixes[pos]));
+    }
+    EXPECT_TRUE(index.empty());
+}
+
+// FindShortestMatch agrees with the first covering prefix of a linear scan.
+TEST_F(PrefixIndexTest, ShortestMatch) {
+    Ip4PrefixIndex index;
+    vector<Ip4Prefix> prefixes;
+    for (int idx = 0; idx < kPrefixCount; ++idx) {
+        Ip4Prefix prefix = RandomPrefix(16);
+        if (index.Insert(prefix, prefixes.size()))
+            prefixes.push_back(prefix);
+    }
+
+    for (int idx = 0; idx < kLookupCount; ++idx) {
+        Ip4Prefix route = RandomPrefix(24);
+        vector<int> matches = LinearMatches(prefixes, route);
+        const Ip4PrefixIndex::Entry *entry = index.FindShortestMatch(route);
+        if (matches.empty()) {
+            EXPECT_TRUE(entry == NULL);
+        } else {
+            ASSERT_TRUE(entry != NULL);
+            EXPECT_EQ(matches.front(), entry->second);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    bgp_log_test::init();
+    ControlNode::SetDefaultSchedulingPolicy();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -332,6 +332,43 @@ TEST_F(RibOutAttributesTest, SequenceNumber2) {
     route.RemovePath(&peer2);
 }
 
+// RibOutAttrs with the same nexthops share one interned nexthop list.
+TEST_F(RibOutAttributesTest, NextHopListInterned) {
+    Ip4Prefix prefix;
+    InetRoute route(prefix);
+
+    BgpAttrNextHop nexthop(0x01010101);
+    BgpAttrSpec spec;
+    spec.push_back(&nexthop);
+    BgpAttrPtr attr = server_.attr_db()->Locate(spec);
+    BgpPeerMock peer;
+    BgpPath *path = new BgpPath(&peer, BgpPath::BGP_XMPP, attr, 0, 100);
+    route.InsertPath(path);
+
+    RibOutNextHopListDB *db = server_.ribout_nexthop_list_db();
+    {
+        RibOutAttr ribout_attr1(&route, route.BestPath()->GetAttr(), true);
+        RibOutAttr ribout_attr2(static_cast<BgpTable *>(NULL), attr.get(),
+                                100, 0, true);
+        EXPECT_EQ(1, db->Size());
+        EXPECT_EQ(&ribout_attr1.nexthop_list(), &ribout_attr2.nexthop_list());
+        EXPECT_TRUE(ribout_attr1 == ribout_attr2);
+
+        RibOutAttr ribout_attr3(static_cast<BgpTable *>(NULL), attr.get(),
+                                200, 0, true);
+        EXPECT_EQ(2, db->Size());
+        EXPECT_TRUE(ribout_attr1 != ribout_attr3);
+
+        RibOutAttr ribout_attr4(ribout_attr3);
+        EXPECT_EQ(2, db->Size());
+        EXPECT_TRUE(ribout_attr3 == ribout_attr4);
+    }
+    EXPECT_EQ(0, db->Size());
+
+    // Cleanup.
+    route.RemovePath(&peer);
+}
+
 }  // namespace
 
 static void SetUp() {
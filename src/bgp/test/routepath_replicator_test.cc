@@ -11,6 +11,7 @@
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/inet/inet_table.h"
+#include "bgp/inet6vpn/inet6vpn_table.h"
 #include "bgp/l3vpn/inetvpn_table.h"
 #include "bgp/origin-vn/origin_vn.h"
 #include "bgp/routing-instance/rtarget_group_mgr.h"
@@ -257,6 +258,43 @@ protected:
         task_util::WaitForIdle();
     }
 
+    void AddInet6VPNRoute(IPeer *peer, const string &prefix, int localpref,
+                          const vector<string> &instance_names) {
+        boost::system::error_code error;
+        Inet6VpnPrefix nlri = Inet6VpnPrefix::FromString(prefix, &error);
+        EXPECT_FALSE(error);
+        BgpAttrSpec attr_spec;
+        boost::scoped_ptr<BgpAttrLocalPref> local_pref(
+                                new BgpAttrLocalPref(localpref));
+        attr_spec.push_back(local_pref.get());
+        boost::scoped_ptr<ExtCommunitySpec> commspec;
+        commspec.reset(BuildInstanceListTargets(instance_names, &attr_spec));
+
+        DBRequest request;
+        request.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        request.key.reset(new Inet6VpnTable::RequestKey(nlri, peer));
+        BgpAttrPtr attr = bgp_server_->attr_db()->Locate(attr_spec);
+        request.data.reset(new BgpTable::RequestData(attr, 0, 0));
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable("bgp.l3vpn-inet6.0"));
+        ASSERT_TRUE(table != NULL);
+        table->Enqueue(&request);
+        task_util::WaitForIdle();
+    }
+
+    void DeleteInet6VPNRoute(IPeer *peer, const string &prefix) {
+        boost::system::error_code error;
+        Inet6VpnPrefix nlri = Inet6VpnPrefix::FromString(prefix, &error);
+        EXPECT_FALSE(error);
+        DBRequest request;
+        request.oper = DBRequest::DB_ENTRY_DELETE;
+        request.key.reset(new Inet6VpnTable::RequestKey(nlri, peer));
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable("bgp.l3vpn-inet6.0"));
+        ASSERT_TRUE(table != NULL);
+        table->Enqueue(&request);
+    }
+
     void DeleteVPNRoute(IPeer *peer, const string &prefix) {
         boost::system::error_code error;
         InetVpnPrefix nlri = InetVpnPrefix::FromString(prefix, &error);
@@ -321,6 +359,16 @@ protected:
         return table->Size();
     }
 
+    // Returns -1 if the instance has no inet6 table
+    int Inet6RouteCount(const string &instance_name) const {
+        BgpTable *table = static_cast<BgpTable *>(
+            bgp_server_->database()->FindTable(instance_name + ".inet6.0"));
+        if (table == NULL) {
+            return -1;
+        }
+        return table->Size();
+    }
+
     BgpRoute *VPNRouteLookup(const string &prefix) {
         BgpTable *table = static_cast<BgpTable *>(
             bgp_server_->database()->FindTable("bgp.l3vpn.0"));
@@ -2697,6 +2745,45 @@ TEST_F(ReplicationTest, TableStateOnVRFInBulkSyncList) {
     VerifyVRFTableStateExists("red", false);
 }
 
+//
+// With lazy tables, the inet6 tables of the instances are created when a VPN
+// route carries one of their import targets, and the route gets replicated
+// into them.
+//
+TEST_F(ReplicationTest, LazyTableCreatedByVpnRoute) {
+    bgp_server_->set_lazy_vrf_tables(true);
+    vector<string> instance_names = list_of("blue")("red")("green");
+    multimap<string, string> connections = map_list_of("blue", "red");
+    NetworkConfig(instance_names, connections);
+    task_util::WaitForIdle();
+
+    VerifyTableNoExists("blue.inet6.0");
+    VerifyTableNoExists("red.inet6.0");
+    VerifyTableNoExists("green.inet6.0");
+    const RoutePathReplicator *replicator =
+        bgp_server_->replicator(Address::INET6VPN);
+    size_t deferred_count = replicator->deferred_import_count();
+    EXPECT_NE(0U, deferred_count);
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    // VPN route with target "blue", imported in both blue and red.
+    AddInet6VPNRoute(peers_[0], "192.168.0.1:1:2001:db8::1/128", 100,
+                     list_of("blue"));
+    TASK_UTIL_EXPECT_EQ(1, Inet6RouteCount("blue"));
+    TASK_UTIL_EXPECT_EQ(1, Inet6RouteCount("red"));
+    EXPECT_EQ(-1, Inet6RouteCount("green"));
+    TASK_UTIL_EXPECT_GT(deferred_count, replicator->deferred_import_count());
+    EXPECT_NE(0U, replicator->deferred_import_count());
+
+    DeleteInet6VPNRoute(peers_[0], "192.168.0.1:1:2001:db8::1/128");
+    TASK_UTIL_EXPECT_EQ(0, Inet6RouteCount("blue"));
+    TASK_UTIL_EXPECT_EQ(0, Inet6RouteCount("red"));
+    VerifyTableNoExists("green.inet6.0");
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
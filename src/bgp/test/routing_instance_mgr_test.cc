@@ -5,6 +5,7 @@
 #include <boost/foreach.hpp>
 #include <fstream>
 
+#include "base/string_util.h"
 #include "base/task_annotations.h"
 #include "bgp/test/bgp_server_test_util.h"
 #include "bgp/tunnel_encap/tunnel_encap.h"
@@ -131,6 +132,67 @@ protected:
         return ri_mgr_->GetActiveTraceBuffer(name);
     }
 
+    void RequestTable(const string &name, Address::Family family) {
+        ri_mgr_->RequestTable(name, family);
+        task_util::WaitForIdle();
+    }
+
+    void SweepLazyTables() {
+        ConcurrencyScope scope("bgp::Config");
+
+        TaskScheduler::GetInstance()->Stop();
+        ri_mgr_->LazyTableSweepTimerExpired();
+        TaskScheduler::GetInstance()->Start();
+        task_util::WaitForIdle();
+    }
+
+    const BgpTable *GetTable(const string &name, Address::Family family) {
+        const RoutingInstance *rtinstance = FindRoutingInstance(name);
+        return rtinstance->GetTable(family);
+    }
+
+    void CreateRoutingInstances(vector<BgpInstanceConfigTest *> *cfg_list,
+                                int count) {
+        {
+            ConcurrencyScope scope("bgp::Config");
+            TaskScheduler::GetInstance()->Stop();
+            for (int idx = 1; idx <= count; ++idx) {
+                BgpInstanceConfigTest *cfg =
+                    BgpTestUtil::CreateBgpInstanceConfig(
+                        "ri" + integerToString(idx),
+                        "target:100:" + integerToString(idx),
+                        "target:100:" + integerToString(idx));
+                cfg_list->push_back(cfg);
+                ri_mgr_->CreateRoutingInstance(cfg);
+            }
+            TaskScheduler::GetInstance()->Start();
+        }
+        task_util::WaitForIdle();
+    }
+
+    void DeleteRoutingInstances(vector<BgpInstanceConfigTest *> *cfg_list) {
+        {
+            ConcurrencyScope scope("bgp::Config");
+            TaskScheduler::GetInstance()->Stop();
+            BOOST_FOREACH(BgpInstanceConfigTest *cfg, *cfg_list) {
+                ri_mgr_->DeleteRoutingInstance(cfg->name());
+            }
+            TaskScheduler::GetInstance()->Start();
+        }
+        TASK_UTIL_EXPECT_EQ(1U, ri_mgr_->count());
+        STLDeleteValues(cfg_list);
+    }
+
+    size_t GetTableCount() {
+        size_t count = 0;
+        for (RoutingInstanceMgr::RoutingInstanceIterator it = ri_mgr_->begin();
+             it != ri_mgr_->end(); ++it) {
+            if (!it->second->IsMasterRoutingInstance())
+                count += it->second->GetTables().size();
+        }
+        return count;
+    }
+
     EventManager evm_;
     BgpServer server_;
     RoutingInstanceMgr *ri_mgr_;
@@ -930,6 +992,93 @@ TEST_F(RoutingInstanceMgrTest, VnIndexByExtCommunity13) {
     DeleteRoutingInstance(ri2_cfg.get());
 }
 
+//
+// INET6 and MVPN tables are not created along with the instance if lazy
+// tables are enabled.
+// They get created when requested and deleted after two idle sweeps.
+//
+TEST_F(RoutingInstanceMgrTest, LazyTables01) {
+    server_.set_lazy_vrf_tables(true);
+    scoped_ptr<BgpInstanceConfigTest> ri1_cfg;
+    ri1_cfg.reset(BgpTestUtil::CreateBgpInstanceConfig("ri1",
+            "target:100:1", "target:100:1"));
+    CreateRoutingInstance(ri1_cfg.get());
+
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::EVPN) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::ERMVPN) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) == NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) == NULL);
+
+    RequestTable("ri1", Address::INET6);
+    RequestTable("ri1", Address::MVPN);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) != NULL);
+
+    // First sweep only marks the tables as idle.
+    SweepLazyTables();
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) != NULL);
+
+    // Second sweep deletes them.
+    SweepLazyTables();
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) == NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) == NULL);
+
+    // Tables can be created again.
+    RequestTable("ri1", Address::INET6);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) != NULL);
+
+    DeleteRoutingInstance(ri1_cfg.get());
+}
+
+//
+// All tables are created along with the instance if lazy tables are
+// disabled, and requests for tables that exist are ignored.
+//
+TEST_F(RoutingInstanceMgrTest, LazyTables02) {
+    scoped_ptr<BgpInstanceConfigTest> ri1_cfg;
+    ri1_cfg.reset(BgpTestUtil::CreateBgpInstanceConfig("ri1",
+            "target:100:1", "target:100:1"));
+    CreateRoutingInstance(ri1_cfg.get());
+
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) != NULL);
+    RequestTable("ri1", Address::INET6);
+    SweepLazyTables();
+    SweepLazyTables();
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::INET6) != NULL);
+    TASK_UTIL_EXPECT_TRUE(GetTable("ri1", Address::MVPN) != NULL);
+
+    DeleteRoutingInstance(ri1_cfg.get());
+}
+
+//
+// Tables per instance with and without lazy tables. The INET6 and MVPN tables
+// of each instance are not created with lazy tables.
+//
+TEST_F(RoutingInstanceMgrTest, LazyTablesScale) {
+    const size_t kInstanceCount = 1000;
+    vector<BgpInstanceConfigTest *> cfg_list;
+
+    CreateRoutingInstances(&cfg_list, kInstanceCount);
+    size_t eager_tables = GetTableCount();
+    DeleteRoutingInstances(&cfg_list);
+
+    server_.set_lazy_vrf_tables(true);
+    CreateRoutingInstances(&cfg_list, kInstanceCount);
+    size_t lazy_tables = GetTableCount();
+    for (size_t idx = 1; idx <= kInstanceCount; ++idx) {
+        string name = "ri" + integerToString(idx);
+        ASSERT_TRUE(GetTable(name, Address::INET6) == NULL);
+        ASSERT_TRUE(GetTable(name, Address::MVPN) == NULL);
+    }
+    DeleteRoutingInstances(&cfg_list);
+
+    EXPECT_EQ(0U, eager_tables % kInstanceCount);
+    EXPECT_EQ(eager_tables - 2 * kInstanceCount, lazy_tables);
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
@@ -2881,6 +2881,45 @@ TYPED_TEST(ServiceChainTest, PendingChain) {
     this->VerifyDownServiceChainCount(1);
 }
 
+//
+// With lazy tables, the inet6 tables used by the service chain may not exist
+// when it is configured. The chain is pending till they are created on its
+// request, and then works as usual.
+//
+TYPED_TEST(ServiceChainTest, PendingChainLazyTables) {
+    this->bgp_server_->set_lazy_vrf_tables(true);
+    vector<string> instance_names = list_of("blue")("blue-i1")("red-i2")("red");
+    multimap<string, string> connections =
+        map_list_of("blue", "blue-i1") ("red-i2", "red");
+    this->NetworkConfig(instance_names, connections);
+    this->VerifyNetworkConfig(instance_names);
+
+    this->VerifyServiceChainCount(0);
+    this->VerifyDownServiceChainCount(0);
+
+    this->SetServiceChainInformation("blue-i1",
+        "controller/src/bgp/testdata/service_chain_1.xml");
+
+    // Tables needed by the chain got created and the chain is resolved.
+    TASK_UTIL_EXPECT_EQ(0, this->ServiceChainPendingQSize());
+    this->VerifyServiceChainCount(1);
+    this->VerifyDownServiceChainCount(1);
+    TASK_UTIL_EXPECT_TRUE(this->GetTable("blue") != NULL);
+    TASK_UTIL_EXPECT_TRUE(this->GetConnTable(
+        this->service_is_transparent_ ? "blue-i1" : "blue") != NULL);
+
+    // Add Connected
+    this->AddConnectedRoute(NULL, this->BuildConnPrefix("1.1.2.3", 32), 100,
+                            this->BuildNextHopAddress("2.3.4.5"));
+    this->VerifyServiceChainCount(1);
+    this->VerifyDownServiceChainCount(0);
+
+    // Delete connected
+    this->DeleteConnectedRoute(NULL, this->BuildConnPrefix("1.1.2.3", 32));
+    this->VerifyServiceChainCount(1);
+    this->VerifyDownServiceChainCount(1);
+}
+
 TYPED_TEST(ServiceChainTest, UnresolvedPendingChain) {
     vector<string> instance_names = list_of("blue")("blue-i1")("red-i2");
     multimap<string, string> connections =
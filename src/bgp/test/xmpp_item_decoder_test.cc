@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pugixml/pugixml.hpp>
+
+#include "base/logging.h"
+#include "bgp/xmpp_item_decoder.h"
+#include "net/bgp_af.h"
+#include "schema/xmpp_enet_types.h"
+#include "schema/xmpp_unicast_types.h"
+#include "testing/gunit.h"
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+using pugi::xml_document;
+using pugi::xml_node;
+
+class XmppItemDecoderTest : public ::testing::Test {
+protected:
+    static const int kRepeatCount = 4096;
+
+    virtual void SetUp() {
+        srand(1);
+    }
+
+    static string RandomString(const char *prefix) {
+        ostringstream oss;
+        oss << prefix << rand() % 1000;
+        return oss.str();
+    }
+
+    static void RandomInetNextHop(autogen::NextHopType *nh) {
+        nh->af = BgpAf::IPv4;
+        nh->address = RandomString("10.1.1.");
+        nh->label = rand() % 1000000;
+        nh->vni = rand() % 2 ? rand() % 100000 : 0;
+        nh->mac = rand() % 2 ? RandomString("00:01:02:03:04:") : "";
+        nh->virtual_network = RandomString("vn");
+        vector<string> &encaps =
+            nh->tunnel_encapsulation_list.tunnel_encapsulation;
+        encaps.push_back("gre");
+        if (rand() % 2)
+            encaps.push_back("udp");
+        for (int idx = rand() % 3; idx > 0; --idx) {
+            nh->tag_list.tag.push_back(rand());
+        }
+    }
+
+    static void RandomInetItem(autogen::ItemType *item) {
+        item->Clear();
+        bool inet6 = rand() % 2;
+        item->entry.nlri.af = inet6 ? BgpAf::IPv6 : BgpAf::IPv4;
+        item->entry.nlri.safi = BgpAf::Unicast;
+        item->entry.nlri.address = inet6 ?
+            RandomString("2001:db8::") + "/128" :
+            RandomString("192.168.1.") + "/32";
+        for (int idx = rand() % 3 + 1; idx > 0; --idx) {
+            autogen::NextHopType nh;
+            nh.Clear();
+            RandomInetNextHop(&nh);
+            item->entry.next_hops.next_hop.push_back(nh);
+        }
+        item->entry.version = 1;
+        item->entry.virtual_network = RandomString("default:vn");
+        item->entry.sequence_number = rand() % 100;
+        item->entry.mobility.seqno = item->entry.sequence_number;
+        item->entry.mobility.sticky = rand() % 2;
+        for (int idx = rand() % 3; idx > 0; --idx) {
+            item->entry.security_group_list.security_group.push_back(
+                rand() % 100000);
+        }
+        for (int idx = rand() % 3; idx > 0; --idx) {
+            item->entry.community_tag_list.community_tag.push_back(
+                RandomString("no-reoriginate-"));
+        }
+        item->entry.local_preference = rand() % 200;
+        item->entry.med = rand() % 200;
+        if (rand() % 2)
+            item->entry.sub_protocol = "interface";
+    }
+
+    static void RandomEnetItem(autogen::EnetItemType *item) {
+        item->Clear();
+        item->entry.nlri.af = BgpAf::L2Vpn;
+        item->entry.nlri.safi = BgpAf::Enet;
+        item->entry.nlri.ethernet_tag = rand() % 4096;
+        item->entry.nlri.mac = RandomString("00:01:02:03:04:");
+        item->entry.nlri.address = RandomString("10.1.1.") + "/32";
+        for (int idx = rand() % 3 + 1; idx > 0; --idx) {
+            autogen::EnetNextHopType nh;
+            nh.Clear();
+            nh.af = BgpAf::IPv4;
+            nh.address = RandomString("10.1.1.");
+            nh.label = rand() % 1000000;
+            nh.l3_label = rand() % 1000000;
+            nh.tunnel_encapsulation_list.tunnel_encapsulation.push_back(
+                rand() % 2 ? "vxlan" : "gre");
+            item->entry.next_hops.next_hop.push_back(nh);
+        }
+        item->entry.version = 1;
+        item->entry.virtual_network = RandomString("default:vn");
+        item->entry.sequence_number = rand() % 100;
+        item->entry.mobility.seqno = item->entry.sequence_number;
+        item->entry.mobility.sticky = rand() % 2;
+        for (int idx = rand() % 3; idx > 0; --idx) {
+            item->entry.security_group_list.security_group.push_back(
+                rand() % 100000);
+        }
+        item->entry.local_preference = rand() % 200;
+        item->entry.med = rand() % 200;
+        item->entry.etree_leaf = rand() % 2;
+    }
+
+    // Collect all elements under node, in document order
+    static void CollectElements(xml_node node, vector<xml_node> *list) {
+        for (xml_node child = node.first_child(); child;
+             child = child.next_sibling()) {
+            if (child.type() != pugi::node_element)
+                continue;
+            list->push_back(child);
+            CollectElements(child, list);
+        }
+    }
+
+    // Apply one random change of the kind a broken or foreign encoder
+    // could produce.
+    static void Mutate(xml_node item) {
+        vector<xml_node> elements;
+        CollectElements(item, &elements);
+        if (elements.empty())
+            return;
+        xml_node node = elements[rand() % elements.size()];
+        xml_node text = node.first_child();
+        bool leaf = text && text.type() == pugi::node_pcdata;
+        static const char *values[] = {
+            "", " 7", "7 ", "-1", "+1", "0x10", "1.5", "99999999999",
+            "true", "false", "TRUE", "abc", "4294967295",
+        };
+
+        switch (rand() % 7) {
+        case 0:
+            node.parent().remove_child(node);
+            break;
+        case 1:
+            node.parent().insert_copy_after(node, node);
+            break;
+        case 2:
+            node.parent().append_child("unknown").text().set("1");
+            break;
+        case 3:
+            node.append_attribute("unknown") = "1";
+            break;
+        case 4:
+            if (leaf) {
+                text.set_value(values[rand() % (sizeof(values) /
+                                                sizeof(values[0]))]);
+            } else {
+                node.append_child(pugi::node_pcdata).set_value("1");
+            }
+            break;
+        case 5:
+            if (leaf) {
+                string value(" ");
+                value += text.value();
+                text.set_value(value.c_str());
+            } else {
+                node.append_child(pugi::node_comment).set_value("1");
+            }
+            break;
+        case 6:
+            node.set_name("next-hop");
+            break;
+        }
+    }
+
+    template <typename T>
+    static string Print(const T &item) {
+        xml_document doc;
+        xml_node node = doc.append_child("item");
+        item.Encode(&node);
+        ostringstream oss;
+        doc.print(oss, "", pugi::format_raw);
+        return oss.str();
+    }
+
+    // Whenever the decoder accepts the item, XmlParse must accept it too
+    // and give the same result.
+    template <typename T>
+    void Verify(const xml_node &node, T *decoded, int *accepted) {
+        bool ok = XmppItemDecoder::Decode(node, decoded);
+        T parsed;
+        parsed.Clear();
+        bool parse_ok = parsed.XmlParse(node);
+        if (!ok)
+            return;
+        (*accepted)++;
+        EXPECT_TRUE(parse_ok);
+        EXPECT_EQ(Print(parsed), Print(*decoded));
+    }
+
+    template <typename T>
+    void Fuzz(void (*random_item)(T *)) {
+        T item, decoded;
+        int accepted = 0;
+        for (int idx = 0; idx < kRepeatCount; ++idx) {
+            random_item(&item);
+            xml_document doc;
+            xml_node node = doc.append_child("item");
+            node.append_attribute("id") = "1";
+            item.Encode(&node);
+
+            // The agent encoding is always accepted.
+            EXPECT_TRUE(XmppItemDecoder::Decode(node, &decoded));
+            EXPECT_EQ(Print(item), Print(decoded));
+
+            for (int count = rand() % 3 + 1; count > 0; --count) {
+                Mutate(node);
+            }
+            Verify(node, &decoded, &accepted);
+        }
+        // Some changes, e.g. removing an element, keep the encoding
+        // canonical.
+        EXPECT_NE(0, accepted);
+    }
+};
+
+TEST_F(XmppItemDecoderTest, Inet) {
+    Fuzz(&RandomInetItem);
+}
+
+TEST_F(XmppItemDecoderTest, Enet) {
+    Fuzz(&RandomEnetItem);
+}
+
+// Anything but a single entry is left to XmlParse.
+TEST_F(XmppItemDecoderTest, NoEntry) {
+    xml_document doc;
+    xml_node node = doc.append_child("item");
+    autogen::ItemType item;
+    EXPECT_FALSE(XmppItemDecoder::Decode(node, &item));
+    node.append_child("entry");
+    EXPECT_TRUE(XmppItemDecoder::Decode(node, &item));
+    node.append_child("entry");
+    EXPECT_FALSE(XmppItemDecoder::Decode(node, &item));
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
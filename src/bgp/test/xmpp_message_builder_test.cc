@@ -4,10 +4,12 @@
 
 #include <pugixml/pugixml.hpp>
 
+#include "base/time_util.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_ribout_updates.h"
 #include "bgp/xmpp_message_builder.h"
+#include "bgp/evpn/evpn_route.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/mvpn/mvpn_route.h"
 #include "bgp/security_group/security_group.h"
@@ -132,6 +134,34 @@ protected:
         return false;
     }
 
+    // Build a message for all the routes and return the data sent to a peer
+    string BuildMessage(const vector<RibOutAttr *> &roattrs,
+                        bool item_template) {
+        static_cast<BgpXmppMessage *>(message_)->set_item_template_enabled(
+            item_template);
+        message_->Start(ribout_, false, roattrs[0], routes_[0]);
+        for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+            message_->AddRoute(routes_[ridx], roattrs[ridx]);
+        }
+        message_->Finish();
+        XmppTestPeer peer("agent.juniper.net");
+        size_t msgsize;
+        const string *msg_str = NULL;
+        string temp;
+        const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str,
+                                               &temp);
+        return string(reinterpret_cast<const char *>(msg), msgsize);
+    }
+
+    // Attributes shared by groups of routes, the way the update queue
+    // hands them to the message
+    void AllocSharedAttrs(vector<RibOutAttr *> *roattrs, int group_size) {
+        for (int idx = 0;  idx < kRouteCount; ++idx) {
+            roattrs->push_back(new RibOutAttr(table_, attr_.get(),
+                100 + idx / group_size, 0, true));
+        }
+    }
+
     virtual void TearDown() {
         STLDeleteValues(&roattrs_);
         STLDeleteValues(&routes_);
@@ -154,6 +184,109 @@ protected:
     vector<RibOutAttr *> roattrs_;
 };
 
+class XmppEvpnMessageBuilderTest : public ::testing::Test {
+protected:
+    static const int kRouteCount = 32;
+
+    XmppEvpnMessageBuilderTest()
+        : thread_(&evm_), message_(NULL), table_(NULL), ribout_(NULL) {
+    }
+
+    virtual void SetUp() {
+        bs_x_.reset(new BgpServerTest(&evm_, "X"));
+        thread_.Start();
+        bs_x_->Configure(config);
+        task_util::WaitForIdle();
+
+        TASK_UTIL_EXPECT_TRUE(
+            bs_x_->database()->FindTable("blue.evpn.0") != NULL);
+        table_ = static_cast<BgpTable *>(
+            bs_x_->database()->FindTable("blue.evpn.0"));
+        ribout_ = table_->RibOutLocate(bs_x_->update_sender(),
+            RibExportPolicy(BgpProto::XMPP, RibExportPolicy::XMPP, -1, 0));
+        message_ = ribout_->updates(0)->GetMessage();
+
+        attr_[0] = LocateAttr(0x123);
+        attr_[1] = LocateAttr(0x456);
+
+        // Every third route has other attributes, the ethernet tag changes
+        // after it
+        for (int idx = 0;  idx < kRouteCount; ++idx) {
+            char prefix_str[64];
+            snprintf(prefix_str, sizeof(prefix_str),
+                     "2-10.1.1.1:65535-%d-11:12:13:14:15:%02x,0.0.0.0",
+                     idx / 3, idx);
+            EvpnRoute *route =
+                new EvpnRoute(EvpnPrefix::FromString(prefix_str));
+            routes_.push_back(route);
+        }
+        AllocAttrs(&roattrs_);
+    }
+
+    BgpAttrPtr LocateAttr(uint32_t sgid) {
+        BgpAttrNextHop nexthop(0x0a0a0a0a);
+        BgpAttrSpec spec;
+        spec.push_back(&nexthop);
+
+        SecurityGroup sg(0, sgid);
+        SecurityGroup4ByteAs sg4(90000, 0);
+        ExtCommunitySpec extcomm;
+        extcomm.communities.push_back(
+                get_value(sg.GetExtCommunity().begin(), 8));
+        extcomm.communities.push_back(
+                get_value(sg4.GetExtCommunity().begin(), 8));
+        spec.push_back(&extcomm);
+        return bs_x_->attr_db()->Locate(spec);
+    }
+
+    void AllocAttrs(vector<RibOutAttr *> *roattrs) {
+        for (int idx = 0;  idx < kRouteCount; ++idx) {
+            roattrs->push_back(new RibOutAttr(table_,
+                attr_[idx % 3 == 1].get(), 100, 0, true));
+        }
+    }
+
+    // Build a message for all the routes and return the data sent to a peer
+    string BuildMessage(const vector<RibOutAttr *> &roattrs,
+                        bool item_template, bool cache_routes) {
+        static_cast<BgpXmppMessage *>(message_)->set_item_template_enabled(
+            item_template);
+        message_->Start(ribout_, cache_routes, roattrs[0], routes_[0]);
+        for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+            message_->AddRoute(routes_[ridx], roattrs[ridx]);
+        }
+        message_->Finish();
+        XmppTestPeer peer("agent.juniper.net");
+        size_t msgsize;
+        const string *msg_str = NULL;
+        string temp;
+        const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str,
+                                               &temp);
+        return string(reinterpret_cast<const char *>(msg), msgsize);
+    }
+
+    virtual void TearDown() {
+        STLDeleteValues(&roattrs_);
+        STLDeleteValues(&routes_);
+        table_->RibOutDelete(
+            RibExportPolicy(BgpProto::XMPP, RibExportPolicy::XMPP, -1, 0));
+        bs_x_->Shutdown();
+        evm_.Shutdown();
+        thread_.Join();
+        task_util::WaitForIdle();
+    }
+
+    EventManager evm_;
+    ServerThread thread_;
+    BgpServerTestPtr bs_x_;
+    Message *message_;
+    BgpTable *table_;
+    RibOut *ribout_;
+    BgpAttrPtr attr_[2];
+    vector<EvpnRoute *> routes_;
+    vector<RibOutAttr *> roattrs_;
+};
+
 class XmppMvpnMessageBuilderTest : public ::testing::Test {
 protected:
     static const int kRepeatCount = 1024;
@@ -198,6 +331,34 @@ protected:
         }
     }
 
+    // Build a message for all the routes and return the data sent to a peer
+    string BuildMessage(const vector<RibOutAttr *> &roattrs,
+                        bool item_template) {
+        static_cast<BgpXmppMessage *>(message_)->set_item_template_enabled(
+            item_template);
+        message_->Start(ribout_, false, roattrs[0], routes_[0]);
+        for (int ridx = 1; ridx < kRouteCount; ++ridx) {
+            message_->AddRoute(routes_[ridx], roattrs[ridx]);
+        }
+        message_->Finish();
+        XmppTestPeer peer("agent.juniper.net");
+        size_t msgsize;
+        const string *msg_str = NULL;
+        string temp;
+        const uint8_t *msg = message_->GetData(&peer, &msgsize, &msg_str,
+                                               &temp);
+        return string(reinterpret_cast<const char *>(msg), msgsize);
+    }
+
+    // Attributes shared by groups of routes, the way the update queue
+    // hands them to the message
+    void AllocSharedAttrs(vector<RibOutAttr *> *roattrs, int group_size) {
+        for (int idx = 0;  idx < kRouteCount; ++idx) {
+            roattrs->push_back(new RibOutAttr(table_, attr_.get(),
+                100 + idx / group_size, 0, true));
+        }
+    }
+
     virtual void TearDown() {
         STLDeleteValues(&roattrs_);
         STLDeleteValues(&routes_);
@@ -302,6 +463,70 @@ TEST_P(XmppMvpnMessageBuilderParamTest, Basic) {
     }
 }
 
+// Items emitted from the template match the ones rendered through the DOM
+TEST_F(XmppMessageBuilderTest, ItemTemplate) {
+    EXPECT_EQ(BuildMessage(roattrs_, false), BuildMessage(roattrs_, true));
+    for (int group_size = 1; group_size <= kRouteCount; group_size *= 4) {
+        vector<RibOutAttr *> roattrs;
+        AllocSharedAttrs(&roattrs, group_size);
+        string expected = BuildMessage(roattrs, false);
+        EXPECT_EQ(expected, BuildMessage(roattrs, true));
+        EXPECT_TRUE(VerifySG(reinterpret_cast<const uint8_t *>(
+            expected.data()), expected.size(), 0x123));
+        STLDeleteValues(&roattrs);
+    }
+}
+
+TEST_F(XmppMvpnMessageBuilderTest, ItemTemplate) {
+    EXPECT_EQ(BuildMessage(roattrs_, false), BuildMessage(roattrs_, true));
+    for (int group_size = 1; group_size <= kRouteCount; group_size *= 4) {
+        vector<RibOutAttr *> roattrs;
+        AllocSharedAttrs(&roattrs, group_size);
+        EXPECT_EQ(BuildMessage(roattrs, false), BuildMessage(roattrs, true));
+        STLDeleteValues(&roattrs);
+    }
+}
+
+TEST_F(XmppEvpnMessageBuilderTest, ItemTemplate) {
+    EXPECT_EQ(BuildMessage(roattrs_, false, false),
+              BuildMessage(roattrs_, true, false));
+}
+
+// A route sent from its cached repr does not go through the template. The
+// community state of the routes after it must still be their own.
+TEST_F(XmppEvpnMessageBuilderTest, ItemTemplateCachedRoute) {
+    string expected = BuildMessage(roattrs_, false, false);
+
+    vector<RibOutAttr *> roattrs;
+    AllocAttrs(&roattrs);
+    for (int idx = 1; idx < kRouteCount; idx += 3) {
+        message_->Start(ribout_, true, roattrs[idx], routes_[idx]);
+        message_->Finish();
+        EXPECT_FALSE(roattrs[idx]->repr().empty());
+    }
+    EXPECT_EQ(expected, BuildMessage(roattrs, true, true));
+    STLDeleteValues(&roattrs);
+}
+
+// Time to build messages whose routes share the attributes, with and
+// without the item template
+TEST_F(XmppMessageBuilderTest, ItemTemplateBenchmark) {
+    vector<RibOutAttr *> roattrs;
+    AllocSharedAttrs(&roattrs, kRouteCount);
+    uint64_t usecs[2];
+    for (int item_template = 0; item_template < 2; ++item_template) {
+        uint64_t start = ClockMonotonicUsec();
+        for (int idx = 0; idx < kRepeatCount; ++idx) {
+            BuildMessage(roattrs, item_template);
+        }
+        usecs[item_template] = ClockMonotonicUsec() - start;
+    }
+    STLDeleteValues(&roattrs);
+
+    cout << kRepeatCount << " messages of " << kRouteCount << " routes: DOM "
+        << usecs[0] << " usec, template " << usecs[1] << " usec" << endl;
+}
+
 INSTANTIATE_TEST_CASE_P(ShortPeerName, XmppMvpnMessageBuilderParamTest,
     ::testing::Combine(
         ::testing::Values(false), ::testing::Bool(), ::testing::Bool()));
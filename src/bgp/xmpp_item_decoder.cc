@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_item_decoder.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "schema/xmpp_enet_types.h"
+#include "schema/xmpp_unicast_types.h"
+
+using pugi::xml_node;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Largest number of digits that fits any integer field
+const size_t kMaxDigits = 9;
+
+//
+// Text of a leaf element. Returns NULL if the element has attributes or
+// anything other than a single text node.
+//
+const char *LeafText(const xml_node &node) {
+    if (node.first_attribute())
+        return NULL;
+    xml_node child = node.first_child();
+    if (!child)
+        return "";
+    if (child.type() != pugi::node_pcdata || child.next_sibling())
+        return NULL;
+    return child.value();
+}
+
+bool DecodeValue(const xml_node &node, string *value) {
+    const char *text = LeafText(node);
+    if (!text)
+        return false;
+    size_t len = strlen(text);
+    if (len && (isspace(static_cast<unsigned char>(text[0])) ||
+                isspace(static_cast<unsigned char>(text[len - 1]))))
+        return false;
+    value->assign(text, len);
+    return true;
+}
+
+bool DecodeValue(const xml_node &node, bool *value) {
+    const char *text = LeafText(node);
+    if (!text)
+        return false;
+    if (strcmp(text, "true") == 0) {
+        *value = true;
+    } else if (strcmp(text, "false") == 0) {
+        *value = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool DecodeValue(const xml_node &node, T *value) {
+    const char *text = LeafText(node);
+    if (!text || !text[0])
+        return false;
+    int result = 0;
+    for (size_t idx = 0; text[idx]; ++idx) {
+        if (idx == kMaxDigits ||
+            !isdigit(static_cast<unsigned char>(text[idx]))) {
+            return false;
+        }
+        result = result * 10 + (text[idx] - '0');
+    }
+    *value = result;
+    return true;
+}
+
+// Mark field as decoded. Returns false if it already was.
+bool FirstTime(int field, uint32_t *seen) {
+    if (*seen & (1 << field))
+        return false;
+    *seen |= (1 << field);
+    return true;
+}
+
+template <typename T>
+bool DecodeScalar(const xml_node &node, int field, uint32_t *seen,
+                  T *value) {
+    return FirstTime(field, seen) && DecodeValue(node, value);
+}
+
+// List of leaf elements named name
+template <typename T>
+bool DecodeLeafList(const xml_node &node, int field, uint32_t *seen,
+                    const char *name, vector<T> *list) {
+    if (!FirstTime(field, seen) || node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        if (child.type() != pugi::node_element ||
+            strcmp(child.name(), name) != 0) {
+            return false;
+        }
+        list->push_back(T());
+        if (!DecodeValue(child, &list->back()))
+            return false;
+    }
+    return true;
+}
+
+// Element decoded by the autogen type, e.g. mobility and load-balance
+template <typename T>
+bool DecodeComplex(const xml_node &node, int field, uint32_t *seen,
+                   T *value) {
+    return FirstTime(field, seen) && value->XmlParse(node);
+}
+
+// List element that agents always send empty, e.g. olist
+bool DecodeEmpty(const xml_node &node, int field, uint32_t *seen) {
+    return FirstTime(field, seen) && !node.first_attribute() &&
+        !node.first_child();
+}
+
+template <typename T>
+bool DecodeInetNlri(const xml_node &node, T *nlri) {
+    enum { AF, SAFI, ADDRESS };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "af") == 0) {
+            ok = DecodeScalar(child, AF, &seen, &nlri->af);
+        } else if (strcmp(name, "safi") == 0) {
+            ok = DecodeScalar(child, SAFI, &seen, &nlri->safi);
+        } else if (strcmp(name, "address") == 0) {
+            ok = DecodeScalar(child, ADDRESS, &seen, &nlri->address);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool DecodeInetNextHop(const xml_node &node, autogen::NextHopType *nh) {
+    enum { AF, ADDRESS, LABEL, VNI, MAC, VIRTUAL_NETWORK, ENCAP, TAG };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "af") == 0) {
+            ok = DecodeScalar(child, AF, &seen, &nh->af);
+        } else if (strcmp(name, "address") == 0) {
+            ok = DecodeScalar(child, ADDRESS, &seen, &nh->address);
+        } else if (strcmp(name, "label") == 0) {
+            ok = DecodeScalar(child, LABEL, &seen, &nh->label);
+        } else if (strcmp(name, "vni") == 0) {
+            ok = DecodeScalar(child, VNI, &seen, &nh->vni);
+        } else if (strcmp(name, "mac") == 0) {
+            ok = DecodeScalar(child, MAC, &seen, &nh->mac);
+        } else if (strcmp(name, "virtual-network") == 0) {
+            ok = DecodeScalar(child, VIRTUAL_NETWORK, &seen,
+                              &nh->virtual_network);
+        } else if (strcmp(name, "tunnel-encapsulation-list") == 0) {
+            ok = DecodeLeafList(child, ENCAP, &seen, "tunnel-encapsulation",
+                &nh->tunnel_encapsulation_list.tunnel_encapsulation);
+        } else if (strcmp(name, "tag-list") == 0) {
+            ok = DecodeLeafList(child, TAG, &seen, "tag", &nh->tag_list.tag);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+bool DecodeEnetNextHop(const xml_node &node, autogen::EnetNextHopType *nh) {
+    enum { AF, ADDRESS, LABEL, L3_LABEL, MAC, ENCAP, TAG };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "af") == 0) {
+            ok = DecodeScalar(child, AF, &seen, &nh->af);
+        } else if (strcmp(name, "address") == 0) {
+            ok = DecodeScalar(child, ADDRESS, &seen, &nh->address);
+        } else if (strcmp(name, "label") == 0) {
+            ok = DecodeScalar(child, LABEL, &seen, &nh->label);
+        } else if (strcmp(name, "l3-label") == 0) {
+            ok = DecodeScalar(child, L3_LABEL, &seen, &nh->l3_label);
+        } else if (strcmp(name, "mac") == 0) {
+            ok = DecodeScalar(child, MAC, &seen, &nh->mac);
+        } else if (strcmp(name, "tunnel-encapsulation-list") == 0) {
+            ok = DecodeLeafList(child, ENCAP, &seen, "tunnel-encapsulation",
+                &nh->tunnel_encapsulation_list.tunnel_encapsulation);
+        } else if (strcmp(name, "tag-list") == 0) {
+            ok = DecodeLeafList(child, TAG, &seen, "tag", &nh->tag_list.tag);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+// The next-hops element, with the decoder for a next-hop
+template <typename T>
+bool DecodeNextHops(const xml_node &node, int field, uint32_t *seen,
+                    vector<T> *list,
+                    bool (*decode)(const xml_node &, T *)) {
+    if (!FirstTime(field, seen) || node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        if (child.type() != pugi::node_element ||
+            strcmp(child.name(), "next-hop") != 0) {
+            return false;
+        }
+        list->push_back(T());
+        list->back().Clear();
+        if (!decode(child, &list->back()))
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool DecodeInetEntry(const xml_node &node, T *entry) {
+    enum {
+        NLRI, NEXT_HOPS, VERSION, VIRTUAL_NETWORK, MOBILITY, SEQUENCE_NUMBER,
+        SECURITY_GROUP, COMMUNITY_TAG, LOCAL_PREFERENCE, MED, LOAD_BALANCE,
+        SUB_PROTOCOL
+    };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "nlri") == 0) {
+            ok = FirstTime(NLRI, &seen) && DecodeInetNlri(child, &entry->nlri);
+        } else if (strcmp(name, "next-hops") == 0) {
+            ok = DecodeNextHops(child, NEXT_HOPS, &seen,
+                &entry->next_hops.next_hop, &DecodeInetNextHop);
+        } else if (strcmp(name, "version") == 0) {
+            ok = DecodeScalar(child, VERSION, &seen, &entry->version);
+        } else if (strcmp(name, "virtual-network") == 0) {
+            ok = DecodeScalar(child, VIRTUAL_NETWORK, &seen,
+                              &entry->virtual_network);
+        } else if (strcmp(name, "mobility") == 0) {
+            ok = DecodeComplex(child, MOBILITY, &seen, &entry->mobility);
+        } else if (strcmp(name, "sequence-number") == 0) {
+            ok = DecodeScalar(child, SEQUENCE_NUMBER, &seen,
+                              &entry->sequence_number);
+        } else if (strcmp(name, "security-group-list") == 0) {
+            ok = DecodeLeafList(child, SECURITY_GROUP, &seen,
+                "security-group",
+                &entry->security_group_list.security_group);
+        } else if (strcmp(name, "community-tag-list") == 0) {
+            ok = DecodeLeafList(child, COMMUNITY_TAG, &seen, "community-tag",
+                &entry->community_tag_list.community_tag);
+        } else if (strcmp(name, "local-preference") == 0) {
+            ok = DecodeScalar(child, LOCAL_PREFERENCE, &seen,
+                              &entry->local_preference);
+        } else if (strcmp(name, "med") == 0) {
+            ok = DecodeScalar(child, MED, &seen, &entry->med);
+        } else if (strcmp(name, "load-balance") == 0) {
+            ok = DecodeComplex(child, LOAD_BALANCE, &seen,
+                               &entry->load_balance);
+        } else if (strcmp(name, "sub-protocol") == 0) {
+            ok = DecodeScalar(child, SUB_PROTOCOL, &seen,
+                              &entry->sub_protocol);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool DecodeEnetNlri(const xml_node &node, T *nlri) {
+    enum { AF, SAFI, ETHERNET_TAG, MAC, ADDRESS, SOURCE, GROUP, FLAGS };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "af") == 0) {
+            ok = DecodeScalar(child, AF, &seen, &nlri->af);
+        } else if (strcmp(name, "safi") == 0) {
+            ok = DecodeScalar(child, SAFI, &seen, &nlri->safi);
+        } else if (strcmp(name, "ethernet-tag") == 0) {
+            ok = DecodeScalar(child, ETHERNET_TAG, &seen,
+                              &nlri->ethernet_tag);
+        } else if (strcmp(name, "mac") == 0) {
+            ok = DecodeScalar(child, MAC, &seen, &nlri->mac);
+        } else if (strcmp(name, "address") == 0) {
+            ok = DecodeScalar(child, ADDRESS, &seen, &nlri->address);
+        } else if (strcmp(name, "source") == 0) {
+            ok = DecodeScalar(child, SOURCE, &seen, &nlri->source);
+        } else if (strcmp(name, "group") == 0) {
+            ok = DecodeScalar(child, GROUP, &seen, &nlri->group);
+        } else if (strcmp(name, "flags") == 0) {
+            ok = DecodeScalar(child, FLAGS, &seen, &nlri->flags);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool DecodeEnetEntry(const xml_node &node, T *entry) {
+    enum {
+        NLRI, NEXT_HOPS, VERSION, VIRTUAL_NETWORK, MOBILITY, SEQUENCE_NUMBER,
+        SECURITY_GROUP, LOCAL_PREFERENCE, MED, ETREE_LEAF, REPLICATOR_ADDRESS,
+        ASSISTED_REPLICATION, EDGE_REPLICATION, OLIST, LEAF_OLIST
+    };
+    uint32_t seen = 0;
+    if (node.first_attribute())
+        return false;
+    for (xml_node child = node.first_child(); child;
+         child = child.next_sibling()) {
+        const char *name = child.name();
+        bool ok;
+        if (strcmp(name, "nlri") == 0) {
+            ok = FirstTime(NLRI, &seen) && DecodeEnetNlri(child, &entry->nlri);
+        } else if (strcmp(name, "next-hops") == 0) {
+            ok = DecodeNextHops(child, NEXT_HOPS, &seen,
+                &entry->next_hops.next_hop, &DecodeEnetNextHop);
+        } else if (strcmp(name, "version") == 0) {
+            ok = DecodeScalar(child, VERSION, &seen, &entry->version);
+        } else if (strcmp(name, "virtual-network") == 0) {
+            ok = DecodeScalar(child, VIRTUAL_NETWORK, &seen,
+                              &entry->virtual_network);
+        } else if (strcmp(name, "mobility") == 0) {
+            ok = DecodeComplex(child, MOBILITY, &seen, &entry->mobility);
+        } else if (strcmp(name, "sequence-number") == 0) {
+            ok = DecodeScalar(child, SEQUENCE_NUMBER, &seen,
+                              &entry->sequence_number);
+        } else if (strcmp(name, "security-group-list") == 0) {
+            ok = DecodeLeafList(child, SECURITY_GROUP, &seen,
+                "security-group",
+                &entry->security_group_list.security_group);
+        } else if (strcmp(name, "local-preference") == 0) {
+            ok = DecodeScalar(child, LOCAL_PREFERENCE, &seen,
+                              &entry->local_preference);
+        } else if (strcmp(name, "med") == 0) {
+            ok = DecodeScalar(child, MED, &seen, &entry->med);
+        } else if (strcmp(name, "etree-leaf") == 0) {
+            ok = DecodeScalar(child, ETREE_LEAF, &seen, &entry->etree_leaf);
+        } else if (strcmp(name, "replicator-address") == 0) {
+            ok = DecodeScalar(child, REPLICATOR_ADDRESS, &seen,
+                              &entry->replicator_address);
+        } else if (strcmp(name, "assisted-replication-supported") == 0) {
+            ok = DecodeScalar(child, ASSISTED_REPLICATION, &seen,
+                              &entry->assisted_replication_supported);
+        } else if (strcmp(name, "edge-replication-not-supported") == 0) {
+            ok = DecodeScalar(child, EDGE_REPLICATION, &seen,
+                              &entry->edge_replication_not_supported);
+        } else if (strcmp(name, "olist") == 0) {
+            ok = DecodeEmpty(child, OLIST, &seen);
+        } else if (strcmp(name, "leaf-olist") == 0) {
+            ok = DecodeEmpty(child, LEAF_OLIST, &seen);
+        } else {
+            ok = false;
+        }
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+// The entry element of an item
+bool IsEntry(const xml_node &node) {
+    return node.type() == pugi::node_element &&
+        strcmp(node.name(), "entry") == 0;
+}
+
+}  // namespace
+
+bool XmppItemDecoder::Decode(const xml_node &node, autogen::ItemType *item) {
+    item->Clear();
+    xml_node entry = node.first_child();
+    if (!entry || !IsEntry(entry) || entry.next_sibling())
+        return false;
+    return DecodeInetEntry(entry, &item->entry);
+}
+
+bool XmppItemDecoder::Decode(const xml_node &node,
+                             autogen::EnetItemType *item) {
+    item->Clear();
+    xml_node entry = node.first_child();
+    if (!entry || !IsEntry(entry) || entry.next_sibling())
+        return false;
+    return DecodeEnetEntry(entry, &item->entry);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_XMPP_ITEM_DECODER_H_
+#define SRC_BGP_XMPP_ITEM_DECODER_H_
+
+#include <pugixml/pugixml.hpp>
+
+namespace autogen {
+class ItemType;
+class EnetItemType;
+}
+
+//
+// Single pass decode of the inet, inet6 and enet route items published by
+// agents, as an alternative to the generic autogen XmlParse.
+//
+// Only the encoding produced by the autogen Encode on the agent is accepted:
+// known elements, each scalar element at most once, decimal integers without
+// sign or spaces and booleans spelt true or false. Decode returns false for
+// anything else and the caller falls back to XmlParse, which decides whether
+// the item is valid. When Decode returns true, the item holds the same values
+// as after Clear and XmlParse.
+//
+// The item is cleared by Decode. Callers keep one item and pass it for every
+// route so that the strings and vectors in it keep their storage.
+//
+// This only replaces XmlParse. The channel still builds the BgpAttrSpec and
+// the route request from the decoded item as before.
+//
+class XmppItemDecoder {
+public:
+    static bool Decode(const pugi::xml_node &node, autogen::ItemType *item);
+    static bool Decode(const pugi::xml_node &node,
+                       autogen::EnetItemType *item);
+
+private:
+    XmppItemDecoder();
+};
+
+#endif  // SRC_BGP_XMPP_ITEM_DECODER_H_
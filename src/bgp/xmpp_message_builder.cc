@@ -7,6 +7,8 @@
 #include <boost/foreach.hpp>
 
 #include <algorithm>
+#include <cstring>
+#include <utility>
 
 #include "bgp/ipeer.h"
 #include "bgp/bgp_server.h"
@@ -73,6 +75,112 @@ static inline const char *XmppSafiName(uint8_t safi) {
     return NULL;
 }
 
+//
+// Return true if pugi writes the value unchanged in text and attributes.
+//
+static inline bool IsPlainXmlText(const string &value) {
+    for (string::const_iterator it = value.begin(); it != value.end(); ++it) {
+        if (*it == '&' || *it == '<' || *it == '>' || *it == '"' ||
+            *it == '\'' || static_cast<unsigned char>(*it) < 0x20) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BgpXmppMessage::ItemTemplate::ItemTemplate()
+    : valid_(false), usable_(false), key_(0) {
+}
+
+const char *BgpXmppMessage::ItemTemplate::Marker(size_t index) {
+    static const char *markers[kMaxItemFields] = {
+        "@@xmpp-item-field-0@@",
+        "@@xmpp-item-field-1@@",
+        "@@xmpp-item-field-2@@",
+        "@@xmpp-item-field-3@@",
+        "@@xmpp-item-field-4@@",
+    };
+    assert(index < kMaxItemFields);
+    return markers[index];
+}
+
+//
+// Compare the fields used to build an item. RibOutAttr::operator== is not
+// used as it compares the label of one side with the nexthop label of the
+// other. Nexthop lists are interned, so equal lists are the same object.
+//
+bool BgpXmppMessage::ItemTemplate::SameAttr(const RibOutAttr *roattr) const {
+    return valid_ &&
+        roattr_.attr() == roattr->attr() &&
+        &roattr_.nexthop_list() == &roattr->nexthop_list() &&
+        roattr_.label() == roattr->label() &&
+        roattr_.l3_label() == roattr->l3_label() &&
+        roattr_.source_address() == roattr->source_address() &&
+        roattr_.vrf_originated() == roattr->vrf_originated();
+}
+
+bool BgpXmppMessage::ItemTemplate::Matches(const RibOutAttr *roattr,
+                                           uint32_t key) const {
+    return key_ == key && SameAttr(roattr);
+}
+
+//
+// Split the item rendered with markers in place of the fields. The template
+// is not usable if a marker is missing or repeated, the caller then renders
+// every item through the DOM.
+//
+void BgpXmppMessage::ItemTemplate::Build(const RibOutAttr *roattr,
+                                         uint32_t key, const string &xml,
+                                         size_t field_count) {
+    Clear();
+    valid_ = true;
+    key_ = key;
+    roattr_ = *roattr;
+
+    vector<std::pair<size_t, size_t> > positions;
+    for (size_t idx = 0; idx < field_count; ++idx) {
+        const char *marker = Marker(idx);
+        size_t pos = xml.find(marker);
+        if (pos == string::npos ||
+            xml.find(marker, pos + 1) != string::npos) {
+            return;
+        }
+        positions.push_back(std::make_pair(pos, idx));
+    }
+    std::sort(positions.begin(), positions.end());
+
+    size_t start = 0;
+    for (size_t idx = 0; idx < positions.size(); ++idx) {
+        fragments_.push_back(
+            xml.substr(start, positions[idx].first - start));
+        field_order_.push_back(positions[idx].second);
+        start = positions[idx].first + strlen(Marker(positions[idx].second));
+    }
+    fragments_.push_back(xml.substr(start));
+    usable_ = true;
+}
+
+bool BgpXmppMessage::ItemTemplate::Emit(const vector<string> &fields,
+                                        string *repr) const {
+    if (!usable_)
+        return false;
+    for (size_t idx = 0; idx < field_order_.size(); ++idx) {
+        *repr += fragments_[idx];
+        *repr += fields[field_order_[idx]];
+    }
+    *repr += fragments_.back();
+    return true;
+}
+
+void BgpXmppMessage::ItemTemplate::Clear() {
+    valid_ = false;
+    usable_ = false;
+    key_ = 0;
+    roattr_.clear();
+    fragments_.clear();
+    field_order_.clear();
+}
+
 BgpXmppMessage::BgpXmppMessage()
     : table_(NULL),
       writer_(XmlWriter(&repr_)),
@@ -80,8 +188,10 @@ BgpXmppMessage::BgpXmppMessage()
       cache_routes_(false),
       repr_valid_(false),
       mobility_(0, false),
-      etree_leaf_(false) {
+      etree_leaf_(false),
+      item_template_enabled_(true) {
     msg_begin_.reserve(kMaxFromToLength);
+    item_fields_.reserve(kMaxItemFields);
 }
 
 BgpXmppMessage::~BgpXmppMessage() {
@@ -94,6 +204,8 @@ void BgpXmppMessage::Reset() {
     cache_routes_ = false;
     repr_valid_ = false;
     repr_.clear();
+    item_template_.Clear();
+    community_attr_.reset();
 }
 
 bool BgpXmppMessage::Start(const RibOut *ribout, bool cache_routes,
@@ -104,11 +216,8 @@ bool BgpXmppMessage::Start(const RibOut *ribout, bool cache_routes,
     cache_routes_ = cache_routes;
     Address::Family family = table_->family();
 
-    if (is_reachable_) {
-        const BgpAttr *attr = roattr->attr();
-        ProcessCommunity(attr->community());
-        ProcessExtCommunity(attr->ext_community());
-    }
+    if (is_reachable_)
+        ProcessAttr(roattr->attr());
 
     // Reserve space for the begin line that contains the message opening tag
     // with from and to attributes. Actual value gets patched in when GetData
@@ -140,7 +249,13 @@ bool BgpXmppMessage::Start(const RibOut *ribout, bool cache_routes,
     return true;
 }
 
+//
+// Release the template and the community state, they hold a reference to
+// the attributes of the last route in the message.
+//
 void BgpXmppMessage::Finish() {
+    item_template_.Clear();
+    community_attr_.reset();
 }
 
 bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -150,11 +265,8 @@ bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     if (!is_reachable_ && num_unreach_route_ >= kMaxUnreachCount)
         return false;
 
-    if (is_reachable_) {
-        const BgpAttr *attr = roattr->attr();
-        ProcessCommunity(attr->community());
-        ProcessExtCommunity(attr->ext_community());
-    }
+    if (is_reachable_)
+        ProcessAttr(roattr->attr());
 
     if (table_->family() == Address::ERMVPN) {
         return AddMcastRoute(route, roattr);
@@ -169,6 +281,36 @@ bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     }
 }
 
+//
+// Append the item for route to repr_, from the template if the route has the
+// same attributes and key as the previous one. The route fields must be set
+// in item_fields_.
+//
+void BgpXmppMessage::AddItem(const BgpRoute *route, const RibOutAttr *roattr,
+                             uint32_t key, EncodeItemFn encode) {
+    bool plain = item_template_enabled_;
+    for (size_t idx = 0; plain && idx < item_fields_.size(); ++idx) {
+        plain = IsPlainXmlText(item_fields_[idx]);
+    }
+    if (!plain) {
+        (this->*encode)(route, roattr, item_fields_);
+        return;
+    }
+
+    if (!item_template_.Matches(roattr, key)) {
+        vector<string> markers;
+        for (size_t idx = 0; idx < item_fields_.size(); ++idx) {
+            markers.push_back(ItemTemplate::Marker(idx));
+        }
+        size_t pos = repr_.size();
+        (this->*encode)(route, roattr, markers);
+        item_template_.Build(roattr, key, repr_.substr(pos), markers.size());
+        repr_.resize(pos);
+    }
+    if (!item_template_.Emit(item_fields_, &repr_))
+        (this->*encode)(route, roattr, item_fields_);
+}
+
 void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
                                    const RibOutAttr::NextHop &nexthop,
                                    autogen::ItemType *item) {
@@ -201,18 +343,15 @@ void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
     item->entry.next_hops.next_hop.push_back(item_nexthop);
 }
 
-void BgpXmppMessage::AddIpReach(const BgpRoute *route,
-                                const RibOutAttr *roattr) {
-    if (!roattr->repr().empty()) {
-        repr_ += roattr->repr();
-        return;
-    }
+void BgpXmppMessage::EncodeIpItem(const BgpRoute *route,
+                                  const RibOutAttr *roattr,
+                                  const vector<string> &fields) {
     Address::Family family = table_->family();
 
     autogen::ItemType item;
     item.entry.nlri.af = BgpAf::FamilyToAfi(family);
     item.entry.nlri.safi = BgpAf::FamilyToXmppSafi(family);
-    item.entry.nlri.address = route->ToString();
+    item.entry.nlri.address = fields[1];
     item.entry.version = 1;
     item.entry.virtual_network = GetVirtualNetwork(route, roattr);
     item.entry.local_preference = roattr->attr()->local_pref();
@@ -242,16 +381,28 @@ void BgpXmppMessage::AddIpReach(const BgpRoute *route,
     if (!load_balance_attribute_.IsDefault())
         load_balance_attribute_.Encode(&item.entry.load_balance);
 
-    xml_node node = doc_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-
-    // Remember the previous size.
     // Using remove_child instead of reset allows memory pages allocated for
     // the xml_document to be reused during the lifetime of the xml_document.
-    size_t pos = repr_.size();
+    xml_node node = doc_.append_child("item");
+    node.append_attribute("id") = fields[0].c_str();
     item.Encode(&node);
     doc_.print(writer_, "\t", pugi::format_default, pugi::encoding_auto, 3);
     doc_.remove_child(node);
+}
+
+void BgpXmppMessage::AddIpReach(const BgpRoute *route,
+                                const RibOutAttr *roattr) {
+    if (!roattr->repr().empty()) {
+        repr_ += roattr->repr();
+        return;
+    }
+
+    // Remember the previous size.
+    size_t pos = repr_.size();
+    item_fields_.clear();
+    item_fields_.push_back(route->ToXmppIdString());
+    item_fields_.push_back(route->ToString());
+    AddItem(route, roattr, 0, &BgpXmppMessage::EncodeIpItem);
 
     // Cache the substring starting at the previous size.
     if (cache_routes_)
@@ -310,27 +461,21 @@ void BgpXmppMessage::EncodeEnetNextHop(const BgpRoute *route,
     item->entry.next_hops.next_hop.push_back(item_nexthop);
 }
 
-void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
-                                  const RibOutAttr *roattr) {
-    if (!roattr->repr().empty()) {
-        repr_ += roattr->repr();
-        return;
-    }
+void BgpXmppMessage::EncodeEnetItem(const BgpRoute *route,
+                                    const RibOutAttr *roattr,
+                                    const vector<string> &fields) {
     Address::Family family = table_->family();
 
     autogen::EnetItemType item;
     item.entry.nlri.af = BgpAf::FamilyToAfi(family);
     item.entry.nlri.safi = BgpAf::FamilyToXmppSafi(family);
 
-    EvpnRoute *evpn_route =
-        static_cast<EvpnRoute *>(const_cast<BgpRoute *>(route));
-    const EvpnPrefix &evpn_prefix = evpn_route->GetPrefix();
-    item.entry.nlri.ethernet_tag = evpn_prefix.tag();
-    item.entry.nlri.mac = evpn_prefix.mac_addr().ToString();
-    item.entry.nlri.address = evpn_prefix.ip_address().to_string() + "/" +
-        integerToString(evpn_prefix.ip_address_length());
-    item.entry.nlri.source = evpn_prefix.source().to_string();
-    item.entry.nlri.group = evpn_prefix.group().to_string();
+    const EvpnRoute *evpn_route = static_cast<const EvpnRoute *>(route);
+    item.entry.nlri.ethernet_tag = evpn_route->GetPrefix().tag();
+    item.entry.nlri.mac = fields[1];
+    item.entry.nlri.address = fields[2];
+    item.entry.nlri.source = fields[3];
+    item.entry.nlri.group = fields[4];
 
     item.entry.virtual_network = GetVirtualNetwork(route, roattr);
     item.entry.local_preference = roattr->attr()->local_pref();
@@ -379,16 +524,38 @@ void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
         EncodeEnetNextHop(route, nexthop, &item);
     }
 
-    xml_node node = doc_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-
-    // Remember the previous size.
     // Using remove_child instead of reset allows memory pages allocated for
     // the xml_document to be reused during the lifetime of the xml_document.
-    size_t pos = repr_.size();
+    xml_node node = doc_.append_child("item");
+    node.append_attribute("id") = fields[0].c_str();
     item.Encode(&node);
     doc_.print(writer_, "\t", pugi::format_default, pugi::encoding_auto, 3);
     doc_.remove_child(node);
+}
+
+//
+// The ethernet tag is part of the template key as it is encoded as an
+// integer.
+//
+void BgpXmppMessage::AddEnetReach(const BgpRoute *route,
+                                  const RibOutAttr *roattr) {
+    if (!roattr->repr().empty()) {
+        repr_ += roattr->repr();
+        return;
+    }
+
+    const EvpnPrefix &evpn_prefix =
+        static_cast<const EvpnRoute *>(route)->GetPrefix();
+    size_t pos = repr_.size();
+    item_fields_.clear();
+    item_fields_.push_back(route->ToXmppIdString());
+    item_fields_.push_back(evpn_prefix.mac_addr().ToString());
+    item_fields_.push_back(evpn_prefix.ip_address().to_string() + "/" +
+        integerToString(evpn_prefix.ip_address_length()));
+    item_fields_.push_back(evpn_prefix.source().to_string());
+    item_fields_.push_back(evpn_prefix.group().to_string());
+    AddItem(route, roattr, evpn_prefix.tag(),
+            &BgpXmppMessage::EncodeEnetItem);
 
     // Cache the substring starting at the previous size.
     if (cache_routes_)
@@ -411,21 +578,15 @@ bool BgpXmppMessage::AddEnetRoute(const BgpRoute *route,
     return true;
 }
 
-//
-// Note that there's no need to cache the string representation since a given
-// mcast route is sent to exactly one xmpp peer.
-//
-void BgpXmppMessage::AddMcastReach(const BgpRoute *route,
-                                   const RibOutAttr *roattr) {
+void BgpXmppMessage::EncodeMcastItem(const BgpRoute *route,
+                                     const RibOutAttr *roattr,
+                                     const vector<string> &fields) {
     Address::Family family = table_->family();
     autogen::McastItemType item;
     item.entry.nlri.af = BgpAf::FamilyToAfi(family);
     item.entry.nlri.safi = BgpAf::FamilyToXmppSafi(family);
-
-    ErmVpnRoute *ermvpn_route =
-        static_cast<ErmVpnRoute *>(const_cast<BgpRoute *>(route));
-    item.entry.nlri.group = ermvpn_route->GetPrefix().group().to_string();
-    item.entry.nlri.source =  ermvpn_route->GetPrefix().source().to_string();
+    item.entry.nlri.group = fields[1];
+    item.entry.nlri.source = fields[2];
     item.entry.nlri.source_label = roattr->label();
     if (!roattr->source_address().is_unspecified()) {
         item.entry.nlri.source_address =
@@ -446,12 +607,27 @@ void BgpXmppMessage::AddMcastReach(const BgpRoute *route,
     // Using remove_child instead of reset allows memory pages allocated for
     // the xml_document to be reused during the lifetime of the xml_document.
     xml_node node = doc_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    node.append_attribute("id") = fields[0].c_str();
     item.Encode(&node);
     doc_.print(writer_, "\t", pugi::format_default, pugi::encoding_auto, 3);
     doc_.remove_child(node);
 }
 
+//
+// Note that there's no need to cache the string representation since a given
+// mcast route is sent to exactly one xmpp peer.
+//
+void BgpXmppMessage::AddMcastReach(const BgpRoute *route,
+                                   const RibOutAttr *roattr) {
+    const ErmVpnPrefix &ermvpn_prefix =
+        static_cast<const ErmVpnRoute *>(route)->GetPrefix();
+    item_fields_.clear();
+    item_fields_.push_back(route->ToXmppIdString());
+    item_fields_.push_back(ermvpn_prefix.group().to_string());
+    item_fields_.push_back(ermvpn_prefix.source().to_string());
+    AddItem(route, roattr, 0, &BgpXmppMessage::EncodeMcastItem);
+}
+
 void BgpXmppMessage::AddMcastUnreach(const BgpRoute *route) {
     repr_ += "\t\t\t<retract id=\"" + route->ToXmppIdString() + "\" />\n";
 }
@@ -468,17 +644,17 @@ bool BgpXmppMessage::AddMcastRoute(const BgpRoute *route,
     return true;
 }
 
-void BgpXmppMessage::AddMvpnReach(const BgpRoute *route,
-                                  const RibOutAttr *roattr) {
+void BgpXmppMessage::EncodeMvpnItem(const BgpRoute *route,
+                                    const RibOutAttr *roattr,
+                                    const vector<string> &fields) {
     Address::Family family = table_->family();
     autogen::MvpnItemType item;
     item.entry.nlri.af = BgpAf::FamilyToAfi(family);
     item.entry.nlri.safi = BgpAf::FamilyToXmppSafi(family);
 
-    MvpnRoute *mvpn_route =
-        static_cast<MvpnRoute *>(const_cast<BgpRoute *>(route));
-    item.entry.nlri.group = mvpn_route->GetPrefix().group().to_string();
-    item.entry.nlri.source =  mvpn_route->GetPrefix().source().to_string();
+    const MvpnRoute *mvpn_route = static_cast<const MvpnRoute *>(route);
+    item.entry.nlri.group = fields[1];
+    item.entry.nlri.source = fields[2];
     item.entry.nlri.route_type = mvpn_route->GetPrefix().type();
     assert((item.entry.nlri.route_type == MvpnPrefix::SourceActiveADRoute) ||
             (item.entry.nlri.route_type == MvpnPrefix::SourceTreeJoinRoute));
@@ -499,12 +675,28 @@ void BgpXmppMessage::AddMvpnReach(const BgpRoute *route,
     // Using remove_child instead of reset allows memory pages allocated for
     // the xml_document to be reused during the lifetime of the xml_document.
     xml_node node = doc_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    node.append_attribute("id") = fields[0].c_str();
     item.Encode(&node);
     doc_.print(writer_, "\t", pugi::format_default, pugi::encoding_auto, 3);
     doc_.remove_child(node);
 }
 
+//
+// The route type is part of the template key as it decides whether the
+// olist is encoded.
+//
+void BgpXmppMessage::AddMvpnReach(const BgpRoute *route,
+                                  const RibOutAttr *roattr) {
+    const MvpnPrefix &mvpn_prefix =
+        static_cast<const MvpnRoute *>(route)->GetPrefix();
+    item_fields_.clear();
+    item_fields_.push_back(route->ToXmppIdString());
+    item_fields_.push_back(mvpn_prefix.group().to_string());
+    item_fields_.push_back(mvpn_prefix.source().to_string());
+    AddItem(route, roattr, mvpn_prefix.type(),
+            &BgpXmppMessage::EncodeMvpnItem);
+}
+
 void BgpXmppMessage::AddMvpnUnreach(const BgpRoute *route) {
     repr_ += "\t\t\t<retract id=\"" + route->ToXmppIdString() + "\" />\n";
 }
@@ -564,6 +756,19 @@ const uint8_t *BgpXmppMessage::GetData(IPeerUpdate *peer, size_t *lenp,
     }
 }
 
+//
+// Update the community state unless it was derived from the same attributes.
+// It is tracked apart from the item template as routes encoded through the
+// DOM or from a cached repr do not update the template.
+//
+void BgpXmppMessage::ProcessAttr(const BgpAttr *attr) {
+    if (community_attr_.get() == attr)
+        return;
+    community_attr_ = attr;
+    ProcessCommunity(attr->community());
+    ProcessExtCommunity(attr->ext_community());
+}
+
 void BgpXmppMessage::ProcessCommunity(const Community *community) {
     community_list_.clear();
     if (community == NULL)
@@ -43,10 +43,16 @@ public:
                                    const std::string **msg_str,
                                    std::string *temp);
 
+    // Used by tests to compare against items built through the DOM only.
+    void set_item_template_enabled(bool enabled) {
+        item_template_enabled_ = enabled;
+    }
+
 private:
     static const size_t kMaxFromToLength = 192;
     static const uint32_t kMaxReachCount = 32;
     static const uint32_t kMaxUnreachCount = 256;
+    static const size_t kMaxItemFields = 5;
 
     class XmlWriter : public pugi::xml_writer {
     public:
@@ -59,6 +65,42 @@ private:
         std::string *repr_;
     };
 
+    //
+    // XML for the item of a reach route, split at the fields that depend on
+    // the route prefix. Consecutive routes in a message usually have the
+    // same attributes, so the item is rendered through the DOM once, with a
+    // marker in place of each prefix field, and then emitted for the other
+    // routes by appending the fragments and the fields.
+    //
+    // The key holds the parts of the prefix that change the rest of the
+    // item, e.g. the mvpn route type.
+    //
+    class ItemTemplate {
+    public:
+        ItemTemplate();
+
+        static const char *Marker(size_t index);
+        bool SameAttr(const RibOutAttr *roattr) const;
+        bool Matches(const RibOutAttr *roattr, uint32_t key) const;
+        void Build(const RibOutAttr *roattr, uint32_t key,
+                   const std::string &xml, size_t field_count);
+        bool Emit(const std::vector<std::string> &fields,
+                  std::string *repr) const;
+        void Clear();
+
+    private:
+        bool valid_;
+        bool usable_;
+        uint32_t key_;
+        RibOutAttr roattr_;
+        std::vector<std::string> fragments_;
+        std::vector<size_t> field_order_;
+    };
+
+    typedef void (BgpXmppMessage::*EncodeItemFn)(
+        const BgpRoute *route, const RibOutAttr *roattr,
+        const std::vector<std::string> &fields);
+
     struct MobilityInfo {
     public:
         MobilityInfo(uint32_t seqno, bool sticky)
@@ -69,9 +111,13 @@ private:
     };
 
     virtual void Reset();
+    void AddItem(const BgpRoute *route, const RibOutAttr *roattr,
+                 uint32_t key, EncodeItemFn encode);
     void EncodeNextHop(const BgpRoute *route,
                        const RibOutAttr::NextHop &nexthop,
                        autogen::ItemType *item);
+    void EncodeIpItem(const BgpRoute *route, const RibOutAttr *roattr,
+                      const std::vector<std::string> &fields);
     void AddIpReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddIpUnreach(const BgpRoute *route);
     bool AddInetRoute(const BgpRoute *route, const RibOutAttr *roattr);
@@ -81,18 +127,25 @@ private:
     void EncodeEnetNextHop(const BgpRoute *route,
                            const RibOutAttr::NextHop &nexthop,
                            autogen::EnetItemType *item);
+    void EncodeEnetItem(const BgpRoute *route, const RibOutAttr *roattr,
+                        const std::vector<std::string> &fields);
     void AddEnetReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddEnetUnreach(const BgpRoute *route);
     bool AddEnetRoute(const BgpRoute *route, const RibOutAttr *roattr);
 
+    void EncodeMcastItem(const BgpRoute *route, const RibOutAttr *roattr,
+                         const std::vector<std::string> &fields);
     void AddMcastReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddMcastUnreach(const BgpRoute *route);
     bool AddMcastRoute(const BgpRoute *route, const RibOutAttr *roattr);
 
+    void EncodeMvpnItem(const BgpRoute *route, const RibOutAttr *roattr,
+                        const std::vector<std::string> &fields);
     void AddMvpnReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddMvpnUnreach(const BgpRoute *route);
     bool AddMvpnRoute(const BgpRoute *route, const RibOutAttr *roattr);
 
+    void ProcessAttr(const BgpAttr *attr);
     void ProcessCommunity(const Community *community);
     void ProcessExtCommunity(const ExtCommunity *ext_community);
     std::string GetVirtualNetwork(const RibOutAttr::NextHop &nexthop) const;
@@ -109,6 +162,11 @@ private:
     pugi::xml_document doc_;
     MobilityInfo mobility_;
     bool etree_leaf_;
+    bool item_template_enabled_;
+    ItemTemplate item_template_;
+    // Attributes the community state below was derived from
+    BgpAttrPtr community_attr_;
+    std::vector<std::string> item_fields_;
 
     std::vector<int> security_group_list_;
     std::vector<std::string> community_list_;
@@ -91,6 +91,7 @@ static XmppServer *CreateXmppServer(EventManager *evm, Options *options,
     xmpp_cfg->endpoint.port(options->xmpp_port());
     xmpp_cfg->FromAddr = XmppInit::kControlNodeJID;
     xmpp_cfg->auth_enabled = options->xmpp_auth_enabled();
+    xmpp_cfg->compression_enabled = options->xmpp_compression_enabled();
     xmpp_cfg->tcp_hold_time = options->tcp_hold_time();
     xmpp_cfg->gr_helper_disable = options->gr_helper_xmpp_disable();
 
@@ -275,6 +276,7 @@ int main(int argc, char *argv[]) {
     sandesh_context.bgp_server = bgp_server.get();
     bgp_server->set_gr_helper_disable(options.gr_helper_bgp_disable());
     bgp_server->set_mvpn_ipv4_enable(options.mvpn_ipv4_enable());
+    bgp_server->set_lazy_vrf_tables(options.lazy_vrf_tables());
 
     ConnectionStateManager::GetInstance();
 
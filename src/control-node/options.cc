@@ -131,6 +131,8 @@ void Options::Initialize(EventManager &evm,
              "Enable local logging of sandesh messages")
         ("DEFAULT.mvpn_ipv4_enable", opt::bool_switch(&mvpn_ipv4_enable_),
              "Enable NGEN Multicast VPN support for IPv4 routes")
+        ("DEFAULT.lazy_vrf_tables", opt::bool_switch(&lazy_vrf_tables_),
+             "Create IPv6 and MVPN routing instance tables on first use")
         ("DEFAULT.use_syslog", opt::bool_switch(&use_syslog_),
              "Enable logging to syslog")
         ("DEFAULT.syslog_facility",
@@ -149,6 +151,9 @@ void Options::Initialize(EventManager &evm,
              "XMPP listener port")
         ("DEFAULT.xmpp_auth_enable", opt::bool_switch(&xmpp_auth_enable_),
              "Enable authentication over Xmpp")
+        ("DEFAULT.xmpp_compression_enable",
+             opt::bool_switch(&xmpp_compression_enable_),
+             "Accept zlib stream compression requested by Xmpp clients")
         ("DEFAULT.xmpp_server_cert",
              opt::value<string>()->default_value(
              "/etc/contrail/ssl/certs/server.pem"),
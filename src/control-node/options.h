@@ -38,6 +38,7 @@ public:
     bool use_syslog() const { return use_syslog_; }
     std::string syslog_facility() const { return syslog_facility_; }
     bool mvpn_ipv4_enable() const { return mvpn_ipv4_enable_; }
+    bool lazy_vrf_tables() const { return lazy_vrf_tables_; }
     bool task_track_run_time() const { return task_track_run_time_; }
     std::string config_db_user() const {
         return configdb_options_.config_db_username;
@@ -71,6 +72,7 @@ public:
     }
     uint16_t xmpp_port() const { return xmpp_port_; }
     bool xmpp_auth_enabled() const { return xmpp_auth_enable_; }
+    bool xmpp_compression_enabled() const { return xmpp_compression_enable_; }
     std::string xmpp_server_cert() const { return xmpp_server_cert_; }
     std::string xmpp_server_key() const { return xmpp_server_key_; }
     std::string xmpp_ca_cert() const { return xmpp_ca_cert_; }
@@ -125,10 +127,12 @@ private:
     bool use_syslog_;
     std::string syslog_facility_;
     bool mvpn_ipv4_enable_;
+    bool lazy_vrf_tables_;
     bool task_track_run_time_;
     ConfigClientOptions configdb_options_;
     uint16_t xmpp_port_;
     bool xmpp_auth_enable_;
+    bool xmpp_compression_enable_;
     std::string xmpp_server_cert_;
     std::string xmpp_server_key_;
     std::string xmpp_ca_cert_;
@@ -0,0 +1,373 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "db/db_btree.h"
+
+#include <algorithm>
+
+#include "db/db_entry.h"
+
+const int DBBTree::kNodeSize;
+const int DBBTree::kMaxDepth;
+
+struct DBBTree::Node {
+    explicit Node(bool leaf) : leaf(leaf), count(0) { }
+    bool leaf;
+    // Number of entries in a leaf, number of children in an inner node
+    int count;
+};
+
+struct DBBTree::LeafNode : public DBBTree::Node {
+    LeafNode() : Node(true), prev(NULL), next(NULL) { }
+    DBEntry *entries[kNodeSize];
+    LeafNode *prev;
+    LeafNode *next;
+};
+
+// keys[i] is the first entry of the subtree of children[i + 1]
+struct DBBTree::InnerNode : public DBBTree::Node {
+    InnerNode() : Node(false) { }
+    DBEntry *keys[kNodeSize - 1];
+    Node *children[kNodeSize];
+};
+
+DBBTree::DBBTree() : size_(0), depth_(1), next_leaf_(NULL) {
+    head_ = new LeafNode();
+    root_ = head_;
+}
+
+DBBTree::~DBBTree() {
+    FreeNode(root_);
+}
+
+void DBBTree::FreeNode(Node *node) {
+    if (node->leaf) {
+        delete static_cast<LeafNode *>(node);
+        return;
+    }
+    InnerNode *inner = static_cast<InnerNode *>(node);
+    for (int i = 0; i < inner->count; i++) {
+        FreeNode(inner->children[i]);
+    }
+    delete inner;
+}
+
+bool DBBTree::Less(const DBEntry *lhs, const DBEntry *rhs) {
+    return lhs->IsLess(*rhs);
+}
+
+int DBBTree::LeafLowerBound(const LeafNode *leaf, const DBEntry *key) {
+    int low = 0, high = leaf->count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (Less(leaf->entries[mid], key)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int DBBTree::LeafUpperBound(const LeafNode *leaf, const DBEntry *key) {
+    int low = 0, high = leaf->count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (Less(key, leaf->entries[mid])) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+// Index of the child whose subtree holds key: the number of separators not
+// greater than key
+int DBBTree::ChildIndex(const InnerNode *inner, const DBEntry *key) {
+    int low = 0, high = inner->count - 1;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (Less(key, inner->keys[mid])) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+DBBTree::LeafNode *DBBTree::Descend(const DBEntry *key, PathElem *path,
+                                    int *level) const {
+    Node *node = root_;
+    int depth = 0;
+    while (!node->leaf) {
+        InnerNode *inner = static_cast<InnerNode *>(node);
+        int index = ChildIndex(inner, key);
+        if (path) {
+            path[depth].node = inner;
+            path[depth].index = index;
+        }
+        depth++;
+        node = inner->children[index];
+    }
+    if (level) {
+        *level = depth;
+    }
+    return static_cast<LeafNode *>(node);
+}
+
+DBEntry *DBBTree::Find(const DBEntry *key) const {
+    const LeafNode *leaf = Descend(key, NULL, NULL);
+    int pos = LeafLowerBound(leaf, key);
+    if (pos == leaf->count || Less(key, leaf->entries[pos])) {
+        return NULL;
+    }
+    return leaf->entries[pos];
+}
+
+DBEntry *DBBTree::LowerBound(const DBEntry *key) const {
+    const LeafNode *leaf = Descend(key, NULL, NULL);
+    int pos = LeafLowerBound(leaf, key);
+    if (pos < leaf->count) {
+        return leaf->entries[pos];
+    }
+    // Leaves other than the root are never empty
+    return leaf->next ? leaf->next->entries[0] : NULL;
+}
+
+DBEntry *DBBTree::UpperBound(const DBEntry *key) const {
+    const LeafNode *leaf = Descend(key, NULL, NULL);
+    int pos = LeafUpperBound(leaf, key);
+    if (pos < leaf->count) {
+        return leaf->entries[pos];
+    }
+    return leaf->next ? leaf->next->entries[0] : NULL;
+}
+
+DBEntry *DBBTree::First() const {
+    return head_->count ? head_->entries[0] : NULL;
+}
+
+// Returns true if the successor of key is in leaf or is the first entry of
+// the next leaf
+bool DBBTree::LeafCovers(const LeafNode *leaf, const DBEntry *key) {
+    if (leaf->count == 0 || Less(key, leaf->entries[0])) {
+        return false;
+    }
+    return (leaf->next == NULL || Less(key, leaf->next->entries[0]));
+}
+
+DBEntry *DBBTree::Next(const DBEntry *entry) const {
+    const LeafNode *leaf = next_leaf_;
+    if (leaf == NULL || !LeafCovers(leaf, entry)) {
+        leaf = Descend(entry, NULL, NULL);
+    }
+    int pos = LeafUpperBound(leaf, entry);
+    if (pos == leaf->count) {
+        leaf = leaf->next;
+        pos = 0;
+    }
+    next_leaf_ = leaf;
+    return leaf ? leaf->entries[pos] : NULL;
+}
+
+bool DBBTree::Insert(DBEntry *entry) {
+    PathElem path[kMaxDepth];
+    int level;
+    LeafNode *leaf = Descend(entry, path, &level);
+    int pos = LeafLowerBound(leaf, entry);
+    if (pos < leaf->count && !Less(entry, leaf->entries[pos])) {
+        return false;
+    }
+    size_++;
+
+    if (leaf->count < kNodeSize) {
+        std::copy_backward(leaf->entries + pos, leaf->entries + leaf->count,
+                           leaf->entries + leaf->count + 1);
+        leaf->entries[pos] = entry;
+        leaf->count++;
+        return true;
+    }
+
+    // Split the leaf, the upper half moves to a new leaf on the right
+    LeafNode *right = new LeafNode();
+    int half = kNodeSize / 2;
+    std::copy(leaf->entries + half, leaf->entries + kNodeSize,
+              right->entries);
+    right->count = kNodeSize - half;
+    leaf->count = half;
+    right->next = leaf->next;
+    right->prev = leaf;
+    if (leaf->next) {
+        leaf->next->prev = right;
+    }
+    leaf->next = right;
+
+    LeafNode *target = leaf;
+    if (pos > half) {
+        target = right;
+        pos -= half;
+    }
+    std::copy_backward(target->entries + pos, target->entries + target->count,
+                       target->entries + target->count + 1);
+    target->entries[pos] = entry;
+    target->count++;
+
+    InsertInParent(path, level, leaf, right->entries[0], right);
+    return true;
+}
+
+// Insert right, with separator, after left in the parent of left
+void DBBTree::InsertInParent(PathElem *path, int level, Node *left,
+                             DBEntry *separator, Node *right) {
+    while (true) {
+        if (level == 0) {
+            assert(depth_ < kMaxDepth);
+            InnerNode *root = new InnerNode();
+            root->children[0] = left;
+            root->children[1] = right;
+            root->keys[0] = separator;
+            root->count = 2;
+            root_ = root;
+            depth_++;
+            return;
+        }
+
+        level--;
+        InnerNode *parent = path[level].node;
+        int index = path[level].index;
+        if (parent->count < kNodeSize) {
+            std::copy_backward(parent->children + index + 1,
+                               parent->children + parent->count,
+                               parent->children + parent->count + 1);
+            std::copy_backward(parent->keys + index,
+                               parent->keys + parent->count - 1,
+                               parent->keys + parent->count);
+            parent->children[index + 1] = right;
+            parent->keys[index] = separator;
+            parent->count++;
+            return;
+        }
+
+        // Split the parent. Build the kNodeSize + 1 children and their
+        // separators, keep the lower half and move the upper half to a new
+        // node. The separator between the halves moves up.
+        Node *children[kNodeSize + 1];
+        DBEntry *keys[kNodeSize];
+        std::copy(parent->children, parent->children + index + 1, children);
+        children[index + 1] = right;
+        std::copy(parent->children + index + 1,
+                  parent->children + kNodeSize, children + index + 2);
+        std::copy(parent->keys, parent->keys + index, keys);
+        keys[index] = separator;
+        std::copy(parent->keys + index, parent->keys + kNodeSize - 1,
+                  keys + index + 1);
+
+        int half = (kNodeSize + 1) / 2;
+        InnerNode *sibling = new InnerNode();
+        std::copy(children, children + half, parent->children);
+        std::copy(keys, keys + half - 1, parent->keys);
+        parent->count = half;
+        std::copy(children + half, children + kNodeSize + 1,
+                  sibling->children);
+        std::copy(keys + half, keys + kNodeSize, sibling->keys);
+        sibling->count = kNodeSize + 1 - half;
+
+        left = parent;
+        separator = keys[half - 1];
+        right = sibling;
+    }
+}
+
+bool DBBTree::Remove(const DBEntry *entry) {
+    PathElem path[kMaxDepth];
+    int level;
+    LeafNode *leaf = Descend(entry, path, &level);
+    int pos = LeafLowerBound(leaf, entry);
+    if (pos == leaf->count || Less(entry, leaf->entries[pos])) {
+        return false;
+    }
+
+    // The first entry of a leaf is the separator of the lowest ancestor
+    // reached through a child other than the first one. Replace it with the
+    // next entry. If the subtree becomes empty, the separator is removed
+    // with the subtree below.
+    if (pos == 0) {
+        DBEntry *next = NULL;
+        if (leaf->count > 1) {
+            next = leaf->entries[1];
+        } else if (leaf->next) {
+            next = leaf->next->entries[0];
+        }
+        for (int i = level - 1; i >= 0; i--) {
+            if (path[i].index > 0) {
+                if (next) {
+                    path[i].node->keys[path[i].index - 1] = next;
+                }
+                break;
+            }
+        }
+    }
+
+    std::copy(leaf->entries + pos + 1, leaf->entries + leaf->count,
+              leaf->entries + pos);
+    leaf->count--;
+    size_--;
+
+    if (leaf->count == 0 && level > 0) {
+        RemoveLeaf(leaf, path, level);
+    }
+    return true;
+}
+
+// Free an empty leaf and the inner nodes left without children
+void DBBTree::RemoveLeaf(LeafNode *leaf, PathElem *path, int level) {
+    if (leaf->prev) {
+        leaf->prev->next = leaf->next;
+    } else {
+        head_ = leaf->next;
+    }
+    if (leaf->next) {
+        leaf->next->prev = leaf->prev;
+    }
+    if (next_leaf_ == leaf) {
+        next_leaf_ = NULL;
+    }
+    delete leaf;
+
+    for (int i = level - 1; i >= 0; i--) {
+        InnerNode *inner = path[i].node;
+        int index = path[i].index;
+        std::copy(inner->children + index + 1,
+                  inner->children + inner->count, inner->children + index);
+        if (index > 0) {
+            std::copy(inner->keys + index, inner->keys + inner->count - 1,
+                      inner->keys + index - 1);
+        } else if (inner->count > 1) {
+            std::copy(inner->keys + 1, inner->keys + inner->count - 1,
+                      inner->keys);
+        }
+        inner->count--;
+        if (inner->count > 0) {
+            break;
+        }
+        delete inner;
+        if (i == 0) {
+            // Tree is empty
+            head_ = new LeafNode();
+            root_ = head_;
+            depth_ = 1;
+            return;
+        }
+    }
+
+    // Remove root nodes with a single child
+    while (!root_->leaf && root_->count == 1) {
+        InnerNode *root = static_cast<InnerNode *>(root_);
+        root_ = root->children[0];
+        delete root;
+        depth_--;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef ctrlplane_db_btree_h
+#define ctrlplane_db_btree_h
+
+#include <cstddef>
+
+#include "base/util.h"
+
+class DBEntry;
+
+//
+// B+ tree of DBEntry pointers, ordered by DBEntry::IsLess.
+//
+// Alternative to the red-black tree of DBTablePartition for tables with many
+// entries. Nodes hold up to kNodeSize pointers in an array, so that a lookup
+// reads a few contiguous nodes instead of chasing a pointer per level through
+// the entries. Leaves are linked in key order.
+//
+// Separators in inner nodes are pointers to the first entry of the subtree on
+// their right. They are updated when that entry is removed, so that they
+// never point to a deleted entry.
+//
+// Removal frees empty nodes but does not merge nodes that are not full.
+//
+// Concurrency: not thread safe, DBTablePartition serializes access.
+//
+class DBBTree {
+public:
+    static const int kNodeSize = 64;
+
+    DBBTree();
+    ~DBBTree();
+
+    // Returns false if an entry with the same key is present
+    bool Insert(DBEntry *entry);
+    // Remove the entry with the same key as entry. Returns false if none
+    bool Remove(const DBEntry *entry);
+
+    DBEntry *Find(const DBEntry *key) const;
+    // First entry not less than key
+    DBEntry *LowerBound(const DBEntry *key) const;
+    // First entry greater than key
+    DBEntry *UpperBound(const DBEntry *key) const;
+    DBEntry *First() const;
+    // Entry following entry, which need not be in the tree. Continues from
+    // the leaf of the previous call through the leaf links if entry falls
+    // in it, so that walks do not descend from the root for every entry
+    DBEntry *Next(const DBEntry *entry) const;
+
+    size_t size() const { return size_; }
+    bool empty() const { return (size_ == 0); }
+    int depth() const { return depth_; }
+
+private:
+    static const int kMaxDepth = 16;
+
+    struct Node;
+    struct LeafNode;
+    struct InnerNode;
+    struct PathElem {
+        InnerNode *node;
+        int index;
+    };
+
+    static bool Less(const DBEntry *lhs, const DBEntry *rhs);
+    static int LeafLowerBound(const LeafNode *leaf, const DBEntry *key);
+    static int LeafUpperBound(const LeafNode *leaf, const DBEntry *key);
+    static int ChildIndex(const InnerNode *inner, const DBEntry *key);
+    static bool LeafCovers(const LeafNode *leaf, const DBEntry *key);
+
+    // Descend to the leaf for key, recording the inner nodes visited in path
+    LeafNode *Descend(const DBEntry *key, PathElem *path, int *level) const;
+    void InsertInParent(PathElem *path, int level, Node *left,
+                        DBEntry *separator, Node *right);
+    void RemoveLeaf(LeafNode *leaf, PathElem *path, int level);
+    void FreeNode(Node *node);
+
+    Node *root_;
+    // First leaf in key order
+    LeafNode *head_;
+    size_t size_;
+    int depth_;
+    // Leaf of the entry last returned by Next, reset when the leaf is freed
+    mutable const LeafNode *next_leaf_;
+
+    DISALLOW_COPY_AND_ASSIGN(DBBTree);
+};
+
+#endif
@@ -232,6 +232,60 @@ void DBGraph::Visit(DBGraphVertex *start, VertexVisitor vertex_visit_fn,
     // std::cout << "Graph Walk time(in usec) " <<  (end_t-t) << std::endl;
 }
 
+void DBGraph::PropagateEdges(DBGraphVertex *current_vertex,
+                   OutEdgeIterator iter_begin, OutEdgeIterator iter_end,
+                   VertexPropagate propagate_fn,
+                   EdgePredicate &edge_test, VertexPredicate &vertex_test,
+                   VisitQ &visit_q, bool match_name,
+                   const std::string &allowed_edge) {
+    for (; iter_begin != iter_end; ++iter_begin) {
+        const DBGraph::EdgeProperties &e_prop = get(edge_bundle, *iter_begin);
+        DBGraphEdge *edge = e_prop.edge;
+        if (match_name && e_prop.name() != allowed_edge) break;
+        DBGraphVertex *adjacent_vertex = vertex_target(current_vertex, edge);
+        if (!edge_test(current_vertex, adjacent_vertex, edge)) continue;
+        if (!vertex_test(adjacent_vertex)) continue;
+        if (propagate_fn(current_vertex, adjacent_vertex)) {
+            visit_q.push(adjacent_vertex);
+        }
+    }
+}
+
+void DBGraph::Propagate(const std::vector<DBGraphVertex *> &start,
+                        VertexPropagate propagate_fn,
+                        const VisitorFilter &filter) {
+    EdgePredicate edge_test(this, filter);
+    VertexPredicate vertex_test(this, filter);
+
+    VisitQ visit_q;
+    BOOST_FOREACH(DBGraphVertex *vertex, start) {
+        visit_q.push(vertex);
+    }
+    while (!visit_q.empty()) {
+        DBGraphVertex *vertex = visit_q.front();
+        visit_q.pop();
+        OutEdgeListType &out_edge_set = graph_.out_edge_list(vertex->vertex());
+        if (out_edge_set.empty()) continue;
+
+        DBGraph::VisitorFilter::AllowedEdgeRetVal allowed_edge_ret =
+            filter.AllowedEdges(vertex);
+        if (!allowed_edge_ret.first) {
+            BOOST_FOREACH (std::string allowed_edge, allowed_edge_ret.second) {
+                EdgeContainer fake_container;
+                fake_container.push_back(
+                         EdgeType(0, 0, EdgeProperties(allowed_edge, NULL)));
+                StoredEdge es(vertex->vertex(), fake_container.begin());
+                PropagateEdges(vertex, out_edge_set.lower_bound(es),
+                               out_edge_set.end(), propagate_fn, edge_test,
+                               vertex_test, visit_q, true, allowed_edge);
+            }
+        } else {
+            PropagateEdges(vertex, out_edge_set.begin(), out_edge_set.end(),
+                           propagate_fn, edge_test, vertex_test, visit_q);
+        }
+    }
+}
+
 DBGraph::edge_iterator::edge_iterator(DBGraph *graph) : graph_(graph) {
     if (graph_) {
         boost::tie(iter_, end_) = edges(*graph_->graph());
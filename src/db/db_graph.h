@@ -6,6 +6,7 @@
 #define ctrlplane_db_graph_h
 
 #include <queue>
+#include <vector>
 
 #include <boost/function.hpp>
 #include <boost/iterator/iterator_facade.hpp>
@@ -22,6 +23,10 @@ public:
     typedef boost::function<void(DBGraphVertex *)> VertexVisitor;
     typedef boost::function<void(DBGraphEdge *)> EdgeVisitor;
     typedef boost::function<void(DBGraphVertex *)> VertexFinish;
+    // Called for an edge from source to target, returns true if target
+    // gained state that must be propagated further
+    typedef boost::function<bool(DBGraphVertex *, DBGraphVertex *)>
+        VertexPropagate;
 
     struct VisitorFilter {
         typedef std::set<std::string> AllowedEdgeSet;
@@ -109,6 +114,13 @@ public:
     void Visit(DBGraphVertex *start, VertexVisitor vertex_visit_fn,
                EdgeVisitor edge_visit_fn, VertexFinish vertex_finish_fn);
 
+    // Propagate per vertex state from several start vertices in a single
+    // traversal, following the edges that Visit would follow with the same
+    // filter. A vertex is expanded again each time it gains state, so the
+    // result is the union of the walks from each start vertex.
+    void Propagate(const std::vector<DBGraphVertex *> &start,
+                   VertexPropagate propagate_fn, const VisitorFilter &filter);
+
     edge_iterator edge_list_begin();
     edge_iterator edge_list_end();
 
@@ -132,6 +144,13 @@ private:
                   uint64_t curr_walk, VisitQ &visit_queue,
                   bool match_name=false, const std::string &allowed_edge = "");
 
+    void PropagateEdges(DBGraphVertex *current_vertex,
+                        OutEdgeIterator iter_begin, OutEdgeIterator iter_end,
+                        VertexPropagate propagate_fn,
+                        EdgePredicate &edge_test, VertexPredicate &vertex_test,
+                        VisitQ &visit_queue, bool match_name = false,
+                        const std::string &allowed_edge = "");
+
     DBGraphVertex *vertex_target(DBGraphVertex *current_vertex,
                                  DBGraphEdge *edge);
 
@@ -18,16 +18,54 @@ using tbb::concurrent_queue;
 using tbb::atomic;
 
 struct RequestQueueEntry {
+    RequestQueueEntry() : tpart(NULL), client(NULL), next(NULL), chunk(NULL) {
+    }
     // Constructor takes ownership of DBRequest key, data.
     RequestQueueEntry(DBTablePartBase *tpart, DBClient *client, DBRequest *req)
-        : tpart(tpart), client(client) {
+        : tpart(tpart), client(client), next(NULL), chunk(NULL) {
         request.Swap(req);
     }
     DBTablePartBase *tpart;
     DBClient *client;
     DBRequest request;
+    // Next request enqueued in the same queue element
+    RequestQueueEntry *next;
+    // Chunk the entry is allocated from, NULL if allocated alone
+    RequestChunk *chunk;
+};
+
+// Queue entries of a DBRequestBatch, allocated at once.
+struct RequestChunk {
+    RequestChunk() : used(0), freed(0) { }
+    RequestQueueEntry entries[DBRequestBatch::kChunkSize];
+    size_t used;
+    size_t freed;
 };
 
+static void FreeRequestQueueEntry(RequestQueueEntry *req_entry) {
+    RequestChunk *chunk = req_entry->chunk;
+    if (chunk == NULL) {
+        delete req_entry;
+        return;
+    }
+
+    // Release key and data now, the chunk is freed with its last entry
+    req_entry->request.key.reset();
+    req_entry->request.data.reset();
+    if (++chunk->freed == chunk->used) {
+        delete chunk;
+    }
+}
+
+// Free a chain of entries linked by next.
+static void FreeRequestQueueChain(RequestQueueEntry *req_entry) {
+    while (req_entry) {
+        RequestQueueEntry *next = req_entry->next;
+        FreeRequestQueueEntry(req_entry);
+        req_entry = next;
+    }
+}
+
 struct RemoveQueueEntry {
     RemoveQueueEntry(DBTablePartBase *tpart, DBEntryBase *db_entry)
         : tpart(tpart), db_entry(db_entry) {
@@ -45,6 +83,7 @@ public:
 
     explicit WorkQueue(DBPartition *partition, int partition_id)
         : db_partition_(partition),
+          pending_(NULL),
           db_partition_id_(partition_id),
           disable_(false),
           running_(false) {
@@ -53,11 +92,12 @@ public:
         total_request_count_ = 0;
     }
     ~WorkQueue() {
+        FreeRequestQueueChain(pending_);
         for (RequestQueue::iterator iter = request_queue_.unsafe_begin();
              iter != request_queue_.unsafe_end();) {
             RequestQueueEntry *req_entry = *iter;
             ++iter;
-            delete req_entry;
+            FreeRequestQueueChain(req_entry);
         }
         request_queue_.clear();
     }
@@ -73,12 +113,28 @@ public:
 
     }
 
+    // Enqueue a chain of requests as one element of the request queue.
+    bool EnqueueRequestBatch(RequestQueueEntry *head, size_t count) {
+        request_queue_.push(head);
+        MaybeStartRunner();
+        uint32_t max = request_count_.fetch_and_add(count) + count - 1;
+        if (max > max_request_queue_len_)
+            max_request_queue_len_ = max;
+        total_request_count_ += count;
+        return max < (kThreshold - 1);
+    }
+
+    // Dequeue the next request. Requests of a queue element are returned one
+    // at a time, the rest of the element is kept in pending_ so that the
+    // runner can yield in the middle of a batch.
     bool DequeueRequest(RequestQueueEntry **req_entry) {
-        bool success = request_queue_.try_pop(*req_entry);
-        if (success) {
-            request_count_.fetch_and_decrement();
+        if (pending_ == NULL && !request_queue_.try_pop(pending_)) {
+            return false;
         }
-        return success;
+        *req_entry = pending_;
+        pending_ = pending_->next;
+        request_count_.fetch_and_decrement();
+        return true;
     }
 
     void EnqueueRemove(RemoveQueueEntry *rm_entry) {
@@ -120,7 +176,8 @@ public:
     int db_task_id() const { return db_partition_->task_id(); }
 
     bool IsDBQueueEmpty() const {
-        return (request_queue_.empty() && change_list_.empty());
+        return (request_queue_.empty() && pending_ == NULL &&
+                change_list_.empty());
     }
 
     bool disable() { return disable_; }
@@ -141,6 +198,8 @@ public:
 private:
     DBPartition *db_partition_;
     RequestQueue request_queue_;
+    // Requests of the queue element being processed. Accessed by the runner
+    RequestQueueEntry *pending_;
     TablePartList change_list_;
     atomic<long> request_count_;
     uint64_t total_request_count_;
@@ -206,7 +265,7 @@ public:
         RequestQueueEntry *req_entry = NULL;
         while (queue_->DequeueRequest(&req_entry)) {
             req_entry->tpart->Process(req_entry->client, &req_entry->request);
-            delete req_entry;
+            FreeRequestQueueEntry(req_entry);
             if (++count == kMaxIterations) {
                 return false;
             }
@@ -253,7 +312,8 @@ void DBPartition::WorkQueue::MaybeStartRunner() {
 
 bool DBPartition::WorkQueue::RunnerDone() {
     tbb::mutex::scoped_lock lock(mutex_);
-    if (disable_ || (request_queue_.empty() && remove_queue_.empty())) {
+    if (disable_ || (request_queue_.empty() && pending_ == NULL &&
+                     remove_queue_.empty())) {
         running_ = false;
         return true;
     }
@@ -277,6 +337,11 @@ bool DBPartition::EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
     return work_queue_->EnqueueRequest(entry);
 }
 
+bool DBPartition::EnqueueRequestBatch(RequestQueueEntry *head,
+                                      size_t count) {
+    return work_queue_->EnqueueRequestBatch(head, count);
+}
+
 void DBPartition::EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry) {
     RemoveQueueEntry *entry = new RemoveQueueEntry(tpart, db_entry);
     db_entry->SetOnRemoveQ();
@@ -303,3 +368,55 @@ uint64_t DBPartition::max_request_queue_len() const {
 int DBPartition::task_id() const {
     return db_->task_id();
 }
+
+const size_t DBRequestBatch::kChunkSize;
+
+DBRequestBatch::DBRequestBatch(DBTableBase *table)
+    : table_(table), batches_(DB::PartitionCount()), size_(0) {
+}
+
+DBRequestBatch::~DBRequestBatch() {
+    for (size_t i = 0; i < batches_.size(); i++) {
+        FreeRequestQueueChain(batches_[i].head);
+    }
+}
+
+void DBRequestBatch::Add(DBRequest *req) {
+    DBTablePartBase *tpart = table_->GetTablePartition(req->key.get());
+    PartitionBatch *batch = &batches_[tpart->index()];
+    if (batch->chunk == NULL || batch->chunk->used == kChunkSize) {
+        batch->chunk = new RequestChunk();
+    }
+
+    RequestQueueEntry *req_entry =
+        &batch->chunk->entries[batch->chunk->used++];
+    req_entry->tpart = tpart;
+    req_entry->chunk = batch->chunk;
+    req_entry->request.Swap(req);
+    if (batch->tail) {
+        batch->tail->next = req_entry;
+    } else {
+        batch->head = req_entry;
+    }
+    batch->tail = req_entry;
+    batch->count++;
+    size_++;
+}
+
+bool DBRequestBatch::Enqueue() {
+    DB *db = table_->database();
+    bool more = true;
+    for (size_t i = 0; i < batches_.size(); i++) {
+        PartitionBatch *batch = &batches_[i];
+        if (batch->head == NULL) {
+            continue;
+        }
+        DBPartition *partition = db->GetPartition(i);
+        if (!partition->EnqueueRequestBatch(batch->head, batch->count)) {
+            more = false;
+        }
+        *batch = PartitionBatch();
+    }
+    size_ = 0;
+    return more;
+}
@@ -5,6 +5,7 @@
 #ifndef ctrlplane_db_partition_h
 #define ctrlplane_db_partition_h
 
+#include <vector>
 #include <boost/function.hpp>
 
 #include "base/util.h"
@@ -14,6 +15,8 @@
 class DB;
 class DBClient;
 class DBTablePartBase;
+struct RequestChunk;
+struct RequestQueueEntry;
 
 // Database shard interface.
 // Each shard handles the full pipeline of DB update processing.
@@ -29,6 +32,10 @@ public:
     bool EnqueueRequest(DBTablePartBase *tpart, DBClient *client,
                         DBRequest *req);
 
+    // Enqueue a chain of count requests, linked by RequestQueueEntry::next,
+    // as a single element of the request queue. See DBRequestBatch.
+    bool EnqueueRequestBatch(RequestQueueEntry *head, size_t count);
+
     void EnqueueRemove(DBTablePartBase *tpart, DBEntryBase *db_entry);
 
     // Enqueue table on change list.
@@ -52,4 +59,51 @@ private:
     DISALLOW_COPY_AND_ASSIGN(DBPartition);
 };
 
+// Requests accumulated by a producer and enqueued to a table at once with
+// DBTableBase::EnqueueBatch, e.g. all the prefixes of a BGP UPDATE.
+//
+// Requests are grouped per partition. The requests of a partition are pushed
+// to the partition request queue as a single element, with one check to
+// start the queue runner, and the runner processes them in order. Queue
+// entries are allocated in chunks of kChunkSize instead of one allocation per
+// request, and a chunk is freed when all its requests are processed.
+//
+// Order of the requests is kept within a partition, as with Enqueue.
+class DBRequestBatch {
+public:
+    static const size_t kChunkSize = 64;
+
+    explicit DBRequestBatch(DBTableBase *table);
+    ~DBRequestBatch();
+
+    // Add a request to the batch. Takes ownership of the key and data of the
+    // request, as DBTableBase::Enqueue.
+    void Add(DBRequest *req);
+
+    DBTableBase *table() { return table_; }
+    size_t size() const { return size_; }
+    bool empty() const { return (size_ == 0); }
+
+private:
+    friend class DBTableBase;
+
+    struct PartitionBatch {
+        PartitionBatch() : head(NULL), tail(NULL), chunk(NULL), count(0) { }
+        RequestQueueEntry *head;
+        RequestQueueEntry *tail;
+        // Chunk from which entries are allocated
+        RequestChunk *chunk;
+        size_t count;
+    };
+
+    // Enqueue the requests to the partitions and empty the batch.
+    bool Enqueue();
+
+    DBTableBase *table_;
+    std::vector<PartitionBatch> batches_;
+    size_t size_;
+
+    DISALLOW_COPY_AND_ASSIGN(DBRequestBatch);
+};
+
 #endif
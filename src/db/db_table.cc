@@ -198,6 +198,12 @@ bool DBTableBase::Enqueue(DBRequest *req) {
     return partition->EnqueueRequest(tpart, NULL, req);
 }
 
+bool DBTableBase::EnqueueBatch(DBRequestBatch *batch) {
+    assert(batch->table() == this);
+    enqueue_count_ += batch->size();
+    return batch->Enqueue();
+}
+
 void DBTableBase::EnqueueRemove(DBEntryBase *db_entry) {
     DBTablePartBase *tpart = GetTablePartition(db_entry);
     DBPartition *partition = db_->GetPartition(tpart->index());
@@ -246,12 +252,20 @@ void DBTableBase::FillListeners(vector<ShowTableListener> *listeners) const {
 class DBTable::WalkWorker : public Task {
 public:
     WalkWorker(TableWalker *walker, int db_partition_id);
+    explicit WalkWorker(WalkWorker *worker);
 
     virtual bool Run();
 
     std::string Description() const { return "DBTable::WalkWorker"; }
 
 private:
+    // Task that continues the walk when this worker gets parked
+    Task *Park();
+
+    // Iterate up to max_walk_entry_count entries, return the number of
+    // entries visited in visited. Return false to yield
+    bool WalkPartition(int max_walk_entry_count, int *visited);
+
     // Store the last visited node to continue walk
     std::auto_ptr<DBRequestKey> walk_ctx_;
 
@@ -287,10 +301,39 @@ public:
 };
 
 bool DBTable::WalkWorker::Run() {
+    DBTable *table = walker_->table();
+    int max_walk_entry_count = table->GetWalkIterationToYield();
+
+    // Give up the partition if walks used up their budget. The walk is
+    // continued by the worker created by Park once budget is available.
+    DBTableWalkMgr *walk_mgr = table->database()->GetWalkMgr();
+    if (!walk_mgr->AcquireWalkBudget(
+            boost::bind(&DBTable::WalkWorker::Park, this))) {
+        return true;
+    }
+
+    int visited = 0;
+    bool done = WalkPartition(max_walk_entry_count, &visited);
+    walk_mgr->ChargeWalkBudget(visited);
+    if (!done) {
+        return false;
+    }
+
+    walk_mgr->WalkWorkerDone();
+
+    // Check whether all other walks on the table is completed
+    long num_walkers_on_tpart = walker_->pending_workers_.fetch_and_decrement();
+    if (num_walkers_on_tpart == 1) {
+        table->WalkDone();
+    }
+    return true;
+}
+
+bool DBTable::WalkWorker::WalkPartition(int max_walk_entry_count,
+                                        int *visited) {
     int count = 0;
     DBRequestKey *key_resume = walk_ctx_.get();
     DBTable *table = walker_->table();
-    int max_walk_entry_count = table->GetWalkIterationToYield();
     DBEntry *entry;
 
     if (key_resume != NULL) {
@@ -301,43 +344,49 @@ bool DBTable::WalkWorker::Run() {
     } else {
         entry = tbl_partition_->GetFirst();
     }
-    if (entry == NULL) {
-        goto walk_done;
-    }
 
     for (DBEntry *next = NULL; entry; entry = next) {
         next = tbl_partition_->GetNext(entry);
         if (count == max_walk_entry_count) {
             // store the context
             walk_ctx_ = entry->GetDBRequestKey();
+            *visited = count;
             return false;
         }
 
         // Invoke walker function
         bool more = table->InvokeWalkCb(tbl_partition_, entry);
+        count++;
         if (!more) {
             break;
         }
 
         db_walker_wait();
-        count++;
-    }
-
-walk_done:
-    // Check whether all other walks on the table is completed
-    long num_walkers_on_tpart = walker_->pending_workers_.fetch_and_decrement();
-    if (num_walkers_on_tpart == 1) {
-        table->WalkDone();
     }
+    *visited = count;
     return true;
 }
 
 DBTable::WalkWorker::WalkWorker(TableWalker *walker, int db_partition_id)
-    : Task(walker->table()->GetWalkerTaskId(), db_partition_id), walker_(walker) {
+    : Task(walker->table()->GetWalkerTaskId(), db_partition_id),
+      walker_(walker) {
     tbl_partition_ = static_cast<DBTablePartition *>
         (walker_->table()->GetTablePartition(db_partition_id));
 }
 
+//
+// Take over the walk state of a worker that gets parked.
+//
+DBTable::WalkWorker::WalkWorker(WalkWorker *worker)
+    : Task(worker->GetTaskId(), worker->GetTaskInstance()),
+      walk_ctx_(worker->walk_ctx_), tbl_partition_(worker->tbl_partition_),
+      walker_(worker->walker_) {
+}
+
+Task *DBTable::WalkWorker::Park() {
+    return new WalkWorker(this);
+}
+
 void DBTable::TableWalker::StartWalk() {
     CHECK_CONCURRENCY("db::Walker");
     assert(pending_workers_ == 0);
@@ -351,6 +400,8 @@ void DBTable::TableWalker::StartWalk() {
     if (pending_workers_ == 0) {
         table_->WalkDone();
     } else {
+        DBTableWalkMgr *walk_mgr = table_->database()->GetWalkMgr();
+        walk_mgr->WalkWorkersStart(pending_workers_);
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         BOOST_FOREACH(Task *task, worker_tasks_) scheduler->Enqueue(task);
     }
@@ -380,6 +431,12 @@ DBTable::DBTable(DB *db, const string &name)
     max_walk_iteration_to_yield_ = iter_to_yield_env_;
 }
 
+DBTable::PartitionStore DBTable::LargeTablePartitionStore() {
+    static bool btree_store_env_ =
+        (getenv("DB_BTREE_PARTITION_STORE") != NULL);
+    return (btree_store_env_ ? BTREE_STORE : RBTREE_STORE);
+}
+
 DBTable::~DBTable() {
     STLDeleteValues(&partitions_);
 }
@@ -636,12 +693,12 @@ void DBTable::WalkAgain(DBTable::DBTableWalkRef walk) {
 
 bool DBTable::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
     DBTableWalkMgr *walk_mgr = database()->GetWalkMgr();
-    return walk_mgr->InvokeWalkCb(part, entry);
+    return walk_mgr->InvokeWalkCb(this, part, entry);
 }
 
 void DBTable::WalkDone() {
     incr_walk_complete_count();
     walker_->ClearWalkWorks();
     DBTableWalkMgr *walk_mgr = database()->GetWalkMgr();
-    return walk_mgr->WalkDone();
+    return walk_mgr->WalkDone(this);
 }
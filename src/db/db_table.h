@@ -6,6 +6,7 @@
 #define ctrlplane_db_table_h
 
 #include <memory>
+#include <set>
 #include <vector>
 #include <unistd.h>
 #include <boost/function.hpp>
@@ -18,6 +19,7 @@ class DB;
 class DBClient;
 class DBEntryBase;
 class DBEntry;
+class DBRequestBatch;
 class DBTablePartBase;
 class DBTablePartition;
 class DBTableWalk;
@@ -68,6 +70,10 @@ public:
 
     // Enqueue a request to the table. Takes ownership of the data.
     bool Enqueue(DBRequest *req);
+    // Enqueue all the requests of the batch, grouped per partition, and
+    // empty the batch. Returns false if the client should stop enqueuing
+    // updates.
+    bool EnqueueBatch(DBRequestBatch *batch);
     void EnqueueRemove(DBEntryBase *db_entry);
 
     // Determine the table partition depending on the record key.
@@ -197,6 +203,19 @@ public:
     // Hash for key. Used to identify partition
     virtual size_t Hash(const DBRequestKey *key) const {return 0;};
 
+    // Data structure holding the entries of a partition
+    //   RBTREE_STORE : red-black tree linked through the entries
+    //   BTREE_STORE  : B+ tree of entry pointers, see DBBTree. Fewer cache
+    //                  misses on lookups and walks of large tables
+    enum PartitionStore {
+        RBTREE_STORE,
+        BTREE_STORE,
+    };
+    virtual PartitionStore GetPartitionStore() const { return RBTREE_STORE; }
+    // Store for tables that can grow large. RBTREE_STORE unless the
+    // DB_BTREE_PARTITION_STORE environment variable is set
+    static PartitionStore LargeTablePartitionStore();
+
     // Alloc a derived DBTablePartBase entry. The default implementation
     // allocates DBTablePart should be good for most common cases.
     // Override if *really* necessary
@@ -350,6 +369,9 @@ private:
     std::auto_ptr<TableWalker> walker_;
     std::vector<DBTablePartition *> partitions_;
     DBTable::DBTableWalkRef walk_ref_;
+    // Walkers served by the walk in progress on this table. Managed by
+    // DBTableWalkMgr
+    std::set<DBTableWalkRef> current_walks_;
     int walker_task_id_;
     int max_walk_iteration_to_yield_;
 
@@ -85,6 +85,9 @@ void DBTablePartBase::Delete(DBEntryBase *entry) {
 
 DBTablePartition::DBTablePartition(DBTable *table, int index)
     : DBTablePartBase(table, index) {
+    if (table->GetPartitionStore() == DBTable::BTREE_STORE) {
+        btree_.reset(new DBBTree());
+    }
 }
 
 void DBTablePartition::Process(DBClient *client, DBRequest *req) {
@@ -95,8 +98,13 @@ void DBTablePartition::Process(DBClient *client, DBRequest *req) {
 
 void DBTablePartition::Add(DBEntry *entry) {
     tbb::mutex::scoped_lock lock(mutex_);
-    std::pair<Tree::iterator, bool> ret = tree_.insert(*entry);
-    assert(ret.second);
+    if (btree_.get()) {
+        bool success = btree_->Insert(entry);
+        assert(success);
+    } else {
+        std::pair<Tree::iterator, bool> ret = tree_.insert(*entry);
+        assert(ret.second);
+    }
     entry->set_table_partition(static_cast<DBTablePartBase *>(this));
     Notify(entry);
     parent()->AddRemoveCallback(entry, true);
@@ -112,7 +120,12 @@ void DBTablePartition::Remove(DBEntryBase *db_entry) {
     DBEntry *entry = static_cast<DBEntry *>(db_entry);
     parent()->AddRemoveCallback(entry, false);
 
-    bool success = tree_.erase(*entry);
+    bool success;
+    if (btree_.get()) {
+        success = btree_->Remove(entry);
+    } else {
+        success = tree_.erase(*entry);
+    }
     if (!success) {
         LOG(FATAL, "ABORT: DB node erase failed for table " + parent()->name());
         LOG(FATAL, "Invalid node " + db_entry->ToString());
@@ -122,11 +135,14 @@ void DBTablePartition::Remove(DBEntryBase *db_entry) {
 
     // If a table is marked for deletion, then we may trigger the deletion
     // process when the last prefix is deleted
-    if (tree_.empty())
+    if (size() == 0)
         table()->RetryDelete();
 }
 
 DBEntry *DBTablePartition::FindInternal(const DBEntry *entry) {
+    if (btree_.get()) {
+        return btree_->Find(entry);
+    }
     Tree::iterator loc = tree_.find(*entry);
     if (loc != tree_.end()) {
         return loc.operator->();
@@ -135,6 +151,9 @@ DBEntry *DBTablePartition::FindInternal(const DBEntry *entry) {
 }
 
 const DBEntry *DBTablePartition::FindInternal(const DBEntry *entry) const {
+    if (btree_.get()) {
+        return btree_->Find(entry);
+    }
     Tree::const_iterator loc = tree_.find(*entry);
     if (loc != tree_.end()) {
         return loc.operator->();
@@ -178,6 +197,9 @@ DBEntry *DBTablePartition::FindNext(const DBRequestKey *key) {
     DBTable *table = static_cast<DBTable *>(parent());
     std::auto_ptr<DBEntry> entry_ptr = table->AllocEntry(key);
 
+    if (btree_.get()) {
+        return btree_->UpperBound(entry_ptr.get());
+    }
     Tree::iterator loc = tree_.upper_bound(*(entry_ptr.get()));
     if (loc != tree_.end()) {
         return loc.operator->();
@@ -190,6 +212,9 @@ DBEntry *DBTablePartition::lower_bound(const DBEntryBase *key) {
     const DBEntry *entry = static_cast<const DBEntry *>(key);
     tbb::mutex::scoped_lock lock(mutex_);
 
+    if (btree_.get()) {
+        return btree_->LowerBound(entry);
+    }
     Tree::iterator it = tree_.lower_bound(*entry);
     if (it != tree_.end()) {
         return (it.operator->());
@@ -199,6 +224,9 @@ DBEntry *DBTablePartition::lower_bound(const DBEntryBase *key) {
 
 DBEntry *DBTablePartition::GetFirst() {
     tbb::mutex::scoped_lock lock(mutex_);
+    if (btree_.get()) {
+        return btree_->First();
+    }
     Tree::iterator it = tree_.begin();
     if (it == tree_.end()) {
         return NULL;
@@ -211,6 +239,9 @@ DBEntry *DBTablePartition::GetNext(const DBEntryBase *key) {
     const DBEntry *entry = static_cast<const DBEntry *>(key);
     tbb::mutex::scoped_lock lock(mutex_);
 
+    if (btree_.get()) {
+        return btree_->Next(entry);
+    }
     Tree::const_iterator it = tree_.iterator_to(*entry);
     it++;
     if (it != tree_.end()) {
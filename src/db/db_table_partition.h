@@ -6,9 +6,11 @@
 #define ctrlplane_db_table_partition_h
 
 #include <boost/intrusive/list.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <tbb/spin_rw_mutex.h>
 #include <tbb/mutex.h>
 
+#include "db/db_btree.h"
 #include "db/db_entry.h"
 
 class DBTableBase;
@@ -111,14 +113,18 @@ public:
     DBEntry *FindNext(const DBRequestKey *key);
 
     DBTable *table();
-    size_t size() const { return tree_.size(); }
+    size_t size() const {
+        return btree_.get() ? btree_->size() : tree_.size();
+    }
 
 private:
     DBEntry *FindInternal(const DBEntry *entry);
     const DBEntry *FindInternal(const DBEntry *entry) const;
 
     mutable tbb::mutex mutex_;
+    // Entries are in tree_, or in btree_ if the table uses the B+ tree store
     Tree tree_;
+    boost::scoped_ptr<DBBTree> btree_;
     DISALLOW_COPY_AND_ASSIGN(DBTablePartition);
 };
 
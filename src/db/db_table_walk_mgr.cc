@@ -12,10 +12,23 @@
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "db/db.h"
 #include "db/db_partition.h"
 #include "db/db_table.h"
 #include "db/db_table_partition.h"
+#include "db/db_types.h"
+
+const int DBTableWalkMgr::kDefaultMaxConcurrentWalks;
+const uint64_t DBTableWalkMgr::kWalkBudgetIntervalUsecs;
+
+// All DBTableWalkMgr instances, for introspect
+static tbb::mutex walk_mgr_list_mutex_;
+static std::set<DBTableWalkMgr *> walk_mgr_list_;
+
+DBTableWalkMgr::WalkRequestInfo::WalkRequestInfo(DBTable *table)
+    : table(table), request_time(ClockMonotonicUsec()) {
+}
 
 DBTableWalkMgr::DBTableWalkMgr()
     : walk_request_trigger_(new TaskTrigger(
@@ -23,22 +36,80 @@ DBTableWalkMgr::DBTableWalkMgr()
         TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)),
       walk_done_trigger_(new TaskTrigger(
         boost::bind(&DBTableWalkMgr::ProcessWalkDone, this),
-        TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)) {
+        TaskScheduler::GetInstance()->GetTaskId("db::Walker"), 0)),
+      max_concurrent_walks_(kDefaultMaxConcurrentWalks) {
+    static bool init_ = false;
+    static int max_concurrent_walks_env_ = 0;
+    static int walk_budget_env_ = 0;
+
+    if (!init_) {
+        char *count_str = getenv("DB_MAX_CONCURRENT_WALKS");
+        if (count_str) {
+            max_concurrent_walks_env_ = strtol(count_str, NULL, 0);
+        }
+        char *budget_str = getenv("DB_WALK_BUDGET");
+        if (budget_str) {
+            walk_budget_env_ = strtol(budget_str, NULL, 0);
+        }
+        init_ = true;
+    }
+    if (max_concurrent_walks_env_ > 0)
+        max_concurrent_walks_ = max_concurrent_walks_env_;
+
+    walk_budget_ = walk_budget_env_;
+    walk_budget_interval_start_ = 0;
+    walk_budget_used_ = 0;
+    walk_budget_yield_count_ = 0;
+    walk_worker_count_ = 0;
+    walk_complete_count_ = 0;
+    walk_latency_total_ = 0;
+    walk_latency_max_ = 0;
+
+    tbb::mutex::scoped_lock lock(walk_mgr_list_mutex_);
+    walk_mgr_list_.insert(this);
+}
+
+DBTableWalkMgr::~DBTableWalkMgr() {
+    STLDeleteValues(&parked_walk_workers_);
+    tbb::mutex::scoped_lock lock(walk_mgr_list_mutex_);
+    walk_mgr_list_.erase(this);
 }
 
+void DBTableWalkMgr::SetWalkBudget(uint32_t budget) {
+    walk_budget_ = budget;
+    ResumeParkedWalkWorkers();
+}
+
+void DBTableWalkMgr::SetMaxConcurrentWalks(size_t count) {
+    assert(count > 0);
+    tbb::mutex::scoped_lock lock(mutex_);
+    max_concurrent_walks_ = count;
+    walk_request_trigger_->Set();
+}
+
+//
+// Start walks for requests in walk_request_list_, in order, as long as less
+// than max_concurrent_walks_ tables are being walked. Requests on a table
+// already being walked stay in the list until the walk of the table is done.
+//
 bool DBTableWalkMgr::ProcessWalkRequestList() {
     CHECK_CONCURRENCY("db::Walker");
     tbb::mutex::scoped_lock lock(mutex_);
-    if (!current_table_walk_.empty()) return true;
-    while (true) {
-        if (walk_request_list_.empty()) break;
-        WalkRequestInfoPtr info = walk_request_list_.front();
-        walk_request_set_.erase(info.get());
-        walk_request_list_.pop_front();
-        current_table_walk_.swap(info->pending_requests);
+    for (WalkRequestInfoList::iterator it = walk_request_list_.begin(), next;
+         it != walk_request_list_.end(); it = next) {
+        next = it;
+        ++next;
+        if (walk_in_progress_map_.size() >= max_concurrent_walks_) break;
+        WalkRequestInfoPtr info = *it;
         DBTable *table = info->table;
+        if (walk_in_progress_map_.find(table) != walk_in_progress_map_.end())
+            continue;
+        walk_request_set_.erase(info.get());
+        walk_request_list_.erase(it);
+        assert(table->current_walks_.empty());
+        table->current_walks_.swap(info->pending_requests);
         bool walk_table = false;
-        BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
+        BOOST_FOREACH(DBTable::DBTableWalkRef walker, table->current_walks_) {
             if (walker->stopped()) continue;
             walker->set_in_progress();
             walker->reset_walk_again();
@@ -46,19 +117,36 @@ bool DBTableWalkMgr::ProcessWalkRequestList() {
         }
         if (walk_table) {
             // start the walk
+            walk_in_progress_map_.insert(
+                std::make_pair(table, info->request_time));
             table->StartWalk();
-            break;
         } else {
-            current_table_walk_.clear();
+            table->current_walks_.clear();
         }
     }
     return true;
 }
 
+//
+// Notify walkers of the tables done walking and look for new walks to start.
+//
 bool DBTableWalkMgr::ProcessWalkDone() {
     CHECK_CONCURRENCY("db::Walker");
-    assert(!current_table_walk_.empty());
-    BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
+    WalkDoneList done_list;
+    {
+        tbb::mutex::scoped_lock lock(walk_done_mutex_);
+        done_list.swap(walk_done_list_);
+    }
+    BOOST_FOREACH(DBTable *table, done_list) {
+        ProcessTableWalkDone(table);
+    }
+    walk_request_trigger_->Set();
+    return true;
+}
+
+void DBTableWalkMgr::ProcessTableWalkDone(DBTable *table) {
+    assert(!table->current_walks_.empty());
+    BOOST_FOREACH(DBTable::DBTableWalkRef walker, table->current_walks_) {
         if (walker->walk_again())
             walker->set_walk_requested();
         else if (!walker->stopped())
@@ -66,9 +154,17 @@ bool DBTableWalkMgr::ProcessWalkDone() {
         if (walker->stopped() || walker->walk_again()) continue;
         walker->walk_complete()(walker, walker->table());
     }
-    current_table_walk_.clear();
-    walk_request_trigger_->Set();
-    return true;
+    table->current_walks_.clear();
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    WalkInProgressMap::iterator loc = walk_in_progress_map_.find(table);
+    assert(loc != walk_in_progress_map_.end());
+    uint64_t latency = ClockMonotonicUsec() - loc->second;
+    walk_in_progress_map_.erase(loc);
+    walk_complete_count_++;
+    walk_latency_total_ += latency;
+    if (latency > walk_latency_max_)
+        walk_latency_max_ = latency;
 }
 
 DBTable::DBTableWalkRef DBTableWalkMgr::AllocWalker(DBTable *table,
@@ -113,13 +209,18 @@ void DBTableWalkMgr::WalkTable(DBTable::DBTableWalkRef walk) {
     walk_request_trigger_->Set();
 }
 
-void DBTableWalkMgr::WalkDone() {
+void DBTableWalkMgr::WalkDone(DBTable *table) {
+    {
+        tbb::mutex::scoped_lock lock(walk_done_mutex_);
+        walk_done_list_.push_back(table);
+    }
     walk_done_trigger_->Set();
 }
 
-bool DBTableWalkMgr::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
+bool DBTableWalkMgr::InvokeWalkCb(DBTable *table, DBTablePartBase *part,
+                                  DBEntryBase *entry) {
     uint32_t skip_walk_count = 0;
-    BOOST_FOREACH(DBTable::DBTableWalkRef walker, current_table_walk_) {
+    BOOST_FOREACH(DBTable::DBTableWalkRef walker, table->current_walks_) {
         if (walker->done() || walker->stopped() || walker->walk_again()) {
             skip_walk_count++;
             continue;
@@ -130,5 +231,125 @@ bool DBTableWalkMgr::InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry) {
             if (!walker->stopped()) walker->set_walk_done();
         }
     }
-    return (skip_walk_count < current_table_walk_.size());
+    return (skip_walk_count < table->current_walks_.size());
+}
+
+//
+// Check the budget before a walk worker visits its next batch of entries.
+// The entries actually visited are charged afterwards with ChargeWalkBudget.
+// The budget is reset at the start of every kWalkBudgetIntervalUsecs. The
+// batches started last in an interval may go over budget.
+//
+// A worker that finds the budget used up is parked, unless all other workers
+// are parked already. The worker that starts the next interval resumes the
+// parked ones.
+//
+bool DBTableWalkMgr::AcquireWalkBudget(ParkFn park_fn) {
+    uint32_t budget = walk_budget_;
+    if (budget == 0)
+        return true;
+
+    uint64_t now = ClockMonotonicUsec();
+    uint64_t start = walk_budget_interval_start_;
+    if (now - start >= kWalkBudgetIntervalUsecs) {
+        if (walk_budget_interval_start_.compare_and_swap(now, start) ==
+            start) {
+            walk_budget_used_ = 0;
+            ResumeParkedWalkWorkers();
+        }
+    }
+    if (walk_budget_used_ < (int64_t) budget)
+        return true;
+
+    tbb::mutex::scoped_lock lock(walk_budget_mutex_);
+    if (parked_walk_workers_.size() + 1 >= walk_worker_count_)
+        return true;
+    parked_walk_workers_.push_back(park_fn());
+    walk_budget_yield_count_++;
+    return false;
+}
+
+void DBTableWalkMgr::ChargeWalkBudget(int count) {
+    if (walk_budget_ == 0)
+        return;
+    walk_budget_used_.fetch_and_add(count);
+}
+
+void DBTableWalkMgr::ResumeParkedWalkWorkers() {
+    WalkWorkerList workers;
+    {
+        tbb::mutex::scoped_lock lock(walk_budget_mutex_);
+        workers.swap(parked_walk_workers_);
+    }
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    BOOST_FOREACH(Task *task, workers) {
+        scheduler->Enqueue(task);
+    }
+}
+
+void DBTableWalkMgr::WalkWorkersStart(size_t count) {
+    tbb::mutex::scoped_lock lock(walk_budget_mutex_);
+    walk_worker_count_ += count;
+}
+
+//
+// Resume the parked workers if the last running worker is done, there is no
+// worker left to start the next interval.
+//
+void DBTableWalkMgr::WalkWorkerDone() {
+    WalkWorkerList workers;
+    {
+        tbb::mutex::scoped_lock lock(walk_budget_mutex_);
+        assert(walk_worker_count_ > 0);
+        walk_worker_count_--;
+        if (parked_walk_workers_.size() < walk_worker_count_)
+            return;
+        workers.swap(parked_walk_workers_);
+    }
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    BOOST_FOREACH(Task *task, workers) {
+        scheduler->Enqueue(task);
+    }
+}
+
+size_t DBTableWalkMgr::walk_queue_depth() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return walk_request_list_.size();
+}
+
+size_t DBTableWalkMgr::walks_in_progress() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return walk_in_progress_map_.size();
+}
+
+void DBTableWalkMgr::FillWalkStats(ShowDBTableWalkMgrStats *stats) const {
+    stats->set_max_concurrent_walks(max_concurrent_walks_);
+    stats->set_walk_budget(walk_budget_);
+    stats->set_walk_queue_depth(walk_queue_depth());
+    stats->set_walks_in_progress(walks_in_progress());
+    stats->set_walk_complete_count(walk_complete_count_);
+    uint64_t complete_count = walk_complete_count_;
+    stats->set_walk_latency_avg_usecs(complete_count ?
+        walk_latency_total_ / complete_count : 0);
+    stats->set_walk_latency_max_usecs(walk_latency_max_);
+    stats->set_walk_budget_yield_count(walk_budget_yield_count_);
+}
+
+void DBTableWalkMgr::FillAllWalkStats(
+    std::vector<ShowDBTableWalkMgrStats> *list) {
+    tbb::mutex::scoped_lock lock(walk_mgr_list_mutex_);
+    BOOST_FOREACH(const DBTableWalkMgr *walk_mgr, walk_mgr_list_) {
+        ShowDBTableWalkMgrStats stats;
+        walk_mgr->FillWalkStats(&stats);
+        list->push_back(stats);
+    }
+}
+
+void ShowDBTableWalkMgrReq::HandleRequest() const {
+    ShowDBTableWalkMgrResp *resp = new ShowDBTableWalkMgrResp;
+    std::vector<ShowDBTableWalkMgrStats> list;
+    DBTableWalkMgr::FillAllWalkStats(&list);
+    resp->set_walk_mgr_stats(list);
+    resp->set_context(context());
+    resp->Response();
 }
@@ -6,13 +6,16 @@
 #define ctrlplane_db_table_walk_mgr_h
 
 #include <list>
+#include <map>
 #include <set>
+#include <vector>
 
 #include <boost/assign.hpp>
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include <tbb/task.h>
 
@@ -22,6 +25,8 @@
 
 #include "db/db_table.h"
 
+class ShowDBTableWalkMgrStats;
+
 //
 // DBTableWalkMgr:
 // ==============
@@ -62,20 +67,35 @@
 //    restarted from beginning of DBTable. This API should be called from a task
 //    which is mutually exclusive from db::Walker task.
 //
-// DBTableWalkMgr ensures that not more than one DBTable is walked at any point
-// in time. All other DBTable walk requests are queued and taken up only after
-// current walk completes.
+// DBTableWalkMgr walks up to max_concurrent_walks_ different DBTables at any
+// point in time. All other DBTable walk requests are queued and taken up when
+// one of the current walks completes. A given DBTable is never walked by more
+// than one walk at a time, requests on a table that is being walked wait for
+// the current walk of the table to complete.
 // Actual DBTable walk (i.e. iterating the DBTablePartition) is performed in
 // db::DBTable task or task id configured with DBTable::SetWalkTaskId with
-// instance id set as partition index.
-// The advantage of running DBTable walk in serial manner is in clubbing
-// multiple walk requests on a given table and serving such requests in one
-// iteration of DBTable walk
+// instance id set as partition index. Walks on different tables hence run
+// concurrently on different partitions, and interleave on the same partition.
+// The advantage of queueing walk requests per table is in clubbing multiple
+// walk requests on a given table and serving such requests in one iteration
+// of DBTable walk
+//
+// Walk budget:
+// ===========
+// To keep route processing responsive while several tables are walked, the
+// number of entries visited by all walks can be limited with a budget of
+// walk_budget_ entries per kWalkBudgetIntervalUsecs. A walk worker that finds
+// the budget exhausted is parked without visiting any entry and gives up its
+// partition. Parked workers are resumed when a running worker starts the next
+// interval. The last running worker is never parked, so that there is always
+// one to resume the others. A worker is charged for the entries it actually
+// visited. The budget is unlimited by default.
 //
 // WalkReqList holds list of DBTableWalkRef(i.e. walkers created by multiple
 // application modules) that requested for DBTable walk on a specific table.
-// InvokeWalkCb notifies all such walkers stored in current_table_walk_, while
-// iterating through DBTable entries
+// The list of the walk in progress on a table is kept in the DBTable.
+// InvokeWalkCb notifies all such walkers, while iterating through DBTable
+// entries
 //
 // WalkRequestInfo:
 // ===============
@@ -87,9 +107,10 @@
 // walk_request_list_ holds list of WalkRequestInfo. This list is keyed by
 // DBTable. Additional walk_request_set_ is maintained for easy search of
 // WalkRequestInfo for a given DBTable.
-// Current table on which walk is going on will not be present in the
-// walk_request_list_. If caller requests for WalkAgain(), it is added back to
-// the walk_request_list_ (in the end of the list).
+// Tables on which walk is going on are kept in walk_in_progress_map_ and
+// are not present in the walk_request_list_. If caller requests for
+// WalkAgain(), the table is added back to the walk_request_list_ (in the end
+// of the list), and is walked again once the current walk completes.
 //
 // Task Triggers:
 // walk_request_trigger_ : Task trigger which evaluate walk_request_list_.
@@ -98,12 +119,19 @@
 //
 // walk_done_trigger_ : Task trigger ensures that WalkCompleteFn is triggered
 // in db::Walker task context for all DBTableWalkRef which requested for
-// current DBTable walk. At the end of ProcessWalkDone, walk_request_trigger_ is
-// triggered to evaluate walk request from top of walk_request_list_.
+// the DBTable walks in walk_done_list_. At the end of ProcessWalkDone,
+// walk_request_trigger_ is triggered to evaluate walk_request_list_.
 //
 class DBTableWalkMgr {
 public:
+    // Tables are walked one at a time, in request order, by default.
+    // Concurrent walks and the walk budget are opt-in, see
+    // SetMaxConcurrentWalks and SetWalkBudget.
+    static const int kDefaultMaxConcurrentWalks = 1;
+    static const uint64_t kWalkBudgetIntervalUsecs = 10000;
+
     DBTableWalkMgr();
+    ~DBTableWalkMgr();
 
     void DisableWalkProcessing() {
         walk_request_trigger_->set_disable();
@@ -121,13 +149,31 @@ public:
         walk_done_trigger_->set_enable();
     }
 
+    // Maximum number of tables walked at the same time
+    void SetMaxConcurrentWalks(size_t count);
+    size_t max_concurrent_walks() const { return max_concurrent_walks_; }
+
+    // Maximum number of entries visited by all walks per
+    // kWalkBudgetIntervalUsecs. 0 for unlimited
+    void SetWalkBudget(uint32_t budget);
+    uint32_t walk_budget() const { return walk_budget_; }
+
+    size_t walk_queue_depth() const;
+    size_t walks_in_progress() const;
+    uint64_t walk_budget_yield_count() const {
+        return walk_budget_yield_count_;
+    }
+    void FillWalkStats(ShowDBTableWalkMgrStats *stats) const;
+
+    // Fill stats of all DBTableWalkMgr instances, for introspect
+    static void FillAllWalkStats(std::vector<ShowDBTableWalkMgrStats> *list);
+
 private:
     friend class DBTable;
     typedef std::set<DBTable::DBTableWalkRef> WalkReqList;
 
     struct WalkRequestInfo {
-        WalkRequestInfo(DBTable *table) : table(table) {
-        }
+        WalkRequestInfo(DBTable *table);
 
         void AppendWalkReq(DBTable::DBTableWalkRef ref) {
             pending_requests.insert(ref);
@@ -142,6 +188,8 @@ private:
         }
         DBTable *table;
         WalkReqList pending_requests;
+        // Time of the first request, to compute walk latency
+        uint64_t request_time;
     };
 
     struct WalkRequestCompare {
@@ -153,6 +201,12 @@ private:
     typedef boost::shared_ptr<WalkRequestInfo> WalkRequestInfoPtr;
     typedef std::list<WalkRequestInfoPtr> WalkRequestInfoList;
     typedef std::set<WalkRequestInfo *, WalkRequestCompare> WalkRequestInfoSet;
+    // Tables being walked, with the time walk was requested
+    typedef std::map<DBTable *, uint64_t> WalkInProgressMap;
+    typedef std::list<DBTable *> WalkDoneList;
+    typedef std::list<Task *> WalkWorkerList;
+    // Create the task that continues the walk of a parked walk worker
+    typedef boost::function<Task *(void)> ParkFn;
 
     // Create a DBTable Walker
     DBTable::DBTableWalkRef AllocWalker(DBTable *table, DBTable::WalkFn walk_fn,
@@ -165,7 +219,7 @@ private:
     void WalkTable(DBTable::DBTableWalkRef walk);
 
     // DBTable finished walking
-    void WalkDone();
+    void WalkDone(DBTable *table);
 
     // Walk the table again
     void WalkAgain(DBTable::DBTableWalkRef walk);
@@ -173,19 +227,53 @@ private:
     bool ProcessWalkRequestList();
 
     bool ProcessWalkDone();
+    void ProcessTableWalkDone(DBTable *table);
+
+    bool InvokeWalkCb(DBTable *table, DBTablePartBase *part,
+                      DBEntryBase *entry);
+
+    // Check budget before visiting the next batch of entries. Return false if
+    // the walk worker got parked, park_fn is used to create the task that
+    // resumes it.
+    bool AcquireWalkBudget(ParkFn park_fn);
+    // Charge count entries visited by a walk worker to the budget
+    void ChargeWalkBudget(int count);
+    void ResumeParkedWalkWorkers();
 
-    bool InvokeWalkCb(DBTablePartBase *part, DBEntryBase *entry);
+    // Track walk workers that are not done with their partition, running or
+    // parked
+    void WalkWorkersStart(size_t count);
+    void WalkWorkerDone();
 
     boost::scoped_ptr<TaskTrigger> walk_request_trigger_;
     boost::scoped_ptr<TaskTrigger> walk_done_trigger_;
 
-    // Mutex to protect walk_request_list_ and walk_request_set_ as
-    // Walk can be requested from task which may run concurrently
-    tbb::mutex mutex_;
+    // Mutex to protect walk_request_list_, walk_request_set_ and
+    // walk_in_progress_map_ as Walk can be requested from task which may run
+    // concurrently
+    mutable tbb::mutex mutex_;
     WalkRequestInfoList walk_request_list_;
     WalkRequestInfoSet walk_request_set_;
+    WalkInProgressMap walk_in_progress_map_;
+
+    // Tables done walking, filled from the last walk worker of each table
+    tbb::mutex walk_done_mutex_;
+    WalkDoneList walk_done_list_;
+
+    size_t max_concurrent_walks_;
+    tbb::atomic<uint32_t> walk_budget_;
+    tbb::atomic<uint64_t> walk_budget_interval_start_;
+    tbb::atomic<int64_t> walk_budget_used_;
+    tbb::atomic<uint64_t> walk_budget_yield_count_;
+
+    // Mutex to protect walk_worker_count_ and parked_walk_workers_
+    tbb::mutex walk_budget_mutex_;
+    size_t walk_worker_count_;
+    WalkWorkerList parked_walk_workers_;
 
-    WalkReqList current_table_walk_;
+    tbb::atomic<uint64_t> walk_complete_count_;
+    tbb::atomic<uint64_t> walk_latency_total_;
+    tbb::atomic<uint64_t> walk_latency_max_;
 
     DISALLOW_COPY_AND_ASSIGN(DBTableWalkMgr);
 };
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "db/db_btree.h"
+#include "db/db_entry.h"
+#include "db/db_table.h"
+
+#include "base/logging.h"
+#include "testing/gunit.h"
+
+struct BTreeTestKey : public DBRequestKey {
+    explicit BTreeTestKey(uint32_t key) : key(key) { }
+    uint32_t key;
+};
+
+class BTreeTestEntry : public DBEntry {
+public:
+    explicit BTreeTestEntry(uint32_t key) : key_(key) { }
+
+    bool IsLess(const DBEntry &rhs) const {
+        const BTreeTestEntry &a = static_cast<const BTreeTestEntry &>(rhs);
+        return key_ < a.key_;
+    }
+
+    void SetKey(const DBRequestKey *key) {
+        key_ = static_cast<const BTreeTestKey *>(key)->key;
+    }
+
+    virtual KeyPtr GetDBRequestKey() const {
+        return KeyPtr(new BTreeTestKey(key_));
+    }
+
+    std::string ToString() const { return "BTreeTestEntry"; }
+
+    uint32_t key() const { return key_; }
+
+private:
+    uint32_t key_;
+    DISALLOW_COPY_AND_ASSIGN(BTreeTestEntry);
+};
+
+class DBBTreeTest : public ::testing::Test {
+protected:
+    virtual void TearDown() {
+        STLDeleteValues(&entries_);
+    }
+
+    // Allocate count entries with keys 0 to count - 1, in random order
+    void AllocEntries(uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            entries_.push_back(new BTreeTestEntry(i));
+        }
+        std::random_shuffle(entries_.begin(), entries_.end());
+    }
+
+    uint32_t Key(const DBEntry *entry) const {
+        return static_cast<const BTreeTestEntry *>(entry)->key();
+    }
+
+    // Walk the tree with UpperBound and with Next, and check both match the
+    // reference
+    void Verify(const DBBTree &tree, const std::set<uint32_t> &reference) {
+        EXPECT_EQ(reference.size(), tree.size());
+        std::set<uint32_t>::const_iterator it = reference.begin();
+        for (DBEntry *entry = tree.First(); entry;
+             entry = tree.UpperBound(entry), ++it) {
+            ASSERT_TRUE(it != reference.end());
+            ASSERT_EQ(*it, Key(entry));
+        }
+        EXPECT_TRUE(it == reference.end());
+
+        it = reference.begin();
+        for (DBEntry *entry = tree.First(); entry;
+             entry = tree.Next(entry), ++it) {
+            ASSERT_TRUE(it != reference.end());
+            ASSERT_EQ(*it, Key(entry));
+        }
+        EXPECT_TRUE(it == reference.end());
+    }
+
+    std::vector<BTreeTestEntry *> entries_;
+};
+
+// Random inserts and removes, compared with std::set
+TEST_F(DBBTreeTest, Random) {
+    const uint32_t kKeyCount = 64 * 1024;
+    AllocEntries(kKeyCount);
+    std::vector<BTreeTestEntry *> by_key(kKeyCount);
+    for (size_t i = 0; i < entries_.size(); i++) {
+        by_key[entries_[i]->key()] = entries_[i];
+    }
+
+    DBBTree tree;
+    std::set<uint32_t> reference;
+    srand(1);
+    for (int round = 0; round < 8; round++) {
+        // Grow on even rounds, shrink on odd rounds
+        int insert_ratio = (round % 2 == 0) ? 3 : 1;
+        for (uint32_t i = 0; i < kKeyCount; i++) {
+            uint32_t key = rand() % kKeyCount;
+            if (rand() % 4 < insert_ratio) {
+                EXPECT_EQ(reference.insert(key).second,
+                          tree.Insert(by_key[key]));
+            } else {
+                EXPECT_EQ(reference.erase(key) == 1,
+                          tree.Remove(by_key[key]));
+            }
+        }
+        Verify(tree, reference);
+
+        for (uint32_t i = 0; i < 1024; i++) {
+            BTreeTestEntry key(rand() % (kKeyCount + 1));
+            std::set<uint32_t>::const_iterator it =
+                reference.lower_bound(key.key());
+            DBEntry *entry = tree.LowerBound(&key);
+            EXPECT_EQ(it == reference.end(), entry == NULL);
+            if (entry) {
+                EXPECT_EQ(*it, Key(entry));
+            }
+            it = reference.upper_bound(key.key());
+            entry = tree.UpperBound(&key);
+            EXPECT_EQ(it == reference.end(), entry == NULL);
+            if (entry) {
+                EXPECT_EQ(*it, Key(entry));
+            }
+            EXPECT_EQ(reference.count(key.key()) == 1,
+                      tree.Find(&key) != NULL);
+        }
+    }
+
+    // Remove everything
+    for (uint32_t key = 0; key < kKeyCount; key++) {
+        EXPECT_EQ(reference.erase(key) == 1, tree.Remove(by_key[key]));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(1, tree.depth());
+    EXPECT_TRUE(tree.First() == NULL);
+    BTreeTestEntry key(0);
+    EXPECT_TRUE(tree.LowerBound(&key) == NULL);
+}
+
+// Duplicate keys are rejected
+TEST_F(DBBTreeTest, Duplicate) {
+    DBBTree tree;
+    BTreeTestEntry e1(1), e2(1);
+    EXPECT_TRUE(tree.Insert(&e1));
+    EXPECT_FALSE(tree.Insert(&e2));
+    EXPECT_EQ(&e1, tree.Find(&e2));
+    EXPECT_TRUE(tree.Remove(&e2));
+    EXPECT_FALSE(tree.Remove(&e1));
+}
+
+// Walk with Next while entries are added and removed, including the entry
+// the walk is on, as walk callbacks may do through the table
+TEST_F(DBBTreeTest, NextWhileModified) {
+    const uint32_t kKeyCount = 16 * 1024;
+    AllocEntries(kKeyCount);
+    std::vector<BTreeTestEntry *> by_key(kKeyCount);
+    for (size_t i = 0; i < entries_.size(); i++) {
+        by_key[entries_[i]->key()] = entries_[i];
+    }
+
+    DBBTree tree;
+    std::set<uint32_t> reference;
+    for (uint32_t key = 0; key < kKeyCount; key += 2) {
+        tree.Insert(by_key[key]);
+        reference.insert(key);
+    }
+
+    srand(1);
+    uint32_t visited = 0;
+    for (DBEntry *entry = tree.First(); entry; visited++) {
+        uint32_t current = Key(entry);
+        for (int i = 0; i < 4; i++) {
+            uint32_t key = rand() % kKeyCount;
+            if (rand() % 2) {
+                EXPECT_EQ(reference.insert(key).second,
+                          tree.Insert(by_key[key]));
+            } else {
+                EXPECT_EQ(reference.erase(key) == 1,
+                          tree.Remove(by_key[key]));
+            }
+        }
+        // Drop the current entry now and then
+        if (rand() % 8 == 0) {
+            reference.erase(current);
+            tree.Remove(entry);
+        }
+
+        std::set<uint32_t>::const_iterator it =
+            reference.upper_bound(current);
+        entry = tree.Next(entry);
+        ASSERT_EQ(it == reference.end(), entry == NULL);
+        if (entry) {
+            ASSERT_EQ(*it, Key(entry));
+        }
+    }
+    EXPECT_GT(visited, 0U);
+    Verify(tree, reference);
+}
+
+// Large tree: every entry is found and walked once, and the tree stays
+// shallow
+TEST_F(DBBTreeTest, Scale) {
+    const uint32_t kKeyCount = 1000 * 1000;
+    AllocEntries(kKeyCount);
+
+    DBBTree tree;
+    for (uint32_t i = 0; i < kKeyCount; i++) {
+        EXPECT_TRUE(tree.Insert(entries_[i]));
+    }
+    EXPECT_EQ(kKeyCount, tree.size());
+    // Nodes are at least half full after random inserts
+    EXPECT_LE(tree.depth(), 4);
+
+    std::random_shuffle(entries_.begin(), entries_.end());
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < kKeyCount; i++) {
+        found += (tree.Find(entries_[i]) == entries_[i]);
+    }
+    EXPECT_EQ(kKeyCount, found);
+
+    uint32_t walked = 0;
+    uint32_t expected = 0;
+    for (DBEntry *entry = tree.First(); entry; entry = tree.Next(entry)) {
+        ASSERT_EQ(expected++, Key(entry));
+        walked++;
+    }
+    EXPECT_EQ(kKeyCount, walked);
+
+    for (uint32_t i = 0; i < kKeyCount; i++) {
+        EXPECT_TRUE(tree.Remove(entries_[i]));
+    }
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(1, tree.depth());
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -275,6 +275,110 @@ TEST_F(DBTest, Find) {
     del_notification = 0;
 }
 
+// Requests of a batch are processed in order within a partition
+TEST_F(DBTest, EnqueueBatch) {
+    const int num_entries = 1000;
+    tid_ = itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    adc_notification = 0;
+    del_notification = 0;
+
+    // More than a chunk of requests per partition
+    DBRequestBatch batch(itbl);
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest addReq(DBRequest::DB_ENTRY_ADD_CHANGE);
+        addReq.key.reset(new VlanTableReqKey(idx));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        batch.Add(&addReq);
+        EXPECT_TRUE(addReq.key.get() == NULL);
+    }
+    // Delete of an entry added earlier in the same batch
+    DBRequest delReq(DBRequest::DB_ENTRY_DELETE);
+    delReq.key.reset(new VlanTableReqKey(0));
+    batch.Add(&delReq);
+    EXPECT_EQ(num_entries + 1U, batch.size());
+
+    uint64_t enqueue_count = itbl->enqueue_count();
+    itbl->EnqueueBatch(&batch);
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(enqueue_count + num_entries + 1, itbl->enqueue_count());
+    task_util::WaitForIdle();
+    EXPECT_EQ(num_entries - 1U, itbl->Size());
+
+    // Requests of a batch not enqueued are freed with the batch
+    {
+        DBRequestBatch unused(itbl);
+        DBRequest addReq(DBRequest::DB_ENTRY_ADD_CHANGE);
+        addReq.key.reset(new VlanTableReqKey(0));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        unused.Add(&addReq);
+    }
+    task_util::WaitForIdle();
+    EXPECT_EQ(num_entries - 1U, itbl->Size());
+
+    for (int idx = 1; idx < num_entries; ++idx) {
+        DBRequest delReq(DBRequest::DB_ENTRY_DELETE);
+        delReq.key.reset(new VlanTableReqKey(idx));
+        batch.Add(&delReq);
+    }
+    itbl->EnqueueBatch(&batch);
+    TASK_UTIL_EXPECT_EQ(0, itbl->Size());
+    itbl->Unregister(tid_);
+}
+
+// Requests enqueued in many batches are all processed once, in order within
+// a partition
+TEST_F(DBTest, EnqueueBatchScale) {
+    const int num_entries = 64 * 1024 - 1;
+    const size_t batch_size = 500;
+    tid_ = itbl->Register(boost::bind(&DBTest::DBTestListener, this, _1, _2));
+    adc_notification = 0;
+    del_notification = 0;
+
+    uint64_t enqueue_count = itbl->enqueue_count();
+    DBRequestBatch batch(itbl);
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest addReq(DBRequest::DB_ENTRY_ADD_CHANGE);
+        addReq.key.reset(new VlanTableReqKey(idx));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        batch.Add(&addReq);
+        if (batch.size() == batch_size) {
+            itbl->EnqueueBatch(&batch);
+            EXPECT_TRUE(batch.empty());
+        }
+    }
+    itbl->EnqueueBatch(&batch);
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(enqueue_count + num_entries, itbl->enqueue_count());
+    task_util::WaitForIdle();
+    EXPECT_EQ(num_entries, itbl->Size());
+    EXPECT_EQ(num_entries, adc_notification);
+    EXPECT_EQ(0, del_notification);
+
+    // Change and delete of each entry in the same batch, the delete is
+    // processed last
+    adc_notification = 0;
+    for (int idx = 0; idx < num_entries; ++idx) {
+        DBRequest addReq(DBRequest::DB_ENTRY_ADD_CHANGE);
+        addReq.key.reset(new VlanTableReqKey(idx));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan Change"));
+        batch.Add(&addReq);
+        DBRequest delReq(DBRequest::DB_ENTRY_DELETE);
+        delReq.key.reset(new VlanTableReqKey(idx));
+        batch.Add(&delReq);
+        if (batch.size() >= batch_size)
+            itbl->EnqueueBatch(&batch);
+    }
+    itbl->EnqueueBatch(&batch);
+    EXPECT_EQ(enqueue_count + 3 * num_entries, itbl->enqueue_count());
+    TASK_UTIL_EXPECT_EQ(0, itbl->Size());
+    TASK_UTIL_EXPECT_EQ(num_entries, del_notification);
+    EXPECT_LE(adc_notification, num_entries);
+
+    itbl->Unregister(tid_);
+    adc_notification = 0;
+    del_notification = 0;
+}
+
 void RegisterFactory() {
     DB::RegisterFactory("db.test.vlan.0", &VlanTable::CreateTable);
     DB::RegisterFactory("db.test.vlan.1", &VlanTable::CreateTable);
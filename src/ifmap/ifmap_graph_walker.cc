@@ -75,7 +75,9 @@ IFMapGraphWalker::IFMapGraphWalker(DBGraph *graph, IFMapExporter *exporter)
       link_delete_walk_trigger_(new TaskTrigger(
           boost::bind(&IFMapGraphWalker::LinkDeleteWalk, this),
           TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"), 0)),
-      walk_client_index_(BitSet::npos) {
+      walk_client_index_(BitSet::npos),
+      link_delete_batch_size_(kMaxLinkDeleteWalks),
+      link_delete_walk_count_(0) {
     traversal_white_list_.reset(new IFMapTypenameWhiteList());
     AddNodesToWhitelist();
 }
@@ -148,11 +150,27 @@ bool IFMapGraphWalker::FilterNeighbor(IFMapNode *lnode, IFMapLink *link) {
     return false;
 }
 
-void IFMapGraphWalker::RecomputeInterest(DBGraphVertex *vertex, int bit) {
-    IFMapNode *node = static_cast<IFMapNode *>(vertex);
-    IFMapNodeState *state = exporter_->NodeStateLocate(node);
-    state->nmask_set(bit);
-    UpdateNewReachableNodesTracker(bit, state);
+void IFMapGraphWalker::AddReachableNode(IFMapNodeState *state,
+                                        const BitSet &bset) {
+    if (state->nmask().empty()) {
+        reachable_nodes_.push_back(state);
+    }
+    state->nmask_or(bset);
+}
+
+// The clients that reach source also reach target. Returns true if target
+// is reached by clients that did not reach it yet.
+bool IFMapGraphWalker::PropagateInterest(DBGraphVertex *source,
+                                         DBGraphVertex *target) {
+    IFMapNodeState *src_state =
+        exporter_->NodeStateLocate(static_cast<IFMapNode *>(source));
+    IFMapNodeState *tgt_state =
+        exporter_->NodeStateLocate(static_cast<IFMapNode *>(target));
+    if (tgt_state->nmask().Contains(src_state->nmask())) {
+        return false;
+    }
+    AddReachableNode(tgt_state, src_state->nmask());
+    return true;
 }
 
 bool IFMapGraphWalker::LinkDeleteWalk() {
@@ -173,21 +191,22 @@ bool IFMapGraphWalker::LinkDeleteWalk() {
     }
     int count = 0;
     BitSet done_set;
+    std::vector<DBGraphVertex *> start;
+    IFMapTable *table = IFMapTable::FindTable(server->database(),
+                                              "virtual-router");
     while (i != BitSet::npos) {
         IFMapClient *client = server->GetClient(i);
         assert(client);
-        AddNewReachableNodesTracker(client->index());
 
-        IFMapTable *table = IFMapTable::FindTable(server->database(),
-                                                  "virtual-router");
         IFMapNode *node = table->FindNode(client->identifier());
         if ((node != NULL) && node->IsVertexValid()) {
-            graph_->Visit(node,
-                boost::bind(&IFMapGraphWalker::RecomputeInterest, this, _1, i),
-                0, *traversal_white_list_.get());
+            BitSet bset;
+            bset.set(i);
+            AddReachableNode(exporter_->NodeStateLocate(node), bset);
+            start.push_back(node);
         }
         done_set.set(i);
-        if (++count == kMaxLinkDeleteWalks) {
+        if (++count == link_delete_batch_size_) {
             // client 'i' has been processed. If 'i' is the last bit set, we
             // will return true below. Else we will return false and there
             // is atleast one more bit left to process.
@@ -196,6 +215,14 @@ bool IFMapGraphWalker::LinkDeleteWalk() {
 
         i = link_delete_clients_.find_next(i);
     }
+
+    // Compute the nmask of all the nodes reachable by the clients in
+    // done_set in a single traversal.
+    graph_->Propagate(start,
+        boost::bind(&IFMapGraphWalker::PropagateInterest, this, _1, _2),
+        *traversal_white_list_.get());
+    link_delete_walk_count_++;
+
     // Remove the subset of clients that we have finished processing.
     ResetLinkDeleteClients(done_set);
 
@@ -218,11 +245,9 @@ void IFMapGraphWalker::ResetLinkDeleteClients(const BitSet &bset) {
     link_delete_clients_.Reset(bset);
 }
 
-void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
+void IFMapGraphWalker::CleanupInterest(const BitSet &rm_mask,
+                                       IFMapNode *node,
                                        IFMapNodeState *state) {
-    BitSet rm_mask;
-    rm_mask.set(client_index);
-
     // interest = interest - rm_mask + nmask
 
     if (!state->interest().empty() && !state->nmask().empty()) {
@@ -249,10 +274,12 @@ void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
     }
 }
 
-// Cleanup all the graph nodes that were reachable before this link delete.
-// After this link delete, these nodes may still be reachable. But, its
-// also possible that the link delete has made them unreachable.
-void IFMapGraphWalker::OldReachableNodesCleanupInterest(int client_index) {
+// Cleanup all the graph nodes that were reachable before this link delete
+// and that the walk did not reach, i.e. that the link delete has made
+// unreachable for all the clients in done_set. The nodes reached by the walk
+// are handled by ReachableNodesCleanupInterest().
+void IFMapGraphWalker::OldReachableNodesCleanupInterest(int client_index,
+        const BitSet &done_set) {
     IFMapState *state = NULL;
     IFMapNode *node = NULL;
     IFMapExporter::Cs_citer iter = exporter_->ClientConfigTrackerBegin(
@@ -272,70 +299,34 @@ void IFMapGraphWalker::OldReachableNodesCleanupInterest(int client_index) {
             assert(node);
             IFMapNodeState *nstate = exporter_->NodeStateLookup(node);
             assert(state == nstate);
-            CleanupInterest(client_index, node, nstate);
+            if (nstate->nmask().empty()) {
+                CleanupInterest(done_set, node, nstate);
+            }
         }
     }
 }
 
-// Cleanup all the graph nodes that were not reachable before the link delete
-// but are reachable now. Note, we store nodes in new_reachable_nodes_tracker_
-// only if we visited them during the graph-walk via RecomputeInterest() and if
-// their interest bit was not set i.e. they were not reachable before we
-// started the walk.
-void IFMapGraphWalker::NewReachableNodesCleanupInterest(int client_index) {
-    IFMapState *state = NULL;
-    IFMapNode *node = NULL;
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-
-    for (Rns_citer iter = rnset->begin(); iter != rnset->end(); ++iter) {
-        state = *iter;
-        assert(state->IsNode());
-        node = state->GetIFMapNode();
+// Cleanup all the graph nodes reached by the walk, whether they were
+// reachable before the link delete or not. Clears their nmask.
+void IFMapGraphWalker::ReachableNodesCleanupInterest(const BitSet &done_set) {
+    for (std::vector<IFMapNodeState *>::const_iterator iter =
+         reachable_nodes_.begin(); iter != reachable_nodes_.end(); ++iter) {
+        IFMapNodeState *state = *iter;
+        IFMapNode *node = state->GetIFMapNode();
         assert(node);
-        IFMapNodeState *nstate = exporter_->NodeStateLookup(node);
-        assert(state == nstate);
-        CleanupInterest(client_index, node, nstate);
+        CleanupInterest(done_set, node, state);
     }
-    DeleteNewReachableNodesTracker(client_index);
+    reachable_nodes_.clear();
 }
 
 void IFMapGraphWalker::LinkDeleteWalkBatchEnd(const BitSet &done_set) {
+    // Examine all the nodes that were reachable before the link delete.
     for (size_t i = done_set.find_first(); i != BitSet::npos;
             i = done_set.find_next(i)) {
-        // Examine all the nodes that were reachable before the link delete.
-        OldReachableNodesCleanupInterest(i);
-        // Examine all the nodes that were not reachable before the link
-        // delete but are now reachable.
-        NewReachableNodesCleanupInterest(i);
-    }
-}
-
-void IFMapGraphWalker::AddNewReachableNodesTracker(int client_index) {
-    if (client_index >= (int)new_reachable_nodes_tracker_.size()) {
-        new_reachable_nodes_tracker_.resize(client_index + 1, NULL);
-    }
-    assert(new_reachable_nodes_tracker_[client_index] == NULL);
-    ReachableNodesSet *rnset = new ReachableNodesSet();
-    new_reachable_nodes_tracker_[client_index] = rnset;
-}
-
-void IFMapGraphWalker::DeleteNewReachableNodesTracker(int client_index) {
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-    assert(rnset);
-    delete rnset;
-    new_reachable_nodes_tracker_[client_index] = NULL;
-}
-
-// Keep track of this node if it was unreachable earlier.
-void IFMapGraphWalker::UpdateNewReachableNodesTracker(int client_index,
-                                                      IFMapState *state) {
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-    assert(rnset);
-    // If the interest is not set, the node was not reachable earlier but is
-    // reachable now.
-    if (!state->interest().test(client_index)) {
-        rnset->insert(state);
+        OldReachableNodesCleanupInterest(i, done_set);
     }
+    // Examine all the nodes that are reachable now.
+    ReachableNodesCleanupInterest(done_set);
 }
 
 const IFMapTypenameWhiteList &IFMapGraphWalker::get_traversal_white_list()
@@ -20,11 +20,16 @@ class TaskTrigger;
 struct IFMapTypenameWhiteList;
 
 // Computes the interest graph for the ifmap clients (i.e. vnc agent).
+//
+// On link delete, the interest of the affected clients is recomputed in
+// batches. A single traversal from the virtual-router nodes of the clients
+// in a batch propagates the set of clients reaching each node, so that a
+// change to a node shared by many clients, such as a security group, walks
+// the shared part of the graph once per batch rather than once per client.
 class IFMapGraphWalker {
 public:
-    typedef std::set<IFMapState *> ReachableNodesSet;
-    typedef ReachableNodesSet::const_iterator Rns_citer;
-    typedef std::vector<ReachableNodesSet *> ReachableNodesTracker;
+    // Number of clients whose interest is recomputed by one traversal
+    static const int kMaxLinkDeleteWalks = 256;
 
     IFMapGraphWalker(DBGraph *graph, IFMapExporter *exporter);
     ~IFMapGraphWalker();
@@ -40,25 +45,31 @@ public:
     const IFMapTypenameWhiteList &get_traversal_white_list() const;
     void ResetLinkDeleteClients(const BitSet &bset);
 
-private:
-    static const int kMaxLinkDeleteWalks = 1;
+    int link_delete_batch_size() const { return link_delete_batch_size_; }
+    void set_link_delete_batch_size(int size) {
+        link_delete_batch_size_ = size;
+    }
+    // Number of link delete traversals, one per batch of clients
+    uint64_t link_delete_walk_count() const {
+        return link_delete_walk_count_;
+    }
 
+private:
     void ProcessLinkAdd(IFMapNode *lnode, IFMapNode *rnode, const BitSet &bset);
     void JoinVertex(DBGraphVertex *vertex, const BitSet &bset);
     void NotifyEdge(DBGraphEdge *edge, const BitSet &bset);
-    void RecomputeInterest(DBGraphVertex *vertex, int bit);
-    void CleanupInterest(int client_index, IFMapNode *node,
+    void AddReachableNode(IFMapNodeState *state, const BitSet &bset);
+    bool PropagateInterest(DBGraphVertex *source, DBGraphVertex *target);
+    void CleanupInterest(const BitSet &rm_mask, IFMapNode *node,
                          IFMapNodeState *state);
     void AddNodesToWhitelist();
     void AddLinksToWhitelist();
     bool LinkDeleteWalk();
     void LinkDeleteWalkBatchEnd(const BitSet &done_set);
     void OrLinkDeleteClients(const BitSet &bset);
-    void AddNewReachableNodesTracker(int client_index);
-    void DeleteNewReachableNodesTracker(int client_index);
-    void UpdateNewReachableNodesTracker(int client_index, IFMapState *state);
-    void OldReachableNodesCleanupInterest(int client_index);
-    void NewReachableNodesCleanupInterest(int client_index);
+    void OldReachableNodesCleanupInterest(int client_index,
+                                          const BitSet &done_set);
+    void ReachableNodesCleanupInterest(const BitSet &done_set);
 
     DBGraph *graph_;
     IFMapExporter *exporter_;
@@ -66,7 +77,11 @@ private:
     std::auto_ptr<IFMapTypenameWhiteList> traversal_white_list_;
     BitSet link_delete_clients_;
     size_t walk_client_index_;
-    ReachableNodesTracker new_reachable_nodes_tracker_;
+    int link_delete_batch_size_;
+    uint64_t link_delete_walk_count_;
+    // Nodes reached by the current link delete walk, i.e. with a non empty
+    // nmask
+    std::vector<IFMapNodeState *> reachable_nodes_;
 };
 
 #endif /* defined(__ctrlplane__ifmap_graph_walker__) */
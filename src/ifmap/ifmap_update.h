@@ -193,6 +193,7 @@ public:
     const BitSet &nmask() const { return nmask_; }
     void nmask_clear() { nmask_.clear(); }
     void nmask_set(int bit) { nmask_.set(bit); }
+    void nmask_or(const BitSet &bset) { nmask_ |= bset; }
     virtual bool CanDelete() {
         return (update_list().empty() && IsInvalid() && !HasDependents());
     }
@@ -5,6 +5,7 @@
 #include "ifmap/ifmap_exporter.h"
 
 #include "base/logging.h"
+#include "base/string_util.h"
 #include "base/test/task_test_util.h"
 #include "control-node/control_node.h"
 #include "db/db.h"
@@ -13,6 +14,7 @@
 #include "io/test/event_manager_test.h"
 #include "ifmap/ifmap_client.h"
 #include "ifmap/ifmap_factory.h"
+#include "ifmap/ifmap_graph_walker.h"
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_server.h"
 #include "ifmap/ifmap_server_table.h"
@@ -234,6 +236,15 @@ protected:
         return link;
     }
 
+    bool NodeHasInterest(const string &type, const string &name, int index) {
+        IFMapNode *node = TableLookup(type, name);
+        if (node == NULL) {
+            return false;
+        }
+        IFMapNodeState *state = exporter_->NodeStateLookup(node);
+        return (state != NULL && state->interest().test(index));
+    }
+
     void ParseEventsJson (string events_file) {
         ConfigCassandraClientTest::ParseEventsJson(config_client_manager_.get(),
                 events_file);
@@ -1282,6 +1293,127 @@ TEST_F(IFMapExporterTest, ConfigTracker) {
     TASK_UTIL_EXPECT_EQ(LinkTableSize(), 10);
 }
 
+// Remove a link to a node shared by several clients. The clients that still
+// reach the node through another path keep their interest in it.
+TEST_F(IFMapExporterTest, LinkDeleteSharedNode) {
+    server_->SetSender(new IFMapUpdateSenderMock(server_.get()));
+    TestClient c1("192.168.1.1");
+    TestClient c2("192.168.1.2");
+    TestClient c3("192.168.1.3");
+    TestClient c4("192.168.1.4");
+    TestClient *clients[] = { &c1, &c2, &c3, &c4 };
+    for (int i = 0; i < 4; i++) {
+        ClientSetup(clients[i]);
+        string vm = "vm_c" + integerToString(i + 1);
+        string vmi = vm + ":veth0";
+        IFMapMsgLink("virtual-router", "virtual-machine",
+                     clients[i]->identifier(), vm);
+        IFMapMsgLink("virtual-machine", "virtual-machine-interface", vm, vmi,
+                     "virtual-machine-interface-virtual-machine");
+        IFMapMsgLink("virtual-machine-interface", "security-group", vmi,
+                     "sg1");
+    }
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_c1:veth0", "blue");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_c2:veth0", "blue");
+    IFMapMsgLink("virtual-network", "access-control-list", "blue", "acl1");
+    IFMapMsgLink("security-group", "access-control-list", "sg1", "acl1");
+    task_util::WaitForIdle();
+
+    for (int i = 0; i < 4; i++) {
+        TASK_UTIL_EXPECT_TRUE(NodeHasInterest("access-control-list", "acl1",
+                                              clients[i]->index()));
+    }
+
+    // c3 and c4 reach acl1 only through sg1
+    IFMapMsgUnlink("security-group", "access-control-list", "sg1", "acl1");
+    task_util::WaitForIdle();
+    EXPECT_TRUE(NodeHasInterest("access-control-list", "acl1", c1.index()));
+    EXPECT_TRUE(NodeHasInterest("access-control-list", "acl1", c2.index()));
+    EXPECT_FALSE(NodeHasInterest("access-control-list", "acl1", c3.index()));
+    EXPECT_FALSE(NodeHasInterest("access-control-list", "acl1", c4.index()));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(NodeHasInterest("security-group", "sg1",
+                                    clients[i]->index()));
+    }
+
+    // c1 does not reach anything from its virtual-router anymore
+    IFMapMsgUnlink("virtual-router", "virtual-machine", "192.168.1.1",
+                   "vm_c1");
+    task_util::WaitForIdle();
+    EXPECT_FALSE(NodeHasInterest("access-control-list", "acl1", c1.index()));
+    EXPECT_FALSE(NodeHasInterest("virtual-network", "blue", c1.index()));
+    EXPECT_FALSE(NodeHasInterest("security-group", "sg1", c1.index()));
+    EXPECT_TRUE(NodeHasInterest("access-control-list", "acl1", c2.index()));
+    EXPECT_TRUE(NodeHasInterest("security-group", "sg1", c2.index()));
+    EXPECT_TRUE(NodeHasInterest("security-group", "sg1", c3.index()));
+}
+
+// Link delete on a graph where all the clients share a security group,
+// recomputing the interest of one client per traversal and of a batch of
+// clients per traversal.
+TEST_F(IFMapExporterTest, LinkDeleteWalkScale) {
+    const int kClientCount = 1024;
+    const int kNetworkCount = 16;
+    server_->SetSender(new IFMapUpdateSenderMock(server_.get()));
+
+    std::vector<TestClient *> clients;
+    for (int i = 0; i < kClientCount; i++) {
+        std::stringstream addr;
+        addr << "10.1." << i / 256 << "." << i % 256;
+        TestClient *client = new TestClient(addr.str());
+        clients.push_back(client);
+        ClientSetup(client);
+
+        string vm = "vm_" + integerToString(i);
+        string vmi = vm + ":veth0";
+        string vn = "vn_" + integerToString(i % kNetworkCount);
+        IFMapMsgLink("virtual-router", "virtual-machine", addr.str(), vm);
+        IFMapMsgLink("virtual-machine", "virtual-machine-interface", vm, vmi,
+                     "virtual-machine-interface-virtual-machine");
+        IFMapMsgLink("virtual-machine-interface", "virtual-network", vmi, vn);
+        IFMapMsgLink("virtual-machine-interface", "security-group", vmi,
+                     "sg");
+    }
+    for (int i = 0; i < kNetworkCount; i++) {
+        string vn = "vn_" + integerToString(i);
+        IFMapMsgLink("virtual-network", "access-control-list", vn,
+                     vn + ":acl");
+    }
+    IFMapMsgLink("security-group", "access-control-list", "sg", "sg:acl");
+    task_util::WaitForIdle();
+
+    IFMapGraphWalker *walker = exporter_->graph_walker();
+    const int batch_size[] = { 1, IFMapGraphWalker::kMaxLinkDeleteWalks };
+    for (int run = 0; run < 2; run++) {
+        walker->set_link_delete_batch_size(batch_size[run]);
+        uint64_t walks = walker->link_delete_walk_count();
+        IFMapMsgUnlink("security-group", "access-control-list", "sg",
+                       "sg:acl");
+        task_util::WaitForIdle();
+        EXPECT_EQ(static_cast<uint64_t>(kClientCount / batch_size[run]),
+                  walker->link_delete_walk_count() - walks);
+
+        for (int i = 0; i < kClientCount; i++) {
+            EXPECT_FALSE(NodeHasInterest("access-control-list", "sg:acl",
+                                         clients[i]->index()));
+            EXPECT_TRUE(NodeHasInterest("security-group", "sg",
+                                        clients[i]->index()));
+        }
+
+        IFMapMsgLink("security-group", "access-control-list", "sg",
+                     "sg:acl");
+        task_util::WaitForIdle();
+        for (int i = 0; i < kClientCount; i++) {
+            EXPECT_TRUE(NodeHasInterest("access-control-list", "sg:acl",
+                                        clients[i]->index()));
+        }
+    }
+    walker->set_link_delete_batch_size(IFMapGraphWalker::kMaxLinkDeleteWalks);
+    STLDeleteValues(&clients);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     LoggingInit();
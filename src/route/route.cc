@@ -45,3 +45,60 @@ void Route::Sort(Compare compare, const Path *prev_front) {
         set_last_change_at_to_now();
     }
 }
+
+bool Route::IsSorted(Compare compare) const {
+    PathList::const_iterator prev = path_.begin();
+    if (prev == path_.end())
+        return true;
+    for (PathList::const_iterator it = prev; ++it != path_.end(); prev = it) {
+        if (compare(*it, *prev))
+            return false;
+    }
+    return true;
+}
+
+//
+// The path goes before the first path it is better than, which is where a
+// stable sort puts a path appended to sorted paths. Paths may be out of
+// order if one was modified in place, fall back to a full sort then.
+//
+void Route::InsertSorted(const Path *ipath, Compare compare,
+                         const Path *prev_front) {
+    Path *path = const_cast<Path *> (ipath);
+
+    path->set_time_stamp_usecs(UTCTimestampUsec());
+    PathList::iterator pos = path_.end();
+    PathList::iterator prev = path_.end();
+    bool sorted = true;
+    for (PathList::iterator it = path_.begin(); it != path_.end();
+         prev = it, ++it) {
+        if (prev != path_.end() && compare(*it, *prev)) {
+            sorted = false;
+            break;
+        }
+        if (pos == path_.end() && compare(*path, *it))
+            pos = it;
+    }
+
+    if (sorted) {
+        path_.insert(pos, *path);
+    } else {
+        path_.push_back(*path);
+        path_.sort(compare);
+    }
+
+    // If the best path changes, update route's time stamp.
+    if (prev_front != front()) {
+        set_last_change_at_to_now();
+    }
+}
+
+void Route::SortIfNeeded(Compare compare, const Path *prev_front) {
+    if (!IsSorted(compare))
+        path_.sort(compare);
+
+    // If the best path changes, update route's time stamp.
+    if (prev_front != front()) {
+        set_last_change_at_to_now();
+    }
+}
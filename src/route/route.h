@@ -43,6 +43,15 @@ public:
     // Sort paths based on compare function.
     void Sort(Compare compare, const Path *prev_front);
 
+    // Insert a path at its position in paths sorted based on compare
+    // function. Same result as insert followed by Sort, in linear time when
+    // the paths are in order.
+    void InsertSorted(const Path *path, Compare compare,
+                      const Path *prev_front);
+
+    // Sort paths based on compare function unless they are in order.
+    void SortIfNeeded(Compare compare, const Path *prev_front);
+
     const PathList &GetPathList() const {
         return path_;
     }
@@ -52,6 +61,8 @@ public:
     }
 
 private:
+    bool IsSorted(Compare compare) const;
+
     // Path List
     PathList path_;
 
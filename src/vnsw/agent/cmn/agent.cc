@@ -192,6 +192,7 @@ void Agent::SetAgentTaskPolicy() {
         "Agent::Services",
         "Agent::StatsCollector",
         kTaskFlowStatsCollector,
+        kTaskFlowStatsScan,
         kTaskSessionStatsCollector,
         kTaskSessionStatsCollectorEvent,
         "sandesh::RecvQueue",
@@ -323,19 +324,39 @@ void Agent::SetAgentTaskPolicy() {
     SetTaskPolicyOne(kTaskFlowStatsCollector, flow_stats_exclude_list,
                      sizeof(flow_stats_exclude_list) / sizeof(char *));
 
-    const char *session_stats_exclude_list[] = {
-        kTaskSessionStatsCollectorEvent,
+    // Partitions of the flow table are scanned by different instances in
+    // parallel. The scan timer runs without instance and excludes them
+    const char *flow_stats_scan_exclude_list[] = {
+        AGENT_FLOW_STATS_MANAGER_TASK,
         AGENT_SHUTDOWN_TASKNAME,
         AGENT_INIT_TASKNAME
     };
-    SetTaskPolicyOne(kTaskSessionStatsCollector, session_stats_exclude_list,
-                     sizeof(session_stats_exclude_list) / sizeof(char *));
+    SetTaskPolicyOne(kTaskFlowStatsScan, flow_stats_scan_exclude_list,
+                     sizeof(flow_stats_scan_exclude_list) / sizeof(char *));
+
+    // Session stats collector scan and event tasks of the same instance are
+    // mutually exclusive. Instances work on disjoint sets of sessions and
+    // can run in parallel.
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    TaskPolicy session_stats_policy;
+    session_stats_policy.push_back
+        (TaskExclusion(scheduler->GetTaskId(AGENT_SHUTDOWN_TASKNAME)));
+    session_stats_policy.push_back
+        (TaskExclusion(scheduler->GetTaskId(AGENT_INIT_TASKNAME)));
+    for (int idx = 0; idx < kMaxSessionStatsCollectors; ++idx) {
+        session_stats_policy.push_back
+            (TaskExclusion(scheduler->GetTaskId
+                           (kTaskSessionStatsCollectorEvent), idx));
+    }
+    scheduler->SetPolicy(scheduler->GetTaskId(kTaskSessionStatsCollector),
+                         session_stats_policy);
 
     const char *session_stats_event_exclude_list[] = {
         AGENT_SHUTDOWN_TASKNAME,
         AGENT_INIT_TASKNAME
     };
-    SetTaskPolicyOne(kTaskSessionStatsCollectorEvent, session_stats_exclude_list,
+    SetTaskPolicyOne(kTaskSessionStatsCollectorEvent,
+                     session_stats_event_exclude_list,
                      sizeof(session_stats_event_exclude_list) / sizeof(char *));
     const char *metadata_exclude_list[] = {
         "xmpp::StateMachine",
@@ -373,7 +394,6 @@ void Agent::SetAgentTaskPolicy() {
                      flow_stats_manager_exclude_list,
                      sizeof(flow_stats_manager_exclude_list) / sizeof(char *));
 
-    TaskScheduler *scheduler = TaskScheduler::GetInstance();
     scheduler->RegisterLog(boost::bind(&Agent::TaskTrace, this,
                                        _1, _2, _3, _4, _5));
 
@@ -722,6 +742,8 @@ void Agent::InitPeers() {
     local_vm_export_peer_.reset(new Peer(Peer::LOCAL_VM_PEER,
                                          LOCAL_VM_EXPORT_PEER,
                                          true));
+    restore_peer_.reset(new Peer(Peer::RESTORE_PEER, RESTORE_PEER_NAME,
+                                 false));
 }
 
 void Agent::ReconfigSignalHandler(boost::system::error_code ec, int signum) {
@@ -326,6 +326,7 @@ extern void RouterIdDepInit(Agent *agent);
 #define kTaskFlowAudit "KSync::FlowAudit"
 #define kTaskFlowLogging "Agent::FlowLogging"
 #define kTaskFlowStatsCollector "Flow::StatsCollector"
+#define kTaskFlowStatsScan "Flow::StatsScan"
 #define kTaskSessionStatsCollector "Flow::SessionStatsCollector"
 #define kTaskSessionStatsCollectorEvent "Flow::SessionStatsCollectorEvent"
 #define kTaskFlowStatsUpdate "Agent::FlowStatsUpdate"
@@ -341,6 +342,7 @@ extern void RouterIdDepInit(Agent *agent);
 #define kTaskMacLearning "Agent::MacLearning"
 #define kTaskMacLearningMgmt "Agent::MacLearningMgmt"
 #define kTaskMacAging "Agent::MacAging"
+#define kTaskPortIpcReload "Agent::PortIpcReload"
 
 #define kInterfaceDbTablePrefix "db.interface"
 #define kVnDbTablePrefix  "db.vn"
@@ -391,6 +393,13 @@ public:
     static const uint8_t kMaxSessionEndpoints = 5;
     static const uint8_t kMaxSessionAggs = 8;
     static const uint8_t kMaxSessions = 100;
+    static const uint8_t kDefaultSessionStatsCollectors = 1;
+    static const uint8_t kMaxSessionStatsCollectors = 8;
+    static const uint8_t kMaxFlowStatsScanPartitions = 8;
+    static const uint16_t kDefaultIpfixPort = 4739;
+    static const uint16_t kDefaultIpfixMtu = 1400;
+    static const uint16_t kMinIpfixMtu = 512;
+    static const uint16_t kMaxIpfixMtu = 9000;
     static const uint16_t kFabricSnatTableSize = 4096;
     // kDropNewFlowsRecoveryThreshold is set to 90% of the Max flows for a
     // VM this value represents that recovery from the drop new flows will
@@ -1039,6 +1048,7 @@ public:
     const Peer *local_vm_export_peer() const {
         return local_vm_export_peer_.get();
     }
+    const Peer *restore_peer() const {return restore_peer_.get();}
 
     // Agent Modules
     AgentConfig *cfg() const;
@@ -1550,6 +1560,7 @@ private:
     std::auto_ptr<Peer> mac_learning_peer_;
     std::auto_ptr<Peer> fabric_rt_export_peer_;
     std::auto_ptr<Peer> local_vm_export_peer_;
+    std::auto_ptr<Peer> restore_peer_;
 
     std::auto_ptr<AgentSignal> agent_signal_;
 
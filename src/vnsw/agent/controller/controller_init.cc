@@ -209,6 +209,8 @@ void VNController::XmppServerConnect() {
                 agent_->controller_ifmap_xmpp_server(count), &ec));
             assert(ec.value() == 0);
             xmpp_cfg->auth_enabled = agent_->xmpp_auth_enabled();
+            xmpp_cfg->compression_enabled =
+                agent_->params()->xmpp_compression_enabled();
             if (xmpp_cfg->auth_enabled) {
                 xmpp_cfg->path_to_server_cert =  agent_->xmpp_server_cert();
                 xmpp_cfg->path_to_server_priv_key =  agent_->xmpp_server_key();
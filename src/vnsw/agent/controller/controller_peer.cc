@@ -7,6 +7,8 @@
 #include <base/logging.h>
 #include <base/connection_info.h>
 #include "base/address_util.h"
+#include "bgp/xmpp_item_decoder.h"
+#include "db/db_partition.h"
 #include <net/bgp_af.h>
 #include "cmn/agent_cmn.h"
 #include "init/agent_param.h"
@@ -26,6 +28,7 @@
 #include "oper/agent_path.h"
 #include "oper/ecmp_load_balance.h"
 #include "oper/global_system_config.h"
+#include "resource_manager/controller_route_backup.h"
 #include "cmn/agent_stats.h"
 #include <pugixml/pugixml.hpp>
 #include "xml/xml_pugi.h"
@@ -190,6 +193,16 @@ bool AgentXmppChannel::SendUpdate(const uint8_t *msg, size_t size) {
                           boost::bind(&AgentXmppChannel::WriteReadyCb, this, _1));
 }
 
+// Decode an item of a route update into item. Encodings that
+// XmppItemDecoder does not handle are left to the autogen parser.
+template <typename TYPE>
+static bool DecodeItem(const pugi::xml_node &node, TYPE *item) {
+    if (XmppItemDecoder::Decode(node, item))
+        return true;
+    item->Clear();
+    return item->XmlParse(node);
+}
+
 void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
     pugi::xml_node node = pugi->FindNode("items");
     pugi::xml_attribute attr = node.attribute("node");
@@ -323,28 +336,28 @@ void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
                     rt_table->DeleteReq(bgp_peer_id(), vrf_name, mac,
                                         ip_addr, plen, ethernet_tag,
                                         new ControllerVmRoute(bgp_peer_id()));
+                    ControllerRouteBackup::DeleteEvpnRoute(agent_, xs_idx_,
+                                        vrf_name, mac, ip_addr, plen,
+                                        ethernet_tag);
                 }
             }
         }
         return;
     }
 
-    //Call Auto-generated Code to return struct
-    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
-    if (EnetItemsType::XmlParseProperty(node, &xparser) == false) {
-        CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                         "Xml Parsing for evpn Failed");
-        return;
-    }
-
-    EnetItemsType *items;
-    EnetItemType *item;
-
-    items = (static_cast<EnetItemsType *>(xparser.get()));
-    std::vector<EnetItemType>::iterator iter;
-    for (vector<EnetItemType>::iterator iter =items->item.begin();
-         iter != items->item.end(); iter++) {
-        item = &*iter;
+    // Decode the items one at a time and batch the routes to remote VMs, see
+    // ReceiveV4V6Update.
+    EnetItemType *item = &enet_item_;
+    DBRequestBatch batch(agent_->fabric_evpn_table());
+    for (pugi::xml_node item_node = node.first_child(); item_node;
+         item_node = item_node.next_sibling()) {
+        if (strcmp(item_node.name(), "item") != 0)
+            continue;
+        if (!DecodeItem(item_node, item)) {
+            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                             "Xml Parsing for evpn Failed");
+            break;
+        }
 
         boost::system::error_code ec;
         MacAddress mac = MacAddress(item->entry.nlri.mac);
@@ -352,12 +365,11 @@ void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
         group = IpAddress::from_string(item->entry.nlri.group, ec);
         source = IpAddress::from_string(item->entry.nlri.source, ec);
 
-        uint32_t plen = ParseEvpnAddress(item->entry.nlri.address, &ip_addr,
-                                         mac);
+        int plen = ParseEvpnAddress(item->entry.nlri.address, &ip_addr, mac);
         if (plen < 0) {
             CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
                              "Error parsing address : " + item->entry.nlri.address);
-            return;
+            break;
         }
 
         if (mac.IsMulticast()) {
@@ -370,11 +382,16 @@ void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
         if (IsEcmp(item->entry.next_hops.next_hop)) {
             VnListType vn_list;
             vn_list.insert(item->entry.virtual_network);
-            AddEvpnEcmpRoute(vrf_name, mac, ip_addr, plen, item, vn_list);
+            AddEvpnEcmpRoute(vrf_name, mac, ip_addr, plen, item, vn_list,
+                             &batch);
         } else {
-            AddEvpnRoute(vrf_name, item->entry.nlri.mac, ip_addr, plen, item);
+            AddEvpnRoute(vrf_name, item->entry.nlri.mac, ip_addr, plen, item,
+                         &batch);
         }
     }
+    if (!batch.empty()) {
+        agent_->fabric_evpn_table()->EnqueueBatch(&batch);
+    }
 }
 
 void AgentXmppChannel::ReceiveMulticastUpdate(XmlPugi *pugi) {
@@ -705,6 +722,9 @@ void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
                         rt_table->DeleteReq(bgp_peer_id(), vrf_name,
                                             prefix_addr, prefix_len,
                                             new ControllerVmRoute(bgp_peer_id()));
+                        ControllerRouteBackup::DeleteRoute(agent_, xs_idx_,
+                                            vrf_name, prefix_addr,
+                                            prefix_len);
 
                     } else if (atoi(af) == BgpAf::IPv6) {
                         Ip6Address prefix_addr;
@@ -717,27 +737,30 @@ void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
                         rt_table->DeleteReq(bgp_peer_id(), vrf_name,
                                             prefix_addr, prefix_len,
                                             new ControllerVmRoute(bgp_peer_id()));
+                        ControllerRouteBackup::DeleteRoute(agent_, xs_idx_,
+                                            vrf_name, prefix_addr,
+                                            prefix_len);
                     }
                 }
             }
             return;
         }
 
-        //Call Auto-generated Code to return struct
-        auto_ptr<AutogenProperty> xparser(new AutogenProperty());
-        if (ItemsType::XmlParseProperty(node, &xparser) == false) {
-            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                             "Xml Parsing Failed");
-            return;
-        }
-        ItemsType *items;
-        ItemType *item;
-
-        items = (static_cast<ItemsType *>(xparser.get()));
-        for (vector<ItemType>::iterator iter =items->item.begin();
-                                        iter != items->item.end();
-                                        ++iter) {
-            item = &*iter;
+        // Decode the items one at a time into the item kept for the
+        // channel, instead of building the list of all the items of the
+        // message first. Routes to remote VMs, most of a full route download,
+        // are added to a batch that is enqueued once at the end.
+        ItemType *item = &inet_item_;
+        DBRequestBatch batch(agent_->fabric_inet4_unicast_table());
+        for (pugi::xml_node item_node = node.first_child(); item_node;
+             item_node = item_node.next_sibling()) {
+            if (strcmp(item_node.name(), "item") != 0)
+                continue;
+            if (!DecodeItem(item_node, item)) {
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                 "Xml Parsing Failed");
+                break;
+            }
             boost::system::error_code ec;
             int prefix_len;
 
@@ -748,9 +771,9 @@ void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
                 if (ec.value() != 0) {
                     CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
                             "Error parsing v4 route address");
-                    return;
+                    break;
                 }
-                AddRoute(vrf_name, prefix_addr, prefix_len, item);
+                AddRoute(vrf_name, prefix_addr, prefix_len, item, &batch);
             } else if (atoi(af) == BgpAf::IPv6) {
                 Ip6Address prefix_addr;
                 ec = Inet6PrefixParse(item->entry.nlri.address, &prefix_addr,
@@ -758,14 +781,17 @@ void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
                 if (ec.value() != 0) {
                     CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
                             "Error parsing v6 route address");
-                    return;
+                    break;
                 }
-                AddRoute(vrf_name, prefix_addr, prefix_len, item);
+                AddRoute(vrf_name, prefix_addr, prefix_len, item, &batch);
             } else {
                 CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
                                  "Error updating route, Unknown IP family");
             }
         }
+        if (!batch.empty()) {
+            agent_->fabric_inet4_unicast_table()->EnqueueBatch(&batch);
+        }
     }
 }
 
@@ -899,9 +925,41 @@ static void GetEcmpHashFieldsToUse(TYPE *item,
     }
 }
 
+// Tunnel nexthops of a route for the controller route backup. Routes with a
+// nexthop on this compute are left to the control-node.
+template <typename TYPE>
+static bool GetBackupNextHopList(Agent *agent, const TYPE *item,
+                                 ControllerRouteBackup::NextHopList *list) {
+    for (uint32_t i = 0; i < item->entry.next_hops.next_hop.size(); i++) {
+        if (list->size() >= ControllerEcmpRoute::maximum_ecmp_paths)
+            break;
+        boost::system::error_code ec;
+        Ip4Address addr = Ip4Address::from_string
+            (item->entry.next_hops.next_hop[i].address, ec);
+        if (ec.value() != 0 || addr == agent->router_id())
+            return false;
+        ControllerNextHopResource nh;
+        nh.set_tunnel_dest(addr.to_string());
+        nh.set_label(item->entry.next_hops.next_hop[i].label);
+        nh.set_tunnel_bmap(agent->controller()->GetTypeBitmap
+            (item->entry.next_hops.next_hop[i].tunnel_encapsulation_list));
+        list->push_back(nh);
+    }
+    return (list->empty() == false);
+}
+
+template <typename TYPE>
+static uint32_t GetPreference(const TYPE *item) {
+    // use LOW PathPreference if local preference attribute is not set
+    if (item->entry.local_preference != 0)
+        return item->entry.local_preference;
+    return PathPreference::LOW;
+}
+
 void AgentXmppChannel::AddInetEcmpRoute(string vrf_name, IpAddress prefix_addr,
                                         uint32_t prefix_len, ItemType *item,
-                                        const VnListType &vn_list) {
+                                        const VnListType &vn_list,
+                                        DBRequestBatch *batch) {
     BgpPeer *bgp_peer = bgp_peer_id();
     InetUnicastAgentRouteTable *rt_table = PrefixToRouteTable(vrf_name,
                                                               prefix_addr);
@@ -928,7 +986,18 @@ void AgentXmppChannel::AddInetEcmpRoute(string vrf_name, IpAddress prefix_addr,
     }
     //ECMP create component NH
     rt_table->AddRemoteVmRouteReq(bgp_peer_id(), vrf_name,
-                                  prefix_addr, prefix_len, data);
+                                  prefix_addr, prefix_len, data, batch);
+
+    ControllerRouteBackup::NextHopList nh_list;
+    if (vrf_name != agent_->fabric_vrf_name() &&
+        GetBackupNextHopList(agent_, item, &nh_list)) {
+        TagList tag_list;
+        BuildTagList(item, &tag_list);
+        ControllerRouteBackup::AddRoute(agent_, xs_idx_, vrf_name,
+                               prefix_addr, prefix_len, nh_list, vn_list,
+                               item->entry.security_group_list.security_group,
+                               tag_list, GetPreference(item));
+    }
 }
 
 void AgentXmppChannel::AddEvpnEcmpRoute(string vrf_name,
@@ -936,7 +1005,8 @@ void AgentXmppChannel::AddEvpnEcmpRoute(string vrf_name,
                                         const IpAddress &prefix_addr,
                                         uint32_t plen,
                                         EnetItemType *item,
-                                        const VnListType &vn_list) {
+                                        const VnListType &vn_list,
+                                        DBRequestBatch *batch) {
     // Verify that vrf is present and active
     VrfKey vrf_key(vrf_name);
     VrfEntry *vrf =
@@ -974,7 +1044,20 @@ void AgentXmppChannel::AddEvpnEcmpRoute(string vrf_name,
     }
     //ECMP create component NH
     rt_table->AddRemoteVmRouteReq(bgp_peer_id(), vrf_name, mac, prefix_addr,
-                                  plen, item->entry.nlri.ethernet_tag, data);
+                                  plen, item->entry.nlri.ethernet_tag, data,
+                                  batch);
+
+    ControllerRouteBackup::NextHopList nh_list;
+    if (GetBackupNextHopList(agent_, item, &nh_list)) {
+        TagList tag_list;
+        BuildTagList(item, &tag_list);
+        ControllerRouteBackup::AddEvpnRoute(agent_, xs_idx_, vrf_name, mac,
+                               prefix_addr, plen,
+                               item->entry.nlri.ethernet_tag, nh_list,
+                               vn_list,
+                               item->entry.security_group_list.security_group,
+                               tag_list, GetPreference(item));
+    }
 }
 
 template <typename TYPE>
@@ -1136,7 +1219,8 @@ void AgentXmppChannel::AddEvpnRoute(const std::string &vrf_name,
                                     std::string mac_str,
                                     const IpAddress &ip_addr,
                                     uint32_t plen,
-                                    EnetItemType *item) {
+                                    EnetItemType *item,
+                                    DBRequestBatch *batch) {
     // Verify that vrf is present and active
     VrfKey vrf_key(vrf_name);
     VrfEntry *vrf =
@@ -1206,7 +1290,20 @@ void AgentXmppChannel::AddEvpnRoute(const std::string &vrf_name,
                               EcmpLoadBalance(),
                               item->entry.etree_leaf);
         rt_table->AddRemoteVmRouteReq(bgp_peer_id(), vrf_name, mac, ip_addr,
-                                     plen, item->entry.nlri.ethernet_tag, data);
+                                     plen, item->entry.nlri.ethernet_tag, data,
+                                     batch);
+
+        // Only the first nexthop is used, ECMP is suppressed for the route
+        ControllerRouteBackup::NextHopList nh_list;
+        if (GetBackupNextHopList(agent_, item, &nh_list)) {
+            nh_list.resize(1);
+            ControllerRouteBackup::AddEvpnRoute(agent_, xs_idx_, vrf_name,
+                               mac, ip_addr, plen,
+                               item->entry.nlri.ethernet_tag, nh_list,
+                               vn_list,
+                               item->entry.security_group_list.security_group,
+                               tag_list, preference);
+        }
         return;
     }
 
@@ -1404,7 +1501,8 @@ void AgentXmppChannel::AddEvpnRoute(const std::string &vrf_name,
 
 void AgentXmppChannel::AddRemoteRoute(string vrf_name, IpAddress prefix_addr,
                                       uint32_t prefix_len, ItemType *item,
-                                      const VnListType &vn_list) {
+                                      const VnListType &vn_list,
+                                      DBRequestBatch *batch) {
     InetUnicastAgentRouteTable *rt_table = PrefixToRouteTable(vrf_name,
                                                               prefix_addr);
 
@@ -1483,7 +1581,14 @@ void AgentXmppChannel::AddRemoteRoute(string vrf_name, IpAddress prefix_addr,
                                path_preference, false, ecmp_load_balance,
                                false);
         rt_table->AddRemoteVmRouteReq(bgp_peer_id(), vrf_name, prefix_addr,
-                                      prefix_len, data);
+                                      prefix_len, data, batch);
+        ControllerRouteBackup::NextHopList nh_list;
+        if (GetBackupNextHopList(agent_, item, &nh_list)) {
+            ControllerRouteBackup::AddRoute(agent_, xs_idx_, vrf_name,
+                               prefix_addr, prefix_len, nh_list, vn_list,
+                               item->entry.security_group_list.security_group,
+                               tag_list, preference);
+        }
         return;
     }
 
@@ -1612,7 +1717,8 @@ void AgentXmppChannel::AddRemoteRoute(string vrf_name, IpAddress prefix_addr,
             break;
             }
         case NextHop::COMPOSITE: {
-            AddInetEcmpRoute(vrf_name, prefix_addr, prefix_len, item, vn_list);
+            AddInetEcmpRoute(vrf_name, prefix_addr, prefix_len, item, vn_list,
+                             batch);
             break;
             }
         case NextHop::VRF: {
@@ -1736,7 +1842,8 @@ void AgentXmppChannel::GetVnList(const TYPE &nexthops, VnListType *vn_list) {
 }
 
 void AgentXmppChannel::AddRoute(string vrf_name, IpAddress prefix_addr,
-                                uint32_t prefix_len, ItemType *item) {
+                                uint32_t prefix_len, ItemType *item,
+                                DBRequestBatch *batch) {
     if ((item->entry.next_hops.next_hop[0].label ==
             MplsTable::kInvalidExportLabel) &&
         (vrf_name != agent_->fabric_vrf_name())) {
@@ -1746,9 +1853,11 @@ void AgentXmppChannel::AddRoute(string vrf_name, IpAddress prefix_addr,
     VnListType vn_list;
     GetVnList(item->entry.next_hops.next_hop, &vn_list);
     if (IsEcmp(item->entry.next_hops.next_hop)) {
-        AddInetEcmpRoute(vrf_name, prefix_addr, prefix_len, item, vn_list);
+        AddInetEcmpRoute(vrf_name, prefix_addr, prefix_len, item, vn_list,
+                         batch);
     } else {
-        AddRemoteRoute(vrf_name, prefix_addr, prefix_len, item, vn_list);
+        AddRemoteRoute(vrf_name, prefix_addr, prefix_len, item, vn_list,
+                       batch);
     }
 }
 
@@ -32,6 +32,7 @@ struct EndOfRibTxTimer;
 struct EndOfRibRxTimer;
 struct LlgrStaleTimer;
 class ControllerEcmpRoute;
+class DBRequestBatch;
 
 class XmlWriter : public pugi::xml_writer {
 public:
@@ -194,11 +195,13 @@ public:
                                     autogen::EnetItemType *item);
     void AddEvpnRoute(const std::string &vrf_name, std::string mac_addr,
                       const IpAddress &ip, uint32_t plen,
-                      autogen::EnetItemType *item);
+                      autogen::EnetItemType *item,
+                      DBRequestBatch *batch = NULL);
     void AddEvpnEcmpRoute(std::string vrf_name, const MacAddress &mac,
                           const IpAddress &ip, uint32_t plen,
                           autogen::EnetItemType *item,
-                          const VnListType &vn_list);
+                          const VnListType &vn_list,
+                          DBRequestBatch *batch = NULL);
     template <typename TYPE>
     void BuildTagList(const TYPE *item, TagList *tag_list);
     uint64_t route_published_time() const {return route_published_time_;}
@@ -226,7 +229,7 @@ private:
                                                    const IpAddress &prefix_addr);
     void ReceiveInternal(const XmppStanza::XmppMessage *msg);
     void AddRoute(std::string vrf_name, IpAddress ip, uint32_t plen,
-                  autogen::ItemType *item);
+                  autogen::ItemType *item, DBRequestBatch *batch = NULL);
     void AddMplsRoute(std::string vrf_name, IpAddress ip, uint32_t plen,
                   autogen::ItemType *item);
     void AddMulticastEvpnRoute(const std::string &vrf_name,
@@ -237,10 +240,12 @@ private:
                         const VnListType &vn_list);
     void AddRemoteRoute(std::string vrf_name, IpAddress prefix_addr,
                             uint32_t prefix_len, autogen::ItemType *item,
-                            const VnListType &vn_list);
+                            const VnListType &vn_list,
+                            DBRequestBatch *batch = NULL);
     void AddInetEcmpRoute(std::string vrf_name, IpAddress ip, uint32_t plen,
                           autogen::ItemType *item,
-                          const VnListType &vn_list);
+                          const VnListType &vn_list,
+                          DBRequestBatch *batch = NULL);
     void AddInetMplsEcmpRoute(std::string vrf_name, IpAddress ip, uint32_t plen,
                           autogen::ItemType *item,
                           const VnListType &vn_list);
@@ -307,6 +312,9 @@ private:
     boost::scoped_ptr<EndOfRibRxTimer> end_of_rib_rx_timer_;
     boost::scoped_ptr<LlgrStaleTimer> llgr_stale_timer_;
     Agent *agent_;
+    // Reused to decode the inet, inet6 and evpn items of every update
+    autogen::ItemType inet_item_;
+    autogen::EnetItemType enet_item_;
 };
 
 #endif // __CONTROLLER_PEER_H__
@@ -187,6 +187,21 @@ ControllerEcmpRoute::ControllerEcmpRoute(const BgpPeer *peer,
     agent_ = peer->agent();
    }
 
+ControllerEcmpRoute::ControllerEcmpRoute(Agent *agent,
+                        const std::string &vrf_name,
+                        const VnListType &vn_list,
+                        const TagList &tag_list,
+                        const SecurityGroupList &sg_list,
+                        const PathPreference &path_pref,
+                        TunnelType::TypeBmap tunnel_bmap,
+                        DBRequest &nh_req) :
+    ControllerPeerPath(NULL), vn_list_(vn_list), sg_list_(sg_list),
+    tag_list_(tag_list), path_preference_(path_pref),
+    tunnel_bmap_(tunnel_bmap), agent_(agent), copy_local_path_(false),
+    vrf_name_(vrf_name) {
+    nh_req_.Swap(&nh_req);
+}
+
 template <typename TYPE>
 ControllerEcmpRoute::ControllerEcmpRoute(const BgpPeer *peer,
                                          const VnListType &vn_list,
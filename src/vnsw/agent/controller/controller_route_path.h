@@ -217,6 +217,15 @@ public:
                         std::vector<uint32_t> &label_list,
                         const std::string &prefix_str,
                         const std::string &vrf_name);
+    //Route replayed from the controller route backup, no bgp peer
+    ControllerEcmpRoute(Agent *agent,
+                        const std::string &vrf_name,
+                        const VnListType &vn_list,
+                        const TagList &tag_list,
+                        const SecurityGroupList &sg_list,
+                        const PathPreference &path_pref,
+                        TunnelType::TypeBmap tunnel_bmap,
+                        DBRequest &nh_req);
     virtual ~ControllerEcmpRoute() { }
     virtual bool AddChangePathExtended(Agent *agent, AgentPath *path,
                                        const AgentRoute *rt);
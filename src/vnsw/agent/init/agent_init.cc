@@ -26,6 +26,8 @@
 #include <oper/multicast_policy.h>
 #include <controller/controller_init.h>
 #include <resource_manager/resource_manager.h>
+#include <resource_manager/resource_backup.h>
+#include <resource_manager/controller_route_backup.h>
 
 #include "agent_init.h"
 
@@ -175,6 +177,12 @@ void AgentInit::SetResourceManagerReady() {
 
     Init();
     agent_->set_init_done(true);
+    // Program the routes kept from the previous run before the controller
+    // session comes up
+    ResourceBackupManager *backup_mgr =
+        agent_->resource_manager()->backup_mgr();
+    if (backup_mgr)
+        backup_mgr->route_backup()->Start();
     ConnectToControllerBase();
 }
 
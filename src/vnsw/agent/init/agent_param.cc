@@ -377,6 +377,26 @@ void AgentParam::ParseSessionDestinationArguments
     }
 }
 
+void AgentParam::ParseSessionIpfixArguments
+    (const boost::program_options::variables_map &var_map) {
+    string collector;
+    ipfix_collector_ = Ip4Address();
+    ipfix_collector_port_ = Agent::kDefaultIpfixPort;
+    if (GetOptValue<string>(var_map, collector, "SESSION.ipfix_collector") &&
+        !collector.empty()) {
+        if (!ParseAddress(collector, &ipfix_collector_,
+                          &ipfix_collector_port_)) {
+            ipfix_collector_ = Ip4Address();
+        }
+    }
+    GetOptValue<uint16_t>(var_map, ipfix_mtu_, "SESSION.ipfix_mtu");
+    if (ipfix_mtu_ < Agent::kMinIpfixMtu) {
+        ipfix_mtu_ = Agent::kMinIpfixMtu;
+    } else if (ipfix_mtu_ > Agent::kMaxIpfixMtu) {
+        ipfix_mtu_ = Agent::kMaxIpfixMtu;
+    }
+}
+
 void AgentParam::ParseCollectorArguments
     (const boost::program_options::variables_map &var_map) {
     collector_server_list_.clear();
@@ -561,6 +581,10 @@ void AgentParam::ParseHypervisorArguments
             return;
         }
     }
+    GetOptValue<bool>(var_map, vm_stats_cgroup_collector_,
+                      "HYPERVISOR.vm_stats_cgroup_collector");
+    GetOptValue<string>(var_map, vm_stats_root_path_,
+                        "HYPERVISOR.vm_stats_root_path");
     if (!GetValueFromTree<uint16_t>(vmi_vm_vn_uve_interval_,
                                     "DEFAULT.vmi_vm_vn_uve_interval")) {
         vmi_vm_vn_uve_interval_ = Agent::kDefaultVmiVmVnUveInterval;
@@ -588,6 +612,8 @@ void AgentParam::ParseDefaultSectionArguments
     GetOptValue<string>(var_map, syslog_facility_, "DEFAULT.syslog_facility");
 
     GetOptValue<bool>(var_map, xmpp_auth_enable_, "DEFAULT.xmpp_auth_enable");
+    GetOptValue<bool>(var_map, xmpp_compression_enable_,
+                      "DEFAULT.xmpp_compression_enable");
     GetOptValue<bool>(var_map, xmpp_dns_auth_enable_,
                       "DEFAULT.xmpp_dns_auth_enable");
     GetOptValue<string>(var_map, xmpp_server_cert_, "DEFAULT.xmpp_server_cert");
@@ -651,6 +677,8 @@ void AgentParam::ParseMetadataProxyArguments
                         "METADATA.metadata_client_key");
     GetOptValue<string>(var_map, metadata_ca_cert_,
                         "METADATA.metadata_ca_cert");
+    GetOptValue<uint32_t>(var_map, metadata_cache_ttl_,
+                        "METADATA.metadata_cache_ttl");
 }
 
 void AgentParam::ParseFlowArguments
@@ -686,6 +714,19 @@ void AgentParam::ParseFlowArguments
                           "FLOWS.max_aggregates_per_session_endpoint");
     GetOptValue<uint16_t>(var_map, max_endpoints_per_session_msg_,
                           "FLOWS.max_endpoints_per_session_msg");
+    GetOptValue<uint16_t>(var_map, session_stats_collector_count_,
+                          "FLOWS.session_stats_collector_count");
+    if (session_stats_collector_count_ == 0) {
+        session_stats_collector_count_ = 1;
+    } else if (session_stats_collector_count_ >
+               Agent::kMaxSessionStatsCollectors) {
+        session_stats_collector_count_ = Agent::kMaxSessionStatsCollectors;
+    }
+    GetOptValue<uint16_t>(var_map, flow_stats_scan_partitions_,
+                          "FLOWS.stats_scan_partitions");
+    if (flow_stats_scan_partitions_ > Agent::kMaxFlowStatsScanPartitions) {
+        flow_stats_scan_partitions_ = Agent::kMaxFlowStatsScanPartitions;
+    }
     GetOptValue<uint16_t>(var_map, fabric_snat_hash_table_size_,
                           "FLOWS.fabric_snat_hash_table_size");
 }
@@ -1147,6 +1188,7 @@ void AgentParam::ProcessArguments() {
     ParseTsnServersArguments(var_map_);
     ParseCryptArguments(var_map_);
     ParseSessionDestinationArguments(var_map_);
+    ParseSessionIpfixArguments(var_map_);
     ParseTraceArguments(var_map_);
 }
 
@@ -1534,6 +1576,7 @@ void AgentParam::LogConfig() const {
     }
     LOG(DEBUG, "Xmpp Servers                : " << concat_servers);
     LOG(DEBUG, "Xmpp Authentication         : " << xmpp_auth_enable_);
+    LOG(DEBUG, "Xmpp Compression            : " << xmpp_compression_enable_);
     if (xmpp_auth_enable_) {
         LOG(DEBUG, "Xmpp Server Certificate : " << xmpp_server_cert_);
         LOG(DEBUG, "Xmpp Server Key         : " << xmpp_server_key_);
@@ -1585,6 +1628,7 @@ void AgentParam::LogConfig() const {
         LOG(DEBUG, "Metadata Client Key             : " << metadata_client_key_);
         LOG(DEBUG, "Metadata CA Certificate         : " << metadata_ca_cert_);
     }
+    LOG(DEBUG, "Metadata-Proxy Cache TTL    : " << metadata_cache_ttl_);
 
     LOG(DEBUG, "Max Vm Flows                : " << max_vm_flows_);
     LOG(DEBUG, "Linklocal Max System Flows  : " << linklocal_system_flows_);
@@ -1604,6 +1648,13 @@ void AgentParam::LogConfig() const {
     LOG(DEBUG, "Maximum sessions            : " << max_sessions_per_aggregate_);
     LOG(DEBUG, "Maximum session aggregates  : " << max_aggregates_per_session_endpoint_);
     LOG(DEBUG, "Maximum session endpoints   : " << max_endpoints_per_session_msg_);
+    LOG(DEBUG, "Session stats collectors    : " << session_stats_collector_count_);
+    LOG(DEBUG, "Flow stats scan partitions  : " << flow_stats_scan_partitions_);
+    if (ipfix_export_enabled()) {
+        LOG(DEBUG, "Session IPFIX collector     : " << ipfix_collector_
+            << ":" << ipfix_collector_port_);
+        LOG(DEBUG, "Session IPFIX MTU           : " << ipfix_mtu_);
+    }
     LOG(DEBUG, "Fabric SNAT hash table size : " << fabric_snat_hash_table_size_);
     LOG(DEBUG, "Flow excluding Router ID in hash    :" << flow_hash_excl_rid_);
 
@@ -1647,6 +1698,7 @@ void AgentParam::LogConfig() const {
 
     if (hypervisor_mode_ == MODE_KVM) {
     LOG(DEBUG, "Hypervisor mode             : kvm");
+    LOG(DEBUG, "VM stats cgroup collector   : " << vm_stats_cgroup_collector_);
         return;
     }
 
@@ -1729,7 +1781,8 @@ AgentParam::AgentParam(bool enable_flow_options,
         xen_ll_(), tunnel_type_(), metadata_shared_secret_(),
         metadata_proxy_port_(0), metadata_use_ssl_(false),
         metadata_client_cert_(""), metadata_client_cert_type_("PEM"),
-        metadata_client_key_(""), metadata_ca_cert_(""), max_vm_flows_(),
+        metadata_client_key_(""), metadata_ca_cert_(""),
+        metadata_cache_ttl_(2), max_vm_flows_(),
         linklocal_system_flows_(), linklocal_vm_flows_(),
         flow_cache_timeout_(), flow_index_sm_log_count_(),
         flow_add_tokens_(Agent::kFlowAddTokens),
@@ -1742,7 +1795,9 @@ AgentParam::AgentParam(bool enable_flow_options,
         config_file_(), program_name_(),
         log_file_(), log_files_count_(kLogFilesCount),
         log_file_size_(kLogFileSize),
-        log_local_(false), log_flow_(false), log_level_(),
+        log_local_(false), log_flow_(false), ipfix_collector_(),
+        ipfix_collector_port_(Agent::kDefaultIpfixPort),
+        ipfix_mtu_(Agent::kDefaultIpfixMtu), log_level_(),
         log_category_(), use_syslog_(false),
         http_server_port_(), rest_port_(), host_name_(),
         agent_stats_interval_(kAgentStatsInterval),
@@ -1751,12 +1806,13 @@ AgentParam::AgentParam(bool enable_flow_options,
         vmware_physical_port_(""), test_mode_(false), tree_(),
         vgw_config_table_(new VirtualGatewayConfigTable() ),
         dhcp_relay_mode_(false), xmpp_auth_enable_(false),
-        xmpp_server_cert_(""), xmpp_server_key_(""), xmpp_ca_cert_(""),
+        xmpp_compression_enable_(false), xmpp_server_cert_(""), xmpp_server_key_(""), xmpp_ca_cert_(""),
         xmpp_dns_auth_enable_(false),
         simulate_evpn_tor_(false), si_netns_command_(),
         si_docker_command_(), si_netns_workers_(0),
         si_netns_timeout_(0), si_lb_ssl_cert_path_(), si_lbaas_auth_conf_(),
-        vmware_mode_(ESXI_NEUTRON), nexthop_server_endpoint_(),
+        vmware_mode_(ESXI_NEUTRON), vm_stats_cgroup_collector_(false),
+        vm_stats_root_path_("/"), nexthop_server_endpoint_(),
         nexthop_server_add_pid_(0),
         vrouter_on_nic_mode_(false),
         exception_packet_interface_(""),
@@ -1769,6 +1825,8 @@ AgentParam::AgentParam(bool enable_flow_options,
         max_sessions_per_aggregate_(Agent::kMaxSessions),
         max_aggregates_per_session_endpoint_(Agent::kMaxSessionAggs),
         max_endpoints_per_session_msg_(Agent::kMaxSessionEndpoints),
+        session_stats_collector_count_(Agent::kDefaultSessionStatsCollectors),
+        flow_stats_scan_partitions_(0),
         subnet_hosts_resolvable_(true),
         bgp_as_a_service_port_range_("50000-50512"),
         services_queue_limit_(1024),
@@ -2055,6 +2113,9 @@ AgentParam::AgentParam(bool enable_flow_options,
          "List of IPAddress:Port of DNS node Servers")
         ("DEFAULT.xmpp_auth_enable", opt::bool_switch(&xmpp_auth_enable_),
          "Enable Xmpp over TLS")
+        ("DEFAULT.xmpp_compression_enable",
+         opt::bool_switch(&xmpp_compression_enable_),
+         "Request zlib stream compression on the control-node Xmpp channels")
         ("DEFAULT.tsn_servers",
          opt::value<std::vector<std::string> >()->multitoken(),
          "List of IPAddress of TSN Servers")
@@ -2099,6 +2160,9 @@ AgentParam::AgentParam(bool enable_flow_options,
           "METADATA Client ssl private key")
         ("METADATA.metadata_ca_cert", opt::value<string>()->default_value(""),
           "METADATA CA ssl certificate")
+        ("METADATA.metadata_cache_ttl",
+         opt::value<uint32_t>()->default_value(2),
+          "Lifetime of cached metadata GET responses in seconds, 0 disables")
         ("NETWORKS.control_network_ip", opt::value<string>(),
          "control-channel IP address used by WEB-UI to connect to vnswad")
         ("DEFAULT.platform", opt::value<string>(),
@@ -2198,7 +2262,12 @@ AgentParam::AgentParam(bool enable_flow_options,
          opt::value<std::vector<std::string> >()
              ->default_value(default_session_destination, std::string("collector"))
              ->implicit_value(implicit_session_destination, std::string("")),
-        "List of destinations. valid values are collector, file, syslog. Space delimited");
+        "List of destinations. valid values are collector, file, syslog. Space delimited")
+        ("SESSION.ipfix_collector", opt::value<string>()->default_value(""),
+         "IPFIX collector <ip>:<port> to export sessions to")
+        ("SESSION.ipfix_mtu",
+         opt::value<uint16_t>()->default_value(Agent::kDefaultIpfixMtu),
+         "Maximum size of IPFIX messages");
     options_.add(log);
     config_file_options_.add(log);
 
@@ -2235,6 +2304,10 @@ AgentParam::AgentParam(bool enable_flow_options,
              "Maximum number of Session Aggregates per SessionEndpoint Entry")
             ("FLOWS.max_endpoints_per_session_msg", opt::value<uint16_t>()->default_value(Agent::kMaxSessionEndpoints),
              "Maximum number of SessionEnpoint entries per SessionEndpointObject")
+            ("FLOWS.session_stats_collector_count", opt::value<uint16_t>()->default_value(Agent::kDefaultSessionStatsCollectors),
+             "Number of session stats collector instances")
+            ("FLOWS.stats_scan_partitions", opt::value<uint16_t>()->default_value(0),
+             "Number of partitions for index ordered scan of vrouter flow table for ageing, 0 to disable")
             ("FLOWS.fabric_snat_hash_table_size", opt::value<uint16_t>()->default_value(default_fabric_snat_table_size),
              "Size of Port NAT hash table")
             ;
@@ -2256,6 +2329,12 @@ AgentParam::AgentParam(bool enable_flow_options,
             ("HYPERVISOR.vmware_mode",
              opt::value<string>()->default_value("esxi_neutron"),
              "VMWare mode <esxi_neutron|vcenter>")
+            ("HYPERVISOR.vm_stats_cgroup_collector",
+             opt::value<bool>()->default_value(false),
+             "Collect VM statistics from cgroup/procfs instead of virsh/docker")
+            ("HYPERVISOR.vm_stats_root_path",
+             opt::value<string>()->default_value("/"),
+             "Root of the cgroup/procfs tree used to collect VM statistics")
             ;
         options_.add(hypervisor);
         config_file_options_.add(hypervisor);
@@ -251,6 +251,7 @@ public:
     }
     std::string metadata_client_key() const { return metadata_client_key_;}
     std::string metadata_ca_cert() const { return metadata_ca_cert_;}
+    uint32_t metadata_cache_ttl() const { return metadata_cache_ttl_; }
     float max_vm_flows() const { return max_vm_flows_; }
     uint32_t linklocal_system_flows() const { return linklocal_system_flows_; }
     uint32_t linklocal_vm_flows() const { return linklocal_vm_flows_; }
@@ -265,6 +266,7 @@ public:
     }
     bool dhcp_relay_mode() const {return dhcp_relay_mode_;}
     bool xmpp_auth_enabled() const {return xmpp_auth_enable_;}
+    bool xmpp_compression_enabled() const {return xmpp_compression_enable_;}
     std::string xmpp_server_cert() const { return xmpp_server_cert_;}
     std::string xmpp_server_key() const { return xmpp_server_key_;}
     std::string xmpp_ca_cert() const { return xmpp_ca_cert_;}
@@ -298,6 +300,17 @@ public:
     const std::vector<std::string> &get_slo_destination() {
         return slo_destination_;
     }
+    // IPFIX export of sessions is enabled when collector is configured
+    bool ipfix_export_enabled() const {
+        return !ipfix_collector_.is_unspecified();
+    }
+    const Ip4Address &ipfix_collector() const { return ipfix_collector_; }
+    uint16_t ipfix_collector_port() const { return ipfix_collector_port_; }
+    uint16_t ipfix_mtu() const { return ipfix_mtu_; }
+    void set_ipfix_collector(const Ip4Address &addr, uint16_t port) {
+        ipfix_collector_ = addr;
+        ipfix_collector_port_ = port;
+    }
     const std::string &log_level() const { return log_level_; }
     const std::string &log_category() const { return log_category_; }
     const std::string &log_property_file() const { return log_property_file_; }
@@ -340,6 +353,18 @@ public:
     bool isVmwareMode() const { return hypervisor_mode_ == MODE_VMWARE; }
     bool isVmwareVcenterMode() const { return vmware_mode_ == VCENTER; }
     VmwareMode vmware_mode() const { return vmware_mode_; }
+    bool vm_stats_cgroup_collector() const {
+        return vm_stats_cgroup_collector_;
+    }
+    void set_vm_stats_cgroup_collector(bool val) {
+        vm_stats_cgroup_collector_ = val;
+    }
+    const std::string &vm_stats_root_path() const {
+        return vm_stats_root_path_;
+    }
+    void set_vm_stats_root_path(const std::string &path) {
+        vm_stats_root_path_ = path;
+    }
     Platform platform() const { return platform_; }
     bool vrouter_on_nic_mode() const {
         return platform_ == VROUTER_ON_NIC;
@@ -447,6 +472,18 @@ public:
     uint16_t max_endpoints_per_session_msg() const {
         return max_endpoints_per_session_msg_;
     }
+    uint16_t session_stats_collector_count() const {
+        return session_stats_collector_count_;
+    }
+    void set_session_stats_collector_count(uint16_t count) {
+        session_stats_collector_count_ = count;
+    }
+    uint16_t flow_stats_scan_partitions() const {
+        return flow_stats_scan_partitions_;
+    }
+    void set_flow_stats_scan_partitions(uint16_t count) {
+        flow_stats_scan_partitions_ = count;
+    }
     std::string ksync_thread_cpu_pin_policy() const {
         return ksync_thread_cpu_pin_policy_;
     }
@@ -678,6 +715,8 @@ private:
         (const boost::program_options::variables_map &v);
     void ParseSessionDestinationArguments
         (const boost::program_options::variables_map &v);
+    void ParseSessionIpfixArguments
+        (const boost::program_options::variables_map &v);
     void ParseTraceArguments
         (const boost::program_options::variables_map &v);
 
@@ -725,6 +764,7 @@ private:
     std::string metadata_client_cert_type_;
     std::string metadata_client_key_;
     std::string metadata_ca_cert_;
+    uint32_t metadata_cache_ttl_;
     float max_vm_flows_;
     uint16_t linklocal_system_flows_;
     uint16_t linklocal_vm_flows_;
@@ -748,6 +788,9 @@ private:
     bool log_flow_;
     std::vector<std::string> slo_destination_;
     std::vector<std::string> sample_destination_;
+    Ip4Address ipfix_collector_;
+    uint16_t ipfix_collector_port_;
+    uint16_t ipfix_mtu_;
     std::string log_level_;
     std::string log_category_;
     bool use_syslog_;
@@ -766,6 +809,7 @@ private:
     std::auto_ptr<VirtualGatewayConfigTable> vgw_config_table_;
     bool dhcp_relay_mode_;
     bool xmpp_auth_enable_;
+    bool xmpp_compression_enable_;
     std::string xmpp_server_cert_;
     std::string xmpp_server_key_;
     std::string xmpp_ca_cert_;
@@ -781,6 +825,8 @@ private:
     std::string si_lb_ssl_cert_path_;
     std::string si_lbaas_auth_conf_;
     VmwareMode vmware_mode_;
+    bool vm_stats_cgroup_collector_;
+    std::string vm_stats_root_path_;
     // List of IP addresses on the compute node.
     AddressList compute_node_address_list_;
     std::string nexthop_server_endpoint_;
@@ -798,6 +844,8 @@ private:
     uint16_t max_sessions_per_aggregate_;
     uint16_t max_aggregates_per_session_endpoint_;
     uint16_t max_endpoints_per_session_msg_;
+    uint16_t session_stats_collector_count_;
+    uint16_t flow_stats_scan_partitions_;
     bool subnet_hosts_resolvable_;
     std::string bgp_as_a_service_port_range_;
     std::vector<uint16_t> bgp_as_a_service_port_range_value_;
@@ -50,7 +50,9 @@ bool EcmpData::Update(AgentRoute *rt) {
         return LocalVmPortPeerEcmp(rt);
     }
 
-    if (path_->peer()->GetType() == Peer::BGP_PEER) {
+    // Routes restored from the backup stand in for the bgp peer routes
+    if (path_->peer()->GetType() == Peer::BGP_PEER ||
+        path_->peer()->GetType() == Peer::RESTORE_PEER) {
         alloc_label_ = false;
         return BgpPeerEcmp();
     }
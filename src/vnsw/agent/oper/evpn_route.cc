@@ -5,6 +5,7 @@
 #include <boost/uuid/uuid_io.hpp>
 
 #include <cmn/agent_cmn.h>
+#include <db/db_partition.h>
 #include <route/route.h>
 
 #include <oper/ecmp_load_balance.h>
@@ -390,12 +391,17 @@ void EvpnAgentRouteTable::AddRemoteVmRouteReq(const Peer *peer,
                                               const IpAddress &ip_addr,
                                               uint32_t plen,
                                               uint32_t ethernet_tag,
-                                              AgentRouteData *data) {
+                                              AgentRouteData *data,
+                                              DBRequestBatch *batch) {
     DBRequest req(DBRequest::DB_ENTRY_ADD_CHANGE);
     req.key.reset(new EvpnRouteKey(peer, vrf_name, mac, ip_addr,
                                    plen, ethernet_tag));
     req.data.reset(data);
 
+    if (batch) {
+        batch->Add(&req);
+        return;
+    }
     EvpnTableEnqueue(Agent::GetInstance(), &req);
 }
 
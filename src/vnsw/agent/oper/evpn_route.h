@@ -6,6 +6,7 @@
 #define vnsw_evpn_route_hpp
 
 class EvpnRoutingData;
+class DBRequestBatch;
 
 //////////////////////////////////////////////////////////////////
 //  EVPN
@@ -96,13 +97,16 @@ public:
                               const IpAddress &ip_addr,
                               uint32_t ethernet_tag,
                               AgentRouteData *data);
+    // The request is added to batch if given, instead of enqueued to the
+    // fabric evpn table.
     static void AddRemoteVmRouteReq(const Peer *peer,
                                     const std::string &vrf_name,
                                     const MacAddress &mac,
                                     const IpAddress &ip_addr,
                                     uint32_t plen,
                                     uint32_t ethernet_tag,
-                                    AgentRouteData *data);
+                                    AgentRouteData *data,
+                                    DBRequestBatch *batch = NULL);
     static void AddRemoteVmRoute(const Peer *peer,
                                  const std::string &vrf_name,
                                  const MacAddress &mac,
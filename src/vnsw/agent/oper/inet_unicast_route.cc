@@ -6,6 +6,7 @@
 
 #include <base/address_util.h>
 #include <base/task_annotations.h>
+#include <db/db_partition.h>
 #include <boost/foreach.hpp>
 #include <cmn/agent_cmn.h>
 #include <route/route.h>
@@ -1367,12 +1368,17 @@ InetUnicastAgentRouteTable::AddRemoteVmRouteReq(const Peer *peer,
                                                 const string &vm_vrf,
                                                 const IpAddress &vm_addr,
                                                 uint8_t plen,
-                                                AgentRouteData *data) {
+                                                AgentRouteData *data,
+                                                DBRequestBatch *batch) {
     if (Agent::GetInstance()->simulate_evpn_tor())
         return;
     DBRequest req(DBRequest::DB_ENTRY_ADD_CHANGE);
     req.key.reset(new InetUnicastRouteKey(peer, vm_vrf, vm_addr, plen));
     req.data.reset(data);
+    if (batch) {
+        batch->Add(&req);
+        return;
+    }
     InetUnicastTableEnqueue(Agent::GetInstance(), vm_vrf, &req);
 }
 
@@ -10,6 +10,7 @@ class LocalVmRoute;
 class InetInterfaceRoute;
 class ClonedLocalPath;
 class EcmpLoadBalance;
+class DBRequestBatch;
 
 //////////////////////////////////////////////////////////////////
 //  UNICAST INET
@@ -250,9 +251,12 @@ public:
                 bool is_learnt_route = false);
     void ResyncRoute(const Peer *peer, const string &vrf,
                      const IpAddress &addr, uint8_t plen);
+    // The request is added to batch if given, instead of enqueued to the
+    // fabric inet4 unicast table.
     static void AddRemoteVmRouteReq(const Peer *peer, const string &vm_vrf,
                                     const IpAddress &vm_addr,uint8_t plen,
-                                    AgentRouteData *data);
+                                    AgentRouteData *data,
+                                    DBRequestBatch *batch = NULL);
     void AddVlanNHRouteReq(const Peer *peer, const string &vm_vrf,
                            const IpAddress &addr, uint8_t plen,
                            VlanNhRoute *data);
@@ -29,6 +29,7 @@
 #define MAC_LEARNING_PEER_NAME "DynamicMacLearningPeer"
 #define FABRIC_RT_EXPORT "FabricRouteExport"
 #define LOCAL_VM_EXPORT_PEER "LocalVmExportPeer"
+#define RESTORE_PEER_NAME "Restore"
 
 class AgentXmppChannel;
 class ControllerRouteWalker;
@@ -63,6 +64,8 @@ public:
         MAC_VM_BINDING_PEER,
         INET_EVPN_PEER,
         MAC_LEARNING_PEER,
+        // Routes restored from the backup till the control-node sends them
+        RESTORE_PEER,
     };
 
     Peer(Type type, const std::string &name, bool controller_export);
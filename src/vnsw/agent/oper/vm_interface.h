@@ -116,6 +116,7 @@ class PathPreference;
 class MetaDataIp;
 class HealthCheckInstanceBase;
 struct VmInterfaceLearntMacIpData;
+class DBRequestBatch;
 
 class LocalVmPortPeer;
 class VmInterface;
@@ -1563,7 +1564,8 @@ public:
     bool IsMaxMacIpLearnt() const;
 
     // Static methods
-    // Add a vm-interface
+    // Add a vm-interface. The request is added to batch when not NULL,
+    // the caller then enqueues the batch to the table
     static void NovaAdd(InterfaceTable *table,
                         const boost::uuids::uuid &intf_uuid,
                         const std::string &os_name, const Ip4Address &addr,
@@ -1572,7 +1574,8 @@ public:
                         uint16_t tx_vlan_id, uint16_t rx_vlan_id,
                         const std::string &parent, const Ip6Address &ipv6,
                         uint8_t vhostuser_mode,
-                        Interface::Transport transport, uint8_t link_state);
+                        Interface::Transport transport, uint8_t link_state,
+                        DBRequestBatch *batch = NULL);
     // Del a vm-interface
     static void Delete(InterfaceTable *table,
                        const boost::uuids::uuid &intf_uuid,
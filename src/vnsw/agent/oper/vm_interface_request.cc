@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 #include <cmn/agent_cmn.h>
+#include <db/db_partition.h>
 #include <init/agent_param.h>
 #include <oper/operdb_init.h>
 #include <oper/route_common.h>
@@ -989,7 +990,7 @@ void VmInterface::NovaAdd(InterfaceTable *table, const uuid &intf_uuid,
                           const Ip6Address &ip6,
                           uint8_t vhostuser_mode,
                           Interface::Transport transport,
-                          uint8_t link_state) {
+                          uint8_t link_state, DBRequestBatch *batch) {
     DBRequest req(DBRequest::DB_ENTRY_ADD_CHANGE);
     req.key.reset(new VmInterfaceKey(AgentKey::ADD_DEL_CHANGE, intf_uuid,
                                      os_name));
@@ -1001,6 +1002,10 @@ void VmInterface::NovaAdd(InterfaceTable *table, const uuid &intf_uuid,
                                            VmInterface::INSTANCE,
                                            vhostuser_mode,
                                            transport, link_state));
+    if (batch) {
+        batch->Add(&req);
+        return;
+    }
     table->Enqueue(&req);
 }
 
@@ -44,6 +44,7 @@ struct VrfData : public AgentOperDBData {
         GwVrf     = 1 << 1,     // GW configured for this VRF
         MirrorVrf = 1 << 2,     // internally Created VRF
         PbbVrf    = 1 << 3,     // Per ISID VRF
+        RestoreVrf = 1 << 4,    // vrf is restored from the route backup
         //Note addition of new flag may need update in
         //ConfigFlags() API, if flag being added is a property
         //flag(Ex PbbVrf) and not flag indicating Config origination(ex: GwVrf)
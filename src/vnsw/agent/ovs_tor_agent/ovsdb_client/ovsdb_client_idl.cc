@@ -3,6 +3,7 @@
  */
 
 #include <assert.h>
+#include <algorithm>
 #include <cstddef>
 #include <string.h>
 #include <stdlib.h>
@@ -10,6 +11,7 @@
 extern "C" {
 #include <ovsdb_wrapper.h>
 };
+#include <base/time_util.h>
 #include <oper/agent_sandesh.h>
 #include <ovsdb_types.h>
 #include <ovsdb_client_connection_state.h>
@@ -54,6 +56,13 @@ using OVSDB::VnOvsdbObject;
 using OVSDB::ConnectionStateTable;
 using OVSDB::OvsdbResourceVxLanIdTable;
 
+const std::size_t OvsdbClientIdl::OVSDBMinInFlightPendingTxn;
+const std::size_t OvsdbClientIdl::OVSDBInitInFlightPendingTxn;
+const std::size_t OvsdbClientIdl::OVSDBMaxInFlightPendingTxn;
+const std::size_t OvsdbClientIdl::OVSDBMinEntriesInBulkTxn;
+const std::size_t OvsdbClientIdl::OVSDBMaxEntriesInBulkTxn;
+const uint64_t OvsdbClientIdl::OVSDBTxnRttFloorUsec;
+
 namespace OVSDB {
 void ovsdb_wrapper_idl_callback(void *idl_base, int op,
         struct ovsdb_idl_row *row) {
@@ -69,6 +78,18 @@ void ovsdb_wrapper_idl_txn_ack(void *idl_base, struct ovsdb_idl_txn *txn) {
     OvsdbClientIdl *client_idl = (OvsdbClientIdl *) idl_base;
     OvsdbEntryList &entry_list = client_idl->pending_txn_[txn];
     bool success = ovsdb_wrapper_is_txn_success(txn);
+
+    OvsdbClientIdl::TxnSendTimeMap::iterator time_it =
+        client_idl->txn_send_time_.find(txn);
+    if (time_it != client_idl->txn_send_time_.end()) {
+        client_idl->UpdateTxnPacing(time_it->second, ClockMonotonicUsec(),
+                                    entry_list.size());
+        client_idl->txn_send_time_.erase(time_it);
+    }
+    if (entry_list.size() > 1) {
+        client_idl->stats_.bulk_txn_count++;
+        client_idl->stats_.bulk_txn_entries += entry_list.size();
+    }
     if (!success) {
         // increment stats.
         client_idl->stats_.txn_failed++;
@@ -92,11 +113,9 @@ void ovsdb_wrapper_idl_txn_ack(void *idl_base, struct ovsdb_idl_txn *txn) {
     // Donot Access entry_list ref after transaction delete
     client_idl->DeleteTxn(txn);
 
-    // if there are pending txn messages to be scheduled, pick one and schedule
-    if (!client_idl->pending_send_msgs_.empty()) {
-        client_idl->session_->SendJsonRpc(client_idl->pending_send_msgs_.front());
-        client_idl->pending_send_msgs_.pop();
-    }
+    // if there are pending txn messages to be scheduled, schedule as many
+    // as the in flight window allows
+    client_idl->SendThrottledTxnMsgs();
 }
 
 void intrusive_ptr_add_ref(OvsdbClientIdl *p) {
@@ -148,7 +167,9 @@ OvsdbClientIdl::OvsdbClientIdl(OvsdbClientSession *session, Agent *agent,
                 *(agent->event_manager())->io_service(),
                 "OVSDB Client Keep Alive Timer",
                 agent->task_scheduler()->GetTaskId("Agent::KSync"), 0)),
-    monitor_request_id_(NULL), bulk_txn_(NULL), stats_() {
+    monitor_request_id_(NULL), bulk_txn_(NULL), stats_(),
+    max_in_flight_txn_(OVSDBInitInFlightPendingTxn),
+    bulk_txn_size_(OVSDBMinEntriesInBulkTxn), last_backoff_usec_(0) {
     refcount_ = 0;
     vtep_global_= ovsdb_wrapper_vteprec_global_first(idl_);
     ovsdb_wrapper_idl_set_callback(idl_, (void *)this,
@@ -201,7 +222,8 @@ OvsdbClientIdl::OvsdbMsg::~OvsdbMsg() {
 }
 
 OvsdbClientIdl::TxnStats::TxnStats() : txn_initiated(0), txn_succeeded(0),
-    txn_failed(0) {
+    txn_failed(0), bulk_txn_entries(0), bulk_txn_count(0), txn_rtt_usec(0),
+    txn_min_rtt_usec(0), txn_backoff_count(0) {
 }
 
 void OvsdbClientIdl::OnEstablish() {
@@ -232,17 +254,69 @@ void OvsdbClientIdl::OnEstablish() {
             boost::bind(&OvsdbClientIdl::KeepAliveTimerCb, this));
 }
 
-void OvsdbClientIdl::TxnScheduleJsonRpc(struct jsonrpc_msg *msg) {
+void OvsdbClientIdl::TxnScheduleJsonRpc(struct ovsdb_idl_txn *txn,
+                                        struct jsonrpc_msg *msg) {
     // increment stats.
     stats_.txn_initiated++;
 
     if (!session_->ThrottleInFlightTxnMessages() ||
-        OVSDBMaxInFlightPendingTxn >= pending_txn_.size()) {
+        (pending_send_msgs_.empty() &&
+         max_in_flight_txn_ > txn_send_time_.size())) {
+        txn_send_time_[txn] = ClockMonotonicUsec();
         session_->SendJsonRpc(msg);
     } else {
         // throttle txn messages, push the message to pending send
         // msg queue to be scheduled later.
-        pending_send_msgs_.push(msg);
+        pending_send_msgs_.push(TxnMsg(txn, msg));
+    }
+}
+
+void OvsdbClientIdl::SendThrottledTxnMsgs() {
+    while (!pending_send_msgs_.empty() &&
+           max_in_flight_txn_ > txn_send_time_.size()) {
+        TxnMsg txn_msg = pending_send_msgs_.front();
+        pending_send_msgs_.pop();
+        txn_send_time_[txn_msg.first] = ClockMonotonicUsec();
+        session_->SendJsonRpc(txn_msg.second);
+    }
+}
+
+// Additive increase, multiplicative decrease of the in flight window.
+// Bulk txns of more entries take longer to ack, so the latency is compared
+// per entry. An ack latency per entry more than twice the lowest seen, with
+// the txn latency above OVSDBTxnRttFloorUsec, means ovsdb-server is falling
+// behind: halve the window and the bulk txn size.
+// Txns sent before the last back off were sent with the former window, their
+// acks don't back off again, so the window is halved at most once per round
+// trip. Bulk txn size grows in CreateBulkTxn when entries keep coming faster
+// than the txns are acked.
+void OvsdbClientIdl::UpdateTxnPacing(uint64_t send_usec, uint64_t ack_usec,
+                                     std::size_t entries) {
+    uint64_t rtt_usec = ack_usec - send_usec;
+    uint64_t entry_rtt_usec = rtt_usec / std::max(entries, (std::size_t) 1);
+    if (stats_.txn_min_rtt_usec == 0 ||
+        entry_rtt_usec < stats_.txn_min_rtt_usec) {
+        stats_.txn_min_rtt_usec = entry_rtt_usec;
+    }
+    if (stats_.txn_rtt_usec == 0) {
+        stats_.txn_rtt_usec = rtt_usec;
+    } else {
+        stats_.txn_rtt_usec = (7 * stats_.txn_rtt_usec + rtt_usec) / 8;
+    }
+
+    if (rtt_usec > OVSDBTxnRttFloorUsec &&
+        entry_rtt_usec > 2 * stats_.txn_min_rtt_usec) {
+        if (send_usec < last_backoff_usec_) {
+            return;
+        }
+        last_backoff_usec_ = ack_usec;
+        stats_.txn_backoff_count++;
+        max_in_flight_txn_ = std::max(OVSDBMinInFlightPendingTxn,
+                                      max_in_flight_txn_ / 2);
+        bulk_txn_size_ = std::max(OVSDBMinEntriesInBulkTxn,
+                                  bulk_txn_size_ / 2);
+    } else if (max_in_flight_txn_ < OVSDBMaxInFlightPendingTxn) {
+        max_in_flight_txn_++;
     }
 }
 
@@ -337,7 +411,14 @@ struct ovsdb_idl_txn *OvsdbClientIdl::CreateBulkTxn(OvsdbEntryBase *entry,
     entry->ack_event_ = ack_event;
 
     // try creating bulk transaction only if pending txn are there
-    if (pending_txn_.empty() || bulk_entries_.size() == OVSDBEntriesInBulkTxn) {
+    if (pending_txn_.empty() || bulk_entries_.size() >= bulk_txn_size_) {
+        // bulk txn filled up while previous txns are pending, entries are
+        // coming in faster than acks, let the next bulk txn grow
+        if (!pending_txn_.empty() &&
+            bulk_txn_size_ < OVSDBMaxEntriesInBulkTxn) {
+            bulk_txn_size_ = std::min(OVSDBMaxEntriesInBulkTxn,
+                                      bulk_txn_size_ * 2);
+        }
         // once done bunch entries add the txn to pending txn list and
         // reset bulk_txn_ to let EncodeSendTxn proceed with bulk txn
         pending_txn_[bulk_txn_] = bulk_entries_;
@@ -372,13 +453,14 @@ bool OvsdbClientIdl::EncodeSendTxn(struct ovsdb_idl_txn *txn,
         DeleteTxn(txn);
         return true;
     }
-    TxnScheduleJsonRpc(msg);
+    TxnScheduleJsonRpc(txn, msg);
     return false;
 }
 
 void OvsdbClientIdl::DeleteTxn(struct ovsdb_idl_txn *txn) {
     assert(ConcurrencyCheck());
     pending_txn_.erase(txn);
+    txn_send_time_.erase(txn);
     // third party code and handle only one txn at a time,
     // if there is a pending bulk entry encode and send before
     // destroying the current txn
@@ -547,7 +629,7 @@ void OvsdbClientIdl::TriggerDeletion() {
 
     while (!pending_send_msgs_.empty()) {
         // flush and destroy all the pending send messages
-        ovsdb_wrapper_jsonrpc_msg_destroy(pending_send_msgs_.front());
+        ovsdb_wrapper_jsonrpc_msg_destroy(pending_send_msgs_.front().second);
         pending_send_msgs_.pop();
     }
 
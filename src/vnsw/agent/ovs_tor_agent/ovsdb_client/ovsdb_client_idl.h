@@ -6,7 +6,9 @@
 #define SRC_VNSW_AGENT_OVS_TOR_AGENT_OVSDB_CLIENT_OVSDB_CLIENT_IDL_H_
 
 #include <assert.h>
+#include <map>
 #include <queue>
+#include <utility>
 
 #include <boost/intrusive_ptr.hpp>
 #include <tbb/atomic.h>
@@ -71,8 +73,16 @@ public:
         OvsdbSessionEchoWait     // Echo Req sent waiting for reply
     };
 
-    static const std::size_t OVSDBMaxInFlightPendingTxn = 25;
-    static const std::size_t OVSDBEntriesInBulkTxn = 4;
+    // Transaction pacing, the number of entries in a bulk txn and the
+    // number of txn in flight adapt between these limits, see
+    // UpdateTxnPacing
+    static const std::size_t OVSDBMinInFlightPendingTxn = 4;
+    static const std::size_t OVSDBInitInFlightPendingTxn = 25;
+    static const std::size_t OVSDBMaxInFlightPendingTxn = 1024;
+    static const std::size_t OVSDBMinEntriesInBulkTxn = 4;
+    static const std::size_t OVSDBMaxEntriesInBulkTxn = 4096;
+    // txn ack latency below this is never considered as congestion
+    static const uint64_t OVSDBTxnRttFloorUsec = 20000;
 
     enum Op {
         OVSDB_DEL = 0,
@@ -104,11 +114,21 @@ public:
         uint64_t txn_initiated;
         uint64_t txn_succeeded;
         uint64_t txn_failed;
+        // entries acked by bulk txns
+        uint64_t bulk_txn_entries;
+        uint64_t bulk_txn_count;
+        // smoothed txn ack latency, and lowest ack latency per entry
+        uint64_t txn_rtt_usec;
+        uint64_t txn_min_rtt_usec;
+        // number of times the in flight window was halved
+        uint64_t txn_backoff_count;
     };
 
     typedef boost::function<void(OvsdbClientIdl::Op, struct ovsdb_idl_row *)> NotifyCB;
     typedef std::map<struct ovsdb_idl_txn *, OvsdbEntryList> PendingTxnMap;
-    typedef std::queue<struct jsonrpc_msg *> ThrottledTxnMsgs;
+    typedef std::pair<struct ovsdb_idl_txn *, struct jsonrpc_msg *> TxnMsg;
+    typedef std::queue<TxnMsg> ThrottledTxnMsgs;
+    typedef std::map<struct ovsdb_idl_txn *, uint64_t> TxnSendTimeMap;
 
     OvsdbClientIdl(OvsdbClientSession *session, Agent *agent, OvsPeerManager *manager);
     virtual ~OvsdbClientIdl();
@@ -119,9 +139,14 @@ public:
     // Send request to start monitoring OVSDB server
     void OnEstablish();
 
-    // Encode and send json rpc message to OVSDB server
+    // Encode and send json rpc message of txn to OVSDB server
     // takes ownership of jsonrpc message, and free memory
-    void TxnScheduleJsonRpc(struct jsonrpc_msg *msg);
+    // Every txn message counts against the in flight window until acked.
+    // The monitor request and echo messages are sent directly by the
+    // session and exempt: the monitor request is sent once, before any
+    // txn, and echo must not queue behind txns or the keepalive fails.
+    void TxnScheduleJsonRpc(struct ovsdb_idl_txn *txn,
+                            struct jsonrpc_msg *msg);
 
     // Process the recevied message and trigger update to ovsdb client
     void MessageProcess(const u_int8_t *buf, std::size_t len);
@@ -180,6 +205,8 @@ public:
     const TxnStats &stats() const;
     uint64_t pending_txn_count() const;
     uint64_t pending_send_msg_count() const;
+    std::size_t max_in_flight_txn() const { return max_in_flight_txn_; }
+    std::size_t bulk_txn_size() const { return bulk_txn_size_; }
 
     // Concurrency Check to validate all idl transactions happen only in
     // db::DBTable or Agent::KSync task context
@@ -193,6 +220,12 @@ private:
 
     void ConnectOperDB();
 
+    // Send txn messages queued by throttling, as the window allows
+    void SendThrottledTxnMsgs();
+    // Adapt the in flight window and bulk txn size to the txn ack latency
+    void UpdateTxnPacing(uint64_t send_usec, uint64_t ack_usec,
+                         std::size_t entries);
+
     struct ovsdb_idl *idl_;
     const struct vteprec_global *vtep_global_;
     OvsdbClientSession *session_;
@@ -221,6 +254,12 @@ private:
 
     // transaction stats per IDL
     TxnStats stats_;
+    // send time of txns waiting for ack
+    TxnSendTimeMap txn_send_time_;
+    std::size_t max_in_flight_txn_;
+    std::size_t bulk_txn_size_;
+    // ack time of the txn that last halved the window
+    uint64_t last_backoff_usec_;
 
     tbb::atomic<int> refcount_;
     std::auto_ptr<OvsPeer> route_peer_;
@@ -154,12 +154,26 @@ void OvsdbClientSession::AddSessionInfo(SandeshOvsdbClientSession &session) {
         sandesh_stats.set_txn_pending(client_idl_->pending_txn_count());
         sandesh_stats.set_pending_send_msg(
                 client_idl_->pending_send_msg_count());
+        sandesh_stats.set_bulk_txn_count(stats.bulk_txn_count);
+        sandesh_stats.set_bulk_txn_entries(stats.bulk_txn_entries);
+        sandesh_stats.set_txn_rtt_usec(stats.txn_rtt_usec);
+        sandesh_stats.set_txn_min_rtt_usec(stats.txn_min_rtt_usec);
+        sandesh_stats.set_max_in_flight_txn(client_idl_->max_in_flight_txn());
+        sandesh_stats.set_bulk_txn_size(client_idl_->bulk_txn_size());
+        sandesh_stats.set_txn_backoff_count(stats.txn_backoff_count);
     } else {
         sandesh_stats.set_txn_initiated(0);
         sandesh_stats.set_txn_succeeded(0);
         sandesh_stats.set_txn_failed(0);
         sandesh_stats.set_txn_pending(0);
         sandesh_stats.set_pending_send_msg(0);
+        sandesh_stats.set_bulk_txn_count(0);
+        sandesh_stats.set_bulk_txn_entries(0);
+        sandesh_stats.set_txn_rtt_usec(0);
+        sandesh_stats.set_txn_min_rtt_usec(0);
+        sandesh_stats.set_max_in_flight_txn(0);
+        sandesh_stats.set_bulk_txn_size(0);
+        sandesh_stats.set_txn_backoff_count(0);
     }
     session.set_connection_time(connection_time_);
     session.set_txn_stats(sandesh_stats);
@@ -136,7 +136,7 @@ bool PhysicalPortEntry::OverrideOvs() {
     }
     OVSDB_TRACE(Trace, "Sending Vlan Port Binding update for Physical route " +
                        dev_name_ + " Physical Port " + name_);
-    table_->client_idl()->TxnScheduleJsonRpc(msg);
+    table_->client_idl()->TxnScheduleJsonRpc(txn, msg);
     return false;
 }
 
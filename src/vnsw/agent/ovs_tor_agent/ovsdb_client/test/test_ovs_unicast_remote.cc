@@ -412,6 +412,93 @@ TEST_F(UnicastRemoteTest, PhysicalLocatorCreateWait) {
     WAIT_FOR(100, 10000, (l_table->Find(&l_key) == NULL));
 }
 
+// Program a burst of remote macs, they are sent in bulk txns and the pacing
+// stays within its limits
+TEST_F(UnicastRemoteTest, UnicastRemoteScale) {
+    const int kMacCount = 2048;
+    VnAddReq(2, "test-vn1");
+    agent_->vrf_table()->CreateVrfReq("test-vrf1", MakeUuid(2));
+    AddPhysicalDevice("test-router", 1);
+    client->WaitForIdle();
+    AddPhysicalDeviceVn(agent_, 1, 2, true);
+    client->WaitForIdle();
+
+    OvsdbClientIdl *idl = tcp_session_->client_idl();
+    uint64_t txn_failures = idl->stats().txn_failed;
+    uint64_t txn_succeeded = idl->stats().txn_succeeded;
+    uint64_t bulk_txn_count = idl->stats().bulk_txn_count;
+    uint64_t bulk_txn_entries = idl->stats().bulk_txn_entries;
+    uint64_t txn_backoff_count = idl->stats().txn_backoff_count;
+    std::vector<MacAddress> macs;
+    for (int i = 0; i < kMacCount; i++) {
+        macs.push_back(MacAddress(0, 0, 0, 2, (i >> 8) & 0xff, i & 0xff));
+    }
+
+    TestTaskHold *hold =
+        new TestTaskHold(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"), 0);
+    for (int i = 0; i < kMacCount; i++) {
+        BridgeTunnelRouteAdd(bgp_peer_, std::string("test-vrf1"),
+                             (1 << TunnelType::VXLAN), "10.0.1.1",
+                             101, macs[i], "0.0.0.0", 32);
+    }
+    delete hold;
+    client->WaitForIdle();
+
+    VrfOvsdbObject *table = idl->vrf_ovsdb();
+    VrfOvsdbEntry vrf_key(table, UuidToString(MakeUuid(2)));
+    VrfOvsdbEntry *vrf_entry;
+    WAIT_FOR(100, 10000,
+             (vrf_entry =
+              static_cast<VrfOvsdbEntry *>(table->Find(&vrf_key))) != NULL);
+    if (vrf_entry != NULL) {
+        UnicastMacRemoteTable *u_table = vrf_entry->route_table();
+        for (int i = 0; i < kMacCount; i++) {
+            UnicastMacRemoteEntry key(u_table, macs[i].ToString());
+            UnicastMacRemoteEntry *entry;
+            WAIT_FOR(1000, 10000,
+                     ((entry = static_cast<UnicastMacRemoteEntry *>
+                       (u_table->Find(&key))) != NULL
+                      && entry->GetState() == KSyncEntry::IN_SYNC));
+        }
+    }
+
+    const OvsdbClientIdl::TxnStats &stats = idl->stats();
+    uint64_t txns = stats.txn_succeeded - txn_succeeded;
+    EXPECT_EQ(txn_failures, stats.txn_failed);
+    // Macs are acked in bulk txns, far fewer txns than macs
+    EXPECT_GT(stats.bulk_txn_count, bulk_txn_count);
+    EXPECT_GE(stats.bulk_txn_entries - bulk_txn_entries,
+              (uint64_t) kMacCount / 2);
+    EXPECT_LT(txns, (uint64_t) kMacCount / 2);
+    // The window is halved at most once per acked txn, and the limits stay
+    // within bounds
+    EXPECT_LE(stats.txn_backoff_count - txn_backoff_count, txns);
+    EXPECT_GE(idl->max_in_flight_txn(),
+              OvsdbClientIdl::OVSDBMinInFlightPendingTxn);
+    EXPECT_LE(idl->max_in_flight_txn(),
+              OvsdbClientIdl::OVSDBMaxInFlightPendingTxn);
+    EXPECT_GE(idl->bulk_txn_size(), OvsdbClientIdl::OVSDBMinEntriesInBulkTxn);
+    EXPECT_LE(idl->bulk_txn_size(), OvsdbClientIdl::OVSDBMaxEntriesInBulkTxn);
+
+    Ip4Address zero_ip;
+    for (int i = 0; i < kMacCount; i++) {
+        EvpnAgentRouteTable::DeleteReq(bgp_peer_, std::string("test-vrf1"),
+                                       macs[i], zero_ip, 32, 0, NULL);
+    }
+    client->WaitForIdle();
+    DelPhysicalDeviceVn(agent_, 1, 2, false);
+    client->WaitForIdle();
+    DeletePhysicalDevice("test-router");
+    client->WaitForIdle();
+    agent_->vrf_table()->DeleteVrfReq("test-vrf1");
+    VnDelReq(2);
+    client->WaitForIdle();
+
+    LogicalSwitchTable *l_table = idl->logical_switch_table();
+    LogicalSwitchEntry l_key(l_table, UuidToString(MakeUuid(2)));
+    WAIT_FOR(100, 10000, (l_table->Find(&l_key) == NULL));
+}
+
 int main(int argc, char *argv[]) {
     GETUSERARGS();
     // override with true to initialize ovsdb server and client
@@ -490,6 +490,7 @@ void FlowEntry::Reset() {
     refcount_ = 0;
     nw_ace_uuid_ = FlowPolicyStateStr.at(NOT_EVALUATED);
     fsc_ = NULL;
+    ssc_ = NULL;
     trace_ = false;
     event_logs_.reset();
     event_log_index_ = 0;
@@ -40,6 +40,7 @@ class FlowTableKSyncEntry;
 class FlowEntry;
 class FlowExportInfo;
 class FlowStatsCollector;
+class SessionStatsCollector;
 class Token;
 class FlowMgmtRequest;
 class FlowEntryInfo;
@@ -732,6 +733,13 @@ class FlowEntry {
     void set_fsc(FlowStatsCollector *fsc) {
         fsc_ = fsc;
     }
+    SessionStatsCollector* ssc() const {
+        return ssc_;
+    }
+
+    void set_ssc(SessionStatsCollector *ssc) {
+        ssc_ = ssc;
+    }
     static std::string DropReasonStr(uint16_t reason);
     std::string KeyString() const;
     void SetEventSandeshData(SandeshFlowIndexInfo *info);
@@ -842,6 +850,7 @@ private:
     tbb::mutex mutex_;
     boost::intrusive::list_member_hook<> free_list_node_;
     FlowStatsCollector *fsc_;
+    SessionStatsCollector *ssc_;
     uint32_t last_event_;
     bool trace_;
     boost::scoped_array<FlowEventLog> event_logs_;
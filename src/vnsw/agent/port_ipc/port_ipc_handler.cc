@@ -6,12 +6,14 @@
 #include <sstream>
 #include <fstream>
 #include <net/if.h>
+#include <algorithm>
 #include <boost/uuid/uuid.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/string_util.h"
@@ -85,10 +87,16 @@ static void InterfaceResync(Agent *agent, const boost::uuids::uuid &u,
 /////////////////////////////////////////////////////////////////////////////
 // PortIpcHandler methods
 /////////////////////////////////////////////////////////////////////////////
+const std::string PortIpcHandler::kPortsJournal = "ports.journal";
+const uint32_t PortIpcHandler::kMaxReloadTasks;
+const uint32_t PortIpcHandler::kMinReloadJobsPerTask;
+const uint32_t PortIpcHandler::kJournalCompactMinRecords;
+
 PortIpcHandler::PortIpcHandler(Agent *agent, const std::string &dir)
     : agent_(agent), ports_dir_(dir), vmvn_dir_(dir + "/vm"), version_(0),
       interface_stale_cleaner_(new InterfaceConfigStaleCleaner(agent)),
-       port_subscribe_table_(new PortSubscribeTable(agent_)) {
+       port_subscribe_table_(new PortSubscribeTable(agent_)),
+      journal_file_(dir + "/" + kPortsJournal), journal_records_(0) {
     interface_stale_cleaner_->set_callback(
         boost::bind(&InterfaceConfigStaleCleaner::OnInterfaceConfigStaleTimeout,
                     interface_stale_cleaner_.get(), _1));
@@ -119,6 +127,46 @@ PortIpcHandler::~PortIpcHandler() {
 
 void PortIpcHandler::ReloadAllPorts(const std::string &dir, bool check_port,
                                     bool vm_vn_ports) {
+    ReloadParseStatePtr state(new ReloadParseState(check_port, false));
+    BuildReloadJobs(dir, vm_vn_ports, NULL, 0, &state->jobs);
+    StartReloadJobs(state);
+}
+
+void PortIpcHandler::ReloadAllPorts(bool check_port) {
+    JournalMap journal;
+    std::time_t journal_time = 0;
+    bool has_journal = LoadJournal(&journal, &journal_time);
+
+    ReloadParseStatePtr state(new ReloadParseState(check_port, true));
+    BuildReloadJobs(ports_dir_, false, has_journal ? &journal : NULL,
+                    journal_time, &state->jobs);
+
+    /* Process each vm directory under vmvn_dir_ */
+    fs::path vmvn_dir(vmvn_dir_);
+    fs::directory_iterator end_iter;
+
+    if (fs::exists(vmvn_dir) && fs::is_directory(vmvn_dir)) {
+        fs::directory_iterator it(vmvn_dir);
+        BOOST_FOREACH(fs::path const &p, std::make_pair(it, end_iter)) {
+            if (!fs::is_directory(p)) {
+                continue;
+            }
+            BuildReloadJobs(p.string(), true, NULL, 0, &state->jobs);
+        }
+    }
+
+    StartReloadJobs(state);
+}
+
+/* Build the list of ports to add from the files in a directory. Journal
+ * record of a port is used instead of reading its file when the file is
+ * older than the journal. Files written while the agent was not running are
+ * read, and records of ports whose file was removed are ignored. So the port
+ * files remain authoritative if the journal is stale */
+void PortIpcHandler::BuildReloadJobs(const std::string &dir, bool vm_vn_port,
+                                     const JournalMap *journal,
+                                     std::time_t journal_time,
+                                     ReloadJobList *jobs) const {
     fs::path ports_dir(dir);
     fs::directory_iterator end_iter;
 
@@ -132,49 +180,148 @@ void PortIpcHandler::ReloadAllPorts(const std::string &dir, bool check_port,
             continue;
         }
         /* Skip if filename is not in UUID format */
-        if (!IsUUID(p.filename().string())) {
+        const string name = p.filename().string();
+        if (!IsUUID(name)) {
             continue;
         }
 
-        ProcessFile(p.string(), check_port, vm_vn_ports);
+        if (journal) {
+            JournalMap::const_iterator jit = journal->find(name);
+            boost::system::error_code ec;
+            if (jit != journal->end() &&
+                fs::last_write_time(p, ec) < journal_time && !ec) {
+                jobs->push_back(ReloadJob(p.string(), jit->second,
+                                          vm_vn_port));
+                continue;
+            }
+        }
+        jobs->push_back(ReloadJob(p.string(), "", vm_vn_port));
     }
 }
 
-void PortIpcHandler::ReloadAllPorts(bool check_port) {
-    ReloadAllPorts(ports_dir_, check_port, false);
+/* Parses the port files of ReloadAllPorts. Jobs done by the task are
+ * shared with the other tasks of the reload through state */
+class ReloadParseTask : public Task {
+public:
+    ReloadParseTask(PortIpcHandler *handler,
+                    PortIpcHandler::ReloadParseStatePtr state, int instance) :
+        Task(TaskScheduler::GetInstance()->GetTaskId(kTaskPortIpcReload),
+             instance), handler_(handler), state_(state) {
+    }
+    virtual ~ReloadParseTask() { }
 
-    /* Process each vm directory under vmvn_dir_ */
-    fs::path vmvn_dir(vmvn_dir_);
-    fs::directory_iterator end_iter;
+    bool Run() {
+        handler_->ParseReloadJobs(state_.get());
+        return true;
+    }
+    std::string Description() const { return "ReloadParseTask"; }
 
-    if (!fs::exists(vmvn_dir) || !fs::is_directory(vmvn_dir)) {
+private:
+    PortIpcHandler *handler_;
+    PortIpcHandler::ReloadParseStatePtr state_;
+};
+
+/* Parse the ports in reload parse tasks. ReloadAllPorts returns without
+ * waiting for them, the ports are added by the task parsing the last job */
+void PortIpcHandler::StartReloadJobs(ReloadParseStatePtr state) {
+    if (state->jobs.empty()) {
+        ProcessReloadJobs(state.get());
         return;
     }
-    fs::directory_iterator it(vmvn_dir);
-    BOOST_FOREACH(fs::path const &p, std::make_pair(it, end_iter)) {
-        if (!fs::is_directory(p)) {
-            continue;
+
+    size_t tasks = std::min<size_t>(kMaxReloadTasks,
+                                    state->jobs.size() / kMinReloadJobsPerTask);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (size_t i = 0; i < std::max<size_t>(tasks, 1); i++) {
+        scheduler->Enqueue(new ReloadParseTask(this, state, i));
+    }
+}
+
+/* Parse jobs until none is left. A task that runs after all the jobs were
+ * claimed returns without touching the job list */
+void PortIpcHandler::ParseReloadJobs(ReloadParseState *state) {
+    const size_t count = state->jobs.size();
+    for (size_t i = state->next++; i < count; i = state->next++) {
+        ParseReloadJob(&state->jobs[i], state->check_port);
+        if (++state->done == count) {
+            ProcessReloadJobs(state);
         }
-        ReloadAllPorts(p.string(), check_port, true);
     }
 }
 
-void PortIpcHandler::ProcessFile(const string &file, bool check_port,
-                                 bool vm_vn_ports) {
-    string err_msg;
-    std::ifstream f(file.c_str());
-    if (!f.good()) {
+void PortIpcHandler::ParseReloadJob(ReloadJob *job, bool check_port) const {
+    if (job->json.empty()) {
+        std::ifstream f(job->file.c_str());
+        if (!f.good()) {
+            job->parsed = true;
+            return;
+        }
+        std::ostringstream tmp;
+        tmp<<f.rdbuf();
+        job->json = tmp.str();
+        f.close();
+    }
+
+    /* Arrays and invalid strings are left to AddPortFromJson and
+     * AddVmVnPort */
+    contrail_rapidjson::Document d;
+    if (d.Parse<0>(const_cast<char *>(job->json.c_str())).HasParseError()
+        || !d.IsObject()) {
         return;
     }
-    std::ostringstream tmp;
-    tmp<<f.rdbuf();
-    string json = tmp.str();
-    f.close();
 
-    if (vm_vn_ports == false)
-        AddPortFromJson(json, check_port, err_msg, false);
-    else
-        AddVmVnPort(json, check_port, err_msg, false);
+    string err_msg;
+    job->parsed = true;
+    if (job->vm_vn_port) {
+        job->entry.reset(MakeAddVmVnPortRequest(d, check_port, err_msg));
+        if (job->entry.get() == NULL) {
+            CONFIG_TRACE(VmVnPortInfo, err_msg.c_str());
+        }
+    } else {
+        job->entry.reset(MakeAddVmiUuidRequest(d, check_port, err_msg));
+        if (job->entry.get() == NULL) {
+            CONFIG_TRACE(PortInfo, err_msg.c_str());
+        }
+    }
+}
+
+/* Add the ports once all the jobs are parsed. Ports from ports_dir_ are
+ * added with a single batch of interface requests */
+void PortIpcHandler::ProcessReloadJobs(ReloadParseState *state) {
+    ReloadJobList *jobs = &state->jobs;
+    bool check_port = state->check_port;
+    string err_msg;
+    VmiSubscribeEntryPtrList list;
+    for (size_t i = 0; i < jobs->size(); i++) {
+        ReloadJob &job = (*jobs)[i];
+        if (job.vm_vn_port) {
+            continue;
+        }
+        if (job.parsed == false) {
+            AddPortFromJson(job.json, check_port, err_msg, false);
+        } else if (job.entry.get() != NULL) {
+            list.push_back(job.entry);
+        }
+    }
+    AddPortList(list, false, err_msg);
+
+    contrail_rapidjson::Document d;
+    for (size_t i = 0; i < jobs->size(); i++) {
+        ReloadJob &job = (*jobs)[i];
+        if (job.vm_vn_port == false) {
+            continue;
+        }
+        if (job.parsed == false) {
+            AddVmVnPort(job.json, check_port, err_msg, false);
+        } else if (job.entry.get() != NULL) {
+            AddVmVnPortEntry(job.entry, d, false, err_msg);
+        }
+    }
+
+    if (state->compact_journal) {
+        /* Start a new journal with the ports added */
+        CompactJournal();
+    }
 }
 
 bool PortIpcHandler::AddPortArrayFromJson(const contrail_rapidjson::Value &d,
@@ -222,12 +369,13 @@ bool PortIpcHandler::AddPortFromJson(const string &json, bool check_port,
          * first pass and addition in second pass */
         VmiSubscribeEntryPtrList req_list;
         if (AddPortArrayFromJson(d, json, req_list, check_port, err_msg)) {
-            for (size_t i = 0; i < req_list.size(); i++) {
-                AddVmiUuidEntry(req_list[i], d, write_file, err_msg);
-            }
+            AddPortList(req_list, write_file, err_msg);
         }
 
         req_list.clear();
+        if (write_file) {
+            SyncJournal();
+        }
         return true;
     }
 
@@ -238,9 +386,51 @@ bool PortIpcHandler::AddPortFromJson(const string &json, bool check_port,
     }
 
     AddVmiUuidEntry(entry, d, write_file, err_msg);
+    if (write_file) {
+        SyncJournal();
+    }
     return true;
 }
 
+bool PortIpcHandler::AddPortsFromJson(const string &json, bool check_port,
+                                      string &err_msg) {
+    contrail_rapidjson::Document d;
+    if (d.Parse<0>(const_cast<char *>(json.c_str())).HasParseError()) {
+        err_msg = "Invalid Json string ==> " + json;
+        CONFIG_TRACE(PortInfo, err_msg.c_str());
+        return false;
+    }
+    if (!d.IsArray()) {
+        err_msg = "Unexpected Json string (not an array) ==> " + json;
+        CONFIG_TRACE(PortInfo, err_msg.c_str());
+        return false;
+    }
+
+    VmiSubscribeEntryPtrList req_list;
+    if (!AddPortArrayFromJson(d, json, req_list, check_port, err_msg)) {
+        return false;
+    }
+
+    AddPortList(req_list, true, err_msg);
+    SyncJournal();
+    return true;
+}
+
+/* Add the ports with a single batch of interface requests */
+void PortIpcHandler::AddPortList(const VmiSubscribeEntryPtrList &list,
+                                 bool write_file, string &err_msg) {
+    VmiSubscribeEntryPtrList add_list;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (PrepareVmiUuidEntry(list[i], write_file, err_msg)) {
+            add_list.push_back(list[i]);
+        }
+    }
+
+    if (!add_list.empty()) {
+        port_subscribe_table_->AddVmiList(add_list);
+    }
+}
+
 VmiSubscribeEntry *PortIpcHandler::MakeAddVmiUuidRequest
 (const contrail_rapidjson::Value &d, bool check_port,
 std::string &err_msg) const {
@@ -368,6 +558,20 @@ std::string &err_msg) const {
 bool PortIpcHandler::AddVmiUuidEntry(PortSubscribeEntryPtr entry_ref,
                                      const contrail_rapidjson::Value &d,
                                      bool write_file, string &err_msg) const {
+    if (!PrepareVmiUuidEntry(entry_ref, write_file, err_msg)) {
+        return false;
+    }
+
+    VmiSubscribeEntry *entry =
+        dynamic_cast<VmiSubscribeEntry *>(entry_ref.get());
+    port_subscribe_table_->AddVmi(entry->vmi_uuid(), entry_ref);
+    return true;
+}
+
+/* Write the port file if needed and trace the add */
+bool PortIpcHandler::PrepareVmiUuidEntry(PortSubscribeEntryPtr entry_ref,
+                                         bool write_file,
+                                         string &err_msg) const {
     VmiSubscribeEntry *entry =
         dynamic_cast<VmiSubscribeEntry *>(entry_ref.get());
     // If Writing to file fails return error
@@ -386,7 +590,6 @@ bool PortIpcHandler::AddVmiUuidEntry(PortSubscribeEntryPtr entry_ref,
                  PortSubscribeEntry::TypeToString(entry->type()),
                  entry->ip6_addr().to_string(), entry->version(),
                  entry->vhostuser_mode(), entry->link_state());
-    port_subscribe_table_->AddVmi(entry->vmi_uuid(), entry_ref);
     return true;
 }
 
@@ -421,11 +624,130 @@ bool PortIpcHandler::WriteJsonToFile(VmiSubscribeEntry *entry, bool overwrite)
         if (remove) {
             fs::remove(file_path);
         }
+        return output;
     }
 
+    AppendJournal("+ " + UuidToString(entry->vmi_uuid()) + " " +
+                  MakeVmiUuidJson(entry, false, false) + "\n");
     return output;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// Port journal methods
+//
+// Each line of the journal is a record "+ <uuid> <json>" for a port add or
+// change, or "- <uuid>" for a port delete. A line without newline at the end
+// is from an interrupted write and is ignored. The journal is rewritten with
+// the current ports after ReloadAllPorts and when it grows large.
+/////////////////////////////////////////////////////////////////////////////
+bool PortIpcHandler::LoadJournal(JournalMap *journal,
+                                 std::time_t *journal_time) const {
+    fs::path file_path(journal_file_);
+    boost::system::error_code ec;
+    if (!fs::is_regular_file(file_path, ec)) {
+        return false;
+    }
+    *journal_time = fs::last_write_time(file_path, ec);
+    if (ec) {
+        return false;
+    }
+
+    std::ifstream f(journal_file_.c_str());
+    if (!f.good()) {
+        return false;
+    }
+    std::ostringstream tmp;
+    tmp<<f.rdbuf();
+    const string data = tmp.str();
+    f.close();
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        if (end == string::npos) {
+            break;
+        }
+        if (end > pos + 2 && data[pos + 1] == ' ') {
+            if (data[pos] == '+') {
+                size_t id_end = data.find(' ', pos + 2);
+                if (id_end < end) {
+                    (*journal)[data.substr(pos + 2, id_end - pos - 2)] =
+                        data.substr(id_end + 1, end - id_end - 1);
+                }
+            } else if (data[pos] == '-') {
+                journal->erase(data.substr(pos + 2, end - pos - 2));
+            }
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+void PortIpcHandler::AppendJournal(const string &record) const {
+    tbb::mutex::scoped_lock lock(journal_mutex_);
+    if (!journal_.is_open()) {
+        return;
+    }
+    journal_ << record;
+    journal_records_++;
+}
+
+/* Flush the records of a request, and compact the journal if needed */
+void PortIpcHandler::SyncJournal() {
+    {
+        tbb::mutex::scoped_lock lock(journal_mutex_);
+        if (!journal_.is_open()) {
+            return;
+        }
+        journal_.flush();
+        if (journal_records_ <=
+            2 * port_subscribe_table_->Size() + kJournalCompactMinRecords) {
+            return;
+        }
+    }
+    CompactJournal();
+}
+
+/* Rewrite the journal with a record per port and open it for append. The
+ * new journal replaces the old one only once completely written */
+void PortIpcHandler::CompactJournal() {
+    VmiSubscribeEntryPtrList list;
+    port_subscribe_table_->GetVmiList(&list);
+
+    tbb::mutex::scoped_lock lock(journal_mutex_);
+    if (journal_.is_open()) {
+        journal_.close();
+    }
+
+    string tmp_file = journal_file_ + ".tmp";
+    std::ofstream f(tmp_file.c_str(), std::ios::trunc);
+    if (f.fail()) {
+        LOG(ERROR, "Cannot open file " << tmp_file << " for writing");
+        return;
+    }
+    for (size_t i = 0; i < list.size(); i++) {
+        const VmiSubscribeEntry *entry =
+            static_cast<const VmiSubscribeEntry *>(list[i].get());
+        f << "+ " << UuidToString(entry->vmi_uuid()) << " "
+          << MakeVmiUuidJson(entry, false, false) << "\n";
+    }
+    f.close();
+    boost::system::error_code ec;
+    if (f.fail()) {
+        LOG(ERROR, "Cannot write port journal " << tmp_file);
+        fs::remove(tmp_file, ec);
+        return;
+    }
+    fs::rename(tmp_file, journal_file_, ec);
+    if (ec) {
+        LOG(ERROR, "Cannot rename " << tmp_file << " to " << journal_file_);
+        return;
+    }
+
+    journal_.open(journal_file_.c_str(), std::ios::app);
+    journal_records_ = list.size();
+}
+
 bool PortIpcHandler::ValidateMac(const string &mac) const {
     size_t pos = 0;
     int colon = 0;
@@ -449,12 +771,52 @@ bool PortIpcHandler::DeletePort(const string &url, string &err_msg) {
     boost::uuids::uuid vmi_uuid = StringToUuid(url);
     if (vmi_uuid != nil_uuid()) {
         DeleteVmiUuidEntry(vmi_uuid, err_msg);
+        SyncJournal();
         return true;
     }
 
     return true;
 }
 
+bool PortIpcHandler::DeletePortsFromJson(const string &json,
+                                         string &err_msg) {
+    contrail_rapidjson::Document d;
+    if (d.Parse<0>(const_cast<char *>(json.c_str())).HasParseError()) {
+        err_msg = "Invalid Json string ==> " + json;
+        CONFIG_TRACE(PortInfo, err_msg.c_str());
+        return false;
+    }
+    if (!d.IsArray()) {
+        err_msg = "Unexpected Json string (not an array) ==> " + json;
+        CONFIG_TRACE(PortInfo, err_msg.c_str());
+        return false;
+    }
+
+    /* Elements are port ids, or port objects with an id member */
+    std::vector<boost::uuids::uuid> uuid_list;
+    for (size_t i = 0; i < d.Size(); i++) {
+        const contrail_rapidjson::Value& elem = d[i];
+        boost::uuids::uuid u = nil_uuid();
+        if (elem.IsString()) {
+            u = StringToUuid(elem.GetString());
+        } else if (elem.IsObject()) {
+            GetUuidMember(elem, "id", &u, NULL);
+        }
+        if (u == nil_uuid()) {
+            err_msg = "Json Array has invalid element ==> " + json;
+            CONFIG_TRACE(PortInfo, err_msg.c_str());
+            return false;
+        }
+        uuid_list.push_back(u);
+    }
+
+    for (size_t i = 0; i < uuid_list.size(); i++) {
+        DeleteVmiUuidEntry(uuid_list[i], err_msg);
+    }
+    SyncJournal();
+    return true;
+}
+
 void PortIpcHandler::DeleteVmiUuidEntry(
     const boost::uuids::uuid &u, string &err_msg) {
     uint64_t version = 0;
@@ -464,6 +826,7 @@ void PortIpcHandler::DeleteVmiUuidEntry(
     }
     port_subscribe_table_->DeleteVmi(u);
     CONFIG_TRACE(DeletePortEnqueue, "Delete", UuidToString(u), version);
+    AppendJournal("- " + UuidToString(u) + "\n");
 
     string file = ports_dir_ + "/" + UuidToString(u);
     fs::path file_path(file);
@@ -508,6 +871,7 @@ bool PortIpcHandler::EnablePort(const string &url, string &err_msg) {
         }
     }
     InterfaceResync(agent_, u, entry->ifname(), true);
+    SyncJournal();
     string msg = "Enable state for " + url + " version " +
         integerToString(entry->version()) + " written to file : " +
         integerToString(written_to_file);
@@ -548,6 +912,7 @@ bool PortIpcHandler::DisablePort(const string &url, string &err_msg) {
         }
     }
     InterfaceResync(agent_, u, entry->ifname(), false);
+    SyncJournal();
     string msg = "Disable state for " + url + " version " +
         integerToString(entry->version()) + " written to file : " +
         integerToString(written_to_file);
@@ -572,7 +937,8 @@ void PortIpcHandler::AddMember(const char *key, const char *value,
 }
 
 std::string PortIpcHandler::MakeVmiUuidJson(const VmiSubscribeEntry *entry,
-                                            bool meta_info) const {
+                                            bool meta_info,
+                                            bool pretty) const {
     contrail_rapidjson::Document doc;
     doc.SetObject();
     contrail_rapidjson::Document::AllocatorType &a = doc.GetAllocator();
@@ -609,8 +975,15 @@ std::string PortIpcHandler::MakeVmiUuidJson(const VmiSubscribeEntry *entry,
     }
 
     contrail_rapidjson::StringBuffer buffer;
-    contrail_rapidjson::PrettyWriter<contrail_rapidjson::StringBuffer> writer(buffer);
-    doc.Accept(writer);
+    if (pretty) {
+        contrail_rapidjson::PrettyWriter<contrail_rapidjson::StringBuffer>
+            writer(buffer);
+        doc.Accept(writer);
+    } else {
+        contrail_rapidjson::Writer<contrail_rapidjson::StringBuffer>
+            writer(buffer);
+        doc.Accept(writer);
+    }
 
     return buffer.GetString();
 }
@@ -5,7 +5,13 @@
 #ifndef _ROOT_PORT_IPC_HANDLER_H_
 #define _ROOT_PORT_IPC_HANDLER_H_
 
+#include <ctime>
+#include <fstream>
+#include <map>
 #include <string>
+#include <vector>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
 #include <rapidjson/document.h>
 #include <base/timer.h>
 #include <base/address.h>
@@ -23,6 +29,15 @@ typedef std::vector<PortSubscribeEntryPtr> VmiSubscribeEntryPtrList;
 class PortIpcHandler {
 public:
     static const std::string kPortsDir;
+    // Journal of port add/delete in the ports directory. Replayed on
+    // ReloadAllPorts instead of reading one file per port
+    static const std::string kPortsJournal;
+    // Tasks parsing the port files on ReloadAllPorts
+    static const uint32_t kMaxReloadTasks = 8;
+    static const uint32_t kMinReloadJobsPerTask = 64;
+    // Journal is rewritten with the current ports when it has more records
+    // than twice the number of ports plus kJournalCompactMinRecords
+    static const uint32_t kJournalCompactMinRecords = 1024;
 
     PortIpcHandler(Agent *agent, const std::string &dir);
     virtual ~PortIpcHandler();
@@ -45,12 +60,17 @@ public:
     bool AddPortFromJson(const string &json, bool check_port, string &err_msg,
                          bool write_file);
     bool DeletePort(const string &url, string &err_msg);
+    // Bulk add and delete. Json is an array of ports, or of port ids for
+    // delete. All or none of the ports are processed
+    bool AddPortsFromJson(const string &json, bool check_port,
+                          string &err_msg);
+    bool DeletePortsFromJson(const string &json, string &err_msg);
     void DeleteVmiUuidEntry(const boost::uuids::uuid &u, std::string &err_str);
     bool GetPortInfo(const std::string &uuid_str, std::string &info) const;
     bool AddVgwFromJson(const std::string &json, std::string &err_msg) const;
     bool DelVgwFromJson(const std::string &json, std::string &err_msg) const;
     std::string MakeVmiUuidJson(const VmiSubscribeEntry *entry,
-                                bool meta_info) const;
+                                bool meta_info, bool pretty = true) const;
     bool EnablePort(const string &url, string &err_msg);
     bool DisablePort(const string &url, string &err_msg);
 
@@ -73,8 +93,59 @@ public:
     PortSubscribeTable *port_subscribe_table() const {
         return port_subscribe_table_.get();
     }
+    uint32_t journal_records() const { return journal_records_; }
 private:
     friend class PortIpcTest;
+    friend class ReloadParseTask;
+
+    // Port file or journal record to parse on ReloadAllPorts
+    struct ReloadJob {
+        ReloadJob(const std::string &f, const std::string &j, bool vm_vn) :
+            file(f), json(j), vm_vn_port(vm_vn), parsed(false) {
+        }
+        std::string file;
+        std::string json;
+        bool vm_vn_port;
+        // Set when the port was parsed by ParseReloadJob. Others are added
+        // through AddPortFromJson/AddVmVnPort
+        bool parsed;
+        PortSubscribeEntryPtr entry;
+    };
+    typedef std::vector<ReloadJob> ReloadJobList;
+
+    // Jobs of a reload, shared by its parse tasks. Each task claims the
+    // next job until none is left. The task parsing the last job adds the
+    // ports
+    struct ReloadParseState {
+        ReloadParseState(bool check, bool compact) :
+            check_port(check), compact_journal(compact) {
+            next = 0;
+            done = 0;
+        }
+        ReloadJobList jobs;
+        const bool check_port;
+        // Start a new journal once the ports are added
+        const bool compact_journal;
+        tbb::atomic<size_t> next;
+        tbb::atomic<size_t> done;
+    };
+    typedef boost::shared_ptr<ReloadParseState> ReloadParseStatePtr;
+    typedef std::map<std::string, std::string> JournalMap;
+
+    void BuildReloadJobs(const std::string &dir, bool vm_vn_port,
+                         const JournalMap *journal, std::time_t journal_time,
+                         ReloadJobList *jobs) const;
+    void StartReloadJobs(ReloadParseStatePtr state);
+    void ParseReloadJobs(ReloadParseState *state);
+    void ParseReloadJob(ReloadJob *job, bool check_port) const;
+    void ProcessReloadJobs(ReloadParseState *state);
+    void AddPortList(const VmiSubscribeEntryPtrList &list, bool write_file,
+                     std::string &err_msg);
+
+    bool LoadJournal(JournalMap *journal, std::time_t *journal_time) const;
+    void AppendJournal(const std::string &record) const;
+    void SyncJournal();
+    void CompactJournal();
     bool InterfaceExists(const std::string &name) const;
 
     VmiSubscribeEntry *MakeAddVmiUuidRequest(const contrail_rapidjson::Value &d,
@@ -97,13 +168,14 @@ private:
 
     bool AddVmiUuidEntry(PortSubscribeEntryPtr entry, const contrail_rapidjson::Value &d,
                          bool write_file, std::string &err_msg) const;
+    bool PrepareVmiUuidEntry(PortSubscribeEntryPtr entry, bool write_file,
+                             std::string &err_msg) const;
     bool AddVmVnPortEntry(PortSubscribeEntryPtr entry,
                           const contrail_rapidjson::Value &d, bool write_file,
                           std::string &err_msg) const;
 
     bool ValidateMac(const std::string &mac) const;
     bool IsUUID(const std::string &uuid_str) const;
-    void ProcessFile(const std::string &file, bool check_port, bool vm_vn_port);
     void AddMember(const char *key, const char *value,
                    contrail_rapidjson::Document *doc) const;
     bool WriteJsonToFile(VmiSubscribeEntry *entry, bool overwrite) const;
@@ -118,6 +190,10 @@ private:
     int version_;
     boost::scoped_ptr<InterfaceConfigStaleCleaner> interface_stale_cleaner_;
     std::auto_ptr<PortSubscribeTable> port_subscribe_table_;
+    std::string journal_file_;
+    mutable tbb::mutex journal_mutex_;
+    mutable std::ofstream journal_;
+    mutable uint32_t journal_records_;
 
     DISALLOW_COPY_AND_ASSIGN(PortIpcHandler);
 };
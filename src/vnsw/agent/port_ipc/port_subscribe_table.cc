@@ -5,6 +5,7 @@
 #include <sandesh/sandesh_trace.h>
 #include <port_ipc/port_ipc_types.h>
 #include <cmn/agent_cmn.h>
+#include <db/db_partition.h>
 #include <init/agent_param.h>
 #include <oper/interface_common.h>
 #include <controller/controller_init.h>
@@ -99,6 +100,11 @@ void VmiSubscribeEntry::Update(const PortSubscribeEntry *rhs) {
 }
 
 void VmiSubscribeEntry::OnAdd(Agent *agent, PortSubscribeTable *table) const {
+    OnAdd(agent, table, NULL);
+}
+
+void VmiSubscribeEntry::OnAdd(Agent *agent, PortSubscribeTable *table,
+                              DBRequestBatch *batch) const {
     uint16_t tx_vlan_id_p = VmInterface::kInvalidVlanId;
     uint16_t rx_vlan_id_p = VmInterface::kInvalidVlanId;
     string port = Agent::NullString();
@@ -125,7 +131,7 @@ void VmiSubscribeEntry::OnAdd(Agent *agent, PortSubscribeTable *table) const {
     VmInterface::NovaAdd(agent->interface_table(), vmi_uuid_, ifname_,
                          ip4_addr_, mac_addr_, vm_name_, project_uuid_,
                          tx_vlan_id_p, rx_vlan_id_p, port, ip6_addr_,
-                         vhostuser_mode_, transport, link_state_);
+                         vhostuser_mode_, transport, link_state_, batch);
 
     // Notify controller module about new port
     if (type_ == PortSubscribeEntry::NAMESPACE)
@@ -215,6 +221,29 @@ PortSubscribeTable::~PortSubscribeTable() {
 void PortSubscribeTable::AddVmi(const boost::uuids::uuid &u,
                              PortSubscribeEntryPtr entry) {
     tbb::mutex::scoped_lock lock(mutex_);
+    InsertVmi(u, entry)->OnAdd(agent_, this);
+}
+
+void PortSubscribeTable::AddVmiList
+(const std::vector<PortSubscribeEntryPtr> &list) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    DBRequestBatch batch(interface_table_);
+    for (size_t i = 0; i < list.size(); i++) {
+        VmiSubscribeEntry *entry =
+            dynamic_cast<VmiSubscribeEntry *>(list[i].get());
+        PortSubscribeEntryPtr ref = InsertVmi(entry->vmi_uuid(), list[i]);
+        static_cast<VmiSubscribeEntry *>(ref.get())->OnAdd(agent_, this,
+                                                            &batch);
+    }
+    // Deletes of replaced entries are enqueued before the batch, so they are
+    // processed first
+    interface_table_->EnqueueBatch(&batch);
+}
+
+// Insert entry in the tree or update the existing entry. Returns the entry
+// in the tree. Caller holds the mutex
+PortSubscribeEntryPtr PortSubscribeTable::InsertVmi
+(const boost::uuids::uuid &u, PortSubscribeEntryPtr entry) {
     std::pair<VmiTree::iterator, bool> ret =
         vmi_tree_.insert(std::make_pair(u, entry));
     if (ret.second == false) {
@@ -232,8 +261,7 @@ void PortSubscribeTable::AddVmi(const boost::uuids::uuid &u,
             ret.first->second->Update(entry.get());
         }
     }
-
-    ret.first->second->OnAdd(agent_, this);
+    return ret.first->second;
 }
 
 void PortSubscribeTable::DeleteVmi(const boost::uuids::uuid &u) {
@@ -256,6 +284,15 @@ PortSubscribeEntryPtr PortSubscribeTable::GetVmi(const boost::uuids::uuid &u)
     return it->second;
 }
 
+void PortSubscribeTable::GetVmiList(std::vector<PortSubscribeEntryPtr> *list)
+    const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (VmiTree::const_iterator it = vmi_tree_.begin();
+         it != vmi_tree_.end(); ++it) {
+        list->push_back(it->second);
+    }
+}
+
 /*
  * Process add of vm-vn subscribe entry.
  * Add an entry to vmvn_subscribe_tree_
@@ -27,6 +27,7 @@ class VmiSubscribeEntry;
 class VmVnPortSubscribeEntry;
 class PortSubscribeEntry;
 class PortSubscribeTable;
+class DBRequestBatch;
 typedef boost::shared_ptr<PortSubscribeEntry> PortSubscribeEntryPtr;
 
 /****************************************************************************
@@ -84,6 +85,9 @@ public:
 
     virtual void Update(const PortSubscribeEntry *rhs);
     void OnAdd(Agent *agent, PortSubscribeTable *table) const;
+    // Interface add request goes to batch instead of the interface table
+    void OnAdd(Agent *agent, PortSubscribeTable *table,
+               DBRequestBatch *batch) const;
     void OnDelete(Agent *agent, PortSubscribeTable *table) const;
 
     const boost::uuids::uuid &vmi_uuid() const { return vmi_uuid_; }
@@ -250,8 +254,12 @@ public:
     uint32_t Size() const { return vmi_tree_.size(); }
 
     void AddVmi(const boost::uuids::uuid &u, PortSubscribeEntryPtr entry);
+    // Add VmiSubscribeEntry list with a single enqueue of the interface add
+    // requests to the interface table
+    void AddVmiList(const std::vector<PortSubscribeEntryPtr> &list);
     void DeleteVmi(const boost::uuids::uuid &u);
     PortSubscribeEntryPtr GetVmi(const boost::uuids::uuid &u) const;
+    void GetVmiList(std::vector<PortSubscribeEntryPtr> *list) const;
 
     void AddVmVnPort(const boost::uuids::uuid &vm_uuid,
                      const boost::uuids::uuid &vn_uuid,
@@ -282,6 +290,8 @@ public:
     const VmiEntry *VmiToEntry(const boost::uuids::uuid &vmi_uuid) const;
 
 private:
+    PortSubscribeEntryPtr InsertVmi(const boost::uuids::uuid &u,
+                                    PortSubscribeEntryPtr entry);
     void UpdateVmiIfnodeInfo(const boost::uuids::uuid &vmi_uuid,
                              const VmInterfaceConfigData *data);
     void DeleteVmiIfnodeInfo(const boost::uuids::uuid &vmi_uuid);
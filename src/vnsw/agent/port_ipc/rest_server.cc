@@ -72,6 +72,34 @@ void RESTServer::VmPortPostHandler(const struct RESTData& data) {
     }
 }
 
+void RESTServer::VmPortBulkPostHandler(const struct RESTData& data) {
+    PortIpcHandler *pih = agent_->port_ipc_handler();
+    if (pih) {
+        std::string err_msg;
+        if (pih->AddPortsFromJson(data.request->Body(), false, err_msg)) {
+            REST::SendResponse(data.session, "{}");
+        } else {
+            REST::SendErrorResponse(data.session, "{ " + err_msg + " }");
+        }
+    } else {
+       REST::SendErrorResponse(data.session, "{ Operation Not Supported }");
+    }
+}
+
+void RESTServer::VmPortBulkDeleteHandler(const struct RESTData& data) {
+    PortIpcHandler *pih = agent_->port_ipc_handler();
+    if (pih) {
+        std::string err_msg;
+        if (pih->DeletePortsFromJson(data.request->Body(), err_msg)) {
+            REST::SendResponse(data.session, "{}");
+        } else {
+            REST::SendErrorResponse(data.session, "{ " + err_msg + " }");
+        }
+    } else {
+        REST::SendErrorResponse(data.session, "{ Operation Not Supported }");
+    }
+}
+
 void RESTServer::VmPortSyncHandler(const struct RESTData& data) {
     PortIpcHandler *pih = agent_->port_ipc_handler();
     if (pih) {
@@ -245,6 +273,14 @@ const std::vector<RESTServer::HandlerSpecifier> RESTServer::RESTHandlers_ =
         regex("/port"),
         HTTP_POST,
         &RESTServer::VmPortPostHandler))
+    (HandlerSpecifier(
+        regex("/ports"),
+        HTTP_POST,
+        &RESTServer::VmPortBulkPostHandler))
+    (HandlerSpecifier(
+        regex("/ports"),
+        HTTP_DELETE,
+        &RESTServer::VmPortBulkDeleteHandler))
     (HandlerSpecifier(
         regex("/syncports"),
         HTTP_POST,
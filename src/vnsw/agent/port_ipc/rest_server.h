@@ -56,6 +56,9 @@ class RESTServer {
     void GatewayDeleteHandler(const struct RESTData& data);
     void VmPortEnableHandler(const struct RESTData& data);
     void VmPortDisableHandler(const struct RESTData& data);
+    // Bulk add/delete of ports, body is a JSON array
+    void VmPortBulkPostHandler(const struct RESTData& data);
+    void VmPortBulkDeleteHandler(const struct RESTData& data);
 
     // Handler for VM+VN based messages
     void VmVnPortPostHandler(const struct RESTData&);
@@ -2,9 +2,13 @@
  * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <unistd.h>
+#include <ctime>
+#include <fstream>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include "base/os.h"
+#include "base/string_util.h"
 #include "testing/gunit.h"
 #include "test/test_cmn_util.h"
 #include "port_ipc/port_ipc_handler.h"
@@ -48,6 +52,71 @@ class PortIpcTest : public ::testing::Test {
      bool IsUUID(const string &file) {
          return pih_->IsUUID(file);
      }
+     // Write count port files in dir, and return the port ids
+     void WritePortFiles(const string &dir, uint32_t count,
+                         std::vector<boost::uuids::uuid> *list) {
+         for (uint32_t i = 0; i < count; i++) {
+             char uuid_str[64], ifname[32], mac[32], ip[32];
+             snprintf(uuid_str, sizeof(uuid_str),
+                      "00000000-0000-0000-0000-0000%08x", i + 1);
+             snprintf(ifname, sizeof(ifname), "tapscale%u", i);
+             snprintf(mac, sizeof(mac), "02:00:00:00:%02x:%02x",
+                      (i >> 8) & 0xff, i & 0xff);
+             snprintf(ip, sizeof(ip), "12.%u.%u.1", (i >> 8) & 0xff,
+                      i & 0xff);
+             boost::uuids::uuid u = StringToUuid(uuid_str);
+             VmiSubscribeEntry entry(PortSubscribeEntry::VMPORT, ifname, 0, u,
+                 StringToUuid("ea73b285-01a7-4d3e-8322-50976e8913db"),
+                 "vm1", StringToUuid("fa73b285-01a7-4d3e-8322-50976e8913de"),
+                 StringToUuid("b02a3bfb-7946-4b1c-8cc4-bf8cedcbc48d"),
+                 Ip4Address::from_string(ip), Ip6Address(), mac,
+                 VmInterface::kInvalidVlanId, VmInterface::kInvalidVlanId,
+                 0, 1);
+             std::ofstream f((dir + "/" + uuid_str).c_str());
+             f << pih_->MakeVmiUuidJson(&entry, true);
+             list->push_back(u);
+         }
+     }
+
+     // Reload the ports and wait for all the interfaces to be present
+     void ReloadPorts(const std::vector<boost::uuids::uuid> &list,
+                      const string &dir, bool journal) {
+         if (journal) {
+             pih_->ReloadAllPorts(false);
+         } else {
+             pih_->ReloadAllPorts(dir, false, false);
+         }
+         WAIT_FOR(10000, 1000, (InterfacesPresent(list) == list.size()));
+     }
+
+     size_t InterfacesPresent(const std::vector<boost::uuids::uuid> &list) {
+         size_t count = 0;
+         for (size_t i = 0; i < list.size(); i++) {
+             if (agent_->interface_table()->FindVmi(list[i]) != NULL) {
+                 count++;
+             }
+         }
+         return count;
+     }
+
+     // Remove the ports from the agent, keeping the port files
+     void UnsubscribePorts(const std::vector<boost::uuids::uuid> &list) {
+         for (size_t i = 0; i < list.size(); i++) {
+             pih_->port_subscribe_table()->DeleteVmi(list[i]);
+         }
+         client->WaitForIdle(10);
+         WAIT_FOR(10000, 1000, (InterfacesPresent(list) == 0));
+     }
+
+     const string &ports_dir() const { return pih_->ports_dir_; }
+     void SetPortsDir(const string &dir) {
+         pih_->ports_dir_ = dir;
+         pih_->journal_file_ = dir + "/" + PortIpcHandler::kPortsJournal;
+         if (pih_->journal_.is_open()) {
+             pih_->journal_.close();
+         }
+     }
+
      void DeleteAllPorts(const string &dir) {
          string err_str;
          fs::path ports_dir(dir);
@@ -270,6 +339,95 @@ TEST_F(PortIpcTest, Port_Sync) {
     agent()->set_port_ipc_handler(ipc);
 }
 
+/* Bulk add and delete of ports with a JSON array */
+TEST_F(PortIpcTest, Port_Bulk_Add_Del) {
+    uint32_t port_count = PortSubscribeSize(agent_);
+    std::string err_str;
+    const string ports = "["
+        "{\"id\": \"ea73b285-01a7-4d3e-8322-50976e8913da\","
+        " \"instance-id\": \"ea73b285-01a7-4d3e-8322-50976e8913db\","
+        " \"vn-id\": \"fa73b285-01a7-4d3e-8322-50976e8913de\","
+        " \"vm-project-id\": \"b02a3bfb-7946-4b1c-8cc4-bf8cedcbc48d\","
+        " \"display-name\": \"vm1\", \"ip-address\": \"11.0.0.3\","
+        " \"ip6-address\": \"\", \"type\": 0,"
+        " \"system-name\": \"tap1af4bee3-04\","
+        " \"mac-address\": \"02:1a:f4:be:e3:04\","
+        " \"rx-vlan-id\": 65535, \"tx-vlan-id\": 65535},"
+        "{\"id\": \"ea73b285-01a7-4d3e-8322-50976e8913dc\","
+        " \"instance-id\": \"ea73b285-01a7-4d3e-8322-50976e8913db\","
+        " \"vn-id\": \"fa73b285-01a7-4d3e-8322-50976e8913de\","
+        " \"vm-project-id\": \"b02a3bfb-7946-4b1c-8cc4-bf8cedcbc48d\","
+        " \"display-name\": \"vm1\", \"ip-address\": \"11.0.0.4\","
+        " \"ip6-address\": \"\", \"type\": 0,"
+        " \"system-name\": \"tap1af4bee3-05\","
+        " \"mac-address\": \"02:1a:f4:be:e3:05\","
+        " \"rx-vlan-id\": 65535, \"tx-vlan-id\": 65535}]";
+
+    // Not an array
+    EXPECT_FALSE(pih_->AddPortsFromJson("{}", false, err_str));
+    EXPECT_TRUE(pih_->AddPortsFromJson(ports, false, err_str));
+    client->WaitForIdle(2);
+    WAIT_FOR(500, 1000, ((port_count + 2) == PortSubscribeSize(agent_)));
+
+    // Invalid id, none of the ports are deleted
+    EXPECT_FALSE(pih_->DeletePortsFromJson(
+        "[\"ea73b285-01a7-4d3e-8322-50976e8913da\", \"x\"]", err_str));
+    client->WaitForIdle(2);
+    EXPECT_EQ(port_count + 2, PortSubscribeSize(agent_));
+
+    EXPECT_TRUE(pih_->DeletePortsFromJson(
+        "[\"ea73b285-01a7-4d3e-8322-50976e8913da\","
+        " {\"id\": \"ea73b285-01a7-4d3e-8322-50976e8913dc\"}]", err_str));
+    client->WaitForIdle(2);
+    WAIT_FOR(500, 1000, ((port_count) == PortSubscribeSize(agent_)));
+}
+
+/* Port ready time after restart, with a file per port and with the journal */
+TEST_F(PortIpcTest, PortReloadScale) {
+    const uint32_t kPortCount = 1024;
+    const string dir = "/tmp/port_ipc_scale_" + integerToString(getpid());
+    const string saved_ports_dir = ports_dir();
+    uint32_t port_count = PortSubscribeSize(agent_);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    std::vector<boost::uuids::uuid> list;
+    WritePortFiles(dir, kPortCount, &list);
+
+    ReloadPorts(list, dir, false);
+    EXPECT_EQ(port_count + kPortCount, PortSubscribeSize(agent_));
+    UnsubscribePorts(list);
+
+    // First reload from dir writes the journal
+    SetPortsDir(dir);
+    ReloadPorts(list, dir, true);
+    WAIT_FOR(1000, 1000,
+             ((port_count + kPortCount) == pih_->journal_records()));
+    UnsubscribePorts(list);
+
+    // Port files older than the journal are not read. Emptied port files
+    // are still added from their journal record
+    std::time_t now = time(NULL);
+    for (size_t i = 0; i < list.size(); i++) {
+        const string file = dir + "/" + UuidToString(list[i]);
+        std::ofstream(file.c_str(), std::ios::trunc);
+        fs::last_write_time(file, now - 60);
+    }
+    fs::last_write_time(dir + "/" + PortIpcHandler::kPortsJournal, now);
+    ReloadPorts(list, dir, true);
+    EXPECT_EQ(port_count + kPortCount, PortSubscribeSize(agent_));
+
+    //cleanup
+    std::string err_str;
+    for (size_t i = 0; i < list.size(); i++) {
+        pih_->DeleteVmiUuidEntry(list[i], err_str);
+    }
+    client->WaitForIdle(2);
+    WAIT_FOR(500, 1000, ((port_count) == PortSubscribeSize(agent_)));
+    SetPortsDir(saved_ports_dir);
+    fs::remove_all(dir);
+}
+
 TEST_F(PortIpcTest, Port_Add_Python) {
 
     const char* cmd = "python controller/src/vnsw/agent/port_ipc/vrouter-port-control --oper=add --uuid=100 --instance_uuid=f9885c6f-7278-11ea-bf6e-02486f9480e0 --vn_uuid=f988b4e1-7278-11ea-bf6e-02486f9480e0 --vm_project_uuid=f9886e9f-7278-11ea-bf6e-02486f9480e0 --ip_address=1.1.1.10 --ipv6_address= --vm_name=vm1 --tap_name=tap1 --mac=90:e2:ff:ff:94:9d --rx_vlan_id=0 --tx_vlan_id=0 --port_json_path='./'";
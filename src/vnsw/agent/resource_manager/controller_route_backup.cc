@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <cmn/agent_cmn.h>
+#include <cmn/agent.h>
+#include <init/agent_param.h>
+#include <oper/vrf.h>
+#include <oper/vn.h>
+#include <oper/route_common.h>
+#include <oper/ecmp_load_balance.h>
+#include <controller/controller_route_path.h>
+#include "resource_manager/resource_manager.h"
+#include "resource_manager/resource_backup.h"
+#include "resource_manager/sandesh_map.h"
+#include "resource_manager/controller_route_backup.h"
+
+static std::string PrefixToString(const IpAddress &addr, uint8_t plen) {
+    std::stringstream prefix;
+    prefix << addr.to_string() << "/" << (int)plen;
+    return prefix.str();
+}
+
+// Evpn routes are keyed as in their retract id
+static std::string EvpnRouteKey(const MacAddress &mac, const IpAddress &addr,
+                                uint8_t plen, uint32_t ethernet_tag) {
+    std::stringstream key;
+    key << ethernet_tag << "-" << mac.ToString() << ","
+        << PrefixToString(addr, plen);
+    return key.str();
+}
+
+static bool PrefixFromString(const std::string &prefix, IpAddress *addr,
+                             uint8_t *plen) {
+    size_t pos = prefix.find('/');
+    if (pos == std::string::npos)
+        return false;
+    boost::system::error_code ec;
+    *addr = IpAddress::from_string(prefix.substr(0, pos), ec);
+    if (ec.value() != 0)
+        return false;
+    *plen = strtoul(prefix.c_str() + pos + 1, NULL, 10);
+    return true;
+}
+
+ControllerRouteResourceKey::ControllerRouteResourceKey(ResourceManager *rm,
+    const std::string &vrf_name, const std::string &route_key,
+    uint8_t xs_idx) :
+    ResourceKey(rm, Resource::INVALID), vrf_name_(vrf_name),
+    route_key_(route_key), xs_idx_(xs_idx) {
+}
+
+ControllerRouteResourceKey::~ControllerRouteResourceKey() {
+}
+
+bool ControllerRouteResourceKey::IsLess(const ResourceKey &rhs) const {
+    const ControllerRouteResourceKey *key =
+        static_cast<const ControllerRouteResourceKey *>(&rhs);
+    if (vrf_name_ != key->vrf_name_)
+        return vrf_name_ < key->vrf_name_;
+    if (route_key_ != key->route_key_)
+        return route_key_ < key->route_key_;
+    return xs_idx_ < key->xs_idx_;
+}
+
+// Only the map is updated here, the file is written by the table once no
+// change is seen for the idle time out.
+void ControllerRouteResourceKey::Backup(ResourceData *data, uint16_t op) {
+    ControllerRouteBackUpResourceTable &table =
+        rm()->backup_mgr()->sandesh_maps().controller_route_table();
+    if (op == ResourceBackupReq::AUDIT) {
+        table.FlushStale();
+    } else if (op == ResourceBackupReq::DEL) {
+        table.DeleteRoute(vrf_name_, route_key_, xs_idx_);
+    } else {
+        ControllerRouteResourceData *route_data =
+            static_cast<ControllerRouteResourceData *>(data);
+        table.AddRoute(vrf_name_, route_key_, route_data->config(),
+                       route_data->route());
+    }
+    table.TriggerBackup();
+}
+
+ControllerRouteResourceData::ControllerRouteResourceData(ResourceManager *rm,
+    const ControllerVrfConfigResource &config,
+    const ControllerRouteResource &route) :
+    ResourceData(rm), config_(config), route_(route) {
+}
+
+ControllerRouteResourceData::~ControllerRouteResourceData() {
+}
+
+ControllerRouteBackup::ControllerRouteBackup(ResourceBackupManager *manager) :
+    backup_manager_(manager), agent_(manager->agent()),
+    vrf_listener_id_(DBTableBase::kInvalidId), restored_route_count_(0) {
+}
+
+ControllerRouteBackup::~ControllerRouteBackup() {
+    if (vrf_listener_id_ != DBTableBase::kInvalidId) {
+        agent_->vrf_table()->Unregister(vrf_listener_id_);
+    }
+}
+
+// The config of the vrf is taken along with the route, it is what the
+// restore needs to create the vrf before config is downloaded.
+void ControllerRouteBackup::Backup(Agent *agent, uint8_t xs_idx,
+                                   const std::string &vrf_name,
+                                   const std::string &route_key,
+                                   ControllerRouteResource *route) {
+    ResourceManager *rm = agent->resource_manager();
+    if (rm == NULL || rm->backup_mgr() == NULL)
+        return;
+
+    ControllerVrfConfigResource config;
+    VrfEntry *vrf = agent->vrf_table()->FindVrfFromName(vrf_name);
+    const VnEntry *vn = vrf ? vrf->vn() : NULL;
+    if (vn) {
+        config.set_vn_uuid(UuidToString(vn->GetUuid()));
+        config.set_vn_name(vn->GetName());
+        config.set_vn_id(vn->vnid());
+        config.set_vxlan_id(vn->GetVxLanId());
+    }
+
+    route->set_time_stamp(UTCTimestampUsec());
+    route->set_controller_bmap(1 << xs_idx);
+    ResourceManager::KeyPtr key(new ControllerRouteResourceKey(rm, vrf_name,
+                                    route_key, xs_idx));
+    ResourceManager::DataPtr data(new ControllerRouteResourceData(rm, config,
+                                                                  *route));
+    rm->backup_mgr()->BackupResource(key, data, ResourceBackupReq::ADD);
+}
+
+void ControllerRouteBackup::Withdraw(Agent *agent, uint8_t xs_idx,
+                                     const std::string &vrf_name,
+                                     const std::string &route_key) {
+    ResourceManager *rm = agent->resource_manager();
+    if (rm == NULL || rm->backup_mgr() == NULL)
+        return;
+
+    ResourceManager::KeyPtr key(new ControllerRouteResourceKey(rm, vrf_name,
+                                    route_key, xs_idx));
+    ResourceManager::DataPtr data;
+    rm->backup_mgr()->BackupResource(key, data, ResourceBackupReq::DEL);
+}
+
+void ControllerRouteBackup::AddRoute(Agent *agent, uint8_t xs_idx,
+                                     const std::string &vrf_name,
+                                     const IpAddress &addr, uint8_t plen,
+                                     const NextHopList &nh_list,
+                                     const VnListType &vn_list,
+                                     const SecurityGroupList &sg_list,
+                                     const TagList &tag_list,
+                                     uint32_t preference) {
+    ControllerRouteResource route;
+    route.set_prefix(PrefixToString(addr, plen));
+    route.set_nexthop_list(nh_list);
+    route.set_vn_list(std::vector<std::string>(vn_list.begin(),
+                                               vn_list.end()));
+    route.set_sg_list(sg_list);
+    route.set_tag_list(tag_list);
+    route.set_preference(preference);
+    Backup(agent, xs_idx, vrf_name, route.get_prefix(), &route);
+}
+
+void ControllerRouteBackup::DeleteRoute(Agent *agent, uint8_t xs_idx,
+                                        const std::string &vrf_name,
+                                        const IpAddress &addr, uint8_t plen) {
+    Withdraw(agent, xs_idx, vrf_name, PrefixToString(addr, plen));
+}
+
+void ControllerRouteBackup::AddEvpnRoute(Agent *agent, uint8_t xs_idx,
+                                         const std::string &vrf_name,
+                                         const MacAddress &mac,
+                                         const IpAddress &addr, uint8_t plen,
+                                         uint32_t ethernet_tag,
+                                         const NextHopList &nh_list,
+                                         const VnListType &vn_list,
+                                         const SecurityGroupList &sg_list,
+                                         const TagList &tag_list,
+                                         uint32_t preference) {
+    ControllerRouteResource route;
+    route.set_prefix(PrefixToString(addr, plen));
+    route.set_nexthop_list(nh_list);
+    route.set_vn_list(std::vector<std::string>(vn_list.begin(),
+                                               vn_list.end()));
+    route.set_sg_list(sg_list);
+    route.set_tag_list(tag_list);
+    route.set_preference(preference);
+    route.set_evpn(true);
+    route.set_mac(mac.ToString());
+    route.set_ethernet_tag(ethernet_tag);
+    Backup(agent, xs_idx, vrf_name,
+           EvpnRouteKey(mac, addr, plen, ethernet_tag), &route);
+}
+
+void ControllerRouteBackup::DeleteEvpnRoute(Agent *agent, uint8_t xs_idx,
+                                            const std::string &vrf_name,
+                                            const MacAddress &mac,
+                                            const IpAddress &addr,
+                                            uint8_t plen,
+                                            uint32_t ethernet_tag) {
+    Withdraw(agent, xs_idx, vrf_name,
+             EvpnRouteKey(mac, addr, plen, ethernet_tag));
+}
+
+void ControllerRouteBackup::Restore(const VrfRouteMap &vrf_route_map) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    pending_map_ = vrf_route_map;
+}
+
+// Vrfs created before the listener is registered are looked up here, the
+// others are created from the backup and restored as they are notified.
+void ControllerRouteBackup::Start() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (pending_map_.empty())
+        return;
+
+    if (vrf_listener_id_ == DBTableBase::kInvalidId) {
+        vrf_listener_id_ = agent_->vrf_table()->Register(
+            boost::bind(&ControllerRouteBackup::VrfNotify, this, _1, _2));
+    }
+
+    VrfRouteMapIter it = pending_map_.begin();
+    while (it != pending_map_.end()) {
+        VrfEntry *vrf = agent_->vrf_table()->FindVrfFromName(it->first);
+        if (vrf == NULL) {
+            CreateVrf(it->first, it->second.get_config());
+            it++;
+            continue;
+        }
+        AddRoutes(it->first, it->second);
+        restored_map_.insert(*it);
+        pending_map_.erase(it++);
+    }
+}
+
+// The virtual network is created first so that the vrf finds it. Both are
+// kept only till end of rib unless config sends them.
+void ControllerRouteBackup::CreateVrf(const std::string &vrf_name,
+                                const ControllerVrfConfigResource &config) {
+    boost::uuids::uuid vn_uuid = boost::uuids::nil_uuid();
+    if (config.get_vn_uuid().empty() == false)
+        vn_uuid = StringToUuid(config.get_vn_uuid());
+
+    if (vn_uuid != boost::uuids::nil_uuid() &&
+        agent_->vn_table()->Find(vn_uuid) == NULL) {
+        agent_->vn_table()->AddVn(vn_uuid, config.get_vn_name(),
+                                  boost::uuids::nil_uuid(), vrf_name,
+                                  std::vector<VnIpam>(),
+                                  VnData::VnIpamDataMap(),
+                                  config.get_vn_id(), config.get_vxlan_id(),
+                                  true, true, false, false, false, false);
+        restored_vn_set_.insert(vn_uuid);
+    }
+    agent_->vrf_table()->CreateVrfReq(vrf_name, vn_uuid,
+                                      VrfData::RestoreVrf);
+    restored_vrf_set_.insert(vrf_name);
+}
+
+void ControllerRouteBackup::VrfNotify(DBTablePartBase *partition,
+                                      DBEntryBase *e) {
+    VrfEntry *vrf = static_cast<VrfEntry *>(e);
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (vrf->IsDeleted()) {
+        restored_map_.erase(vrf->GetName());
+        return;
+    }
+
+    VrfRouteMapIter it = pending_map_.find(vrf->GetName());
+    if (it == pending_map_.end())
+        return;
+    AddRoutes(it->first, it->second);
+    restored_map_.insert(*it);
+    pending_map_.erase(it);
+}
+
+// A route with more than one nexthop is added with a composite of the
+// tunnel nexthops, as the control-node ECMP routes are.
+AgentRouteData *ControllerRouteBackup::BuildRouteData
+(const std::string &vrf_name, const ControllerRouteResource &route) {
+    VnListType vn_list(route.get_vn_list().begin(),
+                       route.get_vn_list().end());
+    PathPreference path_preference(0, route.get_preference(), false, false);
+    const NextHopList &nh_list = route.get_nexthop_list();
+    boost::system::error_code ec;
+
+    if (nh_list.size() == 1) {
+        Ip4Address tunnel_dest =
+            Ip4Address::from_string(nh_list[0].get_tunnel_dest(), ec);
+        if (ec.value() != 0)
+            return NULL;
+        return ControllerVmRoute::MakeControllerVmRoute(NULL,
+                               agent_->fabric_vrf_name(), agent_->router_id(),
+                               vrf_name, tunnel_dest,
+                               nh_list[0].get_tunnel_bmap(),
+                               nh_list[0].get_label(), MacAddress(), vn_list,
+                               route.get_sg_list(), route.get_tag_list(),
+                               path_preference, false, EcmpLoadBalance(),
+                               false);
+    }
+
+    TunnelType::TypeBmap bmap = 0;
+    ComponentNHKeyList comp_nh_list;
+    for (NextHopList::const_iterator it = nh_list.begin();
+         it != nh_list.end(); it++) {
+        Ip4Address tunnel_dest =
+            Ip4Address::from_string(it->get_tunnel_dest(), ec);
+        if (ec.value() != 0)
+            return NULL;
+        bmap = it->get_tunnel_bmap();
+        std::auto_ptr<const NextHopKey> nh_key(new TunnelNHKey(
+                               agent_->fabric_vrf_name(), agent_->router_id(),
+                               tunnel_dest, false,
+                               TunnelType::ComputeType(bmap)));
+        ComponentNHKeyPtr component_nh_key(new ComponentNHKey(
+                                           it->get_label(), nh_key));
+        comp_nh_list.push_back(component_nh_key);
+    }
+
+    if (comp_nh_list.empty())
+        return NULL;
+
+    DBRequest nh_req(DBRequest::DB_ENTRY_ADD_CHANGE);
+    nh_req.key.reset(new CompositeNHKey(Composite::ECMP, false, comp_nh_list,
+                                        vrf_name));
+    nh_req.data.reset(new CompositeNHData());
+    return new ControllerEcmpRoute(agent_, vrf_name, vn_list,
+                                   route.get_tag_list(), route.get_sg_list(),
+                                   path_preference, bmap, nh_req);
+}
+
+void ControllerRouteBackup::AddRoutes(const std::string &vrf_name,
+                              const ControllerVrfRouteResource &vrf_data) {
+    const std::map<std::string, ControllerRouteResource> &route_map =
+        vrf_data.get_route_map();
+    std::map<std::string, ControllerRouteResource>::const_iterator it;
+    for (it = route_map.begin(); it != route_map.end(); it++) {
+        const ControllerRouteResource &route = it->second;
+        IpAddress addr;
+        uint8_t plen;
+        if (!PrefixFromString(route.get_prefix(), &addr, &plen))
+            continue;
+
+        boost::system::error_code ec;
+        MacAddress mac;
+        if (route.get_evpn()) {
+            mac = MacAddress(route.get_mac(), &ec);
+            if (ec.value() != 0)
+                continue;
+        }
+
+        AgentRouteData *data = BuildRouteData(vrf_name, route);
+        if (data == NULL)
+            continue;
+
+        if (route.get_evpn()) {
+            EvpnAgentRouteTable::AddRemoteVmRouteReq(agent_->restore_peer(),
+                                                     vrf_name, mac, addr,
+                                                     plen,
+                                                     route.get_ethernet_tag(),
+                                                     data);
+        } else {
+            InetUnicastAgentRouteTable::AddRemoteVmRouteReq(
+                agent_->restore_peer(), vrf_name, addr, plen, data);
+        }
+        restored_route_count_++;
+    }
+}
+
+void ControllerRouteBackup::DeleteRoutes(const std::string &vrf_name,
+                              const ControllerVrfRouteResource &vrf_data) {
+    const std::map<std::string, ControllerRouteResource> &route_map =
+        vrf_data.get_route_map();
+    std::map<std::string, ControllerRouteResource>::const_iterator it;
+    for (it = route_map.begin(); it != route_map.end(); it++) {
+        const ControllerRouteResource &route = it->second;
+        IpAddress addr;
+        uint8_t plen;
+        if (!PrefixFromString(route.get_prefix(), &addr, &plen))
+            continue;
+        if (route.get_evpn()) {
+            boost::system::error_code ec;
+            MacAddress mac(route.get_mac(), &ec);
+            if (ec.value() != 0)
+                continue;
+            EvpnAgentRouteTable::DeleteReq(agent_->restore_peer(), vrf_name,
+                                           mac, addr, plen,
+                                           route.get_ethernet_tag(), NULL);
+        } else {
+            InetUnicastAgentRouteTable::DeleteReq(agent_->restore_peer(),
+                                                  vrf_name, addr, plen, NULL);
+        }
+    }
+}
+
+// The control-node has sent all its routes. Delete the restored paths,
+// the vrfs and virtual networks config did not send, and remove the routes
+// the control-node did not send again from the backup.
+void ControllerRouteBackup::Audit() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (vrf_listener_id_ != DBTableBase::kInvalidId) {
+        agent_->vrf_table()->Unregister(vrf_listener_id_);
+        vrf_listener_id_ = DBTableBase::kInvalidId;
+    }
+
+    for (VrfRouteMapIter it = restored_map_.begin();
+         it != restored_map_.end(); it++) {
+        DeleteRoutes(it->first, it->second);
+    }
+    restored_map_.clear();
+    pending_map_.clear();
+
+    // The vrf stays if config has created it as well
+    for (std::set<std::string>::iterator it = restored_vrf_set_.begin();
+         it != restored_vrf_set_.end(); it++) {
+        agent_->vrf_table()->DeleteVrfReq(*it, VrfData::RestoreVrf);
+    }
+    restored_vrf_set_.clear();
+
+    for (std::set<boost::uuids::uuid>::iterator it = restored_vn_set_.begin();
+         it != restored_vn_set_.end(); it++) {
+        VnEntry *vn = agent_->vn_table()->Find(*it);
+        if (vn && vn->ifmap_node() == NULL)
+            agent_->vn_table()->DelVn(*it);
+    }
+    restored_vn_set_.clear();
+
+    ResourceManager *rm = backup_manager_->resource_manager();
+    ResourceManager::KeyPtr key(new ControllerRouteResourceKey(rm, "", "", 0));
+    ResourceManager::DataPtr data;
+    backup_manager_->BackupResource(key, data, ResourceBackupReq::AUDIT);
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_controller_route_backup_hpp
+#define vnsw_agent_controller_route_backup_hpp
+
+#include <tbb/mutex.h>
+#include <cmn/agent.h>
+#include <db/db_table.h>
+#include <oper/nexthop.h>
+#include <resource_manager/resource_table.h>
+#include <resource_manager/resource_manager_types.h>
+
+class ResourceManager;
+class ResourceBackupManager;
+
+// Key to backup a route learnt from the control-node. The key is not kept
+// in any resource table, it only carries the change to the backup work
+// queue.
+class ControllerRouteResourceKey : public ResourceKey {
+public:
+    ControllerRouteResourceKey(ResourceManager *rm,
+                               const std::string &vrf_name,
+                               const std::string &route_key,
+                               uint8_t xs_idx);
+    virtual ~ControllerRouteResourceKey();
+
+    virtual const std::string ToString() {
+        return vrf_name_ + "/" + route_key_;
+    }
+    virtual bool IsLess(const ResourceKey &rhs) const;
+    virtual void Backup(ResourceData *data, uint16_t op);
+
+private:
+    std::string vrf_name_;
+    // Prefix, or ethernet tag, mac and prefix for evpn routes
+    std::string route_key_;
+    // Controller adding or retracting the route
+    uint8_t xs_idx_;
+    DISALLOW_COPY_AND_ASSIGN(ControllerRouteResourceKey);
+};
+
+class ControllerRouteResourceData : public ResourceData {
+public:
+    ControllerRouteResourceData(ResourceManager *rm,
+                                const ControllerVrfConfigResource &config,
+                                const ControllerRouteResource &route);
+    virtual ~ControllerRouteResourceData();
+
+    virtual const std::string ToString() {return route_.get_prefix();}
+    const ControllerVrfConfigResource &config() const {return config_;}
+    const ControllerRouteResource &route() const {return route_;}
+
+private:
+    // Config of the vrf when the route was learnt
+    ControllerVrfConfigResource config_;
+    ControllerRouteResource route_;
+    DISALLOW_COPY_AND_ASSIGN(ControllerRouteResourceData);
+};
+
+// Warm restart of the routes learnt from the control-node.
+//
+// Remote VM routes received from the control-node, inet and evpn with one
+// or more tunnel nexthops, are kept in the controller route backup table
+// along with the config of their vrf and virtual network. On restart the
+// routes are added with the restore peer before the controller is
+// connected. A vrf not created from config yet is created from the backup,
+// with its virtual network, so the routes do not wait for the config
+// download. The restore peer sorts after the bgp peers, so a route sent
+// again by the control-node takes over as soon as it arrives. On end of
+// rib the restored paths are deleted, the vrfs and virtual networks config
+// did not send are deleted and the routes not sent again are removed from
+// the backup.
+class ControllerRouteBackup {
+public:
+    typedef std::map<std::string, ControllerVrfRouteResource> VrfRouteMap;
+    typedef VrfRouteMap::iterator VrfRouteMapIter;
+    typedef std::vector<ControllerNextHopResource> NextHopList;
+
+    ControllerRouteBackup(ResourceBackupManager *manager);
+    virtual ~ControllerRouteBackup();
+
+    // Called by the controller as routes are added and retracted. A route
+    // stays in the backup till every controller advertising it retracts it.
+    static void AddRoute(Agent *agent, uint8_t xs_idx,
+                         const std::string &vrf_name,
+                         const IpAddress &addr, uint8_t plen,
+                         const NextHopList &nh_list,
+                         const VnListType &vn_list,
+                         const SecurityGroupList &sg_list,
+                         const TagList &tag_list, uint32_t preference);
+    static void DeleteRoute(Agent *agent, uint8_t xs_idx,
+                            const std::string &vrf_name,
+                            const IpAddress &addr, uint8_t plen);
+    static void AddEvpnRoute(Agent *agent, uint8_t xs_idx,
+                             const std::string &vrf_name,
+                             const MacAddress &mac, const IpAddress &addr,
+                             uint8_t plen, uint32_t ethernet_tag,
+                             const NextHopList &nh_list,
+                             const VnListType &vn_list,
+                             const SecurityGroupList &sg_list,
+                             const TagList &tag_list, uint32_t preference);
+    static void DeleteEvpnRoute(Agent *agent, uint8_t xs_idx,
+                                const std::string &vrf_name,
+                                const MacAddress &mac, const IpAddress &addr,
+                                uint8_t plen, uint32_t ethernet_tag);
+
+    // Routes read from the backup, added once the vrf is created.
+    void Restore(const VrfRouteMap &vrf_route_map);
+    // Create the missing vrfs and add the routes. Called once the DB tables
+    // are created, before connecting to the controller.
+    void Start();
+    // End of rib, delete the restored paths and config.
+    void Audit();
+
+    uint32_t restored_route_count() const {return restored_route_count_;}
+
+private:
+    static void Backup(Agent *agent, uint8_t xs_idx,
+                       const std::string &vrf_name,
+                       const std::string &route_key,
+                       ControllerRouteResource *route);
+    static void Withdraw(Agent *agent, uint8_t xs_idx,
+                         const std::string &vrf_name,
+                         const std::string &route_key);
+    void VrfNotify(DBTablePartBase *partition, DBEntryBase *e);
+    void CreateVrf(const std::string &vrf_name,
+                   const ControllerVrfConfigResource &config);
+    AgentRouteData *BuildRouteData(const std::string &vrf_name,
+                                   const ControllerRouteResource &route);
+    void AddRoutes(const std::string &vrf_name,
+                   const ControllerVrfRouteResource &vrf_data);
+    void DeleteRoutes(const std::string &vrf_name,
+                      const ControllerVrfRouteResource &vrf_data);
+
+    ResourceBackupManager *backup_manager_;
+    Agent *agent_;
+    // Vrfs not created yet
+    VrfRouteMap pending_map_;
+    // Vrfs with routes added from the backup
+    VrfRouteMap restored_map_;
+    // Vrfs and virtual networks created from the backup
+    std::set<std::string> restored_vrf_set_;
+    std::set<boost::uuids::uuid> restored_vn_set_;
+    DBTableBase::ListenerId vrf_listener_id_;
+    uint32_t restored_route_count_;
+    tbb::mutex mutex_;
+    DISALLOW_COPY_AND_ASSIGN(ControllerRouteBackup);
+};
+
+#endif
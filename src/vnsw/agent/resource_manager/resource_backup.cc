@@ -11,10 +11,12 @@
 #include "resource_manager/sandesh_map.h"
 #include "resource_manager/resource_manager.h"
 #include "resource_manager/resource_manager_types.h"
+#include "resource_manager/controller_route_backup.h"
 #include <sys/stat.h>
 
 ResourceBackupManager::ResourceBackupManager(ResourceManager *mgr) :
     resource_manager_(mgr), agent_(mgr->agent()), sandesh_maps_(this),
+    route_backup_(new ControllerRouteBackup(this)),
     backup_work_queue_(agent_->task_scheduler()->
             GetTaskId(kAgentResourceBackUpTask), 0,
             boost::bind(&ResourceBackupManager::WorkQueueBackUpProcess,
@@ -87,6 +89,7 @@ ResourceSandeshMaps& ResourceBackupManager::sandesh_maps() {
 }
 
 void ResourceBackupManager::AuditDone() {
+    route_backup_->Audit();
     agent_->event_notifier()->DeregisterSubscriber(audit_handle_);
     audit_handle_.reset();
 }
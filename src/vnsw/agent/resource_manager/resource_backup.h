@@ -14,12 +14,15 @@ class ResourceSandeshMaps;
 class ResourceManager;
 class ResourceTable;
 class ResourceData;
+class ControllerRouteBackup;
 
 class ResourceBackupReq {
 public:
     enum Op {
         ADD = 1,
         DEL,
+        // Remove the backup entries not refreshed since the restore
+        AUDIT,
     };
 
     ResourceBackupReq(ResourceManager::KeyPtr key,
@@ -47,6 +50,7 @@ public:
 
     void Init();
     ResourceSandeshMaps& sandesh_maps();
+    ControllerRouteBackup *route_backup() {return route_backup_.get();}
     static uint32_t ReadResourceDataFromFile(const std::string &file_name,
                                              std::auto_ptr<uint8_t> *buf);
 
@@ -62,6 +66,7 @@ private:
     ResourceManager *resource_manager_;
     Agent *agent_;
     ResourceSandeshMaps sandesh_maps_;
+    boost::scoped_ptr<ControllerRouteBackup> route_backup_;
     // Work queue to backup the data.
     WorkQueue<ResourceBackupReqPtr> backup_work_queue_;
     EventNotifyHandle::Ptr audit_handle_;
@@ -12,6 +12,7 @@
 #include <resource_manager/resource_backup.h>
 #include <resource_manager/resource_cmn.h>
 #include <resource_manager/index_resource.h>
+#include <resource_manager/controller_route_backup.h>
 
 ResourceManager::ResourceManager(Agent *agent) :
     agent_(agent),
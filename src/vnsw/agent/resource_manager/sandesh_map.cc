@@ -24,13 +24,15 @@
 #include "resource_manager/qos_index.h"
 #include "resource_manager/bgp_as_service_index.h"
 #include "resource_manager/mirror_index.h"
+#include "resource_manager/controller_route_backup.h"
 #include <oper/nexthop.h>
 
 BackUpResourceTable::BackUpResourceTable(ResourceBackupManager *manager,
                                          const std::string &name,
                                          const std::string &file_name) :
     backup_manager_(manager), agent_(manager->agent()), name_(name),
-    last_modified_time_(UTCTimestampUsec()) {
+    last_modified_time_(UTCTimestampUsec()), fall_back_count_(0),
+    write_count_(0) {
 
     if (!agent_->isMockMode()) {
         backup_dir_ = agent_->params()->restart_backup_dir();
@@ -64,6 +66,7 @@ bool BackUpResourceTable::TimerExpiry() {
         if (WriteToFile()) {
             last_modified_time_ = UTCTimestampUsec();
             fall_back_count_ = 0;
+            write_count_++;
             return false;
         }
     }
@@ -87,6 +90,10 @@ void BackUpResourceTable::TriggerBackup() {
     last_modified_time_ = UTCTimestampUsec();
 }
 
+bool BackUpResourceTable::write_pending() {
+    return timer_->running();
+}
+
 bool BackUpResourceTable::UpdateRequired() {
     uint64_t current_time_stamp = UTCTimestampUsec();
     // dont update the file if the frequent updates are seen with in 10sec.
@@ -629,13 +636,117 @@ void MirrorBackUpResourceTable::RestoreResource() {
     }
 }
 
+// Controller route backup.
+ControllerRouteBackUpResourceTable::ControllerRouteBackUpResourceTable
+(ResourceBackupManager *manager) :
+    BackUpResourceTable(manager, "ControllerRouteBackUpResourceTable",
+                        "contrail_controller_route_resource"),
+    restore_time_(0) {
+}
+
+ControllerRouteBackUpResourceTable::~ControllerRouteBackUpResourceTable() {
+}
+
+bool ControllerRouteBackUpResourceTable::WriteToFile() {
+    ControllerRouteResourceMapSandesh sandesh_data;
+    sandesh_data.set_version(kVersion);
+    return WriteMapToFile<ControllerRouteResourceMapSandesh, Map>
+        (&sandesh_data, map_);
+}
+
+// A snapshot written with another version is dropped, the routes are
+// learnt from the control-node as on a cold start.
+void ControllerRouteBackUpResourceTable::ReadFromFile() {
+    ControllerRouteResourceMapSandesh sandesh_data;
+    ReadMapFromFile<ControllerRouteResourceMapSandesh>
+        (&sandesh_data, backup_dir());
+    restore_time_ = UTCTimestampUsec();
+    if (sandesh_data.get_version() != kVersion) {
+        LOG(DEBUG, "Controller route backup version mismatch "
+            << sandesh_data.get_version());
+        map_.clear();
+        return;
+    }
+    map_ = sandesh_data.get_index_map();
+}
+
+void ControllerRouteBackUpResourceTable::RestoreResource() {
+    if (agent()->params()->restart_restore_enable() == false) {
+        map_.clear();
+        return;
+    }
+    backup_manager()->route_backup()->Restore(map_);
+}
+
+// The route keeps the controllers advertising it. Controllers recorded
+// before the restore are not carried over, they have to advertise again.
+void ControllerRouteBackUpResourceTable::AddRoute
+(const std::string &vrf_name, const std::string &key,
+ const ControllerVrfConfigResource &config,
+ const ControllerRouteResource &data) {
+    ControllerVrfRouteResource &vrf_data = map_[vrf_name];
+    ControllerRouteResource &route = vrf_data.route_map[key];
+    uint32_t bmap = data.get_controller_bmap();
+    if (route.get_time_stamp() >= restore_time_)
+        bmap |= route.get_controller_bmap();
+    route = data;
+    route.set_controller_bmap(bmap);
+    if (config.get_vn_uuid().empty() == false)
+        vrf_data.set_config(config);
+    vrf_data.set_time_stamp(data.get_time_stamp());
+}
+
+// The route is removed only when the last controller advertising it
+// retracts it.
+void ControllerRouteBackUpResourceTable::DeleteRoute
+(const std::string &vrf_name, const std::string &key, uint8_t xs_idx) {
+    MapIter it = map_.find(vrf_name);
+    if (it == map_.end())
+        return;
+    std::map<std::string, ControllerRouteResource>::iterator rt_it =
+        it->second.route_map.find(key);
+    if (rt_it == it->second.route_map.end())
+        return;
+    uint32_t bmap = rt_it->second.get_controller_bmap() & ~(1 << xs_idx);
+    rt_it->second.set_controller_bmap(bmap);
+    if (bmap != 0)
+        return;
+    it->second.route_map.erase(rt_it);
+    if (it->second.route_map.empty())
+        map_.erase(it);
+}
+
+// Remove the restored routes which the control-node did not send again
+// till end of rib.
+void ControllerRouteBackUpResourceTable::FlushStale() {
+    MapIter it = map_.begin();
+    while (it != map_.end()) {
+        std::map<std::string, ControllerRouteResource> &route_map =
+            it->second.route_map;
+        std::map<std::string, ControllerRouteResource>::iterator rt_it =
+            route_map.begin();
+        while (rt_it != route_map.end()) {
+            if (rt_it->second.get_time_stamp() < restore_time_) {
+                route_map.erase(rt_it++);
+            } else {
+                rt_it++;
+            }
+        }
+        if (route_map.empty()) {
+            map_.erase(it++);
+        } else {
+            it++;
+        }
+    }
+}
+
 ResourceSandeshMaps::ResourceSandeshMaps(ResourceBackupManager *manager) :
     backup_manager_(manager), agent_(manager->agent()),
     interface_mpls_index_table_(manager), vrf_mpls_index_table_(manager),
     vlan_mpls_index_table_(manager), route_mpls_index_table_(manager),
     vm_interface_index_table_(manager), vrf_index_table_ (manager),
     qos_index_table_ (manager), bgp_as_service_index_table_(manager),
-    mirror_index_table_(manager) {
+    mirror_index_table_(manager), controller_route_table_(manager) {
 }
 
 ResourceSandeshMaps::~ResourceSandeshMaps() {
@@ -651,6 +762,7 @@ void ResourceSandeshMaps::ReadFromFile() {
     qos_index_table_.ReadFromFile();
     bgp_as_service_index_table_.ReadFromFile();
     mirror_index_table_.ReadFromFile();
+    controller_route_table_.ReadFromFile();
 }
 
 void ResourceSandeshMaps::EndOfBackup() {
@@ -670,6 +782,7 @@ void ResourceSandeshMaps::RestoreResource() {
     qos_index_table_.RestoreResource();
     bgp_as_service_index_table_.RestoreResource();
     mirror_index_table_.RestoreResource();
+    controller_route_table_.RestoreResource();
     EndOfBackup();
 }
 
@@ -708,6 +821,10 @@ void MirrorIndexResourceMapSandesh::Process(SandeshContext*) {
 
 }
 
+void ControllerRouteResourceMapSandesh::Process(SandeshContext*) {
+
+}
+
 void ResourceSandeshMaps::AddInterfaceMplsResourceEntry(uint32_t index,
                                        InterfaceIndexResource data ) {
     interface_mpls_index_table_.map().insert(InterfaceMplsResourcePair(index,
@@ -43,6 +43,9 @@ public:
                                  uint32_t *hashsum);
     const std::string& file_name_str() {return file_name_str_;}
     const std::string& file_name_prefix() {return file_name_prefix_;}
+    // Writes done, changes seen within the idle time out share a write
+    uint32_t write_count() const {return write_count_;}
+    bool write_pending();
 protected:
     template <typename T1, typename T2>
     bool WriteMapToFile(T1* sandesh_data, const T2& index_map);
@@ -58,6 +61,7 @@ private:
     uint32_t backup_idle_timeout_;
     uint64_t last_modified_time_;
     uint8_t fall_back_count_;
+    uint32_t write_count_;
     std::string file_name_str_;
     std::string file_name_prefix_;
     DISALLOW_COPY_AND_ASSIGN(BackUpResourceTable);
@@ -209,6 +213,33 @@ private:
     Map map_;
 };
 
+// Controller route backup table maintains sandesh encoded data for the
+// routes learnt from the control-node, keyed by vrf name and prefix.
+// The snapshot is versioned, a file with another version is not restored.
+class ControllerRouteBackUpResourceTable : public BackUpResourceTable {
+public:
+    static const uint32_t kVersion = 2;
+    typedef std::map<std::string, ControllerVrfRouteResource> Map;
+    typedef Map::iterator MapIter;
+    ControllerRouteBackUpResourceTable(ResourceBackupManager *manager);
+    virtual ~ControllerRouteBackUpResourceTable();
+
+    bool WriteToFile();
+    void ReadFromFile();
+    void RestoreResource();
+    void AddRoute(const std::string &vrf_name, const std::string &key,
+                  const ControllerVrfConfigResource &config,
+                  const ControllerRouteResource &data);
+    void DeleteRoute(const std::string &vrf_name, const std::string &key,
+                     uint8_t xs_idx);
+    void FlushStale();
+    Map& map() {return map_;}
+private:
+    Map map_;
+    // Routes not refreshed since the restore are stale
+    uint64_t restore_time_;
+};
+
 // Maintians all the Sandesh encoded structures
 class ResourceSandeshMaps {
 public:
@@ -298,6 +329,10 @@ public:
         return mirror_index_table_;
     }
 
+    ControllerRouteBackUpResourceTable& controller_route_table() {
+        return controller_route_table_;
+    }
+
 private:
     ResourceBackupManager *backup_manager_;
     Agent *agent_;
@@ -310,6 +345,7 @@ private:
     QosBackUpResourceTable qos_index_table_;
     BgpAsServiceBackUpResourceTable bgp_as_service_index_table_;
     MirrorBackUpResourceTable mirror_index_table_;
+    ControllerRouteBackUpResourceTable controller_route_table_;
     DISALLOW_COPY_AND_ASSIGN(ResourceSandeshMaps);
 };
 #endif
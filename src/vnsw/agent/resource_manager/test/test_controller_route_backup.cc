@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+//
+// Controller route backup and warm restart test
+//
+
+#include "base/os.h"
+#include <cmn/agent_cmn.h>
+#include "testing/gunit.h"
+#include <cmn/agent.h>
+#include "base/logging.h"
+#include <test/test_cmn_util.h>
+#include <oper/vrf.h>
+#include <resource_manager/resource_manager.h>
+#include "resource_manager/resource_backup.h"
+#include "resource_manager/sandesh_map.h"
+#include "resource_manager/controller_route_backup.h"
+
+class ControllerRouteBackupTest : public ::testing::Test {
+protected:
+    ControllerRouteBackupTest() {
+    }
+    virtual void SetUp() {
+        agent = Agent::GetInstance();
+        backup_mgr = agent->resource_manager()->backup_mgr();
+        prefix = Ip4Address::from_string("1.1.1.10");
+        ecmp_prefix = Ip4Address::from_string("1.1.1.20");
+        tunnel_dest = Ip4Address::from_string("10.1.1.100");
+        mac = MacAddress::FromString("00:00:00:01:01:01");
+    }
+    virtual void TearDown() {
+    }
+
+    ControllerRouteBackUpResourceTable &table() {
+        return backup_mgr->sandesh_maps().controller_route_table();
+    }
+
+    ControllerRouteBackup::NextHopList NextHopList(int count) {
+        ControllerRouteBackup::NextHopList nh_list;
+        for (int i = 0; i < count; i++) {
+            ControllerNextHopResource nh;
+            nh.set_tunnel_dest(
+                Ip4Address(tunnel_dest.to_ulong() + i).to_string());
+            nh.set_label(1000 + i);
+            nh.set_tunnel_bmap(TunnelType::MplsType());
+            nh_list.push_back(nh);
+        }
+        return nh_list;
+    }
+
+    void AddRoute(const std::string &vrf_name, const Ip4Address &addr,
+                  int nh_count, uint8_t xs_idx) {
+        VnListType vn_list;
+        vn_list.insert("vn1");
+        ControllerRouteBackup::AddRoute(agent, xs_idx, vrf_name, addr, 32,
+                                        NextHopList(nh_count), vn_list,
+                                        SecurityGroupList(), TagList(), 100);
+    }
+
+    void AddRoute(const std::string &vrf_name, uint8_t xs_idx = 0) {
+        AddRoute(vrf_name, prefix, 1, xs_idx);
+        client->WaitForIdle();
+    }
+
+    void DeleteRoute(const std::string &vrf_name, uint8_t xs_idx = 0) {
+        ControllerRouteBackup::DeleteRoute(agent, xs_idx, vrf_name, prefix,
+                                           32);
+        client->WaitForIdle();
+    }
+
+    void AddEvpnRoute(const std::string &vrf_name) {
+        VnListType vn_list;
+        vn_list.insert("vn1");
+        ControllerRouteBackup::AddEvpnRoute(agent, 0, vrf_name, mac, prefix,
+                                            32, 0, NextHopList(1), vn_list,
+                                            SecurityGroupList(), TagList(),
+                                            100);
+        client->WaitForIdle();
+    }
+
+    // Read the backup as on restart
+    void ReadBackup() {
+        table().map().clear();
+        table().ReadFromFile();
+        backup_mgr->route_backup()->Restore(table().map());
+        backup_mgr->route_backup()->Start();
+        client->WaitForIdle();
+    }
+
+    Agent *agent;
+    ResourceBackupManager *backup_mgr;
+    Ip4Address prefix;
+    Ip4Address ecmp_prefix;
+    Ip4Address tunnel_dest;
+    MacAddress mac;
+};
+
+// Routes are added to and deleted from the backup as the control-node
+// sends and retracts them.
+TEST_F(ControllerRouteBackupTest, AddDelete) {
+    AddRoute("vrf1");
+    EXPECT_EQ(1U, table().map().size());
+    EXPECT_EQ(1U, table().map()["vrf1"].get_route_map().size());
+
+    DeleteRoute("vrf1");
+    EXPECT_TRUE(table().map().empty());
+}
+
+// A route advertised by both controllers stays in the backup till the
+// last one retracts it.
+TEST_F(ControllerRouteBackupTest, MultipleControllers) {
+    AddRoute("vrf1", 0);
+    AddRoute("vrf1", 1);
+    EXPECT_EQ(1U, table().map()["vrf1"].get_route_map().size());
+
+    DeleteRoute("vrf1", 0);
+    EXPECT_EQ(1U, table().map().size());
+    EXPECT_EQ(1U, table().map()["vrf1"].get_route_map().size());
+
+    // Retract from a controller that already withdrew the route
+    DeleteRoute("vrf1", 0);
+    EXPECT_EQ(1U, table().map().size());
+
+    DeleteRoute("vrf1", 1);
+    EXPECT_TRUE(table().map().empty());
+}
+
+// Routes read from the backup are added with the restore peer and deleted
+// on end of rib. A vrf created by config as well stays after end of rib.
+TEST_F(ControllerRouteBackupTest, Restore) {
+    uint32_t write_count = table().write_count();
+    AddRoute("vrf1");
+    WAIT_FOR(2000, 10000, table().write_count() > write_count);
+
+    ReadBackup();
+    EXPECT_EQ(1U, table().map().size());
+    uint32_t restored_count =
+        backup_mgr->route_backup()->restored_route_count();
+
+    VrfAddReq("vrf1");
+    client->WaitForIdle();
+    EXPECT_TRUE(VrfFind("vrf1"));
+    EXPECT_EQ(restored_count + 1,
+              backup_mgr->route_backup()->restored_route_count());
+    InetUnicastRouteEntry *rt = RouteGet("vrf1", prefix, 32);
+    EXPECT_TRUE(rt != NULL);
+    if (rt) {
+        const AgentPath *path = rt->FindPath(agent->restore_peer());
+        EXPECT_TRUE(path != NULL);
+        EXPECT_EQ(1000U, rt->GetActiveLabel());
+    }
+
+    // End of rib, the route was not sent again by the control-node
+    backup_mgr->route_backup()->Audit();
+    client->WaitForIdle();
+    EXPECT_TRUE(RouteGet("vrf1", prefix, 32) == NULL);
+    EXPECT_TRUE(table().map().empty());
+    EXPECT_TRUE(VrfFind("vrf1"));
+
+    VrfDelReq("vrf1");
+    client->WaitForIdle();
+    EXPECT_FALSE(VrfFind("vrf1"));
+}
+
+// Route changes are written to the file once the backup is idle, not once
+// per change.
+TEST_F(ControllerRouteBackupTest, BatchedWrite) {
+    WAIT_FOR(2000, 10000, table().write_pending() == false);
+    uint32_t write_count = table().write_count();
+    for (int i = 0; i < 64; i++) {
+        AddRoute("vrf1", Ip4Address(prefix.to_ulong() + i), 1, 0);
+    }
+    client->WaitForIdle();
+    EXPECT_EQ(64U, table().map()["vrf1"].get_route_map().size());
+
+    WAIT_FOR(2000, 10000, table().write_pending() == false);
+    EXPECT_EQ(write_count + 1, table().write_count());
+
+    for (int i = 0; i < 64; i++) {
+        ControllerRouteBackup::DeleteRoute(agent, 0, "vrf1",
+                                           Ip4Address(prefix.to_ulong() + i),
+                                           32);
+    }
+    client->WaitForIdle();
+    EXPECT_TRUE(table().map().empty());
+}
+
+// With no controller connected and no config, the vrf and its virtual
+// network are created from the backup and the inet, ECMP and evpn routes
+// are programmed.
+TEST_F(ControllerRouteBackupTest, RestoreWithoutController) {
+    AddVn("vn2", 2, 2);
+    AddVrf("vrf2");
+    AddLink("virtual-network", "vn2", "routing-instance", "vrf2");
+    client->WaitForIdle();
+    VrfEntry *vrf = VrfGet("vrf2");
+    ASSERT_TRUE(vrf != NULL);
+    EXPECT_TRUE(vrf->vn() != NULL);
+
+    uint32_t write_count = table().write_count();
+    AddRoute("vrf2", prefix, 1, 0);
+    AddRoute("vrf2", ecmp_prefix, 2, 0);
+    AddEvpnRoute("vrf2");
+    WAIT_FOR(2000, 10000, table().write_count() > write_count);
+    EXPECT_EQ(3U, table().map()["vrf2"].get_route_map().size());
+    EXPECT_EQ(UuidToString(MakeUuid(2)),
+              table().map()["vrf2"].get_config().get_vn_uuid());
+
+    // Config is gone, as on a restart before the config download
+    DelLink("virtual-network", "vn2", "routing-instance", "vrf2");
+    DelVrf("vrf2");
+    DelVn("vn2");
+    client->WaitForIdle();
+    WAIT_FOR(100, 1000, VrfFind("vrf2", true) == false);
+    EXPECT_FALSE(VnFind(2));
+
+    uint32_t restored_count =
+        backup_mgr->route_backup()->restored_route_count();
+    ReadBackup();
+    WAIT_FOR(100, 1000, VrfFind("vrf2") == true);
+    client->WaitForIdle();
+    EXPECT_TRUE(VnFind(2));
+    EXPECT_EQ(restored_count + 3,
+              backup_mgr->route_backup()->restored_route_count());
+
+    InetUnicastRouteEntry *rt = RouteGet("vrf2", prefix, 32);
+    ASSERT_TRUE(rt != NULL);
+    EXPECT_TRUE(rt->FindPath(agent->restore_peer()) != NULL);
+    EXPECT_EQ(NextHop::TUNNEL, rt->GetActiveNextHop()->GetType());
+
+    rt = RouteGet("vrf2", ecmp_prefix, 32);
+    ASSERT_TRUE(rt != NULL);
+    const NextHop *nh = rt->GetActiveNextHop();
+    ASSERT_EQ(NextHop::COMPOSITE, nh->GetType());
+    EXPECT_EQ(2U, static_cast<const CompositeNH *>(nh)->ComponentNHCount());
+
+    EvpnRouteEntry *evpn_rt = EvpnRouteGet("vrf2", mac, prefix, 0);
+    ASSERT_TRUE(evpn_rt != NULL);
+    EXPECT_TRUE(evpn_rt->FindPath(agent->restore_peer()) != NULL);
+
+    // End of rib, neither config nor the routes were sent again
+    backup_mgr->route_backup()->Audit();
+    client->WaitForIdle();
+    EXPECT_TRUE(RouteGet("vrf2", prefix, 32) == NULL);
+    EXPECT_TRUE(RouteGet("vrf2", ecmp_prefix, 32) == NULL);
+    EXPECT_TRUE(EvpnRouteGet("vrf2", mac, prefix, 0) == NULL);
+    WAIT_FOR(100, 1000, VrfFind("vrf2", true) == false);
+    EXPECT_FALSE(VnFind(2));
+    EXPECT_TRUE(table().map().empty());
+}
+
+int main(int argc, char **argv) {
+    GETUSERARGS();
+    client = TestInit(init_file, ksync_init, true, true, true,
+                      30000, 1000, true, true, 30000, true);
+    usleep(100000);
+    bool success = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    system("rm -rf /tmp/backup");
+    TestShutdown();
+    delete client;
+    return success;
+}
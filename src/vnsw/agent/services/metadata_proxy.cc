@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <boost/algorithm/string.hpp>
 #include <boost/bind.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/foreach.hpp>
@@ -12,6 +13,7 @@
 #include <isc/hmacsha.h>
 
 #include "base/contrail_ports.h"
+#include "base/time_util.h"
 #include "http/http_request.h"
 #include "http/http_session.h"
 #include "http/http_server.h"
@@ -80,11 +82,17 @@ GetHmacSha256(const std::string &key, const std::string &data) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+const uint32_t MetadataProxy::kMaxIdleConnections;
+const uint32_t MetadataProxy::kMaxCacheEntriesPerInstance;
+const uint32_t MetadataProxy::kMaxCacheResponseSize;
+
 MetadataProxy::MetadataProxy(ServicesModule *module,
                              const std::string &secret)
     : services_(module), shared_secret_(secret),
       http_server_(new MetadataServer(services_->agent()->event_manager())),
-      http_client_(new MetadataClient(services_->agent()->event_manager())) {
+      http_client_(new MetadataClient(services_->agent()->event_manager())),
+      cache_ttl_(services_->agent()->params()->metadata_cache_ttl()),
+      next_cache_sweep_(0) {
 
     // Register wildcard entry to match any URL coming on the metadata port
     http_server_->RegisterHandler(HTTP_WILDCARD_ENTRY,
@@ -102,11 +110,14 @@ MetadataProxy::~MetadataProxy() {
 void MetadataProxy::CloseSessions() {
     for (SessionMap::iterator it = metadata_sessions_.begin();
          it != metadata_sessions_.end(); ) {
-        SessionMap::iterator next = ++it;
+        SessionMap::iterator next = it;
+        ++next;
         CloseClientSession(it->second.conn);
         CloseServerSession(it->first);
         it = next;
     }
+    CloseIdleConnections();
+    ClearCache();
 
     assert(metadata_sessions_.empty());
     assert(metadata_proxy_sessions_.empty());
@@ -174,6 +185,21 @@ MetadataProxy::HandleMetadataRequest(HttpSession *session, const HttpRequest *re
     if (uri.size())
         uri = uri.substr(1); // ignore the first "/"
     const std::string &body = request->Body();
+
+    // Requests other than GET and HEAD may change the metadata of the
+    // instance, drop its cached responses
+    bool cache_get = (request->GetMethod() == HTTP_GET && cache_ttl_ != 0);
+    if (request->GetMethod() != HTTP_GET &&
+        request->GetMethod() != HTTP_HEAD) {
+        response_cache_.erase(vm_uuid);
+    }
+    if (cache_get && SendCachedResponse(session, vm_uuid, uri, conn_close)) {
+        METADATA_TRACE(Trace, "GET request for VM : " << vm_ip
+                       << " URL : " << uri << " served from cache");
+        delete request;
+        return;
+    }
+
     {
         std::string nova_hostname;
         HttpConnection *conn = GetProxyConnection(session, conn_close,
@@ -184,6 +210,10 @@ MetadataProxy::HandleMetadataRequest(HttpSession *session, const HttpRequest *re
         }
 
         if (conn) {
+            SessionData &data = metadata_sessions_.find(session)->second;
+            data.ResetResponse(cache_get, ClockMonotonicUsec());
+            data.vm_uuid = vm_uuid;
+            data.uri = uri;
             switch(request->GetMethod()) {
                 case HTTP_GET: {
                     conn->HttpGet(uri, true, false, true, header_options,
@@ -281,28 +311,57 @@ MetadataProxy::HandleMetadataResponse(HttpConnection *conn, HttpSessionPtr sessi
         }
 
         metadata_stats_.responses++;
-        if (!ec && it->second.close_req) {
-            std::stringstream str(msg);
-            std::string option;
-            str >> option;
-            if (option == "Content-Length:") {
-                str >> it->second.content_len;
-            } else if (msg == "\r\n") {
-                it->second.header_end = true;
-                if (it->second.header_end && !it->second.content_len) {
-                    CloseClientSession(it->second.conn);
-                    CloseServerSession(session.get());
-                    delete_session = true;
-                }
-            } else if (it->second.header_end) {
-                it->second.data_sent += msg.length();
-                if (it->second.data_sent >= it->second.content_len) {
-                    CloseClientSession(it->second.conn);
-                    CloseServerSession(session.get());
-                    delete_session = true;
+        SessionData &data = it->second;
+        if (data.response_done)
+            goto done;
+
+        // Track the end of the response, to close the session when the
+        // client asked for it and to cache the response
+        bool complete = false;
+        if (data.cacheable)
+            data.response.push_back(msg);
+        std::stringstream str(msg);
+        std::string option;
+        str >> option;
+        if (data.header_end) {
+            data.data_sent += msg.length();
+            if (data.data_sent >= data.content_len) {
+                data.conn_reusable = true;
+                complete = true;
+            }
+        } else if (data.status == 0 && boost::starts_with(option, "HTTP/")) {
+            str >> data.status;
+        } else if (boost::iequals(option, "Content-Length:")) {
+            str >> data.content_len;
+            data.content_len_known = !str.fail();
+            if (data.content_len > kMaxCacheResponseSize) {
+                data.cacheable = false;
+                data.response.clear();
+            }
+        } else if (msg == "\r\n") {
+            if (data.status == 100) {
+                // Interim response, the final one follows
+                data.status = 0;
+                data.response.clear();
+            } else {
+                data.header_end = true;
+                // Without Content-Length the body, if any, is only
+                // forwarded, conn can not be reused
+                if (!data.content_len) {
+                    data.conn_reusable = data.content_len_known;
+                    complete = true;
                 }
             }
         }
+
+        if (complete) {
+            ResponseDone(&data, ClockMonotonicUsec());
+            if (data.close_req) {
+                ReleaseClientSession(data);
+                CloseServerSession(session.get());
+                delete_session = true;
+            }
+        }
     }
 
 done:
@@ -318,7 +377,7 @@ MetadataProxy::OnServerSessionEvent(HttpSession *session, TcpSession::Event even
             SessionMap::iterator it = metadata_sessions_.find(session);
             if (it == metadata_sessions_.end())
                 break;
-            CloseClientSession(it->second.conn);
+            ReleaseClientSession(it->second);
             metadata_sessions_.erase(it);
             break;
         }
@@ -335,8 +394,19 @@ MetadataProxy::OnClientSessionEvent(HttpClientSession *session, TcpSession::Even
             {
                 ConnectionSessionMap::iterator it =
                     metadata_proxy_sessions_.find(session->Connection());
-                if (it == metadata_proxy_sessions_.end())
+                if (it == metadata_proxy_sessions_.end()) {
+                    // Idle connection closed by the metadata service
+                    for (ConnectionPool::iterator pit =
+                         idle_connections_.begin();
+                         pit != idle_connections_.end(); ++pit) {
+                        if (pit->second == session->Connection()) {
+                            idle_connections_.erase(pit);
+                            CloseClientSession(session->Connection());
+                            break;
+                        }
+                    }
                     break;
+                }
                 CloseServerSession(it->second);
                 CloseClientSession(session->Connection());
             }
@@ -365,34 +435,167 @@ MetadataProxy::GetProxyConnection(HttpSession *session, bool conn_close,
         nova_hostname, &nova_server, &nova_port))
         return NULL;
 
-    HttpConnection *conn = (nova_hostname != 0 && !nova_hostname->empty()) ? 
-       http_client_->CreateConnection(*nova_hostname, nova_port) :
-       http_client_->CreateConnection(boost::asio::ip::tcp::endpoint(nova_server, nova_port));
-
-    map<CURLoption, int> *curl_options = conn->curl_options();
-    curl_options->insert(std::make_pair(CURLOPT_HTTP_TRANSFER_DECODING, 0L));
-    conn->set_use_ssl(services_->agent()->params()->metadata_use_ssl());
-    if (conn->use_ssl()) {
-        conn->set_client_cert(
-              services_->agent()->params()->metadata_client_cert());
-        conn->set_client_cert_type(
-              services_->agent()->params()->metadata_client_cert_type());
-        conn->set_client_key(
-              services_->agent()->params()->metadata_client_key());
-        conn->set_ca_cert(
-              services_->agent()->params()->metadata_ca_cert());
+    bool use_hostname = (nova_hostname != 0 && !nova_hostname->empty());
+    std::stringstream key;
+    key << (use_hostname ? *nova_hostname : nova_server.to_string()) << ":"
+        << nova_port;
+    if (services_->agent()->params()->metadata_use_ssl())
+        key << "/ssl";
+    std::string upstream_key = key.str();
+
+    // Reuse an idle connection to the same metadata service if any
+    HttpConnection *conn = NULL;
+    ConnectionPool::iterator pit = idle_connections_.find(upstream_key);
+    if (pit != idle_connections_.end()) {
+        conn = pit->second;
+        idle_connections_.erase(pit);
+        metadata_stats_.upstream_connections_reused++;
+    } else {
+        conn = use_hostname ?
+            http_client_->CreateConnection(*nova_hostname, nova_port) :
+            http_client_->CreateConnection(
+                boost::asio::ip::tcp::endpoint(nova_server, nova_port));
+
+        map<CURLoption, int> *curl_options = conn->curl_options();
+        curl_options->insert(
+            std::make_pair(CURLOPT_HTTP_TRANSFER_DECODING, 0L));
+        conn->set_use_ssl(services_->agent()->params()->metadata_use_ssl());
+        if (conn->use_ssl()) {
+            conn->set_client_cert(
+                  services_->agent()->params()->metadata_client_cert());
+            conn->set_client_cert_type(
+                  services_->agent()->params()->metadata_client_cert_type());
+            conn->set_client_key(
+                  services_->agent()->params()->metadata_client_key());
+            conn->set_ca_cert(
+                  services_->agent()->params()->metadata_ca_cert());
+        }
+        conn->RegisterEventCb(
+            boost::bind(&MetadataProxy::OnClientSessionEvent, this, _1, _2));
+        metadata_stats_.upstream_connections++;
     }
-    conn->RegisterEventCb(
-             boost::bind(&MetadataProxy::OnClientSessionEvent, this, _1, _2));
     session->RegisterEventCb(
              boost::bind(&MetadataProxy::OnServerSessionEvent, this, _1, _2));
-    SessionData data(conn, conn_close);
+    SessionData data(conn, conn_close, upstream_key);
     metadata_sessions_.insert(SessionPair(session, data));
     metadata_proxy_sessions_.insert(ConnectionSessionPair(conn, session));
     metadata_stats_.proxy_sessions++;
     return conn;
 }
 
+bool MetadataProxy::MetadataServiceConfigured() const {
+    uint16_t nova_port, linklocal_port;
+    Ip4Address nova_server, linklocal_server;
+    std::string nova_hostname;
+    return services_->agent()->oper_db()->global_vrouter()->
+        FindLinkLocalService(GlobalVrouter::kMetadataService,
+                             &linklocal_server, &linklocal_port,
+                             &nova_hostname, &nova_server, &nova_port);
+}
+
+// Answer a GET from the cache. Signed requests still go to the metadata
+// service on a miss, the cache only holds responses it already returned to
+// this instance.
+bool
+MetadataProxy::SendCachedResponse(HttpSession *session,
+                                  const std::string &vm_uuid,
+                                  const std::string &uri, bool conn_close) {
+    // Keep responses in order if the previous one is still being proxied
+    SessionMap::iterator it = metadata_sessions_.find(session);
+    if (it != metadata_sessions_.end() && !it->second.response_done)
+        return false;
+    if (!MetadataServiceConfigured())
+        return false;
+
+    uint64_t now = ClockMonotonicUsec();
+    ResponseCache::iterator cit = response_cache_.find(vm_uuid);
+    if (cit == response_cache_.end()) {
+        metadata_stats_.cache_misses++;
+        return false;
+    }
+    InstanceCache::iterator eit = cit->second.find(uri);
+    if (eit == cit->second.end() || eit->second.expiry <= now) {
+        metadata_stats_.cache_misses++;
+        return false;
+    }
+
+    metadata_stats_.cache_hits++;
+    const std::vector<std::string> &response = eit->second.response;
+    for (std::vector<std::string>::const_iterator rit = response.begin();
+         rit != response.end(); ++rit) {
+        session->Send(reinterpret_cast<const u_int8_t *>(rit->c_str()),
+                      rit->length(), NULL);
+        metadata_stats_.responses++;
+    }
+
+    if (conn_close) {
+        if (it != metadata_sessions_.end()) {
+            ReleaseClientSession(it->second);
+        }
+        CloseServerSession(session);
+        http_server_->DeleteSession(session);
+    }
+    return true;
+}
+
+void MetadataProxy::ResponseDone(SessionData *data, uint64_t now) {
+    data->response_done = true;
+    uint64_t latency = now - data->start_time;
+    metadata_stats_.upstream_responses++;
+    metadata_stats_.latency_usecs += latency;
+    if (latency > metadata_stats_.max_latency_usecs)
+        metadata_stats_.max_latency_usecs = latency;
+
+    if (data->cacheable && data->status == 200 && data->content_len) {
+        AddCacheEntry(*data, now);
+    }
+    data->response.clear();
+}
+
+void MetadataProxy::AddCacheEntry(const SessionData &data, uint64_t now) {
+    if (now >= next_cache_sweep_)
+        SweepCache(now);
+
+    InstanceCache &cache = response_cache_[data.vm_uuid];
+    if (cache.find(data.uri) == cache.end() &&
+        cache.size() >= kMaxCacheEntriesPerInstance)
+        return;
+    CacheEntry &entry = cache[data.uri];
+    entry.response = data.response;
+    entry.expiry = now + cache_ttl_ * 1000000ULL;
+}
+
+// Remove expired responses and instances left without any
+void MetadataProxy::SweepCache(uint64_t now) {
+    for (ResponseCache::iterator cit = response_cache_.begin();
+         cit != response_cache_.end(); ) {
+        InstanceCache &cache = cit->second;
+        for (InstanceCache::iterator eit = cache.begin();
+             eit != cache.end(); ) {
+            if (eit->second.expiry <= now) {
+                cache.erase(eit++);
+            } else {
+                ++eit;
+            }
+        }
+        if (cache.empty()) {
+            response_cache_.erase(cit++);
+        } else {
+            ++cit;
+        }
+    }
+    next_cache_sweep_ = now + cache_ttl_ * 1000000ULL;
+}
+
+uint32_t MetadataProxy::CacheSize() const {
+    uint32_t size = 0;
+    for (ResponseCache::const_iterator it = response_cache_.begin();
+         it != response_cache_.end(); ++it) {
+        size += it->second.size();
+    }
+    return size;
+}
+
 void
 MetadataProxy::CloseServerSession(HttpSession *session) {
     session->Close();
@@ -406,6 +609,26 @@ MetadataProxy::CloseClientSession(HttpConnection *conn) {
     metadata_proxy_sessions_.erase(conn);
 }
 
+void
+MetadataProxy::ReleaseClientSession(const SessionData &data) {
+    if (!data.conn_reusable ||
+        idle_connections_.size() >= kMaxIdleConnections) {
+        CloseClientSession(data.conn);
+        return;
+    }
+    metadata_proxy_sessions_.erase(data.conn);
+    idle_connections_.insert(std::make_pair(data.upstream_key, data.conn));
+}
+
+void MetadataProxy::CloseIdleConnections() {
+    for (ConnectionPool::iterator it = idle_connections_.begin();
+         it != idle_connections_.end(); ++it) {
+        HttpClient *client = it->second->client();
+        client->RemoveConnection(it->second);
+    }
+    idle_connections_.clear();
+}
+
 void
 MetadataProxy::ErrorClose(HttpSession *session, uint16_t error) {
     std::string message = ErrorMessage(error);
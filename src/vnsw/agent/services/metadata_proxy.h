@@ -13,26 +13,84 @@ class MetadataClient;
 
 class MetadataProxy {
 public:
+    // Maximum number of idle upstream connections kept for reuse
+    static const uint32_t kMaxIdleConnections = 16;
+    // Maximum number of cached responses per instance
+    static const uint32_t kMaxCacheEntriesPerInstance = 32;
+    // Responses larger than this are not cached
+    static const uint32_t kMaxCacheResponseSize = 64 * 1024;
+
     struct SessionData {
-        SessionData(HttpConnection *c, bool conn_close)
-            : conn(c), content_len(0), data_sent(0),
-              close_req(conn_close), header_end(false) {}
+        SessionData(HttpConnection *c, bool conn_close,
+                    const std::string &upstream)
+            : conn(c), upstream_key(upstream), content_len(0), data_sent(0),
+              content_len_known(false), close_req(conn_close),
+              header_end(false), response_done(true), conn_reusable(true),
+              cacheable(false), status(0), start_time(0) {}
+
+        // Start tracking the response to a new request on the session
+        void ResetResponse(bool cache_response, uint64_t now) {
+            content_len = data_sent = 0;
+            content_len_known = false;
+            header_end = response_done = conn_reusable = false;
+            cacheable = cache_response;
+            status = 0;
+            start_time = now;
+            response.clear();
+        }
 
         HttpConnection *conn;
+        std::string upstream_key;
         uint32_t content_len;
         uint32_t data_sent;
+        bool content_len_known;
         bool close_req;
         bool header_end;
+        bool response_done;
+        // No response is in progress on conn. Not set when the end of the
+        // response is not known from Content-Length, as the body may
+        // still be coming
+        bool conn_reusable;
+        // Response to a GET, to be added to the cache when complete
+        bool cacheable;
+        uint16_t status;
+        uint64_t start_time;
+        std::string vm_uuid;
+        std::string uri;
+        std::vector<std::string> response;
     };
 
     struct MetadataStats {
         MetadataStats() { Reset(); }
-        void Reset() { requests = responses = proxy_sessions = internal_errors = 0; }
+        void Reset() {
+            requests = responses = proxy_sessions = internal_errors = 0;
+            cache_hits = cache_misses = 0;
+            upstream_connections = upstream_connections_reused = 0;
+            upstream_responses = 0;
+            latency_usecs = max_latency_usecs = 0;
+        }
 
         uint32_t requests;
         uint32_t responses;
         uint32_t proxy_sessions;
         uint32_t internal_errors;
+        uint32_t cache_hits;
+        uint32_t cache_misses;
+        // Connections opened to the metadata service
+        uint32_t upstream_connections;
+        // Sessions served on an idle connection taken from the pool
+        uint32_t upstream_connections_reused;
+        // Complete responses received from the metadata service
+        uint32_t upstream_responses;
+        uint64_t latency_usecs;
+        uint64_t max_latency_usecs;
+    };
+
+    // Cached response, as the chunks received from the metadata service
+    struct CacheEntry {
+        CacheEntry() : expiry(0) {}
+        std::vector<std::string> response;
+        uint64_t expiry;
     };
 
     typedef std::map<HttpSession *, SessionData> SessionMap;
@@ -40,6 +98,12 @@ public:
     typedef std::map<HttpConnection *, HttpSession *> ConnectionSessionMap;
     typedef std::pair<HttpConnection *, HttpSession *> ConnectionSessionPair;
     typedef boost::intrusive_ptr<HttpSession> HttpSessionPtr;
+    // Idle connections, keyed by metadata service address
+    typedef std::multimap<std::string, HttpConnection *> ConnectionPool;
+    // Cached responses of an instance, keyed by url
+    typedef std::map<std::string, CacheEntry> InstanceCache;
+    // Cached responses, keyed by instance uuid
+    typedef std::map<std::string, InstanceCache> ResponseCache;
 
     MetadataProxy(ServicesModule *module, const std::string &secret);
     virtual ~MetadataProxy();
@@ -56,11 +120,27 @@ public:
     const MetadataStats &metadatastats() const { return metadata_stats_; }
     void ClearStats() { metadata_stats_.Reset(); }
 
+    uint32_t cache_ttl() const { return cache_ttl_; }
+    void set_cache_ttl(uint32_t ttl) { cache_ttl_ = ttl; }
+    uint32_t CacheSize() const;
+    void ClearCache() { response_cache_.clear(); }
+    uint32_t IdleConnections() const { return idle_connections_.size(); }
+
 private:
     HttpConnection *GetProxyConnection(HttpSession *session, bool conn_close,
                                        std::string *nova_hostname);
+    bool MetadataServiceConfigured() const;
+    bool SendCachedResponse(HttpSession *session, const std::string &vm_uuid,
+                            const std::string &uri, bool conn_close);
+    void AddCacheEntry(const SessionData &data, uint64_t now);
+    void SweepCache(uint64_t now);
+    void ResponseDone(SessionData *data, uint64_t now);
     void CloseServerSession(HttpSession *session);
     void CloseClientSession(HttpConnection *conn);
+    // Return the connection of a completed session to the idle pool, or
+    // close it if it can not be reused
+    void ReleaseClientSession(const SessionData &data);
+    void CloseIdleConnections();
     void ErrorClose(HttpSession *sesion, uint16_t error);
 
     ServicesModule *services_;
@@ -70,6 +150,11 @@ private:
     SessionMap metadata_sessions_;
     ConnectionSessionMap metadata_proxy_sessions_;
     MetadataStats metadata_stats_;
+    ConnectionPool idle_connections_;
+    ResponseCache response_cache_;
+    // Lifetime of cached GET responses in seconds, 0 disables the cache
+    uint32_t cache_ttl_;
+    uint64_t next_cache_sweep_;
 
     DISALLOW_COPY_AND_ASSIGN(MetadataProxy);
 };
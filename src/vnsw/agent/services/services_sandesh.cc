@@ -936,12 +936,27 @@ void ServicesSandesh::MetadataHandleRequest(std::string ctxt, bool more = false)
     MetadataResponse *resp = new MetadataResponse();
     resp->set_metadata_server_port(
           Agent::GetInstance()->metadata_server_port());
-    const MetadataProxy::MetadataStats &stats =
-          Agent::GetInstance()->services()->metadataproxy()->metadatastats();
+    const MetadataProxy *proxy =
+          Agent::GetInstance()->services()->metadataproxy();
+    const MetadataProxy::MetadataStats &stats = proxy->metadatastats();
     resp->set_metadata_requests(stats.requests);
     resp->set_metadata_responses(stats.responses);
     resp->set_metadata_proxy_sessions(stats.proxy_sessions);
     resp->set_metadata_internal_errors(stats.internal_errors);
+    resp->set_metadata_cache_hits(stats.cache_hits);
+    resp->set_metadata_cache_misses(stats.cache_misses);
+    uint32_t lookups = stats.cache_hits + stats.cache_misses;
+    resp->set_metadata_cache_hit_percent(
+          lookups ? (stats.cache_hits * 100) / lookups : 0);
+    resp->set_metadata_cache_entries(proxy->CacheSize());
+    resp->set_metadata_upstream_connections(stats.upstream_connections);
+    resp->set_metadata_upstream_connections_reused(
+          stats.upstream_connections_reused);
+    resp->set_metadata_idle_connections(proxy->IdleConnections());
+    resp->set_metadata_upstream_responses(stats.upstream_responses);
+    resp->set_metadata_avg_latency_usecs(stats.upstream_responses ?
+          stats.latency_usecs / stats.upstream_responses : 0);
+    resp->set_metadata_max_latency_usecs(stats.max_latency_usecs);
     resp->set_context(ctxt);
     resp->set_more(more);
     resp->Response();
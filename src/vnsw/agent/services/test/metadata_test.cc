@@ -115,7 +115,8 @@ public:
     }
 
     MetadataTest() : nova_api_proxy_(NULL), vm_http_client_(NULL),
-                     done_(0), itf_count_(0), data_size_(0) {
+                     done_(0), itf_count_(0), data_size_(0),
+                     send_content_len_(true) {
         rid_ = Agent::GetInstance()->interface_table()->Register(
                 boost::bind(&MetadataTest::ItfUpdate, this, _2));
         Agent::GetInstance()->set_compute_node_ip(Ip4Address::from_string("127.0.0.1"));
@@ -338,11 +339,18 @@ public:
                             "</head>\n"
                             "</html>\n";
         char response[512];
-        snprintf(response, sizeof(response),
-                 "HTTP/1.1 200 OK\r\n"
-                 "Content-Type: text/html; charset=UTF-8\r\n"
-                 "Content-Length: %u\r\n"
-                 "\r\n%s", (unsigned int)strlen(body), body);
+        if (send_content_len_) {
+            snprintf(response, sizeof(response),
+                     "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/html; charset=UTF-8\r\n"
+                     "Content-Length: %u\r\n"
+                     "\r\n%s", (unsigned int)strlen(body), body);
+        } else {
+            snprintf(response, sizeof(response),
+                     "HTTP/1.1 200 OK\r\n"
+                     "Content-Type: text/html; charset=UTF-8\r\n"
+                     "\r\n%s", body);
+        }
 
         session->Send(reinterpret_cast<const u_int8_t *>(response),
                       strlen(response), NULL);
@@ -350,6 +358,8 @@ public:
     }
 
     Agent *agent_;
+    // Respond without Content-Length, the end of the body is not known
+    bool send_content_len_;
 private:
     HttpServer *nova_api_proxy_;
     HttpClient *vm_http_client_;
@@ -617,6 +627,138 @@ TEST_F(MetadataTest, MetadataOtherMethodsTest) {
     Agent::GetInstance()->services()->metadataproxy()->ClearStats();
 }
 
+// Repeated GETs are served from the cache, other requests reuse the idle
+// connection to the metadata service
+TEST_F(MetadataTest, MetadataCacheTest) {
+    int count = 0;
+    MetadataProxy::MetadataStats stats;
+    struct PortInfo input[] = {
+        {"vnet1", 1, vm1_ip, "00:00:00:01:01:01", 1, 1},
+    };
+
+    MetadataProxy *proxy = Agent::GetInstance()->services()->metadataproxy();
+    uint32_t cache_ttl = proxy->cache_ttl();
+    proxy->set_cache_ttl(60);
+    proxy->ClearCache();
+
+    StartNovaApiProxy();
+    SetupLinkLocalConfig();
+
+    CreateVmportEnv(input, 1, 0);
+    client->WaitForIdle();
+    client->Reset();
+
+    StartHttpClient();
+
+    InterfaceTable *intf_table = Agent::GetInstance()->interface_table();
+    std::auto_ptr<InterfaceTable> interface_table(new TestInterfaceTable());
+    Agent::GetInstance()->set_interface_table(interface_table.get());
+    SendHttpClientRequest(GET_METHOD);
+    METADATA_CHECK (stats.responses < 5);
+    EXPECT_EQ(1U, stats.requests);
+    EXPECT_EQ(0U, stats.cache_hits);
+    EXPECT_EQ(1U, stats.cache_misses);
+    EXPECT_EQ(1U, stats.proxy_sessions);
+    EXPECT_EQ(1U, stats.upstream_connections);
+    EXPECT_EQ(1U, proxy->CacheSize());
+
+    // Served from the cache, metadata service is not contacted
+    SendHttpClientRequest(GET_METHOD);
+    METADATA_CHECK (stats.responses < 10);
+    EXPECT_EQ(2U, stats.requests);
+    EXPECT_EQ(1U, stats.cache_hits);
+    EXPECT_EQ(1U, stats.proxy_sessions);
+    EXPECT_EQ(1U, stats.upstream_responses);
+
+    // POST drops the cached responses of the instance and goes on the idle
+    // connection
+    SendHttpClientRequest(POST_METHOD);
+    METADATA_CHECK (stats.responses < 15);
+    EXPECT_EQ(0U, proxy->CacheSize());
+    EXPECT_EQ(2U, stats.proxy_sessions);
+    EXPECT_EQ(1U, stats.upstream_connections);
+    EXPECT_EQ(1U, stats.upstream_connections_reused);
+
+    SendHttpClientRequest(GET_METHOD);
+    METADATA_CHECK (stats.responses < 20);
+    Agent::GetInstance()->set_interface_table(intf_table);
+    EXPECT_EQ(4U, stats.requests);
+    EXPECT_EQ(1U, stats.cache_hits);
+    EXPECT_EQ(2U, stats.cache_misses);
+    EXPECT_EQ(3U, stats.proxy_sessions);
+    EXPECT_EQ(1U, stats.upstream_connections);
+    EXPECT_EQ(2U, stats.upstream_connections_reused);
+    EXPECT_EQ(3U, stats.upstream_responses);
+    EXPECT_EQ(0U, stats.internal_errors);
+    EXPECT_LE(stats.max_latency_usecs, stats.latency_usecs);
+
+    client->Reset();
+    StopHttpClient();
+    DeleteVmportEnv(input, 1, 1, 0);
+    client->WaitForIdle();
+
+    ClearLinkLocalConfig();
+    StopNovaApiProxy();
+    client->WaitForIdle();
+
+    proxy->set_cache_ttl(cache_ttl);
+    proxy->ClearCache();
+    proxy->ClearStats();
+}
+
+// A response without Content-Length may still be streaming when the headers
+// end, its connection to the metadata service is not reused
+TEST_F(MetadataTest, MetadataNoContentLengthTest) {
+    int count = 0;
+    MetadataProxy::MetadataStats stats;
+    struct PortInfo input[] = {
+        {"vnet1", 1, vm1_ip, "00:00:00:01:01:01", 1, 1},
+    };
+
+    MetadataProxy *proxy = Agent::GetInstance()->services()->metadataproxy();
+    uint32_t cache_ttl = proxy->cache_ttl();
+    proxy->set_cache_ttl(0);
+
+    StartNovaApiProxy();
+    SetupLinkLocalConfig();
+
+    CreateVmportEnv(input, 1, 0);
+    client->WaitForIdle();
+    client->Reset();
+
+    StartHttpClient();
+
+    InterfaceTable *intf_table = Agent::GetInstance()->interface_table();
+    std::auto_ptr<InterfaceTable> interface_table(new TestInterfaceTable());
+    Agent::GetInstance()->set_interface_table(interface_table.get());
+    send_content_len_ = false;
+    SendHttpClientRequest(GET_METHOD);
+    METADATA_CHECK (stats.upstream_responses < 1);
+    EXPECT_EQ(1U, stats.upstream_connections);
+
+    send_content_len_ = true;
+    SendHttpClientRequest(POST_METHOD);
+    METADATA_CHECK (stats.upstream_responses < 2);
+    Agent::GetInstance()->set_interface_table(intf_table);
+    EXPECT_EQ(2U, stats.requests);
+    EXPECT_EQ(2U, stats.proxy_sessions);
+    EXPECT_EQ(2U, stats.upstream_connections);
+    EXPECT_EQ(0U, stats.upstream_connections_reused);
+    EXPECT_EQ(0U, stats.internal_errors);
+
+    client->Reset();
+    StopHttpClient();
+    DeleteVmportEnv(input, 1, 1, 0);
+    client->WaitForIdle();
+
+    ClearLinkLocalConfig();
+    StopNovaApiProxy();
+    client->WaitForIdle();
+
+    proxy->set_cache_ttl(cache_ttl);
+    proxy->ClearStats();
+}
+
 // Send request without linklocal metadata
 TEST_F(MetadataTest, MetadataNoLinkLocalTest) {
     int count = 0;
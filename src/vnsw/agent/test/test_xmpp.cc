@@ -364,6 +364,76 @@ protected:
         SendRouteDeleteMessage(peer, vrf, ss.str().c_str());
     }
 
+    // Send a single update with one item per address, all of them routes
+    // to VMs behind the remote vrouter 5.5.5.5
+    void SendRouteItems(ControlNodeMockBgpXmppPeer *peer,
+                        const std::string &vrf,
+                        const std::vector<std::string> &addresses) {
+        xml_document xdoc;
+        xml_node xitems = MessageHeader(&xdoc, vrf);
+
+        for (size_t i = 0; i < addresses.size(); i++) {
+            autogen::NextHopType item_nexthop;
+            item_nexthop.af = BgpAf::IPv4;
+            item_nexthop.address = "5.5.5.5";
+            item_nexthop.label = 100 + i;
+            item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.
+                push_back("gre");
+
+            autogen::ItemType item;
+            item.entry.next_hops.next_hop.push_back(item_nexthop);
+            item.entry.nlri.af = BgpAf::IPv4;
+            item.entry.nlri.safi = BgpAf::Unicast;
+            item.entry.nlri.address = addresses[i];
+            item.entry.version = 1;
+            item.entry.virtual_network = "vn1";
+
+            xml_node node = xitems.append_child("item");
+            node.append_attribute("id") = addresses[i].c_str();
+            item.Encode(&node);
+        }
+
+        uint32_t count = bgp_peer.get()->Count();
+        SendDocument(xdoc, peer);
+        WAIT_FOR(1000, 100, (bgp_peer.get()->Count() > count));
+        client->WaitForIdle();
+    }
+
+    // Same as SendRouteItems for evpn routes, addresses are "mac,ip/plen"
+    void SendL2RouteItems(ControlNodeMockBgpXmppPeer *peer,
+                          const std::string &vrf,
+                          const std::vector<std::string> &addresses) {
+        xml_document xdoc;
+        xml_node xitems = L2MessageHeader(&xdoc, vrf);
+
+        for (size_t i = 0; i < addresses.size(); i++) {
+            size_t pos = addresses[i].find(',');
+            autogen::EnetNextHopType item_nexthop;
+            item_nexthop.af = 1;
+            item_nexthop.address = "5.5.5.5";
+            item_nexthop.label = 100 + i;
+            item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.
+                push_back("vxlan");
+
+            autogen::EnetItemType item;
+            item.entry.nlri.af = 25;
+            item.entry.nlri.safi = 242;
+            item.entry.nlri.mac = addresses[i].substr(0, pos);
+            item.entry.nlri.address = addresses[i].substr(pos + 1);
+            item.entry.nlri.ethernet_tag = 0;
+            item.entry.next_hops.next_hop.push_back(item_nexthop);
+
+            xml_node node = xitems.append_child("item");
+            node.append_attribute("id") = addresses[i].c_str();
+            item.Encode(&node);
+        }
+
+        uint32_t count = bgp_peer.get()->Count();
+        SendDocument(xdoc, peer);
+        WAIT_FOR(1000, 100, (bgp_peer.get()->Count() > count));
+        client->WaitForIdle();
+    }
+
     void SendRouteDeleteMessage(ControlNodeMockBgpXmppPeer *peer,
                                 const std::string &vrf, const char *str) {
         xml_document xdoc;
@@ -1895,4 +1965,141 @@ TEST_F(AgentXmppUnitTest, bgp_peer_route_update) {
     client->WaitForIdle(5);
 }
 
+
+// Routes to remote VMs of an update are enqueued as one batch to the fabric
+// inet4 and evpn tables, and still end up in the vrf of the update
+TEST_F(AgentXmppUnitTest, RouteItemsBatch) {
+    client->Reset();
+    AddEncapList("VXLAN", "MPLSoGRE", "MPLSoUDP");
+    client->WaitForIdle();
+
+    XmppConnectionSetUp();
+    WAIT_FOR(1000, 10000,
+             (sconnection->GetStateMcState() == xmsm::ESTABLISHED));
+    WAIT_FOR(1000, 10000, (cchannel->GetPeerState() == xmps::READY));
+    WAIT_FOR(1000, 10000, (mock_peer.get()->Count() == 1));
+
+    AddVrf("vrf1", 1);
+    client->WaitForIdle();
+
+    std::vector<std::string> addresses;
+    addresses.push_back("10.1.1.1/32");
+    addresses.push_back("10.1.1.2/32");
+    addresses.push_back("10.1.1.3/32");
+    uint64_t inet_count = agent_->fabric_inet4_unicast_table()->
+        enqueue_count();
+    SendRouteItems(mock_peer.get(), "vrf1", addresses);
+    EXPECT_LE(inet_count + addresses.size(),
+              agent_->fabric_inet4_unicast_table()->enqueue_count());
+    for (size_t i = 0; i < addresses.size(); i++) {
+        Ip4Address addr = Ip4Address::from_string(
+            addresses[i].substr(0, addresses[i].find('/')));
+        WAIT_FOR(1000, 1000, (RouteGet("vrf1", addr, 32) != NULL));
+        InetUnicastRouteEntry *rt = RouteGet("vrf1", addr, 32);
+        ASSERT_TRUE(rt != NULL);
+        EXPECT_EQ(Peer::BGP_PEER, rt->GetActivePath()->peer()->GetType());
+        EXPECT_EQ(NextHop::TUNNEL, rt->GetActiveNextHop()->GetType());
+        EXPECT_TRUE(RouteGet(agent_->fabric_vrf_name(), addr, 32) == NULL);
+    }
+
+    std::vector<std::string> l2_addresses;
+    l2_addresses.push_back("00:00:00:02:02:01,10.1.1.1/32");
+    l2_addresses.push_back("00:00:00:02:02:02,10.1.1.2/32");
+    l2_addresses.push_back("00:00:00:02:02:03,10.1.1.3/32");
+    uint64_t evpn_count = agent_->fabric_evpn_table()->enqueue_count();
+    SendL2RouteItems(mock_peer.get(), "vrf1", l2_addresses);
+    EXPECT_LE(evpn_count + l2_addresses.size(),
+              agent_->fabric_evpn_table()->enqueue_count());
+    for (size_t i = 0; i < l2_addresses.size(); i++) {
+        size_t pos = l2_addresses[i].find(',');
+        MacAddress mac(l2_addresses[i].substr(0, pos));
+        IpAddress addr = Ip4Address::from_string(
+            addresses[i].substr(0, addresses[i].find('/')));
+        WAIT_FOR(1000, 1000, (EvpnRouteGet("vrf1", mac, addr, 0) != NULL));
+        EvpnRouteEntry *evpn_rt = EvpnRouteGet("vrf1", mac, addr, 0);
+        ASSERT_TRUE(evpn_rt != NULL);
+        EXPECT_EQ(Peer::BGP_PEER,
+                  evpn_rt->GetActivePath()->peer()->GetType());
+        EXPECT_EQ(NextHop::TUNNEL, evpn_rt->GetActiveNextHop()->GetType());
+    }
+
+    for (size_t i = 0; i < addresses.size(); i++) {
+        SendRouteDeleteMessage(mock_peer.get(), "vrf1",
+                               addresses[i].c_str());
+        SendL2RouteDeleteMessage(mock_peer.get(),
+            l2_addresses[i].substr(0, l2_addresses[i].find(',')), "vrf1",
+            addresses[i]);
+    }
+    client->WaitForIdle();
+    DelEncapList();
+    DelVrf("vrf1");
+    client->WaitForIdle();
+
+    TaskScheduler::GetInstance()->Stop();
+    agent_->controller()->unicast_cleanup_timer().cleanup_timer_->Fire();
+    TaskScheduler::GetInstance()->Start();
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf1") == false));
+    xc->ConfigUpdate(new XmppConfigData());
+    client->WaitForIdle(5);
+}
+
+// A malformed item stops the processing of an update. Items before it are
+// added, items after it are not
+TEST_F(AgentXmppUnitTest, RouteItemsMalformedMiddleItem) {
+    client->Reset();
+    AddEncapList("VXLAN", "MPLSoGRE", "MPLSoUDP");
+    client->WaitForIdle();
+
+    XmppConnectionSetUp();
+    WAIT_FOR(1000, 10000,
+             (sconnection->GetStateMcState() == xmsm::ESTABLISHED));
+    WAIT_FOR(1000, 10000, (cchannel->GetPeerState() == xmps::READY));
+    WAIT_FOR(1000, 10000, (mock_peer.get()->Count() == 1));
+
+    AddVrf("vrf1", 1);
+    client->WaitForIdle();
+
+    std::vector<std::string> addresses;
+    addresses.push_back("10.1.1.1/32");
+    addresses.push_back("10.1.1/bad");
+    addresses.push_back("10.1.1.3/32");
+    SendRouteItems(mock_peer.get(), "vrf1", addresses);
+    Ip4Address first = Ip4Address::from_string("10.1.1.1");
+    Ip4Address last = Ip4Address::from_string("10.1.1.3");
+    WAIT_FOR(1000, 1000, (RouteGet("vrf1", first, 32) != NULL));
+    EXPECT_EQ(NextHop::TUNNEL,
+              RouteGet("vrf1", first, 32)->GetActiveNextHop()->GetType());
+    EXPECT_TRUE(RouteGet("vrf1", last, 32) == NULL);
+
+    std::vector<std::string> l2_addresses;
+    l2_addresses.push_back("00:00:00:02:02:01,10.1.1.1/32");
+    l2_addresses.push_back("00:00:00:02:02:02,bad");
+    l2_addresses.push_back("00:00:00:02:02:03,10.1.1.3/32");
+    SendL2RouteItems(mock_peer.get(), "vrf1", l2_addresses);
+    MacAddress first_mac("00:00:00:02:02:01");
+    MacAddress last_mac("00:00:00:02:02:03");
+    WAIT_FOR(1000, 1000,
+             (EvpnRouteGet("vrf1", first_mac, IpAddress(first), 0) != NULL));
+    EXPECT_TRUE(EvpnRouteGet("vrf1", last_mac, IpAddress(last), 0) == NULL);
+    EXPECT_TRUE(L2RouteGet("vrf1", last_mac) == NULL);
+
+    SendRouteDeleteMessage(mock_peer.get(), "vrf1", "10.1.1.1/32");
+    SendL2RouteDeleteMessage(mock_peer.get(), "00:00:00:02:02:01", "vrf1",
+                             "10.1.1.1/32");
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (RouteGet("vrf1", first, 32) == NULL));
+    DelEncapList();
+    DelVrf("vrf1");
+    client->WaitForIdle();
+
+    TaskScheduler::GetInstance()->Stop();
+    agent_->controller()->unicast_cleanup_timer().cleanup_timer_->Fire();
+    TaskScheduler::GetInstance()->Start();
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (VrfFind("vrf1") == false));
+    xc->ConfigUpdate(new XmppConfigData());
+    client->WaitForIdle(5);
+}
+
 }
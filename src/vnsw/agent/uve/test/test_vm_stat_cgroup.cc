@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/os.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <cmn/agent_cmn.h>
+#include <base/task.h>
+#include <io/event_manager.h>
+#include <base/util.h>
+#include <uve/agent_uve.h>
+#include <uve/vm_stat_cgroup.h>
+
+#include "testing/gunit.h"
+#include "test/test_cmn_util.h"
+#include <uve/test/vm_uve_table_test.h>
+
+using namespace std;
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+class VmStatCgroupTest : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        agent_ = Agent::GetInstance();
+        std::ostringstream root;
+        root << "/tmp/vm_stat_cgroup_test." << getpid();
+        root_ = root.str();
+        MakeDir("");
+        collector_.reset(new VmStatCgroupCollector(agent_, root_));
+        vmut_ = static_cast<VmUveTableTest *>(agent_->uve()->vm_uve_table());
+        vmut_->ClearCount();
+    }
+
+    virtual void TearDown() {
+        collector_.reset();
+        std::string cmd = "rm -rf " + root_;
+        EXPECT_EQ(0, system(cmd.c_str()));
+    }
+
+    void MakeDir(const std::string &dir) {
+        std::string cmd = "mkdir -p '" + root_ + "/" + dir + "'";
+        EXPECT_EQ(0, system(cmd.c_str()));
+    }
+
+    void WriteFile(const std::string &dir, const std::string &file,
+                   const std::string &data) {
+        MakeDir(dir);
+        std::string path = root_ + "/" + dir + "/" + file;
+        std::ofstream out(path.c_str(), std::ios::binary);
+        out << data;
+    }
+
+    void AddQemuProcess(const std::string &pid, const std::string &uuid,
+                        const std::string &cgroup) {
+        std::string proc = "proc/" + pid;
+        std::string cmdline;
+        cmdline += string("/usr/bin/qemu-system-x86_64") + '\0';
+        cmdline += string("-name") + '\0' + "instance-00000001" + '\0';
+        cmdline += string("-uuid") + '\0' + uuid + '\0';
+        cmdline += string("-m") + '\0' + "2048" + '\0';
+        cmdline += string("-drive") + '\0' + "file=/var/lib/nova/instances/" +
+            uuid + "/disk,format=qcow2,if=none" + '\0';
+        WriteFile(proc, "cmdline", cmdline);
+        WriteFile(proc, "status",
+                  "Name:\tqemu-system-x86\n"
+                  "VmPeak:\t 3000000 kB\n"
+                  "VmSize:\t 2900000 kB\n"
+                  "VmRSS:\t  1000000 kB\n");
+        WriteFile(proc, "stat",
+                  pid + " (qemu-kvm) S 1 1 1 0 -1 0 0 0 0 0 100 50 0 0\n");
+        WriteFile(proc, "cgroup", cgroup);
+        WriteFile(proc + "/task/" + pid, "comm", "qemu-kvm\n");
+        WriteFile(proc + "/task/" + pid, "stat",
+                  pid + " (qemu-kvm) S 1 1 1 0 -1 0 0 0 0 0 10 5 0 0\n");
+        WriteFile(proc + "/task/2001", "comm", "CPU 0/KVM\n");
+        WriteFile(proc + "/task/2001", "stat",
+                  "2001 (CPU 0/KVM) R 1 1 1 0 -1 0 0 0 0 0 40 20 0 0\n");
+        WriteFile(proc + "/task/2002", "comm", "CPU 1/KVM\n");
+        WriteFile(proc + "/task/2002", "stat",
+                  "2002 (CPU 1/KVM) R 1 1 1 0 -1 0 0 0 0 0 30 10 0 0\n");
+
+        // qcow2 image with a virtual size of 1GB
+        std::string header("QFI\xfb", 4);
+        header += std::string(20, '\0');
+        const char size[] = { 0, 0, 0, 0, 0x40, 0, 0, 0 };
+        header += std::string(size, sizeof(size));
+        WriteFile("var/lib/nova/instances/" + uuid, "disk", header);
+    }
+
+    VmStatCgroup *AddVm(const std::string &uuid_str) {
+        boost::uuids::uuid u = StringToUuid(uuid_str);
+        VmStatCgroup *stat = new VmStatCgroup(agent_, u, collector_.get());
+        stat->Start();
+        return stat;
+    }
+
+    Agent *agent_;
+    std::string root_;
+    boost::scoped_ptr<VmStatCgroupCollector> collector_;
+    VmUveTableTest *vmut_;
+};
+
+TEST_F(VmStatCgroupTest, KvmCgroupV1) {
+    std::string uuid = "90cb7351-d2dc-4d8d-a216-2f460be183b6";
+    AddQemuProcess("1234", uuid,
+                   "11:freezer:/machine/instance-1.libvirt-qemu\n"
+                   "7:memory:/machine/instance-1.libvirt-qemu\n"
+                   "4:cpu,cpuacct:/machine/instance-1.libvirt-qemu\n"
+                   "1:name=systemd:/machine/instance-1.libvirt-qemu\n");
+    std::string cgroup = "sys/fs/cgroup/";
+    std::string path = "/machine/instance-1.libvirt-qemu";
+    WriteFile(cgroup + "cpu,cpuacct" + path, "cpuacct.usage", "5000000000\n");
+    WriteFile(cgroup + "memory" + path, "memory.limit_in_bytes",
+              "9223372036854771712\n");
+    WriteFile(cgroup + "freezer" + path, "freezer.state", "THAWED\n");
+
+    VmStatCgroup *stat = AddVm(uuid);
+    EXPECT_EQ(1U, collector_->vm_count());
+    collector_->Collect();
+    EXPECT_EQ(1234U, stat->pid());
+    EXPECT_EQ(1U, vmut_->send_count());
+    EXPECT_EQ(1U, vmut_->vm_stats_send_count());
+
+    const UveVirtualMachineAgent &uve = vmut_->last_sent_uve();
+    EXPECT_EQ(uuid, uve.get_name());
+    const VmCpuStats &cpu = uve.get_cpu_info();
+    // No memory cgroup limit, so the quota comes from the qemu -m argument
+    EXPECT_EQ(2048U * 1024U, cpu.get_vm_memory_quota());
+    EXPECT_EQ(1000000U, cpu.get_rss());
+    EXPECT_EQ(2900000U, cpu.get_virt_memory());
+    EXPECT_EQ(3000000U, cpu.get_peak_virt_memory());
+    EXPECT_EQ(1073741824U, cpu.get_disk_allocated_bytes());
+    EXPECT_EQ(2U, uve.get_vm_cpu_count());
+    vnsConstants vns;
+    EXPECT_EQ(vns.VrouterAgentVmStateMap.at(
+                  VrouterAgentVmState::VROUTER_AGENT_VM_ACTIVE),
+              uve.get_vm_state());
+
+    const VirtualMachineStats &stats = vmut_->last_sent_stats_uve();
+    EXPECT_EQ(uuid, stats.get_name());
+
+    stat->Stop();
+    EXPECT_EQ(0U, collector_->vm_count());
+    collector_->Collect();
+    EXPECT_EQ(1U, vmut_->send_count());
+}
+
+TEST_F(VmStatCgroupTest, KvmCgroupV2) {
+    std::string uuid = "a1cb7351-d2dc-4d8d-a216-2f460be183b7";
+    AddQemuProcess("4321", uuid,
+                   "0::/machine.slice/machine-qemu-instance-2.scope\n");
+    std::string path = "sys/fs/cgroup/machine.slice/"
+        "machine-qemu-instance-2.scope";
+    WriteFile(path, "cpu.stat", "usage_usec 5000000\nuser_usec 4000000\n");
+    WriteFile(path, "memory.max", "1073741824\n");
+    WriteFile(path, "cgroup.freeze", "1\n");
+
+    VmStatCgroup *stat = AddVm(uuid);
+    collector_->Collect();
+    EXPECT_EQ(4321U, stat->pid());
+
+    const UveVirtualMachineAgent &uve = vmut_->last_sent_uve();
+    EXPECT_EQ(uuid, uve.get_name());
+    EXPECT_EQ(1048576U, uve.get_cpu_info().get_vm_memory_quota());
+    vnsConstants vns;
+    EXPECT_EQ(vns.VrouterAgentVmStateMap.at(
+                  VrouterAgentVmState::VROUTER_AGENT_VM_PAUSED),
+              uve.get_vm_state());
+    stat->Stop();
+}
+
+// Process for a VM goes away and comes back with a different pid
+TEST_F(VmStatCgroupTest, KvmPidChange) {
+    std::string uuid = "b2cb7351-d2dc-4d8d-a216-2f460be183b8";
+    AddQemuProcess("1111", uuid, "0::/machine.slice/vm\n");
+    VmStatCgroup *stat = AddVm(uuid);
+    collector_->Collect();
+    EXPECT_EQ(1111U, stat->pid());
+
+    std::string cmd = "rm -rf " + root_ + "/proc/1111";
+    EXPECT_EQ(0, system(cmd.c_str()));
+    collector_->Collect();
+    EXPECT_EQ(0U, stat->pid());
+
+    AddQemuProcess("2222", uuid, "0::/machine.slice/vm\n");
+    collector_->Collect();
+    EXPECT_EQ(2222U, stat->pid());
+    stat->Stop();
+}
+
+// Stats for multiple VMs are collected in a single pass
+TEST_F(VmStatCgroupTest, MultipleVms) {
+    std::vector<VmStatCgroup *> stats;
+    for (int idx = 0; idx < 10; ++idx) {
+        std::ostringstream uuid, pid;
+        uuid << "c3cb7351-d2dc-4d8d-a216-2f460be183" << (10 + idx);
+        pid << (5000 + idx);
+        AddQemuProcess(pid.str(), uuid.str(), "0::/machine.slice/vm\n");
+        stats.push_back(AddVm(uuid.str()));
+    }
+
+    collector_->Collect();
+    EXPECT_EQ(1U, collector_->collect_count());
+    EXPECT_EQ(10U, vmut_->send_count());
+    for (size_t idx = 0; idx < stats.size(); ++idx) {
+        EXPECT_EQ(5000U + idx, stats[idx]->pid());
+        stats[idx]->Stop();
+    }
+}
+
+int main(int argc, char **argv) {
+    GETUSERARGS();
+    client = TestInit(init_file, ksync_init, true, false, true,
+                      (10 * 60 * 1000), (10 * 60 * 1000), true, true,
+                      (10 * 60 * 1000));
+
+    usleep(10000);
+    int ret = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+    return ret;
+}
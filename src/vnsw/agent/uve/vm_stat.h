@@ -24,9 +24,10 @@ public:
     VmStat(Agent *agent, const boost::uuids::uuid &vm_uuid);
     virtual ~VmStat();
     bool marked_delete() const { return marked_delete_; }
+    const boost::uuids::uuid &vm_uuid() const { return vm_uuid_; }
 
     virtual void Start();
-    void Stop();
+    virtual void Stop();
     void ProcessData();
 private:
     bool BuildVmStatsMsg(VirtualMachineStats *uve);
@@ -0,0 +1,728 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <boost/uuid/uuid_io.hpp>
+#include "rapidjson/document.h"
+#include <base/string_util.h>
+#include <cmn/agent.h>
+#include <init/agent_param.h>
+#include <uve/agent_uve.h>
+#include <uve/vm_stat_cgroup.h>
+#include <uve/vm_uve_table.h>
+
+using namespace boost::uuids;
+
+namespace {
+
+// Concatenate path components, making sure that there's exactly one '/'
+// between them.
+std::string JoinPath(const std::string &dir, const std::string &file) {
+    if (dir.empty())
+        return file;
+    if (file.empty())
+        return dir;
+    bool dir_slash = (dir[dir.size() - 1] == '/');
+    bool file_slash = (file[0] == '/');
+    if (dir_slash && file_slash)
+        return dir + file.substr(1);
+    if (!dir_slash && !file_slash)
+        return dir + "/" + file;
+    return dir + file;
+}
+
+bool IsNumeric(const char *str) {
+    if (*str == '\0')
+        return false;
+    for (; *str != '\0'; ++str) {
+        if (*str < '0' || *str > '9')
+            return false;
+    }
+    return true;
+}
+
+void ListDirectory(const std::string &path, std::vector<std::string> *list) {
+    DIR *dir = opendir(path.c_str());
+    if (dir == NULL)
+        return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+        list->push_back(entry->d_name);
+    }
+    closedir(dir);
+}
+
+// Returns user + system time in seconds from a /proc/<pid>/stat or
+// /proc/<pid>/task/<tid>/stat file. The command name can contain spaces, so
+// the fields are counted from the closing parenthesis of the name.
+bool ReadProcStatCpuTime(const std::string &path, double *cpu_time) {
+    std::string data;
+    if (!VmStatCgroupCollector::ReadFile(path, &data))
+        return false;
+    size_t pos = data.rfind(')');
+    if (pos == std::string::npos)
+        return false;
+    std::stringstream ss(data.substr(pos + 1));
+    std::string field;
+    uint64_t utime = 0, stime = 0;
+    // Field 3 (state) is the first one after the name; utime and stime are
+    // fields 14 and 15.
+    for (int idx = 3; idx <= 15 && (ss >> field); ++idx) {
+        if (idx == 14)
+            stringToInteger(field, utime);
+        if (idx == 15)
+            stringToInteger(field, stime);
+    }
+    long ticks = sysconf(_SC_CLK_TCK);
+    if (ticks <= 0)
+        ticks = 100;
+    *cpu_time = static_cast<double>(utime + stime) / ticks;
+    return true;
+}
+
+// Convert a qemu memory size argument (e.g. "2048", "2048M", "2G" or
+// "size=2048M,slots=...") to KiB. Plain numbers are in MiB.
+uint32_t ParseQemuMemSize(const std::string &arg) {
+    std::string value = arg;
+    size_t pos = value.find("size=");
+    if (pos != std::string::npos)
+        value = value.substr(pos + 5);
+    pos = value.find(',');
+    if (pos != std::string::npos)
+        value = value.substr(0, pos);
+    if (value.empty())
+        return 0;
+
+    uint64_t multiplier = 1024;
+    char suffix = value[value.size() - 1];
+    if (suffix == 'k' || suffix == 'K') {
+        multiplier = 1;
+    } else if (suffix == 'm' || suffix == 'M') {
+        multiplier = 1024;
+    } else if (suffix == 'g' || suffix == 'G') {
+        multiplier = 1024 * 1024;
+    }
+    if (suffix < '0' || suffix > '9')
+        value.erase(value.size() - 1);
+
+    uint64_t size = 0;
+    if (!stringToInteger(value, size))
+        return 0;
+    return static_cast<uint32_t>(size * multiplier);
+}
+
+// Extract the image file name from a qemu -drive or -blockdev argument.
+std::string ParseQemuDriveFile(const std::string &arg) {
+    size_t pos = arg.find("\"filename\":\"");
+    if (pos != std::string::npos) {
+        pos += strlen("\"filename\":\"");
+        size_t end = arg.find('"', pos);
+        return arg.substr(pos, end - pos);
+    }
+
+    std::stringstream ss(arg);
+    std::string option;
+    while (std::getline(ss, option, ',')) {
+        if (option.compare(0, 5, "file=") == 0)
+            return option.substr(5);
+        if (option.compare(0, 9, "filename=") == 0)
+            return option.substr(9);
+    }
+    return std::string();
+}
+
+}  // namespace
+
+VmStatCgroup::VmStatCgroup(Agent *agent, const uuid &vm_uuid,
+                           VmStatCgroupCollector *collector)
+    : VmStat(agent, vm_uuid), collector_(collector),
+      uuid_str_(to_string(vm_uuid)), container_id_() {
+}
+
+VmStatCgroup::~VmStatCgroup() {
+}
+
+void VmStatCgroup::Start() {
+    collector_->Register(this);
+}
+
+// Data for this object is only ever accessed from the collector, so it's
+// handed over to the collector for deletion instead of being deleted here.
+void VmStatCgroup::Stop() {
+    marked_delete_ = true;
+    collector_->Unregister(this);
+}
+
+void VmStatCgroup::Collect(const std::string &root, bool docker) {
+    if (docker) {
+        if (container_id_.empty())
+            return;
+        ReadDockerState(root);
+    }
+    if (pid_ == 0)
+        return;
+
+    std::ostringstream proc_dir;
+    proc_dir << "proc/" << pid_;
+    std::vector<std::string> cmdline;
+    VmStatCgroupCollector::ReadCmdline(
+        JoinPath(JoinPath(root, proc_dir.str()), "cmdline"), &cmdline);
+
+    CgroupPathMap paths;
+    ReadCgroupPaths(root, &paths);
+    ReadCpuStat(root, paths);
+    ReadMemStat(root);
+    ReadMemoryQuota(root, paths, cmdline);
+    if (!docker) {
+        ReadVcpuStat(root);
+        ReadDiskStat(cmdline);
+        ReadVmState(root, paths);
+    }
+
+    SendVmCpuStats();
+}
+
+// Parse /proc/<pid>/cgroup. For cgroup v1 each controller is mapped to the
+// directory under /sys/fs/cgroup for its hierarchy. For cgroup v2 the unified
+// hierarchy is mapped with an empty controller name.
+void VmStatCgroup::ReadCgroupPaths(const std::string &root,
+                                   CgroupPathMap *paths) {
+    std::ostringstream file;
+    file << "proc/" << pid_ << "/cgroup";
+    std::ifstream input(JoinPath(root, file.str()).c_str());
+    std::string line;
+    while (std::getline(input, line)) {
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos)
+            continue;
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+        if (controllers.empty()) {
+            (*paths)[""] = path;
+            continue;
+        }
+        if (controllers.compare(0, 5, "name=") == 0)
+            continue;
+        std::stringstream ss(controllers);
+        std::string controller;
+        while (std::getline(ss, controller, ',')) {
+            (*paths)[controller] = JoinPath(controllers, path);
+        }
+    }
+}
+
+void VmStatCgroup::ReadCpuStat(const std::string &root,
+                               const CgroupPathMap &paths) {
+    std::string cgroup_root = JoinPath(root, "sys/fs/cgroup");
+    double cpu_stat = 0;
+    bool found = false;
+    uint64_t usage = 0;
+
+    CgroupPathMap::const_iterator it = paths.find("cpuacct");
+    if (it != paths.end()) {
+        std::string file =
+            JoinPath(JoinPath(cgroup_root, it->second), "cpuacct.usage");
+        if (VmStatCgroupCollector::ReadUint64(file, &usage)) {
+            // Nanoseconds to seconds
+            cpu_stat = static_cast<double>(usage) / 1000000000;
+            found = true;
+        }
+    }
+
+    it = paths.find("");
+    if (!found && it != paths.end()) {
+        std::string data;
+        std::string file =
+            JoinPath(JoinPath(cgroup_root, it->second), "cpu.stat");
+        if (VmStatCgroupCollector::ReadFile(file, &data)) {
+            std::stringstream ss(data);
+            std::string key;
+            while (ss >> key) {
+                if (key == "usage_usec") {
+                    ss >> usage;
+                    // Microseconds to seconds
+                    cpu_stat = static_cast<double>(usage) / 1000000;
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!found) {
+        std::ostringstream file;
+        file << "proc/" << pid_ << "/stat";
+        found = ReadProcStatCpuTime(JoinPath(root, file.str()), &cpu_stat);
+    }
+    if (!found)
+        return;
+
+    time_t now;
+    time(&now);
+    if (prev_cpu_snapshot_time_ && difftime(now, prev_cpu_snapshot_time_)) {
+        cpu_usage_ = (cpu_stat - prev_cpu_stat_)/
+                     difftime(now, prev_cpu_snapshot_time_);
+        cpu_usage_ *= 100;
+    }
+
+    prev_cpu_stat_ = cpu_stat;
+    prev_cpu_snapshot_time_ = now;
+}
+
+// The vCPU threads of a qemu process are named "CPU <n>/KVM".
+void VmStatCgroup::ReadVcpuStat(const std::string &root) {
+    std::ostringstream task_dir;
+    task_dir << "proc/" << pid_ << "/task";
+    std::string dir = JoinPath(root, task_dir.str());
+    std::vector<std::string> tasks;
+    ListDirectory(dir, &tasks);
+
+    std::map<uint32_t, double> vcpu_map;
+    for (std::vector<std::string>::const_iterator it = tasks.begin();
+         it != tasks.end(); ++it) {
+        std::string comm;
+        if (!VmStatCgroupCollector::ReadFile(
+                JoinPath(JoinPath(dir, *it), "comm"), &comm))
+            continue;
+        if (comm.compare(0, 4, "CPU ") != 0)
+            continue;
+        size_t end = comm.find('/');
+        uint32_t index = 0;
+        if (!stringToInteger(comm.substr(4, end - 4), index))
+            continue;
+        double usage = 0;
+        if (ReadProcStatCpuTime(JoinPath(JoinPath(dir, *it), "stat"), &usage))
+            vcpu_map[index] = usage;
+    }
+
+    std::vector<double> vcpu_usage;
+    for (std::map<uint32_t, double>::const_iterator it = vcpu_map.begin();
+         it != vcpu_map.end(); ++it) {
+        vcpu_usage.push_back(it->second);
+    }
+
+    vm_cpu_count_ = kInvalidCpuCount;
+    if (!vcpu_usage.empty())
+        vm_cpu_count_ = vcpu_usage.size();
+
+    vcpu_usage_percent_.clear();
+    if (prev_vcpu_usage_.size() != vcpu_usage.size()) {
+        //In case a new VCPU get added
+        prev_vcpu_usage_ = vcpu_usage;
+    }
+
+    time_t now;
+    time(&now);
+    if (prev_vcpu_snapshot_time_ && difftime(now, prev_vcpu_snapshot_time_)) {
+        for (uint32_t i = 0; i < vcpu_usage.size(); i++) {
+            double cpu_usage = (vcpu_usage[i] - prev_vcpu_usage_[i])/
+                               difftime(now, prev_vcpu_snapshot_time_);
+            cpu_usage *= 100;
+            vcpu_usage_percent_.push_back(cpu_usage);
+        }
+    }
+
+    prev_vcpu_usage_ = vcpu_usage;
+    prev_vcpu_snapshot_time_ = now;
+}
+
+void VmStatCgroup::ReadMemStat(const std::string &root) {
+    std::ostringstream proc_file;
+    proc_file << "proc/" << pid_ << "/status";
+    std::ifstream file(JoinPath(root, proc_file.str()).c_str());
+
+    bool vmsize = false;
+    bool peak = false;
+    bool rss = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream vm(line);
+        std::string tmp;
+        vm >> tmp;
+        if (tmp == "VmSize:") {
+            vm >> virt_memory_;
+            vmsize = true;
+        } else if (tmp == "VmRSS:") {
+            vm >> mem_usage_;
+            rss = true;
+        } else if (tmp == "VmPeak:") {
+            vm >> virt_memory_peak_;
+            peak = true;
+        }
+        if (rss && vmsize && peak)
+            break;
+    }
+}
+
+// Memory quota in KiB. Use the memory cgroup limit if one is set, otherwise
+// the memory size from the qemu command line.
+void VmStatCgroup::ReadMemoryQuota(const std::string &root,
+                                   const CgroupPathMap &paths,
+                                   const std::vector<std::string> &cmdline) {
+    static const uint64_t kUnlimited = (1ULL << 60);
+    std::string cgroup_root = JoinPath(root, "sys/fs/cgroup");
+    uint64_t limit = 0;
+
+    CgroupPathMap::const_iterator it = paths.find("memory");
+    if (it != paths.end()) {
+        VmStatCgroupCollector::ReadUint64(JoinPath(JoinPath(cgroup_root,
+            it->second), "memory.limit_in_bytes"), &limit);
+    } else if ((it = paths.find("")) != paths.end()) {
+        // memory.max contains "max" when there's no limit, which fails to
+        // parse and leaves the limit at 0.
+        VmStatCgroupCollector::ReadUint64(JoinPath(JoinPath(cgroup_root,
+            it->second), "memory.max"), &limit);
+    }
+    if (limit && limit < kUnlimited) {
+        vm_memory_quota_ = limit / 1024;
+        return;
+    }
+
+    std::vector<std::string>::const_iterator arg =
+        std::find(cmdline.begin(), cmdline.end(), "-m");
+    if (arg != cmdline.end() && ++arg != cmdline.end()) {
+        vm_memory_quota_ = ParseQemuMemSize(*arg);
+    }
+}
+
+// Pick the image for the VM from the qemu command line, preferring the one
+// that contains the VM uuid in its path, and stat it. The capacity of qcow2
+// images is read from the image header.
+void VmStatCgroup::ReadDiskStat(const std::vector<std::string> &cmdline) {
+    std::string disk;
+    for (std::vector<std::string>::const_iterator it = cmdline.begin();
+         it != cmdline.end(); ++it) {
+        if (*it != "-drive" && *it != "-blockdev")
+            continue;
+        if (++it == cmdline.end())
+            break;
+        std::string file = ParseQemuDriveFile(*it);
+        if (file.empty() || file.compare(0, 5, "/dev/") == 0)
+            continue;
+        if (disk.empty() || file.find(uuid_str_) != std::string::npos)
+            disk = file;
+        if (file.find(uuid_str_) != std::string::npos)
+            break;
+    }
+    if (disk.empty())
+        return;
+
+    std::string path = JoinPath(collector_->root_path(), disk);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return;
+    disk_name_ = disk;
+    disk_size_ = st.st_blocks * 512;
+    virtual_size_ = st.st_size;
+
+    // qcow2 header: magic "QFI\xfb" followed by the virtual size as a big
+    // endian 64 bit value at offset 24.
+    std::ifstream image(path.c_str(), std::ios::binary);
+    unsigned char header[32];
+    if (image.read(reinterpret_cast<char *>(header), sizeof(header)) &&
+        header[0] == 'Q' && header[1] == 'F' && header[2] == 'I' &&
+        header[3] == 0xfb) {
+        uint64_t size = 0;
+        for (int idx = 24; idx < 32; ++idx) {
+            size = (size << 8) | header[idx];
+        }
+        virtual_size_ = size;
+    }
+}
+
+// A qemu process that exists is considered to be active unless it has been
+// frozen via the freezer cgroup.
+void VmStatCgroup::ReadVmState(const std::string &root,
+                               const CgroupPathMap &paths) {
+    std::string cgroup_root = JoinPath(root, "sys/fs/cgroup");
+    vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_ACTIVE;
+
+    std::string data;
+    CgroupPathMap::const_iterator it = paths.find("freezer");
+    if (it != paths.end()) {
+        if (VmStatCgroupCollector::ReadFile(JoinPath(JoinPath(cgroup_root,
+                it->second), "freezer.state"), &data) &&
+            data.find("FROZEN") != std::string::npos) {
+            vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_PAUSED;
+        }
+    } else if ((it = paths.find("")) != paths.end()) {
+        if (VmStatCgroupCollector::ReadFile(JoinPath(JoinPath(cgroup_root,
+                it->second), "cgroup.freeze"), &data) &&
+            data.find('1') != std::string::npos) {
+            vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_PAUSED;
+        }
+    }
+}
+
+// Read container state from the docker config.v2.json for the container.
+void VmStatCgroup::ReadDockerState(const std::string &root) {
+    std::string data;
+    std::string file = JoinPath(JoinPath(JoinPath(root,
+        "var/lib/docker/containers"), container_id_), "config.v2.json");
+    vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_UNKNOWN;
+    if (!VmStatCgroupCollector::ReadFile(file, &data))
+        return;
+
+    contrail_rapidjson::Document doc;
+    if (doc.Parse<0>(data.c_str()).HasParseError() || !doc.IsObject() ||
+        !doc.HasMember("State") || !doc["State"].IsObject()) {
+        return;
+    }
+    const contrail_rapidjson::Value &state = doc["State"];
+    if (state.HasMember("Pid") && state["Pid"].IsUint())
+        pid_ = state["Pid"].GetUint();
+    bool paused = state.HasMember("Paused") && state["Paused"].IsBool() &&
+        state["Paused"].GetBool();
+    bool running = state.HasMember("Running") && state["Running"].IsBool() &&
+        state["Running"].GetBool();
+    if (paused) {
+        vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_PAUSED;
+    } else if (running) {
+        vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_ACTIVE;
+    } else {
+        vm_state_ = VrouterAgentVmState::VROUTER_AGENT_VM_SHUTDOWN;
+        pid_ = 0;
+    }
+}
+
+VmStatCgroupCollector::VmStatCgroupCollector(Agent *agent,
+                                             const std::string &root_path)
+    : agent_(agent), root_path_(root_path),
+      timer_(TimerManager::CreateTimer(*(agent->event_manager())->io_service(),
+             "VmStatCgroupTimer",
+             TaskScheduler::GetInstance()->GetTaskId("Agent::VmUve"), 0)),
+      collect_count_(0) {
+}
+
+VmStatCgroupCollector::~VmStatCgroupCollector() {
+    TimerManager::DeleteTimer(timer_);
+    for (VmStatMap::iterator it = vm_stat_map_.begin();
+         it != vm_stat_map_.end(); ++it) {
+        delete it->second;
+    }
+    for (std::vector<VmStatCgroup *>::iterator it = delete_list_.begin();
+         it != delete_list_.end(); ++it) {
+        delete *it;
+    }
+}
+
+void VmStatCgroupCollector::Start() {
+    timer_->Start(agent_->params()->vmi_vm_vn_uve_interval_msecs(),
+                  boost::bind(&VmStatCgroupCollector::Collect, this));
+}
+
+void VmStatCgroupCollector::Register(VmStatCgroup *stat) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    vm_stat_map_[stat->vm_uuid()] = stat;
+}
+
+// Called from the db::DBTable task while the collector may be running.
+// Actual delete happens from the collector.
+void VmStatCgroupCollector::Unregister(VmStatCgroup *stat) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    VmStatMap::iterator it = vm_stat_map_.find(stat->vm_uuid());
+    if (it != vm_stat_map_.end() && it->second == stat)
+        vm_stat_map_.erase(it);
+    delete_list_.push_back(stat);
+}
+
+size_t VmStatCgroupCollector::vm_count() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return vm_stat_map_.size();
+}
+
+void VmStatCgroupCollector::Sweep(std::vector<VmStatCgroup *> *list) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (std::vector<VmStatCgroup *>::iterator it = delete_list_.begin();
+         it != delete_list_.end(); ++it) {
+        delete *it;
+    }
+    delete_list_.clear();
+
+    list->reserve(vm_stat_map_.size());
+    for (VmStatMap::iterator it = vm_stat_map_.begin();
+         it != vm_stat_map_.end(); ++it) {
+        list->push_back(it->second);
+    }
+}
+
+// Collect statistics for all registered VMs. Pids/containers are discovered
+// with one scan of procfs or the docker state directory for all the VMs that
+// need it, followed by a single pass over the cgroup files of each VM.
+bool VmStatCgroupCollector::Collect() {
+    std::vector<VmStatCgroup *> list;
+    Sweep(&list);
+    collect_count_++;
+
+    bool docker = agent_->isDockerMode();
+    std::vector<VmStatCgroup *> pending;
+    for (std::vector<VmStatCgroup *>::iterator it = list.begin();
+         it != list.end(); ++it) {
+        VmStatCgroup *stat = *it;
+        if (docker) {
+            if (stat->vm_uuid() == nil_uuid())
+                continue;
+            if (stat->container_id().empty())
+                pending.push_back(stat);
+        } else if (stat->pid() == 0 || !IsProcessAlive(stat->pid())) {
+            stat->set_pid(0);
+            pending.push_back(stat);
+        }
+    }
+
+    if (!pending.empty()) {
+        if (docker) {
+            DiscoverContainers(pending);
+        } else {
+            DiscoverKvmPids(pending);
+        }
+    }
+
+    for (std::vector<VmStatCgroup *>::iterator it = list.begin();
+         it != list.end(); ++it) {
+        VmStatCgroup *stat = *it;
+        if (stat->marked_delete())
+            continue;
+        stat->Collect(root_path_, docker);
+    }
+    return true;
+}
+
+bool VmStatCgroupCollector::IsProcessAlive(uint32_t pid) const {
+    std::ostringstream dir;
+    dir << "proc/" << pid;
+    struct stat st;
+    return (stat(JoinPath(root_path_, dir.str()).c_str(), &st) == 0);
+}
+
+// Scan procfs once for qemu/kvm processes and match them to VMs using the
+// -uuid argument, or any argument containing the VM uuid.
+void VmStatCgroupCollector::DiscoverKvmPids(
+    const std::vector<VmStatCgroup *> &list) {
+    std::map<std::string, VmStatCgroup *> uuid_map;
+    for (std::vector<VmStatCgroup *>::const_iterator it = list.begin();
+         it != list.end(); ++it) {
+        uuid_map[(*it)->uuid_str()] = *it;
+    }
+
+    std::string proc_dir = JoinPath(root_path_, "proc");
+    std::vector<std::string> pids;
+    ListDirectory(proc_dir, &pids);
+    for (std::vector<std::string>::const_iterator pit = pids.begin();
+         pit != pids.end() && !uuid_map.empty(); ++pit) {
+        if (!IsNumeric(pit->c_str()))
+            continue;
+        std::vector<std::string> args;
+        if (!ReadCmdline(JoinPath(JoinPath(proc_dir, *pit), "cmdline"), &args))
+            continue;
+        if (args.empty() || (args[0].find("qemu") == std::string::npos &&
+                             args[0].find("kvm") == std::string::npos)) {
+            continue;
+        }
+
+        std::map<std::string, VmStatCgroup *>::iterator match =
+            uuid_map.end();
+        for (size_t idx = 0; idx < args.size(); ++idx) {
+            if (args[idx] == "-uuid" && idx + 1 < args.size()) {
+                match = uuid_map.find(args[idx + 1]);
+                break;
+            }
+        }
+        if (match == uuid_map.end()) {
+            for (match = uuid_map.begin(); match != uuid_map.end(); ++match) {
+                bool found = false;
+                for (size_t idx = 1; idx < args.size(); ++idx) {
+                    if (args[idx].find(match->first) != std::string::npos) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (found)
+                    break;
+            }
+        }
+        if (match == uuid_map.end())
+            continue;
+
+        uint32_t pid = 0;
+        stringToInteger(*pit, pid);
+        match->second->set_pid(pid);
+        uuid_map.erase(match);
+    }
+}
+
+// Scan the docker state directory once and match containers to VMs based
+// on the VM uuid appearing in the container configuration.
+void VmStatCgroupCollector::DiscoverContainers(
+    const std::vector<VmStatCgroup *> &list) {
+    std::string containers_dir =
+        JoinPath(root_path_, "var/lib/docker/containers");
+    std::vector<std::string> containers;
+    ListDirectory(containers_dir, &containers);
+
+    std::vector<VmStatCgroup *> remaining(list);
+    for (std::vector<std::string>::const_iterator cit = containers.begin();
+         cit != containers.end() && !remaining.empty(); ++cit) {
+        std::string config;
+        if (!ReadFile(JoinPath(JoinPath(containers_dir, *cit),
+                               "config.v2.json"), &config)) {
+            continue;
+        }
+        for (std::vector<VmStatCgroup *>::iterator it = remaining.begin();
+             it != remaining.end(); ++it) {
+            if (config.find((*it)->uuid_str()) != std::string::npos) {
+                (*it)->set_container_id(*cit);
+                remaining.erase(it);
+                break;
+            }
+        }
+    }
+}
+
+bool VmStatCgroupCollector::ReadFile(const std::string &path,
+                                     std::string *data) {
+    std::ifstream file(path.c_str());
+    if (!file)
+        return false;
+    std::stringstream ss;
+    ss << file.rdbuf();
+    *data = ss.str();
+    return true;
+}
+
+bool VmStatCgroupCollector::ReadUint64(const std::string &path,
+                                       uint64_t *value) {
+    std::ifstream file(path.c_str());
+    if (!file)
+        return false;
+    uint64_t tmp;
+    if (!(file >> tmp))
+        return false;
+    *value = tmp;
+    return true;
+}
+
+bool VmStatCgroupCollector::ReadCmdline(const std::string &path,
+                                        std::vector<std::string> *args) {
+    std::string data;
+    if (!ReadFile(path, &data))
+        return false;
+    std::string arg;
+    std::stringstream ss(data);
+    while (std::getline(ss, arg, '\0')) {
+        args->push_back(arg);
+    }
+    return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_vm_stat_cgroup_h
+#define vnsw_agent_vm_stat_cgroup_h
+
+#include <map>
+#include <string>
+#include <vector>
+#include <tbb/mutex.h>
+#include "vm_stat.h"
+
+class VmStatCgroupCollector;
+
+// VmStat which does not fork any commands to collect statistics. The data
+// is filled in by VmStatCgroupCollector, which reads cgroup and procfs files
+// for all the VMs on the node in a single pass every interval.
+class VmStatCgroup : public VmStat {
+public:
+    VmStatCgroup(Agent *agent, const boost::uuids::uuid &vm_uuid,
+                 VmStatCgroupCollector *collector);
+    virtual ~VmStatCgroup();
+
+    virtual void Start();
+    virtual void Stop();
+
+    const std::string &uuid_str() const { return uuid_str_; }
+    uint32_t pid() const { return pid_; }
+    void set_pid(uint32_t pid) { pid_ = pid; }
+    const std::string &container_id() const { return container_id_; }
+    void set_container_id(const std::string &id) { container_id_ = id; }
+
+    void Collect(const std::string &root, bool docker);
+
+private:
+    friend class VmStatCgroupTest;
+    typedef std::map<std::string, std::string> CgroupPathMap;
+
+    void ReadCgroupPaths(const std::string &root, CgroupPathMap *paths);
+    void ReadCpuStat(const std::string &root, const CgroupPathMap &paths);
+    void ReadVcpuStat(const std::string &root);
+    void ReadMemStat(const std::string &root);
+    void ReadMemoryQuota(const std::string &root, const CgroupPathMap &paths,
+                         const std::vector<std::string> &cmdline);
+    void ReadDiskStat(const std::vector<std::string> &cmdline);
+    void ReadVmState(const std::string &root, const CgroupPathMap &paths);
+    void ReadDockerState(const std::string &root);
+
+    VmStatCgroupCollector *collector_;
+    std::string uuid_str_;
+    std::string container_id_;
+
+    DISALLOW_COPY_AND_ASSIGN(VmStatCgroup);
+};
+
+// Collects statistics for all VmStatCgroup objects from cgroup v1/v2 and
+// procfs, rooted at root_path_ so that it can be pointed to a fake tree in
+// tests. Runs in the Agent::VmUve task, the same task in which stats
+// collected by VmStatKvm and VmStatDocker are processed.
+class VmStatCgroupCollector {
+public:
+    typedef std::map<boost::uuids::uuid, VmStatCgroup *> VmStatMap;
+
+    VmStatCgroupCollector(Agent *agent, const std::string &root_path);
+    virtual ~VmStatCgroupCollector();
+
+    void Register(VmStatCgroup *stat);
+    void Unregister(VmStatCgroup *stat);
+    void Start();
+    bool Collect();
+
+    const std::string &root_path() const { return root_path_; }
+    size_t vm_count() const;
+    uint64_t collect_count() const { return collect_count_; }
+
+    // Helpers to read cgroup/procfs files, also used by VmStatCgroup
+    static bool ReadFile(const std::string &path, std::string *data);
+    static bool ReadUint64(const std::string &path, uint64_t *value);
+    static bool ReadCmdline(const std::string &path,
+                            std::vector<std::string> *args);
+
+private:
+    void Sweep(std::vector<VmStatCgroup *> *list);
+    void DiscoverKvmPids(const std::vector<VmStatCgroup *> &list);
+    void DiscoverContainers(const std::vector<VmStatCgroup *> &list);
+    bool IsProcessAlive(uint32_t pid) const;
+
+    Agent *agent_;
+    std::string root_path_;
+    mutable tbb::mutex mutex_;
+    VmStatMap vm_stat_map_;
+    std::vector<VmStatCgroup *> delete_list_;
+    Timer *timer_;
+    uint64_t collect_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(VmStatCgroupCollector);
+};
+#endif // vnsw_agent_vm_stat_cgroup_h
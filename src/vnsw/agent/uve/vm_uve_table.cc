@@ -8,6 +8,7 @@
 #include <uve/agent_uve.h>
 #include <uve/vm_stat_kvm.h>
 #include <uve/vm_stat_docker.h>
+#include <uve/vm_stat_cgroup.h>
 
 VmUveTable::VmUveTable(Agent *agent, uint32_t default_intvl)
     : VmUveTableBase(agent, default_intvl) {
@@ -56,7 +57,18 @@ void VmUveTable::SendVmStatsMsg(const boost::uuids::uuid &u) {
 void VmUveTable::VmStatCollectionStart(VmUveVmState *state, const VmEntry *vm) {
     //Create object to poll for VM stats
     VmStat *stat = NULL;
-    if (agent_->isKvmMode()) {
+    if (agent_->params()->vm_stats_cgroup_collector() &&
+        (agent_->isKvmMode() || agent_->isDockerMode())) {
+        // Collect stats for all VMs in a single pass from cgroup/procfs
+        // instead of running commands for each VM.
+        if (!cgroup_collector_.get()) {
+            cgroup_collector_.reset(new VmStatCgroupCollector(agent_,
+                agent_->params()->vm_stats_root_path()));
+            cgroup_collector_->Start();
+        }
+        stat = new VmStatCgroup(agent_, vm->GetUuid(),
+                                cgroup_collector_.get());
+    } else if (agent_->isKvmMode()) {
         stat = new VmStatKvm(agent_, vm->GetUuid());
     } else if (agent_->isDockerMode()) {
         stat = new VmStatDocker(agent_, vm->GetUuid());
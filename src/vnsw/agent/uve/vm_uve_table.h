@@ -11,6 +11,8 @@
 #include <pkt/flow_proto.h>
 #include <pkt/flow_table.h>
 
+class VmStatCgroupCollector;
+
 class VmUveTable : public VmUveTableBase {
 public:
     VmUveTable(Agent *agent, uint32_t default_intvl);
@@ -21,6 +23,9 @@ public:
     bool Process(VmStatData *vm_stat_data);
     void SendVmStats(void);
     virtual void DispatchVmStatsMsg(const VirtualMachineStats &uve);
+    VmStatCgroupCollector *cgroup_collector() const {
+        return cgroup_collector_.get();
+    }
 protected:
     virtual void VmStatCollectionStart(VmUveVmState *state, const VmEntry *vm);
     virtual void VmStatCollectionStop(VmUveVmState *state);
@@ -30,6 +35,7 @@ private:
     virtual void SendVmDeleteMsg(const std::string &vm_config_name);
 
     boost::scoped_ptr<WorkQueue<VmStatData *> > event_queue_;
+    boost::scoped_ptr<VmStatCgroupCollector> cgroup_collector_;
     DISALLOW_COPY_AND_ASSIGN(VmUveTable);
 };
 
@@ -17,7 +17,8 @@ public:
         INVALID,
         ADD_FLOW,
         DELETE_FLOW,
-        UPDATE_FLOW_STATS
+        UPDATE_FLOW_STATS,
+        AGE_FLOW
     };
 
     FlowExportReq(Event event, const FlowExportInfo &info) :
@@ -109,8 +109,12 @@ uint32_t FlowStatsCollector::TimersPerScan() {
     scan_time_millisec = flow_age_time_intvl_ / 1000;
 
     // Compute time in which we must scan the complete table to honor the
-    // kFlowScanTime
-    scan_time_millisec = (scan_time_millisec * kFlowScanTime) / 100;
+    // kFlowScanTime. When FlowStatsScanner is enabled, flows are visited
+    // based on the vrouter flow table scan. The list walk is only needed
+    // for flows without a vrouter entry, scan it once per ageing time
+    if (agent_uve_->agent()->params()->flow_stats_scan_partitions() == 0) {
+        scan_time_millisec = (scan_time_millisec * kFlowScanTime) / 100;
+    }
 
     // Enforce min value on scan-time
     if (scan_time_millisec < kFlowStatsTimerInterval) {
@@ -676,9 +680,7 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
 
             // We dont want to retry delete-events, remove flow from ageing list
             assert(info->is_linked());
-            FlowExportInfoList::iterator flow_it =
-                flow_export_info_list_.iterator_to(*info);
-            flow_export_info_list_.erase(flow_it);
+            UnlinkFlowExportInfo(info);
 
             return count;
         }
@@ -695,9 +697,7 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
 
     // Flow aged, remove both forward and reverse flow
     assert(info->is_linked());
-    FlowExportInfoList::iterator flow_it =
-        flow_export_info_list_.iterator_to(*info);
-    flow_export_info_list_.erase(flow_it);
+    UnlinkFlowExportInfo(info);
 
     FlowEntry *rfe = info->reverse_flow();
     FlowExportInfo *rev_info = FindFlowExportInfo(rfe);
@@ -708,22 +708,43 @@ uint32_t FlowStatsCollector::ProcessFlow(FlowExportInfoList::iterator &it,
             if (rev_flow_it == it) {
                 it++;
             }
-            flow_export_info_list_.erase(rev_flow_it);
+            UnlinkFlowExportInfo(rev_info);
         }
         count++;
     }
     return count;
 }
 
+// Remove flow from the ageing list. ProcessFlow is also run for flows
+// reported by FlowStatsScanner, outside of the list walk in RunAgeing. Move
+// flow_iteration_key_ past the flow so that the next RunAgeing does not
+// resume from a flow that is no longer in the list.
+void FlowStatsCollector::UnlinkFlowExportInfo(FlowExportInfo *info) {
+    FlowExportInfoList::iterator it =
+        flow_export_info_list_.iterator_to(*info);
+    if (info->flow() == flow_iteration_key_) {
+        FlowExportInfoList::iterator next = it;
+        ++next;
+        if (next == flow_export_info_list_.end()) {
+            flow_iteration_key_ = NULL;
+        } else {
+            flow_iteration_key_ = next->flow();
+        }
+    }
+    flow_export_info_list_.erase(it);
+}
+
 uint32_t FlowStatsCollector::RunAgeing(uint32_t max_count) {
     FlowExportInfoList::iterator it;
     if (flow_iteration_key_ == NULL) {
         it = flow_export_info_list_.begin();
     } else {
         FlowEntryTree::iterator tree_it = flow_tree_.find(flow_iteration_key_);
-        // Flow to iterate next is not found. Force stop this iteration.
-        // We will continue from begining on next timer
-        if (tree_it == flow_tree_.end()) {
+        // Flow to iterate next is not found or not in ageing list anymore.
+        // Force stop this iteration. We will continue from begining on next
+        // timer
+        if (tree_it == flow_tree_.end() ||
+            tree_it->second.is_linked() == false) {
             flow_iteration_key_ = NULL;
             return entries_to_visit_;
         }
@@ -827,6 +848,13 @@ void FlowStatsCollector::DeleteEvent(const FlowEntryPtr &flow,
     request_queue_.Enqueue(req);
 }
 
+void FlowStatsCollector::AgeEvent(const FlowEntryPtr &flow) {
+    FlowExportInfo info(flow);
+    boost::shared_ptr<FlowExportReq>
+        req(new FlowExportReq(FlowExportReq::AGE_FLOW, info));
+    request_queue_.Enqueue(req);
+}
+
 void FlowStatsCollector::UpdateStatsEvent(const FlowEntryPtr &flow,
                                           uint32_t bytes,
                                           uint32_t packets,
@@ -847,10 +875,33 @@ bool FlowStatsCollector::RequestHandlerEntry() {
 void FlowStatsCollector::RequestHandlerExit(bool done) {
 }
 
+// Flow reported by FlowStatsScanner. Run the ageing checks on it, same as
+// the list walk in RunAgeing
+void FlowStatsCollector::AgeFlowCandidate(FlowEntry *flow) {
+    FlowExportInfo *info = FindFlowExportInfo(flow);
+    // Flow is deleted or aged already
+    if (info == NULL || info->is_linked() == false)
+        return;
+
+    KSyncFlowMemory *ksync_obj = agent_uve_->agent()->ksync()->
+        ksync_flow_memory();
+    FlowExportInfoList::iterator it = flow_export_info_list_.end();
+    flows_visited_++;
+    ProcessFlow(it, ksync_obj, info, current_time_);
+}
+
 bool FlowStatsCollector::RequestHandler(boost::shared_ptr<FlowExportReq> req) {
     const FlowExportInfo &info = req->info();
     FlowEntry *flow = info.flow();
     FlowEntry *rflow = info.reverse_flow();
+
+    // ProcessFlow takes the flow lock when needed, handle it before taking
+    // the lock
+    if (req->event() == FlowExportReq::AGE_FLOW) {
+        AgeFlowCandidate(flow);
+        return true;
+    }
+
     FLOW_LOCK(flow, rflow, FlowEvent::FLOW_MESSAGE);
 
     switch (req->event()) {
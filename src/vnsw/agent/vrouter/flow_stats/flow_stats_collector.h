@@ -144,6 +144,7 @@ public:
     void Shutdown();
     void AddEvent(const FlowEntryPtr &flow);
     void DeleteEvent(const FlowEntryPtr &flow, const RevFlowDepParams &params);
+    void AgeEvent(const FlowEntryPtr &flow);
 
     bool FindFlowExportInfo(const FlowEntry *fe, FlowEntryTree::iterator &it);
     FlowExportInfo *FindFlowExportInfo(const FlowEntry *fe);
@@ -221,6 +222,8 @@ private:
                                 FlowEntryTree::iterator &tree_it);
     void HandleFlowStatsUpdate(const FlowKey &key, uint32_t bytes,
                                uint32_t packets, uint32_t oflow_bytes);
+    void AgeFlowCandidate(FlowEntry *flow);
+    void UnlinkFlowExportInfo(FlowExportInfo *info);
 
     AgentUveBase *agent_uve_;
     int task_id_;
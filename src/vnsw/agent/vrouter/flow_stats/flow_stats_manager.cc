@@ -21,6 +21,9 @@
 #include <uve/agent_uve.h>
 #include <vrouter/flow_stats/flow_stats_collector.h>
 #include <vrouter/flow_stats/session_stats_collector.h>
+#include <vrouter/flow_stats/flow_stats_scanner.h>
+#include <vrouter/ksync/ksync_init.h>
+#include <vrouter/ksync/ksync_flow_memory.h>
 #include <uve/vn_uve_table.h>
 #include <uve/vm_uve_table.h>
 #include <uve/interface_uve_stats_table.h>
@@ -150,6 +153,7 @@ void FlowStatsManager::AddReqHandler(boost::shared_ptr<FlowStatsCollectorReq>
         it->second->SetFlowAgeTime(
                 1000000L * (uint64_t)req->flow_cache_timeout);
         it->second->ClearDelete();
+        UpdateScanIdleTime();
         return;
     }
 
@@ -164,6 +168,7 @@ void FlowStatsManager::AddReqHandler(boost::shared_ptr<FlowStatsCollectorReq>
     if (req->key.port == 0) {
         protocol_list_[req->key.proto] = aging_table.get();
     }
+    UpdateScanIdleTime();
 }
 
 void FlowStatsManager::DeleteReqHandler(boost::shared_ptr<FlowStatsCollectorReq>
@@ -179,6 +184,7 @@ void FlowStatsManager::DeleteReqHandler(boost::shared_ptr<FlowStatsCollectorReq>
     if (flow_aging_table_ptr->CanDelete()) {
         flow_aging_table_map_.erase(it);
         protocol_list_[req->key.proto] = NULL;
+        UpdateScanIdleTime();
     }
 }
 
@@ -197,6 +203,28 @@ void FlowStatsManager::FreeReqHandler(boost::shared_ptr<FlowStatsCollectorReq>
     flow_aging_table_ptr->Shutdown();
     flow_aging_table_map_.erase(it);
     protocol_list_[req->key.proto] = NULL;
+    UpdateScanIdleTime();
+}
+
+// FlowStatsScanner reports flows idle for the minimum ageing time of all
+// aging tables
+void FlowStatsManager::UpdateScanIdleTime() {
+    if (flow_stats_scanner_.get() == NULL) {
+        return;
+    }
+
+    uint64_t age_time = 0;
+    FlowAgingTableMap::iterator it = flow_aging_table_map_.begin();
+    for (; it != flow_aging_table_map_.end(); ++it) {
+        uint64_t value = it->second->GetFlowAgeTime();
+        if (age_time == 0 || value < age_time) {
+            age_time = value;
+        }
+    }
+    if (age_time == 0) {
+        age_time = FlowStatsCollector::FlowAgeTime;
+    }
+    flow_stats_scanner_->set_idle_time(age_time / (1000 * 1000));
 }
 
 void FlowStatsManager::Add(const FlowAgingTableKey &key,
@@ -305,6 +333,7 @@ void FlowStatsManager::AddEvent(FlowEntryPtr &flow) {
     SessionStatsCollector *ssc = NULL;
     ssc = session_stats_collector_obj_->FlowToCollector(flow.get());
     if (ssc) {
+        flow->set_ssc(ssc);
         ssc->AddEvent(flow);
     }
 }
@@ -321,10 +350,12 @@ void FlowStatsManager::DeleteEvent(const FlowEntryPtr &flow,
         flow->set_fsc(NULL);
     }
 
-    SessionStatsCollector *ssc = NULL;
-    ssc = session_stats_collector_obj_->FlowToCollector(flow.get());
+    /* Ignore delete requests if SessionStatsCollector is NULL. Session is
+     * added only on add request, which assigns SessionStatsCollector */
+    SessionStatsCollector *ssc = flow->ssc();
     if (ssc) {
         ssc->DeleteEvent(flow, params);
+        flow->set_ssc(NULL);
     }
 }
 
@@ -345,8 +376,7 @@ void FlowStatsManager::UpdateStatsEvent(const FlowEntryPtr &flow,
 
     fsc->UpdateStatsEvent(flow, bytes, packets, oflow_bytes, u);
 
-    SessionStatsCollector *ssc = NULL;
-    ssc = session_stats_collector_obj_->FlowToCollector(flow.get());
+    SessionStatsCollector *ssc = flow->ssc();
     if (ssc) {
         ssc->UpdateSessionStatsEvent(flow, bytes, packets, oflow_bytes, u);
     }
@@ -400,9 +430,26 @@ void FlowStatsManager::InitDone() {
     AgentProfile *profile = agent_->oper_db()->agent_profile();
     profile->RegisterFlowStatsCb(boost::bind(&FlowStatsManager::SetProfileData,
                                              this, _1));
+
+    uint16_t partitions = agent_->params()->flow_stats_scan_partitions();
+    if (partitions == 0 || agent_->ksync() == NULL) {
+        return;
+    }
+    KSyncFlowMemory *ksync_obj = agent_->ksync()->ksync_flow_memory();
+    if (ksync_obj->flow_table() == NULL) {
+        return;
+    }
+    flow_stats_scanner_.reset(new FlowStatsScanner
+                              (agent_, this, ksync_obj->flow_table(),
+                               ksync_obj->table_entries_count(), partitions));
+    UpdateScanIdleTime();
+    flow_stats_scanner_->InitDone();
 }
 
 void FlowStatsManager::Shutdown() {
+    if (flow_stats_scanner_.get()) {
+        flow_stats_scanner_->Shutdown();
+    }
     default_flow_stats_collector_obj_->Shutdown();
     default_flow_stats_collector_obj_.reset();
     session_stats_collector_obj_->Shutdown();
@@ -5,6 +5,7 @@
 #ifndef vnsw_agent_flow_stats_maanger_h
 #define vnsw_agent_flow_stats_maanger_h
 
+#include <boost/scoped_ptr.hpp>
 #include <cmn/agent_cmn.h>
 #include <cmn/index_vector.h>
 #include <uve/stats_collector.h>
@@ -24,6 +25,7 @@ class FlowStatsCollector;
 class FlowStatsCollectorObject;
 class SessionStatsCollector;
 class SessionStatsCollectorObject;
+class FlowStatsScanner;
 
 struct FlowAgingTableKey {
     FlowAgingTableKey(const uint8_t &protocol, const uint16_t &dst_port):
@@ -92,6 +94,9 @@ public:
     SessionStatsCollectorObject* session_stats_collector_obj() {
         return session_stats_collector_obj_.get();
     }
+    FlowStatsScanner *flow_stats_scanner() {
+        return flow_stats_scanner_.get();
+    }
 
     //Add protocol + port based flow aging table
     void Add(const FlowAgingTableKey &key,
@@ -199,6 +204,7 @@ private:
     friend class FlowStatsCollector;
     friend class SessionStatsCollector;
     bool UpdateSessionThreshold(void);
+    void UpdateScanIdleTime();
     void UpdateThreshold(uint64_t new_value, bool check_oflow);
     FlowStatsCollectorObject* GetFlowStatsCollectorObject(const FlowEntry *flow)
         const;
@@ -207,6 +213,7 @@ private:
     FlowAgingTableMap flow_aging_table_map_;
     FlowAgingTablePtr default_flow_stats_collector_obj_;
     SessionStatsCollectorPtr session_stats_collector_obj_;
+    boost::scoped_ptr<FlowStatsScanner> flow_stats_scanner_;
     uint64_t prev_flow_export_rate_compute_time_;
     uint64_t threshold_;
     uint32_t prev_cfg_flow_export_rate_;
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <base/time_util.h>
+#include <cmn/agent_cmn.h>
+#include <pkt/flow_entry.h>
+#include <vrouter/ksync/ksync_init.h>
+#include <vrouter/ksync/ksync_flow_index_manager.h>
+#include <vrouter/flow_stats/flow_stats_collector.h>
+#include <vrouter/flow_stats/flow_stats_manager.h>
+#include <vrouter/flow_stats/flow_stats_scanner.h>
+
+#include <vr_types.h>
+#include <vr_flow.h>
+
+const uint32_t FlowStatsScanner::kChunkSize;
+const uint32_t FlowStatsScanner::kEntriesPerTask;
+const uint32_t FlowStatsScanner::kMinEntriesPerTimer;
+
+FlowStatsScanner::FlowStatsScanner(Agent *agent, FlowStatsManager *mgr,
+                                   const vr_flow_entry *table, uint32_t count,
+                                   uint16_t partitions) :
+    StatsCollector(agent->task_scheduler()->GetTaskId(kTaskFlowStatsScan),
+                   -1, *(agent->event_manager()->io_service()),
+                   FlowStatsCollector::kFlowStatsTimerInterval,
+                   "Flow stats scanner"),
+    agent_(agent), flow_stats_manager_(mgr),
+    task_id_(agent->task_scheduler()->GetTaskId(kTaskFlowStatsScan)),
+    table_(table), count_(count), timers_per_scan_(1) {
+    assert(partitions > 0);
+    uint32_t size = ((count + kChunkSize - 1) / kChunkSize) * kChunkSize;
+    packets_.resize(size, 0);
+    bytes_.resize(size, 0);
+    gen_id_.resize(size, 0);
+    // Entries are seen idle on first scan, so that every flow is visited
+    // once on start
+    last_change_.resize(size, 0);
+
+    // Partitions start at chunk boundary
+    uint32_t chunks = size / kChunkSize;
+    uint32_t per_partition = ((chunks + partitions - 1) / partitions) *
+        kChunkSize;
+    for (uint16_t i = 0; i < partitions; i++) {
+        Partition partition;
+        partition.start = std::min(count, i * per_partition);
+        partition.end = std::min(count, partition.start + per_partition);
+        partition.next = partition.start;
+        partitions_.push_back(partition);
+    }
+
+    idle_time_ = FlowStatsCollector::FlowAgeTime / (1000 * 1000);
+    candidates_ = 0;
+    UpdateTimersPerScan();
+}
+
+FlowStatsScanner::~FlowStatsScanner() {
+}
+
+void FlowStatsScanner::Shutdown() {
+    StatsCollector::Shutdown();
+}
+
+uint32_t FlowStatsScanner::GetCurrentTime() const {
+    return UTCTimestampUsec() / (1000 * 1000);
+}
+
+void FlowStatsScanner::set_idle_time(uint32_t secs) {
+    idle_time_ = secs;
+}
+
+// Scan complete table in kFlowScanTime percent of the idle time. Same as
+// FlowStatsCollector::TimersPerScan
+void FlowStatsScanner::UpdateTimersPerScan() {
+    uint64_t scan_time_millisec = (uint64_t)idle_time_ * 1000;
+    scan_time_millisec = (scan_time_millisec *
+                          FlowStatsCollector::kFlowScanTime) / 100;
+    if (scan_time_millisec < FlowStatsCollector::kFlowStatsTimerInterval) {
+        scan_time_millisec = FlowStatsCollector::kFlowStatsTimerInterval;
+    }
+    timers_per_scan_ =
+        scan_time_millisec / FlowStatsCollector::kFlowStatsTimerInterval;
+}
+
+void FlowStatsScanner::UpdateEntriesToVisit(Partition *partition) {
+    uint32_t size = partition->end - partition->start;
+    partition->entries_to_visit += size / timers_per_scan_;
+    if (partition->entries_to_visit < kMinEntriesPerTimer)
+        partition->entries_to_visit = kMinEntriesPerTimer;
+    if (partition->entries_to_visit > size)
+        partition->entries_to_visit = size;
+}
+
+// Timer fired. Update entries to visit in every partition and start the scan
+// task for partitions not already running
+bool FlowStatsScanner::Run() {
+    UpdateTimersPerScan();
+    for (uint16_t i = 0; i < partitions_.size(); i++) {
+        Partition *partition = &partitions_[i];
+        if (partition->start == partition->end)
+            continue;
+
+        UpdateEntriesToVisit(partition);
+        if (partition->task == NULL) {
+            partition->task = new ScanTask(this, i);
+            agent_->task_scheduler()->Enqueue(partition->task);
+        }
+    }
+    return true;
+}
+
+bool FlowStatsScanner::RunScanTask(uint16_t idx) {
+    Partition *partition = &partitions_[idx];
+    uint32_t start = partition->next;
+    uint32_t end = start + std::min(kEntriesPerTask,
+                                    partition->entries_to_visit);
+    // Scan complete chunks, see Scan
+    end = ((end + kChunkSize - 1) / kChunkSize) * kChunkSize;
+    if (end > partition->end)
+        end = partition->end;
+
+    candidates_ += Scan(start, end, GetCurrentTime());
+
+    uint32_t visited = end - start;
+    if (visited < partition->entries_to_visit)
+        partition->entries_to_visit -= visited;
+    else
+        partition->entries_to_visit = 0;
+
+    partition->next = end;
+    if (partition->next >= partition->end) {
+        partition->next = partition->start;
+        partition->scans++;
+    }
+
+    if (partition->entries_to_visit == 0) {
+        partition->task = NULL;
+        return true;
+    }
+    return false;
+}
+
+uint32_t FlowStatsScanner::Scan(uint32_t start, uint32_t end, uint32_t now) {
+    const uint32_t idle_time = idle_time_;
+    uint32_t dispatched = 0;
+    uint32_t flags[kChunkSize];
+    uint32_t packets[kChunkSize];
+    uint32_t bytes[kChunkSize];
+    uint32_t gen_id[kChunkSize];
+
+    for (uint32_t base = start; base < end; base += kChunkSize) {
+        uint32_t n = std::min(kChunkSize, end - base);
+
+        // Gather fields of interest from the chunk. Entries past end are
+        // treated as inactive
+        for (uint32_t i = 0; i < n; i++) {
+            const vr_flow_entry *kflow = &table_[base + i];
+            flags[i] = kflow->fe_flags;
+            packets[i] = kflow->fe_stats.flow_packets;
+            bytes[i] = kflow->fe_stats.flow_bytes;
+            gen_id[i] = kflow->fe_gen_id;
+        }
+        for (uint32_t i = n; i < kChunkSize; i++) {
+            flags[i] = packets[i] = bytes[i] = gen_id[i] = 0;
+        }
+
+        // Compare with shadow and compute bitmap of candidates. The loop has
+        // no branches and works on complete chunks so that it vectorizes
+        uint32_t *s_packets = &packets_[base];
+        uint32_t *s_bytes = &bytes_[base];
+        uint32_t *s_gen_id = &gen_id_[base];
+        uint32_t *s_last_change = &last_change_[base];
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < kChunkSize; i++) {
+            uint32_t active = (flags[i] & VR_FLOW_FLAG_ACTIVE) ? 1 : 0;
+            uint32_t evicted = (flags[i] & VR_FLOW_FLAG_EVICTED) ? 1 : 0;
+            uint32_t changed = ((packets[i] ^ s_packets[i]) |
+                                (bytes[i] ^ s_bytes[i]) |
+                                (gen_id[i] ^ s_gen_id[i])) ? 1 : 0;
+            uint32_t idle = ((now - s_last_change[i]) >= idle_time) ? 1 : 0;
+            s_packets[i] = packets[i];
+            s_bytes[i] = bytes[i];
+            s_gen_id[i] = gen_id[i];
+            s_last_change[i] = changed ? now : s_last_change[i];
+            mask |= (active & (changed | idle | evicted)) << i;
+        }
+
+        for (uint32_t i = 0; mask != 0; i++, mask >>= 1) {
+            if ((mask & 0x1) == 0)
+                continue;
+            // Restart idle time so that an idle flow not aged is dispatched
+            // again only after another idle_time
+            s_last_change[i] = now;
+            Dispatch(base + i);
+            dispatched++;
+        }
+    }
+    return dispatched;
+}
+
+void FlowStatsScanner::Dispatch(uint32_t idx) {
+    KSyncFlowIndexManager *imgr = agent_->ksync()->ksync_flow_index_manager();
+    FlowEntryPtr flow = imgr->FindByIndex(idx);
+    if (flow.get() == NULL)
+        return;
+
+    FlowStatsCollector *fsc = flow->fsc();
+    if (fsc == NULL)
+        return;
+    fsc->AgeEvent(flow);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// ScanTask methods
+/////////////////////////////////////////////////////////////////////////////
+FlowStatsScanner::ScanTask::ScanTask(FlowStatsScanner *scanner,
+                                     uint16_t partition) :
+    Task(scanner->task_id_, partition), scanner_(scanner),
+    partition_(partition) {
+}
+
+FlowStatsScanner::ScanTask::~ScanTask() {
+}
+
+std::string FlowStatsScanner::ScanTask::Description() const {
+    return "Flow Stats Scanner Task";
+}
+
+bool FlowStatsScanner::ScanTask::Run() {
+    return scanner_->RunScanTask(partition_);
+}
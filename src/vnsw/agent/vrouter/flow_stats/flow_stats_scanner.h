@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_flow_stats_scanner_h
+#define vnsw_agent_flow_stats_scanner_h
+
+#include <vector>
+#include <tbb/atomic.h>
+#include <base/task.h>
+#include <cmn/agent_cmn.h>
+#include <uve/stats_collector.h>
+
+struct vr_flow_entry;
+class FlowStatsManager;
+
+// Ages flows by scanning the vrouter flow table in index order, instead of
+// walking the flow list of every FlowStatsCollector and reading the
+// vr_flow_entry of each flow at random.
+//
+// The table is split into partitions of contiguous indices. Each partition is
+// scanned by a Flow::StatsScan task, with the partition number as instance,
+// so that partitions are scanned in parallel.
+//
+// A partition is read in chunks of kChunkSize entries. The packet and byte
+// counters of a chunk are compared with a shadow copy kept for every entry,
+// with loops free of branches so that the compiler can vectorize them. An
+// entry is a candidate if it is active and,
+//   - its counters or gen-id changed since last scan
+//   - it did not change for the minimum ageing time of all collectors
+//   - it is marked evicted by vrouter
+// Only candidates are passed to the FlowStatsCollector owning the flow, which
+// runs the regular eviction and ageing checks on it. Flows that did not change
+// and are not idle long enough are not looked at.
+//
+// The timer adds the number of entries to visit to every partition so that
+// the table is scanned once in kFlowScanTime percent of the minimum ageing
+// time, and starts the scan of partitions not already running. The timer runs
+// in Flow::StatsScan task without instance and is mutually exclusive with the
+// partition scans.
+class FlowStatsScanner : public StatsCollector {
+public:
+    // Entries read and compared in one pass. Matches a cache line of the
+    // uint32_t shadow counters
+    static const uint32_t kChunkSize = 16;
+    // Number of entries to scan per task run
+    static const uint32_t kEntriesPerTask = 8192;
+    // Minimum entries to visit per timer in a partition
+    static const uint32_t kMinEntriesPerTimer = 4096;
+
+    class ScanTask : public Task {
+    public:
+        ScanTask(FlowStatsScanner *scanner, uint16_t partition);
+        virtual ~ScanTask();
+        bool Run();
+        std::string Description() const;
+    private:
+        FlowStatsScanner *scanner_;
+        uint16_t partition_;
+    };
+
+    struct Partition {
+        Partition() : start(0), end(0), next(0), entries_to_visit(0),
+            task(NULL), scans(0) {
+        }
+
+        uint32_t start;
+        uint32_t end;
+        // Index to scan next
+        uint32_t next;
+        uint32_t entries_to_visit;
+        ScanTask *task;
+        uint64_t scans;
+    };
+
+    FlowStatsScanner(Agent *agent, FlowStatsManager *mgr,
+                     const vr_flow_entry *table, uint32_t count,
+                     uint16_t partitions);
+    virtual ~FlowStatsScanner();
+
+    bool Run();
+    void Shutdown();
+
+    // Scan entries [start, end) of the table. start must be at a chunk
+    // boundary, and end at a chunk boundary or at end of table, since shadow
+    // of complete chunks is updated. Returns number of candidates dispatched
+    uint32_t Scan(uint32_t start, uint32_t end, uint32_t now);
+    bool RunScanTask(uint16_t partition);
+
+    // Minimum ageing time across the FlowStatsCollectors, in seconds
+    uint32_t idle_time() const { return idle_time_; }
+    void set_idle_time(uint32_t secs);
+
+    uint32_t count() const { return count_; }
+    uint16_t partition_count() const { return partitions_.size(); }
+    const Partition &partition(uint16_t idx) const { return partitions_[idx]; }
+    uint32_t timers_per_scan() const { return timers_per_scan_; }
+    uint64_t candidates() const { return candidates_; }
+
+protected:
+    // Pass the flow at index to the FlowStatsCollector owning it
+    virtual void Dispatch(uint32_t idx);
+    virtual uint32_t GetCurrentTime() const;
+
+private:
+    void UpdateTimersPerScan();
+    void UpdateEntriesToVisit(Partition *partition);
+
+    Agent *agent_;
+    FlowStatsManager *flow_stats_manager_;
+    int task_id_;
+    const vr_flow_entry *table_;
+    uint32_t count_;
+    std::vector<Partition> partitions_;
+    // Shadow of vrouter counters, indexed by flow index. Sized in multiple
+    // of kChunkSize so that the compare loop works on complete chunks
+    std::vector<uint32_t> packets_;
+    std::vector<uint32_t> bytes_;
+    std::vector<uint32_t> gen_id_;
+    // Time in seconds at which counters of entry last changed
+    std::vector<uint32_t> last_change_;
+    tbb::atomic<uint32_t> idle_time_;
+    uint32_t timers_per_scan_;
+    tbb::atomic<uint64_t> candidates_;
+    DISALLOW_COPY_AND_ASSIGN(FlowStatsScanner);
+};
+
+#endif // vnsw_agent_flow_stats_scanner_h
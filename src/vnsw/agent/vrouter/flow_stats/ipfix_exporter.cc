@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <base/logging.h>
+#include <base/time_util.h>
+#include <vrouter/flow_stats/ipfix_exporter.h>
+
+using boost::asio::ip::udp;
+
+const uint16_t IpfixExporter::kVersion;
+const uint16_t IpfixExporter::kMinMtu;
+const uint16_t IpfixExporter::kMessageHeaderLen;
+const uint16_t IpfixExporter::kSetHeaderLen;
+const uint16_t IpfixExporter::kTemplateSetId;
+const uint16_t IpfixExporter::kIpv4TemplateId;
+const uint16_t IpfixExporter::kIpv6TemplateId;
+
+IpfixExporter::IpfixExporter(boost::asio::io_service &io,
+                             const IpAddress &collector, uint16_t port,
+                             uint32_t domain_id, uint16_t mtu) :
+    endpoint_(collector, port), socket_(new udp::socket(io)),
+    domain_id_(domain_id), mtu_(mtu), buffer_(mtu), len_(0), set_offset_(0),
+    set_id_(0), sequence_(0), pending_records_(0),
+    template_refresh_interval_(kDefaultTemplateRefreshInterval),
+    last_template_time_(0), template_sent_(false), messages_sent_(0),
+    records_sent_(0), records_dropped_(0), send_errors_(0) {
+    assert(mtu_ >= kMinMtu);
+    boost::system::error_code ec;
+    socket_->open(collector.is_v6() ? udp::v6() : udp::v4(), ec);
+    if (ec) {
+        LOG(ERROR, "Error opening IPFIX export socket : " << ec.message());
+    }
+}
+
+IpfixExporter::~IpfixExporter() {
+    boost::system::error_code ec;
+    socket_->close(ec);
+}
+
+uint32_t IpfixExporter::ExportTime() const {
+    return UTCTimestampUsec() / 1000000;
+}
+
+void IpfixExporter::Send(const uint8_t *data, size_t len) {
+    boost::system::error_code ec;
+    socket_->send_to(boost::asio::buffer(data, len), endpoint_, 0, ec);
+    if (ec) {
+        send_errors_++;
+        return;
+    }
+    messages_sent_++;
+}
+
+void IpfixExporter::Put8(uint8_t value) {
+    buffer_[len_++] = value;
+}
+
+void IpfixExporter::Put16(uint16_t value) {
+    Put16At(len_, value);
+    len_ += 2;
+}
+
+void IpfixExporter::Put32(uint32_t value) {
+    Put32At(len_, value);
+    len_ += 4;
+}
+
+void IpfixExporter::Put64(uint64_t value) {
+    Put32(value >> 32);
+    Put32(value & 0xFFFFFFFF);
+}
+
+void IpfixExporter::Put16At(size_t offset, uint16_t value) {
+    buffer_[offset] = value >> 8;
+    buffer_[offset + 1] = value & 0xFF;
+}
+
+void IpfixExporter::Put32At(size_t offset, uint32_t value) {
+    Put16At(offset, value >> 16);
+    Put16At(offset + 2, value & 0xFFFF);
+}
+
+size_t IpfixExporter::VariableLen(const std::string *str) {
+    size_t len = str ? str->size() : 0;
+    return (len < 255) ? (len + 1) : (len + 3);
+}
+
+size_t IpfixExporter::DataRecordLen(const IpfixFlowRecord &record) const {
+    size_t addr_len = record.src_ip.is_v6() ? 16 : 4;
+    return (2 * addr_len) + 2 + 2 + 1 + 2 + (6 * 8) + 1 +
+        VariableLen(record.src_vn) + VariableLen(record.dst_vn);
+}
+
+void IpfixExporter::StartSet(uint16_t set_id) {
+    EndSet();
+    set_offset_ = len_;
+    set_id_ = set_id;
+    Put16(set_id);
+    Put16(0);
+}
+
+void IpfixExporter::EndSet() {
+    if (set_offset_ == 0) {
+        return;
+    }
+    Put16At(set_offset_ + 2, len_ - set_offset_);
+    set_offset_ = 0;
+}
+
+void IpfixExporter::EncodeField(uint16_t id, uint16_t len) {
+    Put16(id);
+    Put16(len);
+}
+
+void IpfixExporter::EncodeEnterpriseField(uint16_t id, uint16_t len,
+                                          uint32_t pen) {
+    Put16(id | kEnterpriseBit);
+    Put16(len);
+    Put32(pen);
+}
+
+void IpfixExporter::EncodeTemplate(uint16_t template_id) {
+    bool ipv6 = (template_id == kIpv6TemplateId);
+    Put16(template_id);
+    Put16(15);
+    if (ipv6) {
+        EncodeField(SOURCE_IPV6_ADDRESS, 16);
+        EncodeField(DESTINATION_IPV6_ADDRESS, 16);
+    } else {
+        EncodeField(SOURCE_IPV4_ADDRESS, 4);
+        EncodeField(DESTINATION_IPV4_ADDRESS, 4);
+    }
+    EncodeField(SOURCE_TRANSPORT_PORT, 2);
+    EncodeField(DESTINATION_TRANSPORT_PORT, 2);
+    EncodeField(PROTOCOL_IDENTIFIER, 1);
+    EncodeField(TCP_CONTROL_BITS, 2);
+    EncodeField(OCTET_DELTA_COUNT, 8);
+    EncodeField(PACKET_DELTA_COUNT, 8);
+    EncodeEnterpriseField(OCTET_DELTA_COUNT, 8, kReversePen);
+    EncodeEnterpriseField(PACKET_DELTA_COUNT, 8, kReversePen);
+    EncodeField(FLOW_START_MILLISECONDS, 8);
+    EncodeField(FLOW_END_MILLISECONDS, 8);
+    EncodeField(FLOW_END_REASON, 1);
+    EncodeEnterpriseField(SOURCE_VN_NAME, kVariableLength, kJuniperPen);
+    EncodeEnterpriseField(DESTINATION_VN_NAME, kVariableLength, kJuniperPen);
+}
+
+void IpfixExporter::StartMessage() {
+    len_ = kMessageHeaderLen;
+    set_offset_ = 0;
+    set_id_ = 0;
+    uint32_t now = ExportTime();
+    if (template_sent_ &&
+        (now - last_template_time_) < template_refresh_interval_) {
+        return;
+    }
+    StartSet(kTemplateSetId);
+    EncodeTemplate(kIpv4TemplateId);
+    EncodeTemplate(kIpv6TemplateId);
+    EndSet();
+    template_sent_ = true;
+    last_template_time_ = now;
+}
+
+void IpfixExporter::EncodeAddress(const IpAddress &addr) {
+    if (addr.is_v6()) {
+        Ip6Address::bytes_type bytes = addr.to_v6().to_bytes();
+        std::copy(bytes.begin(), bytes.end(), buffer_.begin() + len_);
+        len_ += bytes.size();
+    } else {
+        Put32(addr.to_v4().to_ulong());
+    }
+}
+
+void IpfixExporter::EncodeString(const std::string *str) {
+    size_t len = str ? str->size() : 0;
+    if (len < 255) {
+        Put8(len);
+    } else {
+        Put8(255);
+        Put16(len);
+    }
+    if (len) {
+        std::copy(str->begin(), str->end(), buffer_.begin() + len_);
+        len_ += len;
+    }
+}
+
+void IpfixExporter::EncodeRecord(const IpfixFlowRecord &record) {
+    EncodeAddress(record.src_ip);
+    EncodeAddress(record.dst_ip);
+    Put16(record.src_port);
+    Put16(record.dst_port);
+    Put8(record.protocol);
+    Put16(record.tcp_flags);
+    Put64(record.octets);
+    Put64(record.packets);
+    Put64(record.reverse_octets);
+    Put64(record.reverse_packets);
+    Put64(record.start_msec);
+    Put64(record.end_msec);
+    Put8(record.end_reason);
+    EncodeString(record.src_vn);
+    EncodeString(record.dst_vn);
+}
+
+bool IpfixExporter::Add(const IpfixFlowRecord &record) {
+    uint16_t template_id = record.src_ip.is_v6() ? kIpv6TemplateId :
+        kIpv4TemplateId;
+    size_t record_len = DataRecordLen(record);
+    size_t set_len = (set_offset_ && set_id_ == template_id) ? 0 :
+        kSetHeaderLen;
+    if (len_ && (len_ + set_len + record_len) > mtu_) {
+        Flush();
+    }
+    if (len_ == 0) {
+        StartMessage();
+    }
+    set_len = (set_offset_ && set_id_ == template_id) ? 0 : kSetHeaderLen;
+    if ((len_ + set_len + record_len) > mtu_) {
+        records_dropped_++;
+        return false;
+    }
+    if (set_len) {
+        StartSet(template_id);
+    }
+    EncodeRecord(record);
+    pending_records_++;
+    return true;
+}
+
+void IpfixExporter::Flush() {
+    if (len_ == 0) {
+        return;
+    }
+    EndSet();
+    Put16At(0, kVersion);
+    Put16At(2, len_);
+    Put32At(4, ExportTime());
+    Put32At(8, sequence_);
+    Put32At(12, domain_id_);
+    Send(&buffer_[0], len_);
+
+    // Sequence number counts data records, modulo 2^32
+    sequence_ += pending_records_;
+    records_sent_ += pending_records_;
+    pending_records_ = 0;
+    len_ = 0;
+    set_id_ = 0;
+}
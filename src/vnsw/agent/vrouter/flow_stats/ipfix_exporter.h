@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_ipfix_exporter_h
+#define vnsw_agent_ipfix_exporter_h
+
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <net/address.h>
+#include <base/util.h>
+
+// Flow record handed to IpfixExporter. It only refers to data owned by the
+// caller, the record is encoded into the export buffer by IpfixExporter::Add
+// and is not retained.
+struct IpfixFlowRecord {
+    IpAddress src_ip;
+    IpAddress dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t protocol;
+    uint16_t tcp_flags;
+    uint64_t octets;
+    uint64_t packets;
+    uint64_t reverse_octets;
+    uint64_t reverse_packets;
+    uint64_t start_msec;
+    uint64_t end_msec;
+    uint8_t end_reason;
+    const std::string *src_vn;
+    const std::string *dst_vn;
+
+    IpfixFlowRecord() : src_ip(), dst_ip(), src_port(0), dst_port(0),
+        protocol(0), tcp_flags(0), octets(0), packets(0), reverse_octets(0),
+        reverse_packets(0), start_msec(0), end_msec(0), end_reason(0),
+        src_vn(NULL), dst_vn(NULL) {
+    }
+};
+
+// Encodes flow records as IPFIX (RFC 7011) data records and exports them to
+// a collector over UDP. Records are written directly into a buffer of mtu
+// bytes, which is sent as one IPFIX message when the next record does not
+// fit or when Flush() is called. Templates are sent in the first message and
+// refreshed every template_refresh_interval seconds, as required for UDP
+// transport. Reverse counters use the RFC 5103 reverse information elements.
+//
+// Not thread safe, each SessionStatsCollector instance owns an exporter and
+// uses its instance id as observation domain.
+class IpfixExporter {
+public:
+    static const uint16_t kVersion = 10;
+    static const uint16_t kMinMtu = 512;
+    static const uint16_t kMessageHeaderLen = 16;
+    static const uint16_t kSetHeaderLen = 4;
+    static const uint16_t kTemplateSetId = 2;
+    static const uint16_t kIpv4TemplateId = 256;
+    static const uint16_t kIpv6TemplateId = 257;
+    static const uint16_t kVariableLength = 0xFFFF;
+    static const uint16_t kEnterpriseBit = 0x8000;
+    static const uint32_t kReversePen = 29305;
+    static const uint32_t kJuniperPen = 2636;
+    static const uint32_t kDefaultTemplateRefreshInterval = 60;
+
+    // Information element ids
+    enum ElementId {
+        OCTET_DELTA_COUNT = 1,
+        PACKET_DELTA_COUNT = 2,
+        PROTOCOL_IDENTIFIER = 4,
+        TCP_CONTROL_BITS = 6,
+        SOURCE_TRANSPORT_PORT = 7,
+        SOURCE_IPV4_ADDRESS = 8,
+        DESTINATION_TRANSPORT_PORT = 11,
+        DESTINATION_IPV4_ADDRESS = 12,
+        SOURCE_IPV6_ADDRESS = 27,
+        DESTINATION_IPV6_ADDRESS = 28,
+        FLOW_END_REASON = 136,
+        FLOW_START_MILLISECONDS = 152,
+        FLOW_END_MILLISECONDS = 153,
+        // Enterprise specific, kJuniperPen
+        SOURCE_VN_NAME = 1,
+        DESTINATION_VN_NAME = 2,
+    };
+
+    // flowEndReason values
+    enum EndReason {
+        IDLE_TIMEOUT = 1,
+        ACTIVE_TIMEOUT = 2,
+        END_OF_FLOW = 3,
+        FORCED_END = 4,
+    };
+
+    IpfixExporter(boost::asio::io_service &io, const IpAddress &collector,
+                  uint16_t port, uint32_t domain_id, uint16_t mtu);
+    virtual ~IpfixExporter();
+
+    // Encode the record into the export buffer. Returns false if the record
+    // cannot fit in an empty message
+    bool Add(const IpfixFlowRecord &record);
+    // Send the pending message, if any
+    void Flush();
+
+    uint16_t mtu() const { return mtu_; }
+    uint32_t domain_id() const { return domain_id_; }
+    uint32_t sequence() const { return sequence_; }
+    uint64_t messages_sent() const { return messages_sent_; }
+    uint64_t records_sent() const { return records_sent_; }
+    uint64_t records_dropped() const { return records_dropped_; }
+    uint64_t send_errors() const { return send_errors_; }
+    uint32_t pending_records() const { return pending_records_; }
+    void set_template_refresh_interval(uint32_t secs) {
+        template_refresh_interval_ = secs;
+    }
+
+protected:
+    virtual uint32_t ExportTime() const;
+    virtual void Send(const uint8_t *data, size_t len);
+
+private:
+    static size_t VariableLen(const std::string *str);
+    size_t DataRecordLen(const IpfixFlowRecord &record) const;
+    void StartMessage();
+    void EncodeTemplate(uint16_t template_id);
+    void EncodeField(uint16_t id, uint16_t len);
+    void EncodeEnterpriseField(uint16_t id, uint16_t len, uint32_t pen);
+    void StartSet(uint16_t set_id);
+    void EndSet();
+    void EncodeRecord(const IpfixFlowRecord &record);
+    void EncodeAddress(const IpAddress &addr);
+    void EncodeString(const std::string *str);
+    void Put8(uint8_t value);
+    void Put16(uint16_t value);
+    void Put32(uint32_t value);
+    void Put64(uint64_t value);
+    void Put16At(size_t offset, uint16_t value);
+    void Put32At(size_t offset, uint32_t value);
+
+    boost::asio::ip::udp::endpoint endpoint_;
+    boost::scoped_ptr<boost::asio::ip::udp::socket> socket_;
+    uint32_t domain_id_;
+    uint16_t mtu_;
+    std::vector<uint8_t> buffer_;
+    size_t len_;
+    // Offset of the header of the data set being filled, 0 if none
+    size_t set_offset_;
+    uint16_t set_id_;
+    uint32_t sequence_;
+    uint32_t pending_records_;
+    uint32_t template_refresh_interval_;
+    uint32_t last_template_time_;
+    bool template_sent_;
+    uint64_t messages_sent_;
+    uint64_t records_sent_;
+    uint64_t records_dropped_;
+    uint64_t send_errors_;
+
+    DISALLOW_COPY_AND_ASSIGN(IpfixExporter);
+};
+
+#endif // vnsw_agent_ipfix_exporter_h
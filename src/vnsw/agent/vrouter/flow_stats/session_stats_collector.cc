@@ -48,7 +48,8 @@ SessionStatsCollector::SessionStatsCollector(boost::asio::io_service &io,
                        MAX_SSC_REQUEST_QUEUE_ITERATIONS ),
         session_msg_list_(agent_uve_->agent()->params()->max_endpoints_per_session_msg(),
                           SessionEndpoint()),
-        session_msg_index_(0), instance_id_(instance_id),
+        session_msg_pending_(), session_msg_index_(0),
+        instance_id_(instance_id),
         flow_stats_manager_(aging_module), parent_(obj), session_task_(NULL),
         current_time_(GetCurrentTime()), session_task_starts_(0) {
         request_queue_.set_name("Session stats collector event queue");
@@ -59,11 +60,17 @@ SessionStatsCollector::SessionStatsCollector(boost::asio::io_service &io,
         request_queue_.SetExitCallback
             (boost::bind(&SessionStatsCollector::RequestHandlerExit, this, _1));
         request_queue_.SetBounded(true);
+        const AgentParam *params = agent_uve_->agent()->params();
+        if (params->ipfix_export_enabled()) {
+            ipfix_exporter_.reset(new IpfixExporter
+                                  (io, params->ipfix_collector(),
+                                   params->ipfix_collector_port(),
+                                   instance_id, params->ipfix_mtu()));
+        }
         InitDone();
 }
 
 SessionStatsCollector::~SessionStatsCollector() {
-    flow_stats_manager_->FreeIndex(instance_id_);
 }
 
 uint64_t SessionStatsCollector::GetCurrentTime() {
@@ -224,22 +231,62 @@ void SessionStatsCollector::EnqueueSessionMsg() {
     }
 }
 
+// Dispatch the partially filled message list. The filled entries are copied
+// into session_msg_pending_, which keeps its capacity across dispatches, so
+// the preallocated entries in session_msg_list_ are left in place.
 void SessionStatsCollector::DispatchPendingSessionMsg() {
     if (session_msg_index_ == 0) {
         return;
     }
 
-    vector<SessionEndpoint>::const_iterator first = session_msg_list_.begin();
-    vector<SessionEndpoint>::const_iterator last = session_msg_list_.begin() +
-                                                    session_msg_index_;
-    vector<SessionEndpoint> new_list(first, last);
-    DispatchSessionMsg(new_list);
+    session_msg_pending_.assign(session_msg_list_.begin(),
+                                session_msg_list_.begin() +
+                                session_msg_index_);
+    DispatchSessionMsg(session_msg_pending_);
     session_msg_index_ = 0;
 }
 
+// Clear the entry in place, so that the strings and containers of the
+// preallocated entry keep their storage for the next endpoint.
+void SessionStatsCollector::ClearSessionEndpoint(SessionEndpoint *ep) {
+    ep->vmi.clear();
+    ep->vn.clear();
+    ep->deployment.clear();
+    ep->tier.clear();
+    ep->application.clear();
+    ep->site.clear();
+    ep->labels.clear();
+    ep->custom_tags.clear();
+    ep->remote_deployment.clear();
+    ep->remote_tier.clear();
+    ep->remote_application.clear();
+    ep->remote_site.clear();
+    ep->remote_labels.clear();
+    ep->remote_custom_tags.clear();
+    ep->security_policy_rule.clear();
+    ep->remote_vn.clear();
+    ep->is_client_session = 0;
+    ep->is_si = 0;
+    ep->remote_prefix.clear();
+    ep->sess_agg_info.clear();
+    ep->__isset.deployment = false;
+    ep->__isset.tier = false;
+    ep->__isset.application = false;
+    ep->__isset.site = false;
+    ep->__isset.labels = false;
+    ep->__isset.custom_tags = false;
+    ep->__isset.remote_deployment = false;
+    ep->__isset.remote_tier = false;
+    ep->__isset.remote_application = false;
+    ep->__isset.remote_site = false;
+    ep->__isset.remote_labels = false;
+    ep->__isset.remote_custom_tags = false;
+    ep->__isset.security_policy_rule = false;
+    ep->__isset.remote_prefix = false;
+}
+
 uint8_t SessionStatsCollector::GetSessionMsgIdx() {
-    SessionEndpoint &obj = session_msg_list_[session_msg_index_];
-    obj = SessionEndpoint();
+    ClearSessionEndpoint(&session_msg_list_[session_msg_index_]);
     return session_msg_index_;
 }
 
@@ -1671,6 +1718,71 @@ void SessionStatsCollector::FillSessionInfoUnlocked
     }
 }
 
+/*
+ * Encode the session directly as an IPFIX data record. Client of the session
+ * is reported as source, counters of the forward flow as forward counters.
+ * Export stats are updated in the same way as FillSessionInfoUnlocked.
+ */
+void SessionStatsCollector::ExportSessionIpfix
+    (const SessionEndpointMap::iterator &it,
+     SessionEndpointInfo::SessionAggMap::iterator session_agg_map_iter,
+     SessionPreAggInfo::SessionMap::iterator session_map_iter,
+     const SessionStatsParams &stats) {
+    const SessionEndpointKey &ep_key = it->first;
+    const SessionAggKey &agg_key = session_agg_map_iter->first;
+    const SessionKey &key = session_map_iter->first;
+    SessionStatsInfo &info = session_map_iter->second;
+
+    bool first_time_export = !info.exported_atleast_once;
+    info.exported_atleast_once = true;
+
+    IpfixFlowRecord record;
+    const SessionStatsParams *real_stats = &stats;
+    if (info.evicted) {
+        real_stats = &info.evict_stats;
+        record.end_reason = IpfixExporter::FORCED_END;
+    } else if (info.deleted) {
+        real_stats = &info.del_stats;
+        record.end_reason = IpfixExporter::END_OF_FLOW;
+    } else {
+        record.end_reason = IpfixExporter::ACTIVE_TIMEOUT;
+    }
+    flow_stats_manager_->UpdateSessionExportStats(1, first_time_export,
+                                                  real_stats->sampled);
+
+    if (ep_key.is_client_session) {
+        record.src_ip = agg_key.local_ip;
+        record.dst_ip = key.remote_ip;
+        record.src_vn = &ep_key.local_vn;
+        record.dst_vn = &ep_key.remote_vn;
+    } else {
+        record.src_ip = key.remote_ip;
+        record.dst_ip = agg_key.local_ip;
+        record.src_vn = &ep_key.remote_vn;
+        record.dst_vn = &ep_key.local_vn;
+    }
+    record.src_port = key.client_port;
+    record.dst_port = agg_key.server_port;
+    record.protocol = agg_key.proto;
+    if (real_stats->fwd_flow.valid) {
+        record.tcp_flags = real_stats->fwd_flow.tcp_flags;
+        record.octets = real_stats->fwd_flow.diff_bytes;
+        record.packets = real_stats->fwd_flow.diff_packets;
+    }
+    /* Evict stats for reverse flow is not supported yet */
+    if (!info.evicted && real_stats->rev_flow.valid) {
+        record.reverse_octets = real_stats->rev_flow.diff_bytes;
+        record.reverse_packets = real_stats->rev_flow.diff_packets;
+    }
+    record.start_msec = info.setup_time / 1000;
+    if (info.teardown_time) {
+        record.end_msec = info.teardown_time / 1000;
+    } else {
+        record.end_msec = GetCurrentTime() / 1000;
+    }
+    ipfix_exporter_->Add(record);
+}
+
 void SessionStatsCollector::UpdateAggregateStats(const SessionInfo &sinfo,
                                                  SessionAggInfo *agg_info,
                                                  bool is_sampling,
@@ -1792,12 +1904,19 @@ bool SessionStatsCollector::ProcessSessionEndpoint
     bool exit = false, ep_completed = true;
 
     SessionEndpoint &session_ep = session_msg_list_[GetSessionMsgIdx()];
+    bool ipfix_export = (ipfix_exporter_.get() != NULL);
 
     session_agg_map_iter = it->second.session_agg_map_.
         lower_bound(session_agg_iteration_key_);
     while (session_agg_map_iter != it->second.session_agg_map_.end()) {
-        SessionAggInfo session_agg_info;
+        // Aggregate info is built in place in the preallocated message. No
+        // message is built when sessions are exported as IPFIX records
         SessionIpPortProtocol session_agg_key;
+        SessionAggInfo *session_agg_info = NULL;
+        if (!ipfix_export) {
+            FillSessionAggInfo(session_agg_map_iter, &session_agg_key);
+            session_agg_info = &session_ep.sess_agg_info[session_agg_key];
+        }
         session_count = 0;
         session_map_iter = session_agg_map_iter->second.session_map_.
             lower_bound(session_iteration_key_);
@@ -1831,18 +1950,24 @@ bool SessionStatsCollector::ProcessSessionEndpoint
                 }
                 continue;
             }
-            if (session_map_iter->second.deleted) {
-                FillSessionInfoUnlocked(session_map_iter, params, &session_info,
-                                        &session_key, NULL, true, is_sampling,
-                                        is_logging);
+            if (ipfix_export) {
+                ExportSessionIpfix(it, session_agg_map_iter, session_map_iter,
+                                   params);
             } else {
-                FillSessionInfoLocked(session_map_iter, params, &session_info,
-                                      &session_key, is_sampling, is_logging);
+                if (session_map_iter->second.deleted) {
+                    FillSessionInfoUnlocked(session_map_iter, params,
+                                            &session_info, &session_key, NULL,
+                                            true, is_sampling, is_logging);
+                } else {
+                    FillSessionInfoLocked(session_map_iter, params,
+                                          &session_info, &session_key,
+                                          is_sampling, is_logging);
+                }
+                session_agg_info->sessionMap.insert(make_pair(session_key,
+                                                              session_info));
+                UpdateAggregateStats(session_info, session_agg_info,
+                                     is_sampling, is_logging);
             }
-            session_agg_info.sessionMap.insert(make_pair(session_key,
-                                                         session_info));
-            UpdateAggregateStats(session_info, &session_agg_info, is_sampling,
-                                 is_logging);
             ++session_map_iter;
             ++session_count;
             if (prev->second.deleted) {
@@ -1854,10 +1979,8 @@ bool SessionStatsCollector::ProcessSessionEndpoint
                 break;
             }
         }
-        if (session_count) {
-            FillSessionAggInfo(session_agg_map_iter, &session_agg_key);
-            session_ep.sess_agg_info.insert(make_pair(session_agg_key,
-                                                      session_agg_info));
+        if (session_agg_info && session_count == 0) {
+            session_ep.sess_agg_info.erase(session_agg_key);
         }
         if (exit) {
             break;
@@ -1957,6 +2080,9 @@ uint32_t SessionStatsCollector::RunSessionEndpointStats(uint32_t max_count) {
 
     //Send any pending session export messages
     DispatchPendingSessionMsg();
+    if (ipfix_exporter_.get()) {
+        ipfix_exporter_->Flush();
+    }
 
     // Update iterator for next pass
     if (it == session_endpoint_map_.end()) {
@@ -2092,25 +2218,33 @@ uint64_t SessionStatsCollector::threshold() const {
 // SessionStatsCollectorObject methods
 /////////////////////////////////////////////////////////////////////////////
 SessionStatsCollectorObject::SessionStatsCollectorObject(Agent *agent,
-                                                   FlowStatsManager *mgr) {
-    for (int i = 0; i < kMaxSessionCollectors; i++) {
-        uint32_t instance_id = mgr->AllocateIndex();
+                                                   FlowStatsManager *mgr) :
+    collector_count_(agent->params()->session_stats_collector_count()) {
+    if (collector_count_ == 0) {
+        collector_count_ = 1;
+    } else if (collector_count_ > kMaxSessionCollectors) {
+        collector_count_ = kMaxSessionCollectors;
+    }
+    // Task policy for the session stats tasks is per instance (see
+    // Agent::SetAgentTaskPolicy), so the collector index is used as
+    // task instance
+    for (int i = 0; i < collector_count_; i++) {
         collectors[i].reset(
             AgentObjectFactory::Create<SessionStatsCollector>(
                 *(agent->event_manager()->io_service()),
-                agent->uve(), instance_id, mgr, this));
+                agent->uve(), i, mgr, this));
     }
 }
 
 SessionStatsCollector* SessionStatsCollectorObject::GetCollector(uint8_t idx) const {
-    if (idx >= 0 && idx < kMaxSessionCollectors) {
+    if (idx < collector_count_) {
         return collectors[idx].get();
     }
     return NULL;
 }
 
 void SessionStatsCollectorObject::SetExpiryTime(int time) {
-    for (int i = 0; i < kMaxSessionCollectors; i++) {
+    for (int i = 0; i < collector_count_; i++) {
         collectors[i]->set_expiry_time(time);
     }
 }
@@ -2121,18 +2255,43 @@ int SessionStatsCollectorObject::GetExpiryTime() const {
     return collectors[0]->expiry_time();
 }
 
+/*
+ * Sessions are keyed on the forward flow for non-local flows, so the forward
+ * and reverse flows must map to the same collector. Follow the collector of
+ * the reverse flow if it is already assigned, else pick collector based on
+ * the VM interface of the forward flow, which is the endpoint of the session.
+ * Once assigned, a flow stays with its collector till it is deleted (see
+ * FlowStatsManager).
+ */
 SessionStatsCollector* SessionStatsCollectorObject::FlowToCollector
     (const FlowEntry *flow) {
+    if (flow->ssc()) {
+        return flow->ssc();
+    }
+
+    const FlowEntry *fwd_flow = flow;
+    if (!flow->is_flags_set(FlowEntry::LocalFlow)) {
+        const FlowEntry *rflow = flow->reverse_flow_entry();
+        if (rflow && rflow->ssc()) {
+            return rflow->ssc();
+        }
+        if (rflow && flow->is_flags_set(FlowEntry::ReverseFlow)) {
+            fwd_flow = rflow;
+        }
+    }
+
     uint8_t idx = 0;
-    FlowTable *table = flow->flow_table();
-    if (table) {
-        idx = table->table_index() % kMaxSessionCollectors;
+    const Interface *itf = fwd_flow->intf_entry();
+    if (itf && itf->type() == Interface::VM_INTERFACE) {
+        idx = itf->id() % collector_count_;
+    } else if (flow->flow_table()) {
+        idx = flow->flow_table()->table_index() % collector_count_;
     }
     return collectors[idx].get();
 }
 
 void SessionStatsCollectorObject::Shutdown() {
-    for (int i = 0; i < kMaxSessionCollectors; i++) {
+    for (int i = 0; i < collector_count_; i++) {
         collectors[i]->Shutdown();
         collectors[i].reset();
     }
@@ -2140,14 +2299,14 @@ void SessionStatsCollectorObject::Shutdown() {
 
 size_t SessionStatsCollectorObject::Size() const {
     size_t size = 0;
-    for (int i = 0; i < kMaxSessionCollectors; i++) {
+    for (int i = 0; i < collector_count_; i++) {
         size += collectors[i]->Size();
     }
     return size;
 }
 
 void SessionStatsCollectorObject::RegisterDBClients() {
-    for (int i = 0; i < kMaxSessionCollectors; i++) {
+    for (int i = 0; i < collector_count_; i++) {
         if (collectors[i].get()) {
             collectors[i].get()->RegisterDBClients();
         }
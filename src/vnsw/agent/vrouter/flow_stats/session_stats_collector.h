@@ -5,7 +5,10 @@
 #ifndef vnsw_agent_session_stats_collector_h
 #define vnsw_agent_session_stats_collector_h
 
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 #include <vrouter/flow_stats/flow_stats_manager.h>
+#include <vrouter/flow_stats/ipfix_exporter.h>
 // Forward declaration
 class FlowStatsManager;
 class SessionStatsReq;
@@ -163,12 +166,22 @@ struct SessionEndpointKeyCmp {
     }
 };
 
+struct FlowEntryPtrHash {
+    std::size_t operator() (const FlowEntryPtr &flow) const {
+        return boost::hash<const FlowEntry *>()(flow.get());
+    }
+};
+
 class SessionStatsCollector : public StatsCollector {
 public:
+    // Endpoints are exported over several runs, resuming from the key of
+    // the next endpoint to be visited, so the map needs a stable order. Flow
+    // lookups are done for every flow event and are hash based.
     typedef std::map<const SessionEndpointKey, SessionEndpointInfo,
                      SessionEndpointKeyCmp> SessionEndpointMap;
     typedef WorkQueue<boost::shared_ptr<SessionStatsReq> > Queue;
-    typedef std::map<FlowEntryPtr, FlowToSessionMap> FlowSessionMap;
+    typedef boost::unordered_map<FlowEntryPtr, FlowToSessionMap,
+                                 FlowEntryPtrHash> FlowSessionMap;
     typedef std::map<std::string, SessionSloRuleEntry> SessionSloRuleMap;
 
     static const uint32_t kSessionStatsTimerInterval = 1000;
@@ -197,6 +210,13 @@ public:
     uint32_t instance_id() const { return instance_id_; }
     const Queue *queue() const { return &request_queue_; }
     size_t Size() const { return session_endpoint_map_.size(); }
+    size_t FlowSessionCount() const { return flow_session_map_.size(); }
+    // When an IPFIX exporter is set, sessions are exported as IPFIX records
+    // instead of SessionEndpoint messages
+    IpfixExporter *ipfix_exporter() const { return ipfix_exporter_.get(); }
+    void set_ipfix_exporter(IpfixExporter *exporter) {
+        ipfix_exporter_.reset(exporter);
+    }
     friend class FlowStatsManager;
     friend class SessionStatsCollectorObject;
 protected:
@@ -221,6 +241,11 @@ private:
         (SessionPreAggInfo::SessionMap::iterator session_map_iter,
          SessionStatsParams *params) const;
     bool ProcessSessionEndpoint(const SessionEndpointMap::iterator &it);
+    void ExportSessionIpfix
+        (const SessionEndpointMap::iterator &it,
+         SessionEndpointInfo::SessionAggMap::iterator session_agg_map_iter,
+         SessionPreAggInfo::SessionMap::iterator session_map_iter,
+         const SessionStatsParams &stats);
     uint64_t GetUpdatedSessionFlowBytes(uint64_t info_bytes,
                                         uint64_t k_flow_bytes) const;
     uint64_t GetUpdatedSessionFlowPackets(uint64_t info_packets,
@@ -297,6 +322,7 @@ private:
     void EnqueueSessionMsg();
     void DispatchPendingSessionMsg();
     uint8_t GetSessionMsgIdx();
+    static void ClearSessionEndpoint(SessionEndpoint *ep);
 
     bool UpdateSloMatchRuleEntry(const boost::uuids::uuid &slo_uuid,
                                  const std::string &match_uuid,
@@ -386,6 +412,8 @@ private:
     FlowSessionMap flow_session_map_;
     Queue request_queue_;
     std::vector<SessionEndpoint> session_msg_list_;
+    // Filled entries of a partial message list, copied here for dispatch
+    std::vector<SessionEndpoint> session_msg_pending_;
     uint8_t session_msg_index_;
     uint32_t instance_id_;
     FlowStatsManager *flow_stats_manager_;
@@ -398,15 +426,22 @@ private:
     uint64_t session_task_starts_;
     uint32_t session_ep_visited_;
     DBTable::ListenerId slo_listener_id_;
+    boost::scoped_ptr<IpfixExporter> ipfix_exporter_;
     DISALLOW_COPY_AND_ASSIGN(SessionStatsCollector);
 };
 
+// Sessions are sharded across collector_count_ SessionStatsCollector
+// instances based on the VM interface of the session endpoint. Each instance
+// runs its event and scan tasks with its index as task instance, so that
+// instances run in parallel. Sharding is opt-in, a single instance is created
+// unless FLOWS.session_stats_collector_count is set.
 class SessionStatsCollectorObject {
 public:
-    static const int kMaxSessionCollectors = 1;
+    static const int kMaxSessionCollectors = Agent::kMaxSessionStatsCollectors;
     typedef boost::shared_ptr<SessionStatsCollector> SessionStatsCollectorPtr;
     SessionStatsCollectorObject(Agent *agent, FlowStatsManager *mgr);
     SessionStatsCollector* GetCollector(uint8_t idx) const;
+    uint8_t collector_count() const { return collector_count_; }
     void SetExpiryTime(int time);
     int GetExpiryTime() const;
     SessionStatsCollector* FlowToCollector(const FlowEntry *flow);
@@ -414,6 +449,7 @@ public:
     size_t Size() const;
     void RegisterDBClients();
 private:
+    uint8_t collector_count_;
     SessionStatsCollectorPtr collectors[kMaxSessionCollectors];
     DISALLOW_COPY_AND_ASSIGN(SessionStatsCollectorObject);
 };
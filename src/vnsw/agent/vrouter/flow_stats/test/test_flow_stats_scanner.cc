@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include "base/os.h"
+#include <base/time_util.h>
+#include <tbb/atomic.h>
+#include "test/test_init.h"
+#include "test/test_cmn_util.h"
+#include "init/agent_param.h"
+#include <vrouter/flow_stats/flow_stats_manager.h>
+#include <vrouter/flow_stats/flow_stats_scanner.h>
+
+#include <vr_types.h>
+#include <vr_flow.h>
+
+// Number of entries in the mock flow table
+static const uint32_t kTableSize = 1024 * 1024;
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+// Scanner that records candidates instead of dispatching to the flow stats
+// collectors, and runs on a time set by the test
+class FlowStatsScannerTest : public FlowStatsScanner {
+public:
+    FlowStatsScannerTest(Agent *agent, const vr_flow_entry *table,
+                         uint32_t count, uint16_t partitions) :
+        FlowStatsScanner(agent, agent->flow_stats_manager(), table, count,
+                         partitions), now_(1000) {
+        dispatched_ = 0;
+        max_index_ = 0;
+    }
+    virtual ~FlowStatsScannerTest() { }
+
+    virtual void Dispatch(uint32_t idx) {
+        dispatched_++;
+        if (idx > max_index_)
+            max_index_ = idx;
+    }
+    virtual uint32_t GetCurrentTime() const { return now_; }
+
+    void set_now(uint32_t now) { now_ = now; }
+    uint32_t now() const { return now_; }
+    uint32_t dispatched() const { return dispatched_; }
+    void reset_dispatched() {
+        dispatched_ = 0;
+        max_index_ = 0;
+    }
+    uint32_t max_index() const { return max_index_; }
+
+private:
+    uint32_t now_;
+    tbb::atomic<uint32_t> dispatched_;
+    tbb::atomic<uint32_t> max_index_;
+};
+
+class FlowStatsScanTest : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        agent_ = Agent::GetInstance();
+        table_ = static_cast<vr_flow_entry *>
+            (calloc(kTableSize, sizeof(vr_flow_entry)));
+        ASSERT_TRUE(table_ != NULL);
+    }
+
+    virtual void TearDown() {
+        free(table_);
+    }
+
+    // Make every stride entry active with non-zero counters
+    uint32_t AddFlows(uint32_t stride) {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < kTableSize; i += stride) {
+            table_[i].fe_flags = VR_FLOW_FLAG_ACTIVE;
+            table_[i].fe_gen_id = 1;
+            table_[i].fe_stats.flow_packets = 1;
+            table_[i].fe_stats.flow_bytes = 64;
+            count++;
+        }
+        return count;
+    }
+
+    // Add traffic on every stride entry. Returns number of active entries
+    // changed
+    uint32_t UpdateFlows(uint32_t stride) {
+        uint32_t count = 0;
+        for (uint32_t i = 0; i < kTableSize; i += stride) {
+            if ((table_[i].fe_flags & VR_FLOW_FLAG_ACTIVE) == 0)
+                continue;
+            table_[i].fe_stats.flow_packets++;
+            table_[i].fe_stats.flow_bytes += 64;
+            count++;
+        }
+        return count;
+    }
+
+    // Scan the whole table. The count returned by the scan must match the
+    // candidates dispatched
+    uint32_t ScanTable(FlowStatsScannerTest *scanner) {
+        scanner->reset_dispatched();
+        uint32_t count = scanner->Scan(0, scanner->count(), scanner->now());
+        EXPECT_EQ(count, scanner->dispatched());
+        return count;
+    }
+
+    Agent *agent_;
+    vr_flow_entry *table_;
+};
+
+// Only changed, idle and evicted entries are dispatched
+TEST_F(FlowStatsScanTest, Candidates) {
+    FlowStatsScannerTest scanner(agent_, table_, kTableSize, 1);
+    scanner.set_idle_time(180);
+    uint32_t flows = AddFlows(4);
+
+    // First scan finds all active flows
+    EXPECT_EQ(flows, ScanTable(&scanner));
+
+    // No change, nothing to dispatch
+    scanner.set_now(scanner.now() + 10);
+    EXPECT_EQ(0U, ScanTable(&scanner));
+
+    // Traffic on some of the flows
+    uint32_t changed = UpdateFlows(64);
+    EXPECT_GT(changed, 0U);
+    scanner.set_now(scanner.now() + 10);
+    EXPECT_EQ(changed, ScanTable(&scanner));
+
+    // Evicted flows are dispatched without change in counters
+    table_[4].fe_flags |= VR_FLOW_FLAG_EVICTED;
+    table_[8].fe_flags |= VR_FLOW_FLAG_EVICTED;
+    scanner.set_now(scanner.now() + 10);
+    EXPECT_EQ(2U, ScanTable(&scanner));
+    table_[4].fe_flags &= ~VR_FLOW_FLAG_EVICTED;
+    table_[8].fe_flags &= ~VR_FLOW_FLAG_EVICTED;
+
+    // Flows without traffic for idle time are dispatched once
+    scanner.set_now(scanner.now() + 180);
+    EXPECT_EQ(flows, ScanTable(&scanner));
+    scanner.set_now(scanner.now() + 10);
+    EXPECT_EQ(0U, ScanTable(&scanner));
+
+    // Gen-id change is a new flow in the entry
+    table_[0].fe_gen_id++;
+    // Inactive entries are not dispatched
+    table_[4].fe_flags = 0;
+    table_[4].fe_stats.flow_packets++;
+    scanner.set_now(scanner.now() + 10);
+    EXPECT_EQ(1U, ScanTable(&scanner));
+    EXPECT_EQ(0U, scanner.max_index());
+}
+
+// Last chunk of the table is partial
+TEST_F(FlowStatsScanTest, PartialChunk) {
+    uint32_t count = kTableSize - 5;
+    FlowStatsScannerTest scanner(agent_, table_, count, 3);
+    table_[count - 1].fe_flags = VR_FLOW_FLAG_ACTIVE;
+    table_[count - 1].fe_stats.flow_packets = 1;
+    // Entry beyond the table size must not be looked at
+    table_[count].fe_flags = VR_FLOW_FLAG_ACTIVE;
+    table_[count].fe_stats.flow_packets = 1;
+
+    EXPECT_EQ(count, scanner.partition(2).end);
+    EXPECT_EQ(0U, scanner.partition(1).start %
+              FlowStatsScanner::kChunkSize);
+    EXPECT_EQ(0U, scanner.partition(2).start %
+              FlowStatsScanner::kChunkSize);
+    scanner.Scan(scanner.partition(2).start, scanner.partition(2).end,
+                 scanner.now());
+    EXPECT_EQ(1U, scanner.dispatched());
+    EXPECT_EQ(count - 1, scanner.max_index());
+}
+
+// Scan the table with partitions in parallel, driven by the scan timer
+TEST_F(FlowStatsScanTest, Partitions) {
+    uint16_t partitions = Agent::kMaxFlowStatsScanPartitions;
+    FlowStatsScannerTest scanner(agent_, table_, kTableSize, partitions);
+    scanner.set_idle_time(1);
+    uint32_t flows = AddFlows(2);
+
+    uint32_t covered = 0;
+    for (uint16_t i = 0; i < partitions; i++) {
+        const FlowStatsScanner::Partition &partition = scanner.partition(i);
+        EXPECT_EQ(covered, partition.start);
+        covered = partition.end;
+    }
+    EXPECT_EQ(kTableSize, covered);
+
+    // Scan time is 25% of idle time, number of timers to scan table once
+    // is 2
+    uint32_t timers = 0;
+    bool done = false;
+    while (done == false) {
+        scanner.Run();
+        client->WaitForIdle();
+        timers++;
+        done = true;
+        for (uint16_t i = 0; i < partitions; i++) {
+            if (scanner.partition(i).scans == 0)
+                done = false;
+        }
+    }
+    EXPECT_EQ(2U, scanner.timers_per_scan());
+    EXPECT_EQ(2U, timers);
+    EXPECT_EQ(flows, scanner.dispatched());
+    EXPECT_EQ(flows, scanner.candidates());
+    // Each partition is scanned exactly once
+    for (uint16_t i = 0; i < partitions; i++) {
+        EXPECT_EQ(1U, scanner.partition(i).scans);
+    }
+    scanner.Shutdown();
+}
+
+int main(int argc, char *argv[]) {
+    int ret;
+    GETUSERARGS();
+
+    client = TestInit(init_file, ksync_init, true, false,
+                      true, (10 * 60 * 1000), (10 * 60 * 1000),
+                      true, true, (10 * 60 * 1000));
+    ::testing::InitGoogleTest(&argc, argv);
+    usleep(10000);
+    ret = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+    return ret;
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2018 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <vector>
+#include "testing/gunit.h"
+#include "base/logging.h"
+#include <boost/asio.hpp>
+#include "cmn/agent_cmn.h"
+#include <vrouter/flow_stats/ipfix_exporter.h>
+
+using boost::asio::ip::udp;
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+// Exporter with a controllable export time
+class IpfixExporterTest : public IpfixExporter {
+public:
+    IpfixExporterTest(boost::asio::io_service &io, const IpAddress &collector,
+                      uint16_t port, uint32_t domain_id, uint16_t mtu) :
+        IpfixExporter(io, collector, port, domain_id, mtu), now_(1000) {
+    }
+    void set_now(uint32_t now) { now_ = now; }
+protected:
+    virtual uint32_t ExportTime() const { return now_; }
+private:
+    uint32_t now_;
+};
+
+struct IpfixSet {
+    uint16_t id;
+    std::vector<uint8_t> data;
+};
+
+struct IpfixMessage {
+    uint16_t version;
+    uint16_t length;
+    uint32_t export_time;
+    uint32_t sequence;
+    uint32_t domain_id;
+    size_t received;
+    std::vector<IpfixSet> sets;
+};
+
+static uint16_t Get16(const uint8_t *p) {
+    return (p[0] << 8) | p[1];
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (Get16(p) << 16) | Get16(p + 2);
+}
+
+static uint64_t Get64(const uint8_t *p) {
+    return ((uint64_t)Get32(p) << 32) | Get32(p + 4);
+}
+
+// Decoded IPv4 data record
+struct IpfixRecord {
+    uint32_t src_ip;
+    uint32_t dst_ip;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint8_t protocol;
+    uint16_t tcp_flags;
+    uint64_t octets;
+    uint64_t packets;
+    uint64_t reverse_octets;
+    uint64_t reverse_packets;
+    uint64_t start_msec;
+    uint64_t end_msec;
+    uint8_t end_reason;
+    std::string src_vn;
+    std::string dst_vn;
+};
+
+static size_t DecodeString(const uint8_t *p, std::string *str) {
+    size_t len = p[0];
+    size_t hdr = 1;
+    if (len == 255) {
+        len = Get16(p + 1);
+        hdr = 3;
+    }
+    str->assign((const char *)p + hdr, len);
+    return hdr + len;
+}
+
+static void DecodeRecords(const IpfixSet &set,
+                          std::vector<IpfixRecord> *records) {
+    const uint8_t *p = &set.data[0];
+    const uint8_t *end = p + set.data.size();
+    while (p < end) {
+        IpfixRecord rec;
+        rec.src_ip = Get32(p);
+        rec.dst_ip = Get32(p + 4);
+        rec.src_port = Get16(p + 8);
+        rec.dst_port = Get16(p + 10);
+        rec.protocol = p[12];
+        rec.tcp_flags = Get16(p + 13);
+        rec.octets = Get64(p + 15);
+        rec.packets = Get64(p + 23);
+        rec.reverse_octets = Get64(p + 31);
+        rec.reverse_packets = Get64(p + 39);
+        rec.start_msec = Get64(p + 47);
+        rec.end_msec = Get64(p + 55);
+        rec.end_reason = p[63];
+        p += 64;
+        p += DecodeString(p, &rec.src_vn);
+        p += DecodeString(p, &rec.dst_vn);
+        records->push_back(rec);
+    }
+}
+
+class IpfixTest : public ::testing::Test {
+public:
+    IpfixTest() : sink_(io_) {
+    }
+
+    virtual void SetUp() {
+        sink_.open(udp::v4());
+        sink_.bind(udp::endpoint(Ip4Address::from_string("127.0.0.1"), 0));
+        sink_.set_option(udp::socket::receive_buffer_size(1024 * 1024));
+        port_ = sink_.local_endpoint().port();
+    }
+
+    virtual void TearDown() {
+        sink_.close();
+    }
+
+    IpfixExporterTest *CreateExporter(uint16_t mtu) {
+        return new IpfixExporterTest(io_, Ip4Address::from_string("127.0.0.1"),
+                                     port_, 7, mtu);
+    }
+
+    // Read all messages pending on the sink socket
+    void Receive(std::vector<IpfixMessage> *messages) {
+        uint8_t buf[65536];
+        while (sink_.available()) {
+            size_t len = sink_.receive(boost::asio::buffer(buf, sizeof(buf)));
+            IpfixMessage msg;
+            msg.version = Get16(buf);
+            msg.length = Get16(buf + 2);
+            msg.export_time = Get32(buf + 4);
+            msg.sequence = Get32(buf + 8);
+            msg.domain_id = Get32(buf + 12);
+            msg.received = len;
+            size_t offset = IpfixExporter::kMessageHeaderLen;
+            while (offset + IpfixExporter::kSetHeaderLen <= len) {
+                IpfixSet set;
+                set.id = Get16(buf + offset);
+                uint16_t set_len = Get16(buf + offset + 2);
+                EXPECT_GE(set_len, IpfixExporter::kSetHeaderLen);
+                EXPECT_LE(offset + set_len, len);
+                if (set_len < IpfixExporter::kSetHeaderLen ||
+                    offset + set_len > len) {
+                    break;
+                }
+                set.data.assign(buf + offset + IpfixExporter::kSetHeaderLen,
+                                buf + offset + set_len);
+                msg.sets.push_back(set);
+                offset += set_len;
+            }
+            EXPECT_EQ(len, offset);
+            messages->push_back(msg);
+        }
+    }
+
+    void FillRecord(IpfixFlowRecord *rec, int idx) {
+        rec->src_ip = Ip4Address(0x01010100 + (idx % 256));
+        rec->dst_ip = Ip4Address::from_string("2.2.2.2");
+        rec->src_port = 1000 + idx;
+        rec->dst_port = 80;
+        rec->protocol = 6;
+        rec->tcp_flags = 0x12;
+        rec->octets = 1000 * idx;
+        rec->packets = idx;
+        rec->reverse_octets = 2000 * idx;
+        rec->reverse_packets = 2 * idx;
+        rec->start_msec = 1500000000000ULL;
+        rec->end_msec = 1500000001000ULL;
+        rec->end_reason = IpfixExporter::ACTIVE_TIMEOUT;
+        rec->src_vn = &src_vn_;
+        rec->dst_vn = &dst_vn_;
+    }
+
+    boost::asio::io_service io_;
+    udp::socket sink_;
+    uint16_t port_;
+    std::string src_vn_;
+    std::string dst_vn_;
+};
+
+TEST_F(IpfixTest, TemplateAndRecord) {
+    boost::scoped_ptr<IpfixExporterTest> exporter(CreateExporter(1400));
+    src_vn_ = "default-domain:admin:vn1";
+    dst_vn_ = "default-domain:admin:vn2";
+    IpfixFlowRecord rec;
+    FillRecord(&rec, 5);
+    EXPECT_TRUE(exporter->Add(rec));
+    EXPECT_EQ(1U, exporter->pending_records());
+    exporter->Flush();
+    EXPECT_EQ(1U, exporter->messages_sent());
+    EXPECT_EQ(1U, exporter->records_sent());
+
+    std::vector<IpfixMessage> messages;
+    Receive(&messages);
+    ASSERT_EQ(1U, messages.size());
+    const IpfixMessage &msg = messages[0];
+    EXPECT_EQ(IpfixExporter::kVersion, msg.version);
+    EXPECT_EQ(msg.received, msg.length);
+    EXPECT_EQ(1000U, msg.export_time);
+    EXPECT_EQ(0U, msg.sequence);
+    EXPECT_EQ(7U, msg.domain_id);
+
+    // Template set with IPv4 and IPv6 templates, followed by data set
+    ASSERT_EQ(2U, msg.sets.size());
+    EXPECT_EQ(IpfixExporter::kTemplateSetId, msg.sets[0].id);
+    const uint8_t *t = &msg.sets[0].data[0];
+    EXPECT_EQ(IpfixExporter::kIpv4TemplateId, Get16(t));
+    EXPECT_EQ(15U, Get16(t + 2));
+    EXPECT_EQ(IpfixExporter::SOURCE_IPV4_ADDRESS, Get16(t + 4));
+    EXPECT_EQ(4U, Get16(t + 6));
+    // 11 IANA and 4 enterprise specific field specifiers per template
+    EXPECT_EQ(2U * (4 + (11 * 4) + (4 * 8)), msg.sets[0].data.size());
+    EXPECT_EQ(IpfixExporter::kIpv6TemplateId, Get16(t + 80));
+
+    EXPECT_EQ(IpfixExporter::kIpv4TemplateId, msg.sets[1].id);
+    std::vector<IpfixRecord> records;
+    DecodeRecords(msg.sets[1], &records);
+    ASSERT_EQ(1U, records.size());
+    EXPECT_EQ(0x01010105U, records[0].src_ip);
+    EXPECT_EQ(0x02020202U, records[0].dst_ip);
+    EXPECT_EQ(1005U, records[0].src_port);
+    EXPECT_EQ(80U, records[0].dst_port);
+    EXPECT_EQ(6U, records[0].protocol);
+    EXPECT_EQ(0x12U, records[0].tcp_flags);
+    EXPECT_EQ(5000U, records[0].octets);
+    EXPECT_EQ(5U, records[0].packets);
+    EXPECT_EQ(10000U, records[0].reverse_octets);
+    EXPECT_EQ(10U, records[0].reverse_packets);
+    EXPECT_EQ(1500000000000ULL, records[0].start_msec);
+    EXPECT_EQ(1500000001000ULL, records[0].end_msec);
+    EXPECT_EQ(IpfixExporter::ACTIVE_TIMEOUT, records[0].end_reason);
+    EXPECT_EQ(src_vn_, records[0].src_vn);
+    EXPECT_EQ(dst_vn_, records[0].dst_vn);
+
+    // Nothing pending, Flush is a no-op
+    exporter->Flush();
+    messages.clear();
+    Receive(&messages);
+    EXPECT_EQ(0U, messages.size());
+}
+
+// Records are batched in messages not larger than mtu. Sequence number of a
+// message is the number of records sent before it
+TEST_F(IpfixTest, Batching) {
+    static const int kRecords = 100;
+    boost::scoped_ptr<IpfixExporterTest> exporter(CreateExporter(1400));
+    src_vn_ = "default-domain:admin:vn1";
+    // Variable length field larger than 255 bytes
+    dst_vn_ = "default-domain:admin:" + std::string(300, 'x');
+    for (int i = 0; i < kRecords; i++) {
+        IpfixFlowRecord rec;
+        FillRecord(&rec, i);
+        EXPECT_TRUE(exporter->Add(rec));
+    }
+    exporter->Flush();
+    EXPECT_EQ((uint64_t)kRecords, exporter->records_sent());
+    EXPECT_EQ((uint32_t)kRecords, exporter->sequence());
+
+    std::vector<IpfixMessage> messages;
+    Receive(&messages);
+    EXPECT_EQ(exporter->messages_sent(), messages.size());
+    EXPECT_GT(messages.size(), 1U);
+    uint32_t sequence = 0;
+    std::vector<IpfixRecord> records;
+    for (size_t i = 0; i < messages.size(); i++) {
+        EXPECT_LE(messages[i].received, 1400U);
+        EXPECT_EQ(messages[i].received, messages[i].length);
+        EXPECT_EQ(sequence, messages[i].sequence);
+        size_t count = records.size();
+        for (size_t j = 0; j < messages[i].sets.size(); j++) {
+            // Templates only in the first message
+            if (messages[i].sets[j].id == IpfixExporter::kTemplateSetId) {
+                EXPECT_EQ(0U, i);
+                continue;
+            }
+            EXPECT_EQ(IpfixExporter::kIpv4TemplateId, messages[i].sets[j].id);
+            DecodeRecords(messages[i].sets[j], &records);
+        }
+        sequence += records.size() - count;
+    }
+    ASSERT_EQ((size_t)kRecords, records.size());
+    for (int i = 0; i < kRecords; i++) {
+        EXPECT_EQ(1000U + i, records[i].src_port);
+        EXPECT_EQ(dst_vn_, records[i].dst_vn);
+    }
+}
+
+// IPv4 and IPv6 records are put in separate data sets
+TEST_F(IpfixTest, Ipv6Record) {
+    boost::scoped_ptr<IpfixExporterTest> exporter(CreateExporter(1400));
+    IpfixFlowRecord rec;
+    FillRecord(&rec, 1);
+    EXPECT_TRUE(exporter->Add(rec));
+    IpfixFlowRecord rec6;
+    FillRecord(&rec6, 2);
+    rec6.src_ip = Ip6Address::from_string("fd00::1");
+    rec6.dst_ip = Ip6Address::from_string("fd00::2");
+    EXPECT_TRUE(exporter->Add(rec6));
+    EXPECT_TRUE(exporter->Add(rec6));
+    exporter->Flush();
+
+    std::vector<IpfixMessage> messages;
+    Receive(&messages);
+    ASSERT_EQ(1U, messages.size());
+    ASSERT_EQ(3U, messages[0].sets.size());
+    EXPECT_EQ(IpfixExporter::kIpv4TemplateId, messages[0].sets[1].id);
+    EXPECT_EQ(IpfixExporter::kIpv6TemplateId, messages[0].sets[2].id);
+    // Two IPv6 records with empty VN names
+    EXPECT_EQ(2U * (32 + 2 + 2 + 1 + 2 + 48 + 1 + 2),
+              messages[0].sets[2].data.size());
+    Ip6Address::bytes_type bytes;
+    std::copy(messages[0].sets[2].data.begin(),
+              messages[0].sets[2].data.begin() + 16, bytes.begin());
+    EXPECT_EQ(Ip6Address::from_string("fd00::1"), Ip6Address(bytes));
+}
+
+// Templates are sent again after the refresh interval
+TEST_F(IpfixTest, TemplateRefresh) {
+    boost::scoped_ptr<IpfixExporterTest> exporter(CreateExporter(1400));
+    exporter->set_template_refresh_interval(10);
+    IpfixFlowRecord rec;
+    FillRecord(&rec, 1);
+    for (uint32_t now = 1000; now <= 1020; now += 5) {
+        exporter->set_now(now);
+        EXPECT_TRUE(exporter->Add(rec));
+        exporter->Flush();
+    }
+
+    std::vector<IpfixMessage> messages;
+    Receive(&messages);
+    ASSERT_EQ(5U, messages.size());
+    int templates = 0;
+    for (size_t i = 0; i < messages.size(); i++) {
+        EXPECT_EQ(i, messages[i].sequence);
+        if (messages[i].sets[0].id == IpfixExporter::kTemplateSetId) {
+            templates++;
+        }
+    }
+    // Sent at 1000, 1010 and 1020
+    EXPECT_EQ(3, templates);
+}
+
+// Record which cannot fit in a message is dropped
+TEST_F(IpfixTest, RecordTooLarge) {
+    boost::scoped_ptr<IpfixExporterTest> exporter(CreateExporter(512));
+    src_vn_ = std::string(1000, 'x');
+    IpfixFlowRecord rec;
+    FillRecord(&rec, 1);
+    EXPECT_FALSE(exporter->Add(rec));
+    EXPECT_EQ(1U, exporter->records_dropped());
+    EXPECT_EQ(0U, exporter->pending_records());
+}
+
+int main(int argc, char *argv[]) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,7 @@
  * Copyright (c) 2015 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <algorithm>
 #include <vector>
 #include "base/os.h"
 #include <boost/array.hpp>
@@ -9,6 +10,8 @@
 #include "test/test_cmn_util.h"
 #include "oper/mirror_table.h"
 #include "oper/tunnel_nh.h"
+#include "oper/global_vrouter.h"
+#include "init/agent_param.h"
 #include "xmpp/test/xmpp_test_util.h"
 #include "pkt/test/test_flow_util.h"
 #include "ksync/ksync_sock_user.h"
@@ -34,20 +37,20 @@ VmInterface *flow1;
 
 class SessionHandleTask : public Task {
 public:
-    SessionHandleTask() :
+    SessionHandleTask(int instance) :
         Task((TaskScheduler::GetInstance()->
-              GetTaskId(kTaskSessionStatsCollector)), 0) {
+              GetTaskId(kTaskSessionStatsCollector)), instance),
+        instance_(instance) {
     }
     virtual bool Run() {
         SessionStatsCollectorObject *obj = Agent::GetInstance()->
             flow_stats_manager()->session_stats_collector_obj();
-        for (int i = 0; i < SessionStatsCollectorObject::kMaxSessionCollectors;
-             i++) {
-            obj->GetCollector(i)->Run();
-        }
+        obj->GetCollector(instance_)->Run();
         return true;
     }
     std::string Description() const { return "SessionHandleTask"; }
+private:
+    int instance_;
 };
 
 class SessionStatsTest : public ::testing::Test {
@@ -71,8 +74,22 @@ public:
     }
     void EnqueueSessionTask() {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        SessionHandleTask *task = new SessionHandleTask();
-        scheduler->Enqueue(task);
+        SessionStatsCollectorObject *obj = agent_->flow_stats_manager()->
+            session_stats_collector_obj();
+        for (int i = 0; i < obj->collector_count(); i++) {
+            SessionHandleTask *task = new SessionHandleTask(i);
+            scheduler->Enqueue(task);
+        }
+    }
+
+    size_t FlowSessionCount() {
+        SessionStatsCollectorObject *obj = agent_->flow_stats_manager()->
+            session_stats_collector_obj();
+        size_t count = 0;
+        for (int i = 0; i < obj->collector_count(); i++) {
+            count += obj->GetCollector(i)->FlowSessionCount();
+        }
+        return count;
     }
 
     void FlowSetup() {
@@ -150,7 +167,8 @@ TEST_F(SessionStatsTest, FlowAddVerify) {
     EXPECT_TRUE(fe != NULL);
     SessionStatsCollector *ssc = ssc_obj->FlowToCollector(fe);
     EXPECT_TRUE(ssc != NULL);
-    EXPECT_EQ(3U, ssc->Size());
+    EXPECT_TRUE(fe->ssc() == ssc);
+    EXPECT_EQ(3U, ssc_obj->Size());
 
     DeleteFlow(flow, 2);
     client->WaitForIdle();
@@ -158,7 +176,7 @@ TEST_F(SessionStatsTest, FlowAddVerify) {
     EXPECT_EQ(0U, flow_proto_->FlowCount());
     EnqueueSessionTask();
     client->WaitForIdle();
-    WAIT_FOR(1000, 500, (ssc->Size() == 0));
+    WAIT_FOR(1000, 500, (ssc_obj->Size() == 0));
 }
 
 TEST_F(SessionStatsTest, RemoteFlowAddVerify) {
@@ -204,6 +222,8 @@ TEST_F(SessionStatsTest, RemoteFlowAddVerify) {
     EXPECT_TRUE(fe != NULL);
     SessionStatsCollector *ssc = ssc_obj->FlowToCollector(fe);
     EXPECT_TRUE(ssc != NULL);
+    /* Forward and reverse flows are on same collector */
+    EXPECT_TRUE(fe->reverse_flow_entry()->ssc() == ssc);
     EXPECT_EQ(2U, ssc->Size());
 
     DeleteFlow(flow, 4);
@@ -215,6 +235,165 @@ TEST_F(SessionStatsTest, RemoteFlowAddVerify) {
     WAIT_FOR(1000, 500, (ssc->Size() == 0));
 }
 
+/* Sessions are exported as IPFIX records to a local UDP sink when an IPFIX
+ * exporter is set on the collectors */
+TEST_F(SessionStatsTest, IpfixExport) {
+    SessionStatsCollectorObject *ssc_obj = agent_->flow_stats_manager()->
+                                           session_stats_collector_obj();
+    boost::asio::ip::udp::socket sink(*agent_->event_manager()->io_service());
+    boost::asio::ip::udp::endpoint ep(Ip4Address::from_string("127.0.0.1"), 0);
+    sink.open(boost::asio::ip::udp::v4());
+    sink.bind(ep);
+    uint16_t port = sink.local_endpoint().port();
+    for (int i = 0; i < ssc_obj->collector_count(); i++) {
+        ssc_obj->GetCollector(i)->set_ipfix_exporter
+            (new IpfixExporter(*agent_->event_manager()->io_service(),
+                               Ip4Address::from_string("127.0.0.1"), port, i,
+                               agent_->params()->ipfix_mtu()));
+    }
+    /* Disable sampling so that all sessions are exported */
+    AddFlowExportRate(GlobalVrouter::kDisableSampling);
+    client->WaitForIdle();
+
+    FlowSetup();
+    TestFlow flow[] = {
+        {
+            TestFlowPkt(Address::INET, "1.1.1.1", "1.1.1.2", 6, 1000, 2000, "vrf5",
+                        flow0->id()),
+            {
+            }
+        }
+    };
+    CreateFlow(flow, 1);
+    client->WaitForIdle();
+    EXPECT_EQ(2U, flow_proto_->FlowCount());
+
+    DeleteFlow(flow, 1);
+    client->WaitForIdle();
+    EnqueueSessionTask();
+    client->WaitForIdle();
+    WAIT_FOR(1000, 500, (ssc_obj->Size() == 0));
+
+    uint64_t records = 0;
+    uint64_t messages_sent = 0;
+    for (int i = 0; i < ssc_obj->collector_count(); i++) {
+        IpfixExporter *exporter = ssc_obj->GetCollector(i)->ipfix_exporter();
+        EXPECT_EQ(0U, exporter->pending_records());
+        EXPECT_EQ(0U, exporter->records_dropped());
+        records += exporter->records_sent();
+        messages_sent += exporter->messages_sent();
+    }
+    EXPECT_GE(records, 1U);
+
+    // Every message sent reaches the sink and carries its records
+    uint8_t buf[65536];
+    uint64_t messages = 0;
+    uint64_t sequence = 0;
+    while (sink.available()) {
+        size_t len = sink.receive(boost::asio::buffer(buf, sizeof(buf)));
+        EXPECT_EQ(IpfixExporter::kVersion, (buf[0] << 8) | buf[1]);
+        EXPECT_EQ(len, (size_t)((buf[2] << 8) | buf[3]));
+        EXPECT_LE(len, agent_->params()->ipfix_mtu());
+        sequence = std::max(sequence, (uint64_t)((buf[8] << 24) |
+                            (buf[9] << 16) | (buf[10] << 8) | buf[11]));
+        messages++;
+    }
+    EXPECT_EQ(messages_sent, messages);
+    if (ssc_obj->collector_count() == 1) {
+        EXPECT_LT(sequence, records);
+    }
+
+    for (int i = 0; i < ssc_obj->collector_count(); i++) {
+        ssc_obj->GetCollector(i)->set_ipfix_exporter(NULL);
+    }
+    AddFlowExportRate(GlobalVrouter::kDefaultFlowExportRate);
+    client->WaitForIdle();
+    FlowTeardown();
+    sink.close();
+}
+
+/* Feed synthetic add, stats and delete events for a large number of sessions
+ * spread over two VMIs, and verify that the session stats collectors keep a
+ * single session per flow pair and export the partial message */
+TEST_F(SessionStatsTest, SessionEventScale) {
+    static const int kFlowCount = 256;
+    static const int kAddIterations = 8;
+    SessionStatsCollectorObject *ssc_obj = agent_->flow_stats_manager()->
+                                           session_stats_collector_obj();
+    FlowSetup();
+
+    std::vector<TestFlowPkt *> pkts;
+    for (int i = 0; i < kFlowCount; i++) {
+        pkts.push_back(new TestFlowPkt(Address::INET, "1.1.1.1", "1.1.1.2", 6,
+                                       1000 + i, 2000, "vrf5", flow0->id()));
+        pkts.push_back(new TestFlowPkt(Address::INET, "1.1.1.2", "1.1.1.1", 6,
+                                       3000 + i, 4000, "vrf5", flow1->id()));
+    }
+
+    for (size_t i = 0; i < pkts.size(); i++) {
+        pkts[i]->Send();
+    }
+    client->WaitForIdle();
+    EXPECT_EQ(4U * kFlowCount, flow_proto_->FlowCount());
+
+    size_t sessions = FlowSessionCount();
+    EXPECT_TRUE(sessions > 0);
+    if (ssc_obj->collector_count() > 1 &&
+        (flow0->id() % ssc_obj->collector_count()) !=
+        (flow1->id() % ssc_obj->collector_count())) {
+        EXPECT_TRUE(ssc_obj->FlowToCollector(pkts[0]->FlowFetch()) !=
+                    ssc_obj->FlowToCollector(pkts[1]->FlowFetch()));
+    }
+
+    std::vector<FlowEntryPtr> flows;
+    for (size_t i = 0; i < pkts.size(); i++) {
+        FlowEntry *fe = pkts[i]->FlowFetch();
+        EXPECT_TRUE(fe != NULL);
+        if (fe == NULL)
+            continue;
+        flows.push_back(fe);
+        flows.push_back(fe->reverse_flow_entry());
+    }
+
+    // Repeated add events for existing flows only lookup the session maps
+    FlowStatsManager *fsm = agent_->flow_stats_manager();
+    for (int iter = 0; iter < kAddIterations; iter++) {
+        for (size_t i = 0; i < flows.size(); i++) {
+            fsm->AddEvent(flows[i]);
+        }
+    }
+    client->WaitForIdle();
+    EXPECT_EQ(sessions, FlowSessionCount());
+
+    for (size_t i = 0; i < flows.size(); i++) {
+        fsm->UpdateStatsEvent(flows[i], 100, 1, 0, flows[i]->uuid());
+    }
+    client->WaitForIdle();
+    EXPECT_EQ(sessions, FlowSessionCount());
+
+    // Fewer endpoints than a full message, exported as a partial message
+    uint64_t sample_exports = fsm->session_sample_exports();
+    EnqueueSessionTask();
+    client->WaitForIdle();
+    EXPECT_GT(fsm->session_sample_exports(), sample_exports);
+
+    flows.clear();
+    for (size_t i = 0; i < pkts.size(); i++) {
+        pkts[i]->Delete();
+    }
+    client->WaitForIdle();
+    WAIT_FOR(1000, 1000, (flow_proto_->FlowCount() == 0));
+    EXPECT_EQ(0U, FlowSessionCount());
+
+    for (size_t i = 0; i < pkts.size(); i++) {
+        delete pkts[i];
+    }
+    FlowTeardown();
+    EnqueueSessionTask();
+    client->WaitForIdle();
+    WAIT_FOR(1000, 500, (ssc_obj->Size() == 0));
+}
+
 int main(int argc, char *argv[]) {
     int ret;
     GETUSERARGS();
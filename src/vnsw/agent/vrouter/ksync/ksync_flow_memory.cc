@@ -48,6 +48,7 @@ KSyncFlowMemory::KSyncFlowMemory(KSync *ksync, uint32_t minor_id) :
     KSyncMemory(ksync, minor_id) {
     table_path_ = FLOW_TABLE_DEV;
     hold_flow_counter_ = 0;
+    flow_table_ = NULL;
 }
 
 void KSyncFlowMemory::Init() {
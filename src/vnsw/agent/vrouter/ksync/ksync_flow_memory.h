@@ -43,6 +43,7 @@ public:
     bool GetFlowKey(uint32_t index, FlowKey *key, bool *is_nat_flow);
 
     bool IsEvictionMarked(const vr_flow_entry *entry, uint16_t flags) const;
+    const vr_flow_entry *flow_table() const { return flow_table_; }
 
     virtual int get_entry_size();
     virtual bool IsInactiveEntry(uint32_t idx, uint8_t &gen_id);
@@ -117,6 +117,9 @@ protected:
 
     void TestBasicConnection(const string &local_name,
                              const string &remote_name, bool fail);
+    void TestCompressedConnection(XmppClient *client,
+                                  const string &local_name,
+                                  bool client_compress, bool compressed);
 
     auto_ptr<EventManager> evm_;
     auto_ptr<ServerThread> thread_;
@@ -200,6 +203,57 @@ void XmppServerTest::TestBasicConnection (const string &local_name,
     TASK_UTIL_EXPECT_EQ(static_cast<XmppBgpMockPeer *>(NULL), peer_);
 }
 
+// Bring up a channel from client, check whether it ends up compressed and
+// exchange subscribe messages over it. The channel is left up.
+void XmppServerTest::TestCompressedConnection(XmppClient *client,
+                                              const string &local_name,
+                                              bool client_compress,
+                                              bool compressed) {
+    XmppConfigData *cfg = new XmppConfigData;
+    XmppChannelConfig *channel_cfg = CreateXmppChannelCfg("127.0.0.1",
+        a_->GetPort(), local_name, XMPP_CONTROL_SERV, true);
+    channel_cfg->compression_enabled = client_compress;
+    cfg->AddXmppChannelConfig(channel_cfg);
+    ConfigUpdate(client, cfg);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_NE(static_cast<XmppConnection *>(NULL),
+                        a_->FindConnection(local_name));
+    XmppConnection *sconnection = a_->FindConnection(local_name);
+    TASK_UTIL_EXPECT_EQ(xmsm::ESTABLISHED, sconnection->GetStateMcState());
+    XmppConnection *cconnection = client->FindConnection(XMPP_CONTROL_SERV);
+    ASSERT_FALSE(cconnection == NULL);
+    TASK_UTIL_EXPECT_EQ(xmsm::ESTABLISHED, cconnection->GetStateMcState());
+    TASK_UTIL_EXPECT_EQ(compressed, sconnection->IsCompressed());
+    TASK_UTIL_EXPECT_EQ(compressed, cconnection->IsCompressed());
+
+    XmppBgpMockPeer *speer = new XmppBgpMockPeer(sconnection->ChannelMux());
+    XmppBgpMockPeer *cpeer = new XmppBgpMockPeer(cconnection->ChannelMux());
+    string data = "<iq type='set' from='" + local_name + "' to='"
+        XMPP_CONTROL_SERV "/other-peer' id='sub1'>"
+        "<pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+        "<subscribe node='vrf-table-name'/></pubsub></iq>";
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(cpeer->SendUpdate(
+            reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+    }
+    TASK_UTIL_EXPECT_EQ(8, speer->Count());
+
+    const XmppSession::CompressionStats &stats =
+        cconnection->session()->compression_stats();
+    if (compressed) {
+        EXPECT_NE(0U, stats.tx_wire_bytes);
+        EXPECT_LT(stats.tx_wire_bytes, stats.tx_bytes);
+    } else {
+        EXPECT_EQ(0U, stats.tx_bytes);
+        EXPECT_EQ(0U, stats.tx_wire_bytes);
+    }
+
+    delete speer;
+    delete cpeer;
+    task_util::WaitForIdle();
+}
+
 namespace {
 
 TEST_F(XmppServerTest, Connection) {
@@ -255,6 +309,60 @@ TEST_F(XmppServerTest, VeryLongBothName) {
     TestBasicConnection(local_name, remote_name, true);
 }
 
+// Compressing and plain clients on the same server
+TEST_F(XmppServerTest, CompressionMixedPeers) {
+    a_->set_compression_enabled(true);
+    XmppClient *c = new XmppClient(evm_.get());
+    TestCompressedConnection(b_, SUB_ADDR, false, false);
+    TestCompressedConnection(c, "agent2@vnsw.contrailsystems.com", true,
+                             true);
+
+    // The plain channel is unaffected by the compressed one
+    XmppConnection *sconnection = a_->FindConnection(SUB_ADDR);
+    ASSERT_FALSE(sconnection == NULL);
+    EXPECT_EQ(xmsm::ESTABLISHED, sconnection->GetStateMcState());
+    EXPECT_FALSE(sconnection->IsCompressed());
+
+    ConfigUpdate(b_, new XmppConfigData());
+    ConfigUpdate(c, new XmppConfigData());
+    TASK_UTIL_EXPECT_EQ(0, a_->ConnectionCount());
+    c->Shutdown();
+    task_util::WaitForIdle();
+    TcpServerManager::DeleteServer(c);
+}
+
+// Stanza inflating beyond kMaxInflatedSize closes the session instead of
+// growing the receive buffer
+TEST_F(XmppServerTest, CompressionOversizedStanza) {
+    a_->set_compression_enabled(true);
+    TestCompressedConnection(b_, SUB_ADDR, true, true);
+
+    XmppConnection *cconnection = b_->FindConnection(XMPP_CONTROL_SERV);
+    ASSERT_FALSE(cconnection == NULL);
+    uint32_t flap_count = cconnection->flap_count();
+    XmppBgpMockPeer *cpeer = new XmppBgpMockPeer(cconnection->ChannelMux());
+    string data = "<iq type='set' from='" SUB_ADDR "' to='"
+        XMPP_CONTROL_SERV "/other-peer' id='sub1'>"
+        "<pubsub xmlns='http://jabber.org/protocol/pubsub'>"
+        "<subscribe node='" + string(XmppSession::kMaxInflatedSize, 'a') +
+        "'/></pubsub></iq>";
+    EXPECT_TRUE(cpeer->SendUpdate(
+        reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+    TASK_UTIL_EXPECT_TRUE(flap_count < cconnection->flap_count());
+
+    delete cpeer;
+    ConfigUpdate(b_, new XmppConfigData());
+    task_util::WaitForIdle();
+}
+
+// Server without compression does not advertise it, the client does not
+// ask and the channel comes up uncompressed
+TEST_F(XmppServerTest, CompressionRefused) {
+    TestCompressedConnection(b_, SUB_ADDR, true, false);
+    ConfigUpdate(b_, new XmppConfigData());
+    task_util::WaitForIdle();
+}
+
 }
 
 static void SetUp() {
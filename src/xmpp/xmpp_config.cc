@@ -13,7 +13,8 @@ using namespace std;
 
 XmppChannelConfig::XmppChannelConfig(bool isClient) :
      ToAddr(""), FromAddr(""), NodeAddr(""), logUVE(false), auth_enabled(false),
-     path_to_server_cert(""), path_to_server_priv_key(""), path_to_ca_cert(""),
+     compression_enabled(false), path_to_server_cert(""),
+     path_to_server_priv_key(""), path_to_ca_cert(""),
      tcp_hold_time(XmppChannelConfig::kTcpHoldTime), gr_helper_disable(false),
      xmpp_hold_time(90), dscp_value(0), isClient_(isClient)  {
 }
@@ -25,6 +25,7 @@ public:
     boost::asio::ip::tcp::endpoint local_endpoint;
     bool logUVE;
     bool auth_enabled;
+    bool compression_enabled;
     std::string path_to_server_cert;
     std::string path_to_server_priv_key;
     std::string path_to_ca_cert;
@@ -56,6 +56,7 @@ XmppConnection::XmppConnection(TcpServer *server,
       from_(config->FromAddr),
       to_(config->ToAddr),
       auth_enabled_(config->auth_enabled),
+      compression_enabled_(config->compression_enabled),
       dscp_value_(config->dscp_value), xmlns_(config->xmlns),
       state_machine_(XmppObjectFactory::Create<XmppStateMachine>(
           this, config->ClientOnly(), config->auth_enabled)),
@@ -80,6 +81,10 @@ std::string XmppConnection::GetXmppAuthenticationType() const {
     }
 }
 
+bool XmppConnection::IsCompressed() const {
+    return session_ && session_->tx_compressed() && session_->rx_compressed();
+}
+
 void XmppConnection::SetConfig(const XmppChannelConfig *config) {
     config_ = config;
 }
@@ -283,6 +288,7 @@ bool XmppConnection::SendOpenConfirm(XmppSession *session) {
     if (!session_) return false;
     XmppStanza::XmppStreamMessage openstream;
     openstream.strmtype = XmppStanza::XmppStreamMessage::INIT_STREAM_HEADER_RESP;
+    openstream.compression = compression_enabled_;
     uint8_t data[XMPP_CONTROL_MESSAGE_MAX_SIZE];
     int len = XmppProto::EncodeStream(openstream, to_, from_, xmlns_, data,
                                       sizeof(data));
@@ -361,6 +367,64 @@ bool XmppConnection::SendProceedTls(XmppSession *session) {
     }
 }
 
+//
+// Send a XEP-0138 stream compression element, with spin_mutex_ held.
+//
+bool XmppConnection::SendCompressElement(
+        XmppStanza::XmppStreamMessage::XmppStreamCompressType type,
+        const char *description) {
+    XmppStanza::XmppStreamMessage stream;
+    stream.strmtype = XmppStanza::XmppStreamMessage::FEATURE_COMPRESS;
+    stream.strmcompresstype = type;
+    uint8_t data[XMPP_CONTROL_MESSAGE_MAX_SIZE];
+    int len = XmppProto::EncodeStream(stream, to_, from_, xmlns_, data,
+                                      sizeof(data));
+    if (len <= 0) {
+        inc_stream_feature_fail();
+        return false;
+    }
+    XMPP_UTDEBUG(XmppControlMessage, ToUVEKey(), XMPP_PEER_DIR_OUT,
+                 description, len, from_, to_);
+    session_->Send(data, len, NULL);
+    return true;
+}
+
+bool XmppConnection::SendCompress(XmppSession *session) {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!session_) return false;
+    return SendCompressElement(
+        XmppStanza::XmppStreamMessage::COMPRESS_REQUEST, "Send Compress");
+}
+
+//
+// Everything sent after <compressed/> is deflated. Switch the session while
+// still holding the lock so that no other message gets in between.
+//
+bool XmppConnection::SendCompressed(XmppSession *session) {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!session_) return false;
+    if (!SendCompressElement(
+            XmppStanza::XmppStreamMessage::COMPRESS_SUCCESS,
+            "Send Compressed")) {
+        return false;
+    }
+    return session_->StartCompress();
+}
+
+bool XmppConnection::SendCompressFailure(XmppSession *session) {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!session_) return false;
+    return SendCompressElement(
+        XmppStanza::XmppStreamMessage::COMPRESS_FAILURE,
+        "Send Compress Failure");
+}
+
+bool XmppConnection::StartCompress() {
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (!session_) return false;
+    return session_->StartCompress();
+}
+
 void XmppConnection::SendClose(XmppSession *session) {
     tbb::spin_mutex::scoped_lock lock(spin_mutex_);
     if (!session_) return;
@@ -817,6 +881,17 @@ void XmppServerConnection::FillShowInfo(
     show_connection->set_receivers(channel_mux()->GetReceiverList());
     show_connection->set_server_auth_type(GetXmppAuthenticationType());
     show_connection->set_dscp_value(dscp_value());
+    show_connection->set_compressed(IsCompressed());
+    if (session_) {
+        const XmppSession::CompressionStats &stats =
+            session_->compression_stats();
+        show_connection->set_tx_bytes(stats.tx_bytes);
+        show_connection->set_tx_wire_bytes(stats.tx_wire_bytes);
+        show_connection->set_rx_bytes(stats.rx_bytes);
+        show_connection->set_rx_wire_bytes(stats.rx_wire_bytes);
+        show_connection->set_deflate_usecs(stats.deflate_usecs);
+        show_connection->set_inflate_usecs(stats.inflate_usecs);
+    }
 }
 
 class XmppClientConnection::DeleteActor : public LifetimeActor {
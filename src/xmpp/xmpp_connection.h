@@ -87,6 +87,10 @@ public:
     virtual bool SendStreamFeatureRequest(XmppSession *session);
     virtual bool SendStartTls(XmppSession *session);
     virtual bool SendProceedTls(XmppSession *session);
+    virtual bool SendCompress(XmppSession *session);
+    virtual bool SendCompressed(XmppSession *session);
+    virtual bool SendCompressFailure(XmppSession *session);
+    bool StartCompress();
 
     void SendKeepAlive();
     void SendClose(XmppSession *session);
@@ -233,6 +237,8 @@ public:
     static const char *kAuthTypeNil;
     static const char *kAuthTypeTls;
     std::string GetXmppAuthenticationType() const;
+    bool compression_enabled() const { return compression_enabled_; }
+    bool IsCompressed() const;
     void SwapContents(XmppConnection *other);
     boost::asio::ip::tcp::endpoint &endpoint() { return endpoint_; }
     const Timer *keepalive_timer() const { return keepalive_timer_; }
@@ -249,6 +255,9 @@ private:
     XmppStanza::XmppMessage *XmppDecode(const std::string &msg);
     void LogKeepAliveSend();
     int GetTaskInstance(bool is_client) const;
+    bool SendCompressElement(
+        XmppStanza::XmppStreamMessage::XmppStreamCompressType type,
+        const char *description);
 
     boost::asio::ip::tcp::endpoint endpoint_;
     boost::asio::ip::tcp::endpoint local_endpoint_;
@@ -265,6 +274,7 @@ private:
     std::string from_; // bare jid
     std::string to_;
     bool auth_enabled_;
+    bool compression_enabled_;
     uint8_t dscp_value_;
     std::string xmlns_;
     mutable std::string uve_key_str_;
@@ -42,7 +42,7 @@ int XmppProto::EncodeStream(const XmppStreamMessage &str, string &to,
             len = EncodeOpen(buf, to, from, xmlns, size);
             break;
         case (XmppStanza::XmppStreamMessage::INIT_STREAM_HEADER_RESP):
-            len = EncodeOpenResp(buf, to, from, size);
+            len = EncodeOpenResp(buf, to, from, str.compression, size);
             break;
         case (XmppStanza::XmppStreamMessage::FEATURE_TLS):
             switch (str.strmtlstype) {
@@ -57,6 +57,19 @@ int XmppProto::EncodeStream(const XmppStreamMessage &str, string &to,
                     break;
             }
             break;
+        case (XmppStanza::XmppStreamMessage::FEATURE_COMPRESS):
+            switch (str.strmcompresstype) {
+                case (XmppStanza::XmppStreamMessage::COMPRESS_REQUEST):
+                    len = EncodeCompress(buf);
+                    break;
+                case (XmppStanza::XmppStreamMessage::COMPRESS_SUCCESS):
+                    len = EncodeCompressed(buf);
+                    break;
+                case (XmppStanza::XmppStreamMessage::COMPRESS_FAILURE):
+                    len = EncodeCompressFailure(buf);
+                    break;
+            }
+            break;
         default:
             break;
     }
@@ -136,7 +149,7 @@ int XmppProto::EncodeWhitespace(uint8_t *buf) {
 }
 
 int XmppProto::EncodeOpenResp(uint8_t *buf, string &to, string &from,
-                              size_t max_size) {
+                              bool compression, size_t max_size) {
 
     auto_ptr<XmlBase> resp_doc(XmppStanza::AllocXmppXmlImpl(sXMPP_STREAM_RESP));
 
@@ -146,6 +159,10 @@ int XmppProto::EncodeOpenResp(uint8_t *buf, string &to, string &from,
 
     SetTo(to, resp_doc.get());
     SetFrom(from, resp_doc.get());
+    if (compression) {
+        resp_doc->AddAttribute(sXMPP_STREAM_COMPRESSION,
+                               sXMPP_COMPRESSION_ZLIB);
+    }
 
     std::stringstream ss;
     resp_doc->PrintDoc(ss);
@@ -210,6 +227,24 @@ int XmppProto::EncodeFeatureTlsProceed(uint8_t *buf) {
     return len;
 }
 
+int XmppProto::EncodeCompress(uint8_t *buf) {
+    auto_ptr<XmlBase> resp_doc(
+        XmppStanza::AllocXmppXmlImpl(sXMPP_STREAM_COMPRESS));
+    return resp_doc->WriteDoc(buf);
+}
+
+int XmppProto::EncodeCompressed(uint8_t *buf) {
+    auto_ptr<XmlBase> resp_doc(
+        XmppStanza::AllocXmppXmlImpl(sXMPP_STREAM_COMPRESSED));
+    return resp_doc->WriteDoc(buf);
+}
+
+int XmppProto::EncodeCompressFailure(uint8_t *buf) {
+    auto_ptr<XmlBase> resp_doc(
+        XmppStanza::AllocXmppXmlImpl(sXMPP_STREAM_COMPRESS_FAILURE));
+    return resp_doc->WriteDoc(buf);
+}
+
 XmppStanza::XmppMessage *XmppProto::Decode(const XmppConnection *connection,
                                            const string &ts) {
     auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
@@ -332,6 +367,7 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(
         strm->to = XmppProto::GetTo(impl);
         strm->from = XmppProto::GetFrom(impl);
         strm->xmlns = XmppProto::GetXmlns(impl);
+        strm->compression = XmppProto::GetCompression(impl);
 
         ret = strm;
 
@@ -384,6 +420,30 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(
         }
         goto done;
 
+    } else if (ts.find(sXMPP_STREAM_NS_COMPRESS) != string::npos) {
+
+        if (impl->LoadDoc(ts) == -1) {
+            XMPP_WARNING(XmppBadMessage, connection->ToUVEKey(),
+                         XMPP_PEER_DIR_IN, "Stream compress parse failed.", ts);
+            goto done;
+        }
+
+        XmppStanza::XmppStreamMessage *strm =
+            new XmppStanza::XmppStreamMessage();
+        strm->strmtype = XmppStanza::XmppStreamMessage::FEATURE_COMPRESS;
+        if (ts.find(sXMPP_STREAM_COMPRESSED_O) != string::npos) {
+            strm->strmcompresstype =
+                XmppStanza::XmppStreamMessage::COMPRESS_SUCCESS;
+        } else if (ts.find(sXMPP_STREAM_COMPRESS_O) != string::npos) {
+            strm->strmcompresstype =
+                XmppStanza::XmppStreamMessage::COMPRESS_REQUEST;
+        } else {
+            strm->strmcompresstype =
+                XmppStanza::XmppStreamMessage::COMPRESS_FAILURE;
+        }
+        ret = strm;
+        goto done;
+
     } else if (ts.find_first_of(sXMPP_VALIDWS) != string::npos) {
 
         XmppStanza::XmppMessage *msg =
@@ -448,6 +508,15 @@ const char *XmppProto::GetXmlns(XmlBase *doc) {
     return doc->ReadAttrib(tmp);
 }
 
+bool XmppProto::GetCompression(XmlBase *doc) {
+    if (!doc)
+        return false;
+
+    string tmp(sXMPP_STREAM_COMPRESSION);
+    const char *method = doc->ReadAttrib(tmp);
+    return method && string(method) == sXMPP_COMPRESSION_ZLIB;
+}
+
 const char *XmppProto::GetId(XmlBase *doc) {
     if (!doc) return NULL;
 
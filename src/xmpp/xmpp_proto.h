@@ -67,7 +67,8 @@ public:
     };
 
     struct XmppStreamMessage : XmppMessage {
-        XmppStreamMessage() : XmppMessage(STREAM_HEADER) {
+        XmppStreamMessage() : XmppMessage(STREAM_HEADER),
+            compression(false) {
         }
 
         enum XmppStreamMsgType {
@@ -76,7 +77,7 @@ public:
             INIT_STREAM_HEADER_RESP = 2,
             FEATURE_SASL = 3,
             FEATURE_TLS = 4,
-            FEAUTRE_COMPRESS_LZW = 5,
+            FEATURE_COMPRESS = 5,
             CLOSE_STREAM = 6
         };
 
@@ -90,8 +91,18 @@ public:
             TLS_PROCEED = 3
         };
 
+        // XEP-0138 stream compression
+        enum XmppStreamCompressType {
+            COMPRESS_REQUEST = 1,
+            COMPRESS_SUCCESS = 2,
+            COMPRESS_FAILURE = 3
+        };
+
         XmppStreamMsgType strmtype;
         XmppStreamTlsType strmtlstype;
+        XmppStreamCompressType strmcompresstype;
+        // Stream header of a server that accepts zlib compression
+        bool compression;
     };
 
     enum XmppMessageStateType {
@@ -189,10 +200,13 @@ private:
     static int EncodeOpen(uint8_t *data, std::string &to, std::string &from,
                           const std::string &xmlns, size_t size);
     static int EncodeOpenResp(uint8_t *data, std::string &to, std::string &from,
-                              size_t size);
+                              bool compression, size_t size);
     static int EncodeFeatureTlsRequest(uint8_t *data);
     static int EncodeFeatureTlsStart(uint8_t *data);
     static int EncodeFeatureTlsProceed(uint8_t *data);
+    static int EncodeCompress(uint8_t *data);
+    static int EncodeCompressed(uint8_t *data);
+    static int EncodeCompressFailure(uint8_t *data);
     static int EncodeWhitespace(uint8_t *data);
     static int SetTo(std::string &to, XmlBase *doc);
     static int SetFrom(std::string &from, XmlBase *doc);
@@ -203,6 +217,7 @@ private:
     static const char *GetTo(XmlBase *doc);
     static const char *GetFrom(XmlBase *doc);
     static const char *GetXmlns(XmlBase *doc);
+    static bool GetCompression(XmlBase *doc);
     static const char *GetAction(XmlBase *doc, const std::string &str);
     static const char *GetNode(XmlBase *doc, const std::string &str);
     static const char *GetAsNode(XmlBase *doc);
@@ -61,6 +61,7 @@ XmppServer::XmppServer(EventManager *evm, const string &server_addr,
       server_addr_(server_addr),
       log_uve_(false),
       auth_enabled_(config->auth_enabled),
+      compression_enabled_(config->compression_enabled),
       tcp_hold_time_(config->tcp_hold_time),
       gr_helper_disable_(config->gr_helper_disable),
       dscp_value_(0),
@@ -207,6 +208,7 @@ XmppServer::XmppServer(EventManager *evm, const string &server_addr)
       server_addr_(server_addr),
       log_uve_(false),
       auth_enabled_(false),
+      compression_enabled_(false),
       tcp_hold_time_(XmppChannelConfig::kTcpHoldTime),
       gr_helper_disable_(false),
       xmpp_config_updater_(NULL),
@@ -224,6 +226,7 @@ XmppServer::XmppServer(EventManager *evm)
       deleter_(new DeleteActor(this)),
       log_uve_(false),
       auth_enabled_(false),
+      compression_enabled_(false),
       tcp_hold_time_(XmppChannelConfig::kTcpHoldTime),
       gr_helper_disable_(false),
       dscp_value_(0),
@@ -580,6 +583,7 @@ XmppServerConnection *XmppServer::CreateConnection(XmppSession *session) {
     cfg.FromAddr = server_addr_;
     cfg.logUVE = log_uve_;
     cfg.auth_enabled = auth_enabled_;
+    cfg.compression_enabled = compression_enabled_;
     cfg.dscp_value = dscp_value_;
 
     XMPP_DEBUG(XmppCreateConnection, session->ToUVEKey(), XMPP_PEER_DIR_OUT,
@@ -98,6 +98,11 @@ public:
     }
     void SetDscpValue(uint8_t value);
     uint8_t dscp_value() const { return dscp_value_; }
+    // Applies to connections accepted after the change
+    bool compression_enabled() const { return compression_enabled_; }
+    void set_compression_enabled(bool compression_enabled) {
+        compression_enabled_ = compression_enabled;
+    }
     const std::string subcluster_name() const {
         return subcluster_name_;
     }
@@ -143,6 +148,7 @@ private:
     std::string server_addr_;
     bool log_uve_;
     bool auth_enabled_;
+    bool compression_enabled_;
     int tcp_hold_time_;
     bool gr_helper_disable_;
     boost::scoped_ptr<XmppConfigUpdater> xmpp_config_updater_;
@@ -3,6 +3,7 @@
  */
 
 #include "base/regex.h"
+#include "base/time_util.h"
 #include "xmpp/xmpp_session.h"
 
 #include "xmpp/xmpp_connection.h"
@@ -12,6 +13,7 @@
 #include "xmpp/xmpp_state_machine.h"
 
 #include "sandesh/sandesh_trace.h"
+#include "sandesh/xmpp_message_sandesh_types.h"
 #include "sandesh/xmpp_trace_sandesh_types.h"
 
 using namespace std;
@@ -29,6 +31,8 @@ const regex XmppSession::stream_features_patt_(rXMPP_STREAM_FEATURES);
 const regex XmppSession::starttls_patt_(rXMPP_STREAM_STARTTLS);
 const regex XmppSession::proceed_patt_(rXMPP_STREAM_PROCEED);
 const regex XmppSession::end_patt_(rXMPP_STREAM_STANZA_END);
+const regex XmppSession::compress_patt_(rXMPP_MESSAGE_COMPRESS);
+const regex XmppSession::compressed_patt_(rXMPP_STREAM_COMPRESSED);
 
 XmppSession::XmppSession(XmppConnectionManager *manager, SslSocket *socket,
     bool async_ready)
@@ -38,7 +42,10 @@ XmppSession::XmppSession(XmppConnectionManager *manager, SslSocket *socket,
       tag_known_(0),
       task_instance_(-1),
       stats_(XmppStanza::RESERVED_STANZA, XmppSession::StatsPair(0, 0)),
-      keepalive_probes_(kSessionKeepaliveProbes) {
+      keepalive_probes_(kSessionKeepaliveProbes),
+      deflate_started_(false),
+      inflate_started_(false),
+      inflate_leftover_(false) {
     buf_.reserve(kMaxMessageSize);
     offset_ = buf_.begin();
     stream_open_matched_ = false;
@@ -47,6 +54,10 @@ XmppSession::XmppSession(XmppConnectionManager *manager, SslSocket *socket,
 XmppSession::~XmppSession() {
     set_observer(NULL);
     connection_ = NULL;
+    if (deflate_started_)
+        deflateEnd(&deflate_stream_);
+    if (inflate_started_)
+        inflateEnd(&inflate_stream_);
 }
 
 void XmppSession::SetConnection(XmppConnection *connection) {
@@ -94,6 +105,93 @@ void XmppSession::WriteReady(const boost::system::error_code &error) {
     manager_->EnqueueSession(this);
 }
 
+//
+// Concurrency: called with the XmppConnection send lock held.
+//
+bool XmppSession::StartCompress() {
+    if (deflate_started_)
+        return true;
+    memset(&deflate_stream_, 0, sizeof(deflate_stream_));
+    if (deflateInit(&deflate_stream_, Z_DEFAULT_COMPRESSION) != Z_OK)
+        return false;
+    deflate_started_ = true;
+    return true;
+}
+
+//
+// Concurrency: called in the context of io thread, or by the state machine
+// while the peer is waiting for <compressed/> and cannot send.
+//
+bool XmppSession::StartDecompress() {
+    if (inflate_started_)
+        return true;
+    memset(&inflate_stream_, 0, sizeof(inflate_stream_));
+    if (inflateInit(&inflate_stream_) != Z_OK)
+        return false;
+    inflate_started_ = true;
+    return true;
+}
+
+//
+// Deflate with a sync flush so that the peer can decode each message as soon
+// as it is received.
+//
+bool XmppSession::Send(const uint8_t *data, size_t size, size_t *sent) {
+    if (!deflate_started_)
+        return SslSession::Send(data, size, sent);
+
+    uint64_t start = ClockMonotonicUsec();
+    size_t bound = deflateBound(&deflate_stream_, size) + 16;
+    if (deflate_buf_.size() < bound)
+        deflate_buf_.resize(bound);
+    deflate_stream_.next_in = const_cast<Bytef *>(data);
+    deflate_stream_.avail_in = size;
+    size_t len = 0;
+    int ret;
+    do {
+        if (len == deflate_buf_.size())
+            deflate_buf_.resize(len + kMaxMessageSize);
+        deflate_stream_.next_out = &deflate_buf_[len];
+        deflate_stream_.avail_out = deflate_buf_.size() - len;
+        ret = deflate(&deflate_stream_, Z_SYNC_FLUSH);
+        assert(ret != Z_STREAM_ERROR);
+        len = deflate_buf_.size() - deflate_stream_.avail_out;
+    } while (deflate_stream_.avail_out == 0);
+
+    compression_stats_.tx_bytes += size;
+    compression_stats_.tx_wire_bytes += len;
+    compression_stats_.deflate_usecs += ClockMonotonicUsec() - start;
+    return SslSession::Send(&deflate_buf_[0], len, sent);
+}
+
+// Inflate data read on a compressed stream and append it to buf_. Fails
+// when buf_ would grow beyond kMaxInflatedSize, so that a small read can
+// not expand into an unbounded stanza.
+bool XmppSession::Inflate(const uint8_t *data, size_t size) {
+    uint64_t start = ClockMonotonicUsec();
+    uint8_t chunk[kMaxMessageSize];
+    std::string str;
+    inflate_stream_.next_in = const_cast<Bytef *>(data);
+    inflate_stream_.avail_in = size;
+    do {
+        inflate_stream_.next_out = chunk;
+        inflate_stream_.avail_out = sizeof(chunk);
+        int ret = inflate(&inflate_stream_, Z_SYNC_FLUSH);
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+            return false;
+        str.append(reinterpret_cast<const char *>(chunk),
+                   sizeof(chunk) - inflate_stream_.avail_out);
+        if (buf_.size() + str.size() > kMaxInflatedSize)
+            return false;
+    } while (inflate_stream_.avail_out == 0);
+
+    compression_stats_.rx_wire_bytes += size;
+    compression_stats_.rx_bytes += str.size();
+    compression_stats_.inflate_usecs += ClockMonotonicUsec() - start;
+    SetBuf(str);
+    return true;
+}
+
 XmppSession::StatsPair XmppSession::Stats(unsigned int type) const {
     assert (type < (unsigned int)XmppStanza::RESERVED_STANZA);
     return stats_[type];
@@ -224,6 +322,20 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
                 m = MatchRegex(tag_known_ ? tag_to_pattern(begin_tag_.c_str()):
                                             stream_features_patt_);
             }
+        } else if ((state == xmsm::OPENCONFIRM) &&
+                   (oc_state == xmsm::OPENCONFIRM_COMPRESS_NEGOTIATION)) {
+            // Note, this is a client only state. The server answers with
+            // <compressed/> or <failure>...</failure>
+            bool compressed =
+                (begin_tag_.compare(sXMPP_STREAM_COMPRESSED_O) == 0);
+            m = MatchRegex(tag_known_ ?
+                (compressed ? end_patt_ : tag_to_pattern(begin_tag_.c_str())) :
+                compressed_patt_);
+            if ((m == 0) && (tag_known_) && compressed) {
+                // Whatever follows <compressed/> is deflated
+                StartDecompress();
+                inflate_leftover_ = true;
+            }
         } else if ((state == xmsm::OPENCONFIRM) && !(IsSslDisabled())) {
             if (connection->IsClient()) {
                 if (oc_state == xmsm::OPENCONFIRM_FEATURE_NEGOTIATION) {
@@ -250,7 +362,20 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
                 }
             }
         } else if (state == xmsm::OPENCONFIRM || state == xmsm::ESTABLISHED) {
-            m = MatchRegex(tag_known_ ? tag_to_pattern(begin_tag_.c_str()):patt_);
+            if (tag_known_) {
+                bool compress =
+                    (begin_tag_.compare(sXMPP_STREAM_COMPRESS_O) == 0);
+                m = MatchRegex(tag_to_pattern(begin_tag_.c_str()));
+                if ((m == 0) && compress && connection->compression_enabled()) {
+                    // The client sends nothing more until it gets
+                    // <compressed/>, and only deflated data after that
+                    StartDecompress();
+                }
+            } else {
+                // Server accepts a compression request until it has one
+                bool compress = !connection->IsClient() && !inflate_started_;
+                m = MatchRegex(compress ? compress_patt_ : patt_);
+            }
         }
 
         if (m == 0) { // full match
@@ -290,7 +415,16 @@ void XmppSession::OnRead(Buffer buffer) {
     }
 
     int result = 0;
-    bool more = Match(buffer, &result, true);
+    bool more;
+    if (inflate_started_) {
+        if (!Inflate(BufferData(buffer), BufferSize(buffer))) {
+            InflateError(buffer);
+            return;
+        }
+        more = Match(buffer, &result, false);
+    } else {
+        more = Match(buffer, &result, true);
+    }
     do {
         if (more == false) {
             if (result < 0) {
@@ -318,10 +452,22 @@ void XmppSession::OnRead(Buffer buffer) {
 
         if (LeftOver()) {
             std::string::const_iterator st = buf_.end();
-            ReplaceBuf(string(offset_, st));
+            if (inflate_leftover_) {
+                inflate_leftover_ = false;
+                string left(offset_, st);
+                buf_.clear();
+                if (!Inflate(reinterpret_cast<const uint8_t *>(left.data()),
+                             left.size())) {
+                    InflateError(buffer);
+                    return;
+                }
+            } else {
+                ReplaceBuf(string(offset_, st));
+            }
             more = Match(buffer, &result, false);
         } else {
             // No more data in the Buffer
+            inflate_leftover_ = false;
             buf_.clear();
             break;
         }
@@ -330,3 +476,12 @@ void XmppSession::OnRead(Buffer buffer) {
     ReleaseBuffer(buffer);
     return;
 }
+
+// Compressed stream is corrupt, there is no way to resynchronize.
+void XmppSession::InflateError(Buffer buffer) {
+    XMPP_WARNING(XmppBadMessage, connection_->ToUVEKey(), XMPP_PEER_DIR_IN,
+                 "Stream inflate failed", "");
+    ReleaseBuffer(buffer);
+    buf_.clear();
+    Close();
+}
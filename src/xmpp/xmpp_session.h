@@ -6,6 +6,8 @@
 #define __XMPP_SESSION_H__
 
 #include <string>
+#include <vector>
+#include <zlib.h>
 #include "base/regex.h"
 #include "io/ssl_server.h"
 #include "io/ssl_session.h"
@@ -28,11 +30,43 @@ public:
     virtual void WriteReady(const boost::system::error_code &error);
     void ProcessWriteReady();
 
+    // Data is deflated before it is written once StartCompress is called
+    virtual bool Send(const uint8_t *data, size_t size, size_t *sent);
+
+    // XEP-0138 zlib stream compression. The send and receive directions are
+    // switched independently. The receive side is switched by the reader as
+    // soon as it sees the element that ends the uncompressed part of the
+    // stream, since data following it in the same read is already deflated.
+    // The send side is switched by the state machine under the connection
+    // send lock, right after <compressed/> is sent or received.
+    struct CompressionStats {
+        CompressionStats()
+            : tx_bytes(0), tx_wire_bytes(0), rx_bytes(0), rx_wire_bytes(0),
+              deflate_usecs(0), inflate_usecs(0) {
+        }
+        uint64_t tx_bytes;        // before deflate
+        uint64_t tx_wire_bytes;   // after deflate
+        uint64_t rx_bytes;        // after inflate
+        uint64_t rx_wire_bytes;   // before inflate
+        uint64_t deflate_usecs;
+        uint64_t inflate_usecs;
+    };
+    bool StartCompress();
+    bool StartDecompress();
+    bool tx_compressed() const { return deflate_started_; }
+    bool rx_compressed() const { return inflate_started_; }
+    const CompressionStats &compression_stats() const {
+        return compression_stats_;
+    }
+
     typedef std::pair<uint64_t, uint64_t> StatsPair; // (packets, bytes)
     StatsPair Stats(unsigned int message_type) const;
     void IncStats(unsigned int message_type, uint64_t bytes);
 
     static const int kMaxMessageSize = 4096;
+    // Limit of the inflated data not consumed as stanzas yet. A peer that
+    // sends more on a compressed stream is disconnected
+    static const size_t kMaxInflatedSize = 1024 * kMaxMessageSize;
     friend class XmppRegexMock;
 
     virtual int GetSessionInstance() const { return task_instance_; }
@@ -58,6 +92,8 @@ private:
     void SetBuf(const std::string &);
     void ReplaceBuf(const std::string &);
     bool LeftOver() const;
+    bool Inflate(const uint8_t *data, size_t size);
+    void InflateError(Buffer buffer);
 
     XmppConnectionManager *manager_;
     XmppConnection *connection_;
@@ -74,6 +110,14 @@ private:
     int keepalive_probes_;
     int tcp_user_timeout_;
     bool stream_open_matched_;
+    z_stream deflate_stream_;
+    z_stream inflate_stream_;
+    bool deflate_started_;
+    bool inflate_started_;
+    // Rest of buf_ arrived after <compressed/> and is still deflated
+    bool inflate_leftover_;
+    std::vector<uint8_t> deflate_buf_;
+    CompressionStats compression_stats_;
 
     static const contrail::regex patt_;
     static const contrail::regex stream_patt_;
@@ -83,6 +127,8 @@ private:
     static const contrail::regex starttls_patt_;
     static const contrail::regex proceed_patt_;
     static const contrail::regex end_patt_;
+    static const contrail::regex compress_patt_;
+    static const contrail::regex compressed_patt_;
 
     DISALLOW_COPY_AND_ASSIGN(XmppSession);
 };
@@ -201,6 +201,43 @@ struct EvTlsHandShakeFailure : sc::event<EvTlsHandShakeFailure> {
     XmppSession *session;
 };
 
+struct EvCompress : sc::event<EvCompress> {
+    EvCompress(XmppSession *session, const XmppStanza::XmppMessage *msg) :
+        session(session),
+        msg(static_cast<const XmppStanza::XmppStreamMessage *>(msg)) {
+    }
+    static const char *Name() {
+        return "EvCompress";
+    }
+    XmppSession *session;
+    boost::shared_ptr<const XmppStanza::XmppMessage> msg;
+};
+
+struct EvCompressed : sc::event<EvCompressed> {
+    EvCompressed(XmppSession *session, const XmppStanza::XmppMessage *msg) :
+        session(session),
+        msg(static_cast<const XmppStanza::XmppStreamMessage *>(msg)) {
+    }
+    static const char *Name() {
+        return "EvCompressed";
+    }
+    XmppSession *session;
+    boost::shared_ptr<const XmppStanza::XmppMessage> msg;
+};
+
+struct EvCompressFailure : sc::event<EvCompressFailure> {
+    EvCompressFailure(XmppSession *session,
+                      const XmppStanza::XmppMessage *msg) :
+        session(session),
+        msg(static_cast<const XmppStanza::XmppStreamMessage *>(msg)) {
+    }
+    static const char *Name() {
+        return "EvCompressFailure";
+    }
+    XmppSession *session;
+    boost::shared_ptr<const XmppStanza::XmppMessage> msg;
+};
+
 struct EvXmppKeepalive : sc::event<EvXmppKeepalive> {
     EvXmppKeepalive(XmppSession *session,
                     const XmppStanza::XmppMessage *msg) :
@@ -394,6 +431,7 @@ struct Active : public sc::state<Active, XmppStateMachine> {
                                                   "Open Confirm");
                 return transit<OpenConfirm>();
             } else {
+                // <compress>, if any, is handled in XmppStreamEstablished
                 connection->StartKeepAliveTimer();
                 state_machine->SendConnectionInfo(&info, event.Name(),
                                                   "Established");
@@ -612,7 +650,11 @@ struct OpenSent : public sc::state<OpenSent, XmppStateMachine> {
             state_machine->AssignSession();
             XmppConnectionInfo info;
             info.set_identifier(event.msg->from);
-            if (state_machine->IsAuthEnabled()) {
+            // Ask for compression only if the server advertised it, an
+            // older server would never answer <compress>
+            if (state_machine->IsAuthEnabled() ||
+                (connection->compression_enabled() &&
+                 event.msg->compression)) {
                 state_machine->SendConnectionInfo(&info, event.Name(),
                                                   "Open Confirm");
                 return transit<OpenConfirm>();
@@ -680,6 +722,8 @@ struct OpenConfirm : public sc::state<OpenConfirm, XmppStateMachine> {
         sc::custom_reaction<EvTlsHandShakeSuccess>,
         sc::custom_reaction<EvTlsHandShakeFailure>,
         sc::custom_reaction<EvXmppOpen>,             //received by server
+        sc::custom_reaction<EvCompressed>,           //received by client
+        sc::custom_reaction<EvCompressFailure>,      //received by client
         sc::custom_reaction<EvStop>
     > reactions;
 
@@ -708,6 +752,19 @@ struct OpenConfirm : public sc::state<OpenConfirm, XmppStateMachine> {
         }
         state_machine->set_state(OPENCONFIRM);
         state_machine->set_openconfirm_state(OPENCONFIRM_INIT);
+
+        // Without TLS, the client enters OpenConfirm only to negotiate
+        // stream compression, advertised by the server.
+        if (state_machine->IsActiveChannel() &&
+            !state_machine->IsAuthEnabled()) {
+            if (!SendCompress(state_machine)) {
+                // cannot transition state as this is the constructor of
+                // new state, hold timer expiry takes the client to Active
+                SM_LOG(state_machine, "Xmpp Send Compress Failed");
+                state_machine->connection()->set_close_reason(
+                    "Send Compress Failed");
+            }
+        }
     }
 
     sc::result react(const EvTcpClose &event) {
@@ -878,12 +935,22 @@ struct OpenConfirm : public sc::state<OpenConfirm, XmppStateMachine> {
         XmppConnection *connection = state_machine->connection();
         XmppSession *session = state_machine->session();
         if (connection->IsActiveChannel()) { //client
-            connection->SendKeepAlive();
-            connection->StartKeepAliveTimer();
+            if (!connection->compression_enabled() ||
+                !event.msg->compression) {
+                return ClientEstablished(state_machine, &info, event.Name());
+            }
+            if (!SendCompress(state_machine)) {
+                connection->SendClose(session);
+                state_machine->ResetSession();
+                info.set_close_reason("Send Compress Failed");
+                state_machine->SendConnectionInfo(&info, event.Name(),
+                                                  "Active");
+                return transit<Active>();
+            }
             state_machine->StartHoldTimer();
             state_machine->SendConnectionInfo(&info, event.Name(),
-                                              "Established");
-            return transit<XmppStreamEstablished>();
+                "Sent Compress, OpenConfirm Compress Negotiation");
+            return discard_event();
         } else { //server
             if (!connection->SendOpenConfirm(session)) {
                 connection->SendClose(session);
@@ -908,6 +975,41 @@ struct OpenConfirm : public sc::state<OpenConfirm, XmppStateMachine> {
         }
     }
 
+    // received by client, server accepted compression
+    sc::result react(const EvCompressed &event) {
+        XmppStateMachine *state_machine = &context<XmppStateMachine>();
+        if (event.session != state_machine->session() ||
+            state_machine->get_openconfirm_state() !=
+                OPENCONFIRM_COMPRESS_NEGOTIATION) {
+            return discard_event();
+        }
+        XmppConnection *connection = state_machine->connection();
+        XmppConnectionInfo info;
+        info.set_identifier(connection->GetTo());
+        if (!connection->StartCompress()) {
+            // Do not send stream close, server expects deflated data
+            state_machine->ResetSession();
+            info.set_close_reason("Start Compress Failed");
+            connection->set_close_reason("Start Compress Failed");
+            state_machine->SendConnectionInfo(&info, event.Name(), "Active");
+            return transit<Active>();
+        }
+        return ClientEstablished(state_machine, &info, event.Name());
+    }
+
+    // received by client, server declined compression
+    sc::result react(const EvCompressFailure &event) {
+        XmppStateMachine *state_machine = &context<XmppStateMachine>();
+        if (event.session != state_machine->session() ||
+            state_machine->get_openconfirm_state() !=
+                OPENCONFIRM_COMPRESS_NEGOTIATION) {
+            return discard_event();
+        }
+        XmppConnectionInfo info;
+        info.set_identifier(state_machine->connection()->GetTo());
+        return ClientEstablished(state_machine, &info, event.Name());
+    }
+
     sc::result react(const EvAdminDown &event) {
         XmppStateMachine *state_machine = &context<XmppStateMachine>();
         CloseSession(state_machine);
@@ -918,6 +1020,26 @@ struct OpenConfirm : public sc::state<OpenConfirm, XmppStateMachine> {
         return transit<Idle>();
     }
 
+    // The reader looks for the server's answer as soon as the substate is
+    // set, so set it before sending.
+    bool SendCompress(XmppStateMachine *state_machine) {
+        state_machine->set_openconfirm_state(
+            OPENCONFIRM_COMPRESS_NEGOTIATION);
+        return state_machine->connection()->SendCompress(
+            state_machine->session());
+    }
+
+    sc::result ClientEstablished(XmppStateMachine *state_machine,
+                                 XmppConnectionInfo *info,
+                                 const char *event_name) {
+        XmppConnection *connection = state_machine->connection();
+        connection->SendKeepAlive();
+        connection->StartKeepAliveTimer();
+        state_machine->StartHoldTimer();
+        state_machine->SendConnectionInfo(info, event_name, "Established");
+        return transit<XmppStreamEstablished>();
+    }
+
     void CloseSession(XmppStateMachine *state_machine) {
         XmppConnection *connection = state_machine->connection();
         if (connection != NULL) connection->StopKeepAliveTimer();
@@ -933,6 +1055,7 @@ struct XmppStreamEstablished :
         sc::custom_reaction<EvXmppKeepalive>,
         sc::custom_reaction<EvXmppMessageStanza>,
         sc::custom_reaction<EvXmppIqStanza>,
+        sc::custom_reaction<EvCompress>,             //received by server
         sc::custom_reaction<EvHoldTimerExpired>,
         sc::custom_reaction<EvStop>
     > reactions;
@@ -999,6 +1122,32 @@ struct XmppStreamEstablished :
         return discard_event();
     }
 
+    // received by server. The reader has already switched the session to
+    // inflate if compression is enabled.
+    sc::result react(const EvCompress &event) {
+        XmppStateMachine *state_machine = &context<XmppStateMachine>();
+        if (event.session != state_machine->session()) {
+            return discard_event();
+        }
+        XmppConnection *connection = state_machine->connection();
+        XmppSession *session = state_machine->session();
+        state_machine->StartHoldTimer();
+        if (!session->rx_compressed() || session->tx_compressed()) {
+            connection->SendCompressFailure(session);
+            return discard_event();
+        }
+        if (!connection->SendCompressed(session)) {
+            state_machine->ResetSession();
+            XmppConnectionInfo info;
+            info.set_close_reason("Send Compressed Failed");
+            connection->set_close_reason("Send Compressed Failed");
+            state_machine->SendConnectionInfo(&info, event.Name(), "Idle");
+            return transit<Idle>();
+        }
+        SM_LOG(state_machine, "Xmpp stream compressed");
+        return discard_event();
+    }
+
     sc::result react(const EvHoldTimerExpired &event) {
         XmppStateMachine *state_machine = &context<XmppStateMachine>();
         if (state_machine->HoldTimerCancelled()) {
@@ -1475,6 +1624,23 @@ void XmppStateMachine::ProcessMessage(XmppSession *session,
                         break;
                 }
 
+            } else if (stream_msg->strmtype ==
+                XmppStanza::XmppStreamMessage::FEATURE_COMPRESS) {
+
+                switch (stream_msg->strmcompresstype) {
+                    case (XmppStanza::XmppStreamMessage::COMPRESS_REQUEST):
+                        ProcessEvent(xmsm::EvCompress(session, msg));
+                        break;
+                    case (XmppStanza::XmppStreamMessage::COMPRESS_SUCCESS):
+                        ProcessEvent(xmsm::EvCompressed(session, msg));
+                        break;
+                    case (XmppStanza::XmppStreamMessage::COMPRESS_FAILURE):
+                        ProcessEvent(xmsm::EvCompressFailure(session, msg));
+                        break;
+                    default:
+                        break;
+                }
+
             } else if (stream_msg->strmtype ==
                     XmppStanza::XmppStreamMessage::INIT_STREAM_HEADER ||
                 stream_msg->strmtype ==
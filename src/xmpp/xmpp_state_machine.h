@@ -41,7 +41,8 @@ typedef enum {
 typedef enum {
     OPENCONFIRM_INIT                         = 0,
     OPENCONFIRM_FEATURE_NEGOTIATION          = 1,
-    OPENCONFIRM_FEATURE_SUCCESS              = 2
+    OPENCONFIRM_FEATURE_SUCCESS              = 2,
+    OPENCONFIRM_COMPRESS_NEGOTIATION         = 3
 } XmOpenConfirmState;
 
 
@@ -23,6 +23,8 @@
 #define sXMPP_STREAM_FAILURE_O      "<failure"
 #define sXMPP_STREAM_PROCEED_O      "<proceed"
 #define sXMPP_REQUIRED_O            "<required"
+#define sXMPP_STREAM_COMPRESS_O     "<compress"
+#define sXMPP_STREAM_COMPRESSED_O   "<compressed"
 
 
 #define sXMPP_VERSION_1_GLOBAL      "<?xml version='1.0'?>"
@@ -32,6 +34,11 @@
 #define sXMPP_LANG_EN               "xml:lang='en'"
 #define sXMPP_STREAM_NS             "xmlns:stream='http://etherx.jabber.org/streams'"
 #define sXMPP_STREAM_NS_TLS         "urn:ietf:params:xml:ns:xmpp-tls"
+#define sXMPP_STREAM_NS_COMPRESS    "http://jabber.org/protocol/compress"
+// Stream header attribute of a server accepting <compress>, the plaintext
+// path has no stream features to advertise it
+#define sXMPP_STREAM_COMPRESSION    "compression"
+#define sXMPP_COMPRESSION_ZLIB      "zlib"
 #define sXMPP_BIND_NS               "<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'/>"
 #define sXMPP_STREAM_ERROR_NS       "xmlns='urn:ietf:params:xml:ns:xmpp-streams'"
 
@@ -42,6 +49,9 @@
 #define sXMPP_STREAM_FEATURE_TLS    "<stream:features><starttls xmlns='urn:ietf:params:xml:ns:xmpp-tls'><required/></starttls></stream:features>"
 #define sXMPP_STREAM_START_TLS       "<starttls xmlns='urn:ietf:params:xml:ns:xmpp-tls'/>"
 #define sXMPP_STREAM_PROCEED_TLS     "<proceed xmlns='urn:ietf:params:xml:ns:xmpp-tls'/>"
+#define sXMPP_STREAM_COMPRESS        "<compress xmlns='http://jabber.org/protocol/compress'><method>zlib</method></compress>"
+#define sXMPP_STREAM_COMPRESSED      "<compressed xmlns='http://jabber.org/protocol/compress'/>"
+#define sXMPP_STREAM_COMPRESS_FAILURE "<failure xmlns='http://jabber.org/protocol/compress'><setup-failed/></failure>"
 
 #define sXMPP_WHITESPACE             "Ȁ" //unicode U+0200 as whitespace
 // Whitespace characters allowed as fillers between xmpp messages.
@@ -61,6 +71,8 @@
 #define rXMPP_STREAM_STARTTLS      "<starttls"
 #define rXMPP_STREAM_PROCEED       "<proceed"
 #define rXMPP_STREAM_STANZA_END    "[\\s\\t\\r\\n]*/>"
+#define rXMPP_MESSAGE_COMPRESS     "<(iq|message|compress)"
+#define rXMPP_STREAM_COMPRESSED    "<(compressed|failure)"
 
 #define rXMPP_STREAM_START_FEATURES "<?.*?>*[\\s\\n\\t\\r]*<(stream:stream|stream:features)"
 #endif // __XMPP_STR_H__